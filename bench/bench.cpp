@@ -0,0 +1,74 @@
+#include "bench.h"
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+
+void BenchContext::throughput(const std::string& name, double operations, double seconds, const std::string& unit) {
+    Metric metric;
+    metric.name  = name;
+    metric.kind  = "throughput";
+    metric.unit  = unit + "/s";
+    metric.value = operations / seconds;
+    metrics.push_back(metric);
+
+    if (unit == "ops")
+        std::printf("  %-34s %12.2f Mops/s %10.2f ns/op\n", name.c_str(), metric.value / 1e6, seconds * 1e9 / operations);
+    else
+        std::printf("  %-34s %12.1f %s/s\n", name.c_str(), metric.value, unit.c_str());
+}
+
+void BenchContext::latency(const std::string& name, std::vector<double> samples) {
+    if (samples.empty()) return;
+    std::sort(samples.begin(), samples.end());
+
+    // Percentile "nearest rank": il campione sotto cui sta il p% dei tempi
+    auto percentile = [&](double p) {
+        size_t rank = (size_t)(p / 100.0 * (double)samples.size() + 0.999999);
+        return samples[std::min(samples.size(), std::max<size_t>(rank, 1)) - 1];
+    };
+
+    Metric metric;
+    metric.name = name;
+    metric.kind = "latency";
+    metric.unit = "us";
+    double total = 0.0;
+    for (double s : samples) total += s;
+    metric.value   = total / (double)samples.size() * 1e6;
+    metric.p50     = percentile(50.0) * 1e6;
+    metric.p99     = percentile(99.0) * 1e6;
+    metric.max     = samples.back() * 1e6;
+    metric.samples = samples.size();
+    metrics.push_back(metric);
+
+    std::printf("  %-34s p50 %9.1f us  p99 %9.1f us  max %9.1f us  (%zu)\n",
+        name.c_str(), metric.p50, metric.p99, metric.max, metric.samples);
+}
+
+void BenchContext::value(const std::string& name, double value, const std::string& unit) {
+    Metric metric;
+    metric.name  = name;
+    metric.kind  = "value";
+    metric.unit  = unit;
+    metric.value = value;
+    metrics.push_back(metric);
+
+    std::printf("  %-34s %12.2f %s\n", name.c_str(), value, unit.c_str());
+}
+
+bool BenchContext::check(bool condition, const std::string& what) {
+    if (!condition) {
+        failures.push_back(what);
+        std::printf("  FAIL: %s\n", what.c_str());
+    }
+    return condition;
+}
+
+void BenchContext::note(const char* format, ...) {
+    std::printf("  ");
+    va_list args;
+    va_start(args, format);
+    std::vprintf(format, args);
+    va_end(args);
+    std::printf("\n");
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ---------------------------------------------------------------
+// voxel_bench
+// Benchmark senza finestra né GPU: misura le parti del motore che
+// girano sulla CPU, così si possono confrontare le prestazioni tra
+// un commit e l'altro anche su macchine senza scheda video.
+//
+// Ogni scenario è una funzione che riceve un BenchContext e ci
+// registra i risultati: throughput, latenze (p50/p99/max) e valori
+// sparsi. Il contesto li stampa in forma leggibile e alla fine
+// voxel_bench li scrive anche in JSON (--json file) per confrontarli
+// con uno script. Seed e dati sono fissi: due run sulla stessa
+// macchina misurano lo stesso lavoro.
+// ---------------------------------------------------------------
+
+using Clock = std::chrono::steady_clock;
+
+inline double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Generatore pseudo-casuale veloce e deterministico (xorshift32):
+// vogliamo gli stessi accessi "casuali" ad ogni esecuzione
+inline uint32_t xorshift(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+class BenchContext {
+public:
+    // operations eseguite in seconds; unit "ops" stampa Mops/s e ns/op
+    void throughput(const std::string& name, double operations, double seconds, const std::string& unit = "ops");
+
+    // Tempi di singole operazioni (frame, chunk...) in secondi
+    void latency(const std::string& name, std::vector<double> samples);
+
+    // Un numero qualsiasi: byte, triangoli, speedup...
+    void value(const std::string& name, double value, const std::string& unit);
+
+    // Controllo di correttezza: se fallisce, fallisce lo scenario
+    // (e voxel_bench esce con un codice diverso da 0)
+    bool check(bool condition, const std::string& what);
+
+    // Riga di testo libera, solo nell'output leggibile
+    void note(const char* format, ...);
+
+    bool failed() const { return !failures.empty(); }
+
+    // Usati da main per il JSON
+    struct Metric {
+        std::string name;
+        std::string kind; // "throughput", "latency", "value"
+        std::string unit;
+        double value = 0.0; // per le latenze: la media
+        double p50 = 0.0, p99 = 0.0, max = 0.0;
+        size_t samples = 0;
+    };
+    const std::vector<Metric>&      results() const { return metrics; }
+    const std::vector<std::string>& failedChecks() const { return failures; }
+
+private:
+    std::vector<Metric>      metrics;
+    std::vector<std::string> failures;
+};
+
+// Scenari, uno per funzione (nei file bench_*.cpp)
+void benchBlockAccess(BenchContext& ctx);
+void benchNoise(BenchContext& ctx);
+void benchGeneration(BenchContext& ctx);
+void benchMeshing(BenchContext& ctx);
+void benchVertexFormat(BenchContext& ctx);
+void benchBufferAllocator(BenchContext& ctx);
+void benchCulling(BenchContext& ctx);
+void benchStorage(BenchContext& ctx);
+void benchJobScaling(BenchContext& ctx);
+void benchFlythrough(BenchContext& ctx);
+void benchProfiler(BenchContext& ctx);
+void benchLod(BenchContext& ctx);
+void benchRaycast(BenchContext& ctx);
+void benchLight(BenchContext& ctx);
+void benchEditBurst(BenchContext& ctx);
+void benchInstancing(BenchContext& ctx);
+void benchStreaming(BenchContext& ctx);
+void benchSimulation(BenchContext& ctx);
+void benchMemory(BenchContext& ctx);
+void benchEntities(BenchContext& ctx);
+void benchServer(BenchContext& ctx);
+void benchFluids(BenchContext& ctx);
+void benchStartup(BenchContext& ctx);
+void benchBlocks(BenchContext& ctx);
+void benchInputReplay(BenchContext& ctx);
@@ -0,0 +1,309 @@
+#include "bench.h"
+
+#include <bit>
+#include <filesystem>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "block_registry.h"
+#include "light.h"
+#include "mesher.h"
+#include "raycast.h"
+#include "terrain.h"
+#include "world.h"
+
+// ---------------------------------------------------------------
+// Proprietà dei blocchi: quanto costa chiedere "è opaco?" al mesher.
+//
+// Lo stesso lavoro, le facce visibili di un chunk di terreno con i 4
+// vicini di AO attorno a ciascuna, in tre modi:
+//   - a oggetti: un registro da BlockID a oggetti con un metodo
+//     virtuale, come si farebbe con una classe per tipo di blocco
+//     (una ricerca nella mappa e una chiamata indiretta per voxel)
+//   - a tabella: isOpaque di block.h, un load nella bitset per voxel
+//   - a maschere: MeshOpacity, l'opacità letta una volta per voxel e
+//     le facce 16 alla volta con AND e NOT su righe di bit
+// I conteggi delle tre devono coincidere, e con i quad del mesher.
+//
+// Poi un tipo registrato a runtime (vetro, non opaco) deve comportarsi
+// come se fosse scritto nel codice: mesher, luce e raycast. La tabella
+// dei nomi salvata con il mondo rifiuta i BlockID che cambiano tipo.
+// ---------------------------------------------------------------
+
+namespace {
+
+class Block {
+public:
+    virtual ~Block() = default;
+    virtual bool isOpaque() const = 0;
+};
+
+class OpaqueBlock : public Block {
+public:
+    bool isOpaque() const override { return true; }
+};
+
+class SeeThroughBlock : public Block {
+public:
+    bool isOpaque() const override { return false; }
+};
+
+using BlockObjects = std::unordered_map<BlockID, std::unique_ptr<Block>>;
+
+BlockObjects makeBlockObjects() {
+    BlockObjects objects;
+    for (int id = 0; id < registeredBlockCount(); id++) {
+        if (isOpaque((BlockID)id)) objects[(BlockID)id] = std::make_unique<OpaqueBlock>();
+        else                       objects[(BlockID)id] = std::make_unique<SeeThroughBlock>();
+    }
+    return objects;
+}
+
+struct FaceStats {
+    int faces     = 0;
+    int occluders = 0; // voxel opachi accanto alle facce (quello che conta l'AO)
+
+    bool operator==(const FaceStats&) const = default;
+};
+
+// Distanza nell'input tra voxel vicini, per faccia (ordine di BlockFace),
+// e gli altri due assi di ogni faccia
+const int STRIDE[3] = { 1, MESH_PADDED_SIZE * MESH_PADDED_SIZE, MESH_PADDED_SIZE };
+
+int neighbourOffset(int face) {
+    return (face & 1 ? -1 : 1) * STRIDE[face >> 1];
+}
+
+// I 4 vicini nel piano davanti alla faccia: quelli che scuriscono gli angoli
+template <typename IsOpaque>
+int occludersAround(int front, int face, IsOpaque&& opaqueAt) {
+    int axis = face >> 1;
+    int u = STRIDE[(axis + 1) % 3], v = STRIDE[(axis + 2) % 3];
+    return opaqueAt(front + u) + opaqueAt(front - u) + opaqueAt(front + v) + opaqueAt(front - v);
+}
+
+// Voxel per voxel: opaqueAt(indice nell'input) è il modo di chiedere
+template <typename IsOpaque>
+FaceStats countFacesPerVoxel(const MeshInput& input, IsOpaque&& opaqueAt) {
+    FaceStats stats;
+    for (int y = 0; y < CHUNK_SIZE; y++)
+        for (int z = 0; z < CHUNK_SIZE; z++)
+            for (int x = 0; x < CHUNK_SIZE; x++) {
+                int idx = MeshInput::index(x, y, z);
+                BlockID block = input.blocks[idx];
+                if (block == BLOCK_AIR) continue;
+                for (int face = 0; face < 6; face++) {
+                    int front = idx + neighbourOffset(face);
+                    if (opaqueAt(front)) continue;
+                    if (!opaqueAt(idx) && input.blocks[front] == block) continue; // vetro contro vetro
+                    stats.faces++;
+                    stats.occluders += occludersAround(front, face, opaqueAt);
+                }
+            }
+    return stats;
+}
+
+// Righe di bit: solo i voxel con una faccia visibile
+FaceStats countFacesBitmask(const MeshInput& input, MeshOpacity& opacity) {
+    opacity.build(input);
+    auto opaqueAt = [&opacity](int index) { return (int)opacity.opaque[index]; };
+
+    FaceStats stats;
+    for (int face = 0; face < 6; face++)
+        for (int y = 0; y < CHUNK_SIZE; y++)
+            for (int z = 0; z < CHUNK_SIZE; z++)
+                for (uint32_t bits = opacity.faces[face][y * CHUNK_SIZE + z]; bits; bits &= bits - 1) {
+                    int front = MeshInput::index(std::countr_zero(bits), y, z) + neighbourOffset(face);
+                    stats.faces++;
+                    stats.occluders += occludersAround(front, face, opaqueAt);
+                }
+    return stats;
+}
+
+void benchLookups(BenchContext& ctx) {
+    World world;
+    TerrainGenerator terrain(1337);
+    const int AREA = 4;
+    for (int cz = -1; cz <= AREA; cz++)
+        for (int cx = -1; cx <= AREA; cx++)
+            for (int cy = WORLD_MIN_CHUNK_Y; cy <= WORLD_MAX_CHUNK_Y; cy++)
+                terrain.generate({ cx, cy, cz }, world.getOrCreateChunk({ cx, cy, cz }));
+
+    std::vector<std::unique_ptr<MeshInput>> inputs;
+    for (int cz = 0; cz < AREA; cz++)
+        for (int cx = 0; cx < AREA; cx++)
+            for (int cy = WORLD_MIN_CHUNK_Y; cy <= WORLD_MAX_CHUNK_Y; cy++) {
+                const Chunk* chunk = world.findChunk({ cx, cy, cz });
+                if (!chunk || chunk->isEmpty()) continue;
+                inputs.push_back(std::make_unique<MeshInput>());
+                inputs.back()->gather(world, { cx, cy, cz });
+            }
+    ctx.value("terrain chunks with blocks", (double)inputs.size(), "chunks");
+
+    const BlockObjects objects = makeBlockObjects();
+    auto opacity = std::make_unique<MeshOpacity>();
+    ChunkMesh mesh;
+    const int ROUNDS = 3;
+
+    std::vector<FaceStats> polymorphic(inputs.size()), table(inputs.size()), bitmask(inputs.size());
+    auto start = Clock::now();
+    for (int round = 0; round < ROUNDS; round++)
+        for (size_t i = 0; i < inputs.size(); i++) {
+            const MeshInput& input = *inputs[i];
+            polymorphic[i] = countFacesPerVoxel(input, [&](int index) {
+                return (int)objects.at(input.blocks[index])->isOpaque();
+            });
+        }
+    double polymorphicSeconds = secondsSince(start);
+
+    start = Clock::now();
+    for (int round = 0; round < ROUNDS; round++)
+        for (size_t i = 0; i < inputs.size(); i++) {
+            const MeshInput& input = *inputs[i];
+            table[i] = countFacesPerVoxel(input, [&](int index) { return (int)isOpaque(input.blocks[index]); });
+        }
+    double tableSeconds = secondsSince(start);
+
+    start = Clock::now();
+    for (int round = 0; round < ROUNDS; round++)
+        for (size_t i = 0; i < inputs.size(); i++) bitmask[i] = countFacesBitmask(*inputs[i], *opacity);
+    double bitmaskSeconds = secondsSince(start);
+
+    start = Clock::now();
+    bool sameAsMesh = true;
+    for (int round = 0; round < ROUNDS; round++)
+        for (size_t i = 0; i < inputs.size(); i++) {
+            buildChunkMesh(*inputs[i], mesh, false);
+            sameAsMesh &= mesh.triangleCount() == 2 * bitmask[i].faces;
+        }
+    double meshSeconds = secondsSince(start);
+
+    double chunks = (double)(ROUNDS * inputs.size());
+    ctx.throughput("faces + AO, polymorphic registry", chunks, polymorphicSeconds, "chunks");
+    ctx.throughput("faces + AO, property table", chunks, tableSeconds, "chunks");
+    ctx.throughput("faces + AO, row bitmasks", chunks, bitmaskSeconds, "chunks");
+    ctx.throughput("full culled mesh", chunks, meshSeconds, "chunks");
+    ctx.value("table vs polymorphic", polymorphicSeconds / tableSeconds, "x");
+    ctx.value("bitmasks vs polymorphic", polymorphicSeconds / bitmaskSeconds, "x");
+
+    int faces = 0;
+    for (const FaceStats& stats : bitmask) faces += stats.faces;
+    ctx.value("visible faces per chunk", (double)faces / (double)inputs.size(), "faces");
+    ctx.check(polymorphic == table && table == bitmask, "the three lookups see the same faces and AO neighbours");
+    ctx.check(sameAsMesh, "the mesher draws one quad per visible face");
+}
+
+void benchRuntimeBlocks(BenchContext& ctx) {
+    int registered = registerBlocks(
+        "# bench\n"
+        "glass      opaque=0 texture=water\n"
+        "glowstone  emission=15 texture=lamp\n"
+        "bad        opaque=2\n", // saltata: non è 0 o 1
+        "bench blocks");
+    BlockID glass     = findBlock("glass");
+    BlockID glowstone = findBlock("glowstone");
+    ctx.check(registered == 2 && glass == BLOCK_COUNT && glowstone == BLOCK_COUNT + 1 && findBlock("bad") == BLOCK_AIR,
+              "block definitions register after the built-in types, bad lines are skipped");
+    ctx.check(registerBlock({ "glass" }) == BLOCK_AIR, "a name can be registered only once");
+    ctx.check(isSolid(glass) && !isOpaque(glass) && isOpaque(glowstone) && blockEmission(glowstone) == MAX_LIGHT,
+              "registered properties land in the property tables");
+
+    // Un chunk: stone in mezzo, vetro tutto attorno, poi due vetri accanto
+    World world;
+    world.setBlock(4, 4, 4, BLOCK_STONE);
+    for (int face = 0; face < 6; face++) {
+        int dx = face == 0 ? 1 : face == 1 ? -1 : 0;
+        int dy = face == 2 ? 1 : face == 3 ? -1 : 0;
+        int dz = face == 4 ? 1 : face == 5 ? -1 : 0;
+        world.setBlock(4 + dx, 4 + dy, 4 + dz, glass);
+    }
+    auto input = std::make_unique<MeshInput>();
+    input->gather(world, { 0, 0, 0 });
+    MeshOpacity opacity;
+    opacity.build(*input);
+    bool stoneDrawn = true;
+    for (int face = 0; face < 6; face++) stoneDrawn &= opacity.visible(face, 4, 4, 4);
+    ctx.check(stoneDrawn, "stone faces behind glass are drawn");
+    // 6 vetri: 5 facce esterne ciascuno (quella verso la pietra è coperta), + 6 della pietra
+    ctx.check(opacity.faceCount() == 6 * 5 + 6, "glass next to stone hides only the face against stone");
+
+    World pair;
+    pair.setBlock(2, 2, 2, glass);
+    pair.setBlock(3, 2, 2, glass);
+    input->gather(pair, { 0, 0, 0 });
+    opacity.build(*input);
+    ctx.check(opacity.faceCount() == 10 && !opacity.visible(FACE_POS_X, 2, 2, 2) && !opacity.visible(FACE_NEG_X, 3, 2, 2),
+              "the face between two glass blocks is culled");
+
+    // Un tetto in cima al mondo, metà vetro e metà pietra: la luce del
+    // cielo passa dal vetro, il raycast lo colpisce
+    World lit;
+    const ChunkPos top = { 0, WORLD_MAX_CHUNK_Y, 0 };
+    const int roofY = WORLD_MAX_CHUNK_Y * CHUNK_SIZE + 10;
+    for (int cy = WORLD_MAX_CHUNK_Y; cy >= WORLD_MIN_CHUNK_Y; cy--) lit.getOrCreateChunk({ 0, cy, 0 });
+    for (int z = 0; z < CHUNK_SIZE; z++)
+        for (int x = 0; x < CHUNK_SIZE; x++) lit.setBlock(x, roofY, z, x < 8 ? glass : (BlockID)BLOCK_STONE);
+    LightEngine light(lit);
+    for (int cy = WORLD_MAX_CHUNK_Y; cy >= WORLD_MIN_CHUNK_Y; cy--) light.onChunkLoaded({ 0, cy, 0 });
+    const Chunk* roof = lit.findChunk(top);
+    int underGlass = roof->getLight(3, 5, 8) >> 4, underStone = roof->getLight(12, 5, 8) >> 4;
+    ctx.check(underGlass == MAX_LIGHT && underStone < MAX_LIGHT, "sky light passes through glass and stops at stone");
+    Ray ray = { glm::vec3(3.5f, roofY + 4.5f, 8.5f), glm::vec3(0.0f, -1.0f, 0.0f), 10.0f };
+    RayHit hit = raycast(lit, ray);
+    ctx.check(hit.hit && hit.id == glass && hit.block == glm::ivec3(3, roofY, 8), "a ray hits glass");
+
+    // Il caso peggiore per il mesher: una scacchiera piena di due tipi
+    // non opachi diversi. Ogni blocco ha 6 facce e nessuna si unisce
+    // alle vicine: 98304 vertici, oltre gli indici a 16 bit di una parte
+    BlockDefinition tintedDefinition;
+    tintedDefinition.name     = "tinted";
+    tintedDefinition.opaque   = false;
+    tintedDefinition.textures = { LAYER_SAND, LAYER_SAND, LAYER_SAND };
+    BlockID tinted = registerBlock(tintedDefinition);
+    World checker;
+    for (int y = 0; y < CHUNK_SIZE; y++)
+        for (int z = 0; z < CHUNK_SIZE; z++)
+            for (int x = 0; x < CHUNK_SIZE; x++) checker.setBlock(x, y, z, (x + y + z) % 2 ? glass : tinted);
+    input->gather(checker, { 0, 0, 0 });
+    ChunkMesh worst;
+    buildChunkMesh(*input, worst);
+    // Ogni gruppo di 6 indici deve puntare ai 4 vertici di un solo quad
+    bool quadsIntact = worst.splitVertex > 0 && worst.splitVertex <= MESH_PART_VERTICES
+                    && worst.vertices.size() - worst.splitVertex <= MESH_PART_VERTICES;
+    for (size_t i = 0; i < worst.indices.size() && quadsIntact; i += 6) {
+        uint32_t base = i < worst.splitIndex ? 0 : worst.splitVertex;
+        uint32_t quad = (base + worst.indices[i]) / 4;
+        for (size_t k = i; k < i + 6; k++) quadsIntact &= (base + worst.indices[k]) / 4 == quad && quad == i / 6;
+    }
+    ctx.check(worst.vertices.size() == (size_t)CHUNK_VOLUME * 6 * 4 && quadsIntact,
+              "a full checkerboard of two transparent types splits into two 16-bit parts");
+
+    resetBlockRegistry();
+    ctx.check(registeredBlockCount() == BLOCK_COUNT && isOpaque(glass) && findBlock("glass") == BLOCK_AIR,
+              "resetting the registry restores the built-in tables");
+
+    // La tabella dei tipi accanto ai salvataggi: tipi nuovi in fondo
+    // vanno bene, lo stesso file con le righe scambiate no
+    std::string table = (std::filesystem::temp_directory_path() / "voxel_bench_blocks.ids").string();
+    std::filesystem::remove(table);
+    registerBlocks("glass opaque=0\nglowstone emission=15\n", "bench table");
+    uint64_t savedHash = blockRegistryHash();
+    bool written  = syncBlockTable(table);
+    registerBlock({ "marble" });
+    bool appended = syncBlockTable(table);
+    resetBlockRegistry();
+    registerBlocks("glowstone emission=15\nglass opaque=0\nmarble\n", "bench table");
+    bool reordered = syncBlockTable(table);
+    ctx.check(written && appended && !reordered && blockRegistryHash() != savedHash,
+              "a saved block table accepts appended types and rejects reordered ones");
+    std::filesystem::remove(table);
+    resetBlockRegistry();
+}
+
+} // namespace
+
+void benchBlocks(BenchContext& ctx) {
+    benchLookups(ctx);
+    benchRuntimeBlocks(ctx);
+}
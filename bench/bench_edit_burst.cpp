@@ -0,0 +1,179 @@
+#include "bench.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <thread>
+#include <unordered_map>
+
+#include "chunk_pipeline.h"
+#include "job_system.h"
+#include "light.h"
+#include "terrain.h"
+#include "world.h"
+
+// ---------------------------------------------------------------
+// Raffiche di modifiche: un'area di terreno caricata e meshata come
+// nel gioco, poi ogni 10 frame una raffica di migliaia di blocchi
+// (crateri di esplosioni, riempimenti di pietra e d'acqua). Ogni frame
+// fa quello del game loop: applica le modifiche del frame in un colpo
+// (luce compresa), prende i chunk con la mesh da rifare (un bit per
+// chunk: una volta sola anche con mille modifiche), li passa alla
+// pipeline e carica le mesh finite, al più 16 per frame come il gioco.
+// Finché la mesh nuova non arriva resta quella vecchia, quindi il
+// frame non aspetta mai il meshing.
+//
+// Si misurano il tempo del frame sul render thread, le mesh rifatte
+// contro quelle che chiederebbe un rimeshing per ogni modifica (il
+// chunk più i vicini di cui tocca il bordo) e quanto passa dalla
+// raffica all'ultima mesh sostituita. Alla fine ogni mesh caricata
+// deve essere identica a una rifatta da zero: nessuna modifica persa.
+// ---------------------------------------------------------------
+static const int   BURST_AREA      = 4;   // chunk attorno all'origine, per lato
+static const int   BURST_FRAMES    = 400;
+static const int   BURST_EVERY     = 10;  // frame tra una raffica e l'altra
+static const int   BURST_UPLOADS   = 16;  // come MAX_UPLOADS_PER_FRAME
+static const float BURST_DELTA     = 1.0f / 60.0f;
+
+namespace {
+
+enum class BurstKind { Crater, BigCrater, StoneFill, WaterFill };
+
+void buildBurst(BurstKind kind, int cx, int cy, int cz, std::vector<BlockEdit>& edits) {
+    edits.clear();
+    if (kind == BurstKind::Crater || kind == BurstKind::BigCrater) {
+        int r = kind == BurstKind::Crater ? 6 : 9;
+        for (int dy = -r; dy <= r; dy++)
+            for (int dz = -r; dz <= r; dz++)
+                for (int dx = -r; dx <= r; dx++)
+                    if (dx * dx + dy * dy + dz * dz <= r * r) edits.push_back({ cx + dx, cy + dy, cz + dz, BLOCK_AIR });
+        return;
+    }
+    // Un parallelepipedo 16x8x16 appoggiato sulla superficie
+    BlockID id = kind == BurstKind::StoneFill ? (BlockID)BLOCK_STONE : (BlockID)BLOCK_WATER;
+    for (int dy = 1; dy <= 8; dy++)
+        for (int dz = -8; dz < 8; dz++)
+            for (int dx = -8; dx < 8; dx++) edits.push_back({ cx + dx, cy + dy, cz + dz, id });
+}
+
+int surfaceY(const World& world, int x, int z) {
+    for (int y = (WORLD_MAX_CHUNK_Y + 1) * CHUNK_SIZE - 1; y >= 0; y--)
+        if (isSolid(world.getBlock(x, y, z))) return y;
+    return 0;
+}
+
+} // namespace
+
+void benchEditBurst(BenchContext& ctx) {
+    World world;
+    JobSystem jobs;
+    TerrainGenerator terrain(1337);
+    ChunkPipeline pipeline(jobs, world, [&terrain](const ChunkPos& pos, Chunk& chunk) {
+        terrain.generate(pos, chunk);
+    });
+    LightEngine light(world);
+    pipeline.setInsertedCallback([&light](const ChunkPos& pos) { light.onChunkLoaded(pos); });
+
+    // L'ultima mesh caricata di ogni chunk, come la vedrebbe la GPU
+    std::unordered_map<ChunkPos, ChunkMesh, ChunkPosHash> uploaded;
+    std::vector<ChunkPos> stale;
+    glm::vec3 cameraPosition(8.0f, 100.0f, 8.0f);
+
+    auto frameWork = [&](int maxUploads) {
+        world.takeMeshDirtyChunks(stale);
+        for (const ChunkPos& pos : stale) pipeline.requestMesh(pos);
+        pipeline.update(cameraPosition);
+        return pipeline.consumeMeshes([&](const ChunkPos& pos, const ChunkMesh& mesh) {
+            ChunkMesh& copy = uploaded[pos];
+            copy.vertices = mesh.vertices;
+            copy.indices  = mesh.indices;
+        }, maxUploads);
+    };
+
+    for (int z = -BURST_AREA; z < BURST_AREA; z++)
+        for (int x = -BURST_AREA; x < BURST_AREA; x++)
+            for (int y = WORLD_MIN_CHUNK_Y; y <= WORLD_MAX_CHUNK_Y; y++) pipeline.requestChunk({ x, y, z });
+    do {
+        frameWork(1 << 30);
+        std::this_thread::yield();
+    } while (!pipeline.isIdle());
+
+    // Le raffiche cadono nella metà interna dell'area, così crateri e
+    // riempimenti passano da un chunk all'altro ma restano nei chunk caricati
+    uint32_t rng = 2024;
+    const int INNER = BURST_AREA * CHUNK_SIZE / 2;
+    const BurstKind KINDS[4] = { BurstKind::Crater, BurstKind::StoneFill, BurstKind::BigCrater, BurstKind::WaterFill };
+
+    std::vector<BlockEdit> burst;
+    std::vector<double> frameTimes, lightTimes, settleTimes;
+    long long totalEdits = 0, perEditRequests = 0;
+    int framesOverBudget = 0, meshesRebuilt = 0, bursts = 0;
+    std::vector<Clock::time_point> unsettled; // raffiche con mesh ancora da sostituire
+
+    const auto frameBudget = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(BURST_DELTA));
+    auto deadline = Clock::now();
+    for (int frame = 0; frame < BURST_FRAMES; frame++) {
+        deadline += frameBudget;
+
+        // Le modifiche arrivano prima del frame (dal gameplay): si prepara
+        // solo la lista, il lavoro vero è dentro il tempo del frame
+        bool burstFrame = frame % BURST_EVERY == 0;
+        if (burstFrame) {
+            int x = -INNER + (int)(xorshift(rng) % (2 * INNER));
+            int z = -INNER + (int)(xorshift(rng) % (2 * INNER));
+            buildBurst(KINDS[bursts % 4], x, surfaceY(world, x, z), z, burst);
+            // Quanti rimeshing chiederebbe un aggiornamento per modifica
+            for (const BlockEdit& e : burst)
+                World::forEachChunkTouching(e.x, e.y, e.z, [&perEditRequests](const ChunkPos&) { perEditRequests++; });
+            totalEdits += (long long)burst.size();
+            bursts++;
+        }
+
+        auto frameStart = Clock::now();
+        if (burstFrame) {
+            light.setBlocks(burst.data(), burst.size());
+            lightTimes.push_back(secondsSince(frameStart));
+            unsettled.push_back(frameStart);
+        }
+        meshesRebuilt += frameWork(BURST_UPLOADS);
+        double frameSeconds = secondsSince(frameStart);
+        frameTimes.push_back(frameSeconds);
+        if (frameSeconds > BURST_DELTA) framesOverBudget++;
+
+        // Tutte le mesh toccate sono state sostituite
+        if (pipeline.isIdle()) {
+            for (auto start : unsettled) settleTimes.push_back(secondsSince(start));
+            unsettled.clear();
+        }
+
+        if (Clock::now() < deadline) std::this_thread::sleep_until(deadline);
+        else deadline = Clock::now();
+    }
+    do {
+        meshesRebuilt += frameWork(1 << 30);
+        std::this_thread::yield();
+    } while (!pipeline.isIdle());
+    for (auto start : unsettled) settleTimes.push_back(secondsSince(start));
+
+    ctx.value("edits per burst", (double)totalEdits / std::max(bursts, 1), "edits");
+    ctx.latency("light per burst", std::move(lightTimes));
+    ctx.latency("main thread frame", std::move(frameTimes));
+    ctx.value("frames over 16.7 ms", framesOverBudget, "frames");
+    ctx.value("remesh requests, one per edit", (double)perEditRequests / std::max(bursts, 1), "chunks/burst");
+    ctx.value("meshes rebuilt (coalesced)", (double)meshesRebuilt / std::max(bursts, 1), "chunks/burst");
+    ctx.latency("burst to last mesh replaced", std::move(settleTimes));
+
+    // Ogni mesh caricata deve essere quella dei blocchi e della luce di adesso
+    int mismatched = 0;
+    auto input = std::make_unique<MeshInput>();
+    ChunkMesh expected;
+    for (const auto& [pos, mesh] : uploaded) {
+        input->gather(world, pos);
+        buildChunkMesh(*input, expected);
+        bool same = mesh.vertices.size() == expected.vertices.size() && mesh.indices == expected.indices &&
+                    std::memcmp(mesh.vertices.data(), expected.vertices.data(), mesh.vertices.size() * sizeof(PackedVertex)) == 0;
+        mismatched += !same;
+    }
+    ctx.check(bursts > 0 && !uploaded.empty(), "edit bursts meshed no chunks");
+    ctx.check(mismatched == 0, "every uploaded mesh matches the edited world (" + std::to_string(mismatched) + " stale)");
+}
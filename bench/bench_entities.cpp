@@ -0,0 +1,208 @@
+#include "bench.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "job_system.h"
+#include "mobs.h"
+#include "raycast.h"
+#include "terrain.h"
+#include "world.h"
+
+// ---------------------------------------------------------------
+// Creature nell'ECS. Un terreno vero e sempre più creature che
+// girano, saltano e sbattono sui blocchi: quanto costa un tick (i
+// sistemi di MobSystem::update) e le istanze da disegnare, con un
+// thread solo e con i batch divisi tra i worker. Le due versioni
+// devono arrivare allo stesso stato al bit, e nessuna creatura deve
+// finire dentro un blocco.
+//
+// Poi il registry da solo: handle scaduti, componenti aggiunti e
+// tolti (l'entità cambia archetipo e si porta dietro i dati), righe
+// spostate dalle distruzioni.
+// ---------------------------------------------------------------
+
+static const int AREA  = 8;  // colonne di chunk per lato attorno all'origine
+static const int TICKS = 30;
+static const float TICK_SECONDS = 1.0f / 60.0f;
+
+namespace {
+
+struct EntityWorld {
+    World            world;
+    TerrainGenerator terrain{ 1337 };
+
+    EntityWorld() {
+        for (int cz = -AREA / 2; cz < AREA / 2; cz++)
+            for (int cx = -AREA / 2; cx < AREA / 2; cx++)
+                for (int cy = WORLD_MIN_CHUNK_Y; cy <= WORLD_MAX_CHUNK_Y; cy++) {
+                    ChunkPos pos = { cx, cy, cz };
+                    auto chunk = std::make_unique<Chunk>();
+                    terrain.generate(pos, *chunk);
+                    world.insertChunk(pos, std::move(chunk));
+                }
+    }
+
+    glm::vec3 center() const {
+        return glm::vec3(0.0f, (float)std::max(terrain.surfaceHeight(0, 0), TerrainGenerator::SEA_LEVEL), 0.0f);
+    }
+};
+
+// FNV-1a su posizioni e velocità di tutte le creature, nell'ordine
+// del registry (lo stesso per le due versioni: stessi spawn e distruzioni)
+uint64_t hashMobs(const MobSystem& mobs) {
+    uint64_t hash = 14695981039346656037ull;
+    auto mix = [&hash](const void* data, size_t size) {
+        const uint8_t* bytes = (const uint8_t*)data;
+        for (size_t i = 0; i < size; i++) hash = (hash ^ bytes[i]) * 1099511628211ull;
+    };
+    mobs.registry().forEachBatch<const Transform, const Velocity>(
+        [&mix](const EntityBatch& batch, const Transform* transform, const Velocity* velocity) {
+            for (int i = 0; i < batch.count; i++) {
+                mix(&transform[i], sizeof(Transform));
+                mix(&velocity[i].linear, sizeof(glm::vec3));
+            }
+        });
+    return hash;
+}
+
+int countInsideBlocks(const World& world, const MobSystem& mobs) {
+    int inside = 0;
+    mobs.registry().forEachBatch<const Transform, const BoundingBox>(
+        [&](const EntityBatch& batch, const Transform* transform, const BoundingBox* bounds) {
+            for (int i = 0; i < batch.count; i++) {
+                // Un filo più piccolo: appoggiate su una faccia non contano
+                glm::vec3 half = bounds[i].halfExtents - 1e-3f;
+                inside += overlapsSolid(world, { transform[i].position - half, transform[i].position + half });
+            }
+        });
+    return inside;
+}
+
+struct RunResult {
+    double   tickSeconds     = 0.0;
+    double   instanceSeconds = 0.0;
+    uint64_t hash   = 0;
+    int      mobs   = 0;
+    int      inside = 0;
+};
+
+RunResult run(const EntityWorld& scene, int count, JobSystem* jobs) {
+    MobSystem mobs(jobs);
+    RunResult result;
+    mobs.spawn(scene.world, scene.center(), count, AREA * CHUNK_SIZE * 0.5f - 2.0f);
+
+    // Qualche tick per farle atterrare prima di misurare
+    for (int tick = 0; tick < 10; tick++) mobs.update(scene.world, TICK_SECONDS);
+
+    std::vector<InstanceData> instances;
+    instances.reserve(mobs.count());
+    for (int tick = 0; tick < TICKS; tick++) {
+        auto start = Clock::now();
+        mobs.update(scene.world, TICK_SECONDS);
+        result.tickSeconds += secondsSince(start);
+
+        start = Clock::now();
+        instances.clear();
+        mobs.appendInstances(scene.world, instances, 0.5f);
+        result.instanceSeconds += secondsSince(start);
+    }
+    result.hash   = hashMobs(mobs);
+    result.mobs   = mobs.count();
+    result.inside = countInsideBlocks(scene.world, mobs);
+    return result;
+}
+
+} // namespace
+
+static void benchMobTicks(BenchContext& ctx) {
+    EntityWorld scene;
+    JobSystem jobs;
+    JobSystem fourWorkers(4); // anche con un core solo: la divisione deve cambiare niente
+
+    bool sameState = true, spawnedAll = true;
+    int inside = 0;
+    for (int count : { 1024, 4096, 16384, 65536 }) {
+        RunResult serial   = run(scene, count, nullptr);
+        RunResult parallel = run(scene, count, &jobs);
+        RunResult split    = run(scene, count, &fourWorkers);
+
+        std::string label = std::to_string(count) + " mobs";
+        ctx.throughput("tick, " + label + ", 1 thread", (double)serial.mobs * TICKS, serial.tickSeconds, "mobs");
+        ctx.throughput("tick, " + label + ", " + std::to_string(jobs.workerCount()) + " workers",
+                       (double)parallel.mobs * TICKS, parallel.tickSeconds, "mobs");
+        ctx.throughput("instances, " + label + ", " + std::to_string(jobs.workerCount()) + " workers",
+                       (double)parallel.mobs * TICKS, parallel.instanceSeconds, "mobs");
+        ctx.value("tick, " + label + ", speedup", serial.tickSeconds / parallel.tickSeconds, "x");
+
+        sameState  &= serial.hash == parallel.hash && serial.hash == split.hash && serial.mobs == split.mobs;
+        spawnedAll &= serial.mobs > count * 9 / 10;
+        inside     += serial.inside + parallel.inside;
+    }
+
+    ctx.check(spawnedAll, "mobs spawn on the ground of the loaded area");
+    ctx.check(sameState, "serial and parallel systems reach the same state bit for bit");
+    ctx.check(inside == 0, "no mob ends up inside a block (" + std::to_string(inside) + ")");
+}
+
+namespace {
+
+struct Tag { uint32_t value; };
+struct Health { float hitPoints; };
+
+} // namespace
+
+static void benchRegistry(BenchContext& ctx) {
+    const int COUNT = 100000;
+    EntityRegistry registry;
+    std::vector<Entity> entities;
+
+    auto start = Clock::now();
+    for (int i = 0; i < COUNT; i++)
+        entities.push_back(registry.create(Transform{ glm::vec3((float)i), 0.0f }, Tag{ (uint32_t)i }));
+    ctx.throughput("create (2 components)", COUNT, secondsSince(start), "entities");
+
+    // Ogni terza perde Tag e ogni quinta guadagna Health: cambiano archetipo
+    start = Clock::now();
+    for (int i = 0; i < COUNT; i += 3) registry.remove<Tag>(entities[i]);
+    for (int i = 0; i < COUNT; i += 5) registry.add(entities[i], Health{ (float)i });
+    ctx.throughput("add/remove component", COUNT / 3 + COUNT / 5, secondsSince(start), "entities");
+
+    // Le pari muoiono: le righe delle altre si spostano nei buchi
+    start = Clock::now();
+    for (int i = 0; i < COUNT; i += 2) registry.destroy(entities[i]);
+    ctx.throughput("destroy", COUNT / 2, secondsSince(start), "entities");
+
+    int wrong = 0;
+    for (int i = 0; i < COUNT; i++) {
+        const Entity& e = entities[i];
+        if (i % 2 == 0) {
+            wrong += registry.alive(e) || registry.get<Transform>(e) != nullptr;
+            continue;
+        }
+        const Transform* transform = registry.get<Transform>(e);
+        const Tag*       tag       = registry.get<Tag>(e);
+        const Health*    health    = registry.get<Health>(e);
+        wrong += !transform || transform->position.x != (float)i;
+        wrong += (i % 3 == 0) != (tag == nullptr) || (tag && tag->value != (uint32_t)i);
+        wrong += (i % 5 == 0) != (health != nullptr) || (health && health->hitPoints != (float)i);
+    }
+
+    // Indici riusati: i vecchi handle non devono vedere le entità nuove
+    for (int i = 0; i < COUNT; i += 2) registry.create(Tag{ 0 });
+    for (int i = 0; i < COUNT; i += 2) wrong += registry.alive(entities[i]);
+
+    size_t tagged = registry.countWith<Tag>(), visited = 0;
+    registry.forEachBatch<const Tag>([&visited](const EntityBatch& batch, const Tag*) { visited += batch.count; });
+
+    ctx.value("archetypes", registry.archetypeCount(), "archetypes");
+    ctx.check(wrong == 0, "handles, components and moved rows stay consistent (" + std::to_string(wrong) + " wrong)");
+    ctx.check(registry.count() == COUNT && visited == tagged, "entity count and queries agree after churn");
+}
+
+void benchEntities(BenchContext& ctx) {
+    benchMobTicks(ctx);
+    benchRegistry(ctx);
+}
@@ -0,0 +1,247 @@
+#include "bench.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "block_updates.h"
+#include "job_system.h"
+#include "world.h"
+
+// ---------------------------------------------------------------
+// Acqua, lava e sabbia con BlockUpdateSystem. Una vasca piatta di
+// 256x256 blocchi (fuori dai chunk caricati è come pietra): sopra,
+// a y = 64, una sorgente ogni due blocchi. Ogni sorgente fa cadere una
+// colonna d'acqua fino al fondo, dove si allarga: più di un milione di
+// celle di fluido. Poi le sorgenti spariscono e tutto si asciuga.
+//
+// Si misura il passo (tick) con un thread solo e con 1, 2, 4 worker e
+// quelli di default: ogni versione deve arrivare allo stesso mondo al
+// bit, ferma (niente più in programma) e, alla fine, senza una goccia.
+// Un lago fermo non deve costare niente; una modifica accanto deve
+// svegliare solo le celle attorno.
+//
+// Poi le regole in piccolo: una lastra di sabbia che cade (nessun
+// granello perso) e la lava che incontra l'acqua e diventa pietra.
+// ---------------------------------------------------------------
+
+static const int AREA       = 16; // chunk per lato
+static const int SOURCE_Y   = 64;
+static const int SPACING    = 2;  // una sorgente ogni SPACING blocchi, in x e in z
+static const int MAX_TICKS  = 400;
+
+namespace {
+
+// La vasca: pavimento di pietra a y = 0, il resto aria
+void buildBasin(World& world, int area) {
+    for (int cz = 0; cz < area; cz++)
+        for (int cx = 0; cx < area; cx++)
+            for (int cy = WORLD_MIN_CHUNK_Y; cy <= WORLD_MAX_CHUNK_Y; cy++) {
+                auto chunk = std::make_unique<Chunk>();
+                if (cy == 0)
+                    for (int z = 0; z < CHUNK_SIZE; z++)
+                        for (int x = 0; x < CHUNK_SIZE; x++) chunk->setBlock(x, 0, z, BLOCK_STONE);
+                world.insertChunk({ cx, cy, cz }, std::move(chunk));
+            }
+}
+
+// Celle con un fluido, in tutto il mondo
+long long countFluid(const World& world) {
+    long long count = 0;
+    world.forEachChunk([&count](const ChunkPos&, const Chunk& chunk) {
+        if (chunk.isEmpty()) return;
+        for (int i = 0; i < CHUNK_VOLUME; i++) count += isFluid(chunk.getBlockAt(i));
+    });
+    return count;
+}
+
+long long countBlock(const World& world, BlockID id) {
+    long long count = 0;
+    world.forEachChunk([&](const ChunkPos&, const Chunk& chunk) {
+        for (int i = 0; i < CHUNK_VOLUME; i++) count += chunk.getBlockAt(i) == id;
+    });
+    return count;
+}
+
+// FNV-1a dei chunk serializzati, in ordine di posizione
+uint64_t hashWorld(const World& world) {
+    std::vector<ChunkPos> positions;
+    world.forEachChunk([&positions](const ChunkPos& pos, const Chunk&) { positions.push_back(pos); });
+    std::sort(positions.begin(), positions.end(), [](const ChunkPos& a, const ChunkPos& b) {
+        if (a.y != b.y) return a.y < b.y;
+        return a.z != b.z ? a.z < b.z : a.x < b.x;
+    });
+    uint64_t hash = 14695981039346656037ull;
+    std::vector<uint8_t> bytes;
+    for (const ChunkPos& pos : positions) {
+        bytes.clear();
+        world.findChunk(pos)->serialize(bytes);
+        for (uint8_t b : bytes) hash = (hash ^ b) * 1099511628211ull;
+    }
+    return hash;
+}
+
+struct FloodRun {
+    std::vector<double> tickTimes; // piena e svuotamento
+    double    seconds    = 0.0;
+    int       floodTicks = 0;
+    int       drainTicks = 0;
+    long long cellUpdates = 0; // celle aggiornate in tutti i passi
+    long long peakCells  = 0;  // celle aggiornate nel passo più pesante
+    long long fluidCells = 0;  // a piena ferma
+    long long leftover   = 0;  // fluido rimasto dopo lo svuotamento
+    bool      settled    = false;
+    uint64_t  floodHash  = 0;
+
+    // Con il lago fermo
+    double idleTickSeconds = 0.0;
+    int    idleCells       = -1;
+    int    editCells       = 0; // celle aggiornate nel passo dopo una modifica
+};
+
+// Passi finché non c'è più niente in programma
+int runUntilSettled(World& world, BlockUpdateSystem& updates, FloodRun& run) {
+    int ticks = 0;
+    while (updates.scheduledCells() > 0 && ticks < MAX_TICKS) {
+        auto start = Clock::now();
+        updates.update(world);
+        run.tickTimes.push_back(secondsSince(start));
+        run.cellUpdates += updates.lastUpdatedCells();
+        run.peakCells    = std::max(run.peakCells, (long long)updates.lastUpdatedCells());
+        ticks++;
+    }
+    return ticks;
+}
+
+FloodRun runFlood(JobSystem* jobs) {
+    World world;
+    buildBasin(world, AREA);
+    BlockUpdateSystem updates(jobs);
+    FloodRun run;
+
+    const int side = AREA * CHUNK_SIZE;
+    for (int z = 0; z < side; z += SPACING)
+        for (int x = 0; x < side; x += SPACING) {
+            world.setBlock(x, SOURCE_Y, z, BLOCK_WATER);
+            updates.blockChanged(world, x, SOURCE_Y, z);
+        }
+
+    auto start = Clock::now();
+    run.floodTicks = runUntilSettled(world, updates, run);
+    double floodSeconds = secondsSince(start);
+    run.settled    = updates.scheduledCells() == 0;
+    run.fluidCells = countFluid(world);
+    run.floodHash  = hashWorld(world);
+
+    // Fermo: il passo non tocca niente
+    auto idleStart = Clock::now();
+    updates.update(world);
+    run.idleTickSeconds = secondsSince(idleStart);
+    run.idleCells = updates.lastUpdatedCells();
+
+    // Un blocco di pietra in mezzo a una colonna: si svegliano le celle attorno
+    world.setBlock(side / 2, SOURCE_Y / 2, side / 2, BLOCK_STONE);
+    updates.blockChanged(world, side / 2, SOURCE_Y / 2, side / 2);
+    updates.update(world);
+    run.editCells = updates.lastUpdatedCells();
+    world.setBlock(side / 2, SOURCE_Y / 2, side / 2, BLOCK_AIR);
+    updates.blockChanged(world, side / 2, SOURCE_Y / 2, side / 2);
+
+    // Via le sorgenti: le colonne si svuotano dall'alto
+    for (int z = 0; z < side; z += SPACING)
+        for (int x = 0; x < side; x += SPACING) {
+            world.setBlock(x, SOURCE_Y, z, BLOCK_AIR);
+            updates.blockChanged(world, x, SOURCE_Y, z);
+        }
+    start = Clock::now();
+    run.drainTicks = runUntilSettled(world, updates, run);
+    run.seconds    = floodSeconds + secondsSince(start);
+    run.settled   &= updates.scheduledCells() == 0;
+    run.leftover   = countFluid(world);
+    return run;
+}
+
+} // namespace
+
+void benchFluids(BenchContext& ctx) {
+    FloodRun serial = runFlood(nullptr);
+    ctx.latency("flood tick, 1 thread", serial.tickTimes);
+    ctx.value("fluid cells at full flood", (double)serial.fluidCells, "cells");
+    ctx.value("busiest tick", (double)serial.peakCells, "cells");
+    ctx.value("ticks to settle (flood + drain)", (double)(serial.floodTicks + serial.drainTicks), "ticks");
+    ctx.throughput("cell updates, 1 thread", (double)serial.cellUpdates, serial.seconds, "cells");
+    ctx.value("idle tick with a settled flood", serial.idleTickSeconds * 1e6, "us");
+    ctx.value("cells woken by one edit", (double)serial.editCells, "cells");
+
+    bool same = true, settled = serial.settled, dry = serial.leftover == 0;
+    struct Config {
+        const char* label;
+        int         workers;
+    };
+    const Config configs[] = { { "1 worker", 1 }, { "2 workers", 2 }, { "4 workers", 4 }, { "default workers", 0 } };
+    for (const Config& config : configs) {
+        JobSystem jobs(config.workers);
+        FloodRun run = runFlood(&jobs);
+        std::string label = config.workers == 0 ? "default workers (" + std::to_string(jobs.workerCount()) + ")" : config.label;
+        ctx.latency("flood tick, " + label, run.tickTimes);
+        ctx.throughput("cell updates, " + label, (double)run.cellUpdates, run.seconds, "cells");
+        ctx.value("speedup over 1 thread, " + label, serial.seconds / run.seconds, "x");
+        same    &= run.floodHash == serial.floodHash && run.floodTicks == serial.floodTicks && run.drainTicks == serial.drainTicks;
+        settled &= run.settled;
+        dry     &= run.leftover == 0;
+    }
+
+    ctx.check(serial.fluidCells >= 1000000, "the flood reaches a million fluid cells (" + std::to_string(serial.fluidCells) + ")");
+    ctx.check(settled, "every flood settles with nothing left scheduled");
+    ctx.check(same, "every worker count ends in the same world, bit for bit");
+    ctx.check(dry, "without sources the flood drains completely");
+    ctx.check(serial.idleCells == 0, "a settled flood costs no cell updates");
+    ctx.check(serial.editCells > 0 && serial.editCells < 64, "one edit wakes only the cells around it");
+
+    // Sabbia: una lastra 32x32 spessa 2 a y = 100 cade sul fondo
+    {
+        World world;
+        buildBasin(world, 2);
+        BlockUpdateSystem updates;
+        for (int y = 100; y < 102; y++)
+            for (int z = 0; z < 32; z++)
+                for (int x = 0; x < 32; x++) {
+                    world.setBlock(x, y, z, BLOCK_SAND);
+                    updates.blockChanged(world, x, y, z);
+                }
+        int ticks = 0;
+        while (updates.scheduledCells() > 0 && ticks++ < MAX_TICKS) updates.update(world);
+        long long landed = 0;
+        for (int y = 1; y <= 2; y++)
+            for (int z = 0; z < 32; z++)
+                for (int x = 0; x < 32; x++) landed += world.getBlock(x, y, z) == BLOCK_SAND;
+        ctx.value("ticks for sand to fall 99 blocks", (double)ticks, "ticks");
+        ctx.check(landed == 2 * 32 * 32 && countBlock(world, BLOCK_SAND) == landed, "falling sand lands on the floor without losing grains");
+    }
+
+    // Lava e acqua: due sorgenti a 8 blocchi, dove si incontrano pietra
+    {
+        World world;
+        buildBasin(world, 2);
+        BlockUpdateSystem updates;
+        long long stoneBefore = countBlock(world, BLOCK_STONE);
+        world.setBlock(8, 1, 16, BLOCK_WATER);
+        world.setBlock(16, 1, 16, BLOCK_LAVA);
+        updates.blockChanged(world, 8, 1, 16);
+        updates.blockChanged(world, 16, 1, 16);
+        int ticks = 0;
+        while (updates.scheduledCells() > 0 && ticks++ < MAX_TICKS) updates.update(world);
+
+        bool touching = false;
+        for (int z = 0; z < 32; z++)
+            for (int x = 0; x < 32; x++) {
+                if (fluidSource(world.getBlock(x, 1, z)) != BLOCK_LAVA) continue;
+                for (int d : { -1, 1 })
+                    touching |= fluidSource(world.getBlock(x + d, 1, z)) == BLOCK_WATER
+                             || fluidSource(world.getBlock(x, 1, z + d)) == BLOCK_WATER;
+            }
+        ctx.check(countBlock(world, BLOCK_STONE) > stoneBefore && !touching && updates.scheduledCells() == 0,
+                  "lava meeting water turns to stone and settles");
+    }
+}
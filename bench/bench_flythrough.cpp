@@ -0,0 +1,138 @@
+#include "bench.h"
+
+#include <cmath>
+#include <thread>
+
+#include "camera.h"
+#include "chunk_pipeline.h"
+#include "culling.h"
+#include "job_system.h"
+#include "light.h"
+#include "terrain.h"
+#include "world.h"
+
+// ---------------------------------------------------------------
+// Volo scriptato: la camera del gioco, guidata con gli stessi
+// processKeyboard/processMouseMovement dell'input vero, vola sopra il
+// terreno per 20 secondi simulati a 60 FPS. Ogni frame fa quello che
+// fa il game loop sulla CPU: chiede i chunk attorno alla camera,
+// raccoglie generazione e mesh dai worker, illumina i chunk nuovi
+// (rimeshando i vicini in cui la luce cambia) e fa il culling.
+// Il passo della camera è fisso (1/60 s), quindi il percorso è sempre
+// lo stesso; a fine frame si aspetta la scadenza dei 60 FPS come farebbe
+// il vsync, così i worker hanno il tempo che avrebbero nel gioco.
+// ---------------------------------------------------------------
+static const int   FLY_RENDER_DISTANCE = 6;
+static const int   FLY_FRAMES          = 600;
+static const float FLY_DELTA_TIME      = 1.0f / 60.0f;
+
+// Come nel gioco: i chunk in cui la luce è cambiata vanno rimeshati
+static void remeshStale(World& world, ChunkPipeline& pipeline) {
+    static std::vector<ChunkPos> stale;
+    world.takeMeshDirtyChunks(stale);
+    for (const ChunkPos& pos : stale) pipeline.requestMesh(pos);
+}
+
+static void drain(ChunkPipeline& pipeline, World& world, ChunkCuller& culler, const glm::vec3& cameraPosition, int& meshes) {
+    do {
+        pipeline.update(cameraPosition, 1 << 30);
+        remeshStale(world, pipeline);
+        meshes += pipeline.consumeMeshes([&](const ChunkPos& pos, const ChunkMesh& mesh) {
+            culler.setChunk(pos, mesh.visibility, !mesh.empty());
+        }, 1 << 30);
+        std::this_thread::yield();
+    } while (!pipeline.isIdle());
+}
+
+static void requestChunksAround(ChunkPipeline& pipeline, const ChunkPos& center) {
+    for (int z = center.z - FLY_RENDER_DISTANCE; z <= center.z + FLY_RENDER_DISTANCE; z++)
+        for (int x = center.x - FLY_RENDER_DISTANCE; x <= center.x + FLY_RENDER_DISTANCE; x++)
+            for (int y = WORLD_MIN_CHUNK_Y; y <= WORLD_MAX_CHUNK_Y; y++)
+                pipeline.requestChunk({ x, y, z });
+}
+
+void benchFlythrough(BenchContext& ctx) {
+    World world;
+    JobSystem jobs;
+    TerrainGenerator terrain(1337);
+    ChunkPipeline pipeline(jobs, world, [&terrain](const ChunkPos& pos, Chunk& chunk) {
+        terrain.generate(pos, chunk);
+    });
+    LightEngine light(world);
+    pipeline.setInsertedCallback([&light](const ChunkPos& pos) { light.onChunkLoaded(pos); });
+    ChunkCuller culler;
+    std::vector<ChunkPos> visible;
+
+    Camera camera(glm::vec3(8.0f, 110.0f, 8.0f), 0.0f, -20.0f);
+    camera.movementSpeed = 30.0f;
+
+    int meshesUploaded = 0;
+    long long drawnTotal = 0;
+    int framesOverBudget = 0;
+
+    // Come all'avvio del gioco: l'area iniziale si carica prima di partire
+    ChunkPos lastCameraChunk = World::toChunkPos(
+        (int)std::floor(camera.position.x), (int)std::floor(camera.position.y), (int)std::floor(camera.position.z));
+    auto start = Clock::now();
+    requestChunksAround(pipeline, lastCameraChunk);
+    drain(pipeline, world, culler, camera.position, meshesUploaded);
+    ctx.value("initial area load", secondsSince(start) * 1e3, "ms");
+    int initialChunks = world.chunkCount();
+
+    const auto frameBudget = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(FLY_DELTA_TIME));
+    std::vector<double> frameTimes, cullTimes;
+    start = Clock::now();
+    auto deadline = start;
+    for (int frame = 0; frame < FLY_FRAMES; frame++) {
+        auto frameStart = Clock::now();
+        deadline += frameBudget;
+
+        // Input scriptato: sempre avanti, con una virata lenta a destra e
+        // uno sguardo che oscilla su e giù, più qualche passo laterale
+        camera.processKeyboard(FORWARD, FLY_DELTA_TIME);
+        if ((frame / 120) % 3 == 2) camera.processKeyboard(LEFT, FLY_DELTA_TIME);
+        camera.processMouseMovement(2.0f, 3.0f * std::sin(frame * 0.02f));
+
+        ChunkPos cameraChunk = World::toChunkPos(
+            (int)std::floor(camera.position.x), (int)std::floor(camera.position.y), (int)std::floor(camera.position.z));
+        if (!(cameraChunk == lastCameraChunk)) {
+            requestChunksAround(pipeline, cameraChunk);
+            lastCameraChunk = cameraChunk;
+        }
+
+        pipeline.update(camera.position);
+        remeshStale(world, pipeline);
+        meshesUploaded += pipeline.consumeMeshes([&](const ChunkPos& pos, const ChunkMesh& mesh) {
+            culler.setChunk(pos, mesh.visibility, !mesh.empty());
+        }, 64);
+
+        auto cullStart = Clock::now();
+        glm::mat4 projection = glm::perspective(glm::radians(camera.fov), 16.0f / 9.0f, 0.1f, 200.0f);
+        culler.cull(Frustum::fromMatrix(projection * camera.getViewMatrix()), camera.position, FLY_RENDER_DISTANCE, visible);
+        cullTimes.push_back(secondsSince(cullStart));
+        drawnTotal += (long long)visible.size();
+
+        double frameSeconds = secondsSince(frameStart);
+        frameTimes.push_back(frameSeconds);
+        if (frameSeconds > FLY_DELTA_TIME) framesOverBudget++;
+
+        // Un frame in ritardo non si recupera: si riparte da adesso
+        if (Clock::now() < deadline) std::this_thread::sleep_until(deadline);
+        else deadline = Clock::now();
+    }
+    double flySeconds = secondsSince(start);
+
+    // Quanti chunk sono ancora da fare alla fine: se la pipeline non
+    // sta dietro alla camera questo numero cresce
+    int pendingAtEnd = pipeline.jobsInFlight();
+    drain(pipeline, world, culler, camera.position, meshesUploaded);
+
+    ctx.latency("main thread frame", std::move(frameTimes));
+    ctx.latency("cull per frame", std::move(cullTimes));
+    ctx.value("frames over 16.7 ms", framesOverBudget, "frames");
+    ctx.value("distance flown", glm::length(camera.position - glm::vec3(8.0f, 110.0f, 8.0f)), "blocks");
+    ctx.value("chunks drawn per frame", (double)drawnTotal / FLY_FRAMES, "chunks");
+    ctx.value("jobs still in flight at the end", pendingAtEnd, "jobs");
+    ctx.throughput("chunks streamed while flying", world.chunkCount() - initialChunks, flySeconds, "chunks");
+    ctx.check(initialChunks > 0 && drawnTotal > 0, "fly-through drew no chunks");
+}
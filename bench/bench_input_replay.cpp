@@ -0,0 +1,148 @@
+#include "bench.h"
+
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "input_recording.h"
+#include "job_system.h"
+#include "replay.h"
+#include "terrain.h"
+
+// ---------------------------------------------------------------
+// Registrare e rigiocare una partita.
+//
+// 1) Il file: una partita scritta a mano (avanti con W, il mouse che
+//    gira piano, in noclip, qualche blocco rotto e piazzato, creature, zoom) con
+//    frame di durata irregolare, salvata e riletta identica. Quanti
+//    byte costa un frame; un file troncato o con un byte cambiato non
+//    si carica.
+//
+// 2) La stessa partita rigiocata senza finestra due volte, con un
+//    worker e con tre: i chunk arrivano in momenti diversi, ma lo
+//    stato finale della simulazione deve essere lo stesso. Tempi per
+//    frame e frame al secondo, come li vedrebbe voxel_replay.
+// ---------------------------------------------------------------
+
+static const uint32_t REPLAY_SEED   = 1337;
+static const int      REPLAY_FRAMES = 600;
+
+namespace {
+
+InputRecording scriptedSession() {
+    TerrainGenerator terrain(REPLAY_SEED);
+    InputRecording recording;
+    recording.seed     = REPLAY_SEED;
+    recording.tickRate = 60;
+    recording.spawn    = glm::vec3(0.5f, (float)std::max(terrain.surfaceHeight(0, 0), TerrainGenerator::SEA_LEVEL) + 3.0f, 0.5f);
+
+    uint32_t rng = 0x1234567u;
+    for (int i = 0; i < REPLAY_FRAMES; i++) {
+        InputFrame frame;
+        frame.frameMicros = 14000 + xorshift(rng) % 5000; // 53-71 FPS
+        if (i >= 30 && i < 500) frame.press(KEY_FORWARD);
+        if (i % 4 == 0) {
+            frame.mouseX = 3.0f * std::sin(i * 0.05f);
+            frame.mouseY = i % 8 == 0 ? -0.5f : 0.5f;
+        }
+        if (i % 60 == 59) frame.press(KEY_BREAK);
+        if (i % 90 == 80) frame.press(KEY_PLACE);
+        if (i >= 300 && i < 305) frame.press((InputKey)(KEY_BLOCK_1 + 2));
+        if (i == 20) frame.press(KEY_NOCLIP); // senza collisioni: le colline non fermano il giro
+        if (i == 100) frame.press(KEY_SPAWN_MOBS);
+        if (i == 200) frame.scroll = 1.0f;
+        recording.frames.push_back(frame);
+    }
+    return recording;
+}
+
+bool sameFrames(const std::vector<InputFrame>& a, const std::vector<InputFrame>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++)
+        if (a[i].keys != b[i].keys || a[i].frameMicros != b[i].frameMicros || a[i].mouseX != b[i].mouseX
+            || a[i].mouseY != b[i].mouseY || a[i].scroll != b[i].scroll)
+            return false;
+    return true;
+}
+
+} // namespace
+
+void benchInputReplay(BenchContext& ctx) {
+    InputRecording recording = scriptedSession();
+    std::string path = (std::filesystem::temp_directory_path() / "voxel_bench_session.vxin").string();
+
+    // --- 1) Il file ---
+    ctx.check(saveInputRecording(path, recording), "recording saved");
+    InputRecording loaded;
+    bool roundTrip = loadInputRecording(path, loaded);
+    ctx.check(roundTrip && sameFrames(recording.frames, loaded.frames) && loaded.seed == recording.seed
+              && loaded.spawn == recording.spawn && loaded.tickRate == recording.tickRate,
+              "recording reloads identical");
+    double fileBytes = (double)std::filesystem::file_size(path);
+    ctx.value("file size", fileBytes, "bytes");
+    ctx.value("bytes per frame", fileBytes / REPLAY_FRAMES, "bytes");
+    ctx.note("%d frames, %.1f s of play in %.0f bytes", REPLAY_FRAMES, recording.seconds(), fileBytes);
+
+    {
+        std::vector<char> bytes(std::filesystem::file_size(path));
+        std::ifstream(path, std::ios::binary).read(bytes.data(), (std::streamsize)bytes.size());
+        bytes[bytes.size() / 2] ^= 0x40;
+        std::ofstream(path, std::ios::binary | std::ios::trunc).write(bytes.data(), (std::streamsize)bytes.size());
+        InputRecording damaged;
+        ctx.check(!loadInputRecording(path, damaged) && damaged.frames.empty(), "damaged recording rejected");
+
+        std::ofstream(path, std::ios::binary | std::ios::trunc).write(bytes.data(), (std::streamsize)bytes.size() - 7);
+        ctx.check(!loadInputRecording(path, damaged), "truncated recording rejected");
+
+        bytes.resize(bytes.size() + 64, 0);
+        std::ofstream(path, std::ios::binary | std::ios::trunc).write(bytes.data(), (std::streamsize)bytes.size());
+        ctx.check(!loadInputRecording(path, damaged), "recording with trailing bytes rejected");
+
+        // Un numero di frame assurdo nell'header (il campo dopo magic,
+        // versione, seed, tickRate, spawn e camera): si scarta senza
+        // provare ad allocarli
+        bytes.resize(bytes.size() - 64);
+        bytes[bytes.size() / 2] ^= 0x40;
+        const uint32_t hugeFrameCount = 0xFFFFFFF0u;
+        std::memcpy(bytes.data() + 40, &hugeFrameCount, 4);
+        std::ofstream(path, std::ios::binary | std::ios::trunc).write(bytes.data(), (std::streamsize)bytes.size());
+        ctx.check(!loadInputRecording(path, damaged), "recording with an impossible frame count rejected");
+    }
+    std::filesystem::remove(path);
+
+    // --- 2) Rigiocare ---
+    ReplayResult first;
+    for (int workers : { 1, 3 }) {
+        JobSystem    jobs(workers);
+        FrameLog     log;
+        ReplayResult result = replayHeadless(recording, jobs, &log);
+
+        std::vector<double> frameTimes, waits;
+        for (const ReplayFrame& frame : log.frames()) {
+            frameTimes.push_back(frame.frameMs / 1000.0);
+            waits.push_back(frame.waitMs / 1000.0);
+        }
+        std::string label = std::to_string(workers) + (workers == 1 ? " worker" : " workers");
+        ctx.latency("replay frame (" + label + ")", frameTimes);
+        ctx.latency("chunk wait per frame (" + label + ")", waits);
+        ctx.throughput("replayed frames (" + label + ")", result.frames, result.seconds, "frames");
+        ctx.value("loading (" + label + ")", result.loadingSeconds * 1000.0, "ms");
+        ctx.note("%s: %s", label.c_str(), log.summary().c_str());
+
+        ctx.check(result.frames == REPLAY_FRAMES && (int)log.frames().size() == REPLAY_FRAMES,
+                  "every frame replayed (" + label + ")");
+        if (workers == 1) {
+            first = result;
+            // Il tempo registrato decide i tick: circa 60 al secondo di gioco
+            ctx.check(std::abs((double)result.ticks - recording.seconds() * recording.tickRate) <= 1.0,
+                      "ticks follow the recorded frame times");
+            ctx.check(glm::distance(result.finalPosition, recording.spawn) > 20.0f, "the player moved");
+        } else {
+            ctx.check(result.ticks == first.ticks && result.finalState == first.finalState,
+                      "same final state with 1 and 3 workers");
+        }
+    }
+}
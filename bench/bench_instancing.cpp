@@ -0,0 +1,178 @@
+#include "bench.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "material.h"
+#include "mesher.h"
+#include "particles.h"
+#include "terrain.h"
+
+// ---------------------------------------------------------------
+// Materiali e istanze. Prima la texture array: quanto costa generare
+// le immagini con tutte le mipmap all'avvio, e se ogni livello è
+// davvero la media di quello sopra; le mesh del terreno devono usare
+// solo layer esistenti, con il prato sopra l'erba e il bordo sui lati.
+//
+// Poi decine di migliaia di frammenti che cadono su un terreno vero:
+// per ogni frame update più le istanze da caricare (40 byte l'una, una
+// draw call), contro quello che servirebbe disegnando un oggetto alla
+// volta: una mat4 da 64 byte per oggetto, passata con un setMat4 prima
+// della sua draw call. Qui si misura solo la parte CPU; le draw call
+// sono contate, non eseguite.
+// ---------------------------------------------------------------
+
+static const int AREA = 6; // colonne di chunk per lato
+
+// La matrice model che un setMat4 per oggetto dovrebbe caricare:
+// translate * rotate(quaternione) * scale
+static glm::mat4 modelMatrix(const InstanceData& instance) {
+    const glm::vec4& q = instance.rotation;
+    float s = instance.scale;
+    glm::mat4 m(1.0f);
+    m[0] = glm::vec4(1.0f - 2.0f * (q.y * q.y + q.z * q.z), 2.0f * (q.x * q.y + q.w * q.z), 2.0f * (q.x * q.z - q.w * q.y), 0.0f) * s;
+    m[1] = glm::vec4(2.0f * (q.x * q.y - q.w * q.z), 1.0f - 2.0f * (q.x * q.x + q.z * q.z), 2.0f * (q.y * q.z + q.w * q.x), 0.0f) * s;
+    m[2] = glm::vec4(2.0f * (q.x * q.z + q.w * q.y), 2.0f * (q.y * q.z - q.w * q.x), 1.0f - 2.0f * (q.x * q.x + q.y * q.y), 0.0f) * s;
+    m[3] = glm::vec4(instance.position.x, instance.position.y, instance.position.z, 1.0f);
+    return m;
+}
+
+static void benchTextures(BenchContext& ctx) {
+    const int RUNS = 200;
+    std::vector<double> samples;
+    TextureArrayImage image;
+    for (int i = 0; i < RUNS; i++) {
+        auto start = Clock::now();
+        image = generateBlockTextures();
+        samples.push_back(secondsSince(start));
+    }
+    ctx.latency("generate texture array with mipmaps", std::move(samples));
+
+    size_t bytes = 0;
+    for (const auto& level : image.levels) bytes += level.size();
+    ctx.value("texture array size", (double)bytes / 1024.0, "KB");
+
+    // Ogni texel di ogni livello è la media arrotondata dei 2x2 sopra
+    int errors = (int)image.levels.size() != TEXTURE_LEVELS || image.levelSize(TEXTURE_LEVELS - 1) != 1;
+    for (size_t level = 1; level < image.levels.size() && !errors; level++) {
+        int size = image.levelSize((int)level), source = image.levelSize((int)level - 1);
+        const std::vector<uint8_t>& above = image.levels[level - 1];
+        errors += image.levels[level].size() != (size_t)image.layers * size * size * 4;
+        for (size_t i = 0; i < image.levels[level].size() && !errors; i++) {
+            int c = (int)(i & 3), x = (int)(i / 4) % size, y = (int)(i / 4 / size) % size, layer = (int)(i / 4 / size / size);
+            int sum = 0;
+            for (int d = 0; d < 4; d++)
+                sum += above[(((size_t)layer * source + 2 * y + (d >> 1)) * source + 2 * x + (d & 1)) * 4 + c];
+            errors += std::abs(image.levels[level][i] - (sum + 2) / 4) > 0;
+        }
+    }
+    ctx.check(errors == 0, "every mip level averages the level above");
+
+    // Layer delle facce nelle mesh del terreno generato
+    TerrainGenerator terrain(1337);
+    World world;
+    for (int cz = 0; cz < 2; cz++)
+        for (int cx = 0; cx < 2; cx++)
+            for (int cy = WORLD_MIN_CHUNK_Y; cy <= WORLD_MAX_CHUNK_Y; cy++) {
+                auto chunk = std::make_unique<Chunk>();
+                terrain.generate({ cx, cy, cz }, *chunk);
+                world.insertChunk({ cx, cy, cz }, std::move(chunk));
+            }
+    auto input = std::make_unique<MeshInput>();
+    ChunkMesh mesh;
+    int invalid = 0, grassTop = 0, grassSide = 0, wrongTop = 0;
+    for (int cz = 0; cz < 2; cz++)
+        for (int cx = 0; cx < 2; cx++)
+            for (int cy = WORLD_MIN_CHUNK_Y; cy <= WORLD_MAX_CHUNK_Y; cy++) {
+                input->gather(world, { cx, cy, cz });
+                buildChunkMesh(*input, mesh);
+                for (const PackedVertex& packed : mesh.vertices) {
+                    VertexData v = unpackVertex(packed);
+                    invalid   += v.textureLayer >= LAYER_COUNT;
+                    grassTop  += v.textureLayer == LAYER_GRASS_TOP;
+                    grassSide += v.textureLayer == LAYER_GRASS_SIDE;
+                    wrongTop  += v.textureLayer == LAYER_GRASS_TOP && v.face != 2;
+                }
+            }
+    ctx.check(invalid == 0, "mesh vertices only use existing texture layers");
+    ctx.check(grassTop > 0 && grassSide > 0 && wrongTop == 0, "grass uses its top layer on top faces only");
+}
+
+void benchInstancing(BenchContext& ctx) {
+    benchTextures(ctx);
+
+    TerrainGenerator terrain(1337);
+    World world;
+    for (int cz = 0; cz < AREA; cz++)
+        for (int cx = 0; cx < AREA; cx++)
+            for (int cy = WORLD_MIN_CHUNK_Y; cy <= WORLD_MAX_CHUNK_Y; cy++) {
+                auto chunk = std::make_unique<Chunk>();
+                terrain.generate({ cx, cy, cz }, *chunk);
+                world.insertChunk({ cx, cy, cz }, std::move(chunk));
+            }
+
+    // Blocchi rotti sulla superficie, 24 frammenti ciascuno
+    const int BROKEN = 2000;
+    const int SIZE = AREA * CHUNK_SIZE;
+    const int HEIGHT = (WORLD_MAX_CHUNK_Y + 1) * CHUNK_SIZE;
+    ParticleSystem particles;
+    uint32_t rng = 77;
+    for (int i = 0; i < BROKEN; i++) {
+        int x = 2 + (int)(xorshift(rng) % (SIZE - 4)), z = 2 + (int)(xorshift(rng) % (SIZE - 4));
+        int y = HEIGHT - 1;
+        while (y > 0 && !isSolid(world.getBlock(x, y, z))) y--;
+        particles.spawnDebris({ x, y + 1, z }, world.getBlock(x, y, z));
+    }
+    int spawned = particles.count();
+    ctx.value("particles", spawned, "instances");
+
+    // 30 frame: fisica, istanze e (per confronto) le matrici per oggetto
+    const int FRAMES = 30;
+    const float DELTA = 1.0f / 60.0f;
+    std::vector<InstanceData> instances;
+    std::vector<glm::mat4> matrices;
+    std::vector<double> updateSamples, instanceSamples, matrixSamples;
+    size_t drawn = 0;
+    float checksum = 0.0f;
+    for (int frame = 0; frame < FRAMES; frame++) {
+        auto start = Clock::now();
+        particles.update(world, DELTA);
+        updateSamples.push_back(secondsSince(start));
+
+        start = Clock::now();
+        instances.clear();
+        particles.appendInstances(world, instances);
+        instanceSamples.push_back(secondsSince(start));
+        drawn += instances.size();
+
+        start = Clock::now();
+        matrices.clear();
+        for (const InstanceData& instance : instances) matrices.push_back(modelMatrix(instance));
+        matrixSamples.push_back(secondsSince(start));
+        checksum += matrices.empty() ? 0.0f : matrices.back()[3].y;
+    }
+    ctx.latency("particle update per frame", std::move(updateSamples));
+    ctx.latency("instance data per frame", std::move(instanceSamples));
+    ctx.latency("model matrices per frame (per-object path)", std::move(matrixSamples));
+    ctx.value("upload per frame, instanced", (double)instances.size() * sizeof(InstanceData) / 1024.0, "KB");
+    ctx.value("upload per frame, one setMat4 each", (double)instances.size() * sizeof(glm::mat4) / 1024.0, "KB");
+    ctx.value("draw calls per frame, instanced", instances.empty() ? 0 : 1, "calls");
+    ctx.value("draw calls per frame, one per object", (double)instances.size(), "calls");
+
+    // Nessun frammento deve finire dentro un blocco pieno
+    int inside = 0;
+    for (const InstanceData& instance : instances) {
+        glm::vec3 p = instance.position;
+        inside += isSolid(world.getBlock((int)std::floor(p.x), (int)std::floor(p.y), (int)std::floor(p.z)));
+    }
+    ctx.check(spawned > 0 && drawn > 0 && std::isfinite(checksum), "debris spawned and packed into instances");
+    ctx.check(inside == 0, "no debris inside solid blocks (" + std::to_string(inside) + " inside)");
+
+    // Dopo la durata massima non resta niente
+    for (int frame = 0; frame < 180; frame++) particles.update(world, DELTA);
+    ctx.check(particles.count() == 0, "debris expires after its lifetime");
+}
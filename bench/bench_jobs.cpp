@@ -0,0 +1,49 @@
+#include "bench.h"
+
+#include <algorithm>
+#include <thread>
+
+#include "chunk_pipeline.h"
+#include "job_system.h"
+#include "terrain.h"
+#include "world.h"
+
+// ---------------------------------------------------------------
+// Job system: genera (terreno vero) e mesha un'area di 24x24 colonne di chunk con
+// 1, 2, 4... worker e misura quanto scala il throughput con i core.
+// Il thread principale fa la parte del render thread.
+// ---------------------------------------------------------------
+void benchJobScaling(BenchContext& ctx) {
+    const int AREA = 24;
+    int maxWorkers = std::max(1, (int)std::thread::hardware_concurrency());
+    double baseline = 0.0;
+
+    for (int workers = 1; workers <= maxWorkers; workers *= 2) {
+        World world;
+        JobSystem jobs(workers);
+        TerrainGenerator terrain(1337);
+        ChunkPipeline pipeline(jobs, world, [&terrain](const ChunkPos& pos, Chunk& chunk) {
+            terrain.generate(pos, chunk);
+        });
+
+        auto start = Clock::now();
+        for (int z = 0; z < AREA; z++)
+            for (int x = 0; x < AREA; x++)
+                for (int y = WORLD_MIN_CHUNK_Y; y <= WORLD_MAX_CHUNK_Y; y++)
+                    pipeline.requestChunk({ x, y, z });
+
+        int meshes = 0;
+        do {
+            pipeline.update(glm::vec3(0.0f), 1 << 30);
+            meshes += pipeline.consumeMeshes([](const ChunkPos&, const ChunkMesh&) {}, 1 << 30);
+            std::this_thread::yield();
+        } while (!pipeline.isIdle());
+        double seconds = secondsSince(start);
+
+        if (workers == 1) baseline = seconds;
+        std::string name = std::to_string(workers) + " workers";
+        ctx.throughput(name + " generate + mesh", world.chunkCount(), seconds, "chunks");
+        ctx.value(name + " speedup", baseline / seconds, "x");
+        ctx.value(name + " meshes", meshes, "meshes");
+    }
+}
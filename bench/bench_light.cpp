@@ -0,0 +1,247 @@
+#include "bench.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "block_registry.h"
+#include "light.h"
+#include "mesher.h"
+#include "terrain.h"
+
+// ---------------------------------------------------------------
+// Luce: un'area di terreno vero arriva chunk per chunk in ordine
+// casuale (come dallo streaming) e si illumina in modo incrementale;
+// poi centinaia di modifiche (scavi, blocchi, lampade) aggiornano la
+// luce con le code add/remove. Dopo ogni fase la luce deve essere
+// identica a quella di un flood fill rifatto da zero su tutta l'area.
+// Si misurano il costo per chunk, la latenza di ogni modifica (luce
+// e poi mesh dei chunk toccati) e quanti chunk ogni modifica rimesha;
+// poi migliaia di modifiche a gruppi, con la luce in batch; alla fine
+// un blocco trasparente che emette deve tenere la sua luce.
+// ---------------------------------------------------------------
+
+static const int AREA = 10; // colonne di chunk per lato
+static const int SIZE = AREA * CHUNK_SIZE;
+static const int HEIGHT = (WORLD_MAX_CHUNK_Y + 1) * CHUNK_SIZE;
+
+// Flood fill da zero su tutta l'area, senza niente di incrementale:
+// light[(y * SIZE + z) * SIZE + x] come in Chunk (cielo nei 4 bit alti)
+static std::vector<uint8_t> referenceLight(const World& world) {
+    std::vector<uint8_t> light((size_t)SIZE * SIZE * HEIGHT, 0);
+    std::vector<BlockID> blocks(light.size());
+    auto index = [](int x, int y, int z) { return ((size_t)y * SIZE + z) * SIZE + x; };
+    for (int y = 0; y < HEIGHT; y++)
+        for (int z = 0; z < SIZE; z++)
+            for (int x = 0; x < SIZE; x++) blocks[index(x, y, z)] = world.getBlock(x, y, z);
+
+    const int dirs[6][3] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+    for (int channel = 0; channel < 2; channel++) {
+        int shift = channel == 0 ? 4 : 0;
+        std::vector<glm::ivec3> queue;
+        for (int z = 0; z < SIZE; z++)
+            for (int x = 0; x < SIZE; x++)
+                for (int y = 0; y < HEIGHT; y++) {
+                    BlockID id = blocks[index(x, y, z)];
+                    int value = channel == 0 ? (y == HEIGHT - 1 && !isSolid(id) ? MAX_LIGHT : 0) : blockEmission(id);
+                    if (value == 0) continue;
+                    light[index(x, y, z)] |= (uint8_t)(value << shift);
+                    queue.push_back({ x, y, z });
+                }
+
+        for (size_t head = 0; head < queue.size(); head++) {
+            glm::ivec3 p = queue[head];
+            int value = (light[index(p.x, p.y, p.z)] >> shift) & 15;
+            for (int d = 0; d < 6; d++) {
+                glm::ivec3 n(p.x + dirs[d][0], p.y + dirs[d][1], p.z + dirs[d][2]);
+                if (n.x < 0 || n.y < 0 || n.z < 0 || n.x >= SIZE || n.y >= HEIGHT || n.z >= SIZE) continue;
+                if (isSolid(blocks[index(n.x, n.y, n.z)])) continue;
+                int next = (channel == 0 && d == 3 && value == MAX_LIGHT) ? MAX_LIGHT : value - 1;
+                uint8_t& cell = light[index(n.x, n.y, n.z)];
+                if (((cell >> shift) & 15) >= next) continue;
+                cell = (uint8_t)((cell & ~(15 << shift)) | next << shift);
+                queue.push_back(n);
+            }
+        }
+    }
+    return light;
+}
+
+static int lightErrors(const World& world) {
+    std::vector<uint8_t> expected = referenceLight(world);
+    int errors = 0;
+    for (int y = 0; y < HEIGHT; y++)
+        for (int z = 0; z < SIZE; z++)
+            for (int x = 0; x < SIZE; x++) {
+                const Chunk* chunk = world.getChunk(World::toChunkPos(x, y, z));
+                uint8_t actual = chunk->getLight(x & CHUNK_MASK, y & CHUNK_MASK, z & CHUNK_MASK);
+                errors += actual != expected[((size_t)y * SIZE + z) * SIZE + x];
+            }
+    return errors;
+}
+
+// Primo blocco pieno dall'alto nella colonna (-1 se non ce n'è)
+static int surfaceY(const World& world, int x, int z) {
+    for (int y = HEIGHT - 1; y >= 0; y--)
+        if (isSolid(world.getBlock(x, y, z))) return y;
+    return -1;
+}
+
+void benchLight(BenchContext& ctx) {
+    // 1) Chunk generati in parallelo al gioco: qui prima tutti, poi
+    //    inseriti in ordine casuale come arriverebbero dai worker
+    TerrainGenerator terrain(1337);
+    std::vector<std::pair<ChunkPos, std::unique_ptr<Chunk>>> generated;
+    for (int cz = 0; cz < AREA; cz++)
+        for (int cx = 0; cx < AREA; cx++)
+            for (int cy = WORLD_MIN_CHUNK_Y; cy <= WORLD_MAX_CHUNK_Y; cy++) {
+                auto chunk = std::make_unique<Chunk>();
+                terrain.generate({ cx, cy, cz }, *chunk);
+                generated.emplace_back(ChunkPos{ cx, cy, cz }, std::move(chunk));
+            }
+    uint32_t rng = 4242;
+    for (size_t i = generated.size() - 1; i > 0; i--) std::swap(generated[i], generated[xorshift(rng) % (i + 1)]);
+
+    World world;
+    LightEngine light(world);
+    std::vector<double> loadSamples;
+    long long loadVisited = 0;
+    auto start = Clock::now();
+    for (auto& [pos, chunk] : generated) {
+        auto chunkStart = Clock::now();
+        world.insertChunk(pos, std::move(chunk));
+        light.onChunkLoaded(pos);
+        loadSamples.push_back(secondsSince(chunkStart));
+        loadVisited += light.lastVisited();
+    }
+    ctx.throughput("chunks lit on load", (double)loadSamples.size(), secondsSince(start), "chunks");
+    ctx.latency("light per loaded chunk", std::move(loadSamples));
+    ctx.value("voxels visited per loaded chunk", (double)loadVisited / generated.size(), "voxels");
+
+    std::vector<ChunkPos> changed;
+    world.takeMeshDirtyChunks(changed);
+
+    int errors = lightErrors(world);
+    ctx.check(errors == 0, "streamed lighting matches a full flood fill (" + std::to_string(errors) + " voxels differ)");
+
+    // 2) Modifiche vicino alla superficie: scavi, blocchi piazzati e
+    //    lampade, anche sotto terra. Per ognuna: luce, poi mesh dei chunk
+    //    toccati (la copia 18³ + il meshing che farebbero i worker).
+    const int EDITS = 600;
+    std::vector<double> lightSamples, meshSamples;
+    std::vector<double> chunksPerEdit;
+    long long editVisited = 0;
+    int maxChunks = 0;
+    auto input = std::make_unique<MeshInput>();
+    ChunkMesh mesh;
+
+    for (int e = 0; e < EDITS; e++) {
+        int x = 8 + xorshift(rng) % (SIZE - 16), z = 8 + xorshift(rng) % (SIZE - 16);
+        int top = surfaceY(world, x, z);
+        if (top < 4 || top > HEIGHT - 6) continue;
+
+        int kind = xorshift(rng) % 10;
+        int y;
+        BlockID id;
+        if (kind < 4)      { y = top - (int)(xorshift(rng) % 4); id = BLOCK_AIR; }            // scavo
+        else if (kind < 7) { y = top + 1 + (int)(xorshift(rng) % 3); id = BLOCK_STONE; }      // blocco in aria
+        else if (kind < 9) { y = top - (int)(xorshift(rng) % 3); id = BLOCK_LAMP; }           // lampada nel terreno
+        else               { y = top + 1; id = BLOCK_LAMP; }                                  // lampada in superficie
+
+        auto editStart = Clock::now();
+        light.setBlock(x, y, z, id);
+        world.takeMeshDirtyChunks(changed);
+        lightSamples.push_back(secondsSince(editStart));
+        editVisited += light.lastVisited();
+
+        auto meshStart = Clock::now();
+        for (const ChunkPos& pos : changed) {
+            input->gather(world, pos);
+            buildChunkMesh(*input, mesh);
+        }
+        meshSamples.push_back(secondsSince(meshStart));
+        chunksPerEdit.push_back((double)changed.size());
+        maxChunks = std::max(maxChunks, (int)changed.size());
+    }
+
+    double averageChunks = 0.0;
+    for (double c : chunksPerEdit) averageChunks += c;
+    averageChunks /= std::max<size_t>(chunksPerEdit.size(), 1);
+
+    ctx.latency("light update per edit", std::move(lightSamples));
+    ctx.latency("remesh per edit", std::move(meshSamples));
+    ctx.value("voxels visited per edit", (double)editVisited / std::max<size_t>(chunksPerEdit.size(), 1), "voxels");
+    ctx.value("chunks remeshed per edit", averageChunks, "chunks");
+    ctx.value("chunks remeshed per edit (max)", maxChunks, "chunks");
+
+    errors = lightErrors(world);
+    ctx.check(errors == 0, "incremental lighting after edits matches a full flood fill (" + std::to_string(errors) + " voxels differ)");
+
+    // 3) Modifiche a migliaia: crateri e riempimenti con dentro qualche
+    //    lampada. Si alternano il batch (setBlocks, luce propagata una
+    //    volta) e le stesse modifiche una per una con setBlock.
+    const int BURSTS = 16;
+    double batchSeconds = 0.0, singleSeconds = 0.0;
+    long long batchEdits = 0, singleEdits = 0;
+    std::vector<BlockEdit> burst;
+    for (int b = 0; b < BURSTS; b++) {
+        int cx = 12 + xorshift(rng) % (SIZE - 24), cz = 12 + xorshift(rng) % (SIZE - 24);
+        int cy = surfaceY(world, cx, cz);
+        if (cy < 8 || cy > HEIGHT - 12) continue;
+
+        burst.clear();
+        bool crater = b % 4 < 2;
+        for (int dy = -5; dy <= 5; dy++)
+            for (int dz = -5; dz <= 5; dz++)
+                for (int dx = -5; dx <= 5; dx++) {
+                    if (crater && dx * dx + dy * dy + dz * dz > 25) continue;
+                    if (!crater && dy < 1) continue; // il riempimento sta sopra la superficie
+                    BlockID id = crater ? (BlockID)BLOCK_AIR : (BlockID)BLOCK_STONE;
+                    if (!crater && (dx + dy + dz) % 7 == 0) id = BLOCK_LAMP;
+                    burst.push_back({ cx + dx, cy + dy, cz + dz, id });
+                }
+
+        auto burstStart = Clock::now();
+        if (b % 2 == 0) {
+            light.setBlocks(burst.data(), burst.size());
+            batchSeconds += secondsSince(burstStart);
+            batchEdits += (long long)burst.size();
+        } else {
+            for (const BlockEdit& edit : burst) light.setBlock(edit.x, edit.y, edit.z, edit.id);
+            singleSeconds += secondsSince(burstStart);
+            singleEdits += (long long)burst.size();
+        }
+    }
+    world.takeMeshDirtyChunks(changed);
+    ctx.throughput("burst edits, batched light", (double)batchEdits, batchSeconds, "edits");
+    ctx.throughput("burst edits, light per edit", (double)singleEdits, singleSeconds, "edits");
+
+    errors = lightErrors(world);
+    ctx.check(errors == 0, "batched lighting after bursts matches a full flood fill (" + std::to_string(errors) + " voxels differ)");
+    ctx.value("world memory with light", (double)world.memoryUsage() / (1024.0 * 1024.0), "MB");
+
+    // 4) Un blocco non opaco che emette 10, acceso a 14 dalla lava
+    //    accanto: tolta la lava deve tornare a 10, non spegnersi
+    BlockDefinition crystalDefinition;
+    crystalDefinition.name     = "bench crystal";
+    crystalDefinition.opaque   = false;
+    crystalDefinition.emission = 10;
+    BlockID crystal = registerBlock(crystalDefinition);
+    World small;
+    for (int cy = WORLD_MIN_CHUNK_Y; cy <= WORLD_MAX_CHUNK_Y; cy++) small.getOrCreateChunk({ 0, cy, 0 });
+    LightEngine smallLight(small);
+    for (int cy = WORLD_MAX_CHUNK_Y; cy >= WORLD_MIN_CHUNK_Y; cy--) smallLight.onChunkLoaded({ 0, cy, 0 });
+    auto blockLight = [&small](int x, int y, int z) {
+        return small.findChunk(World::toChunkPos(x, y, z))->getLight(x & CHUNK_MASK, y & CHUNK_MASK, z & CHUNK_MASK) & 15;
+    };
+    smallLight.setBlock(5, 8, 5, crystal);
+    smallLight.setBlock(6, 8, 5, BLOCK_LAVA);
+    int lit = blockLight(5, 8, 5);
+    smallLight.setBlock(6, 8, 5, BLOCK_AIR);
+    int own = blockLight(5, 8, 5), beside = blockLight(6, 8, 5);
+    resetBlockRegistry();
+    ctx.check(lit == MAX_LIGHT - 1 && own == 10 && beside == 9,
+              "a transparent emitter keeps its own light when a brighter neighbour goes away");
+}
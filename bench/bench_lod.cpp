@@ -0,0 +1,252 @@
+#include "bench.h"
+
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <unordered_set>
+
+#include "job_system.h"
+#include "lod.h"
+#include "mesher.h"
+#include "terrain.h"
+
+// ---------------------------------------------------------------
+// LOD: la selezione deve coprire ogni colonna con un solo livello,
+// il LodManager non deve lasciare buchi né sovrapporre nodi mentre la
+// camera si sposta. Poi i tempi: selezione, generazione + meshing di un
+// nodo per livello, e i triangoli dei LOD contro quelli che servirebbero
+// a piena risoluzione sulla stessa distanza.
+// ---------------------------------------------------------------
+
+// Colonne di chunk coperte da più livelli (o da nessuno, dentro l'ultimo)
+static int coverageErrors(const LodSelection& selection) {
+    int levels = selection.levels();
+    glm::ivec2 min = selection.regionMin(levels) << levels;
+    glm::ivec2 max = selection.regionMax(levels) << levels;
+
+    int errors = 0;
+    for (int z = min.y - 4; z < max.y + 4; z++)
+        for (int x = min.x - 4; x < max.x + 4; x++) {
+            int count = selection.isDetail(x, z) ? 1 : 0;
+            for (int level = 1; level <= levels; level++)
+                if (selection.isSelected(level, x >> level, z >> level)) count++;
+            bool inside = x >= min.x && x < max.x && z >= min.y && z < max.y;
+            if (count != (inside ? 1 : 0)) errors++;
+        }
+    return errors;
+}
+
+static void checkSelection(BenchContext& ctx) {
+    LodSettings settings;
+    const glm::vec3 cameras[] = {
+        { 0.5f, 80.0f, 0.5f }, { -1.0f, 80.0f, -1.0f }, { 1234.5f, 60.0f, -987.25f },
+        { -40000.0f, 100.0f, 25000.0f }, { 31.9f, 80.0f, 32.1f },
+    };
+    int errors = 0;
+    for (const glm::vec3& camera : cameras) errors += coverageErrors(LodSelection(settings, camera));
+    ctx.check(errors == 0, "every column covered by exactly one LOD level (" + std::to_string(errors) + " errors)");
+
+    bool tall = true;
+    for (int level = 1; level <= settings.levels; level++)
+        tall = tall && lodColumnNodes(level) * lodNodeSize(level) >= (WORLD_MAX_CHUNK_Y + 1) * CHUNK_SIZE;
+    ctx.check(tall, "LOD columns cover the world height");
+
+    // Ogni lato con la parete deve dare su un altro livello, ogni lato
+    // senza su un nodo dello stesso
+    LodSelection selection(settings, cameras[2]);
+    std::vector<LodNode> nodes;
+    selection.nodes(nodes);
+    int wrongSeams = 0;
+    for (const LodNode& node : nodes) {
+        const int dx[4] = { 1, -1, 0, 0 }, dz[4] = { 0, 0, 1, -1 };
+        uint8_t seams = selection.seams(node);
+        for (int side = 0; side < 4; side++) {
+            bool sameLevel = selection.isSelected(node.level, node.pos.x + dx[side], node.pos.z + dz[side]);
+            if (sameLevel == ((seams >> side) & 1)) wrongSeams++;
+        }
+    }
+    ctx.check(wrongSeams == 0, "LOD seams only toward other levels");
+
+    // Budget fisso: lo stesso numero di nodi per anello a qualsiasi distanza
+    int ring = 0;
+    for (int level = 1; level <= settings.levels; level++) ring += 3 * settings.radius * settings.radius * lodColumnNodes(level);
+    ctx.check((int)nodes.size() == ring, "LOD node count matches the ring layout");
+    ctx.value("nodes", (double)nodes.size(), "nodes");
+    ctx.value("view distance", selection.viewDistance(), "blocks");
+
+    std::vector<double> samples;
+    for (int i = 0; i < 200; i++) {
+        auto start = Clock::now();
+        LodSelection moved(settings, glm::vec3(i * 16.0f, 80.0f, i * 7.0f));
+        moved.nodes(nodes);
+        samples.push_back(secondsSince(start));
+    }
+    ctx.latency("selection", samples);
+}
+
+// ---------------------------------------------------------------
+// LodManager senza finestra: si arriva a regime, poi la camera salta
+// di qualche nodo e ad ogni "frame" si controlla che ogni colonna
+// resti coperta (da un nodo o da chunk meshati) e che i nodi disegnati
+// non si sovrappongano. I chunk del livello 0 arrivano in ritardo.
+// ---------------------------------------------------------------
+static void checkManager(BenchContext& ctx) {
+    LodSettings settings;
+    settings.levels = 3;
+    settings.radius = 4;
+
+    JobSystem        jobs;
+    TerrainGenerator terrain(1337);
+    LodManager       lod(jobs, terrain, settings);
+
+    std::unordered_set<LodNode, LodNodeHash> uploaded;
+    std::vector<LodNode> removed, drawn;
+    bool uploadErrors = false;
+
+    // Frustum che contiene tutto: cull() restituisce tutti i nodi disegnabili
+    Frustum everything;
+    for (glm::vec4& plane : everything.planes) plane = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+
+    int  frame = 0, meshedFrom = 0;
+    auto chunkMeshed = [&](const ChunkPos&) { return frame >= meshedFrom; };
+
+    auto step = [&](const glm::vec3& camera) {
+        lod.update(camera, chunkMeshed);
+        lod.consumeMeshes([&](const LodNode& node, const ChunkMesh& mesh) {
+            if (mesh.empty()) uploaded.erase(node);
+            else uploaded.insert(node);
+        }, 64);
+        lod.takeRemoved(removed);
+        for (const LodNode& node : removed) uploadErrors |= uploaded.erase(node) == 0;
+        frame++;
+    };
+
+    glm::vec3 start(8.0f, 90.0f, 8.0f);
+    auto warmup = Clock::now();
+    do {
+        step(start);
+        std::this_thread::yield();
+    } while (!lod.isIdle());
+    ctx.value("warm-up", secondsSince(warmup) * 1e3, "ms");
+
+    LodStats stats = lod.stats();
+    ctx.check(stats.shownNodes == stats.desiredNodes && stats.staleNodes == 0, "all selected LOD nodes shown after warm-up");
+    ctx.check((int)uploaded.size() == stats.drawable, "uploaded LOD meshes match drawable nodes");
+
+    LodSelection before = lod.selection();
+    glm::vec3 target = start + glm::vec3(3.0f * lodNodeSize(2), 0.0f, -1.0f * lodNodeSize(2));
+    LodSelection after(settings, target);
+
+    // Colonne dentro entrambe le selezioni: devono restare coperte
+    int levels = settings.levels;
+    glm::ivec2 min = glm::max(before.regionMin(levels), after.regionMin(levels)) << levels;
+    glm::ivec2 max = glm::min(before.regionMax(levels), after.regionMax(levels)) << levels;
+
+    int holes = 0, overlaps = 0, frames = 0, maxStale = 0;
+    std::vector<uint8_t> cells;
+    meshedFrom = frame + 30;
+    do {
+        step(target);
+        frames++;
+        maxStale = std::max(maxStale, lod.stats().staleNodes);
+
+        for (int z = min.y; z < max.y; z++)
+            for (int x = min.x; x < max.x; x++)
+                for (int y = WORLD_MIN_CHUNK_Y; y <= WORLD_MAX_CHUNK_Y; y++) {
+                    ChunkPos pos = { x, y, z };
+                    // I chunk del vecchio livello 0 restano sulla GPU e si
+                    // disegnano finché un nodo non li copre
+                    bool chunk = (after.isDetail(x, z) && chunkMeshed(pos)) || before.isDetail(x, z);
+                    if (!lod.covers(pos) && !chunk) holes++;
+                }
+
+        // Ogni nodo disegnato segna le sue celle da un chunk
+        lod.cull(everything, drawn);
+        glm::ivec2 outerMin = glm::min(before.regionMin(levels), after.regionMin(levels)) << levels;
+        glm::ivec2 outerMax = glm::max(before.regionMax(levels), after.regionMax(levels)) << levels;
+        int width = outerMax.x - outerMin.x, depth = outerMax.y - outerMin.y, height = WORLD_MAX_CHUNK_Y + 1;
+        cells.assign((size_t)width * depth * height, 0);
+        for (const LodNode& node : drawn) {
+            int n = 1 << node.level;
+            for (int z = node.pos.z * n; z < (node.pos.z + 1) * n; z++)
+                for (int x = node.pos.x * n; x < (node.pos.x + 1) * n; x++)
+                    for (int y = node.pos.y * n; y < std::min((node.pos.y + 1) * n, height); y++) {
+                        uint8_t& cell = cells[((size_t)(z - outerMin.y) * width + (x - outerMin.x)) * height + y];
+                        if (cell++) overlaps++;
+                    }
+        }
+        std::this_thread::yield();
+    } while (!lod.isIdle() || frame < meshedFrom);
+
+    ctx.check(holes == 0, "no LOD holes while moving (" + std::to_string(holes) + " missing cells)");
+    ctx.check(overlaps == 0, "no overlapping LOD nodes while moving (" + std::to_string(overlaps) + " cells)");
+    ctx.check(!uploadErrors, "removed LOD nodes were uploaded");
+
+    stats = lod.stats();
+    ctx.check(stats.shownNodes == stats.desiredNodes && stats.staleNodes == 0, "all selected LOD nodes shown after moving");
+    ctx.check((int)uploaded.size() == stats.drawable, "uploaded LOD meshes match drawable nodes after moving");
+    ctx.check(maxStale > 0, "the move left stale LOD nodes to replace");
+    ctx.value("transition frames", frames, "frames");
+    ctx.value("max stale nodes", maxStale, "nodes");
+}
+
+// ---------------------------------------------------------------
+// Costo per livello e budget: un nodo costa come un chunk a qualsiasi
+// livello, e i triangoli dei LOD sono una frazione di quelli che
+// servirebbero disegnando tutto a piena risoluzione.
+// ---------------------------------------------------------------
+static void benchLevels(BenchContext& ctx) {
+    LodSettings settings;
+    TerrainGenerator terrain(1337);
+    LodSelection selection(settings, glm::vec3(8.0f, 90.0f, 8.0f));
+
+    auto input = std::make_unique<MeshInput>();
+    ChunkMesh mesh;
+    const int SAMPLES = 48;
+    double detailTriangles = 0.0;
+    double lodTriangles    = 0.0;
+
+    for (int level = 0; level <= settings.levels; level++) {
+        std::vector<double> samples;
+        double triangles = 0.0;
+        for (int i = 0; i < SAMPLES; i++) {
+            // Colonne di nodi sparse, tutte le altezze (lo 0 ha solo chunk)
+            LodNode node = { { (i * 7) % 23 - 11, i % lodColumnNodes(level), (i * 5) % 19 - 9 }, level };
+            auto start = Clock::now();
+            generateLodInput(terrain, node, 0, *input);
+            buildChunkMesh(*input, mesh);
+            samples.push_back(secondsSince(start));
+            triangles += mesh.triangleCount();
+        }
+        std::string name = level == 0 ? "chunk" : "level " + std::to_string(level);
+        ctx.latency(name + " generate + mesh", samples);
+
+        // Triangoli medi per colonna di nodi al livello, per tutte le colonne
+        double perColumn = triangles / SAMPLES * lodColumnNodes(level);
+        int columns = 0;
+        glm::ivec2 min = selection.regionMin(level), max = selection.regionMax(level);
+        for (int z = min.y; z < max.y; z++)
+            for (int x = min.x; x < max.x; x++)
+                if (level == 0 ? selection.isDetail(x, z) : selection.isSelected(level, x, z)) columns++;
+
+        if (level == 0) detailTriangles = perColumn;
+        else lodTriangles += perColumn * columns;
+    }
+
+    // A piena risoluzione ogni colonna di chunk costerebbe come quelle del livello 0
+    int levels = settings.levels;
+    glm::ivec2 outer = (selection.regionMax(levels) - selection.regionMin(levels)) << levels;
+    glm::ivec2 detail = selection.regionMax(0) - selection.regionMin(0);
+    double fullTriangles = detailTriangles * ((double)outer.x * outer.y - (double)detail.x * detail.y);
+
+    ctx.value("LOD triangles", lodTriangles, "triangles");
+    ctx.value("full-res triangles (estimate)", fullTriangles, "triangles");
+    ctx.value("LOD reduction", fullTriangles / std::max(lodTriangles, 1.0), "x");
+    ctx.value("LOD mesh memory", lodTriangles * 2.0 * sizeof(PackedVertex) + lodTriangles * 3.0 * sizeof(uint16_t), "bytes");
+}
+
+void benchLod(BenchContext& ctx) {
+    checkSelection(ctx);
+    checkManager(ctx);
+    benchLevels(ctx);
+}
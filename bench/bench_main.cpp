@@ -0,0 +1,171 @@
+// ---------------------------------------------------------------
+// voxel_bench
+//   voxel_bench                   esegue tutti gli scenari
+//   voxel_bench culling storage   solo quelli nominati
+//   voxel_bench --list            elenca gli scenari
+//   voxel_bench --json out.json   scrive anche i risultati in JSON
+//
+// Il codice di uscita è 1 se un controllo di correttezza fallisce:
+// un backend SIMD che non coincide con lo scalare, un vertice che non
+// torna uguale, un allocatore che sovrappone le mesh, un culling
+// sbagliato o un chunk che non sopravvive al salvataggio sono bug,
+// e uno script (o la CI) se ne deve accorgere.
+// ---------------------------------------------------------------
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench.h"
+#include "noise.h"
+
+struct Scenario {
+    const char* name;
+    const char* description;
+    void (*run)(BenchContext&);
+};
+
+static const Scenario SCENARIOS[] = {
+    { "block_access",     "world get/set, sequential and random",     benchBlockAccess },
+    { "meshing",          "greedy vs culled meshing, per-chunk time",  benchMeshing },
+    { "vertex_format",    "packed vertex round trip and size",         benchVertexFormat },
+    { "buffer_allocator", "mesh buffer sub-allocation",                benchBufferAllocator },
+    { "noise",            "SIMD noise backends vs scalar",             benchNoise },
+    { "generation",       "terrain generation per backend",            benchGeneration },
+    { "culling",          "frustum and cave culling",                  benchCulling },
+    { "storage",          "chunk serialization and region files",      benchStorage },
+    { "job_scaling",      "generate + mesh with 1..N workers",         benchJobScaling },
+    { "flythrough",       "scripted camera flight over streamed terrain", benchFlythrough },
+    { "profiler",         "zone overhead and capture round trip",      benchProfiler },
+    { "lod",              "LOD selection, transitions and budget",     benchLod },
+    { "raycast",          "DDA raycast, batches and AABB collision",   benchRaycast },
+    { "light",            "flood-fill lighting on load and per edit",  benchLight },
+    { "edit_burst",       "bursts of thousands of edits, coalesced remeshing", benchEditBurst },
+    { "instancing",       "block texture array, particles as instances", benchInstancing },
+    { "streaming",        "fast fly-out and back with memory budgets",  benchStreaming },
+    { "simulation",       "fixed-tick simulation: replay and threaded",  benchSimulation },
+    { "memory",           "arenas and pools: zero-allocation frames",    benchMemory },
+    { "entities",         "ECS mobs: tick throughput, serial vs parallel", benchEntities },
+    { "server",           "loopback server with bots: bandwidth and tick", benchServer },
+    { "fluids",           "fluid and falling-block updates: 1M-cell flood, scaling", benchFluids },
+    { "startup",          "program binary cache, asset loading, time to playable", benchStartup },
+    { "blocks",           "property tables vs polymorphic lookups, runtime block types", benchBlocks },
+    { "input_replay",     "recorded input: file size, deterministic headless replay", benchInputReplay },
+};
+
+struct ScenarioResult {
+    const Scenario* scenario;
+    BenchContext    context;
+    double          seconds = 0.0;
+};
+
+// Le stringhe che scriviamo sono nostre (nomi e messaggi ASCII), ma
+// virgolette e backslash vanno comunque protetti
+static std::string jsonString(const std::string& text) {
+    std::string out = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out + "\"";
+}
+
+static bool writeJson(const std::string& path, const std::vector<ScenarioResult>& results) {
+    std::ofstream file(path);
+    if (!file) {
+        std::fprintf(stderr, "cannot write %s\n", path.c_str());
+        return false;
+    }
+
+    file.precision(9);
+    file << "{\n";
+    file << "  \"compiler\": " << jsonString(__VERSION__) << ",\n";
+    file << "  \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n";
+    file << "  \"noise_backend\": " << jsonString(noiseBackendName(detectBestNoiseBackend())) << ",\n";
+    file << "  \"scenarios\": [";
+    for (size_t s = 0; s < results.size(); s++) {
+        const ScenarioResult& result = results[s];
+        file << (s ? ",\n" : "\n");
+        file << "    {\n";
+        file << "      \"name\": " << jsonString(result.scenario->name) << ",\n";
+        file << "      \"ok\": " << (result.context.failed() ? "false" : "true") << ",\n";
+        file << "      \"seconds\": " << result.seconds << ",\n";
+        file << "      \"failures\": [";
+        for (size_t i = 0; i < result.context.failedChecks().size(); i++)
+            file << (i ? ", " : "") << jsonString(result.context.failedChecks()[i]);
+        file << "],\n";
+        file << "      \"metrics\": [";
+        const auto& metrics = result.context.results();
+        for (size_t m = 0; m < metrics.size(); m++) {
+            const BenchContext::Metric& metric = metrics[m];
+            file << (m ? ",\n" : "\n");
+            file << "        { \"name\": " << jsonString(metric.name)
+                 << ", \"kind\": " << jsonString(metric.kind)
+                 << ", \"unit\": " << jsonString(metric.unit);
+            if (metric.kind == "latency") {
+                file << ", \"mean\": " << metric.value << ", \"p50\": " << metric.p50
+                     << ", \"p99\": " << metric.p99 << ", \"max\": " << metric.max
+                     << ", \"samples\": " << metric.samples;
+            } else {
+                file << ", \"value\": " << metric.value;
+            }
+            file << " }";
+        }
+        file << "\n      ]\n    }";
+    }
+    file << "\n  ]\n}\n";
+    return true;
+}
+
+int main(int argc, char** argv) {
+    std::string jsonPath;
+    std::vector<std::string> selected;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--list") == 0) {
+            for (const Scenario& scenario : SCENARIOS)
+                std::printf("%-18s %s\n", scenario.name, scenario.description);
+            return 0;
+        } else if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            jsonPath = argv[++i];
+        } else if (argv[i][0] == '-') {
+            std::fprintf(stderr, "usage: %s [--list] [--json file] [scenario...]\n", argv[0]);
+            return 2;
+        } else {
+            selected.push_back(argv[i]);
+        }
+    }
+
+    // Un nome sbagliato è un errore: meglio che un confronto vuoto
+    for (const std::string& name : selected) {
+        bool found = false;
+        for (const Scenario& scenario : SCENARIOS) found = found || name == scenario.name;
+        if (!found) {
+            std::fprintf(stderr, "unknown scenario '%s' (see --list)\n", name.c_str());
+            return 2;
+        }
+    }
+
+    std::vector<ScenarioResult> results;
+    results.reserve(std::size(SCENARIOS));
+    bool ok = true;
+    for (const Scenario& scenario : SCENARIOS) {
+        bool wanted = selected.empty();
+        for (const std::string& name : selected) wanted = wanted || name == scenario.name;
+        if (!wanted) continue;
+
+        std::printf("== %s ==\n", scenario.name);
+        ScenarioResult& result = results.emplace_back();
+        result.scenario = &scenario;
+        auto start = Clock::now();
+        scenario.run(result.context);
+        result.seconds = secondsSince(start);
+        ok = ok && !result.context.failed();
+        std::printf("\n");
+    }
+
+    if (!jsonPath.empty() && !writeJson(jsonPath, results)) return 2;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,324 @@
+#include "bench.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+#include "chunk_streamer.h"
+#include "culling.h"
+#include "job_system.h"
+#include "light.h"
+#include "lod.h"
+#include "memory.h"
+#include "profiler.h"
+#include "simulation.h"
+#include "terrain.h"
+
+// ---------------------------------------------------------------
+// Allocatore globale contato. voxel_bench sostituisce operator new e
+// delete: ogni richiesta all'heap, da qualsiasi thread e da qualsiasi
+// libreria, passa di qui. Contano solo quando counting è acceso, così
+// gli altri scenari non pagano quasi niente.
+// ---------------------------------------------------------------
+namespace {
+
+std::atomic<bool>      counting{ false };
+std::atomic<long long> heapAllocations{ 0 };
+thread_local long long threadAllocations = 0; // del thread chiamante
+
+void* countedAllocate(size_t size, size_t alignment) {
+    if (counting.load(std::memory_order_relaxed)) {
+        heapAllocations.fetch_add(1, std::memory_order_relaxed);
+        threadAllocations++;
+    }
+    if (size == 0) size = 1;
+    void* p;
+    if (alignment <= alignof(std::max_align_t)) p = std::malloc(size);
+#ifdef _WIN32
+    // MSVC non ha std::aligned_alloc: la sua coppia è _aligned_malloc/_aligned_free
+    else p = _aligned_malloc(size, alignment);
+#else
+    else p = std::aligned_alloc(alignment, (size + alignment - 1) & ~(alignment - 1));
+#endif
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+// Il delete che corrisponde a countedAllocate con lo stesso allineamento
+void countedFree(void* p, [[maybe_unused]] size_t alignment) {
+#ifdef _WIN32
+    if (alignment > alignof(std::max_align_t)) {
+        _aligned_free(p);
+        return;
+    }
+#endif
+    std::free(p);
+}
+
+} // namespace
+
+void* operator new(size_t size) { return countedAllocate(size, alignof(std::max_align_t)); }
+void* operator new[](size_t size) { return countedAllocate(size, alignof(std::max_align_t)); }
+void* operator new(size_t size, std::align_val_t alignment) { return countedAllocate(size, (size_t)alignment); }
+void* operator new[](size_t size, std::align_val_t alignment) { return countedAllocate(size, (size_t)alignment); }
+void  operator delete(void* p) noexcept { std::free(p); }
+void  operator delete[](void* p) noexcept { std::free(p); }
+void  operator delete(void* p, size_t) noexcept { std::free(p); }
+void  operator delete[](void* p, size_t) noexcept { std::free(p); }
+void  operator delete(void* p, std::align_val_t alignment) noexcept { countedFree(p, (size_t)alignment); }
+void  operator delete[](void* p, std::align_val_t alignment) noexcept { countedFree(p, (size_t)alignment); }
+void  operator delete(void* p, size_t, std::align_val_t alignment) noexcept { countedFree(p, (size_t)alignment); }
+void  operator delete[](void* p, size_t, std::align_val_t alignment) noexcept { countedFree(p, (size_t)alignment); }
+
+namespace {
+
+// Quante allocazioni fa fn: tutti i thread e solo quello chiamante
+struct AllocationCount {
+    long long total  = 0;
+    long long caller = 0;
+};
+
+template <typename Fn>
+AllocationCount countAllocations(Fn&& fn) {
+    long long totalBefore  = heapAllocations.load(std::memory_order_relaxed);
+    long long callerBefore = threadAllocations;
+    counting.store(true, std::memory_order_relaxed);
+    fn();
+    counting.store(false, std::memory_order_relaxed);
+    return { heapAllocations.load(std::memory_order_relaxed) - totalBefore, threadAllocations - callerBefore };
+}
+
+} // namespace
+
+// ---------------------------------------------------------------
+// Frame a regime. Il game loop senza finestra: mondo generato e
+// meshato, LOD attorno, simulazione sul suo thread; la camera resta
+// ferma e si gira su se stessa (culling, interpolazione e streaming
+// lavorano ad ogni frame, ma niente di nuovo da generare). Dopo il
+// riscaldamento (vector e arene arrivano alla loro capacità, lo
+// storico del profiler si riempie) un frame non deve più chiedere
+// niente all'heap, su nessun thread.
+//
+// Poi a parte: quanto costa all'heap rimeshare un chunk (i job
+// allocano ancora la loro coda), arena contro heap per i temporanei
+// e FixedPool contro new per blocchi grandi come un Chunk.
+// ---------------------------------------------------------------
+static const int MEMORY_RADIUS        = 4;   // colonne attorno alla camera
+static const int MEMORY_WARMUP_FRAMES = 2 * Profiler::HISTORY_FRAMES + 60;
+static const int MEMORY_FRAMES        = 600;
+
+static void benchSteadyFrame(BenchContext& ctx) {
+    World world;
+    JobSystem jobs;
+    TerrainGenerator terrain(1337);
+    ChunkPipeline pipeline(jobs, world, [&terrain](const ChunkPos& pos, Chunk& chunk) {
+        terrain.generate(pos, chunk);
+    });
+    LightEngine light(world);
+    pipeline.setInsertedCallback([&light](const ChunkPos& pos) { light.onChunkLoaded(pos); });
+    ChunkStreamer streamer(world, pipeline);
+    ChunkCuller culler;
+
+    LodSettings lodSettings;
+    lodSettings.levels = 2;
+    lodSettings.radius = 3;
+    LodManager lod(jobs, terrain, lodSettings);
+
+    glm::vec3 eye(8.5f, (float)std::max(terrain.surfaceHeight(8, 8), TerrainGenerator::SEA_LEVEL) + 3.0f, 8.5f);
+    std::mutex worldMutex;
+    Simulation simulation(world, light, eye);
+
+    std::vector<ChunkPos> visibleChunks, staleMeshes, evictedMeshes;
+    std::vector<LodNode> visibleLodNodes, removedLodNodes;
+    std::vector<InstanceData> instances;
+    ColumnRegion region = { glm::ivec2(-MEMORY_RADIUS), glm::ivec2(MEMORY_RADIUS) };
+    auto chunkMeshed = [&pipeline](const ChunkPos& pos) { return pipeline.isMeshed(pos); };
+
+    // Quello che fa il game loop, senza OpenGL (vedi main.cpp)
+    auto frame = [&](const glm::vec3& camera, const glm::vec3& front) {
+        PROFILE_FRAME();
+        frameArena().reset();
+        lod.update(camera, chunkMeshed);
+        if (std::unique_lock worldLock{ worldMutex, std::try_to_lock }) {
+            streamer.update(camera, 1.0f / 60.0f, region);
+            world.takeMeshDirtyChunks(staleMeshes);
+            for (const ChunkPos& pos : staleMeshes) pipeline.requestMesh(pos);
+        }
+        streamer.uploadMeshes([&](const ChunkPos& pos, const ChunkMesh& mesh) {
+            culler.setChunk(pos, mesh.visibility, !mesh.empty());
+        }, 64);
+        streamer.takeEvictedMeshes(evictedMeshes);
+        for (const ChunkPos& pos : evictedMeshes) culler.removeChunk(pos);
+        lod.consumeMeshes([](const LodNode&, const ChunkMesh&) {}, 64);
+        lod.takeRemoved(removedLodNodes);
+
+        glm::mat4 projection = glm::perspective(glm::radians(70.0f), 16.0f / 9.0f, 0.1f, 400.0f);
+        glm::mat4 view = glm::lookAt(camera, camera + front, glm::vec3(0.0f, 1.0f, 0.0f));
+        Frustum frustum = Frustum::fromMatrix(projection * view);
+        culler.cull(frustum, camera, MEMORY_RADIUS + 2, visibleChunks);
+        std::erase_if(visibleChunks, [&lod](const ChunkPos& pos) { return lod.covers(pos); });
+        streamer.touch(visibleChunks);
+        lod.cull(frustum, visibleLodNodes);
+    };
+
+    // Fino a regime: tutto generato, meshato e caricato
+    glm::vec3 front(1.0f, -0.2f, 0.0f);
+    do {
+        frame(eye, front);
+        std::this_thread::yield();
+    } while (!pipeline.isIdle() || !lod.isIdle());
+
+    SimulationThread thread(simulation, worldMutex);
+    PlayerInput input;
+    int frameIndex = 0;
+    auto spinFrame = [&] {
+        // Un giro completo ogni 240 frame: gli stessi frame si ripetono
+        input.yaw = (float)(frameIndex++ % 240) * 1.5f;
+        input.pitch = -20.0f;
+        thread.submit(input);
+        glm::vec3 camera = eye;
+        if (const SimSnapshot* snapshot = thread.latest()) {
+            float alpha = thread.alpha(*snapshot, Clock::now());
+            camera = snapshot->eyeAt(alpha);
+            snapshot->interpolateInstances(alpha, instances);
+        }
+        float yaw = glm::radians(input.yaw), pitch = glm::radians(input.pitch);
+        frame(camera, glm::vec3(std::cos(yaw) * std::cos(pitch), std::sin(pitch), std::sin(yaw) * std::cos(pitch)));
+    };
+
+    for (int i = 0; i < MEMORY_WARMUP_FRAMES; i++) spinFrame();
+
+    std::vector<double> frameTimes;
+    frameTimes.reserve(MEMORY_FRAMES);
+    long long ticksBefore = thread.stats().ticks;
+    AllocationCount steady = countAllocations([&] {
+        for (int i = 0; i < MEMORY_FRAMES; i++) {
+            auto start = Clock::now();
+            spinFrame();
+            frameTimes.push_back(secondsSince(start));
+            std::this_thread::sleep_for(std::chrono::milliseconds(2)); // lascia girare i tick
+        }
+    });
+    long long ticks = thread.stats().ticks - ticksBefore;
+    thread.stop();
+
+    ctx.latency("steady frame (LOD, streaming, cull, interpolation)", std::move(frameTimes));
+    ctx.value("heap allocations per steady frame (all threads)", (double)steady.total / MEMORY_FRAMES, "allocs");
+    ctx.value("simulation ticks while measuring", (double)ticks, "ticks");
+    ctx.check(ticks > 0, "the simulation ticks while the frames are measured");
+    ctx.check(steady.caller == 0, "no heap allocations on the render thread in steady state (" + std::to_string(steady.caller) + ")");
+    ctx.check(steady.total == 0, "no heap allocations on any thread in steady state (" + std::to_string(steady.total) + ")");
+
+    // Rimeshare dei chunk già caricati: il mesher usa pool e arene, ma
+    // lanciare un job alloca ancora (la sua std::function e la coda)
+    std::vector<ChunkPos> remesh;
+    for (int z = -2; z < 2; z++)
+        for (int x = -2; x < 2; x++)
+            for (int y = 2; y < 6; y++) remesh.push_back({ x, y, z });
+    MemoryStats meshesBefore = memoryStats();
+    AllocationCount remeshing = countAllocations([&] {
+        for (const ChunkPos& pos : remesh) pipeline.requestMesh(pos);
+        do {
+            frame(eye, front);
+            std::this_thread::yield();
+        } while (!pipeline.isIdle());
+    });
+    MemoryStats meshesAfter = memoryStats();
+    long long poolMisses = meshesAfter[MemoryTag::Meshes].heapAllocations - meshesBefore[MemoryTag::Meshes].heapAllocations;
+    ctx.value("heap allocations per remeshed chunk", (double)remeshing.total / (double)remesh.size(), "allocs");
+    ctx.value("new mesh objects per remeshed chunk", (double)poolMisses / (double)remesh.size(), "objects");
+}
+
+// ---------------------------------------------------------------
+// Temporanei: 64 vector da 1..256 interi per "frame", come le liste
+// che un sistema si costruisce e butta. Dall'arena sono uno spostamento
+// di puntatore e un reset; dall'heap una malloc e una free ciascuno.
+// ---------------------------------------------------------------
+static void benchArena(BenchContext& ctx) {
+    const int FRAMES = 20000, LISTS = 64;
+    LinearArena arena(1u << 20, MemoryTag::Scratch);
+    long long checksum = 0;
+
+    auto start = Clock::now();
+    for (int f = 0; f < FRAMES; f++) {
+        arena.reset();
+        uint32_t rng = 0x9E3779B9u + f;
+        for (int l = 0; l < LISTS; l++) {
+            ArenaVector<int> list(arena);
+            list.resize(1 + xorshift(rng) % 256, l);
+            checksum += list.back();
+        }
+    }
+    double arenaSeconds = secondsSince(start);
+
+    start = Clock::now();
+    for (int f = 0; f < FRAMES; f++) {
+        uint32_t rng = 0x9E3779B9u + f;
+        for (int l = 0; l < LISTS; l++) {
+            std::vector<int> list;
+            list.resize(1 + xorshift(rng) % 256, l);
+            checksum -= list.back();
+        }
+    }
+    double heapSeconds = secondsSince(start);
+
+    ctx.throughput("temporary lists from the frame arena", (double)FRAMES * LISTS, arenaSeconds);
+    ctx.throughput("temporary lists from the heap", (double)FRAMES * LISTS, heapSeconds);
+    ctx.value("arena speedup", heapSeconds / arenaSeconds, "x");
+    ctx.check(checksum == 0, "arena and heap lists hold the same data");
+}
+
+// ---------------------------------------------------------------
+// Blocchi grandi come un Chunk, presi e resi in ordine sparso (come
+// lo streaming carica e scarica colonne): FixedPool contro new.
+// ---------------------------------------------------------------
+static void benchChunkPool(BenchContext& ctx) {
+    const int LIVE = 4096, ROUNDS = 200;
+    FixedPool pool(sizeof(Chunk), MemoryTag::Chunks);
+    std::vector<void*> live(LIVE, nullptr);
+
+    auto churn = [&](auto allocate, auto release) {
+        uint32_t rng = 12345;
+        for (void*& p : live) p = allocate();
+        auto start = Clock::now();
+        for (int r = 0; r < ROUNDS; r++)
+            for (int i = 0; i < LIVE / 4; i++) {
+                void*& p = live[xorshift(rng) % LIVE];
+                release(p);
+                p = allocate();
+            }
+        double seconds = secondsSince(start);
+        for (void*& p : live) release(p);
+        return seconds;
+    };
+
+    double poolSeconds = churn([&] { return pool.allocate(); }, [&](void* p) { pool.deallocate(p); });
+    double heapSeconds = churn([] { return ::operator new(sizeof(Chunk)); }, [](void* p) { ::operator delete(p); });
+
+    double operations = (double)ROUNDS * (LIVE / 4);
+    ctx.throughput("chunk-sized blocks from FixedPool", operations, poolSeconds);
+    ctx.throughput("chunk-sized blocks from new", operations, heapSeconds);
+
+    // I Chunk passano dal pool anche con make_unique
+    AllocationCount chunks = countAllocations([] {
+        for (int i = 0; i < 256; i++) {
+            auto chunk = std::make_unique<Chunk>();
+            chunk->setBlock(i & CHUNK_MASK, 3, 5, BLOCK_STONE);
+        }
+    });
+    ctx.check(chunks.total == 0, "warm pools make new chunks without the heap (" + std::to_string(chunks.total) + ")");
+}
+
+void benchMemory(BenchContext& ctx) {
+    benchSteadyFrame(ctx);
+    benchArena(ctx);
+    benchChunkPool(ctx);
+}
@@ -0,0 +1,76 @@
+#include "bench.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+#include "profiler.h"
+
+// ---------------------------------------------------------------
+// Profiler: quanto costa una zona (deve restare trascurabile anche
+// nei cicli dei worker) e se la raccolta ricostruisce correttamente
+// zone annidate di più thread e il trace di Chrome.
+// ---------------------------------------------------------------
+void benchProfiler(BenchContext& ctx) {
+#if !VOXEL_PROFILING
+    ctx.note("profiling compiled out (VOXEL_PROFILING=OFF)");
+#else
+    // Apre un frame "pulito": le zone lasciate dagli altri scenari
+    // (i job della pipeline) finiscono nel frame precedente
+    PROFILE_FRAME();
+
+    const int ZONES = 1000000;
+    auto start = Clock::now();
+    for (int i = 0; i < ZONES; i++) {
+        PROFILE_SCOPE("Bench zone");
+    }
+    ctx.throughput("empty zone", ZONES, secondsSince(start));
+    PROFILE_FRAME();
+
+    // Zone annidate sul thread principale e su due thread in parallelo
+    const int OUTER = 100;
+    auto work = [](const char* threadName) {
+        PROFILE_THREAD(threadName);
+        for (int i = 0; i < OUTER; i++) {
+            PROFILE_SCOPE("Outer");
+            PROFILE_SCOPE("Inner");
+        }
+    };
+    std::thread a(work, "Bench A"), b(work, "Bench B");
+    work("Main");
+    a.join();
+    b.join();
+    PROFILE_FRAME();
+
+    const ProfileFrame& frame = Profiler::frames().back();
+    int outer = 0, inner = 0;
+    bool nested = true;
+    for (const ProfileZone& zone : frame.zones) {
+        bool isOuter = std::string(zone.name) == "Outer";
+        bool isInner = std::string(zone.name) == "Inner";
+        outer += isOuter;
+        inner += isInner;
+        if ((isOuter && zone.depth != 0) || (isInner && zone.depth != 1) || zone.end < zone.start) nested = false;
+    }
+    ctx.check(outer == 3 * OUTER && inner == 3 * OUTER,
+        "collected " + std::to_string(outer) + " outer and " + std::to_string(inner) + " inner zones");
+    ctx.check(nested, "zone depths or times are wrong");
+
+    std::vector<std::string> names = Profiler::threadNames();
+    ctx.check(std::find(names.begin(), names.end(), "Bench A") != names.end(), "thread names are not recorded");
+
+    std::string path = (std::filesystem::temp_directory_path() / "voxel_bench_trace.json").string();
+    start = Clock::now();
+    bool written = Profiler::writeChromeTrace(path);
+    double seconds = secondsSince(start);
+    std::ifstream file(path);
+    std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    ctx.check(written && text.rfind("{\"displayTimeUnit\"", 0) == 0 && text.find("\"Bench B\"") != std::string::npos &&
+              text.find("\"Inner\"") != std::string::npos, "Chrome trace is missing zones or thread names");
+    ctx.value("Chrome trace write", seconds * 1e3, "ms");
+    ctx.value("Chrome trace size", text.size() / 1024.0, "KB");
+    std::filesystem::remove(path);
+#endif
+}
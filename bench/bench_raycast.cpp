@@ -0,0 +1,233 @@
+#include "bench.h"
+
+#include <cmath>
+#include <vector>
+
+#include "job_system.h"
+#include "raycast.h"
+#include "terrain.h"
+
+// ---------------------------------------------------------------
+// Raycast e collisioni su un mondo generato grande (32x32 colonne di
+// chunk, tutta l'altezza). Prima la correttezza: la maschera dei brick
+// deve seguire le modifiche, il DDA con salto deve dare esattamente gli
+// stessi colpi di quello blocco per blocco, i box non devono mai
+// finire dentro il terreno. Poi i raggi al secondo: lunghi (256 blocchi,
+// sonde e linea di vista) e corti (picking), singoli e in batch.
+// ---------------------------------------------------------------
+
+static const int AREA = 32;
+
+static float randomFloat(uint32_t& state) {
+    return (xorshift(state) & 0xFFFFFF) / float(0x1000000);
+}
+
+static glm::vec3 randomDirection(uint32_t& state) {
+    for (;;) {
+        glm::vec3 d(randomFloat(state) * 2.0f - 1.0f, randomFloat(state) * 2.0f - 1.0f, randomFloat(state) * 2.0f - 1.0f);
+        float length = glm::length(d);
+        if (length > 0.1f && length <= 1.0f) return d / length;
+    }
+}
+
+// Maschera ricalcolata da zero, per confrontarla con quella tenuta dal chunk
+static uint64_t bruteForceBricks(const Chunk& chunk) {
+    uint64_t mask = 0;
+    for (int y = 0; y < CHUNK_SIZE; y++)
+        for (int z = 0; z < CHUNK_SIZE; z++)
+            for (int x = 0; x < CHUNK_SIZE; x++)
+                if (isSolid(chunk.getBlock(x, y, z))) mask |= uint64_t(1) << Chunk::brickIndex(x, y, z);
+    return mask;
+}
+
+static void checkBricks(BenchContext& ctx) {
+    uint32_t rng = 99;
+    int errors = 0;
+
+    // Modifiche sparse che riempiono e svuotano brick, con la palette
+    // che cresce fino al formato diretto
+    Chunk chunk;
+    for (int i = 0; i < 20000; i++) {
+        int x = xorshift(rng) & CHUNK_MASK, y = xorshift(rng) & CHUNK_MASK, z = xorshift(rng) & CHUNK_MASK;
+        BlockID id = (xorshift(rng) % 3 == 0) ? (BlockID)(1 + xorshift(rng) % 300) : (BlockID)BLOCK_AIR;
+        chunk.setBlock(x, y, z, id);
+        if (i % 97 == 0 && chunk.brickMask() != bruteForceBricks(chunk)) errors++;
+    }
+    errors += chunk.brickMask() != bruteForceBricks(chunk);
+
+    std::vector<uint8_t> bytes;
+    chunk.serialize(bytes);
+    Chunk loaded;
+    errors += !loaded.deserialize(bytes.data(), bytes.size()) || loaded.brickMask() != chunk.brickMask();
+
+    // Terreno vero: generate() passa da assign()
+    TerrainGenerator terrain(1337);
+    for (int cy = WORLD_MIN_CHUNK_Y; cy <= WORLD_MAX_CHUNK_Y; cy++) {
+        Chunk generated;
+        terrain.generate({ 3, cy, -2 }, generated);
+        errors += generated.brickMask() != bruteForceBricks(generated);
+    }
+    chunk.fill(BLOCK_STONE);
+    errors += chunk.brickMask() != ~uint64_t(0);
+
+    ctx.check(errors == 0, "brick masks follow edits, loads and generation (" + std::to_string(errors) + " errors)");
+}
+
+static void benchRays(BenchContext& ctx, const World& world) {
+    uint32_t rng = 2024;
+    const float SIZE = AREA * CHUNK_SIZE;
+
+    // Raggi lunghi da sopra il terreno in tutte le direzioni
+    std::vector<Ray> longRays(20000);
+    for (Ray& ray : longRays) {
+        ray.origin      = glm::vec3(randomFloat(rng) * SIZE, 70.0f + randomFloat(rng) * 50.0f, randomFloat(rng) * SIZE);
+        ray.direction   = randomDirection(rng);
+        ray.maxDistance = 256.0f;
+    }
+
+    // Picking: dall'altezza degli occhi sopra il suolo, 8 blocchi
+    std::vector<Ray> pickRays(20000);
+    for (Ray& ray : pickRays) {
+        glm::vec3 top(randomFloat(rng) * SIZE, 127.5f, randomFloat(rng) * SIZE);
+        RayHit ground = raycast(world, { top, { 0.0f, -1.0f, 0.0f }, 128.0f });
+        ray.origin      = glm::vec3(top.x, ground.block.y + 2.62f, top.z);
+        ray.direction   = randomDirection(rng);
+        ray.maxDistance = 8.0f;
+    }
+
+    // Casi limite del DDA: origini e direzioni intere, parallele agli
+    // assi o sulle diagonali, dove le facce si attraversano a pari distanza
+    std::vector<Ray> edgeRays;
+    for (int i = 0; i < 4000; i++) {
+        Ray ray;
+        ray.origin = glm::vec3((float)(xorshift(rng) % (int)SIZE), (float)(40 + xorshift(rng) % 80), (float)(xorshift(rng) % (int)SIZE));
+        if (i & 1) ray.origin += glm::vec3(0.5f);
+        ray.direction   = glm::vec3((int)(xorshift(rng) % 3) - 1, (int)(xorshift(rng) % 3) - 1, (int)(xorshift(rng) % 3) - 1);
+        ray.maxDistance = 200.0f;
+        edgeRays.push_back(ray);
+    }
+
+    auto same = [](const RayHit& a, const RayHit& b) {
+        return a.hit == b.hit && (!a.hit || (a.block == b.block && a.normal == b.normal && a.distance == b.distance && a.id == b.id));
+    };
+
+    int mismatches = 0, longHits = 0;
+    for (const std::vector<Ray>* rays : { &longRays, &pickRays, &edgeRays })
+        for (const Ray& ray : *rays) {
+            RayHit fast = raycast(world, ray);
+            mismatches += !same(fast, raycastNaive(world, ray));
+            longHits += rays == &longRays && fast.hit;
+        }
+    ctx.check(mismatches == 0, "accelerated raycast matches the naive DDA (" + std::to_string(mismatches) + " mismatches)");
+    ctx.value("long rays hitting terrain", 100.0 * longHits / longRays.size(), "%");
+
+    // Tempi: lo stesso lavoro con le due versioni
+    std::vector<RayHit> hits(longRays.size());
+    for (const std::vector<Ray>* rays : { &longRays, &pickRays }) {
+        std::string kind = rays == &longRays ? "long" : "picking";
+
+        auto start = Clock::now();
+        for (size_t i = 0; i < rays->size(); i++) hits[i] = raycastNaive(world, (*rays)[i]);
+        double naiveSeconds = secondsSince(start);
+
+        start = Clock::now();
+        for (size_t i = 0; i < rays->size(); i++) hits[i] = raycast(world, (*rays)[i]);
+        double fastSeconds = secondsSince(start);
+
+        ctx.throughput(kind + " rays naive", (double)rays->size(), naiveSeconds, "rays");
+        ctx.throughput(kind + " rays bricks", (double)rays->size(), fastSeconds, "rays");
+        ctx.value(kind + " speedup", naiveSeconds / fastSeconds, "x");
+    }
+
+    // Batch sui worker, più il thread chiamante
+    JobSystem jobs;
+    std::vector<RayHit> batchHits(longRays.size());
+    const int ROUNDS = 5;
+    auto start = Clock::now();
+    for (int round = 0; round < ROUNDS; round++)
+        raycastBatch(world, longRays.data(), batchHits.data(), (int)longRays.size(), &jobs);
+    ctx.throughput("long rays batch (" + std::to_string(jobs.workerCount() + 1) + " threads)",
+        (double)longRays.size() * ROUNDS, secondsSince(start), "rays");
+
+    int batchErrors = 0;
+    for (size_t i = 0; i < longRays.size(); i++) batchErrors += !same(batchHits[i], raycast(world, longRays[i]));
+    ctx.check(batchErrors == 0, "batch raycast matches single rays");
+
+    // Linea di vista tra coppie di punti sopra il suolo (es. nemici)
+    std::vector<Ray> sight;
+    for (size_t i = 0; i + 1 < pickRays.size(); i += 2)
+        sight.push_back(Ray::between(pickRays[i].origin, pickRays[i + 1].origin));
+    std::vector<RayHit> sightHits(sight.size());
+    start = Clock::now();
+    raycastBatch(world, sight.data(), sightHits.data(), (int)sight.size(), &jobs);
+    double sightSeconds = secondsSince(start);
+    int visible = 0;
+    for (const RayHit& hit : sightHits) visible += !hit.hit;
+    ctx.throughput("line of sight batch", (double)sight.size(), sightSeconds, "rays");
+    ctx.value("pairs in sight", 100.0 * visible / sight.size(), "%");
+}
+
+// Box del giocatore (0.6 x 1.8 x 0.6) con i piedi in feet
+static Aabb playerBox(const glm::vec3& feet) {
+    return { feet - glm::vec3(0.3f, 0.0f, 0.3f), feet + glm::vec3(0.3f, 1.8f, 0.3f) };
+}
+
+static void benchCollision(BenchContext& ctx, const World& world) {
+    uint32_t rng = 77;
+    const float SIZE = AREA * CHUNK_SIZE;
+
+    // 1) Box lasciati cadere dal cielo: devono fermarsi appoggiati a un blocco
+    int drops = 0, notLanded = 0, sweeps = 0;
+    auto start = Clock::now();
+    for (int i = 0; i < 2000; i++) {
+        Aabb box = playerBox(glm::vec3(16.0f + randomFloat(rng) * (SIZE - 32.0f), 126.0f, 16.0f + randomFloat(rng) * (SIZE - 32.0f)));
+        bool landed = false;
+        for (int fall = 0; fall < 400 && !landed; fall++) {
+            landed = sweepAabb(world, box, glm::vec3(0.0f, -0.7f, 0.0f)).blocked[1];
+            sweeps++;
+        }
+        Aabb below = { { box.min.x, box.min.y - 0.01f, box.min.z }, { box.max.x, box.min.y, box.max.z } };
+        notLanded += !landed || !overlapsSolid(world, below) || overlapsSolid(world, box);
+        drops++;
+    }
+    ctx.check(notLanded == 0, "dropped boxes rest on the ground (" + std::to_string(notLanded) + " of " + std::to_string(drops) + " wrong)");
+
+    // 2) Passi casuali in tutte le direzioni: mai dentro un blocco
+    int inside = 0, blockedSteps = 0;
+    const int WALKERS = 64, STEPS = 2000;
+    for (int w = 0; w < WALKERS; w++) {
+        glm::vec3 top(32.0f + randomFloat(rng) * (SIZE - 64.0f), 127.5f, 32.0f + randomFloat(rng) * (SIZE - 64.0f));
+        RayHit ground = raycast(world, { top, { 0.0f, -1.0f, 0.0f }, 128.0f });
+        Aabb box = playerBox(glm::vec3(top.x, ground.block.y + 1.01f, top.z));
+        if (overlapsSolid(world, box)) continue; // sotto una sporgenza: si salta
+
+        for (int s = 0; s < STEPS; s++) {
+            glm::vec3 motion = randomDirection(rng) * (0.1f + randomFloat(rng) * 0.8f);
+            SweepResult result = sweepAabb(world, box, motion);
+            blockedSteps += result.blocked[0] || result.blocked[1] || result.blocked[2];
+            inside += overlapsSolid(world, box);
+            sweeps++;
+        }
+    }
+    double seconds = secondsSince(start);
+    ctx.check(inside == 0, "swept boxes never end inside blocks (" + std::to_string(inside) + " steps)");
+    ctx.value("walk steps blocked", 100.0 * blockedSteps / (WALKERS * STEPS), "%");
+    ctx.throughput("sweeps", sweeps, seconds, "sweeps");
+}
+
+void benchRaycast(BenchContext& ctx) {
+    checkBricks(ctx);
+
+    World world;
+    TerrainGenerator terrain(1337);
+    auto start = Clock::now();
+    for (int cz = 0; cz < AREA; cz++)
+        for (int cx = 0; cx < AREA; cx++)
+            for (int cy = WORLD_MIN_CHUNK_Y; cy <= WORLD_MAX_CHUNK_Y; cy++)
+                terrain.generate({ cx, cy, cz }, world.getOrCreateChunk({ cx, cy, cz }));
+    ctx.value("world generation", secondsSince(start) * 1e3, "ms");
+    ctx.value("world chunks", world.chunkCount(), "chunks");
+
+    benchRays(ctx, world);
+    benchCollision(ctx, world);
+}
@@ -0,0 +1,337 @@
+#include "bench.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+
+#include "buffer_allocator.h"
+#include "culling.h"
+#include "mesher.h"
+#include "terrain.h"
+#include "world.h"
+
+// ---------------------------------------------------------------
+// Meshing: tre chunk tipici (colline, scacchiera = caso peggiore,
+// blocco pieno) meshati con sole facce visibili e con greedy meshing,
+// poi il tempo di ogni chunk di un pezzo di terreno vero.
+// Il numero di triangoli "naive" è quello di un cubo intero per blocco.
+// ---------------------------------------------------------------
+static void benchMeshingCase(BenchContext& ctx, const std::string& name, const World& world) {
+    auto input = std::make_unique<MeshInput>();
+    input->gather(world, { 0, 0, 0 });
+
+    int solid = world.getChunk({ 0, 0, 0 })->solidCount();
+    ctx.value(name + " naive triangles", solid * 12, "triangles");
+
+    ChunkMesh mesh;
+    for (bool greedy : { false, true }) {
+        std::string variant = name + (greedy ? " greedy" : " culled");
+        const int ITERATIONS = 500;
+        auto start = Clock::now();
+        for (int i = 0; i < ITERATIONS; i++)
+            buildChunkMesh(*input, mesh, greedy);
+        ctx.throughput(variant, ITERATIONS, secondsSince(start), "chunks");
+        ctx.value(variant + " triangles", mesh.triangleCount(), "triangles");
+    }
+}
+
+void benchMeshing(BenchContext& ctx) {
+    World hills;
+    for (int z = 0; z < CHUNK_SIZE; z++)
+        for (int x = 0; x < CHUNK_SIZE; x++) {
+            int height = 6 + (int)(3.0f * std::sin(x * 0.4f) + 3.0f * std::cos(z * 0.3f));
+            for (int y = 0; y < height; y++)
+                hills.setBlock(x, y, z, y == height - 1 ? BLOCK_GRASS : (y > height - 4 ? BLOCK_DIRT : BLOCK_STONE));
+        }
+    benchMeshingCase(ctx, "hills", hills);
+
+    World checkerboard;
+    for (int y = 0; y < CHUNK_SIZE; y++)
+        for (int z = 0; z < CHUNK_SIZE; z++)
+            for (int x = 0; x < CHUNK_SIZE; x++)
+                if ((x + y + z) & 1) checkerboard.setBlock(x, y, z, BLOCK_STONE);
+    benchMeshingCase(ctx, "checkerboard", checkerboard);
+
+    World solid;
+    solid.getOrCreateChunk({ 0, 0, 0 }).fill(BLOCK_STONE);
+    benchMeshingCase(ctx, "solid", solid);
+
+    // Terreno vero: gather + mesh + visibilità, come un job della pipeline
+    World world;
+    TerrainGenerator terrain(1337);
+    const int AREA = 8;
+    for (int cz = -1; cz <= AREA; cz++)
+        for (int cx = -1; cx <= AREA; cx++)
+            for (int cy = WORLD_MIN_CHUNK_Y; cy <= WORLD_MAX_CHUNK_Y; cy++)
+                terrain.generate({ cx, cy, cz }, world.getOrCreateChunk({ cx, cy, cz }));
+
+    auto input = std::make_unique<MeshInput>();
+    ChunkMesh mesh;
+    std::vector<double> samples;
+    for (int cz = 0; cz < AREA; cz++)
+        for (int cx = 0; cx < AREA; cx++)
+            for (int cy = WORLD_MIN_CHUNK_Y; cy <= WORLD_MAX_CHUNK_Y; cy++) {
+                auto start = Clock::now();
+                input->gather(world, { cx, cy, cz });
+                buildChunkMesh(*input, mesh);
+                mesh.visibility = computeChunkVisibility(*input);
+                samples.push_back(secondsSince(start));
+            }
+    ctx.latency("terrain mesh per chunk", std::move(samples));
+}
+
+// ---------------------------------------------------------------
+// Formato dei vertici: prima controlla che pack/unpack siano
+// l'uno l'inverso dell'altro su tutti i valori validi, poi misura
+// i byte per chunk visibile su un pezzo di terreno generato,
+// confrontando il formato compatto con quelli "a float".
+// ---------------------------------------------------------------
+void benchVertexFormat(BenchContext& ctx) {
+    bool roundTrip = true;
+    for (int x = 0; x <= CHUNK_SIZE; x++)
+    for (int y = 0; y <= CHUNK_SIZE; y++)
+    for (int z = 0; z <= CHUNK_SIZE; z++)
+    for (int face = 0; face < 6; face++)
+    for (int ao = 0; ao < 4; ao++) {
+        VertexData v = { x, y, z, face, ao, (x * 977 + z) & 0xFFFF, y & 15, (x + z) & 15 };
+        VertexData back = unpackVertex(packVertex(v));
+        roundTrip = roundTrip && std::memcmp(&v, &back, sizeof(VertexData)) == 0;
+    }
+    ctx.check(roundTrip, "vertex pack/unpack round trip");
+
+    World world;
+    TerrainGenerator terrain(1337);
+    const int AREA = 8;
+    for (int cz = -1; cz <= AREA; cz++)
+        for (int cx = -1; cx <= AREA; cx++)
+            for (int cy = WORLD_MIN_CHUNK_Y; cy <= WORLD_MAX_CHUNK_Y; cy++)
+                terrain.generate({ cx, cy, cz }, world.getOrCreateChunk({ cx, cy, cz }));
+
+    auto input = std::make_unique<MeshInput>();
+    ChunkMesh mesh;
+    long long vertices = 0, indices = 0;
+    int visibleChunks = 0;
+    for (int cz = 0; cz < AREA; cz++)
+        for (int cx = 0; cx < AREA; cx++)
+            for (int cy = WORLD_MIN_CHUNK_Y; cy <= WORLD_MAX_CHUNK_Y; cy++) {
+                input->gather(world, { cx, cy, cz });
+                buildChunkMesh(*input, mesh);
+                if (mesh.empty()) continue;
+                vertices += (long long)mesh.vertices.size();
+                indices  += (long long)mesh.indices.size();
+                visibleChunks++;
+            }
+
+    // Formati di confronto:
+    //  - float completo: posizione, normale, UV (float) + luce (uint) = 36 byte
+    //  - il vertice del mesher prima del formato compatto = 16 byte
+    struct Format { const char* name; int bytesPerVertex; };
+    const Format formats[] = {
+        { "float pos+normal+uv+light", 36 },
+        { "float pos + face + block",  16 },
+        { "packed",                    (int)sizeof(PackedVertex) },
+    };
+    ctx.value("vertices per visible chunk", (double)vertices / visibleChunks, "vertices");
+    ctx.value("indices per visible chunk",  (double)indices / visibleChunks, "indices");
+    for (const Format& format : formats) {
+        double bytes = (double)(vertices * format.bytesPerVertex + indices * (long long)sizeof(uint16_t)) / visibleChunks;
+        ctx.value(std::string(format.name) + " per chunk", bytes / 1024.0, "KB");
+    }
+}
+
+// ---------------------------------------------------------------
+// Allocatore dei buffer delle mesh: simula il caricamento e lo
+// scaricamento continuo di mesh di dimensioni diverse, controlla che
+// due intervalli non si sovrappongano mai e che liberando tutto lo
+// spazio torni un unico blocco.
+// ---------------------------------------------------------------
+void benchBufferAllocator(BenchContext& ctx) {
+    const uint32_t CAPACITY = 1u << 22;
+    BufferAllocator allocator(CAPACITY);
+
+    struct Range { uint32_t offset, size; };
+    std::vector<Range> live;
+    std::vector<uint8_t> owner(CAPACITY, 0); // 1 dove lo spazio è allocato
+    uint32_t rng = 99;
+
+    const int OPERATIONS = 200000;
+    int failures = 0;
+    auto start = Clock::now();
+    for (int i = 0; i < OPERATIONS; i++) {
+        // Si riempie fino a circa l'80% e poi carica e scarica in equilibrio,
+        // come il renderer quando la camera si muove
+        bool doAllocate = live.empty() || (allocator.used() < CAPACITY / 10 * 8 && (xorshift(rng) % 100) < 60)
+                                       || (xorshift(rng) % 100) < 45;
+        if (doAllocate) {
+            // Dimensioni tipiche di una mesh: da poche decine a qualche migliaio di vertici
+            uint32_t size = 16 + xorshift(rng) % 4000;
+            uint32_t offset = allocator.allocate(size);
+            if (offset == BufferAllocator::INVALID) { failures++; continue; }
+            live.push_back({ offset, size });
+        } else {
+            size_t index = xorshift(rng) % live.size();
+            allocator.free(live[index].offset, live[index].size);
+            live[index] = live.back();
+            live.pop_back();
+        }
+    }
+    ctx.throughput("alloc/free (best fit)", OPERATIONS, secondsSince(start));
+
+    // Controllo delle sovrapposizioni (fuori dal tempo misurato)
+    bool overlap = false;
+    uint64_t liveUnits = 0;
+    for (const Range& r : live) {
+        liveUnits += r.size;
+        for (uint32_t k = 0; k < r.size; k++) {
+            if (owner[r.offset + k]) { overlap = true; break; }
+            owner[r.offset + k] = 1;
+        }
+    }
+    ctx.check(!overlap, "overlapping allocations");
+    ctx.check(liveUnits == allocator.used(), "allocator used count differs from the live allocations");
+
+    ctx.value("live allocations", (double)live.size(), "ranges");
+    ctx.value("free blocks", allocator.freeBlockCount(), "blocks");
+    ctx.value("used", 100.0 * allocator.used() / allocator.capacity(), "%");
+    ctx.value("failed allocations", failures, "allocations");
+
+    for (const Range& r : live) allocator.free(r.offset, r.size);
+    ctx.check(allocator.used() == 0 && allocator.freeBlockCount() == 1 && allocator.largestFreeBlock() == CAPACITY,
+        "free space did not coalesce back into one block");
+}
+
+// ---------------------------------------------------------------
+// Culling: prima controlla su mondi sintetici che il test SIMD dia
+// gli stessi risultati di quello scalare e che il cave culling scarti
+// davvero una grotta chiusa, poi misura il costo per frame su terreno vero.
+// ---------------------------------------------------------------
+
+// Mesha tutti i chunk del mondo e li registra nel culler
+static void feedCuller(const World& world, ChunkCuller& culler) {
+    auto input = std::make_unique<MeshInput>();
+    ChunkMesh mesh;
+    world.forEachChunk([&](const ChunkPos& pos, const Chunk&) {
+        input->gather(world, pos);
+        buildChunkMesh(*input, mesh);
+        culler.setChunk(pos, computeChunkVisibility(*input), !mesh.empty());
+    });
+}
+
+static Frustum cameraFrustum(const glm::vec3& eye, const glm::vec3& target) {
+    glm::mat4 view = glm::lookAt(eye, target, glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(70.0f), 16.0f / 9.0f, 0.1f, 200.0f);
+    return Frustum::fromMatrix(projection * view);
+}
+
+static bool contains(const std::vector<ChunkPos>& list, const ChunkPos& pos) {
+    return std::find(list.begin(), list.end(), pos) != list.end();
+}
+
+void benchCulling(BenchContext& ctx) {
+    // 1) SIMD contro scalare su box casuali
+    BoxBatch boxes;
+    uint32_t rng = 12345;
+    const int BOX_COUNT = 100000;
+    for (int i = 0; i < BOX_COUNT; i++) {
+        glm::vec3 min((float)(xorshift(rng) % 512) - 256.0f, (float)(xorshift(rng) % 128), (float)(xorshift(rng) % 512) - 256.0f);
+        boxes.push(min, min + glm::vec3((float)CHUNK_SIZE));
+    }
+    Frustum frustum = cameraFrustum(glm::vec3(0.0f, 64.0f, 0.0f), glm::vec3(100.0f, 40.0f, 60.0f));
+
+    std::vector<uint8_t> batch(BOX_COUNT), scalar(BOX_COUNT);
+    const int REPEATS = 50;
+    auto start = Clock::now();
+    for (int r = 0; r < REPEATS; r++) cullBoxes(frustum, boxes, batch.data());
+    double batchSeconds = secondsSince(start);
+
+    start = Clock::now();
+    for (int r = 0; r < REPEATS; r++)
+        for (int i = 0; i < BOX_COUNT; i++)
+            scalar[i] = frustum.intersectsBox(
+                glm::vec3(boxes.minX[i], boxes.minY[i], boxes.minZ[i]),
+                glm::vec3(boxes.maxX[i], boxes.maxY[i], boxes.maxZ[i])) ? 1 : 0;
+    double scalarSeconds = secondsSince(start);
+
+    int mismatches = 0;
+    for (int i = 0; i < BOX_COUNT; i++) mismatches += batch[i] != scalar[i];
+    ctx.check(mismatches == 0, "batch frustum test differs from scalar on " + std::to_string(mismatches) + " boxes");
+    ctx.throughput("frustum test (scalar)", (double)BOX_COUNT * REPEATS, scalarSeconds);
+    ctx.throughput("frustum test (batch)", (double)BOX_COUNT * REPEATS, batchSeconds);
+
+    // 2) Mondo sintetico: terreno piatto pieno fino a y = 63 con una
+    //    grotta chiusa (chunk cavo) sepolta in (0, 1, 0)
+    {
+        World world;
+        for (int cz = -3; cz <= 3; cz++)
+            for (int cx = -3; cx <= 3; cx++)
+                for (int cy = 0; cy <= 3; cy++)
+                    world.getOrCreateChunk({ cx, cy, cz }).fill(BLOCK_STONE);
+        Chunk& cave = world.getOrCreateChunk({ 0, 1, 0 });
+        for (int y = 1; y < CHUNK_MASK; y++)
+            for (int z = 1; z < CHUNK_MASK; z++)
+                for (int x = 1; x < CHUNK_MASK; x++)
+                    cave.setBlock(x, y, z, BLOCK_AIR);
+
+        ChunkCuller culler;
+        feedCuller(world, culler);
+        std::vector<ChunkPos> visible;
+
+        // Da sopra, guardando in basso verso la grotta: la superficie si vede, la grotta no
+        glm::vec3 eye(8.0f, 90.0f, -40.0f);
+        culler.cull(cameraFrustum(eye, glm::vec3(8.0f, 24.0f, 8.0f)), eye, 8, visible);
+        ctx.check(contains(visible, { 0, 3, 0 }) && !contains(visible, { 0, 1, 0 }),
+            "sealed cave visible from the surface");
+
+        // Senza occlusion culling la grotta torna visibile (è nel frustum)
+        culler.occlusionEnabled = false;
+        culler.cull(cameraFrustum(eye, glm::vec3(8.0f, 24.0f, 8.0f)), eye, 8, visible);
+        ctx.check(contains(visible, { 0, 1, 0 }), "cave outside the frustum in the synthetic world");
+        culler.occlusionEnabled = true;
+
+        // Da dentro la grotta: si vede solo la grotta
+        eye = glm::vec3(8.0f, 24.0f, 8.0f);
+        culler.cull(cameraFrustum(eye, glm::vec3(8.0f, 60.0f, 9.0f)), eye, 8, visible);
+        ctx.check(visible.size() == 1 && contains(visible, { 0, 1, 0 }),
+            "surface visible from inside the sealed cave");
+    }
+
+    // 3) Terreno vero, 17x17 colonne come con RENDER_DISTANCE = 8
+    {
+        World world;
+        TerrainGenerator terrain(1337);
+        for (int cz = -8; cz <= 8; cz++)
+            for (int cx = -8; cx <= 8; cx++)
+                for (int cy = WORLD_MIN_CHUNK_Y; cy <= WORLD_MAX_CHUNK_Y; cy++)
+                    terrain.generate({ cx, cy, cz }, world.getOrCreateChunk({ cx, cy, cz }));
+
+        ChunkCuller culler;
+        feedCuller(world, culler);
+        std::vector<ChunkPos> visible;
+
+        struct View { const char* name; glm::vec3 eye; glm::vec3 target; };
+        float surface = (float)std::max(terrain.surfaceHeight(0, 0), TerrainGenerator::SEA_LEVEL);
+        const View views[] = {
+            { "surface, horizon",  glm::vec3(0.5f, surface + 3.0f, 0.5f), glm::vec3(100.0f, surface, 30.0f) },
+            { "surface, down",     glm::vec3(0.5f, surface + 3.0f, 0.5f), glm::vec3(10.0f, 0.0f, 10.0f) },
+            { "high above",        glm::vec3(0.5f, 127.0f, 0.5f),         glm::vec3(60.0f, 40.0f, 60.0f) },
+            { "underground",       glm::vec3(0.5f, 12.0f, 0.5f),          glm::vec3(100.0f, 12.0f, 30.0f) },
+        };
+        for (const View& v : views) {
+            Frustum f = cameraFrustum(v.eye, v.target);
+            const int FRAMES = 200;
+            std::vector<double> samples;
+            for (int i = 0; i < FRAMES; i++) {
+                auto frameStart = Clock::now();
+                culler.cull(f, v.eye, 8, visible);
+                samples.push_back(secondsSince(frameStart));
+            }
+
+            const CullingStats& stats = culler.stats();
+            ctx.latency(std::string(v.name) + " cull", std::move(samples));
+            ctx.note("%-18s %5d considered %5d frustum %5d occlusion %5d drawn",
+                v.name, stats.considered, stats.frustumCulled, stats.occlusionCulled, stats.drawn);
+            ctx.value(std::string(v.name) + " drawn", stats.drawn, "chunks");
+        }
+    }
+}
@@ -0,0 +1,199 @@
+#include "bench.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "block_registry.h"
+#include "client.h"
+#include "job_system.h"
+#include "server.h"
+
+// ---------------------------------------------------------------
+// Server con giocatori finti in loopback. N bot volano sul terreno
+// rompendo ogni tanto un blocco, attorno allo spawn girano migliaia
+// di creature. Si misura il tick del server e quanti byte riceve
+// ogni giocatore al secondo, che devono restare nella banda fissata.
+//
+// Poi i bot si fermano: quando lo streaming ha finito ogni client
+// deve avere tutti i chunk in vista uguali a quelli del server (anche
+// quelli modificati) e le stesse entità dell'ultimo tick. Con un
+// quinto dei pacchetti persi i chunk devono arrivare lo stesso.
+// ---------------------------------------------------------------
+
+static const int FLY_SECONDS    = 10;
+static const int SETTLE_SECONDS = 8;
+static const int MOBS           = 2000;
+
+namespace {
+
+struct BotRun {
+    std::vector<double> tickTimes;
+    double bytesPerPlayerSecond = 0.0;
+    double worstPlayerRate      = 0.0; // byte/s del client che ne ha ricevuti di più
+    long long overBudget  = 0;   // client oltre la banda
+    long long missing     = 0;   // chunk in vista che il client non ha
+    long long different   = 0;   // chunk diversi da quelli del server
+    long long wrongEntities = 0; // client con entità diverse dall'ultimo tick del server
+    long long rejected    = 0;
+    double entityDeltaBytes = 0.0; // per aggiornamento, in media
+    double entityFullBytes  = 0.0; // lo stesso stato mandato da zero
+    ServerStats stats;
+};
+
+BotRun runBots(int bots, float loss, JobSystem& jobs) {
+    ServerConfig config;
+    config.tickRate       = 20;
+    config.viewDistance   = 4;
+    config.bytesPerSecond = 64 * 1024;
+
+    GameServer server(config, &jobs);
+    std::vector<std::unique_ptr<GameClient>> clients;
+    std::vector<int> ids;
+    for (int i = 0; i < bots; i++) {
+        auto [serverSide, clientSide] = makeLoopbackPair(loss, (uint32_t)i + 7);
+        ids.push_back(server.connect(std::move(serverSide)));
+        clients.push_back(std::make_unique<GameClient>(std::move(clientSide)));
+    }
+
+    BotRun run;
+    bool spawned = false;
+    int flyTicks   = FLY_SECONDS * config.tickRate;
+    int settleTicks = SETTLE_SECONDS * config.tickRate;
+    for (int tick = 1; tick <= flyTicks + settleTicks; tick++) {
+        bool flying = tick <= flyTicks;
+        for (size_t i = 0; i < clients.size(); i++) {
+            GameClient& client = *clients[i];
+            client.update();
+            if (!client.welcomed()) continue;
+            PlayerInput input = botInput((int)i, client.inputsSent() + 1);
+            if (!flying) {
+                input.moves      = 0;
+                input.breakBlock = false;
+            }
+            client.sendInput(input);
+        }
+
+        auto start = Clock::now();
+        server.tick();
+        if (flying) run.tickTimes.push_back(secondsSince(start));
+        if (!spawned && tick >= 5) spawned = server.spawnMobs(server.spawnEye(), MOBS, 40.0f) > 0;
+    }
+    for (auto& client : clients) client->update(); // l'ultimo tick
+
+    // Banda: il budget di ogni tick più lo scoperto massimo di un
+    // pacchetto (un chunk che non si comprime)
+    double seconds = (double)(flyTicks + settleTicks) / config.tickRate;
+    double allowed = config.bytesPerSecond * seconds + config.bytesPerSecond / config.tickRate * 4.0
+                   + 2.0 * Chunk::MAX_SERIALIZED_SIZE;
+    long long total = 0;
+    for (int id : ids) {
+        long long bytes = server.bytesSentTo(id);
+        total += bytes;
+        run.worstPlayerRate = std::max(run.worstPlayerRate, bytes / seconds);
+        run.overBudget += bytes > allowed;
+    }
+    run.bytesPerPlayerSecond = total / seconds / bots;
+
+    // Chunk e entità come sul server
+    const World& world = server.world();
+    std::vector<uint8_t> mine, theirs;
+    for (size_t i = 0; i < clients.size(); i++) {
+        const GameClient& client = *clients[i];
+        glm::vec3 eye = server.playerEye(ids[i]);
+        ChunkPos center = World::toChunkPos((int)std::floor(eye.x), 0, (int)std::floor(eye.z));
+        int r = config.viewDistance;
+        for (int dz = -r; dz <= r; dz++)
+            for (int dx = -r; dx <= r; dx++) {
+                if (dx * dx + dz * dz > r * r) continue;
+                for (int cy = WORLD_MIN_CHUNK_Y; cy <= WORLD_MAX_CHUNK_Y; cy++) {
+                    ChunkPos pos = { center.x + dx, cy, center.z + dz };
+                    const Chunk* original = world.findChunk(pos);
+                    const Chunk* copy     = client.world().findChunk(pos);
+                    if (!original) continue;
+                    if (!copy) {
+                        run.missing++;
+                        continue;
+                    }
+                    mine.clear();
+                    theirs.clear();
+                    copy->serialize(mine);
+                    original->serialize(theirs);
+                    run.different += mine != theirs || client.chunkVersion(pos) != server.chunkVersion(pos);
+                }
+            }
+
+        const std::vector<NetEntity>* expected = server.lastEntities(ids[i]);
+        bool same = expected && client.entityTick() == server.ticks() && expected->size() == client.entities().size();
+        for (size_t e = 0; same && e < expected->size(); e++) {
+            const NetEntity& a = (*expected)[e];
+            const NetEntity& b = client.entities()[e];
+            same = a.id == b.id && a.position == b.position && a.yaw == b.yaw && a.layers == b.layers;
+        }
+        run.wrongEntities += !same;
+        run.rejected += client.stats().rejectedPackets;
+
+        // Lo stesso stato da zero, per confronto con le differenze
+        std::vector<uint8_t> full;
+        ByteWriter writer(full);
+        writeEntityDelta(writer, {}, client.entities());
+        run.entityFullBytes += (double)full.size() / bots;
+    }
+
+    run.stats = server.stats();
+    run.entityDeltaBytes = run.stats.entityUpdates ? (double)run.stats.entityBytes / run.stats.entityUpdates : 0.0;
+    return run;
+}
+
+} // namespace
+
+void benchServer(BenchContext& ctx) {
+    JobSystem jobs;
+    bool withinBudget = true, complete = true, sameEntities = true, valid = true;
+
+    for (int bots : { 1, 4, 16 }) {
+        BotRun run = runBots(bots, 0.0f, jobs);
+        std::string label = std::to_string(bots) + (bots == 1 ? " bot" : " bots");
+        ctx.latency("server tick, " + label, std::move(run.tickTimes));
+        ctx.value("bytes per player per second, " + label, run.bytesPerPlayerSecond / 1024.0, "KB/s");
+        ctx.value("busiest player, " + label, run.worstPlayerRate / 1024.0, "KB/s");
+        if (bots == 4) {
+            ctx.value("chunks sent, " + label, (double)run.stats.chunksSent, "chunks");
+            ctx.value("chunk message, average", (double)run.stats.chunkBytes / std::max(1LL, run.stats.chunksSent), "bytes");
+            ctx.value("entity update, delta", run.entityDeltaBytes, "bytes");
+            ctx.value("entity update, from scratch", run.entityFullBytes, "bytes");
+        }
+        withinBudget &= run.overBudget == 0;
+        complete     &= run.missing == 0 && run.different == 0;
+        sameEntities &= run.wrongEntities == 0;
+        valid        &= run.rejected == 0;
+        if (run.missing || run.different)
+            ctx.note("%s: %lld chunks missing, %lld different", label.c_str(), run.missing, run.different);
+    }
+
+    BotRun lossy = runBots(4, 0.2f, jobs);
+    ctx.value("chunks resent with 20% loss, 4 bots", (double)lossy.stats.chunksResent, "chunks");
+    ctx.value("bytes per player per second with 20% loss", lossy.bytesPerPlayerSecond / 1024.0, "KB/s");
+
+    ctx.check(withinBudget && lossy.overBudget == 0, "every client stays within its bandwidth cap");
+    ctx.check(complete, "after streaming, clients hold every chunk in view exactly as the server");
+    ctx.check(sameEntities, "client entities match the server's last update bit for bit");
+    ctx.check(valid && lossy.rejected == 0, "every received packet decodes");
+    ctx.check(lossy.missing == 0 && lossy.different == 0,
+              "with 20% packet loss chunks still arrive (" + std::to_string(lossy.missing) + " missing)");
+
+    // Un BlockID oltre 255 (tipi registrati a runtime) arriva intero,
+    // uno che il server non conosce no
+    for (int i = 0; registeredBlockCount() < 300; i++) registerBlock({ "bench block " + std::to_string(i) });
+    InputMessage sent, received;
+    sent.input.block = (BlockID)(registeredBlockCount() - 1);
+    std::vector<uint8_t> packet;
+    writeInput(packet, sent);
+    ByteReader reader(packet.data() + 1, packet.size() - 1); // dopo il tipo del messaggio
+    bool wideBlock = readInput(reader, received) && received.input.block == sent.input.block;
+    resetBlockRegistry();
+    reader = ByteReader(packet.data() + 1, packet.size() - 1);
+    ctx.check(wideBlock && !readInput(reader, received), "block ids above 255 survive the input message");
+}
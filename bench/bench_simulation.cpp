@@ -0,0 +1,198 @@
+#include "bench.h"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "job_system.h"
+#include "light.h"
+#include "simulation.h"
+#include "terrain.h"
+#include "world.h"
+
+// ---------------------------------------------------------------
+// Simulazione a passo fisso. Prima senza thread, come per rivedere
+// una partita registrata: gli stessi comandi su due mondi nuovi
+// (camminare, girarsi, rompere e piazzare blocchi, un gruppo di
+// creature) devono dare tick per tick esattamente lo stesso stato,
+// giocatore, frammenti, creature e blocchi compresi; la seconda volta
+// con i sistemi delle creature divisi tra i worker.
+//
+// Poi sul suo thread, con un "render thread" che fa quello del game
+// loop: manda i comandi, prende l'ultimo snapshot, interpola camera e
+// istanze e prova il lock del mondo. Prima a frame veloci, poi lenti
+// (una GPU da 20 FPS): la simulazione deve restare a 60 tick al
+// secondo e la camera interpolata non deve mai tornare indietro.
+// ---------------------------------------------------------------
+static const int SIM_AREA  = 4;   // colonne di chunk per lato attorno all'origine
+static const int SIM_TICKS = 600; // 10 secondi a 60 Hz
+
+namespace {
+
+// Un mondo come nel gioco, generato e illuminato subito
+struct SimWorld {
+    World            world;
+    LightEngine      light{ world };
+    TerrainGenerator terrain{ 1337 };
+
+    SimWorld() {
+        for (int cz = -SIM_AREA / 2; cz < SIM_AREA / 2; cz++)
+            for (int cx = -SIM_AREA / 2; cx < SIM_AREA / 2; cx++)
+                for (int cy = WORLD_MIN_CHUNK_Y; cy <= WORLD_MAX_CHUNK_Y; cy++) {
+                    ChunkPos pos = { cx, cy, cz };
+                    auto chunk = std::make_unique<Chunk>();
+                    terrain.generate(pos, *chunk);
+                    world.insertChunk(pos, std::move(chunk));
+                    light.onChunkLoaded(pos);
+                }
+    }
+
+    glm::vec3 spawn() const {
+        return glm::vec3(0.5f, (float)std::max(terrain.surfaceHeight(0, 0), TerrainGenerator::SEA_LEVEL) + 3.0f, 0.5f);
+    }
+};
+
+// I comandi registrati: avanti girando piano e guardando in basso, un
+// tratto di lato, un colpo ogni 15 tick alternando rompi e piazza,
+// le creature al primo tick
+PlayerInput scriptedInput(int tick) {
+    PlayerInput input;
+    input.yaw   = -90.0f + tick * 0.5f;
+    input.pitch = -35.0f;
+    input.moves = 1 << FORWARD;
+    if (tick >= 200 && tick < 300) input.moves |= 1 << LEFT;
+    input.breakBlock = tick % 15 == 0;
+    input.placeBlock = tick % 15 == 7;
+    input.block      = (BlockID)(1 + (tick / 15) % (BLOCK_COUNT - 1));
+    input.spawnMobs  = tick == 1;
+    return input;
+}
+
+// FNV-1a sui byte: due float uguali al bit danno lo stesso hash
+void hashBytes(uint64_t& hash, const void* data, size_t size) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    for (size_t i = 0; i < size; i++) hash = (hash ^ bytes[i]) * 1099511628211ull;
+}
+
+uint64_t hashSnapshot(const SimSnapshot& snapshot) {
+    uint64_t hash = 14695981039346656037ull;
+    hashBytes(hash, &snapshot.eye, sizeof(snapshot.eye));
+    hashBytes(hash, &snapshot.target.block, sizeof(snapshot.target.block));
+    hashBytes(hash, &snapshot.target.hit, sizeof(snapshot.target.hit));
+    if (!snapshot.instances.empty())
+        hashBytes(hash, snapshot.instances.data(), snapshot.instances.size() * sizeof(InstanceData));
+    return hash;
+}
+
+struct ReplayResult {
+    uint64_t  hash = 0;
+    long long blocks = 0;
+    size_t    maxInstances = 0;
+    float     travelled = 0.0f;
+};
+
+ReplayResult replay(std::vector<double>* tickTimes, JobSystem* jobs) {
+    SimWorld sim;
+    long long blocksBefore = sim.world.blockCount();
+    Simulation simulation(sim.world, sim.light, sim.spawn(), 60, jobs);
+
+    ReplayResult result;
+    SimSnapshot snapshot;
+    for (int tick = 0; tick < SIM_TICKS; tick++) {
+        auto start = Clock::now();
+        simulation.tick(scriptedInput(tick));
+        simulation.fillSnapshot(snapshot);
+        if (tickTimes) tickTimes->push_back(secondsSince(start));
+
+        uint64_t tickHash = hashSnapshot(snapshot);
+        hashBytes(result.hash, &tickHash, sizeof(tickHash));
+        result.maxInstances = std::max(result.maxInstances, snapshot.instances.size());
+    }
+    result.blocks    = sim.world.blockCount() - blocksBefore;
+    result.travelled = glm::length(simulation.player().position - sim.spawn());
+    return result;
+}
+
+} // namespace
+
+static void benchReplay(BenchContext& ctx) {
+    std::vector<double> tickTimes;
+    JobSystem jobs;
+    ReplayResult first  = replay(&tickTimes, nullptr);
+    ReplayResult second = replay(nullptr, &jobs);
+    ctx.latency("headless tick (player, edits, debris, mobs, snapshot)", std::move(tickTimes));
+    ctx.value("debris and mobs at peak", (double)first.maxInstances, "instances");
+
+    ctx.check(first.travelled > 5.0f && first.maxInstances > 0, "the scripted player moves and breaks blocks");
+    ctx.check(first.hash == second.hash && first.blocks == second.blocks,
+              "replaying the same inputs gives the same state every tick");
+}
+
+static void benchThreaded(BenchContext& ctx) {
+    SimWorld sim;
+    std::mutex worldMutex;
+    Simulation simulation(sim.world, sim.light, sim.spawn());
+    SimulationThread thread(simulation, worldMutex);
+
+    // In volo (noclip) dritti verso +x: la camera può solo avanzare
+    PlayerInput input;
+    input.yaw          = 0.0f;
+    input.pitch        = 0.0f;
+    input.moves        = 1 << FORWARD;
+    input.toggleNoclip = true;
+    thread.submit(input);
+    input.toggleNoclip = false;
+
+    std::vector<InstanceData> instances;
+    std::vector<ChunkPos> stale;
+    std::vector<double> frameTimes;
+    int backwards = 0, busyFrames = 0, frames = 0;
+    float lastX = -1e9f;
+
+    auto renderFor = [&](double seconds, std::chrono::milliseconds gpuTime) {
+        auto end = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+        while (Clock::now() < end) {
+            auto start = Clock::now();
+            input.breakBlock = frames % 20 == 0; // frammenti da interpolare
+            thread.submit(input);
+            if (const SimSnapshot* snapshot = thread.latest()) {
+                float alpha = thread.alpha(*snapshot, Clock::now());
+                float x = snapshot->eyeAt(alpha).x;
+                backwards += x < lastX - 1e-4f;
+                lastX = x;
+                snapshot->interpolateInstances(alpha, instances);
+            }
+            // Il lavoro sul mondo del game loop, solo se il tick non lo usa
+            if (std::unique_lock worldLock{ worldMutex, std::try_to_lock }) sim.world.takeMeshDirtyChunks(stale);
+            else busyFrames++;
+            frameTimes.push_back(secondsSince(start));
+            frames++;
+            std::this_thread::sleep_for(gpuTime); // la GPU e lo swap
+        }
+    };
+
+    renderFor(0.5, std::chrono::milliseconds(4));
+    ctx.latency("render thread frame (snapshot, interpolation)", std::move(frameTimes));
+    ctx.value("frames with the world busy", busyFrames, "frames");
+
+    // 20 FPS: i tick devono continuare a 60 al secondo
+    long long ticksBefore = thread.stats().ticks;
+    auto slowStart = Clock::now();
+    renderFor(1.0, std::chrono::milliseconds(50));
+    double tickRate = (thread.stats().ticks - ticksBefore) / secondsSince(slowStart);
+    thread.stop();
+
+    SimulationStats stats = thread.stats();
+    ctx.value("tick rate with a 20 FPS renderer", tickRate, "ticks/s");
+    ctx.value("worst tick", stats.worstTickMs, "ms");
+    ctx.check(tickRate > simulation.tickRate() * 0.9 && tickRate < simulation.tickRate() * 1.1,
+              "slow frames do not slow the simulation (" + std::to_string(tickRate) + " ticks/s)");
+    ctx.check(backwards == 0, "the interpolated camera never moves backwards (" + std::to_string(backwards) + " frames)");
+}
+
+void benchSimulation(BenchContext& ctx) {
+    benchReplay(ctx);
+    benchThreaded(ctx);
+}
@@ -0,0 +1,240 @@
+#include "bench.h"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "asset_loader.h"
+#include "chunk_pipeline.h"
+#include "job_system.h"
+#include "light.h"
+#include "material.h"
+#include "program_cache.h"
+#include "terrain.h"
+#include "world_storage.h"
+
+// ---------------------------------------------------------------
+// Avvio: le parti che si misurano senza GPU.
+//
+// 1) ProgramCache: un binario da 256 KB (la taglia di un program vero
+//    su molti driver) scritto e riletto dal disco. Chiavi diverse per
+//    driver e sorgenti diversi; file troncati, rovinati o rifiutati
+//    dal driver sono miss, mai binari sbagliati.
+//
+// 2) Tempo fino a "giocabile", come in main ma senza finestra: i
+//    compiti dell'AssetLoader e il terreno attorno allo spawn, generato
+//    (mondo nuovo) o letto dai region file (mondo salvato), illuminato
+//    e meshato dalla ChunkPipeline. Il "render thread" fa un frame ogni
+//    millisecondo finché tutte le colonne entro il raggio hanno la mesh.
+//    Con 1 worker e con quelli di default.
+// ---------------------------------------------------------------
+
+static const int      SPAWN_RADIUS   = 2;   // come SPAWN_READY_RADIUS in main
+static const uint32_t STARTUP_SEED   = 1337;
+static const double   STARTUP_TIMEOUT = 60.0;
+
+namespace {
+
+struct StartupRun {
+    double   assetsSeconds   = 0.0; // compiti dell'AssetLoader, dal primo all'ultimo
+    double   playableSeconds = 0.0;
+    int      frames          = 0;
+    int      workers         = 0;
+    bool     assetsOk        = false;
+    bool     playable        = false;
+    uint64_t spawnHash       = 0;   // dei chunk attorno allo spawn
+};
+
+StartupRun runStartup(int workers, const std::string& directory) {
+    StartupRun run;
+    auto start = Clock::now();
+
+    JobSystem         jobs(workers);
+    run.workers = jobs.workerCount();
+    TextureArrayImage images;
+    MaterialUniforms  materials;
+    AssetLoader       assets(jobs);
+    assets.add("block textures", [&images] { images = generateBlockTextures(); return true; });
+    assets.add("materials", [&materials] { materials = buildMaterialUniforms(); return true; });
+
+    World            world;
+    WorldStorage     storage(jobs, directory);
+    TerrainGenerator terrain(STARTUP_SEED);
+    ChunkPipeline    pipeline(jobs, world, [&terrain, &storage](const ChunkPos& pos, Chunk& chunk) {
+        if (storage.loadChunk(pos, chunk)) return;
+        terrain.generate(pos, chunk);
+        storage.saveChunk(pos, chunk);
+    });
+    LightEngine light(world);
+    pipeline.setInsertedCallback([&light](const ChunkPos& pos) { light.onChunkLoaded(pos); });
+
+    // Un anello in più: le colonne sul bordo si meshano solo con i vicini
+    const glm::vec3 spawn(0.5f, (float)terrain.surfaceHeight(0, 0) + 3.0f, 0.5f);
+    for (int cz = -SPAWN_RADIUS - 1; cz <= SPAWN_RADIUS + 1; cz++)
+        for (int cx = -SPAWN_RADIUS - 1; cx <= SPAWN_RADIUS + 1; cx++)
+            for (int cy = WORLD_MIN_CHUNK_Y; cy <= WORLD_MAX_CHUNK_Y; cy++) pipeline.requestChunk({ cx, cy, cz });
+
+    auto spawnReady = [&pipeline] {
+        for (int cz = -SPAWN_RADIUS; cz <= SPAWN_RADIUS; cz++)
+            for (int cx = -SPAWN_RADIUS; cx <= SPAWN_RADIUS; cx++)
+                if (!pipeline.isColumnMeshed(cx, cz)) return false;
+        return true;
+    };
+
+    while (secondsSince(start) < STARTUP_TIMEOUT) {
+        pipeline.update(spawn);
+        pipeline.consumeMeshes([](const ChunkPos&, const ChunkMesh&) {}, 1 << 20);
+        run.frames++;
+        if (assets.done() && spawnReady()) {
+            run.playable = true;
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    run.playableSeconds = secondsSince(start);
+    assets.wait();
+    run.assetsSeconds = assets.seconds();
+    run.assetsOk      = !assets.failed() && !images.levels.empty();
+
+    uint64_t hash = 14695981039346656037ull;
+    std::vector<uint8_t> bytes;
+    for (int cz = -SPAWN_RADIUS; cz <= SPAWN_RADIUS; cz++)
+        for (int cx = -SPAWN_RADIUS; cx <= SPAWN_RADIUS; cx++)
+            for (int cy = WORLD_MIN_CHUNK_Y; cy <= WORLD_MAX_CHUNK_Y; cy++) {
+                const Chunk* chunk = world.findChunk({ cx, cy, cz });
+                if (!chunk) continue;
+                bytes.clear();
+                chunk->serialize(bytes);
+                for (uint8_t b : bytes) hash = (hash ^ b) * 1099511628211ull;
+            }
+    run.spawnHash = hash;
+
+    // I worker finiscono quello che resta (l'anello esterno) prima di chiudere
+    jobs.waitIdle();
+    storage.flush();
+    return run;
+}
+
+// L'unico file .bin della cartella
+std::string onlyBinary(const std::string& directory) {
+    for (const auto& entry : std::filesystem::directory_iterator(directory))
+        if (entry.path().extension() == ".bin") return entry.path().string();
+    return {};
+}
+
+void benchProgramCache(BenchContext& ctx) {
+    std::string directory = (std::filesystem::temp_directory_path() / "voxel_bench_shader_cache").string();
+    std::filesystem::remove_all(directory);
+
+    const std::string driver = "Bench Vendor | Bench Renderer | 4.6.0";
+    const std::string vertex = "#version 330 core\nlayout(location = 0) in vec3 position;\nvoid main() {}\n";
+    const std::string fragment = "#version 330 core\nout vec4 color;\nvoid main() { color = vec4(1.0); }\n";
+
+    ProgramCache cache(directory, driver);
+    ProgramBinary binary;
+    binary.format = 0x8741; // un valore qualsiasi: il formato lo sceglie il driver
+    binary.data.resize(256 * 1024);
+    uint32_t rng = 99;
+    for (uint8_t& b : binary.data) b = (uint8_t)xorshift(rng);
+
+    uint64_t key = cache.keyOf(vertex, fragment);
+    ProgramBinary loaded;
+    ctx.check(!cache.load(key, loaded), "an empty cache is a miss");
+
+    std::vector<double> storeSamples, loadSamples;
+    bool stored = true, same = true;
+    for (int i = 0; i < 20; i++) {
+        auto start = Clock::now();
+        stored &= cache.store(key, binary);
+        storeSamples.push_back(secondsSince(start));
+    }
+    for (int i = 0; i < 100; i++) {
+        auto start = Clock::now();
+        same &= cache.load(key, loaded) && loaded.format == binary.format && loaded.data == binary.data;
+        loadSamples.push_back(secondsSince(start));
+    }
+    ctx.latency("store 256 KB program binary", storeSamples);
+    ctx.latency("load 256 KB program binary", loadSamples);
+    ctx.check(stored && same, "a stored program binary loads back identical");
+
+    ProgramCache otherDriver(directory, "Bench Vendor | Bench Renderer | 4.6.1");
+    std::string edited = fragment;
+    edited[edited.size() - 4] = '5';
+    ctx.check(otherDriver.keyOf(vertex, fragment) != key, "another driver version gets another key");
+    ctx.check(cache.keyOf(vertex, edited) != key, "an edited shader gets another key");
+    ctx.check(cache.keyOf("ab", "c") != cache.keyOf("a", "bc"), "the key keeps vertex and fragment source apart");
+    ctx.check(!otherDriver.load(otherDriver.keyOf(vertex, fragment), loaded), "another driver misses the cached binary");
+
+    // File rovinati: un byte cambiato, poi troncato a metà
+    std::string path = onlyBinary(directory);
+    {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekg(4096);
+        char byte = (char)file.get();
+        file.seekp(4096);
+        file.put((char)(byte ^ 0x5A));
+    }
+    bool corruptMiss = !cache.load(key, loaded) && loaded.data.empty();
+    cache.store(key, binary);
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) / 2);
+    bool truncatedMiss = !cache.load(key, loaded);
+    ctx.check(corruptMiss, "a corrupted binary is a miss");
+    ctx.check(truncatedMiss, "a truncated binary is a miss");
+
+    // Il driver rifiuta il binario: il file sparisce e conta come miss
+    cache.store(key, binary);
+    int missesBefore = cache.misses();
+    ctx.check(cache.load(key, loaded), "a rewritten binary loads again");
+    cache.reject(key);
+    ctx.check(!std::filesystem::exists(path) && cache.rejected() == 1 && cache.misses() == missesBefore + 1,
+              "a binary rejected by the driver is deleted and counted as a miss");
+
+    std::filesystem::remove_all(directory);
+}
+
+} // namespace
+
+void benchStartup(BenchContext& ctx) {
+    benchProgramCache(ctx);
+
+    std::string directory = (std::filesystem::temp_directory_path() / "voxel_bench_startup").string();
+    struct Config {
+        const char* label;
+        int         workers;
+    };
+    const Config configs[] = { { "1 worker", 1 }, { "default workers", 0 } };
+
+    bool allPlayable = true, assetsOk = true, sameSpawn = true;
+    double newSerial = 0.0, newParallel = 0.0, savedParallel = 0.0;
+    for (const Config& config : configs) {
+        std::filesystem::remove_all(directory);
+        StartupRun fresh = runStartup(config.workers, directory);
+        StartupRun saved = runStartup(config.workers, directory);
+        std::string label = config.workers == 0
+            ? "default workers (" + std::to_string(fresh.workers) + ")"
+            : config.label;
+
+        ctx.value("time to playable, new world, " + label, fresh.playableSeconds * 1000.0, "ms");
+        ctx.value("time to playable, saved world, " + label, saved.playableSeconds * 1000.0, "ms");
+        ctx.value("asset tasks, " + label, fresh.assetsSeconds * 1000.0, "ms");
+        ctx.value("frames on the loading screen, new world, " + label, (double)fresh.frames, "frames");
+
+        allPlayable &= fresh.playable && saved.playable;
+        assetsOk    &= fresh.assetsOk && saved.assetsOk;
+        sameSpawn   &= fresh.spawnHash == saved.spawnHash;
+        if (config.workers == 1) newSerial = fresh.playableSeconds;
+        else {
+            newParallel   = fresh.playableSeconds;
+            savedParallel = saved.playableSeconds;
+        }
+    }
+    std::filesystem::remove_all(directory);
+
+    ctx.value("speedup over 1 worker, new world", newSerial / newParallel, "x");
+    ctx.value("saved world vs new world", newParallel / savedParallel, "x");
+    ctx.check(allPlayable, "every startup reaches a meshed spawn area");
+    ctx.check(assetsOk, "every asset task succeeds");
+    ctx.check(sameSpawn, "a saved world loads the same spawn area it generated");
+}
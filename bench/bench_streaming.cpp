@@ -0,0 +1,155 @@
+#include "bench.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <thread>
+
+#include "chunk_streamer.h"
+#include "culling.h"
+#include "job_system.h"
+#include "light.h"
+#include "terrain.h"
+
+// ---------------------------------------------------------------
+// Streaming: un volo veloce (60 blocchi/s) dritto per 6 secondi, poi
+// indietro per altri 6, con budget di memoria piccoli. Il ChunkStreamer
+// fa quello che fa nel gioco: chiede i chunk attorno alla camera e
+// dove sta andando, lavora al più frameBudget per frame e scarica le
+// colonne lontane quando CPU o GPU superano il budget. Al ritorno le
+// colonne scaricate vanno rigenerate e rimeshate.
+//
+// Il volo si fa due volte, senza e con la previsione: si misurano il
+// tempo del frame, i chunk della regione attorno alla camera ancora
+// senza mesh (i "buchi" che si vedrebbero) e la memoria rispetto ai
+// budget. Alla fine, fermi, la regione deve essere tutta meshata e la
+// memoria dentro i budget.
+// ---------------------------------------------------------------
+static const int   STREAM_RADIUS = 6;     // colonne attorno alla camera
+static const int   STREAM_FRAMES = 720;
+static const float STREAM_DELTA  = 1.0f / 60.0f;
+static const float STREAM_SPEED  = 60.0f; // blocchi/s
+
+static ColumnRegion regionAround(const glm::vec3& position) {
+    glm::ivec2 c((int)std::floor(position.x) >> CHUNK_SHIFT, (int)std::floor(position.z) >> CHUNK_SHIFT);
+    return { c - STREAM_RADIUS, c + STREAM_RADIUS };
+}
+
+// Chunk delle colonne interne della regione (senza il bordo, che serve
+// solo al meshing dei vicini) che non hanno ancora una mesh
+static int unmeshedChunks(const ChunkPipeline& pipeline, const ColumnRegion& region) {
+    int missing = 0;
+    for (int z = region.min.y + 1; z < region.max.y; z++)
+        for (int x = region.min.x + 1; x < region.max.x; x++)
+            for (int y = WORLD_MIN_CHUNK_Y; y <= WORLD_MAX_CHUNK_Y; y++) missing += !pipeline.isMeshed({ x, y, z });
+    return missing;
+}
+
+static void fly(BenchContext& ctx, const std::string& label, float lookAhead) {
+    World world;
+    JobSystem jobs;
+    TerrainGenerator terrain(1337);
+    ChunkPipeline pipeline(jobs, world, [&terrain](const ChunkPos& pos, Chunk& chunk) {
+        terrain.generate(pos, chunk);
+    });
+    LightEngine light(world);
+    pipeline.setInsertedCallback([&light](const ChunkPos& pos) { light.onChunkLoaded(pos); });
+
+    StreamingSettings settings;
+    settings.lookAhead   = lookAhead;
+    settings.cpuBudget   = 4u << 20;
+    settings.gpuBudget   = 16u << 20;
+    settings.frameBudget = 0.004f;
+    ChunkStreamer streamer(world, pipeline, settings);
+
+    ChunkCuller culler;
+    std::vector<ChunkPos> visible, stale, evicted;
+    size_t gpuBytes = 0; // come la vedrebbe il ChunkRenderer
+    std::unordered_map<ChunkPos, size_t, ChunkPosHash> uploaded;
+
+    auto frameWork = [&](const glm::vec3& position, float delta) {
+        streamer.update(position, delta, regionAround(position));
+        world.takeMeshDirtyChunks(stale);
+        for (const ChunkPos& pos : stale) pipeline.requestMesh(pos);
+        streamer.uploadMeshes([&](const ChunkPos& pos, const ChunkMesh& mesh) {
+            culler.setChunk(pos, mesh.visibility, !mesh.empty());
+            gpuBytes -= uploaded[pos];
+            uploaded[pos] = mesh.byteSize();
+            gpuBytes += mesh.byteSize();
+        }, 64);
+        streamer.takeEvictedMeshes(evicted);
+        for (const ChunkPos& pos : evicted) {
+            culler.removeChunk(pos);
+            gpuBytes -= uploaded[pos];
+            uploaded.erase(pos);
+        }
+    };
+    auto settle = [&](const glm::vec3& position) {
+        do {
+            frameWork(position, 0.0f);
+            std::this_thread::yield();
+        } while (!pipeline.isIdle());
+    };
+
+    glm::vec3 position(8.0f, 110.0f, 8.0f);
+    settle(position);
+
+    const auto frameBudget = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(STREAM_DELTA));
+    std::vector<double> frameTimes;
+    double unmeshedTotal = 0.0;
+    int framesOverBudget = 0, worstUnmeshed = 0;
+    size_t peakCpu = 0, peakGpu = 0;
+    auto deadline = Clock::now();
+    for (int frame = 0; frame < STREAM_FRAMES; frame++) {
+        deadline += frameBudget;
+
+        // Avanti lungo +x, poi indietro sulle colonne già scaricate
+        glm::vec3 direction(frame < STREAM_FRAMES / 2 ? 1.0f : -1.0f, 0.0f, 0.0f);
+        position += direction * (STREAM_SPEED * STREAM_DELTA);
+
+        auto frameStart = Clock::now();
+        frameWork(position, STREAM_DELTA);
+        glm::mat4 projection = glm::perspective(glm::radians(70.0f), 16.0f / 9.0f, 0.1f, 200.0f);
+        glm::mat4 view = glm::lookAt(position, position + direction + glm::vec3(0.0f, -0.3f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        culler.cull(Frustum::fromMatrix(projection * view), position, STREAM_RADIUS, visible);
+        streamer.touch(visible);
+        double frameSeconds = secondsSince(frameStart);
+        frameTimes.push_back(frameSeconds);
+        if (frameSeconds > STREAM_DELTA) framesOverBudget++;
+
+        int missing = unmeshedChunks(pipeline, regionAround(position));
+        unmeshedTotal += missing;
+        worstUnmeshed = std::max(worstUnmeshed, missing);
+        peakCpu = std::max(peakCpu, world.memoryUsage());
+        peakGpu = std::max(peakGpu, gpuBytes);
+
+        if (Clock::now() < deadline) std::this_thread::sleep_until(deadline);
+        else deadline = Clock::now();
+    }
+    StreamingStats stats = streamer.stats();
+
+    ctx.latency(label + ": main thread frame", std::move(frameTimes));
+    ctx.value(label + ": frames over 16.7 ms", framesOverBudget, "frames");
+    ctx.value(label + ": unmeshed chunks near camera", unmeshedTotal / STREAM_FRAMES, "chunks/frame");
+    ctx.value(label + ": unmeshed chunks near camera (max)", worstUnmeshed, "chunks");
+    ctx.value(label + ": peak world memory", peakCpu / (1024.0 * 1024.0), "MB");
+    ctx.value(label + ": peak mesh memory", peakGpu / (1024.0 * 1024.0), "MB");
+    ctx.value(label + ": columns evicted", (double)stats.evictedColumns, "columns");
+    ctx.value(label + ": meshes evicted", (double)stats.evictedMeshes, "meshes");
+
+    // Fermi: tutto quello attorno alla camera arriva, la memoria scende sotto i budget
+    for (int i = 0; i < 60; i++) frameWork(position, 1.0f / 60.0f);
+    settle(position);
+    int missing = unmeshedChunks(pipeline, regionAround(position));
+    ctx.check(stats.evictedColumns > 0 && stats.evictedMeshes > 0, label + ": small budgets evicted columns and meshes");
+    ctx.check(missing == 0, label + ": every chunk around the camera is meshed after settling (" + std::to_string(missing) + " missing)");
+    ctx.check(world.memoryUsage() <= settings.cpuBudget, label + ": world memory within the CPU budget");
+    ctx.check(gpuBytes <= settings.gpuBudget && gpuBytes == streamer.stats().gpuBytes,
+              label + ": mesh memory within the GPU budget and tracked exactly (" + std::to_string(gpuBytes) + " / "
+                  + std::to_string(streamer.stats().gpuBytes) + " bytes)");
+}
+
+void benchStreaming(BenchContext& ctx) {
+    fly(ctx, "no look-ahead", 0.0f);
+    fly(ctx, "look-ahead 1 s", 1.0f);
+}
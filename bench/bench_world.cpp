@@ -0,0 +1,354 @@
+#include "bench.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+#include "job_system.h"
+#include "noise.h"
+#include "region_file.h"
+#include "terrain.h"
+#include "world.h"
+#include "world_storage.h"
+
+// ---------------------------------------------------------------
+// Un chunk confrontato voxel per voxel con un array di BlockID: la
+// palette si allarga da 0 a 1, 2, 4, 8 e 16 bit (modalità diretta)
+// man mano che arrivano tipi nuovi, riusa la voce di un tipo sparito
+// e torna uniforme quando tutti i voxel sono dello stesso tipo
+// ---------------------------------------------------------------
+static void checkChunkPalette(BenchContext& ctx) {
+    std::vector<BlockID> reference(CHUNK_VOLUME, BLOCK_AIR);
+    auto chunk = std::make_unique<Chunk>();
+    auto sameAsReference = [&] {
+        for (int i = 0; i < CHUNK_VOLUME; i++)
+            if (chunk->getBlockAt(i) != reference[i]) return false;
+        return true;
+    };
+    auto set = [&](int i, BlockID id) {
+        chunk->setBlockAt(i, id);
+        reference[i] = id;
+    };
+
+    // Con n voci nella palette servono expectedBits(n) bit per voxel
+    auto expectedBits = [](int entries) {
+        return entries <= 1 ? 0 : entries <= 2 ? 1 : entries <= 4 ? 2 : entries <= 16 ? 4 : entries <= 256 ? 8 : 16;
+    };
+    bool widens = chunk->bitsPerBlock() == 0;
+    for (int types = 1; types <= 300; types++) {
+        set((types * 13) % CHUNK_VOLUME, (BlockID)types); // 13 e 4096 primi tra loro: posti tutti diversi
+        widens &= chunk->bitsPerBlock() == expectedBits(types + 1);
+    }
+    ctx.check(widens && chunk->bitsPerBlock() == 16 && sameAsReference(),
+              "the palette widens through 1, 2, 4, 8 and 16 bits and keeps every block");
+
+    // Casuale: 40 tipi (8 bit di palette) e l'aria
+    chunk = std::make_unique<Chunk>();
+    std::fill(reference.begin(), reference.end(), BLOCK_AIR);
+    uint32_t rng = 777;
+    for (int n = 0; n < 20000; n++) {
+        uint32_t r = xorshift(rng);
+        set((int)(r % CHUNK_VOLUME), (BlockID)((r >> 12) % 41));
+    }
+    ctx.check(sameAsReference(), "random writes read back exactly");
+
+    // Un tipo sparito lascia la sua voce al prossimo
+    chunk = std::make_unique<Chunk>();
+    std::fill(reference.begin(), reference.end(), BLOCK_AIR);
+    set(1, BLOCK_STONE);
+    set(2, BLOCK_DIRT);
+    set(3, BLOCK_SAND);
+    int entries = chunk->paletteSize(), bits = chunk->bitsPerBlock();
+    set(2, BLOCK_AIR);
+    set(4, BLOCK_GRASS);
+    ctx.check(chunk->paletteSize() == entries && chunk->bitsPerBlock() == bits && sameAsReference(),
+              "a palette entry is reused once its type is gone");
+
+    // Riempito voxel per voxel con un tipo solo: di nuovo uniforme
+    for (int i = 0; i < CHUNK_VOLUME; i++) set(i, BLOCK_STONE);
+    ctx.check(chunk->bitsPerBlock() == 0 && chunk->paletteSize() == 1 && sameAsReference(),
+              "a chunk filled with one type collapses to the uniform form");
+}
+
+// ---------------------------------------------------------------
+// Accesso ai blocchi: un mondo di 256x64x256 (4M blocchi, 1024 chunk)
+// letto e scritto in ordine sequenziale e in ordine casuale. Dopo le
+// scritture il mondo si rilegge tutto e si confronta con un array.
+// ---------------------------------------------------------------
+void benchBlockAccess(BenchContext& ctx) {
+    checkChunkPalette(ctx);
+
+    const int SIZE_XZ = 256;
+    const int SIZE_Y  = 64;
+    const long long volume = (long long)SIZE_XZ * SIZE_Y * SIZE_XZ;
+
+    World world;
+
+    // Scrittura sequenziale: alterniamo 4 tipi per avere palette non banali
+    auto start = Clock::now();
+    for (int y = 0; y < SIZE_Y; y++)
+        for (int z = 0; z < SIZE_XZ; z++)
+            for (int x = 0; x < SIZE_XZ; x++)
+                world.setBlock(x, y, z, (BlockID)(1 + ((x ^ y ^ z) & 3)));
+    ctx.throughput("set sequential", (double)volume, secondsSince(start));
+
+    // Lo stesso mondo in un array, per rileggerlo dopo le scritture
+    auto cell = [&](int x, int y, int z) { return ((size_t)y * SIZE_XZ + z) * SIZE_XZ + x; };
+    std::vector<BlockID> reference((size_t)volume);
+    for (int y = 0; y < SIZE_Y; y++)
+        for (int z = 0; z < SIZE_XZ; z++)
+            for (int x = 0; x < SIZE_XZ; x++) reference[cell(x, y, z)] = (BlockID)(1 + ((x ^ y ^ z) & 3));
+    auto worldMatches = [&] {
+        for (int y = 0; y < SIZE_Y; y++)
+            for (int z = 0; z < SIZE_XZ; z++)
+                for (int x = 0; x < SIZE_XZ; x++)
+                    if (world.getBlock(x, y, z) != reference[cell(x, y, z)]) return false;
+        return true;
+    };
+    ctx.check(worldMatches(), "sequential writes read back exactly");
+
+    // Lettura sequenziale: il checksum impedisce al compilatore
+    // di eliminare il ciclo perché "inutile"
+    uint64_t checksum = 0;
+    start = Clock::now();
+    for (int y = 0; y < SIZE_Y; y++)
+        for (int z = 0; z < SIZE_XZ; z++)
+            for (int x = 0; x < SIZE_XZ; x++)
+                checksum += world.getBlock(x, y, z);
+    ctx.throughput("get sequential", (double)volume, secondsSince(start));
+
+    uint32_t rng = 12345;
+    start = Clock::now();
+    for (long long i = 0; i < volume; i++) {
+        uint32_t r = xorshift(rng);
+        checksum += world.getBlock(r & (SIZE_XZ - 1), (r >> 8) & (SIZE_Y - 1), (r >> 16) & (SIZE_XZ - 1));
+    }
+    ctx.throughput("get random", (double)volume, secondsSince(start));
+
+    uint32_t writeSeed = rng;
+    start = Clock::now();
+    for (long long i = 0; i < volume; i++) {
+        uint32_t r = xorshift(rng);
+        world.setBlock(r & (SIZE_XZ - 1), (r >> 8) & (SIZE_Y - 1), (r >> 16) & (SIZE_XZ - 1), (BlockID)(r >> 28));
+    }
+    ctx.throughput("set random", (double)volume, secondsSince(start));
+
+    // Le stesse scritture casuali, rifatte sull'array
+    rng = writeSeed;
+    for (long long i = 0; i < volume; i++) {
+        uint32_t r = xorshift(rng);
+        reference[cell(r & (SIZE_XZ - 1), (r >> 8) & (SIZE_Y - 1), (r >> 16) & (SIZE_XZ - 1))] = (BlockID)(r >> 28);
+    }
+    ctx.check(worldMatches(), "random writes read back exactly");
+
+    ctx.value("world memory", world.memoryUsage() / (1024.0 * 1024.0), "MB");
+    ctx.note("chunks: %d, blocks: %lld (checksum %llu)",
+        world.chunkCount(), world.blockCount(), (unsigned long long)checksum);
+}
+
+// ---------------------------------------------------------------
+// Rumore: confronta i backend scalare, SSE4.1 e AVX2. Prima di
+// misurare controlla che diano risultati identici bit per bit a
+// quello scalare: se no lo scenario fallisce.
+// ---------------------------------------------------------------
+void benchNoise(BenchContext& ctx) {
+    const int COUNT = 1 << 16;
+    std::vector<float> x(COUNT), y(COUNT), z(COUNT), reference(COUNT), out(COUNT);
+    uint32_t rng = 987654321;
+    for (int i = 0; i < COUNT; i++) {
+        // Coordinate anche negative e non intere, come nel mondo vero
+        x[i] = (float)(int)(xorshift(rng) % 20000) * 0.37f - 3700.0f;
+        y[i] = (float)(xorshift(rng) % 128);
+        z[i] = (float)(int)(xorshift(rng) % 20000) * 0.37f - 3700.0f;
+    }
+
+    FractalParams params;
+    params.seed    = 1337;
+    params.octaves = 4;
+    fractalNoise3D(NoiseBackend::Scalar, params, x.data(), y.data(), z.data(), reference.data(), COUNT);
+
+    for (NoiseBackend backend : { NoiseBackend::Scalar, NoiseBackend::SSE41, NoiseBackend::AVX2 }) {
+        std::string name = noiseBackendName(backend);
+        if (!isNoiseBackendSupported(backend)) {
+            ctx.note("%s not supported by this CPU", name.c_str());
+            continue;
+        }
+
+        fractalNoise3D(backend, params, x.data(), y.data(), z.data(), out.data(), COUNT);
+        ctx.check(std::memcmp(out.data(), reference.data(), COUNT * sizeof(float)) == 0,
+            name + " noise is not bit-identical to scalar");
+
+        const int ITERATIONS = 20;
+        auto start = Clock::now();
+        for (int i = 0; i < ITERATIONS; i++)
+            fractalNoise3D(backend, params, x.data(), y.data(), z.data(), out.data(), COUNT);
+        ctx.throughput(name + " fractal noise (4 octaves)", (double)COUNT * ITERATIONS, secondsSince(start), "points");
+    }
+}
+
+// ---------------------------------------------------------------
+// Generazione del terreno: 8x8 colonne di chunk per backend, con il
+// tempo di ogni singolo chunk (i chunk di superficie costano più di
+// quelli d'aria sopra le montagne)
+// ---------------------------------------------------------------
+void benchGeneration(BenchContext& ctx) {
+    for (NoiseBackend backend : { NoiseBackend::Scalar, NoiseBackend::SSE41, NoiseBackend::AVX2 }) {
+        if (!isNoiseBackendSupported(backend)) continue;
+        std::string name = noiseBackendName(backend);
+
+        TerrainGenerator terrain(1337, backend);
+        Chunk chunk;
+        std::vector<double> samples;
+        auto start = Clock::now();
+        for (int cz = 0; cz < 8; cz++)
+            for (int cx = 0; cx < 8; cx++)
+                for (int cy = WORLD_MIN_CHUNK_Y; cy <= WORLD_MAX_CHUNK_Y; cy++) {
+                    auto chunkStart = Clock::now();
+                    chunk.fill(BLOCK_AIR);
+                    terrain.generate({ cx, cy, cz }, chunk);
+                    samples.push_back(secondsSince(chunkStart));
+                }
+        ctx.throughput(name + " generate", (double)samples.size(), secondsSince(start), "chunks");
+        ctx.latency(name + " generate per chunk", std::move(samples));
+    }
+}
+
+// ---------------------------------------------------------------
+// Salvataggio: round-trip dei chunk (serializzazione e region file,
+// anche dopo sovrascritture asincrone) e velocità di caricamento
+// dal disco rispetto alla generazione, con lo spazio occupato.
+// ---------------------------------------------------------------
+static bool sameBlocks(const Chunk& a, const Chunk& b) {
+    for (int i = 0; i < CHUNK_VOLUME; i++)
+        if (a.getBlockAt(i) != b.getBlockAt(i)) return false;
+    return a.solidCount() == b.solidCount();
+}
+
+void benchStorage(BenchContext& ctx) {
+    // 1) Serializzazione per ogni larghezza della palette, modalità diretta compresa
+    uint32_t rng = 777;
+    for (int types : { 1, 2, 3, 16, 200, 1000 }) {
+        Chunk chunk;
+        for (int i = 0; i < CHUNK_VOLUME; i++) chunk.setBlockAt(i, (BlockID)(xorshift(rng) % types));
+        std::vector<uint8_t> bytes;
+        chunk.serialize(bytes);
+        Chunk loaded;
+        ctx.check(loaded.deserialize(bytes.data(), bytes.size()) && sameBlocks(chunk, loaded) &&
+                  loaded.bitsPerBlock() == chunk.bitsPerBlock(),
+            "chunk serialization round trip with " + std::to_string(types) + " block types");
+    }
+
+    // 2) Region file: terreno vero salvato, riaperto e confrontato
+    const int AREA = 24;
+    std::string directory = (std::filesystem::temp_directory_path() / "voxel_bench_world").string();
+    std::filesystem::remove_all(directory);
+
+    World world;
+    TerrainGenerator terrain(1337);
+    auto start = Clock::now();
+    for (int cz = 0; cz < AREA; cz++)
+        for (int cx = 0; cx < AREA; cx++)
+            for (int cy = WORLD_MIN_CHUNK_Y; cy <= WORLD_MAX_CHUNK_Y; cy++)
+                terrain.generate({ cx, cy, cz }, world.getOrCreateChunk({ cx, cy, cz }));
+    double generateSeconds = secondsSince(start);
+    int chunkCount = world.chunkCount();
+
+    JobSystem jobs;
+    size_t diskBytes = 0;
+    {
+        WorldStorage storage(jobs, directory);
+        bool saved = true;
+        start = Clock::now();
+        world.forEachChunk([&](const ChunkPos& pos, const Chunk& chunk) {
+            saved = storage.saveChunk(pos, chunk) && saved;
+        });
+        ctx.throughput("save (compress + write)", chunkCount, secondsSince(start), "chunks");
+        ctx.check(saved, "saving chunks to the region files");
+        diskBytes = storage.diskUsage();
+    }
+
+    // Il caricamento usa una storage nuova: niente cache dalle scritture
+    {
+        WorldStorage storage(jobs, directory);
+        std::vector<ChunkPos> positions;
+        world.forEachChunk([&](const ChunkPos& pos, const Chunk&) { positions.push_back(pos); });
+        std::vector<Chunk> loaded(positions.size());
+
+        int mismatches = 0;
+        std::vector<double> samples;
+        start = Clock::now();
+        for (size_t i = 0; i < positions.size(); i++) {
+            auto chunkStart = Clock::now();
+            if (!storage.loadChunk(positions[i], loaded[i])) mismatches++;
+            samples.push_back(secondsSince(chunkStart));
+        }
+        double loadSeconds = secondsSince(start);
+
+        for (size_t i = 0; i < positions.size(); i++)
+            if (!sameBlocks(*world.getChunk(positions[i]), loaded[i])) mismatches++;
+        ctx.check(mismatches == 0, std::to_string(mismatches) + " chunks differ after a region file round trip");
+
+        Chunk missing;
+        ctx.check(!storage.loadChunk({ -5, 0, -5 }, missing), "loaded a chunk that was never saved");
+
+        ctx.throughput("generate", chunkCount, generateSeconds, "chunks");
+        ctx.throughput("load (map + decompress)", chunkCount, loadSeconds, "chunks");
+        ctx.latency("load per chunk", std::move(samples));
+        ctx.value("load speedup vs generate", generateSeconds / loadSeconds, "x");
+    }
+
+    ctx.value("disk usage per chunk", (double)diskBytes / chunkCount, "B");
+    ctx.value("memory usage per chunk", (double)world.memoryUsage() / chunkCount, "B");
+
+    // Un chunk risalvato della stessa misura non scrive sopra la copia
+    // vecchia: finché la tabella non cambia, quella resta intatta
+    {
+        std::string path = directory + "/rewrite.cvxr";
+        std::vector<uint8_t> first(600, 0x11), second(600, 0x22), third(600, 0x33);
+        auto fileHas = [&path](const std::vector<uint8_t>& payload) {
+            std::ifstream in(path, std::ios::binary);
+            std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            return std::search(bytes.begin(), bytes.end(), payload.begin(), payload.end()) != bytes.end();
+        };
+        RegionFile region;
+        bool written = region.open(path) && region.writeChunk(0, first.data(), 600, 4096)
+                    && region.writeChunk(0, second.data(), 600, 4096);
+        ctx.check(written && fileHas(first) && fileHas(second), "a rewritten chunk goes to new sectors");
+        size_t size = region.fileSize();
+        ctx.check(region.writeChunk(0, third.data(), 600, 4096) && region.fileSize() == size && !fileHas(first),
+                  "sectors freed by a rewrite are reused");
+    }
+
+    // 3) Modifiche salvate in background (più volte lo stesso chunk,
+    //    con chunk che crescono e cambiano settori) e ricaricate
+    {
+        WorldStorage storage(jobs, directory);
+        for (int round = 0; round < 3; round++) {
+            for (int i = 0; i < 2000; i++) {
+                int x = (int)(xorshift(rng) % (AREA * CHUNK_SIZE));
+                int y = (int)(xorshift(rng) % 128);
+                int z = (int)(xorshift(rng) % (AREA * CHUNK_SIZE));
+                world.setBlock(x, y, z, (BlockID)(1 + xorshift(rng) % (BLOCK_COUNT - 1)));
+            }
+            std::vector<ChunkPos> dirty;
+            world.takeDirtyChunks(dirty);
+            for (const ChunkPos& pos : dirty) storage.saveChunkAsync(pos, *world.getChunk(pos));
+        }
+        storage.flush();
+    }
+    {
+        WorldStorage storage(jobs, directory);
+        int mismatches = 0;
+        world.forEachChunk([&](const ChunkPos& pos, const Chunk& chunk) {
+            Chunk loaded;
+            if (!storage.loadChunk(pos, loaded) || !sameBlocks(chunk, loaded)) mismatches++;
+        });
+        ctx.check(mismatches == 0, std::to_string(mismatches) + " chunks differ after asynchronous rewrites");
+    }
+
+    std::filesystem::remove_all(directory);
+}
@@ -0,0 +1,28 @@
+#version 330 core
+// Lo usano sia i chunk (chunk.vert) che gli oggetti istanziati (instance.vert)
+flat in uint vFace;
+flat in uint vLayer;
+flat in vec4 vMaterial; // rgb = tinta, a = luce propria
+in vec2 vUV;
+in float vLight;
+in float vDistance;
+out vec4 FragColor;
+
+// Tutte le immagini dei blocchi, un layer ciascuna (vedi material.h)
+uniform sampler2DArray blockTextures;
+
+// Distanza a cui il terreno sparisce nel colore del cielo: nasconde
+// il bordo dell'ultimo livello LOD
+uniform float fogDistance;
+const vec3 skyColor = vec3(0.53, 0.81, 0.98);
+
+// Ogni faccia ha una luminosità fissa, così gli spigoli si distinguono
+const float faceShade[6] = float[6](0.8, 0.8, 1.0, 0.5, 0.65, 0.65);
+
+void main() {
+    vec3 albedo = texture(blockTextures, vec3(vUV, float(vLayer))).rgb * vMaterial.rgb;
+    float light = max(vLight, vMaterial.a);
+    vec3 color = albedo * mix(faceShade[vFace], 1.0, vMaterial.a) * light;
+    float fog = smoothstep(fogDistance * 0.6, fogDistance, vDistance);
+    FragColor = vec4(mix(color, skyColor, fog), 1.0);
+}
@@ -0,0 +1,60 @@
+#version 330 core
+// Vertice compatto (vedi packed_vertex.h): due uint da 32 bit
+layout (location = 0) in uint aPosition;   // x, y, z, faccia, AO
+layout (location = 1) in uint aAttributes; // layer texture, luce cielo, luce blocchi
+
+// Origine del chunk in blocchi e livello LOD: un valore per draw
+// (vedi chunk_renderer.h). Un nodo di livello L ha i vertici ogni 2^L blocchi.
+layout (location = 2) in ivec4 aChunkOrigin;
+
+// Dati della camera condivisi da tutti gli shader (vedi uniform_buffer.h)
+layout (std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+    vec4 cameraPosition;
+};
+
+// Tinta e luce propria di ogni layer della texture array (vedi material.h)
+layout (std140) uniform Materials {
+    vec4 materials[64];
+};
+
+flat out uint vFace;
+flat out uint vLayer;
+flat out vec4 vMaterial;
+out vec2 vUV;
+out float vLight;
+out float vDistance;
+
+void main() {
+    vec3 pos = vec3(
+        float(aPosition & 31u),
+        float((aPosition >> 5) & 31u),
+        float((aPosition >> 10) & 31u)
+    );
+    vFace  = (aPosition >> 15) & 7u;
+    uint ao = (aPosition >> 18) & 3u;
+
+    vLayer    = aAttributes & 0xFFFFu;
+    vMaterial = materials[min(vLayer, 63u)];
+    // La luce cala di un livello per blocco: ogni livello vale l'80% del
+    // successivo, così l'occhio la vede diminuire in modo uniforme
+    float skyLight   = pow(0.8, float(15u - ((aAttributes >> 16) & 15u)));
+    float blockLight = pow(0.8, float(15u - ((aAttributes >> 20) & 15u)));
+
+    // AO 0..3 → 0.55..1.0; la luce più forte tra cielo e blocchi
+    vLight = (0.55 + 0.15 * float(ao)) * max(max(skyLight, blockLight), 0.05);
+
+    vec3 worldPos = pos * float(1 << aChunkOrigin.w) + vec3(aChunkOrigin.xyz);
+    vDistance = length(worldPos.xz - cameraPosition.xz);
+
+    // UV in blocchi sul piano della faccia: la texture si ripete una
+    // volta per blocco anche sui quad lunghi del greedy meshing.
+    // La v scende con la y, così la riga 0 dell'immagine sta in alto.
+    uint axis = vFace >> 1;
+    vUV = axis == 0u ? vec2(worldPos.z, -worldPos.y)
+        : axis == 1u ? worldPos.xz
+        :              vec2(worldPos.x, -worldPos.y);
+
+    gl_Position = projection * view * vec4(worldPos, 1.0);
+}
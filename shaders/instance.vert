@@ -0,0 +1,56 @@
+#version 330 core
+// Cubo unitario centrato nell'origine (vedi instance_renderer.cpp)
+layout (location = 0) in vec3 aPosition;
+layout (location = 1) in uint aFace;
+
+// Per istanza (vedi instance_data.h)
+layout (location = 2) in vec4 aPositionScale; // centro, lato
+layout (location = 3) in vec4 aRotation;      // quaternione
+layout (location = 4) in uvec2 aMaterial;     // layer sopra/sotto/lati, luce
+
+layout (std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+    vec4 cameraPosition;
+};
+
+layout (std140) uniform Materials {
+    vec4 materials[64];
+};
+
+// Stesse uscite di chunk.vert: il fragment shader è chunk.frag
+flat out uint vFace;
+flat out uint vLayer;
+flat out vec4 vMaterial;
+out vec2 vUV;
+out float vLight;
+out float vDistance;
+
+// Rotazione con il quaternione q senza costruire una matrice
+vec3 rotate(vec4 q, vec3 v) {
+    return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+void main() {
+    vFace = aFace;
+    uint shift = aFace == 2u ? 0u : aFace == 3u ? 10u : 20u;
+    vLayer    = (aMaterial.x >> shift) & 1023u;
+    vMaterial = materials[min(vLayer, 63u)];
+
+    // Come chunk.vert, senza AO: il cubo è piccolo e staccato dal terreno
+    float skyLight   = pow(0.8, float(15u - ((aMaterial.y >> 4) & 15u)));
+    float blockLight = pow(0.8, float(15u - (aMaterial.y & 15u)));
+    vLight = max(max(skyLight, blockLight), 0.05);
+
+    // UV sul piano della faccia del cubo: l'immagine intera su ogni faccia
+    uint axis = vFace >> 1;
+    vec3 local = aPosition + 0.5;
+    vUV = axis == 0u ? vec2(local.z, 1.0 - local.y)
+        : axis == 1u ? local.xz
+        :              vec2(local.x, 1.0 - local.y);
+
+    vec3 worldPos = rotate(aRotation, aPosition * aPositionScale.w) + aPositionScale.xyz;
+    vDistance = length(worldPos.xz - cameraPosition.xz);
+
+    gl_Position = projection * view * vec4(worldPos, 1.0);
+}
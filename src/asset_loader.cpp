@@ -0,0 +1,91 @@
+#include "asset_loader.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "job_system.h"
+#include "profiler.h"
+
+bool readTextFile(const std::string& path, std::string& out) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Impossibile leggere " << path << "\n";
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    out = buffer.str();
+    return true;
+}
+
+AssetLoader::AssetLoader(JobSystem& jobs) : jobs(jobs) {}
+
+AssetLoader::~AssetLoader() {
+    wait();
+}
+
+void AssetLoader::add(std::string name, std::function<bool()> task) {
+    Task* entry;
+    {
+        std::lock_guard lock(mutex);
+        if (tasks.empty()) start = std::chrono::steady_clock::now();
+        entry = &tasks.emplace_back();
+        entry->timing.name = std::move(name);
+        entry->run = std::move(task);
+    }
+
+    jobs.submit([this, entry] {
+        PROFILE_SCOPE("Load asset");
+        auto taskStart = std::chrono::steady_clock::now();
+        bool ok = entry->run();
+        auto taskEnd = std::chrono::steady_clock::now();
+
+        std::lock_guard lock(mutex);
+        entry->timing.seconds = std::chrono::duration<double>(taskEnd - taskStart).count();
+        entry->timing.ok      = ok;
+        entry->end            = taskEnd;
+        entry->run            = nullptr; // le catture (riferimenti, buffer) non servono più
+        if (++finishedCount == (int)tasks.size()) allDone.notify_all();
+    });
+}
+
+int AssetLoader::total() const {
+    std::lock_guard lock(mutex);
+    return (int)tasks.size();
+}
+
+int AssetLoader::finished() const {
+    std::lock_guard lock(mutex);
+    return finishedCount;
+}
+
+float AssetLoader::progress() const {
+    std::lock_guard lock(mutex);
+    return tasks.empty() ? 1.0f : (float)finishedCount / (float)tasks.size();
+}
+
+void AssetLoader::wait() {
+    std::unique_lock lock(mutex);
+    allDone.wait(lock, [this] { return finishedCount == (int)tasks.size(); });
+}
+
+bool AssetLoader::failed() const {
+    std::lock_guard lock(mutex);
+    return std::any_of(tasks.begin(), tasks.end(), [](const Task& task) { return !task.timing.ok; });
+}
+
+std::vector<AssetTiming> AssetLoader::timings() const {
+    std::lock_guard lock(mutex);
+    std::vector<AssetTiming> result;
+    for (const Task& task : tasks) result.push_back(task.timing);
+    return result;
+}
+
+double AssetLoader::seconds() const {
+    std::lock_guard lock(mutex);
+    TimePoint end = start;
+    for (const Task& task : tasks) end = std::max(end, task.end);
+    return std::chrono::duration<double>(end - start).count();
+}
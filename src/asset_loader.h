@@ -0,0 +1,88 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class JobSystem;
+
+// Legge tutto un file di testo; false (con un messaggio) se non si apre
+bool readTextFile(const std::string& path, std::string& out);
+
+// Tempo di un compito di caricamento, per la console e il bench
+struct AssetTiming {
+    std::string name;
+    double      seconds = 0.0;
+    bool        ok      = false;
+};
+
+// Tempi dell'avvio in secondi, dall'inizio del programma
+struct StartupStats {
+    double firstFrame  = 0.0; // primo frame a schermo (la schermata di caricamento)
+    double assetsReady = 0.0; // shader e texture pronti sulla GPU
+    double playable    = 0.0; // terreno attorno allo spawn pronto, si gioca
+    int    shadersFromCache = 0;
+    int    shadersCompiled  = 0;
+};
+
+// ---------------------------------------------------------------
+// AssetLoader
+// Quello che serve prima di poter giocare (sorgenti degli shader,
+// immagini dei blocchi, materiali...) si prepara sui worker, un job
+// per compito, mentre il render thread resta libero di disegnare la
+// schermata di caricamento e di raccogliere il terreno che intanto
+// si genera. Ogni compito scrive il risultato in una variabile del
+// chiamante, che la legge solo dopo done(): il mutex di done() fa da
+// barriera tra la scrittura sul worker e la lettura.
+//
+// Il caricamento sulla GPU (compilare gli shader, creare le texture)
+// resta al render thread, l'unico con il contesto OpenGL.
+// ---------------------------------------------------------------
+class AssetLoader {
+public:
+    explicit AssetLoader(JobSystem& jobs);
+
+    // Aspetta i compiti ancora in corso: scrivono in variabili del chiamante
+    ~AssetLoader();
+
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader& operator=(const AssetLoader&) = delete;
+
+    // Un compito: task gira su un worker e restituisce false se fallisce
+    void add(std::string name, std::function<bool()> task);
+
+    int   total() const;
+    int   finished() const;
+    float progress() const; // 0..1
+    bool  done() const { return finished() == total(); }
+
+    // Blocca finché tutti i compiti sono finiti
+    void wait();
+
+    // Dopo done(): almeno un compito fallito, tempi per compito e
+    // dal primo add all'ultimo compito finito
+    bool   failed() const;
+    std::vector<AssetTiming> timings() const;
+    double seconds() const;
+
+private:
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+    struct Task {
+        AssetTiming           timing;
+        std::function<bool()> run;
+        TimePoint             end{};
+    };
+
+    JobSystem& jobs;
+
+    mutable std::mutex      mutex;
+    std::condition_variable allDone;
+    std::deque<Task>        tasks; // deque: gli indirizzi restano validi mentre si aggiunge
+    int                     finishedCount = 0;
+    TimePoint               start{};
+};
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <cstdint>
+
+// ---------------------------------------------------------------
+// Tipi di blocco
+// Ogni voxel del mondo è identificato da un BlockID a 16 bit:
+// bastano per 65536 tipi diversi e occupano metà di un int.
+// ---------------------------------------------------------------
+using BlockID = uint16_t;
+
+// Livelli dei fluidi che scorrono: da 1 (il velo più sottile, in fondo
+// alla colata) a FLUID_LEVELS (appena uscito dalla sorgente, o in
+// caduta). La sorgente, BLOCK_WATER o BLOCK_LAVA, vale uno in più.
+constexpr int FLUID_LEVELS = 7;
+constexpr int SOURCE_LEVEL = FLUID_LEVELS + 1;
+
+// L'aria è sempre 0: un chunk appena creato (tutto a zero) è vuoto.
+enum BlockType : BlockID {
+    BLOCK_AIR = 0,
+    BLOCK_STONE,
+    BLOCK_DIRT,
+    BLOCK_GRASS,
+    BLOCK_SAND,
+    BLOCK_WATER,
+    BLOCK_LAMP,
+    BLOCK_LAVA,
+
+    // Acqua e lava che scorrono, un tipo per livello (1..FLUID_LEVELS)
+    BLOCK_WATER_FLOW,
+    BLOCK_LAVA_FLOW = BLOCK_WATER_FLOW + FLUID_LEVELS,
+
+    BLOCK_COUNT = BLOCK_LAVA_FLOW + FLUID_LEVELS // non è un blocco: serve solo a contare quanti tipi esistono
+};
+
+// Luce massima, sia del cielo che dei blocchi: 4 bit
+constexpr int MAX_LIGHT = 15;
+
+// Quanti BlockID hanno una voce nelle tabelle delle proprietà: i tipi
+// di BlockType più quelli registrati a runtime (block_registry.h)
+constexpr int MAX_BLOCK_TYPES = 4096;
+
+// ---------------------------------------------------------------
+// Proprietà di un tipo di blocco. Quelle dei tipi di BlockType sono
+// scritte qui sotto e diventano tabelle a compile time; un BlockID
+// che nessuno ha definito è pieno e opaco, come la pietra.
+// ---------------------------------------------------------------
+struct BlockInfo {
+    const char* name     = "unknown";
+    bool        solid    = true;  // lo colpiscono raycast e collisioni
+    bool        opaque   = true;  // nasconde le facce accanto e ferma la luce
+    bool        falls    = false; // cade se sotto c'è aria o un fluido
+    uint8_t     emission = 0;     // luce emessa, 0..MAX_LIGHT
+};
+
+constexpr BlockInfo builtinBlockInfo(BlockID id) {
+    // Acqua e lava (anche quando scorrono) per ora sono piene e opache
+    // come il resto: il renderer non ha ancora una passata trasparente
+    if (id >= BLOCK_WATER_FLOW && id < BLOCK_LAVA_FLOW) return { "flowing water" };
+    if (id >= BLOCK_LAVA_FLOW && id < BLOCK_COUNT) return { "flowing lava", true, true, false, MAX_LIGHT };
+    switch (id) {
+    case BLOCK_AIR:   return { "air", false, false };
+    case BLOCK_STONE: return { "stone" };
+    case BLOCK_DIRT:  return { "dirt" };
+    case BLOCK_GRASS: return { "grass" };
+    case BLOCK_SAND:  return { "sand", true, true, true };
+    case BLOCK_WATER: return { "water" };
+    case BLOCK_LAMP:  return { "lamp", true, true, false, MAX_LIGHT };
+    case BLOCK_LAVA:  return { "lava", true, true, false, MAX_LIGHT };
+    default:          return {};
+    }
+}
+
+// ---------------------------------------------------------------
+// Tabelle dense delle proprietà, una voce per BlockID
+// Mesher, luce, raycast e collisioni chiedono "è opaco?" o "è pieno?"
+// nei loro cicli più interni, milioni di volte per chunk: qui è un bit
+// in un bitset indicizzato dal BlockID, un load e uno shift, senza
+// switch, chiamate virtuali o mappe. Un bitset da 4096 tipi sono 512
+// byte: stanno in cache tutti insieme.
+//
+// BUILTIN_BLOCK_PROPERTIES è calcolata dal compilatore a partire da
+// builtinBlockInfo; blockProperties ne è una copia inizializzata a
+// compile time (constinit: niente costruttori all'avvio), che
+// registerBlock estende con i tipi definiti a runtime.
+// ---------------------------------------------------------------
+struct BlockPropertyTables {
+    uint64_t solid[MAX_BLOCK_TYPES / 64]  = {};
+    uint64_t opaque[MAX_BLOCK_TYPES / 64] = {};
+    uint64_t falls[MAX_BLOCK_TYPES / 64]  = {};
+    uint8_t  emission[MAX_BLOCK_TYPES]    = {};
+
+    constexpr void set(BlockID id, const BlockInfo& info) {
+        uint64_t bit = uint64_t(1) << (id & 63);
+        int word = id >> 6;
+        solid[word]  = info.solid  ? solid[word] | bit  : solid[word] & ~bit;
+        opaque[word] = info.opaque ? opaque[word] | bit : opaque[word] & ~bit;
+        falls[word]  = info.falls  ? falls[word] | bit  : falls[word] & ~bit;
+        emission[id] = info.emission;
+    }
+};
+
+constexpr BlockPropertyTables makeBuiltinBlockProperties() {
+    BlockPropertyTables tables;
+    for (int id = 0; id < MAX_BLOCK_TYPES; id++) tables.set((BlockID)id, builtinBlockInfo((BlockID)id));
+    return tables;
+}
+
+inline constexpr BlockPropertyTables BUILTIN_BLOCK_PROPERTIES = makeBuiltinBlockProperties();
+inline constinit BlockPropertyTables blockProperties = BUILTIN_BLOCK_PROPERTIES;
+
+// Il bit di id in un bitset delle tabelle. Un ID oltre la tabella
+// (dati rovinati) viene ripiegato dentro invece di leggere fuori.
+constexpr bool blockBit(const uint64_t* bits, BlockID id) {
+    id &= MAX_BLOCK_TYPES - 1;
+    return (bits[id >> 6] >> (id & 63)) & 1;
+}
+
+static_assert(!blockBit(BUILTIN_BLOCK_PROPERTIES.solid, BLOCK_AIR) && !blockBit(BUILTIN_BLOCK_PROPERTIES.opaque, BLOCK_AIR),
+              "l'aria non deve fermare né la luce né il giocatore");
+static_assert(blockBit(BUILTIN_BLOCK_PROPERTIES.opaque, BLOCK_STONE) && blockBit(BUILTIN_BLOCK_PROPERTIES.falls, BLOCK_SAND),
+              "pietra opaca, sabbia che cade");
+static_assert(BUILTIN_BLOCK_PROPERTIES.emission[BLOCK_LAVA_FLOW + FLUID_LEVELS - 1] == MAX_LIGHT,
+              "la lava emette luce a ogni livello");
+static_assert(BLOCK_COUNT <= MAX_BLOCK_TYPES, "troppi tipi per le tabelle delle proprietà");
+
+// Un blocco "pieno" lo colpiscono raycast e collisioni
+inline bool isSolid(BlockID id) { return blockBit(blockProperties.solid, id); }
+
+// Un blocco opaco nasconde le facce dei vicini e ferma la luce
+inline bool isOpaque(BlockID id) { return blockBit(blockProperties.opaque, id); }
+
+// Blocchi che cadono se sotto c'è aria o un fluido
+inline bool fallsDown(BlockID id) { return blockBit(blockProperties.falls, id); }
+
+// Luce emessa dal blocco (0 = nessuna)
+inline int blockEmission(BlockID id) { return blockProperties.emission[id & (MAX_BLOCK_TYPES - 1)]; }
+
+// Nome leggibile, per il pannello di debug (anche dei tipi registrati
+// a runtime: è definita in block_registry.cpp)
+const char* blockName(BlockID id);
+
+// ---------------------------------------------------------------
+// Fluidi: la sorgente e i suoi livelli che scorrono sono lo stesso
+// fluido. Li muove BlockUpdateSystem.
+// ---------------------------------------------------------------
+constexpr bool isFluid(BlockID id) {
+    return id == BLOCK_WATER || id == BLOCK_LAVA || (id >= BLOCK_WATER_FLOW && id < BLOCK_COUNT);
+}
+
+// La sorgente del fluido (BLOCK_AIR se non è un fluido)
+constexpr BlockID fluidSource(BlockID id) {
+    if (id == BLOCK_WATER || id == BLOCK_LAVA) return id;
+    if (id >= BLOCK_WATER_FLOW && id < BLOCK_LAVA_FLOW) return BLOCK_WATER;
+    if (id >= BLOCK_LAVA_FLOW && id < BLOCK_COUNT) return BLOCK_LAVA;
+    return BLOCK_AIR;
+}
+
+// SOURCE_LEVEL per la sorgente, 1..FLUID_LEVELS per chi scorre, 0 per il resto
+constexpr int fluidLevel(BlockID id) {
+    if (id == BLOCK_WATER || id == BLOCK_LAVA) return SOURCE_LEVEL;
+    if (id >= BLOCK_WATER_FLOW && id < BLOCK_LAVA_FLOW) return id - BLOCK_WATER_FLOW + 1;
+    if (id >= BLOCK_LAVA_FLOW && id < BLOCK_COUNT) return id - BLOCK_LAVA_FLOW + 1;
+    return 0;
+}
+
+// Il blocco del fluido source al livello level (aria sotto 1)
+constexpr BlockID fluidBlock(BlockID source, int level) {
+    if (level <= 0) return BLOCK_AIR;
+    if (level >= SOURCE_LEVEL) return source;
+    return (BlockID)((source == BLOCK_LAVA ? BLOCK_LAVA_FLOW : BLOCK_WATER_FLOW) + level - 1);
+}
@@ -0,0 +1,193 @@
+#include "block_registry.h"
+
+#include <algorithm>
+#include <charconv>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+
+#include "asset_loader.h"
+
+// Nomi dei tipi registrati a runtime, a partire da BLOCK_COUNT. Una
+// deque non sposta gli elementi quando cresce: i const char* dati da
+// blockName restano validi.
+static std::deque<std::string> runtimeNames;
+
+// Nomi dei layer per i file di definizione, nell'ordine di TextureLayer
+static const char* const LAYER_NAMES[LAYER_COUNT] = {
+    "stone", "dirt", "grass_top", "grass_side", "sand", "water", "lamp", "lava"
+};
+static_assert(LAYER_COUNT == 8, "LAYER_NAMES ha un nome per ogni TextureLayer");
+
+const char* blockName(BlockID id) {
+    if (id < BLOCK_COUNT) return builtinBlockInfo(id).name;
+    if (id - BLOCK_COUNT < (int)runtimeNames.size()) return runtimeNames[id - BLOCK_COUNT].c_str();
+    return "unknown";
+}
+
+int registeredBlockCount() {
+    return BLOCK_COUNT + (int)runtimeNames.size();
+}
+
+BlockID findBlock(std::string_view name) {
+    for (int id = 1; id < BLOCK_COUNT; id++)
+        if (name == builtinBlockInfo((BlockID)id).name) return (BlockID)id;
+    for (size_t i = 0; i < runtimeNames.size(); i++)
+        if (name == runtimeNames[i]) return (BlockID)(BLOCK_COUNT + i);
+    return BLOCK_AIR;
+}
+
+BlockID registerBlock(const BlockDefinition& definition) {
+    if (definition.name.empty() || definition.name == "air" || findBlock(definition.name) != BLOCK_AIR) {
+        std::cerr << "Blocco \"" << definition.name << "\" già definito\n";
+        return BLOCK_AIR;
+    }
+    if (registeredBlockCount() >= MAX_BLOCK_TYPES) {
+        std::cerr << "Troppi tipi di blocco: \"" << definition.name << "\" non registrato\n";
+        return BLOCK_AIR;
+    }
+
+    BlockID id = (BlockID)registeredBlockCount();
+    runtimeNames.push_back(definition.name);
+
+    BlockInfo info;
+    info.name     = runtimeNames.back().c_str();
+    info.solid    = definition.solid;
+    info.opaque   = definition.opaque;
+    info.falls    = definition.falls;
+    info.emission = (uint8_t)std::clamp(definition.emission, 0, MAX_LIGHT);
+    blockProperties.set(id, info);
+    blockTextureTable[id] = definition.textures;
+    return id;
+}
+
+void resetBlockRegistry() {
+    runtimeNames.clear();
+    blockProperties   = BUILTIN_BLOCK_PROPERTIES;
+    blockTextureTable = makeBlockTextureTable();
+}
+
+// ---------------------------------------------------------------
+// File di definizione: una riga per blocco, "nome chiave=valore ..."
+// ---------------------------------------------------------------
+static bool parseInt(std::string_view text, int& value) {
+    auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return error == std::errc() && end == text.data() + text.size();
+}
+
+static bool parseLayer(std::string_view text, uint16_t& layer) {
+    for (int i = 0; i < LAYER_COUNT; i++)
+        if (text == LAYER_NAMES[i]) {
+            layer = (uint16_t)i;
+            return true;
+        }
+    return false;
+}
+
+// Una proprietà "chiave=valore" nella definizione; false se non va
+static bool parseProperty(std::string_view token, BlockDefinition& definition) {
+    size_t equals = token.find('=');
+    if (equals == std::string_view::npos) return false;
+    std::string_view key = token.substr(0, equals), value = token.substr(equals + 1);
+
+    int number = 0;
+    if (key == "solid" || key == "opaque" || key == "falls") {
+        if (!parseInt(value, number) || (number != 0 && number != 1)) return false;
+        (key == "solid" ? definition.solid : key == "opaque" ? definition.opaque : definition.falls) = number != 0;
+        return true;
+    }
+    if (key == "emission") {
+        if (!parseInt(value, number) || number < 0 || number > MAX_LIGHT) return false;
+        definition.emission = number;
+        return true;
+    }
+
+    uint16_t layer = 0;
+    if (!parseLayer(value, layer)) return false;
+    if (key == "texture") definition.textures = { layer, layer, layer };
+    else if (key == "top")    definition.textures.top    = layer;
+    else if (key == "bottom") definition.textures.bottom = layer;
+    else if (key == "side")   definition.textures.side   = layer;
+    else return false;
+    return true;
+}
+
+int registerBlocks(std::string_view text, const std::string& source) {
+    int registered = 0;
+    int lineNumber = 0;
+    while (!text.empty()) {
+        size_t end = text.find('\n');
+        std::string_view line = text.substr(0, end);
+        text = end == std::string_view::npos ? std::string_view() : text.substr(end + 1);
+        lineNumber++;
+
+        if (size_t comment = line.find('#'); comment != std::string_view::npos) line = line.substr(0, comment);
+
+        // Parole separate da spazi: la prima è il nome, le altre proprietà
+        BlockDefinition definition;
+        bool ok = true, first = true;
+        while (ok) {
+            size_t begin = line.find_first_not_of(" \t\r");
+            if (begin == std::string_view::npos) break;
+            line = line.substr(begin);
+            std::string_view token = line.substr(0, line.find_first_of(" \t\r"));
+            line = line.substr(token.size());
+
+            if (first) definition.name = std::string(token);
+            else if (!parseProperty(token, definition)) {
+                std::cerr << source << ":" << lineNumber << ": proprietà non valida \"" << token << "\"\n";
+                ok = false;
+            }
+            first = false;
+        }
+        if (ok && !first && registerBlock(definition) != BLOCK_AIR) registered++;
+    }
+    return registered;
+}
+
+int loadBlockDefinitions(const std::string& path) {
+    std::string text;
+    if (!readTextFile(path, text)) return 0;
+    return registerBlocks(text, path);
+}
+
+// ---------------------------------------------------------------
+// BlockID su disco
+// ---------------------------------------------------------------
+
+uint64_t blockRegistryHash() {
+    uint64_t hash = 14695981039346656037ull;
+    for (int id = 0; id < registeredBlockCount(); id++) {
+        // Lo zero finale separa i nomi: "ab"+"c" non è "a"+"bc"
+        const char* name = blockName((BlockID)id);
+        for (const char* c = name; ; c++) {
+            hash = (hash ^ (uint8_t)*c) * 1099511628211ull;
+            if (*c == 0) break;
+        }
+    }
+    return hash;
+}
+
+bool syncBlockTable(const std::string& path) {
+    std::string text;
+    if (std::filesystem::exists(path) && readTextFile(path, text)) {
+        std::istringstream lines(text);
+        std::string name;
+        for (int id = BLOCK_COUNT; std::getline(lines, name); id++) {
+            if (findBlock(name) == (BlockID)id) continue;
+            std::cerr << path << ": il tipo \"" << name << "\" era il BlockID " << id << ", ora "
+                      << (findBlock(name) == BLOCK_AIR ? std::string("non esiste") : "è " + std::to_string(findBlock(name)))
+                      << ": i blocchi salvati cambierebbero tipo\n";
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+    std::ofstream file(path, std::ios::trunc);
+    for (const std::string& name : runtimeNames) file << name << "\n";
+    if (!file) std::cerr << "Impossibile scrivere " << path << "\n";
+    return true;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "block.h"
+#include "material.h"
+
+// ---------------------------------------------------------------
+// Blocchi definiti a runtime
+// I tipi di BlockType sono scritti nel codice e le loro proprietà
+// diventano tabelle a compile time (block.h). Altri tipi si possono
+// aggiungere all'avvio, da codice o da un file di testo: prendono il
+// primo BlockID libero dopo BLOCK_COUNT e finiscono nelle stesse
+// tabelle dense, quindi mesher, luce e raycast non fanno differenza
+// tra un tipo scritto nel codice e uno letto da file.
+//
+// Le tabelle si leggono senza lock da tutti i thread: si registra
+// solo all'avvio, prima di far partire worker e simulazione.
+// ---------------------------------------------------------------
+struct BlockDefinition {
+    std::string   name;
+    bool          solid    = true;
+    bool          opaque   = true;
+    bool          falls    = false;
+    int           emission = 0; // 0..MAX_LIGHT
+    BlockTextures textures = { LAYER_STONE, LAYER_STONE, LAYER_STONE };
+};
+
+// Aggiunge un tipo e restituisce il suo BlockID; BLOCK_AIR (con un
+// messaggio) se il nome c'è già o le tabelle sono piene
+BlockID registerBlock(const BlockDefinition& definition);
+
+// Registra i tipi descritti nel testo, uno per riga:
+//
+//   # nome     proprietà (quelle che mancano restano come per la pietra)
+//   glass      opaque=0 texture=water
+//   glowstone  emission=15 texture=lamp
+//   gravel     falls=1 top=dirt side=stone bottom=stone
+//
+// Proprietà: solid, opaque, falls (0/1), emission (0..15), texture
+// (tutte le facce), top, bottom, side; i layer per nome (stone, dirt,
+// grass_top, grass_side, sand, water, lamp, lava). Le righe sbagliate
+// si saltano con un messaggio che dice dove. source compare nei
+// messaggi. Restituisce quanti tipi ha registrato.
+int registerBlocks(std::string_view text, const std::string& source);
+
+// Come registerBlocks, leggendo il file
+int loadBlockDefinitions(const std::string& path);
+
+// Il tipo con quel nome (anche di BlockType), BLOCK_AIR se non esiste
+BlockID findBlock(std::string_view name);
+
+// BlockID validi: da 0 a registeredBlockCount() - 1
+int  registeredBlockCount();
+inline bool isRegisteredBlock(BlockID id) { return id < registeredBlockCount(); }
+
+// Dimentica i tipi registrati a runtime: restano quelli di BlockType
+void resetBlockRegistry();
+
+// ---------------------------------------------------------------
+// BlockID su disco
+// Il BlockID di un tipo registrato a runtime è la sua posizione nel
+// file di definizione, e così com'è finisce nei region file e nelle
+// registrazioni. Riordinare o togliere una riga cambierebbe il tipo
+// dei blocchi già salvati: chi scrive BlockID su disco tiene i nomi
+// (o il loro hash) e li confronta con quelli registrati adesso.
+// ---------------------------------------------------------------
+
+// Hash dei nomi di tutti i tipi, in ordine di BlockID
+uint64_t blockRegistryHash();
+
+// Confronta i tipi registrati con la tabella in path (un nome per
+// riga, dal BlockID BLOCK_COUNT in poi), poi ci scrive quelli attuali.
+// false (con un messaggio, senza scrivere) se un tipo della tabella è
+// sparito o ha cambiato BlockID; tipi nuovi in fondo vanno bene, come
+// una tabella che non c'è ancora.
+bool syncBlockTable(const std::string& path);
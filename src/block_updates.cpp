@@ -0,0 +1,277 @@
+#include "block_updates.h"
+
+#include <algorithm>
+
+#include "job_system.h"
+#include "profiler.h"
+
+namespace {
+
+// Le 6 direzioni: 2a e 2a + 1 sono l'asse a nei due versi
+const int DIRECTIONS[6][3] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+// Passo dell'indice in Chunk per ogni asse (x, y, z)
+const int STRIDES[3] = { 1, CHUNK_AREA, CHUNK_SIZE };
+constexpr int UP   = 2;
+constexpr int DOWN = 3;
+// Le direzioni orizzontali, per lo scorrere di lato
+const int SIDES[4] = { 0, 1, 4, 5 };
+
+// Coordinata locale sull'asse a della cella i (ordine di Chunk::index)
+int localCoord(int i, int a) {
+    return a == 0 ? i & CHUNK_MASK : a == 1 ? i >> (2 * CHUNK_SHIFT) : (i >> CHUNK_SHIFT) & CHUNK_MASK;
+}
+
+// Passi di attesa prima di aggiornare una cella con questo blocco; 0 se non si muove mai
+int delayOf(BlockID id) {
+    if (fallsDown(id)) return BlockUpdateSystem::FALL_DELAY;
+    BlockID source = fluidSource(id);
+    if (source == BLOCK_LAVA)  return BlockUpdateSystem::LAVA_DELAY;
+    if (source == BLOCK_WATER) return BlockUpdateSystem::WATER_DELAY;
+    return 0;
+}
+
+// Fase della scacchiera: chunk vicini hanno sempre fasi diverse
+int phaseOf(const ChunkPos& pos) {
+    return (pos.x & 1) | (pos.y & 1) << 1 | (pos.z & 1) << 2;
+}
+
+bool testBit(const uint64_t* bits, int i) { return (bits[i >> 6] >> (i & 63)) & 1; }
+void setBit(uint64_t* bits, int i)        { bits[i >> 6] |= uint64_t(1) << (i & 63); }
+void clearBit(uint64_t* bits, int i)      { bits[i >> 6] &= ~(uint64_t(1) << (i & 63)); }
+
+} // namespace
+
+void BlockUpdateSystem::clear() {
+    active.clear();
+    lastActive = nullptr;
+    lastPos    = { INT32_MIN, INT32_MIN, INT32_MIN };
+    pending    = 0;
+    jobCount   = 0;
+    changed.clear();
+}
+
+void BlockUpdateSystem::blockChanged(const World& world, int x, int y, int z) {
+    schedule(world, x, y, z);
+    for (const auto& d : DIRECTIONS) schedule(world, x + d[0], y + d[1], z + d[2]);
+}
+
+void BlockUpdateSystem::schedule(const World& world, int x, int y, int z) {
+    ChunkPos pos = World::toChunkPos(x, y, z);
+    const Chunk* chunk = world.getChunk(pos);
+    if (!chunk) return;
+    int i = Chunk::index(x & CHUNK_MASK, y & CHUNK_MASK, z & CHUNK_MASK);
+    int delay = delayOf(chunk->getBlockAt(i));
+    if (delay == 0) return;
+
+    // Celle consecutive stanno quasi sempre nello stesso chunk
+    if (!lastActive || !(pos == lastPos)) {
+        lastActive = &active[pos];
+        lastPos    = pos;
+    }
+    if (testBit(lastActive->scheduled, i)) return;
+    setBit(lastActive->scheduled, i);
+    lastActive->queue.push_back({ tickCount + (uint64_t)delay, (uint16_t)i });
+    std::push_heap(lastActive->queue.begin(), lastActive->queue.end());
+    pending++;
+}
+
+void BlockUpdateSystem::update(World& world) {
+    PROFILE_SCOPE("Block updates");
+    tickCount++;
+    changed.clear();
+    gatherJobs(world);
+
+    // Una fase alla volta (i job sono ordinati per fase): i chunk della
+    // fase in parallelo, poi in ordine di job prima le loro modifiche e
+    // poi le scritture nei vicini
+    for (int begin = 0; begin < jobCount;) {
+        int end = begin;
+        while (end < jobCount && work[end].phase == work[begin].phase) end++;
+        ChunkJob* phase = work.data() + begin;
+        int count = end - begin;
+        if (jobs && count > 1) jobs->parallelFor(count, [phase](int j) { runJob(phase[j]); });
+        else for (int j = 0; j < count; j++) runJob(phase[j]);
+
+        for (int j = begin; j < end; j++) changed.insert(changed.end(), work[j].changes.begin(), work[j].changes.end());
+        for (int j = begin; j < end; j++) applyOutbox(world, work[j]);
+        begin = end;
+    }
+
+    // Chi è cambiato torna in programma con i vicini
+    for (const BlockChange& change : changed) blockChanged(world, change.x, change.y, change.z);
+}
+
+// I chunk con celle in programma per questo passo, ognuno con le sue
+// celle ordinate; intanto si tolgono quelli senza più niente in coda
+// o non più caricati
+void BlockUpdateSystem::gatherJobs(World& world) {
+    jobCount     = 0;
+    updatedCells = 0;
+    lastActive   = nullptr;
+    lastPos      = { INT32_MIN, INT32_MIN, INT32_MIN };
+
+    for (auto it = active.begin(); it != active.end();) {
+        const ChunkPos& pos = it->first;
+        ActiveChunk& chunkState = it->second;
+        Chunk* chunk = chunkState.queue.empty() ? nullptr : world.getChunk(pos);
+        if (!chunk) {
+            pending -= (long long)chunkState.queue.size();
+            it = active.erase(it);
+            continue;
+        }
+        if (chunkState.queue.front().due > tickCount) {
+            ++it;
+            continue;
+        }
+
+        if (jobCount == (int)work.size()) work.emplace_back();
+        ChunkJob& job = work[jobCount++];
+        job.pos    = pos;
+        job.phase  = phaseOf(pos);
+        job.chunk  = chunk;
+        job.active = &chunkState;
+        for (int d = 0; d < 6; d++)
+            job.neighbours[d] = world.findChunk({ pos.x + DIRECTIONS[d][0], pos.y + DIRECTIONS[d][1], pos.z + DIRECTIONS[d][2] });
+        job.cells.clear();
+        job.changes.clear();
+        job.outbox.clear();
+
+        std::vector<ScheduledCell>& queue = chunkState.queue;
+        while (!queue.empty() && queue.front().due <= tickCount) {
+            std::pop_heap(queue.begin(), queue.end());
+            job.cells.push_back(queue.back().cell);
+            clearBit(chunkState.scheduled, queue.back().cell);
+            queue.pop_back();
+        }
+        std::sort(job.cells.begin(), job.cells.end());
+        std::fill(std::begin(chunkState.touched), std::end(chunkState.touched), 0);
+        pending      -= (long long)job.cells.size();
+        updatedCells += (int)job.cells.size();
+        ++it;
+    }
+
+    // Ordine fisso: per fase, poi per posizione (la hash map non ne ha uno)
+    std::sort(work.begin(), work.begin() + jobCount, [](const ChunkJob& a, const ChunkJob& b) {
+        if (a.phase != b.phase) return a.phase < b.phase;
+        if (a.pos.y != b.pos.y) return a.pos.y < b.pos.y;
+        if (a.pos.z != b.pos.z) return a.pos.z < b.pos.z;
+        return a.pos.x < b.pos.x;
+    });
+}
+
+// Le celle di un chunk, dalla più bassa: una pila di sabbia cade tutta
+// insieme, perché ogni granello trova già vuoto il posto di quello sotto.
+// Una cella cambiata in questo passo non si aggiorna di nuovo.
+void BlockUpdateSystem::runJob(ChunkJob& job) {
+    Chunk& chunk = *job.chunk;
+    uint64_t* touched = job.active->touched;
+    int baseX = job.pos.x * CHUNK_SIZE, baseY = job.pos.y * CHUNK_SIZE, baseZ = job.pos.z * CHUNK_SIZE;
+
+    // Il blocco accanto alla cella i in direzione d, anche oltre il bordo
+    auto neighbour = [&](int i, int d) -> BlockID {
+        int a = d >> 1, step = DIRECTIONS[d][a];
+        int local = localCoord(i, a) + step;
+        if (local >= 0 && local < CHUNK_SIZE) return chunk.getBlockAt(i + step * STRIDES[a]);
+        // Nel vicino è la cella sul bordo opposto
+        const Chunk* other = job.neighbours[d];
+        return other ? other->getBlockAt(i - step * CHUNK_MASK * STRIDES[a]) : (BlockID)BLOCK_STONE;
+    };
+    auto write = [&](int i, BlockID id) {
+        BlockID old = chunk.getBlockAt(i);
+        if (old == id) return;
+        chunk.setBlockAt(i, id);
+        setBit(touched, i);
+        job.changes.push_back({ baseX + localCoord(i, 0), baseY + localCoord(i, 1), baseZ + localCoord(i, 2), old, id });
+    };
+    auto writeNeighbour = [&](int i, int d, BlockID id) {
+        int a = d >> 1, step = DIRECTIONS[d][a];
+        int local = localCoord(i, a) + step;
+        if (local >= 0 && local < CHUNK_SIZE) {
+            write(i + step * STRIDES[a], id);
+            return;
+        }
+        job.outbox.push_back({ baseX + localCoord(i, 0) + DIRECTIONS[d][0], baseY + localCoord(i, 1) + DIRECTIONS[d][1],
+                               baseZ + localCoord(i, 2) + DIRECTIONS[d][2], id });
+    };
+
+    auto updateCell = [&](int i) {
+        BlockID id = chunk.getBlockAt(i);
+
+        // Sabbia: scende al posto di quello che ha sotto (un fluido risale)
+        if (fallsDown(id)) {
+            BlockID below = neighbour(i, DOWN);
+            if (below == BLOCK_AIR || isFluid(below)) {
+                write(i, below);
+                writeNeighbour(i, DOWN, id);
+            }
+            return;
+        }
+
+        BlockID source = fluidSource(id);
+        if (source == BLOCK_AIR) return;
+
+        // Lava che tocca l'acqua si raffredda in pietra
+        if (source == BLOCK_LAVA)
+            for (int d = 0; d < 6; d++)
+                if (fluidSource(neighbour(i, d)) == BLOCK_WATER) {
+                    write(i, BLOCK_STONE);
+                    return;
+                }
+
+        // Il livello di chi scorre dipende da chi lo alimenta
+        int level = fluidLevel(id);
+        if (level < SOURCE_LEVEL) {
+            int fed = 0;
+            if (fluidSource(neighbour(i, UP)) == source) fed = FLUID_LEVELS;
+            else
+                for (int d : SIDES) {
+                    BlockID side = neighbour(i, d);
+                    if (fluidSource(side) == source) fed = std::max(fed, fluidLevel(side) - 1);
+                }
+            if (fed != level) {
+                write(i, fluidBlock(source, fed));
+                return;
+            }
+        }
+
+        // Prima giù; di lato solo con un appoggio sotto (non mentre cade)
+        BlockID below = neighbour(i, DOWN);
+        if (below == BLOCK_AIR || (fluidSource(below) == source && fluidLevel(below) < FLUID_LEVELS)) {
+            writeNeighbour(i, DOWN, fluidBlock(source, FLUID_LEVELS));
+            return;
+        }
+        if (fluidSource(below) == source && fluidLevel(below) < SOURCE_LEVEL) return;
+
+        int spread = level - 1;
+        if (spread <= 0) return;
+        for (int d : SIDES) {
+            BlockID side = neighbour(i, d);
+            if (side == BLOCK_AIR || (fluidSource(side) == source && fluidLevel(side) < spread))
+                writeNeighbour(i, d, fluidBlock(source, spread));
+        }
+    };
+
+    for (uint16_t i : job.cells) {
+        if (testBit(touched, i)) continue;
+        setBit(touched, i);
+        updateCell(i);
+    }
+}
+
+// Le scritture di un job nei chunk vicini, a fase finita: in quella
+// fase nessun altro ha toccato quelle celle
+void BlockUpdateSystem::applyOutbox(World& world, const ChunkJob& job) {
+    for (const BlockEdit& edit : job.outbox) {
+        ChunkPos pos = World::toChunkPos(edit.x, edit.y, edit.z);
+        Chunk* chunk = world.getChunk(pos);
+        if (!chunk) continue;
+        int i = Chunk::index(edit.x & CHUNK_MASK, edit.y & CHUNK_MASK, edit.z & CHUNK_MASK);
+        BlockID old = chunk->getBlockAt(i);
+        if (old == edit.id) continue;
+        chunk->setBlockAt(i, edit.id);
+        changed.push_back({ edit.x, edit.y, edit.z, old, edit.id });
+        // Se quel chunk ha ancora da aggiornare questa cella lo farà al prossimo passo
+        auto it = active.find(pos);
+        if (it != active.end()) setBit(it->second.touched, i);
+    }
+}
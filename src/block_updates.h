@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "world.h"
+
+class JobSystem;
+
+// ---------------------------------------------------------------
+// BlockUpdateSystem
+// I blocchi che si muovono da soli: acqua e lava che scorrono, sabbia
+// che cade. Scorrere tutti i chunk caricati ad ogni passo non scala,
+// quindi si aggiornano solo le celle "in programma": per ogni chunk
+// una coda con priorità (il passo a cui tocca a ogni cella) e un bit
+// per cella per non metterla in coda due volte. Quando un blocco
+// cambia, lui e i 6 vicini tornano in programma dopo il ritardo del
+// loro tipo (la lava è più lenta dell'acqua); una cella che non cambia
+// niente esce dalla coda. Un lago fermo non costa nulla.
+//
+// Regole, una cella alla volta:
+//  - sabbia: con aria o un fluido sotto, si scambia con quello che c'è
+//  - lava che tocca l'acqua: diventa pietra
+//  - fluido che scorre (non sorgente): il suo livello viene dai vicini,
+//    pieno se sopra c'è lo stesso fluido, se no uno meno del più alto
+//    di lato; senza nessuno che lo alimenti si asciuga
+//  - poi si allarga: se sotto c'è aria ci cade dentro, se sotto c'è un
+//    appoggio scorre di lato con un livello in meno
+//
+// In parallelo a scacchiera: i chunk in programma si dividono in 8
+// fasi secondo la parità di (x, y, z). Nella stessa fase due chunk non
+// sono mai vicini, quindi ognuno scrive nel suo e legge i 6 vicini, che
+// in quella fase non cambiano. Le scritture nei vicini (l'acqua che
+// passa il bordo) aspettano la fine della fase e si applicano in ordine
+// fisso: il risultato è lo stesso con qualsiasi numero di thread.
+//
+// I blocchi si scrivono direttamente nei chunk: chi chiama update poi
+// passa changes() al LightEngine (blocksChanged) o almeno al World
+// (markBlockChanged), per luce, mesh e salvataggio. I chunk non
+// caricati sono pietra: niente ci scorre dentro.
+// ---------------------------------------------------------------
+class BlockUpdateSystem {
+public:
+    // Passi di update al secondo: i chiamanti lo chiamano con questo ritmo
+    static constexpr int TICK_RATE = 10;
+
+    // Passi tra una modifica e l'aggiornamento di una cella, per tipo
+    static constexpr int WATER_DELAY = 1;
+    static constexpr int LAVA_DELAY  = 3;
+    static constexpr int FALL_DELAY  = 1;
+
+    explicit BlockUpdateSystem(JobSystem* jobs = nullptr) : jobs(jobs) {}
+
+    // Un blocco cambiato da fuori (giocatore, generatore): lui e i
+    // vicini che possono muoversi vanno in programma
+    void blockChanged(const World& world, int x, int y, int z);
+
+    // Un passo: aggiorna le celle in programma per questo passo
+    void update(World& world);
+
+    // Le modifiche dell'ultimo update, in ordine (una cella può apparire più volte)
+    const std::vector<BlockChange>& changes() const { return changed; }
+
+    uint64_t  ticks() const { return tickCount; }
+    int       activeChunks() const { return (int)active.size(); }
+    long long scheduledCells() const { return pending; }
+    int       lastUpdatedCells() const { return updatedCells; }
+    int       lastUpdatedChunks() const { return jobCount; }
+
+    // Dimentica tutto quello che era in programma
+    void clear();
+
+private:
+    struct ScheduledCell {
+        uint64_t due;  // passo a cui tocca
+        uint16_t cell; // indice nel chunk, come Chunk::index
+
+        // std::push_heap tiene in cima il "massimo": invertiamo il confronto
+        bool operator<(const ScheduledCell& other) const { return due > other.due; }
+    };
+
+    static constexpr int CELL_WORDS = CHUNK_VOLUME / 64;
+
+    struct ActiveChunk {
+        std::vector<ScheduledCell> queue; // heap: in cima la cella con due più basso
+        uint64_t scheduled[CELL_WORDS] = {}; // celle già in coda
+        uint64_t touched[CELL_WORDS] = {};   // celle cambiate nel passo in corso
+    };
+
+    // Il lavoro di un chunk in un passo
+    struct ChunkJob {
+        ChunkPos     pos;
+        int          phase;
+        Chunk*       chunk;
+        ActiveChunk* active;
+        const Chunk* neighbours[6]; // nell'ordine di DIRECTIONS, nullptr se non caricati
+
+        std::vector<uint16_t>    cells;   // in programma per questo passo, ordinate
+        std::vector<BlockChange> changes; // nel chunk
+        std::vector<BlockEdit>   outbox;  // nei vicini, da applicare a fine fase
+    };
+
+    void schedule(const World& world, int x, int y, int z);
+    void gatherJobs(World& world);
+    static void runJob(ChunkJob& job);
+    void applyOutbox(World& world, const ChunkJob& job);
+
+    JobSystem* jobs;
+    uint64_t   tickCount = 0;
+    long long  pending = 0;
+
+    std::unordered_map<ChunkPos, ActiveChunk, ChunkPosHash> active;
+    ChunkPos     lastPos = { INT32_MIN, INT32_MIN, INT32_MIN }; // ultimo chunk di schedule
+    ActiveChunk* lastActive = nullptr;
+
+    std::vector<ChunkJob>    work; // i primi jobCount sono quelli del passo
+    int                      jobCount = 0;
+    int                      updatedCells = 0;
+    std::vector<BlockChange> changed;
+};
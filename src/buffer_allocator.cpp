@@ -0,0 +1,66 @@
+#include "buffer_allocator.h"
+
+BufferAllocator::BufferAllocator(uint32_t capacity) {
+    grow(capacity);
+}
+
+uint32_t BufferAllocator::allocate(uint32_t size) {
+    if (size == 0) return INVALID;
+
+    // Best fit: il più piccolo blocco libero con almeno size unità
+    auto best = freeBySize.lower_bound({ size, 0 });
+    if (best == freeBySize.end()) return INVALID;
+
+    uint32_t offset = best->second;
+    uint32_t rest   = best->first - size;
+    removeFree(freeBlocks.find(offset));
+    if (rest > 0) addFree(offset + size, rest);
+    usedUnits += size;
+    return offset;
+}
+
+void BufferAllocator::free(uint32_t offset, uint32_t size) {
+    if (size == 0) return;
+    usedUnits -= size;
+
+    auto next = freeBlocks.lower_bound(offset);
+
+    // Si attacca al blocco libero precedente?
+    if (next != freeBlocks.begin()) {
+        auto previous = std::prev(next);
+        if (previous->first + previous->second == offset) {
+            offset = previous->first;
+            size  += previous->second;
+            removeFree(previous);
+        }
+    }
+    // E al successivo?
+    if (next != freeBlocks.end() && offset + size == next->first) {
+        size += next->second;
+        removeFree(next);
+    }
+    addFree(offset, size);
+}
+
+void BufferAllocator::addFree(uint32_t offset, uint32_t size) {
+    freeBlocks.emplace(offset, size);
+    freeBySize.emplace(size, offset);
+}
+
+void BufferAllocator::removeFree(std::map<uint32_t, uint32_t>::iterator it) {
+    freeBySize.erase({ it->second, it->first });
+    freeBlocks.erase(it);
+}
+
+void BufferAllocator::grow(uint32_t newCapacity) {
+    if (newCapacity <= totalCapacity) return;
+    uint32_t extra = newCapacity - totalCapacity;
+    uint32_t start = totalCapacity;
+    totalCapacity = newCapacity;
+    usedUnits += extra; // free() lo toglie di nuovo
+    free(start, extra);
+}
+
+uint32_t BufferAllocator::largestFreeBlock() const {
+    return freeBySize.empty() ? 0 : freeBySize.rbegin()->first;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <utility>
+
+// ---------------------------------------------------------------
+// BufferAllocator
+// Gestisce lo spazio di un grande buffer (della GPU, ma non tocca
+// OpenGL) come una lista di blocchi liberi: allocate() prende il
+// blocco libero più piccolo che basta (best fit, lasciando intatti i
+// blocchi grandi), free() restituisce un intervallo e lo fonde con i
+// vicini liberi, così lo spazio non si frammenta in tanti buchi piccoli.
+// I blocchi liberi sono indicizzati sia per offset (per fonderli) che
+// per dimensione (per trovarli): entrambe le operazioni sono O(log n).
+//
+// Le unità sono quelle che sceglie chi lo usa (vertici, indici,
+// byte): il renderer dei chunk ne usa uno per i vertici e uno per
+// gli indici.
+// ---------------------------------------------------------------
+class BufferAllocator {
+public:
+    static constexpr uint32_t INVALID = UINT32_MAX;
+
+    explicit BufferAllocator(uint32_t capacity = 0);
+
+    // Offset dell'intervallo allocato, INVALID se non c'è spazio
+    uint32_t allocate(uint32_t size);
+    void     free(uint32_t offset, uint32_t size);
+
+    // Allunga lo spazio gestito (il nuovo spazio in fondo è libero)
+    void grow(uint32_t newCapacity);
+
+    uint32_t capacity() const { return totalCapacity; }
+    uint32_t used() const     { return usedUnits; }
+    uint32_t largestFreeBlock() const;
+    int      freeBlockCount() const { return (int)freeBlocks.size(); }
+
+private:
+    void addFree(uint32_t offset, uint32_t size);
+    void removeFree(std::map<uint32_t, uint32_t>::iterator it);
+
+    std::map<uint32_t, uint32_t> freeBlocks;                 // offset → dimensione
+    std::set<std::pair<uint32_t, uint32_t>> freeBySize;     // (dimensione, offset)
+    uint32_t totalCapacity = 0;
+    uint32_t usedUnits     = 0;
+};
@@ -1,6 +1,5 @@
 #include "camera.h"
 #include <glm/gtc/matrix_transform.hpp>
-#include <GLFW/glfw3.h>
 #include <algorithm> // per std::clamp
 
 Camera::Camera(glm::vec3 startPosition, float startYaw, float startPitch)
@@ -50,6 +49,12 @@ void Camera::processMouseMovement(float xoffset, float yoffset) {
     updateVectors();
 }
 
+void Camera::setOrientation(float newYaw, float newPitch) {
+    yaw   = newYaw;
+    pitch = std::clamp(newPitch, -89.0f, 89.0f);
+    updateVectors();
+}
+
 void Camera::processMouseScroll(float yoffset) {
     // Lo scroll cambia il field of view — effetto zoom
     fov = std::clamp(fov - yoffset, 1.0f, 90.0f);
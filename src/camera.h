@@ -52,6 +52,9 @@ public:
     // xoffset e yoffset sono quanto si è mosso dall'ultimo frame
     void processMouseMovement(float xoffset, float yoffset);
 
+    // Imposta l'orientamento (es. quello deciso da un altro thread)
+    void setOrientation(float newYaw, float newPitch);
+
     // Chiamata quando si scrolla la rotella del mouse (zoom)
     void processMouseScroll(float yoffset);
 
@@ -0,0 +1,289 @@
+#include "chunk.h"
+
+#include <cstring>
+
+// Oltre 256 tipi diversi la palette non conviene più:
+// 8 bit di indice + la palette costano quasi quanto 16 bit diretti
+constexpr int MAX_PALETTE_BITS = 8;
+
+// Un blocco occupa il chunk (conta in solidBlocks e accende il suo
+// brick) se non è aria, anche se non è pieno né opaco: un tipo
+// registrato a runtime come un vetro o una torcia
+static bool occupies(BlockID id) { return id != BLOCK_AIR; }
+
+Chunk::Chunk()
+    : palette{ BLOCK_AIR }
+    , refCounts{ (uint16_t)CHUNK_VOLUME }
+{
+}
+
+static FixedPool& chunkPool() {
+    // Mai distrutto: i chunk di un World statico muoiono dopo i pool
+    static FixedPool* pool = new FixedPool(sizeof(Chunk), MemoryTag::Chunks);
+    return *pool;
+}
+
+void* Chunk::operator new(size_t size) {
+    (void)size; // sempre sizeof(Chunk): le classi derivate non esistono
+    return chunkPool().allocate();
+}
+
+void Chunk::operator delete(void* p) {
+    chunkPool().deallocate(p);
+}
+
+void Chunk::setBlockAt(int i, BlockID id) {
+    // Modalità diretta: i dati sono già BlockID, nessuna palette da aggiornare
+    if (bits == 16) {
+        BlockID old = (BlockID)readRaw(i);
+        if (old == id) return;
+        writeRaw(i, id);
+        solidBlocks += (int)occupies(id) - (int)occupies(old);
+        updateBrick(i, old, id);
+        return;
+    }
+
+    int oldIndex = (bits == 0) ? 0 : (int)readRaw(i);
+    BlockID old = palette[oldIndex];
+    if (old == id) return;
+
+    // Attenzione: paletteIndexFor può cambiare "bits" (repack)
+    // oppure passare alla modalità diretta
+    int newIndex = paletteIndexFor(id);
+    solidBlocks += (int)occupies(id) - (int)occupies(old);
+
+    if (bits == 16) {
+        writeRaw(i, id);
+        updateBrick(i, old, id);
+        return;
+    }
+
+    --refCounts[oldIndex];
+    ++refCounts[newIndex];
+    writeRaw(i, (uint32_t)newIndex);
+    updateBrick(i, old, id);
+
+    // Se ora tutto il chunk è dello stesso tipo torniamo alla forma uniforme:
+    // capita spesso riempiendo un chunk blocco per blocco
+    if (refCounts[newIndex] == CHUNK_VOLUME)
+        fill(id);
+}
+
+void Chunk::fill(BlockID id) {
+    palette.assign(1, id);
+    refCounts.assign(1, (uint16_t)CHUNK_VOLUME);
+    data.clear();
+    data.shrink_to_fit();
+    bits = 0;
+    solidBlocks = occupies(id) ? CHUNK_VOLUME : 0;
+    bricks      = occupies(id) ? ~uint64_t(0) : 0;
+}
+
+void Chunk::updateBrick(int i, BlockID old, BlockID id) {
+    uint64_t bit = uint64_t(1) << brickIndexAt(i);
+    if (occupies(id)) {
+        bricks |= bit;
+        return;
+    }
+    if (!occupies(old)) return;
+
+    // Era l'ultimo blocco del brick? Controlliamo i suoi 64 blocchi
+    int x0 = i & CHUNK_MASK & ~(BRICK_SIZE - 1);
+    int y0 = (i >> (2 * CHUNK_SHIFT)) & ~(BRICK_SIZE - 1);
+    int z0 = (i >> CHUNK_SHIFT) & CHUNK_MASK & ~(BRICK_SIZE - 1);
+    for (int y = y0; y < y0 + BRICK_SIZE; y++)
+        for (int z = z0; z < z0 + BRICK_SIZE; z++)
+            for (int x = x0; x < x0 + BRICK_SIZE; x++)
+                if (occupies(getBlock(x, y, z))) return;
+    bricks &= ~bit;
+}
+
+void Chunk::assign(const BlockID* blocks) {
+    palette.clear();
+    refCounts.clear();
+    solidBlocks = 0;
+    bricks      = 0;
+
+    // Prima passata: palette e conteggi. La ricerca parte dall'ultimo tipo
+    // trovato, perché voxel vicini sono quasi sempre dello stesso tipo.
+    // Gli indici sono temporanei: nell'arena del thread (un worker).
+    ArenaScope scope(scratchArena());
+    uint16_t* indices = scratchArena().allocateArray<uint16_t>(CHUNK_VOLUME);
+    int last = -1;
+    bool direct = false;
+    for (int i = 0; i < CHUNK_VOLUME && !direct; i++) {
+        BlockID id = blocks[i];
+        if (last < 0 || palette[last] != id) {
+            last = -1;
+            for (int p = 0; p < (int)palette.size(); p++)
+                if (palette[p] == id) { last = p; break; }
+            if (last < 0) {
+                if ((int)palette.size() == (1 << MAX_PALETTE_BITS)) { direct = true; break; }
+                palette.push_back(id);
+                refCounts.push_back(0);
+                last = (int)palette.size() - 1;
+            }
+        }
+        refCounts[last]++;
+        indices[i] = (uint16_t)last;
+        if (occupies(id)) {
+            solidBlocks++;
+            bricks |= uint64_t(1) << brickIndexAt(i);
+        }
+    }
+
+    if (direct) {
+        // Troppi tipi diversi: salviamo i BlockID così come sono
+        palette.clear();
+        refCounts.clear();
+        bits = 16;
+        data.assign((size_t)CHUNK_VOLUME * 16 / 64, 0);
+        solidBlocks = 0;
+        bricks      = 0;
+        for (int i = 0; i < CHUNK_VOLUME; i++) {
+            writeRaw(i, blocks[i]);
+            if (occupies(blocks[i])) {
+                solidBlocks++;
+                bricks |= uint64_t(1) << brickIndexAt(i);
+            }
+        }
+        return;
+    }
+
+    if (palette.size() == 1) {
+        fill(palette[0]);
+        return;
+    }
+
+    // Seconda passata: il minimo numero di bit (potenza di 2) che contiene la palette
+    int newBits = 1;
+    while ((1 << newBits) < (int)palette.size()) newBits *= 2;
+    bits = newBits;
+    data.assign((size_t)CHUNK_VOLUME * bits / 64, 0);
+    for (int i = 0; i < CHUNK_VOLUME; i++) writeRaw(i, indices[i]);
+}
+
+// ---------------------------------------------------------------
+// Formato serializzato (little-endian, come la memoria su x86/ARM):
+//   uint8  bits
+//   uint16 numero di voci della palette (0 in modalità diretta)
+//   uint16 palette[n]
+//   uint64 data[CHUNK_VOLUME * bits / 64]
+// I refCount, il numero di blocchi pieni e i brick si ricalcolano al caricamento.
+// ---------------------------------------------------------------
+void Chunk::serialize(std::vector<uint8_t>& out) const {
+    uint16_t paletteCount = (bits == 16) ? 0 : (uint16_t)palette.size();
+    size_t start = out.size();
+    out.resize(start + 3 + paletteCount * sizeof(BlockID) + data.size() * sizeof(uint64_t));
+
+    uint8_t* p = out.data() + start;
+    *p++ = (uint8_t)bits;
+    std::memcpy(p, &paletteCount, 2);                               p += 2;
+    std::memcpy(p, palette.data(), paletteCount * sizeof(BlockID)); p += paletteCount * sizeof(BlockID);
+    std::memcpy(p, data.data(), data.size() * sizeof(uint64_t));
+}
+
+bool Chunk::deserialize(const uint8_t* bytes, size_t size) {
+    if (size < 3) return false;
+    int newBits = bytes[0];
+    uint16_t paletteCount;
+    std::memcpy(&paletteCount, bytes + 1, 2);
+
+    if (newBits != 0 && newBits != 1 && newBits != 2 && newBits != 4 && newBits != 8 && newBits != 16) return false;
+    if (newBits == 16 ? paletteCount != 0 : (paletteCount == 0 || paletteCount > (1 << newBits))) return false;
+
+    size_t words = (size_t)CHUNK_VOLUME * newBits / 64;
+    if (size != 3 + paletteCount * sizeof(BlockID) + words * sizeof(uint64_t)) return false;
+
+    Chunk loaded;
+    loaded.bits = newBits;
+    loaded.palette.resize(paletteCount);
+    loaded.refCounts.assign(paletteCount, 0);
+    loaded.data.resize(words);
+    std::memcpy(loaded.palette.data(), bytes + 3, paletteCount * sizeof(BlockID));
+    std::memcpy(loaded.data.data(), bytes + 3 + paletteCount * sizeof(BlockID), words * sizeof(uint64_t));
+
+    // Contiamo chi usa cosa, controllando che gli indici stiano nella palette
+    if (newBits == 0) {
+        loaded.refCounts[0] = (uint16_t)CHUNK_VOLUME;
+        loaded.solidBlocks  = occupies(loaded.palette[0]) ? CHUNK_VOLUME : 0;
+        loaded.bricks       = occupies(loaded.palette[0]) ? ~uint64_t(0) : 0;
+    } else if (newBits == 16) {
+        for (int i = 0; i < CHUNK_VOLUME; i++) {
+            if (!occupies((BlockID)loaded.readRaw(i))) continue;
+            loaded.solidBlocks++;
+            loaded.bricks |= uint64_t(1) << brickIndexAt(i);
+        }
+    } else {
+        for (int i = 0; i < CHUNK_VOLUME; i++) {
+            uint32_t index = loaded.readRaw(i);
+            if (index >= paletteCount) return false;
+            loaded.refCounts[index]++;
+        }
+        for (int p = 0; p < paletteCount; p++)
+            loaded.solidBlocks += occupies(loaded.palette[p]) ? loaded.refCounts[p] : 0;
+        for (int i = 0; i < CHUNK_VOLUME; i++)
+            if (occupies(loaded.palette[loaded.readRaw(i)])) loaded.bricks |= uint64_t(1) << brickIndexAt(i);
+    }
+
+    *this = std::move(loaded);
+    return true;
+}
+
+size_t Chunk::memoryUsage() const {
+    return sizeof(Chunk)
+         + palette.capacity()   * sizeof(BlockID)
+         + refCounts.capacity() * sizeof(uint16_t)
+         + data.capacity()      * sizeof(uint64_t)
+         + light.capacity();
+}
+
+int Chunk::paletteIndexFor(BlockID id) {
+    // Il tipo è già nella palette?
+    for (int i = 0; i < (int)palette.size(); i++)
+        if (palette[i] == id) return i;
+
+    // Riusiamo una voce che nessun voxel usa più,
+    // così la palette non cresce all'infinito con le modifiche
+    for (int i = 0; i < (int)palette.size(); i++) {
+        if (refCounts[i] == 0) {
+            palette[i] = id;
+            return i;
+        }
+    }
+
+    // Serve una voce nuova: se non ci sta nei bit attuali allarghiamo
+    if ((int)palette.size() >= (1 << bits)) {
+        int newBits = (bits == 0) ? 1 : bits * 2;
+        if (newBits > MAX_PALETTE_BITS) {
+            repack(16);
+            return -1; // in modalità diretta l'indice non serve
+        }
+        repack(newBits);
+    }
+
+    palette.push_back(id);
+    refCounts.push_back(0);
+    return (int)palette.size() - 1;
+}
+
+void Chunk::repack(int newBits) {
+    PaletteVector<uint64_t> newData((size_t)CHUNK_VOLUME * newBits / 64, 0);
+    uint64_t newMask = (uint64_t(1) << newBits) - 1;
+
+    for (int i = 0; i < CHUNK_VOLUME; i++) {
+        uint32_t value = (bits == 0) ? 0 : readRaw(i);
+        if (newBits == 16) value = palette[value]; // da indice a BlockID
+
+        int bitIndex = i * newBits;
+        newData[bitIndex >> 6] |= ((uint64_t)value & newMask) << (bitIndex & 63);
+    }
+
+    data = std::move(newData);
+    bits = newBits;
+
+    if (newBits == 16) {
+        palette.clear();
+        refCounts.clear();
+    }
+}
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "block.h"
+#include "memory.h"
+
+// ---------------------------------------------------------------
+// Dimensioni di un chunk
+// Un chunk è un cubo di 16x16x16 blocchi. Usiamo una potenza di 2
+// così divisioni e moduli diventano shift e AND sui bit.
+// ---------------------------------------------------------------
+constexpr int CHUNK_SHIFT  = 4;
+constexpr int CHUNK_SIZE   = 1 << CHUNK_SHIFT;      // 16
+constexpr int CHUNK_MASK   = CHUNK_SIZE - 1;        // 15
+constexpr int CHUNK_AREA   = CHUNK_SIZE * CHUNK_SIZE;
+constexpr int CHUNK_VOLUME = CHUNK_AREA * CHUNK_SIZE; // 4096
+
+// Un chunk è diviso in 4x4x4 "brick" di 4³ blocchi: un bit per brick
+// dice se contiene qualcosa, e i 64 bit stanno in un uint64_t.
+// Raycast e collisioni saltano i brick vuoti senza leggere i blocchi.
+constexpr int BRICK_SHIFT = 2;
+constexpr int BRICK_SIZE  = 1 << BRICK_SHIFT; // 4
+
+// ---------------------------------------------------------------
+// Classe Chunk
+// Contiene i blocchi di un cubo 16³ in un array piatto e compresso
+// con una "palette": invece di salvare il BlockID di ogni voxel,
+// salviamo la lista dei tipi presenti (la palette) e per ogni voxel
+// solo l'indice nella palette, usando il minimo numero di bit.
+//
+// Esempio: un chunk con solo aria e pietra ha una palette di 2
+// elementi, quindi basta 1 bit per voxel → 512 byte invece di 8 KB.
+//
+// Bit per voxel possibili: 0 (chunk uniforme, nessun dato),
+// 1, 2, 4, 8, oppure 16 = modalità "diretta" senza palette.
+// Usiamo solo divisori di 64 così un indice non è mai spezzato
+// a cavallo di due uint64_t.
+// ---------------------------------------------------------------
+class Chunk {
+public:
+    // Un chunk nuovo è pieno d'aria
+    Chunk();
+
+    // I chunk hanno tutti la stessa dimensione: vengono da un FixedPool
+    // invece che dall'heap (anche con std::make_unique)
+    static void* operator new(size_t size);
+    static void  operator delete(void* p);
+
+    // Coordinate locali 0..15. La x è l'asse più interno: scorrere
+    // lungo x legge memoria contigua, utile per mesher e generatore.
+    static int index(int x, int y, int z) {
+        return (y << (2 * CHUNK_SHIFT)) | (z << CHUNK_SHIFT) | x;
+    }
+
+    BlockID getBlock(int x, int y, int z) const { return getBlockAt(index(x, y, z)); }
+    void    setBlock(int x, int y, int z, BlockID id) { setBlockAt(index(x, y, z), id); }
+
+    // Versioni che prendono direttamente l'indice piatto
+    BlockID getBlockAt(int i) const {
+        if (bits == 0)  return palette[0];
+        if (bits == 16) return (BlockID)((data[i >> 2] >> ((i & 3) << 4)) & 0xFFFF);
+        int bitIndex = i * bits;
+        uint64_t word = data[bitIndex >> 6];
+        uint64_t mask = (uint64_t(1) << bits) - 1;
+        return palette[(word >> (bitIndex & 63)) & mask];
+    }
+    void setBlockAt(int i, BlockID id);
+
+    // Riempie tutto il chunk con un solo tipo (torna alla forma uniforme)
+    void fill(BlockID id);
+
+    // Sostituisce tutti i blocchi con quelli dell'array (CHUNK_VOLUME
+    // elementi, ordinati come index()). Costruisce la palette una volta
+    // sola: molto più veloce di 4096 setBlock.
+    void assign(const BlockID* blocks);
+
+    // Numero di blocchi non-aria: aggiornato ad ogni setBlock,
+    // così contare i blocchi del mondo non richiede di scorrere i voxel
+    int  solidCount() const { return solidBlocks; }
+    bool isEmpty() const    { return solidBlocks == 0; }
+
+    // Bit del brick che contiene il blocco locale (x, y, z), nello stesso
+    // ordine y, z, x di index()
+    static int brickIndex(int x, int y, int z) {
+        return ((y >> BRICK_SHIFT) << 4) | ((z >> BRICK_SHIFT) << 2) | (x >> BRICK_SHIFT);
+    }
+    static int brickIndexAt(int i) {
+        return brickIndex(i & CHUNK_MASK, i >> (2 * CHUNK_SHIFT), (i >> CHUNK_SHIFT) & CHUNK_MASK);
+    }
+
+    // Brick con almeno un blocco non-aria, aggiornati ad ogni modifica
+    uint64_t brickMask() const { return bricks; }
+    bool     brickOccupied(int x, int y, int z) const { return (bricks >> brickIndex(x, y, z)) & 1; }
+
+    // Luce per voxel in un byte: 4 bit alti il cielo, 4 bassi i blocchi
+    // (la calcola LightEngine, non si salva su disco). Finché tutto il
+    // chunk ha la stessa luce, tipico di aria al sole o roccia al buio,
+    // basta un valore solo; l'array si crea alla prima differenza.
+    static uint8_t packLight(int sky, int block) { return (uint8_t)(sky << 4 | block); }
+
+    uint8_t getLightAt(int i) const { return light.empty() ? uniformLight : light[i]; }
+    void    setLightAt(int i, uint8_t value) {
+        if (light.empty()) {
+            if (value == uniformLight) return;
+            light.assign(CHUNK_VOLUME, uniformLight);
+        }
+        light[i] = value;
+    }
+    uint8_t getLight(int x, int y, int z) const { return getLightAt(index(x, y, z)); }
+    void    fillLight(uint8_t value) { light.clear(); light.shrink_to_fit(); uniformLight = value; }
+    // true se tutto il chunk vale value senza array per voxel
+    bool    isLightUniform(uint8_t value) const { return light.empty() && uniformLight == value; }
+
+    // false finché LightEngine non ha illuminato il chunk: fino ad
+    // allora la luce non ci entra, come in un chunk non caricato
+    bool isLit() const        { return lit; }
+    void setLit(bool value)   { lit = value; }
+
+    // La mesh del chunk non corrisponde più a blocchi e luce: lo segna
+    // World::markMeshDirty, che tiene la lista dei chunk con il bit acceso
+    bool isMeshDirty() const        { return meshDirty; }
+    void setMeshDirty(bool value)   { meshDirty = value; }
+
+    // Serializzazione per il salvataggio su disco: scrive i dati così
+    // come sono in memoria (bit per voxel, palette, parole impacchettate),
+    // quindi non serve ricostruire la palette né all'andata né al ritorno.
+    // serialize() aggiunge i byte in fondo a out.
+    void serialize(std::vector<uint8_t>& out) const;
+
+    // false (e chunk invariato) se i byte non sono un chunk valido
+    bool deserialize(const uint8_t* bytes, size_t size);
+
+    // Dimensione massima dei dati di serialize(): modalità diretta, 16 bit per voxel
+    static constexpr size_t MAX_SERIALIZED_SIZE = 1 + 2 + (size_t)CHUNK_VOLUME * 2;
+
+    // Informazioni sulla compressione, utili per debug e benchmark
+    int    bitsPerBlock() const { return bits; }
+    int    paletteSize() const  { return (int)palette.size(); }
+    size_t memoryUsage() const;
+
+private:
+    // Indice nella palette per il tipo id, aggiungendolo se manca.
+    // Può far crescere i bit per voxel (repack) o passare alla modalità diretta.
+    int  paletteIndexFor(BlockID id);
+    void repack(int newBits);
+
+    // Dopo la modifica del blocco i: accende il bit del suo brick o,
+    // se il brick può essersi svuotato, lo ricontrolla
+    void updateBrick(int i, BlockID old, BlockID id);
+
+    uint32_t readRaw(int i) const {
+        int bitIndex = i * bits;
+        return (uint32_t)((data[bitIndex >> 6] >> (bitIndex & 63)) & ((uint64_t(1) << bits) - 1));
+    }
+    void writeRaw(int i, uint32_t value) {
+        int bitIndex = i * bits;
+        uint64_t mask = ((uint64_t(1) << bits) - 1) << (bitIndex & 63);
+        uint64_t& word = data[bitIndex >> 6];
+        word = (word & ~mask) | ((uint64_t)value << (bitIndex & 63));
+    }
+
+    // Palette e dati hanno poche dimensioni possibili (i dati 512 byte
+    // per bit per voxel): li servono i pool a classi di dimensione
+    template <typename T>
+    using PaletteVector = PoolVector<T, MemoryTag::Palettes>;
+
+    PaletteVector<BlockID>  palette;   // tipi presenti nel chunk
+    PaletteVector<uint16_t> refCounts; // quanti voxel usano ogni voce della palette
+    PaletteVector<uint64_t> data;      // indici (o BlockID in modalità diretta) impacchettati
+    int bits        = 0;
+    int solidBlocks = 0;
+    uint64_t bricks = 0;
+
+    PoolVector<uint8_t, MemoryTag::Chunks> light; // vuoto: tutto il chunk vale uniformLight
+    uint8_t uniformLight = 0;
+    bool    lit = false;
+    bool    meshDirty = false;
+};
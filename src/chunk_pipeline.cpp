@@ -0,0 +1,178 @@
+#include "chunk_pipeline.h"
+
+#include <algorithm>
+
+#include "profiler.h"
+
+ChunkPipeline::ChunkPipeline(JobSystem& jobs, World& world, ChunkGenerator generator)
+    : jobs(jobs)
+    , world(world)
+    , generator(std::move(generator))
+{
+}
+
+ChunkPipeline::~ChunkPipeline() {
+    // I job in volo usano le nostre code: aspettiamo che finiscano
+    jobs.waitIdle();
+}
+
+float ChunkPipeline::priorityOf(const ChunkPos& pos) const {
+    glm::vec3 center(
+        (pos.x + 0.5f) * CHUNK_SIZE,
+        (pos.y + 0.5f) * CHUNK_SIZE,
+        (pos.z + 0.5f) * CHUNK_SIZE
+    );
+    return glm::length(center - cameraPosition);
+}
+
+void ChunkPipeline::requestChunk(const ChunkPos& pos) {
+    if (entries.count(pos)) return;
+    entries[pos] = Entry();
+
+    inFlight.fetch_add(1, std::memory_order_relaxed);
+    jobs.submit([this, pos] {
+        PROFILE_SCOPE("Generate chunk");
+        auto chunk = std::make_unique<Chunk>();
+        generator(pos, *chunk);
+        generatedQueue.push({ pos, std::move(chunk) });
+    }, priorityOf(pos));
+}
+
+void ChunkPipeline::requestMesh(const ChunkPos& pos) {
+    auto it = entries.find(pos);
+    if (it == entries.end() || it->second.state == ChunkState::Generating) return;
+
+    Entry& entry = it->second;
+    if (entry.needsMesh) return;
+    entry.needsMesh = true;
+
+    // Se una mesh è già in calcolo la rifaremo quando arriva (onMeshConsumed)
+    if (entry.state != ChunkState::Meshing) meshQueue.push_back(pos);
+}
+
+bool ChunkPipeline::neighboursReady(const ChunkPos& pos) const {
+    for (int dy = -1; dy <= 1; dy++)
+    for (int dz = -1; dz <= 1; dz++)
+    for (int dx = -1; dx <= 1; dx++) {
+        ChunkPos n = { pos.x + dx, pos.y + dy, pos.z + dz };
+        // Sopra e sotto i limiti del mondo c'è solo aria: non serve aspettare
+        if (n.y < WORLD_MIN_CHUNK_Y || n.y > WORLD_MAX_CHUNK_Y) continue;
+
+        auto it = entries.find(n);
+        if (it == entries.end() || it->second.state == ChunkState::Generating) return false;
+    }
+    return true;
+}
+
+void ChunkPipeline::unloadChunk(const ChunkPos& pos) {
+    entries.erase(pos);
+    world.removeChunk(pos);
+}
+
+bool ChunkPipeline::forgetMesh(const ChunkPos& pos) {
+    auto it = entries.find(pos);
+    if (it == entries.end() || it->second.state != ChunkState::Meshed) return false;
+    it->second.state   = ChunkState::Generated;
+    it->second.hasMesh = false;
+    return true;
+}
+
+void ChunkPipeline::update(const glm::vec3& position, int maxMeshStarts, Deadline deadline) {
+    PROFILE_SCOPE("Pipeline update");
+    cameraPosition = position;
+    auto pastDeadline = [deadline] { return deadline != NO_DEADLINE && Deadline::clock::now() >= deadline; };
+
+    // 1) Chunk generati dai worker → nel World (con la luce: è la parte
+    //    più cara, quindi dopo la deadline gli altri aspettano in coda)
+    GeneratedChunk generated;
+    int inserted = 0;
+    while ((inserted == 0 || !pastDeadline()) && generatedQueue.pop(generated)) {
+        inFlight.fetch_sub(1, std::memory_order_relaxed);
+
+        // Nel frattempo non serve più, o è il job di una richiesta
+        // precedente a uno scaricamento (il chunk è già arrivato)
+        auto it = entries.find(generated.pos);
+        if (it == entries.end() || it->second.state != ChunkState::Generating) continue;
+        inserted++;
+
+        world.insertChunk(generated.pos, std::move(generated.chunk));
+        it->second.state     = ChunkState::Generated;
+        it->second.needsMesh = true;
+        if (onInserted) onInserted(generated.pos);
+
+        // Questo chunk potrebbe essere l'ultimo vicino che mancava
+        // a qualcuno: lo rimettiamo in lista, insieme a se stesso
+        for (int dy = -1; dy <= 1; dy++)
+        for (int dz = -1; dz <= 1; dz++)
+        for (int dx = -1; dx <= 1; dx++) {
+            ChunkPos n = { generated.pos.x + dx, generated.pos.y + dy, generated.pos.z + dz };
+            auto neighbour = entries.find(n);
+            if (neighbour != entries.end() && neighbour->second.needsMesh &&
+                neighbour->second.state == ChunkState::Generated)
+                meshQueue.push_back(n);
+        }
+    }
+
+    if (meshQueue.empty()) return;
+
+    // 2) Tra i candidati teniamo quelli pronti, i più vicini prima.
+    //    Gli altri verranno rimessi in lista all'arrivo dei vicini.
+    std::sort(meshQueue.begin(), meshQueue.end(), [](const ChunkPos& a, const ChunkPos& b) {
+        return a.x != b.x ? a.x < b.x : a.y != b.y ? a.y < b.y : a.z < b.z;
+    });
+    meshQueue.erase(std::unique(meshQueue.begin(), meshQueue.end()), meshQueue.end());
+
+    // Lista di questo frame: nell'arena del frame, niente heap
+    ArenaScope scope(frameArena());
+    ArenaVector<ChunkPos> ready(frameArena());
+    ready.reserve(meshQueue.size());
+    for (const ChunkPos& pos : meshQueue) {
+        auto it = entries.find(pos);
+        if (it == entries.end() || !it->second.needsMesh || it->second.state == ChunkState::Meshing) continue;
+        if (neighboursReady(pos)) ready.push_back(pos);
+    }
+    std::sort(ready.begin(), ready.end(), [this](const ChunkPos& a, const ChunkPos& b) {
+        return priorityOf(a) < priorityOf(b);
+    });
+
+    meshQueue.clear();
+    for (int i = 0; i < (int)ready.size(); i++) {
+        if (i < maxMeshStarts && (i == 0 || !pastDeadline())) startMesh(ready[i]);
+        else meshQueue.push_back(ready[i]); // al prossimo frame
+    }
+}
+
+void ChunkPipeline::startMesh(const ChunkPos& pos) {
+    Entry& entry = entries[pos];
+    entry.state       = ChunkState::Meshing;
+    entry.needsMesh   = false;
+    entry.meshVersion = nextMeshVersion++;
+
+    // La copia dei blocchi si fa qui, sul render thread, perché il World
+    // non è thread-safe; il lavoro pesante (il meshing) va al worker
+    PooledMeshInput input = acquireMeshInput();
+    input->gather(world, pos);
+
+    inFlight.fetch_add(1, std::memory_order_relaxed);
+    jobs.submit([this, pos, version = entry.meshVersion, input = std::move(input)] {
+        PROFILE_SCOPE("Mesh chunk");
+        PooledChunkMesh mesh = acquireChunkMesh();
+        buildChunkMesh(*input, *mesh);
+        mesh->visibility = computeChunkVisibility(*input);
+        meshedQueue.push({ pos, version, std::move(mesh) });
+    }, priorityOf(pos));
+}
+
+bool ChunkPipeline::acceptMesh(const MeshedChunk& result) {
+    // Solo l'ultimo job lanciato per il chunk: quelli di prima di uno
+    // scaricamento (o di un chunk che non c'è più) si buttano
+    auto it = entries.find(result.pos);
+    if (it == entries.end() || it->second.state != ChunkState::Meshing || it->second.meshVersion != result.version)
+        return false;
+
+    it->second.state   = ChunkState::Meshed;
+    it->second.hasMesh = true;
+    // Una modifica arrivata mentre la mesh era in calcolo: la rifacciamo
+    if (it->second.needsMesh) meshQueue.push_back(result.pos);
+    return true;
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+
+#include <glm/glm.hpp>
+
+#include "job_system.h"
+#include "mesher.h"
+#include "mpsc_queue.h"
+#include "world.h"
+
+// Riempie un chunk vuoto: viene chiamata dai worker, in parallelo,
+// quindi non deve toccare stato condiviso
+using ChunkGenerator = std::function<void(const ChunkPos& pos, Chunk& chunk)>;
+
+// Chiamata sul render thread appena un chunk generato entra nel World,
+// prima che si possa meshare (es. per calcolarne la luce)
+using ChunkInsertedFn = std::function<void(const ChunkPos& pos)>;
+
+// Istante entro cui il lavoro del frame deve finire (vedi update)
+using Deadline = std::chrono::steady_clock::time_point;
+constexpr Deadline NO_DEADLINE = Deadline::max();
+
+// ---------------------------------------------------------------
+// ChunkPipeline
+// Porta un chunk da "non esiste" a "mesh pronta per la GPU" senza
+// bloccare il render thread:
+//
+//   requestChunk() → [worker] generazione → coda → update() lo inserisce nel World
+//   update()       → copia blocchi + bordo → [worker] meshing → coda → consumeMeshes()
+//
+// Il World viene toccato solo dal render thread: i worker lavorano
+// su dati propri (il chunk che stanno generando, una copia 18³ per
+// il meshing) e restituiscono il risultato con code MPSC senza lock.
+// ---------------------------------------------------------------
+class ChunkPipeline {
+public:
+    ChunkPipeline(JobSystem& jobs, World& world, ChunkGenerator generator);
+    ~ChunkPipeline();
+
+    ChunkPipeline(const ChunkPipeline&) = delete;
+    ChunkPipeline& operator=(const ChunkPipeline&) = delete;
+
+    // Chiede di generare un chunk. La priorità è la distanza dalla camera:
+    // i chunk più vicini vengono generati (e poi meshati) per primi.
+    void requestChunk(const ChunkPos& pos);
+
+    // Chiede di rifare la mesh di un chunk già generato (es. dopo una modifica)
+    void requestMesh(const ChunkPos& pos);
+
+    void setInsertedCallback(ChunkInsertedFn fn) { onInserted = std::move(fn); }
+
+    // Toglie il chunk dal World e dimentica tutto quello che lo riguarda:
+    // i job ancora in volo per lui verranno scartati. Le modifiche non
+    // salvate vanno perse, come con World::removeChunk.
+    void unloadChunk(const ChunkPos& pos);
+
+    // La mesh del chunk è stata tolta dalla GPU: isMeshed torna false e
+    // requestMesh la rifarà. false (e niente cambia) se una mesh è in calcolo.
+    bool forgetMesh(const ChunkPos& pos);
+
+    // Render thread, una volta per frame: inserisce nel mondo i chunk
+    // generati e lancia il meshing di quelli che hanno tutti i vicini pronti.
+    // maxMeshStarts limita quante copie 18³ fare in questo frame; passata
+    // la deadline si smette (dopo almeno un chunk per fase) e il resto
+    // aspetta il prossimo frame.
+    void update(const glm::vec3& cameraPosition, int maxMeshStarts = 32, Deadline deadline = NO_DEADLINE);
+
+    // Render thread: passa a fn(const ChunkPos&, const ChunkMesh&) al massimo
+    // maxCount mesh finite, da caricare sulla GPU, fermandosi alla deadline
+    // se ne ha già passata almeno una. Restituisce quante erano.
+    template <typename Fn>
+    int consumeMeshes(Fn&& fn, int maxCount, Deadline deadline = NO_DEADLINE) {
+        int count = 0;
+        MeshedChunk result;
+        while (count < maxCount && (count == 0 || deadline == NO_DEADLINE || Deadline::clock::now() < deadline) &&
+               meshedQueue.pop(result)) {
+            inFlight.fetch_sub(1, std::memory_order_relaxed);
+            if (!acceptMesh(result)) continue; // chunk scaricato o mesh superata
+            fn(result.pos, *result.mesh);
+            count++;
+        }
+        return count;
+    }
+
+    bool isRequested(const ChunkPos& pos) const { return entries.count(pos) != 0; }
+
+    // true se almeno una mesh del chunk è stata consegnata (anche se
+    // ora se ne sta calcolando una nuova)
+    bool isMeshed(const ChunkPos& pos) const {
+        auto it = entries.find(pos);
+        return it != entries.end() && it->second.hasMesh;
+    }
+
+    // true se tutti i chunk della colonna (cx, cz) hanno una mesh
+    bool isColumnMeshed(int cx, int cz) const {
+        for (int cy = WORLD_MIN_CHUNK_Y; cy <= WORLD_MAX_CHUNK_Y; cy++)
+            if (!isMeshed({ cx, cy, cz })) return false;
+        return true;
+    }
+
+    // Job lanciati e non ancora consegnati al render thread
+    int  jobsInFlight() const { return inFlight.load(std::memory_order_relaxed); }
+    bool isIdle() const { return jobsInFlight() == 0 && meshQueue.empty(); }
+
+private:
+    enum class ChunkState : uint8_t {
+        Generating, // job di generazione in corso
+        Generated,  // nel World, in attesa dei vicini per la mesh
+        Meshing,    // job di meshing in corso
+        Meshed      // mesh consegnata
+    };
+
+    struct Entry {
+        ChunkState state = ChunkState::Generating;
+        bool needsMesh   = false; // mesh da (ri)fare appena possibile
+        bool hasMesh     = false; // una mesh è già stata consegnata
+        uint32_t meshVersion = 0; // dell'ultimo job di meshing lanciato
+    };
+
+    struct GeneratedChunk {
+        ChunkPos pos{};
+        std::unique_ptr<Chunk> chunk;
+    };
+
+    struct MeshedChunk {
+        ChunkPos pos{};
+        uint32_t version = 0;
+        PooledChunkMesh mesh;
+    };
+
+    float priorityOf(const ChunkPos& pos) const;
+    bool  neighboursReady(const ChunkPos& pos) const;
+    void  startMesh(const ChunkPos& pos);
+    bool  acceptMesh(const MeshedChunk& result);
+
+    JobSystem&     jobs;
+    World&         world;
+    ChunkGenerator generator;
+    ChunkInsertedFn onInserted;
+
+    std::unordered_map<ChunkPos, Entry, ChunkPosHash> entries;
+    std::vector<ChunkPos> meshQueue; // chunk con needsMesh, da controllare in update()
+
+    MpscQueue<GeneratedChunk> generatedQueue;
+    MpscQueue<MeshedChunk>    meshedQueue;
+    std::atomic<int>          inFlight{ 0 };
+    uint32_t                  nextMeshVersion = 1;
+
+    glm::vec3 cameraPosition{ 0.0f };
+};
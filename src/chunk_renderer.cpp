@@ -0,0 +1,357 @@
+#include "chunk_renderer.h"
+
+#include <algorithm>
+#include <cstddef> // per offsetof
+#include <cstring>
+#include <iostream>
+
+#include <glad/glad.h>
+
+// Spazio iniziale dei buffer: basta per RENDER_DISTANCE = 8 con margine
+// (un chunk di terreno ha in media ~1000 vertici). Se finisce si raddoppia.
+constexpr uint32_t INITIAL_VERTEX_CAPACITY = 4u << 20; // 32 MB
+constexpr uint32_t INITIAL_INDEX_CAPACITY  = 6u << 20; // 12 MB
+constexpr int      INITIAL_MAX_DRAWS       = 4096;
+
+// Origine di un chunk per lo shader: ivec3 più il livello LOD (0 = chunk)
+constexpr size_t ORIGIN_STRIDE = 4 * sizeof(int32_t);
+
+ChunkRenderer::ChunkRenderer()
+    : vertexSpace(INITIAL_VERTEX_CAPACITY)
+    , indexSpace(INITIAL_INDEX_CAPACITY)
+{
+    indirect   = GLAD_GL_VERSION_4_3 != 0;
+    persistent = indirect && (GLAD_GL_VERSION_4_4 != 0 || GLAD_GL_ARB_buffer_storage != 0);
+
+    glGenVertexArrays(1, &vao);
+    vertexBuffer = createBuffer((size_t)INITIAL_VERTEX_CAPACITY * sizeof(PackedVertex));
+    indexBuffer  = createBuffer((size_t)INITIAL_INDEX_CAPACITY * sizeof(uint16_t));
+    if (indirect) ensureDrawCapacity(INITIAL_MAX_DRAWS);
+    setupVertexArray();
+
+    std::cout << "Chunk renderer: "
+              << (indirect ? "multi-draw indirect" : "GL 3.3, una draw call per chunk")
+              << (persistent ? ", buffer mappati in modo persistente" : "") << "\n";
+}
+
+ChunkRenderer::~ChunkRenderer() {
+    for (void*& fence : fences) {
+        if (fence) glDeleteSync((GLsync)fence);
+        fence = nullptr;
+    }
+    destroyBuffer(vertexBuffer);
+    destroyBuffer(indexBuffer);
+    destroyBuffer(commandBuffer);
+    destroyBuffer(instanceBuffer);
+    glDeleteVertexArrays(1, &vao);
+}
+
+// ---------------------------------------------------------------
+// Buffer
+// Tutte le scritture passano dal target GL_COPY_WRITE_BUFFER: legare
+// un buffer a GL_ELEMENT_ARRAY_BUFFER cambierebbe il VAO attivo.
+// ---------------------------------------------------------------
+
+ChunkRenderer::Buffer ChunkRenderer::createBuffer(size_t size) {
+    Buffer buffer;
+    buffer.size = size;
+    glGenBuffers(1, &buffer.id);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer.id);
+
+    if (persistent) {
+        // Mappato una volta per sempre: la CPU scrive con memcpy, e con
+        // COHERENT la GPU vede i dati senza flush espliciti
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_COPY_WRITE_BUFFER, (GLsizeiptr)size, nullptr, flags);
+        buffer.mapped = (uint8_t*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, (GLsizeiptr)size, flags);
+        if (!buffer.mapped) std::cerr << "Impossibile mappare un buffer di " << size << " byte\n";
+    } else {
+        glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)size, nullptr, GL_DYNAMIC_DRAW);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    return buffer;
+}
+
+void ChunkRenderer::destroyBuffer(Buffer& buffer) {
+    // Cancellare un buffer mappato lo smappa da solo
+    if (buffer.id) glDeleteBuffers(1, &buffer.id);
+    buffer = Buffer();
+}
+
+void ChunkRenderer::writeBuffer(const Buffer& buffer, size_t offset, const void* data, size_t size) {
+    if (buffer.mapped) {
+        std::memcpy(buffer.mapped + offset, data, size);
+        return;
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer.id);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)offset, (GLsizeiptr)size, data);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void ChunkRenderer::growBuffer(Buffer& buffer, size_t newSize) {
+    // Nuovo buffer più grande, copia sulla GPU e poi il vecchio si butta
+    Buffer grown = createBuffer(newSize);
+    glBindBuffer(GL_COPY_READ_BUFFER, buffer.id);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, grown.id);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, (GLsizeiptr)buffer.size);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    destroyBuffer(buffer);
+    buffer = grown;
+
+    // Succede di rado: aspettiamo la copia, così un memcpy nella parte
+    // copiata non può essere sovrascritto dalla copia stessa
+    glFinish();
+    setupVertexArray();
+}
+
+void ChunkRenderer::setupVertexArray() {
+    glBindVertexArray(vao);
+
+    // "I" = attributo intero: arriva allo shader come uint così com'è,
+    // senza conversione in float. I campi li estrae lo shader con shift e AND.
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer.id);
+    glVertexAttribIPointer(0, 1, GL_UNSIGNED_INT, sizeof(PackedVertex), (void*)offsetof(PackedVertex, position));
+    glEnableVertexAttribArray(0);
+    glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(PackedVertex), (void*)offsetof(PackedVertex, attributes));
+    glEnableVertexAttribArray(1);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer.id);
+
+    if (indirect) {
+        // Un valore per istanza: ogni comando ha una sola istanza e
+        // baseInstance sceglie l'origine del suo chunk
+        glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer.id);
+        glVertexAttribIPointer(2, 4, GL_INT, (GLsizei)ORIGIN_STRIDE, (void*)0);
+        glVertexAttribDivisor(2, 1);
+        glEnableVertexAttribArray(2);
+    } else {
+        // Senza array l'attributo prende il valore di glVertexAttribI4i
+        glDisableVertexAttribArray(2);
+    }
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void ChunkRenderer::ensureDrawCapacity(int draws) {
+    if (draws <= maxDraws) return;
+
+    // I buffer per frame cambiano dimensione: la GPU deve aver finito con quelli vecchi
+    glFinish();
+    for (void*& fence : fences) {
+        if (fence) glDeleteSync((GLsync)fence);
+        fence = nullptr;
+    }
+    destroyBuffer(commandBuffer);
+    destroyBuffer(instanceBuffer);
+
+    maxDraws       = std::max(draws, maxDraws * 2);
+    commandBuffer  = createBuffer((size_t)maxDraws * FRAMES_IN_FLIGHT * sizeof(DrawCommand));
+    instanceBuffer = createBuffer((size_t)maxDraws * FRAMES_IN_FLIGHT * ORIGIN_STRIDE);
+    setupVertexArray();
+}
+
+// ---------------------------------------------------------------
+// Mesh
+// ---------------------------------------------------------------
+
+bool ChunkRenderer::allocate(const ChunkMesh& mesh, Allocation& allocation) {
+    allocation.vertexCount = (uint32_t)mesh.vertices.size();
+    allocation.indexCount  = (uint32_t)mesh.indices.size();
+    allocation.splitVertex = mesh.splitVertex;
+    allocation.splitIndex  = mesh.splitIndex;
+
+    allocation.firstVertex = vertexSpace.allocate(allocation.vertexCount);
+    if (allocation.firstVertex == BufferAllocator::INVALID) {
+        uint32_t capacity = std::max(vertexSpace.capacity() * 2, vertexSpace.capacity() + allocation.vertexCount);
+        growBuffer(vertexBuffer, (size_t)capacity * sizeof(PackedVertex));
+        vertexSpace.grow(capacity);
+        allocation.firstVertex = vertexSpace.allocate(allocation.vertexCount);
+    }
+
+    allocation.firstIndex = indexSpace.allocate(allocation.indexCount);
+    if (allocation.firstIndex == BufferAllocator::INVALID) {
+        uint32_t capacity = std::max(indexSpace.capacity() * 2, indexSpace.capacity() + allocation.indexCount);
+        growBuffer(indexBuffer, (size_t)capacity * sizeof(uint16_t));
+        indexSpace.grow(capacity);
+        allocation.firstIndex = indexSpace.allocate(allocation.indexCount);
+    }
+    return allocation.firstVertex != BufferAllocator::INVALID && allocation.firstIndex != BufferAllocator::INVALID;
+}
+
+bool ChunkRenderer::store(const ChunkMesh& mesh, Allocation& allocation) {
+    if (!allocate(mesh, allocation)) {
+        std::cerr << "Spazio esaurito nei buffer dei chunk\n";
+        return false;
+    }
+
+    // Gli indici restano locali alla mesh: baseVertex li sposta al posto giusto
+    writeBuffer(vertexBuffer, (size_t)allocation.firstVertex * sizeof(PackedVertex),
+                mesh.vertices.data(), mesh.vertices.size() * sizeof(PackedVertex));
+    writeBuffer(indexBuffer, (size_t)allocation.firstIndex * sizeof(uint16_t),
+                mesh.indices.data(), mesh.indices.size() * sizeof(uint16_t));
+    return true;
+}
+
+void ChunkRenderer::upload(const ChunkPos& pos, const ChunkMesh& mesh) {
+    // La mesh vecchia si libera solo dopo che quella nuova ha trovato
+    // posto: se i buffer sono pieni resta disegnata quella di prima
+    Allocation allocation;
+    if (!mesh.empty() && !store(mesh, allocation)) return;
+
+    remove(pos);
+    if (!mesh.empty()) chunks[pos] = allocation;
+}
+
+void ChunkRenderer::remove(const ChunkPos& pos) {
+    auto it = chunks.find(pos);
+    if (it == chunks.end()) return;
+    retire(it->second);
+    chunks.erase(it);
+}
+
+void ChunkRenderer::upload(const LodNode& node, const ChunkMesh& mesh) {
+    remove(node);
+    if (mesh.empty()) return;
+
+    Allocation allocation;
+    if (store(mesh, allocation)) lodNodes[node] = allocation;
+}
+
+void ChunkRenderer::remove(const LodNode& node) {
+    auto it = lodNodes.find(node);
+    if (it == lodNodes.end()) return;
+    retire(it->second);
+    lodNodes.erase(it);
+}
+
+void ChunkRenderer::retire(const Allocation& allocation) {
+    // Con glBufferSubData ci pensa il driver a non sovrascrivere dati
+    // in uso; con la mappatura persistente tocca a noi aspettare
+    if (persistent) retired.push_back({ frame, allocation });
+    else release(allocation);
+}
+
+void ChunkRenderer::release(const Allocation& allocation) {
+    vertexSpace.free(allocation.firstVertex, allocation.vertexCount);
+    indexSpace.free(allocation.firstIndex, allocation.indexCount);
+}
+
+// ---------------------------------------------------------------
+// Disegno
+// ---------------------------------------------------------------
+
+void ChunkRenderer::addDraw(const Allocation& a, const ChunkPos& pos, int level) {
+    // Una mesh oltre i 65536 vertici sono due draw, ognuna con la sua baseVertex
+    if (a.splitIndex == 0) {
+        addPart(a.firstIndex, a.indexCount, a.firstVertex, pos, level);
+        return;
+    }
+    addPart(a.firstIndex, a.splitIndex, a.firstVertex, pos, level);
+    addPart(a.firstIndex + a.splitIndex, a.indexCount - a.splitIndex, a.firstVertex + a.splitVertex, pos, level);
+}
+
+void ChunkRenderer::addPart(uint32_t firstIndex, uint32_t indexCount, uint32_t baseVertex, const ChunkPos& pos, int level) {
+    int size = CHUNK_SIZE << level;
+
+    if (!indirect) {
+        glVertexAttribI4i(2, pos.x * size, pos.y * size, pos.z * size, level);
+        glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)indexCount, GL_UNSIGNED_SHORT,
+                                 (void*)((size_t)firstIndex * sizeof(uint16_t)), (GLint)baseVertex);
+        drawCalls++;
+        return;
+    }
+
+    DrawCommand command;
+    command.count         = indexCount;
+    command.instanceCount = 1;
+    command.firstIndex    = firstIndex;
+    command.baseVertex    = (int32_t)baseVertex;
+    command.baseInstance  = 0; // sistemato in draw(), quando si conosce maxDraws
+    commands.push_back(command);
+
+    origins.insert(origins.end(), { pos.x * size, pos.y * size, pos.z * size, level });
+}
+
+void ChunkRenderer::draw(const std::vector<ChunkPos>& visible, const std::vector<LodNode>& lodVisible) {
+    drawCalls = 0;
+    glBindVertexArray(vao);
+
+    // Con OpenGL 3.3 addDraw disegna subito; con l'indirect raccoglie i comandi
+    auto addAll = [&] {
+        for (const ChunkPos& pos : visible) {
+            auto it = chunks.find(pos);
+            if (it != chunks.end()) addDraw(it->second, pos, 0);
+        }
+        for (const LodNode& node : lodVisible) {
+            auto it = lodNodes.find(node);
+            if (it != lodNodes.end()) addDraw(it->second, node.pos, node.level);
+        }
+    };
+
+    if (!indirect) {
+        addAll();
+        glBindVertexArray(0);
+        frame++;
+        return;
+    }
+
+    int slot = (int)(frame % FRAMES_IN_FLIGHT);
+
+    // La copia dei dati per frame che stiamo per riscrivere era del
+    // frame (frame - FRAMES_IN_FLIGHT): aspettiamo che la GPU l'abbia usata
+    if (persistent && fences[slot]) {
+        GLsync fence = (GLsync)fences[slot];
+        while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED) {}
+        glDeleteSync(fence);
+        fences[slot] = nullptr;
+    }
+
+    // Ora la GPU ha finito tutti i frame fino a (frame - FRAMES_IN_FLIGHT):
+    // lo spazio tolto a un chunk prima del frame (frame - FRAMES_IN_FLIGHT + 1)
+    // non è più letto da nessuno
+    while (!retired.empty() && retired.front().frame + FRAMES_IN_FLIGHT - 1 <= frame) {
+        release(retired.front().allocation);
+        retired.pop_front();
+    }
+
+    commands.clear();
+    origins.clear();
+    addAll();
+
+    if (!commands.empty()) {
+        ensureDrawCapacity((int)commands.size());
+        uint32_t firstInstance = (uint32_t)(slot * maxDraws);
+        for (size_t i = 0; i < commands.size(); i++) commands[i].baseInstance = firstInstance + (uint32_t)i;
+
+        size_t commandOffset = (size_t)slot * maxDraws * sizeof(DrawCommand);
+        writeBuffer(commandBuffer, commandOffset, commands.data(), commands.size() * sizeof(DrawCommand));
+        writeBuffer(instanceBuffer, (size_t)firstInstance * ORIGIN_STRIDE, origins.data(), origins.size() * sizeof(int32_t));
+
+        // ensureDrawCapacity può aver ricreato il VAO: lo rileghiamo
+        glBindVertexArray(vao);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer.id);
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_SHORT, (void*)commandOffset, (GLsizei)commands.size(), 0);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        drawCalls = 1;
+    }
+
+    if (persistent) fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glBindVertexArray(0);
+    frame++;
+}
+
+int ChunkRenderer::triangleCount() const {
+    int total = 0;
+    for (const auto& [pos, allocation] : chunks) total += (int)allocation.indexCount / 3;
+    for (const auto& [node, allocation] : lodNodes) total += (int)allocation.indexCount / 3;
+    return total;
+}
+
+size_t ChunkRenderer::gpuBytesUsed() const {
+    return (size_t)vertexSpace.used() * sizeof(PackedVertex) + (size_t)indexSpace.used() * sizeof(uint16_t);
+}
+
+size_t ChunkRenderer::gpuBytesCapacity() const {
+    return vertexBuffer.size + indexBuffer.size;
+}
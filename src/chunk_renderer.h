@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+#include "buffer_allocator.h"
+#include "lod.h"
+#include "mesher.h"
+
+// ---------------------------------------------------------------
+// ChunkRenderer
+// Tutte le mesh dei chunk stanno in due buffer grandi (uno per i
+// vertici e uno per gli indici), divisi tra i chunk con un
+// BufferAllocator. Così un solo VAO descrive tutto il mondo e i
+// chunk visibili si disegnano con una sola chiamata:
+//
+//  - OpenGL 4.3+: glMultiDrawElementsIndirect. Ogni comando dice
+//    dove sta la mesh nei buffer; l'origine del chunk arriva allo
+//    shader come attributo "per istanza" scelto da baseInstance,
+//    senza cambiare uniform tra un chunk e l'altro.
+//  - OpenGL 4.4+: i buffer sono mappati in modo persistente, le mesh
+//    si copiano con un memcpy e i fence evitano di sovrascrivere
+//    dati che la GPU sta ancora leggendo.
+//  - OpenGL 3.3: stessi buffer, caricati con glBufferSubData, e una
+//    glDrawElementsBaseVertex per chunk con l'origine passata come
+//    valore costante dell'attributo (glVertexAttribI4i).
+//
+// Gli stessi buffer contengono anche le mesh dei nodi LOD (lod.h):
+// per lo shader sono chunk con una scala, 2^livello.
+//
+// Lo shader deve avere: location 0 e 1 = vertice compatto,
+// location 2 = ivec4 origine del chunk in blocchi + livello LOD.
+// ---------------------------------------------------------------
+class ChunkRenderer {
+public:
+    // Serve un contesto OpenGL attivo: la strada si sceglie dalla sua versione
+    ChunkRenderer();
+    ~ChunkRenderer();
+
+    // Le risorse GPU non si possono copiare: vietiamo la copia
+    ChunkRenderer(const ChunkRenderer&) = delete;
+    ChunkRenderer& operator=(const ChunkRenderer&) = delete;
+
+    // Carica (o sostituisce) la mesh di un chunk. Una mesh vuota
+    // libera lo spazio del chunk, se ne aveva.
+    void upload(const ChunkPos& pos, const ChunkMesh& mesh);
+    void remove(const ChunkPos& pos);
+
+    // Lo stesso per i nodi LOD
+    void upload(const LodNode& node, const ChunkMesh& mesh);
+    void remove(const LodNode& node);
+
+    // Disegna le mesh dei chunk in visible (di solito l'uscita del
+    // ChunkCuller) e dei nodi in lodVisible, tutte insieme.
+    // Lo shader deve essere già attivo con view e projection.
+    void draw(const std::vector<ChunkPos>& visible, const std::vector<LodNode>& lodVisible = {});
+
+    int chunkCount() const   { return (int)chunks.size(); }
+    int lodNodeCount() const { return (int)lodNodes.size(); }
+    int triangleCount() const; // chunk e nodi LOD
+    int drawCallCount() const { return drawCalls; } // nell'ultimo draw()
+
+    bool usesIndirect() const   { return indirect; }
+    bool usesPersistent() const { return persistent; }
+
+    // Memoria dei buffer delle mesh: occupata e totale, in byte
+    size_t gpuBytesUsed() const;
+    size_t gpuBytesCapacity() const;
+
+private:
+    struct Allocation {
+        uint32_t firstVertex = 0;
+        uint32_t vertexCount = 0;
+        uint32_t firstIndex  = 0;
+        uint32_t indexCount  = 0;
+        uint32_t splitVertex = 0; // seconda parte della mesh (vedi ChunkMesh)
+        uint32_t splitIndex  = 0;
+    };
+
+    // Formato fisso di OpenGL per i comandi indiretti
+    struct DrawCommand {
+        uint32_t count;
+        uint32_t instanceCount;
+        uint32_t firstIndex;
+        int32_t  baseVertex;
+        uint32_t baseInstance;
+    };
+
+    struct Buffer {
+        unsigned int id     = 0;
+        uint8_t*     mapped = nullptr; // solo con la mappatura persistente
+        size_t       size   = 0;
+    };
+
+    // Quanti frame la CPU può stare avanti alla GPU: i dati per frame
+    // (comandi e origini) ruotano su tante copie quanti sono i frame
+    static constexpr int FRAMES_IN_FLIGHT = 3;
+
+    Buffer createBuffer(size_t size);
+    void   destroyBuffer(Buffer& buffer);
+    void   writeBuffer(const Buffer& buffer, size_t offset, const void* data, size_t size);
+    void   growBuffer(Buffer& buffer, size_t newSize);
+    void   setupVertexArray();
+    void   ensureDrawCapacity(int draws);
+    bool   allocate(const ChunkMesh& mesh, Allocation& allocation);
+    bool   store(const ChunkMesh& mesh, Allocation& allocation);
+    void   addDraw(const Allocation& allocation, const ChunkPos& pos, int level);
+    void   addPart(uint32_t firstIndex, uint32_t indexCount, uint32_t baseVertex, const ChunkPos& pos, int level);
+    void   retire(const Allocation& allocation);
+    void   release(const Allocation& allocation);
+
+    bool indirect   = false;
+    bool persistent = false;
+
+    unsigned int vao = 0;
+    Buffer vertexBuffer;   // PackedVertex
+    Buffer indexBuffer;    // uint16_t, relativi a baseVertex
+    Buffer commandBuffer;  // DrawCommand × maxDraws × FRAMES_IN_FLIGHT
+    Buffer instanceBuffer; // origine dei chunk, 4 int × maxDraws × FRAMES_IN_FLIGHT
+    int    maxDraws = 0;
+
+    BufferAllocator vertexSpace;
+    BufferAllocator indexSpace;
+    std::unordered_map<ChunkPos, Allocation, ChunkPosHash> chunks;
+    std::unordered_map<LodNode, Allocation, LodNodeHash>   lodNodes;
+
+    // Spazio liberato ma forse ancora letto dalla GPU: torna libero
+    // solo dopo FRAMES_IN_FLIGHT frame (serve solo con la mappatura persistente)
+    struct Retired {
+        uint64_t   frame;
+        Allocation allocation;
+    };
+    std::deque<Retired> retired;
+
+    void*    fences[FRAMES_IN_FLIGHT] = {}; // GLsync
+    uint64_t frame     = 0;
+    int      drawCalls = 0;
+
+    std::vector<DrawCommand> commands;
+    std::vector<int32_t>     origins;
+};
@@ -0,0 +1,217 @@
+#include "chunk_streamer.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "profiler.h"
+
+static const float  VELOCITY_SMOOTHING = 0.25f;  // secondi: media mobile della velocità
+static const float  MAX_SPEED          = 500.0f; // blocchi/s: oltre è un teletrasporto
+static const float  CPU_CHECK_INTERVAL = 0.25f;  // secondi tra due misure della memoria del World
+static const double EVICT_TARGET       = 0.9;    // si scarica fino al 90% del budget
+static const int    MAX_EVICTIONS_PER_FRAME = 16; // colonne, per non allungare il frame
+
+ChunkStreamer::ChunkStreamer(World& world, ChunkPipeline& pipeline, StreamingSettings settings)
+    : world(world)
+    , pipeline(pipeline)
+    , config(settings)
+{
+}
+
+static glm::ivec2 columnOf(const glm::vec3& position) {
+    return { (int)std::floor(position.x) >> CHUNK_SHIFT, (int)std::floor(position.z) >> CHUNK_SHIFT };
+}
+
+void ChunkStreamer::update(const glm::vec3& position, float deltaTime, const ColumnRegion& region) {
+    PROFILE_SCOPE("Streaming");
+    auto start = Deadline::clock::now();
+    lastWorkMs = std::chrono::duration<float, std::milli>(frameWork).count();
+    frameWork  = Deadline::duration::zero();
+    deadline   = start + std::chrono::duration_cast<Deadline::duration>(std::chrono::duration<float>(config.frameBudget));
+    frame++;
+
+    // 1) Velocità: media mobile, così un frame lento non sposta la previsione
+    if (hasPosition && deltaTime > 0.0f) {
+        glm::vec3 instant = (position - lastPosition) / deltaTime;
+        if (glm::length(instant) > MAX_SPEED) velocity = glm::vec3(0.0f);
+        else velocity += (instant - velocity) * (1.0f - std::exp(-deltaTime / VELOCITY_SMOOTHING));
+    }
+    lastPosition = position;
+    hasPosition  = true;
+
+    // 2) Regione attorno alla camera e la stessa spostata dove sarà
+    //    tra lookAhead secondi: le richieste cambiano solo se cambiano loro
+    cameraColumn = columnOf(position);
+    glm::ivec2 shift = columnOf(position + velocity * config.lookAhead) - cameraColumn;
+    ColumnRegion predicted = { region.min + shift, region.max + shift };
+    if (!(region == current) || !(predicted == ahead)) {
+        current = region;
+        ahead   = predicted;
+        request(current, cameraColumn);
+        if (!(ahead == current)) request(ahead, cameraColumn + shift);
+    }
+
+    // 3) Budget di memoria
+    sinceCpuCheck += deltaTime;
+    if (sinceCpuCheck >= CPU_CHECK_INTERVAL) {
+        sinceCpuCheck = 0.0f;
+        cpuBytes = world.memoryUsage();
+    }
+    overBudget = false;
+    if (cpuBytes > config.cpuBudget) evictCpu();
+    if (gpuBytes > config.gpuBudget) evictGpu();
+
+    // 4) Generazione e meshing, con priorità ai chunk verso cui si va
+    glm::vec3 focus = position + velocity * (config.lookAhead * 0.5f);
+    pipeline.update(focus, config.maxMeshStarts, deadline);
+
+    frameWork += Deadline::clock::now() - start;
+}
+
+void ChunkStreamer::request(const ColumnRegion& region, const glm::ivec2& center) {
+    // A spirale: le colonne più vicine al centro per prime
+    static thread_local std::vector<glm::ivec2> order;
+    order.clear();
+    for (int z = region.min.y; z <= region.max.y; z++)
+        for (int x = region.min.x; x <= region.max.x; x++) order.push_back({ x, z });
+    auto distance = [&center](const glm::ivec2& c) {
+        glm::ivec2 d = c - center;
+        return d.x * d.x + d.y * d.y;
+    };
+    std::sort(order.begin(), order.end(), [&](const glm::ivec2& a, const glm::ivec2& b) { return distance(a) < distance(b); });
+
+    for (const glm::ivec2& c : order) {
+        Column& column  = columns[columnKey(c.x, c.y)];
+        column.lastUsed = frame;
+        for (int y = WORLD_MIN_CHUNK_Y; y <= WORLD_MAX_CHUNK_Y; y++) {
+            ChunkPos pos = { c.x, y, c.y };
+            // Colonna ancora in memoria ma senza mesh: si rimeshano i chunk
+            if (column.meshesEvicted && !pipeline.isMeshed(pos)) pipeline.requestMesh(pos);
+            pipeline.requestChunk(pos);
+        }
+        column.meshesEvicted = false;
+    }
+}
+
+void ChunkStreamer::onMeshUploaded(const ChunkPos& pos, const ChunkMesh& mesh) {
+    size_t bytes = mesh.byteSize();
+    Column& column = columns[columnKey(pos.x, pos.z)];
+
+    auto it = meshBytes.find(pos);
+    if (it != meshBytes.end()) {
+        gpuBytes        -= it->second;
+        column.gpuBytes -= it->second;
+        meshBytes.erase(it);
+    }
+    if (bytes == 0) return; // una mesh vuota non occupa la GPU
+    meshBytes[pos]   = bytes;
+    gpuBytes        += bytes;
+    column.gpuBytes += bytes;
+}
+
+void ChunkStreamer::touch(const std::vector<ChunkPos>& drawn) {
+    for (const ChunkPos& pos : drawn) {
+        auto it = columns.find(columnKey(pos.x, pos.z));
+        if (it != columns.end()) it->second.lastUsed = frame;
+    }
+}
+
+void ChunkStreamer::takeEvictedMeshes(std::vector<ChunkPos>& out) {
+    out.swap(evictedMeshes);
+    evictedMeshes.clear();
+}
+
+// Colonne che si possono togliere, prima quelle usate meno di recente
+// e, tra quelle usate nello stesso frame, le più lontane
+void ChunkStreamer::evictionCandidates(bool gpu, std::vector<Candidate>& out) const {
+    out.clear();
+    for (const auto& [key, column] : columns) {
+        if (isKept(key.x, key.z)) continue;
+        if (gpu && (column.gpuBytes == 0 || column.meshesEvicted)) continue;
+        int dx = key.x - cameraColumn.x, dz = key.z - cameraColumn.y;
+        out.push_back({ column.lastUsed, dx * dx + dz * dz, key });
+    }
+    std::sort(out.begin(), out.end(), [](const Candidate& a, const Candidate& b) {
+        return a.lastUsed != b.lastUsed ? a.lastUsed < b.lastUsed : a.distance > b.distance;
+    });
+}
+
+void ChunkStreamer::evictCpu() {
+    PROFILE_SCOPE("Evict chunks");
+    static thread_local std::vector<Candidate> candidates;
+    evictionCandidates(false, candidates);
+
+    size_t target = (size_t)(config.cpuBudget * EVICT_TARGET);
+    int evicted = 0;
+    for (const Candidate& candidate : candidates) {
+        const ChunkPos& key = candidate.key;
+        if (cpuBytes <= target || evicted == MAX_EVICTIONS_PER_FRAME) return;
+        for (int y = WORLD_MIN_CHUNK_Y; y <= WORLD_MAX_CHUNK_Y; y++) {
+            ChunkPos pos = { key.x, y, key.z };
+            if (const Chunk* chunk = world.getChunk(pos)) {
+                cpuBytes -= std::min(cpuBytes, chunk->memoryUsage());
+                if (onUnload) onUnload(pos, *chunk);
+            }
+            pipeline.unloadChunk(pos);
+
+            auto mesh = meshBytes.find(pos);
+            if (mesh == meshBytes.end()) continue;
+            gpuBytes -= mesh->second;
+            meshBytes.erase(mesh);
+            evictedMeshes.push_back(pos);
+            evictedMeshCount++;
+        }
+        columns.erase(key);
+        evictedColumnCount++;
+        evicted++;
+    }
+    // Restano solo colonne da tenere: il budget è troppo piccolo per la regione
+    if (cpuBytes > target && evicted < MAX_EVICTIONS_PER_FRAME) overBudget = true;
+}
+
+void ChunkStreamer::evictGpu() {
+    PROFILE_SCOPE("Evict meshes");
+    static thread_local std::vector<Candidate> candidates;
+    evictionCandidates(true, candidates);
+
+    size_t target = (size_t)(config.gpuBudget * EVICT_TARGET);
+    int evicted = 0;
+    for (const Candidate& candidate : candidates) {
+        const ChunkPos& key = candidate.key;
+        if (gpuBytes <= target || evicted == MAX_EVICTIONS_PER_FRAME) return;
+        Column& column = columns[key];
+        for (int y = WORLD_MIN_CHUNK_Y; y <= WORLD_MAX_CHUNK_Y; y++) {
+            ChunkPos pos = { key.x, y, key.z };
+            auto mesh = meshBytes.find(pos);
+            // Una mesh in calcolo arriverà comunque: la si toglierà la prossima volta
+            if (mesh == meshBytes.end() || !pipeline.forgetMesh(pos)) continue;
+            gpuBytes        -= mesh->second;
+            column.gpuBytes -= mesh->second;
+            meshBytes.erase(mesh);
+            evictedMeshes.push_back(pos);
+            evictedMeshCount++;
+        }
+        column.meshesEvicted = true;
+        evicted++;
+    }
+    if (gpuBytes > target && evicted < MAX_EVICTIONS_PER_FRAME) overBudget = true;
+}
+
+StreamingStats ChunkStreamer::stats() const {
+    StreamingStats s;
+    s.residentColumns = (int)columns.size();
+    s.residentChunks  = world.chunkCount();
+    s.meshedChunks    = (int)meshBytes.size();
+    for (const auto& [key, column] : columns) s.keptColumns += isKept(key.x, key.z);
+    s.cpuBytes        = cpuBytes;
+    s.cpuBudget       = config.cpuBudget;
+    s.gpuBytes        = gpuBytes;
+    s.gpuBudget       = config.gpuBudget;
+    s.overBudget      = overBudget;
+    s.evictedColumns  = evictedColumnCount;
+    s.evictedMeshes   = evictedMeshCount;
+    s.velocity        = velocity;
+    s.predicted       = lastPosition + velocity * config.lookAhead;
+    s.workMs          = lastWorkMs;
+    return s;
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "chunk_pipeline.h"
+
+// Rettangolo di colonne di chunk (x e z, estremi inclusi)
+struct ColumnRegion {
+    glm::ivec2 min{ 0 };
+    glm::ivec2 max{ -1 };
+
+    bool contains(int x, int z) const { return x >= min.x && x <= max.x && z >= min.y && z <= max.y; }
+    bool operator==(const ColumnRegion& o) const { return min == o.min && max == o.max; }
+};
+
+struct StreamingSettings {
+    float  lookAhead     = 1.0f;      // secondi di volo anticipati dalla previsione
+    size_t cpuBudget     = 256u << 20; // byte dei chunk nel World (blocchi e luce)
+    size_t gpuBudget     = 128u << 20; // byte delle mesh dei chunk sulla GPU
+    float  frameBudget   = 0.004f;    // secondi per frame di streaming sul render thread
+    int    maxMeshStarts = 32;        // copie 18³ per frame, al più
+};
+
+struct StreamingStats {
+    int       residentColumns  = 0;
+    int       residentChunks   = 0;
+    int       meshedChunks     = 0; // con una mesh sulla GPU
+    int       keptColumns      = 0; // attorno alla camera e nella zona prevista
+    size_t    cpuBytes         = 0;
+    size_t    cpuBudget        = 0;
+    size_t    gpuBytes         = 0;
+    size_t    gpuBudget        = 0;
+    bool      overBudget       = false; // quello da tenere non sta nel budget
+    long long evictedColumns   = 0;     // colonne scaricate dall'avvio
+    long long evictedMeshes    = 0;     // mesh tolte dalla GPU dall'avvio
+    glm::vec3 velocity{ 0.0f };
+    glm::vec3 predicted{ 0.0f };        // dove sarà la camera tra lookAhead secondi
+    float     workMs           = 0.0f;  // streaming sul render thread, ultimo frame
+};
+
+// Chiamata prima di togliere un chunk dal World (per salvarlo se modificato)
+using ChunkUnloadFn = std::function<void(const ChunkPos& pos, const Chunk& chunk)>;
+
+// ---------------------------------------------------------------
+// ChunkStreamer
+// Decide quali chunk tenere attorno alla camera e guida la
+// ChunkPipeline. Ogni frame:
+//
+//  - stima la velocità della camera e chiede, oltre alla regione
+//    attorno a lei, quella dove sarà tra lookAhead secondi: in volo i
+//    chunk davanti partono prima che la camera ci arrivi. Le richieste
+//    vanno in ordine di distanza (a spirale) e la pipeline dà priorità
+//    ai chunk vicini al punto a metà strada verso la previsione;
+//  - fa lavorare pipeline e caricamenti solo per frameBudget secondi:
+//    quello che avanza aspetta il frame dopo, così un volo veloce non
+//    allunga il frame;
+//  - se i chunk caricati o le mesh sulla GPU superano il loro budget
+//    scarica colonne intere (CPU) o ne toglie solo le mesh (GPU),
+//    a partire da quelle usate meno di recente e, a pari merito, più
+//    lontane. Le colonne nelle due regioni non si toccano mai.
+//
+// Si lavora a colonne perché la luce del cielo scende dall'alto: un
+// chunk senza quello sopra resterebbe al buio (vedi LightEngine).
+// ---------------------------------------------------------------
+class ChunkStreamer {
+public:
+    ChunkStreamer(World& world, ChunkPipeline& pipeline, StreamingSettings settings = {});
+
+    void setUnloadCallback(ChunkUnloadFn fn) { onUnload = std::move(fn); }
+
+    // Render thread, una volta per frame: region sono le colonne che
+    // servono attorno alla camera (la previsione si ottiene spostandola)
+    void update(const glm::vec3& cameraPosition, float deltaTime, const ColumnRegion& region);
+
+    // Render thread, dopo update: passa a fn(const ChunkPos&, const ChunkMesh&)
+    // le mesh finite finché dura il budget del frame (almeno una, al più maxCount)
+    template <typename Fn>
+    int uploadMeshes(Fn&& fn, int maxCount) {
+        auto start = Deadline::clock::now();
+        int count = pipeline.consumeMeshes([&](const ChunkPos& pos, const ChunkMesh& mesh) {
+            fn(pos, mesh);
+            onMeshUploaded(pos, mesh);
+        }, maxCount, deadline);
+        frameWork += Deadline::clock::now() - start;
+        return count;
+    }
+
+    // I chunk disegnati in questo frame contano come usati (LRU)
+    void touch(const std::vector<ChunkPos>& drawn);
+
+    // Chunk la cui mesh va tolta dalla GPU (svuota l'elenco interno)
+    void takeEvictedMeshes(std::vector<ChunkPos>& out);
+
+    StreamingStats stats() const;
+    const StreamingSettings& settings() const { return config; }
+
+private:
+    struct Column {
+        uint64_t lastUsed      = 0; // frame dell'ultimo uso
+        size_t   gpuBytes      = 0;
+        bool     meshesEvicted = false;
+    };
+
+    struct Candidate {
+        uint64_t lastUsed;
+        int      distance; // al quadrato, in colonne dalla camera
+        ChunkPos key;
+    };
+
+    static ChunkPos columnKey(int x, int z) { return { x, 0, z }; }
+
+    void request(const ColumnRegion& region, const glm::ivec2& center);
+    void onMeshUploaded(const ChunkPos& pos, const ChunkMesh& mesh);
+    bool isKept(int x, int z) const { return current.contains(x, z) || ahead.contains(x, z); }
+    void evictionCandidates(bool gpu, std::vector<Candidate>& out) const;
+    void evictCpu();
+    void evictGpu();
+
+    World&            world;
+    ChunkPipeline&    pipeline;
+    StreamingSettings config;
+    ChunkUnloadFn     onUnload;
+
+    std::unordered_map<ChunkPos, Column, ChunkPosHash>   columns;
+    std::unordered_map<ChunkPos, size_t, ChunkPosHash>   meshBytes; // per chunk con mesh
+    std::vector<ChunkPos> evictedMeshes;
+
+    ColumnRegion current;
+    ColumnRegion ahead;
+    glm::ivec2   cameraColumn{ 0 };
+    glm::vec3    lastPosition{ 0.0f };
+    glm::vec3    velocity{ 0.0f };
+    bool         hasPosition = false;
+
+    uint64_t frame          = 0;
+    float    sinceCpuCheck  = 0.0f;
+    size_t   cpuBytes       = 0; // all'ultimo controllo
+    size_t   gpuBytes       = 0;
+    bool     overBudget     = false;
+    long long evictedColumnCount = 0;
+    long long evictedMeshCount   = 0;
+
+    Deadline deadline = NO_DEADLINE;
+    Deadline::duration frameWork{ 0 };
+    float    lastWorkMs = 0.0f;
+};
@@ -0,0 +1,150 @@
+#include "client.h"
+
+#include <cmath>
+#include <memory>
+
+static const float ENTITY_SCALE = 0.8f;
+static const int   HELLO_RETRY_UPDATES = 10;
+
+GameClient::GameClient(LoopbackEndpoint endpoint)
+    : link(std::move(endpoint))
+{
+    writeHello(packet);
+    link.send(packet);
+}
+
+uint32_t GameClient::chunkVersion(const ChunkPos& pos) const {
+    auto it = versions.find(pos);
+    return it == versions.end() ? 0 : it->second;
+}
+
+void GameClient::update() {
+    bool chunksArrived = false;
+    while (link.receive(packet)) {
+        counters.bytesReceived += (long long)packet.size();
+        counters.packets++;
+
+        ByteReader in(packet.data(), packet.size());
+        switch ((MessageType)in.u8()) {
+            case MessageType::Welcome:
+                if (!readWelcome(in, welcome)) counters.rejectedPackets++;
+                else playerEye = welcome.eye;
+                break;
+            case MessageType::Chunk:
+                receiveChunk(in);
+                chunksArrived = true;
+                break;
+            case MessageType::Entities:
+                receiveEntities(in);
+                break;
+            default:
+                counters.rejectedPackets++;
+                break;
+        }
+    }
+    if (chunksArrived && welcomed()) dropFarChunks();
+
+    // Hello o Welcome persi: ci si ripresenta ogni tanto
+    if (!welcomed() && ++helloWait % HELLO_RETRY_UPDATES == 0) {
+        packet.clear();
+        writeHello(packet);
+        link.send(packet);
+    }
+}
+
+void GameClient::receiveChunk(ByteReader& in) {
+    ChunkPos pos;
+    uint32_t version;
+    auto chunk = std::make_unique<Chunk>();
+    if (!readChunkMessage(in, pos, version, *chunk)) {
+        counters.rejectedPackets++;
+        return;
+    }
+    counters.chunks++;
+    // Confermato anche se ripetuto: la conferma di prima può essersi persa
+    pendingAcks.push_back({ pos, version });
+    if (chunkVersion(pos) >= version) return;
+    versions[pos] = version;
+    localWorld.insertChunk(pos, std::move(chunk));
+}
+
+void GameClient::receiveEntities(ByteReader& in) {
+    static const std::vector<NetEntity> NONE;
+    uint64_t tick     = in.varint();
+    uint64_t baseline = in.varint();
+    glm::ivec3 eye;
+    eye.x = (int)in.svarint();
+    eye.y = (int)in.svarint();
+    eye.z = (int)in.svarint();
+    if (!in.ok() || tick <= latestTick) return; // ripetuto o in ritardo
+
+    // La base deve essere uno stato che abbiamo ancora
+    const EntitySnapshot& base = history[baseline % ENTITY_HISTORY];
+    if (baseline != 0 && base.tick != baseline) {
+        counters.rejectedPackets++;
+        return;
+    }
+    EntitySnapshot& snapshot = history[tick % ENTITY_HISTORY];
+    thread_local std::vector<NetEntity> decoded;
+    if (!readEntityDelta(in, baseline ? base.entities : NONE, decoded)) {
+        counters.rejectedPackets++;
+        return;
+    }
+    snapshot.tick = tick;
+    snapshot.entities.swap(decoded);
+    latestTick = tick;
+    playerEye  = dequantizePosition(eye);
+    counters.entityUpdates++;
+}
+
+void GameClient::dropFarChunks() {
+    int r = welcome.viewDistance + 1;
+    ChunkPos center = World::toChunkPos((int)std::floor(playerEye.x), 0, (int)std::floor(playerEye.z));
+    far.clear();
+    localWorld.forEachChunk([&](const ChunkPos& pos, const Chunk&) {
+        int dx = pos.x - center.x, dz = pos.z - center.z;
+        if (dx * dx + dz * dz > r * r) far.push_back(pos);
+    });
+    for (const ChunkPos& pos : far) {
+        localWorld.removeChunk(pos);
+        versions.erase(pos);
+    }
+}
+
+void GameClient::sendInput(const PlayerInput& input) {
+    message.sequence  = ++sequence;
+    message.input     = input;
+    message.entityAck = latestTick;
+    message.chunkAcks.assign(pendingAcks.begin(), pendingAcks.begin() + std::min<size_t>(pendingAcks.size(), MAX_CHUNK_ACKS));
+    pendingAcks.erase(pendingAcks.begin(), pendingAcks.begin() + (long)message.chunkAcks.size());
+
+    packet.clear();
+    writeInput(packet, message);
+    link.send(packet);
+}
+
+void GameClient::appendInstances(std::vector<InstanceData>& out) const {
+    for (const NetEntity& entity : entities()) {
+        glm::vec3 position = dequantizePosition(entity.position);
+        int x = (int)std::floor(position.x), y = (int)std::floor(position.y), z = (int)std::floor(position.z);
+        const Chunk* chunk = localWorld.findChunk(World::toChunkPos(x, y, z));
+
+        InstanceData instance;
+        instance.position = position;
+        instance.scale    = ENTITY_SCALE;
+        instance.rotation = axisAngle(glm::vec3(0.0f, 1.0f, 0.0f), dequantizeAngle(entity.yaw));
+        instance.layers   = entity.layers;
+        instance.light    = chunk ? chunk->getLight(x & CHUNK_MASK, y & CHUNK_MASK, z & CHUNK_MASK) : MAX_LIGHT << 4;
+        out.push_back(instance);
+    }
+}
+
+PlayerInput botInput(int bot, uint64_t sequence) {
+    PlayerInput input;
+    input.moves        = 1 << FORWARD;
+    input.yaw          = (float)bot * 137.5f + 40.0f * std::sin((float)sequence * 0.02f + (float)bot);
+    input.pitch        = -30.0f;
+    input.toggleNoclip = sequence == 1;
+    input.breakBlock   = sequence % 40 == 20;
+    return input;
+}
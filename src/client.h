@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "instance_data.h"
+#include "net_protocol.h"
+#include "simulation.h"
+#include "transport.h"
+#include "world.h"
+
+struct ClientStats {
+    long long bytesReceived   = 0;
+    long long packets         = 0;
+    long long chunks          = 0; // messaggi Chunk ricevuti (anche ripetuti)
+    long long entityUpdates   = 0;
+    long long rejectedPackets = 0; // non validi, o differenze da una base che non abbiamo
+};
+
+// ---------------------------------------------------------------
+// GameClient
+// L'altro capo di GameServer: si presenta (Hello), tiene una copia
+// del mondo con i chunk che arrivano e le entità vicine, e manda un
+// Input per tick con le conferme di quello che ha ricevuto. I chunk
+// oltre la vista del server (più uno) li scarta da solo.
+//
+// Non simula niente: posizione del giocatore ed entità sono quelle
+// dell'ultimo aggiornamento del server.
+// ---------------------------------------------------------------
+class GameClient {
+public:
+    explicit GameClient(LoopbackEndpoint endpoint);
+
+    // Legge tutti i pacchetti arrivati
+    void update();
+
+    // I comandi di questo tick, con le conferme
+    void sendInput(const PlayerInput& input);
+
+    bool      welcomed() const { return welcome.tickRate > 0; }
+    uint32_t  inputsSent() const { return sequence; }
+    uint32_t  playerId() const { return welcome.playerId; }
+    glm::vec3 eye() const { return playerEye; }
+
+    const World& world() const { return localWorld; }
+    uint32_t     chunkVersion(const ChunkPos& pos) const;
+
+    // Le entità dell'ultimo aggiornamento, ordinate per id
+    const std::vector<NetEntity>& entities() const { return history[latestTick % ENTITY_HISTORY].entities; }
+    uint64_t entityTick() const { return latestTick; }
+
+    // Un'istanza per entità, come MobSystem::appendInstances
+    void appendInstances(std::vector<InstanceData>& out) const;
+
+    const ClientStats&      stats() const { return counters; }
+    const LoopbackEndpoint& endpoint() const { return link; }
+
+private:
+    struct EntitySnapshot {
+        uint64_t tick = 0;
+        std::vector<NetEntity> entities;
+    };
+
+    void receiveChunk(ByteReader& in);
+    void receiveEntities(ByteReader& in);
+    void dropFarChunks();
+
+    LoopbackEndpoint link;
+    WelcomeMessage   welcome;
+    World            localWorld;
+    glm::vec3        playerEye{ 0.0f };
+    uint32_t         sequence = 0;
+    int              helloWait = 0; // update() senza risposta all'Hello
+
+    std::unordered_map<ChunkPos, uint32_t, ChunkPosHash> versions;
+    std::vector<ChunkAck> pendingAcks;
+
+    EntitySnapshot history[ENTITY_HISTORY];
+    uint64_t       latestTick = 0;
+
+    std::vector<uint8_t>  packet;
+    std::vector<ChunkPos> far;
+    InputMessage          message;
+    ClientStats           counters;
+};
+
+// I comandi di un giocatore finto per i test di carico: in volo
+// (noclip) sempre avanti, girando piano in una direzione sua, e ogni
+// tanto rompe un blocco. sequence è il numero dell'Input, da 1.
+PlayerInput botInput(int bot, uint64_t sequence);
@@ -0,0 +1,211 @@
+#include "culling.h"
+
+#include <cmath>
+#include <unordered_set>
+
+#include "memory.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define VOXEL_CULLING_SSE
+#include <xmmintrin.h>
+#endif
+
+Frustum Frustum::fromMatrix(const glm::mat4& m) {
+    // glm è column-major: m[colonna][riga], quindi la riga i è (m[0][i], m[1][i], m[2][i], m[3][i])
+    auto row = [&](int i) { return glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]); };
+
+    Frustum f;
+    f.planes[0] = row(3) + row(0); // sinistra
+    f.planes[1] = row(3) - row(0); // destra
+    f.planes[2] = row(3) + row(1); // basso
+    f.planes[3] = row(3) - row(1); // alto
+    f.planes[4] = row(3) + row(2); // vicino
+    f.planes[5] = row(3) - row(2); // lontano
+
+    // Normalizzati: non serve al test, ma così d è una distanza vera
+    for (glm::vec4& p : f.planes) p /= glm::length(glm::vec3(p));
+    return f;
+}
+
+bool Frustum::intersectsBox(const glm::vec3& min, const glm::vec3& max) const {
+    for (const glm::vec4& p : planes) {
+        // Il vertice del box più "dentro" rispetto al piano: se anche lui
+        // è fuori, lo è tutto il box
+        glm::vec3 v(p.x > 0.0f ? max.x : min.x,
+                    p.y > 0.0f ? max.y : min.y,
+                    p.z > 0.0f ? max.z : min.z);
+        if (p.x * v.x + p.y * v.y + p.z * v.z + p.w < 0.0f) return false;
+    }
+    return true;
+}
+
+void BoxBatch::push(const glm::vec3& min, const glm::vec3& max) {
+    minX.push_back(min.x); minY.push_back(min.y); minZ.push_back(min.z);
+    maxX.push_back(max.x); maxY.push_back(max.y); maxZ.push_back(max.z);
+}
+
+void BoxBatch::removeSwap(int i) {
+    for (std::vector<float>* v : { &minX, &minY, &minZ, &maxX, &maxY, &maxZ }) {
+        (*v)[i] = v->back();
+        v->pop_back();
+    }
+}
+
+void cullBoxes(const Frustum& frustum, const BoxBatch& boxes, uint8_t* visible) {
+    int count = boxes.size();
+    int i = 0;
+
+#ifdef VOXEL_CULLING_SSE
+    // Il segno della normale è lo stesso per tutti i box, quindi la
+    // scelta min/max del vertice si fa una volta per piano, fuori dal loop
+    const float* sx[6]; const float* sy[6]; const float* sz[6];
+    for (int p = 0; p < 6; p++) {
+        const glm::vec4& plane = frustum.planes[p];
+        sx[p] = plane.x > 0.0f ? boxes.maxX.data() : boxes.minX.data();
+        sy[p] = plane.y > 0.0f ? boxes.maxY.data() : boxes.minY.data();
+        sz[p] = plane.z > 0.0f ? boxes.maxZ.data() : boxes.minZ.data();
+    }
+
+    const __m128 zero = _mm_setzero_ps();
+    for (; i + 4 <= count; i += 4) {
+        __m128 inside = _mm_cmpeq_ps(zero, zero); // tutti i bit a 1
+        for (int p = 0; p < 6; p++) {
+            const glm::vec4& plane = frustum.planes[p];
+            __m128 d = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.x), _mm_loadu_ps(sx[p] + i)),
+                           _mm_mul_ps(_mm_set1_ps(plane.y), _mm_loadu_ps(sy[p] + i))),
+                _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.z), _mm_loadu_ps(sz[p] + i)),
+                           _mm_set1_ps(plane.w)));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(d, zero));
+        }
+        int bits = _mm_movemask_ps(inside);
+        visible[i + 0] = (uint8_t)(bits & 1);
+        visible[i + 1] = (uint8_t)((bits >> 1) & 1);
+        visible[i + 2] = (uint8_t)((bits >> 2) & 1);
+        visible[i + 3] = (uint8_t)((bits >> 3) & 1);
+    }
+#endif
+
+    // Coda (o tutto, senza SSE)
+    for (; i < count; i++) {
+        visible[i] = frustum.intersectsBox(
+            glm::vec3(boxes.minX[i], boxes.minY[i], boxes.minZ[i]),
+            glm::vec3(boxes.maxX[i], boxes.maxY[i], boxes.maxZ[i])) ? 1 : 0;
+    }
+}
+
+// ---------------------------------------------------------------
+// ChunkCuller
+// ---------------------------------------------------------------
+
+static glm::vec3 chunkMin(const ChunkPos& pos) {
+    return glm::vec3((float)(pos.x * CHUNK_SIZE), (float)(pos.y * CHUNK_SIZE), (float)(pos.z * CHUNK_SIZE));
+}
+
+void ChunkCuller::setChunk(const ChunkPos& pos, const ChunkVisibility& visibility, bool hasMesh) {
+    ChunkInfo& info = chunks[pos];
+    info.visibility = visibility;
+
+    if (hasMesh && info.drawIndex < 0) {
+        info.drawIndex = boxes.size();
+        boxes.push(chunkMin(pos), chunkMin(pos) + glm::vec3((float)CHUNK_SIZE));
+        drawable.push_back(pos);
+    } else if (!hasMesh && info.drawIndex >= 0) {
+        int index = info.drawIndex;
+        info.drawIndex = -1;
+
+        // L'ultimo prende il posto di quello tolto: aggiorniamo il suo indice
+        boxes.removeSwap(index);
+        drawable[index] = drawable.back();
+        drawable.pop_back();
+        if (index < (int)drawable.size()) chunks[drawable[index]].drawIndex = index;
+    }
+}
+
+void ChunkCuller::removeChunk(const ChunkPos& pos) {
+    auto it = chunks.find(pos);
+    if (it == chunks.end()) return;
+    setChunk(pos, ChunkVisibility(), false);
+    chunks.erase(pos);
+}
+
+void ChunkCuller::cull(const Frustum& frustum, const glm::vec3& cameraPosition, int maxDistance,
+                       std::vector<ChunkPos>& visible) {
+    visible.clear();
+    lastStats = CullingStats();
+    lastStats.considered = boxes.size();
+
+    // 1) Frustum: tutti i chunk con mesh in un colpo solo
+    inFrustum.resize(boxes.size());
+    cullBoxes(frustum, boxes, inFrustum.data());
+    for (uint8_t v : inFrustum) lastStats.frustumCulled += v ? 0 : 1;
+
+    if (!occlusionEnabled) {
+        for (int i = 0; i < boxes.size(); i++)
+            if (inFrustum[i]) visible.push_back(drawable[i]);
+        lastStats.drawn = (int)visible.size();
+        return;
+    }
+
+    // 2) Visita dal chunk della camera
+    static const int offsets[6][3] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+
+    reached.assign(boxes.size(), 0);
+    queue.clear();
+
+    // I chunk già visitati servono solo a questa visita: nodi e bucket
+    // dall'arena del thread, con i bucket della visita precedente
+    ArenaScope scope(scratchArena());
+    std::unordered_set<ChunkPos, ChunkPosHash, std::equal_to<ChunkPos>, ArenaAllocator<ChunkPos>> visited(
+        queue.capacity() * 2, ChunkPosHash(), std::equal_to<ChunkPos>(), ArenaAllocator<ChunkPos>(scratchArena()));
+
+    ChunkPos start = World::toChunkPos(
+        (int)std::floor(cameraPosition.x), (int)std::floor(cameraPosition.y), (int)std::floor(cameraPosition.z));
+    queue.push_back({ start, -1, 0 });
+    visited.insert(start);
+
+    for (size_t head = 0; head < queue.size(); head++) {
+        Visit current = queue[head];
+
+        auto it = chunks.find(current.pos);
+        if (it != chunks.end() && it->second.drawIndex >= 0) {
+            int index = it->second.drawIndex;
+            if (inFrustum[index] && !reached[index]) {
+                reached[index] = 1;
+                visible.push_back(current.pos);
+            }
+        }
+        // Chunk non ancora meshati: li consideriamo aperti, meglio
+        // disegnare qualcosa in più che far sparire il terreno
+        ChunkVisibility visibility = it != chunks.end() ? it->second.visibility : ChunkVisibility();
+
+        for (int face = 0; face < 6; face++) {
+            int opposite = face ^ 1;
+            // Mai tornare indietro rispetto a una direzione già presa
+            if (current.directions & (1 << opposite)) continue;
+            if (current.entryFace >= 0 && !visibility.connects(current.entryFace, face)) continue;
+
+            ChunkPos next = { current.pos.x + offsets[face][0],
+                              current.pos.y + offsets[face][1],
+                              current.pos.z + offsets[face][2] };
+            if (next.y < WORLD_MIN_CHUNK_Y || next.y > WORLD_MAX_CHUNK_Y) continue;
+            if (std::abs(next.x - start.x) > maxDistance || std::abs(next.y - start.y) > maxDistance ||
+                std::abs(next.z - start.z) > maxDistance) continue;
+            if (visited.count(next)) continue;
+
+            // Fuori dal frustum non si entra: per i chunk con mesh il
+            // risultato c'è già, per gli altri lo calcoliamo ora
+            auto nextIt = chunks.find(next);
+            bool nextInFrustum = (nextIt != chunks.end() && nextIt->second.drawIndex >= 0)
+                ? inFrustum[nextIt->second.drawIndex] != 0
+                : frustum.intersectsBox(chunkMin(next), chunkMin(next) + glm::vec3((float)CHUNK_SIZE));
+            if (!nextInFrustum) continue;
+
+            visited.insert(next);
+            queue.push_back({ next, (int8_t)opposite, (uint8_t)(current.directions | (1 << face)) });
+        }
+    }
+
+    lastStats.drawn           = (int)visible.size();
+    lastStats.occlusionCulled = lastStats.considered - lastStats.frustumCulled - lastStats.drawn;
+}
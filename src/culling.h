@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "mesher.h"
+#include "world.h"
+
+// ---------------------------------------------------------------
+// Frustum della camera come 6 piani (a, b, c, d): un punto p è dalla
+// parte interna di un piano se a*p.x + b*p.y + c*p.z + d >= 0.
+// I piani si ricavano direttamente dalle righe di projection * view
+// (metodo di Gribb e Hartmann), senza calcolare gli angoli della camera.
+// ---------------------------------------------------------------
+struct Frustum {
+    glm::vec4 planes[6];
+
+    static Frustum fromMatrix(const glm::mat4& viewProjection);
+
+    // true se il box [min, max] è almeno in parte dentro il frustum.
+    // Test conservativo: un box vicino a uno spigolo può risultare
+    // visibile anche se non lo è, mai il contrario.
+    bool intersectsBox(const glm::vec3& min, const glm::vec3& max) const;
+};
+
+// Box di molti chunk in formato SoA (un array per coordinata): così il
+// test SIMD carica 4 box alla volta con una sola load per coordinata
+struct BoxBatch {
+    std::vector<float> minX, minY, minZ;
+    std::vector<float> maxX, maxY, maxZ;
+
+    int  size() const { return (int)minX.size(); }
+    void push(const glm::vec3& min, const glm::vec3& max);
+    void removeSwap(int i); // rimuove i spostandoci l'ultimo
+};
+
+// Scrive in visible[i] 1 se il box i interseca il frustum, 0 altrimenti.
+// Usa SSE dove c'è (4 box per istruzione), altrimenti il test scalare.
+void cullBoxes(const Frustum& frustum, const BoxBatch& boxes, uint8_t* visible);
+
+// Numeri dell'ultimo frame, per il pannello di debug
+struct CullingStats {
+    int considered      = 0; // chunk con una mesh da disegnare
+    int frustumCulled   = 0; // fuori dal frustum
+    int occlusionCulled = 0; // nel frustum ma nascosti dal terreno
+    int drawn           = 0;
+};
+
+// ---------------------------------------------------------------
+// ChunkCuller
+// Decide ogni frame quali chunk disegnare, in due passi:
+//
+// 1) Frustum culling: tutti i box dei chunk con una mesh vengono
+//    testati in batch contro il frustum.
+// 2) Cave culling: una visita in ampiezza parte dal chunk della
+//    camera e passa da un chunk al vicino solo se dentro il chunk
+//    la faccia da cui è entrata è collegata dall'aria a quella da
+//    cui esce (ChunkVisibility, calcolata al momento del meshing).
+//    La visita va sempre "in avanti", senza mai tornare nella
+//    direzione opposta a una già presa, quindi ogni chunk è visitato
+//    al più una volta. Le grotte dietro a metri di roccia non vengono
+//    raggiunte e non vengono disegnate.
+//
+// Non usa OpenGL: si può provare senza finestra su mondi sintetici.
+// ---------------------------------------------------------------
+class ChunkCuller {
+public:
+    // Registra (o aggiorna) la connettività di un chunk meshato.
+    // hasMesh = false per i chunk vuoti: non si disegnano ma la visita
+    // ci passa attraverso.
+    void setChunk(const ChunkPos& pos, const ChunkVisibility& visibility, bool hasMesh);
+    void removeChunk(const ChunkPos& pos);
+
+    // Riempie visible con i chunk da disegnare in questo frame.
+    // maxDistance limita la visita (in chunk, distanza di Chebyshev
+    // dal chunk della camera).
+    void cull(const Frustum& frustum, const glm::vec3& cameraPosition, int maxDistance,
+              std::vector<ChunkPos>& visible);
+
+    const CullingStats& stats() const { return lastStats; }
+
+    // Con false resta solo il frustum culling (per confronti e debug)
+    bool occlusionEnabled = true;
+
+private:
+    struct ChunkInfo {
+        ChunkVisibility visibility;
+        int drawIndex = -1; // indice nel BoxBatch, -1 se non ha mesh
+    };
+
+    struct Visit {
+        ChunkPos pos;
+        int8_t   entryFace;  // faccia da cui si è entrati, -1 per il chunk della camera
+        uint8_t  directions; // bit per ogni BlockFace già percorsa
+    };
+
+    std::unordered_map<ChunkPos, ChunkInfo, ChunkPosHash> chunks;
+
+    // Chunk con mesh: box e posizione nello stesso ordine
+    BoxBatch              boxes;
+    std::vector<ChunkPos> drawable;
+
+    // Buffer riusati tra un frame e l'altro
+    std::vector<uint8_t> inFrustum;
+    std::vector<uint8_t> reached;
+    std::vector<Visit>   queue;
+
+    CullingStats lastStats;
+};
@@ -5,6 +5,13 @@
 #include <imgui_impl_opengl3.h>
 #include <GLFW/glfw3.h>
 
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#include "profiler.h"
+
 void DebugUI::init(GLFWwindow* window) {
     // Crea il contesto ImGui — deve essere fatto una sola volta
     IMGUI_CHECKVERSION();
@@ -35,7 +42,8 @@ void DebugUI::beginFrame() {
     ImGui::NewFrame();
 }
 
-void DebugUI::endFrame(float deltaTime, float cameraX, float cameraY, float cameraZ, int totalCubes) {
+void DebugUI::endFrame(float deltaTime, float cameraX, float cameraY, float cameraZ,
+                       const WorldDebugInfo& world) {
     // Disegna il pannello solo se è visibile
     if (visible) {
         // Calcola FPS dall'inverso del deltaTime
@@ -51,7 +59,7 @@ void DebugUI::endFrame(float deltaTime, float cameraX, float cameraY, float came
         // ImGui::SetNextWindow* deve essere chiamato PRIMA di Begin()
         // ---------------------------------------------------------------
         ImGui::SetNextWindowPos(ImVec2(10.0f, 10.0f), ImGuiCond_Always);
-        ImGui::SetNextWindowSize(ImVec2(300.0f, 0.0f), ImGuiCond_Always); // 0 = altezza automatica
+        ImGui::SetNextWindowSize(ImVec2(VOXEL_PROFILING ? 420.0f : 300.0f, 0.0f), ImGuiCond_Always); // 0 = altezza automatica
         ImGui::SetNextWindowBgAlpha(0.75f); // semi-trasparente come Minecraft
 
         // Crea la finestra debug — ImGuiWindowFlags rimuove decorazioni inutili
@@ -79,6 +87,11 @@ void DebugUI::endFrame(float deltaTime, float cameraX, float cameraY, float came
             ImVec2(0.0f, 50.0f)     // dimensione del grafico
         );
 
+        // Dall'avvio del programma: primo frame e momento in cui si è potuto giocare
+        const StartupStats& startup = world.startup;
+        ImGui::Text("Startup:    first frame %.0f ms, playable %.2f s", startup.firstFrame * 1000.0, startup.playable);
+        ImGui::Text("Shaders:    %d from cache, %d compiled", startup.shadersFromCache, startup.shadersCompiled);
+
         ImGui::Separator(); // linea divisoria orizzontale
 
         // --- Sezione Camera/Posizione ---
@@ -86,21 +99,110 @@ void DebugUI::endFrame(float deltaTime, float cameraX, float cameraY, float came
         ImGui::Text("X: %.2f", cameraX);
         ImGui::Text("Y: %.2f", cameraY);
         ImGui::Text("Z: %.2f", cameraZ);
+        if (world.target.hit)
+            ImGui::Text("Target: %d %d %d, %s (face %d %d %d)", world.target.block.x, world.target.block.y,
+                        world.target.block.z, blockName(world.target.id),
+                        world.target.normal.x, world.target.normal.y, world.target.normal.z);
+        else
+            ImGui::Text("Target: none");
+        ImGui::Text("Place:  %s%s", blockName(world.placeBlock), world.noclip ? ", noclip" : "");
 
         ImGui::Separator();
 
         // --- Sezione Mondo ---
         ImGui::TextColored(ImVec4(0.0f, 1.0f, 0.0f, 1.0f), "[ World ]");
-        ImGui::Text("Cubes: %d", totalCubes);
+        ImGui::Text("Chunks: %d (%d meshed)", world.loadedChunks, world.meshedChunks);
+        ImGui::Text("Blocks: %lld", world.totalBlocks);
+        ImGui::Text("Triangles: %d", world.triangles);
+        ImGui::Text("Jobs: %d in flight, %d workers", world.jobsInFlight, world.workerThreads);
 
         ImGui::Separator();
 
+        // --- Sezione Culling ---
+        // Quanti chunk con mesh sono stati scartati prima delle draw call
+        ImGui::TextColored(ImVec4(1.0f, 0.5f, 0.0f, 1.0f), "[ Culling ]");
+        ImGui::Text("Considered: %d", world.culling.considered);
+        ImGui::Text("Frustum:    -%d", world.culling.frustumCulled);
+        ImGui::Text("Occlusion:  -%d", world.culling.occlusionCulled);
+        ImGui::Text("Drawn:      %d", world.culling.drawn);
+        ImGui::Text("Draw calls: %d", world.drawCalls);
+        ImGui::Text("Instances:  %d (%d draw call)", world.instances, world.instances > 0 ? 1 : 0);
+        ImGui::Text("Mesh GPU:   %.1f / %.1f MB", world.gpuMeshBytes / (1024.0 * 1024.0),
+                    world.gpuMeshCapacity / (1024.0 * 1024.0));
+
+        ImGui::Separator();
+
+        // --- Sezione LOD ---
+        // Nodi a risoluzione ridotta oltre i chunk: "stale" sono quelli
+        // vecchi ancora disegnati finché i nuovi non sono pronti
+        ImGui::TextColored(ImVec4(0.5f, 0.8f, 1.0f, 1.0f), "[ LOD ]");
+        ImGui::Text("Levels:     %d, view %.0f blocks", world.lod.levels, world.lod.viewDistance);
+        ImGui::Text("Nodes:      %d / %d shown, %d stale", world.lod.shownNodes, world.lod.desiredNodes,
+                    world.lod.staleNodes);
+        ImGui::Text("Drawn:      %d of %d", world.lodVisible, world.lod.drawable);
+        ImGui::Text("Triangles:  %d", world.lod.triangles);
+        ImGui::Text("Jobs:       %d in flight", world.lod.jobsInFlight);
+
+        ImGui::Separator();
+
+        // --- Sezione Streaming ---
+        // Chunk tenuti in memoria e mesh sulla GPU rispetto ai budget:
+        // oltre il budget si scaricano le colonne usate meno di recente
+        const StreamingStats& st = world.streaming;
+        const double MB = 1024.0 * 1024.0;
+        ImGui::TextColored(ImVec4(0.6f, 1.0f, 0.6f, 1.0f), "[ Streaming ]");
+        ImGui::Text("Resident:   %d columns (%d kept), %d chunks", st.residentColumns, st.keptColumns, st.residentChunks);
+        ImGui::Text("CPU:        %.1f / %.0f MB", st.cpuBytes / MB, st.cpuBudget / MB);
+        ImGui::Text("GPU:        %.1f / %.0f MB, %d meshes", st.gpuBytes / MB, st.gpuBudget / MB, st.meshedChunks);
+        if (st.overBudget)
+            ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "Over budget: the kept region does not fit");
+        ImGui::Text("Evicted:    %lld columns, %lld meshes", st.evictedColumns, st.evictedMeshes);
+        ImGui::Text("Speed:      %.1f blocks/s", glm::length(st.velocity));
+        ImGui::Text("Work:       %.2f ms last frame", st.workMs);
+
+        ImGui::Separator();
+
+        // --- Sezione Simulazione ---
+        // Tick a passo fisso sul loro thread: qui si vede se stanno
+        // nel passo e quanti se ne sono saltati per non restare indietro
+        const SimulationStats& sim = world.simulation;
+        ImGui::TextColored(ImVec4(0.6f, 1.0f, 0.6f, 1.0f), "[ Simulation ]");
+        ImGui::Text("Tick:       %lld at %d Hz", sim.ticks, sim.tickRate);
+        ImGui::Text("Tick time:  %.2f ms (worst %.2f ms)", sim.tickMs, sim.worstTickMs);
+        ImGui::Text("Mobs:       %d", sim.entities);
+        if (sim.skippedTicks > 0)
+            ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "Skipped:    %lld ticks", sim.skippedTicks);
+
+        ImGui::Separator();
+
+        // --- Memoria: in uso / riservata, richieste e quante all'heap ---
+        ImGui::TextColored(ImVec4(0.6f, 1.0f, 0.6f, 1.0f), "[ Memory ]");
+        for (int i = 0; i < (int)MemoryTag::Count; i++) {
+            const MemoryTagStats& tag = world.memory.tags[i];
+            ImGui::Text("%-15s %6.1f / %6.1f MB", memoryTagName((MemoryTag)i), tag.bytesInUse / MB, tag.bytesReserved / MB);
+            ImGui::Text("                %lld allocs, %lld from heap", tag.allocations, tag.heapAllocations);
+        }
+
+        ImGui::Separator();
+
+#if VOXEL_PROFILING
+        drawProfiler();
+        ImGui::Separator();
+#endif
+
         // --- Info controlli ---
         ImGui::TextColored(ImVec4(0.7f, 0.7f, 0.7f, 1.0f), "[ Controls ]");
         ImGui::Text("WASD    - Move");
         ImGui::Text("Mouse   - Look");
         ImGui::Text("Scroll  - Zoom");
+        ImGui::Text("LMB/RMB - Break / place block");
+        ImGui::Text("1-7     - Block to place");
+        ImGui::Text("N       - Toggle noclip");
+        ImGui::Text("M       - Spawn mobs");
         ImGui::Text("F3      - Toggle debug");
+#if VOXEL_PROFILING
+        ImGui::Text("F4      - Save profile trace");
+#endif
         ImGui::Text("ESC     - Quit");
 
         ImGui::End();
@@ -113,6 +215,145 @@ void DebugUI::endFrame(float deltaTime, float cameraX, float cameraY, float came
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 }
 
+void DebugUI::drawLoadingScreen(const LoadingScreenInfo& info) {
+    beginFrame();
+
+    // Una finestra senza decorazioni al centro dello schermo
+    const ImVec2 size(360.0f, 0.0f);
+    const ImVec2 display = ImGui::GetIO().DisplaySize;
+    ImGui::SetNextWindowPos(ImVec2((display.x - size.x) * 0.5f, display.y * 0.4f), ImGuiCond_Always);
+    ImGui::SetNextWindowSize(size, ImGuiCond_Always);
+    ImGui::Begin("Loading", nullptr,
+        ImGuiWindowFlags_NoResize   |
+        ImGuiWindowFlags_NoMove     |
+        ImGuiWindowFlags_NoCollapse |
+        ImGuiWindowFlags_NoTitleBar
+    );
+
+    ImGui::Text("Loading... %.1f s", info.seconds);
+
+    // Shader e texture: prima sui worker, poi il caricamento sulla GPU
+    char label[64];
+    float assets = info.assetsTotal > 0 ? (float)info.assetsDone / (float)info.assetsTotal : 1.0f;
+    if (info.gpuReady) std::snprintf(label, sizeof(label), "Assets ready");
+    else std::snprintf(label, sizeof(label), "Assets %d / %d", info.assetsDone, info.assetsTotal);
+    ImGui::ProgressBar(info.gpuReady ? 1.0f : assets * 0.9f, ImVec2(-1.0f, 0.0f), label);
+
+    // Il terreno attorno allo spawn, generato o letto dal disco e meshato
+    float terrain = info.columnsTotal > 0 ? (float)info.columnsDone / (float)info.columnsTotal : 1.0f;
+    std::snprintf(label, sizeof(label), "Terrain %d / %d columns", info.columnsDone, info.columnsTotal);
+    ImGui::ProgressBar(terrain, ImVec2(-1.0f, 0.0f), label);
+
+    ImGui::End();
+
+    ImGui::Render();
+    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+}
+
 void DebugUI::toggleVisible() {
     visible = !visible;
-}
\ No newline at end of file
+}
+
+// ---------------------------------------------------------------
+// Profiler: in alto le zone più costose (media e picco sugli ultimi
+// 60 frame), sotto la timeline dell'ultimo frame stile "flame graph":
+// una riga per thread, le zone annidate una sotto l'altra.
+// ---------------------------------------------------------------
+static ImU32 zoneColor(const char* name) {
+    // Lo stesso nome ha sempre lo stesso colore (hash FNV-1a del testo)
+    uint32_t hash = 2166136261u;
+    for (const char* c = name; *c; c++) hash = (hash ^ (uint8_t)*c) * 16777619u;
+    return IM_COL32(90 + (hash & 127), 90 + ((hash >> 8) & 127), 90 + ((hash >> 16) & 127), 255);
+}
+
+void DebugUI::drawProfiler() {
+    const int STATS_FRAMES = 60;
+    const int MAX_ROWS     = 12;
+
+    ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.8f, 1.0f), "[ Profiler ]");
+
+    std::vector<ProfileZoneStats> stats = Profiler::zoneStats(STATS_FRAMES);
+    if (ImGui::BeginTable("##zones", 4, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit)) {
+        ImGui::TableSetupColumn("Zone");
+        ImGui::TableSetupColumn("Where");
+        ImGui::TableSetupColumn("ms/frame");
+        ImGui::TableSetupColumn("max");
+        ImGui::TableHeadersRow();
+        for (int i = 0; i < (int)stats.size() && i < MAX_ROWS; i++) {
+            const ProfileZoneStats& zone = stats[i];
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn(); ImGui::Text("%s", zone.name.c_str());
+            ImGui::TableNextColumn(); ImGui::Text("%s", zone.gpu ? "GPU" : zone.mainThread ? "main" : "workers");
+            ImGui::TableNextColumn(); ImGui::Text("%6.2f", zone.averageMs);
+            ImGui::TableNextColumn(); ImGui::Text("%6.2f", zone.maxMs);
+        }
+        ImGui::EndTable();
+    }
+
+    const std::deque<ProfileFrame>& frames = Profiler::frames();
+    if (frames.empty()) return;
+    const ProfileFrame& frame = frames.back();
+    double frameMs = (frame.end - frame.start) * 1e-6;
+    ImGui::Text("Frame %llu: %.2f ms", (unsigned long long)frame.number, frameMs);
+
+    // Righe: una per thread con zone in questo frame, più la GPU se ci sono tempi
+    std::vector<std::string> threads = Profiler::threadNames();
+    std::vector<int> rowOfThread(threads.size(), -1);
+    std::vector<int> rowDepth;
+    for (const ProfileZone& zone : frame.zones) {
+        if (zone.thread >= threads.size()) continue;
+        if (rowOfThread[zone.thread] < 0) {
+            rowOfThread[zone.thread] = (int)rowDepth.size();
+            rowDepth.push_back(0);
+        }
+        int& depth = rowDepth[rowOfThread[zone.thread]];
+        depth = std::max(depth, zone.depth + 1);
+    }
+
+    const float LANE_HEIGHT = 14.0f;
+    const float LABEL_WIDTH = 70.0f;
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    ImVec2 origin = ImGui::GetCursorScreenPos();
+    float  width  = std::max(ImGui::GetContentRegionAvail().x - LABEL_WIDTH, 50.0f);
+
+    // Posizione di ogni riga (le righe con più livelli sono più alte)
+    std::vector<float> rowY(rowDepth.size());
+    float y = origin.y;
+    for (size_t r = 0; r < rowDepth.size(); r++) { rowY[r] = y; y += rowDepth[r] * LANE_HEIGHT + 2.0f; }
+    float gpuY = y;
+    if (!frame.gpu.empty()) y += LANE_HEIGHT + 2.0f;
+
+    auto toX = [&](int64_t time) {
+        double t = (double)(time - frame.start) / (double)std::max<int64_t>(frame.end - frame.start, 1);
+        return origin.x + LABEL_WIDTH + (float)std::clamp(t, 0.0, 1.0) * width;
+    };
+    auto drawZone = [&](const char* name, float x0, float x1, float top, double ms) {
+        ImVec2 a(x0, top), b(std::max(x1, x0 + 1.0f), top + LANE_HEIGHT - 1.0f);
+        drawList->AddRectFilled(a, b, zoneColor(name));
+        // Il nome solo se ci sta
+        if (b.x - a.x > ImGui::CalcTextSize(name).x + 4.0f)
+            drawList->AddText(ImVec2(a.x + 2.0f, a.y), IM_COL32(0, 0, 0, 255), name);
+        if (ImGui::IsMouseHoveringRect(a, b)) ImGui::SetTooltip("%s: %.3f ms", name, ms);
+    };
+
+    for (size_t t = 0; t < threads.size(); t++)
+        if (rowOfThread[t] >= 0)
+            drawList->AddText(ImVec2(origin.x, rowY[rowOfThread[t]]), IM_COL32(200, 200, 200, 255), threads[t].c_str());
+    for (const ProfileZone& zone : frame.zones) {
+        if (zone.thread >= threads.size()) continue;
+        float top = rowY[rowOfThread[zone.thread]] + zone.depth * LANE_HEIGHT;
+        drawZone(zone.name, toX(zone.start), toX(zone.end), top, (zone.end - zone.start) * 1e-6);
+    }
+
+    // La GPU: le durate una dopo l'altra dall'inizio del frame
+    if (!frame.gpu.empty()) {
+        drawList->AddText(ImVec2(origin.x, gpuY), IM_COL32(200, 200, 200, 255), "GPU");
+        int64_t time = frame.start;
+        for (const GpuProfileZone& zone : frame.gpu) {
+            drawZone(zone.name, toX(time), toX(time + zone.duration), gpuY, zone.duration * 1e-6);
+            time += zone.duration;
+        }
+    }
+
+    ImGui::Dummy(ImVec2(LABEL_WIDTH + width, y - origin.y));
+}
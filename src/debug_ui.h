@@ -8,10 +8,56 @@
 // invece di mantenere uno stato, molto più semplice per debug tools.
 // ---------------------------------------------------------------
 
+#include <cstddef>
+
+#include "asset_loader.h"
+#include "chunk_streamer.h"
+#include "culling.h"
+#include "lod.h"
+#include "raycast.h"
+#include "memory.h"
+#include "simulation.h"
+
 // Forward declaration: diciamo al compilatore che GLFWwindow esiste
 // senza includere tutto GLFW qui — riduce i tempi di compilazione
 struct GLFWwindow;
 
+// ---------------------------------------------------------------
+// Dati sul mondo e sul rendering da mostrare nel pannello.
+// Una struct invece di tanti parametri: aggiungere un campo non
+// cambia la firma di endFrame().
+// ---------------------------------------------------------------
+struct WorldDebugInfo {
+    int       loadedChunks  = 0; // chunk caricati nel mondo
+    long long totalBlocks   = 0; // blocchi non-aria nel mondo
+    int       meshedChunks  = 0; // chunk con una mesh sulla GPU
+    int       triangles     = 0; // triangoli disegnabili
+    int       jobsInFlight  = 0; // job di generazione/meshing non ancora consegnati
+    int       workerThreads = 0;
+    CullingStats culling;         // chunk scartati e disegnati nell'ultimo frame
+    int       drawCalls       = 0; // draw call dei chunk nell'ultimo frame
+    size_t    gpuMeshBytes    = 0; // memoria GPU occupata dalle mesh
+    size_t    gpuMeshCapacity = 0; // dimensione dei buffer delle mesh
+    LodStats  lod;                 // nodi LOD attorno al livello 0
+    int       lodVisible      = 0; // nodi LOD disegnati nell'ultimo frame
+    int       instances       = 0; // oggetti istanziati (frammenti), una draw call per tutti
+    StreamingStats streaming;      // chunk residenti, budget di memoria e sfratti
+    SimulationStats simulation;    // tick del thread della simulazione
+    MemoryStats memory;            // arene e pool per sottosistema
+    RayHit    target;              // blocco puntato dal mirino
+    BlockID   placeBlock = BLOCK_STONE; // blocco piazzato con il tasto destro
+    bool      noclip     = false;       // collisioni della camera spente
+    StartupStats startup;               // tempi dell'avvio
+};
+
+// Avanzamento mostrato dalla schermata di caricamento
+struct LoadingScreenInfo {
+    int   assetsDone   = 0, assetsTotal  = 0; // compiti dell'AssetLoader finiti
+    bool  gpuReady     = false;               // shader e texture sulla GPU
+    int   columnsDone  = 0, columnsTotal = 0; // colonne attorno allo spawn con la mesh
+    float seconds      = 0.0f;                // dall'avvio
+};
+
 class DebugUI {
 public:
     // Inizializza ImGui e lo collega alla finestra GLFW e al contesto OpenGL
@@ -31,9 +77,13 @@ public:
         float cameraX,          // posizione camera X
         float cameraY,          // posizione camera Y
         float cameraZ,          // posizione camera Z
-        int   totalCubes        // numero di cubi nel mondo
+        const WorldDebugInfo& world
     );
 
+    // Un frame intero (beginFrame compreso) con solo la schermata di
+    // caricamento, al centro della finestra, finché non si può giocare
+    void drawLoadingScreen(const LoadingScreenInfo& info);
+
     // Alterna la visibilità del pannello con F3
     void toggleVisible();
 
@@ -41,6 +91,9 @@ public:
     bool isVisible() const { return visible; }
 
 private:
+    // Sezione del profiler: tabella delle zone e timeline dell'ultimo frame
+    void drawProfiler();
+
     bool visible = false; // il pannello parte nascosto, F3 lo mostra
 
     // Dati storici per il grafico degli FPS
@@ -0,0 +1,112 @@
+#include "ecs.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+
+// ---------------------------------------------------------------
+// Tipi di componenti
+// ---------------------------------------------------------------
+
+static size_t componentSizes[MAX_COMPONENT_TYPES];
+static std::atomic<int> componentTypes{ 0 };
+
+int registerComponentType(size_t size) {
+    // Chiamata una volta per tipo (static locale di componentType<T>)
+    int type = componentTypes.fetch_add(1, std::memory_order_relaxed);
+    if (type >= MAX_COMPONENT_TYPES) {
+        std::cerr << "ECS: troppi tipi di componente (massimo " << MAX_COMPONENT_TYPES << ")\n";
+        std::abort();
+    }
+    componentSizes[type] = size;
+    return type;
+}
+
+// ---------------------------------------------------------------
+// EntityRegistry
+// ---------------------------------------------------------------
+
+Entity EntityRegistry::allocateEntity() {
+    living++;
+    if (!freeIndices.empty()) {
+        uint32_t index = freeIndices.back();
+        freeIndices.pop_back();
+        return { index, records[index].generation };
+    }
+    records.push_back({});
+    return { (uint32_t)records.size() - 1, 0 };
+}
+
+bool EntityRegistry::alive(Entity entity) const {
+    return entity.index < records.size()
+        && records[entity.index].archetype != UINT32_MAX
+        && records[entity.index].generation == entity.generation;
+}
+
+void EntityRegistry::destroy(Entity entity) {
+    if (!alive(entity)) return;
+    Record& record = records[entity.index];
+    removeRow(record.archetype, record.row);
+    record.archetype = UINT32_MAX;
+    record.generation++; // le copie del vecchio Entity non valgono più
+    freeIndices.push_back(entity.index);
+    living--;
+}
+
+uint32_t EntityRegistry::archetypeIndex(ComponentMask mask) {
+    auto it = archetypeByMask.find(mask);
+    if (it != archetypeByMask.end()) return it->second;
+
+    auto archetype = std::make_unique<Archetype>();
+    archetype->mask = mask;
+    for (int type = 0; type < MAX_COMPONENT_TYPES; type++)
+        if (mask & (ComponentMask(1) << type)) archetype->columns[type].size = componentSizes[type];
+
+    uint32_t index = (uint32_t)archetypes.size();
+    archetypes.push_back(std::move(archetype));
+    archetypeByMask.emplace(mask, index);
+    return index;
+}
+
+uint32_t EntityRegistry::appendRow(uint32_t archetype, Entity entity) {
+    Archetype& a = *archetypes[archetype];
+    uint32_t row = (uint32_t)a.entities.size();
+    a.entities.push_back(entity);
+    for (Column& column : a.columns)
+        if (column.size) column.bytes.resize(column.bytes.size() + column.size);
+    records[entity.index].archetype = archetype;
+    records[entity.index].row       = row;
+    return row;
+}
+
+void EntityRegistry::removeRow(uint32_t archetype, uint32_t row) {
+    // L'ultima riga prende il posto di quella tolta: gli array restano
+    // contigui, l'ordine delle entità non conta
+    Archetype& a = *archetypes[archetype];
+    uint32_t last = (uint32_t)a.entities.size() - 1;
+    if (row != last) {
+        Entity moved = a.entities[last];
+        a.entities[row] = moved;
+        for (Column& column : a.columns)
+            if (column.size) std::memcpy(column.at(row), column.at(last), column.size);
+        records[moved.index].row = row;
+    }
+    a.entities.pop_back();
+    for (Column& column : a.columns)
+        if (column.size) column.bytes.resize(column.bytes.size() - column.size);
+}
+
+void EntityRegistry::move(Entity entity, ComponentMask mask) {
+    Record   from    = records[entity.index];
+    uint32_t to      = archetypeIndex(mask);
+    uint32_t row     = appendRow(to, entity);
+    Archetype& source = *archetypes[from.archetype];
+    Archetype& target = *archetypes[to];
+
+    // I componenti in comune si copiano; quelli nuovi restano a zero
+    for (int type = 0; type < MAX_COMPONENT_TYPES; type++)
+        if (source.columns[type].size && target.columns[type].size)
+            std::memcpy(target.columns[type].at(row), source.columns[type].at(from.row), source.columns[type].size);
+
+    removeRow(from.archetype, from.row);
+}
@@ -0,0 +1,259 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "job_system.h"
+#include "memory.h"
+
+// ---------------------------------------------------------------
+// Entità e componenti (ECS) con archetipi.
+//
+// Un'entità è solo un indice con una generazione (Entity); i suoi dati
+// sono componenti, struct semplici (Transform, Velocity, ...). Le
+// entità con gli stessi tipi di componenti formano un archetipo, che
+// tiene ogni tipo in un array suo (structure of arrays): la riga r di
+// ogni colonna è l'entità entities[r]. Un sistema che legge posizione
+// e velocità scorre solo quei due array, contigui, senza saltare gli
+// altri campi come farebbe un vector di oggetti.
+//
+// Aggiungere o togliere un componente sposta l'entità in un altro
+// archetipo (una copia delle sue righe); distruggerla sposta l'ultima
+// riga al suo posto. Durante un forEach* la struttura non cambia:
+// creazioni e distruzioni vanno fatte prima o dopo.
+//
+// I componenti si spostano con memcpy: solo tipi banalmente copiabili,
+// al massimo MAX_COMPONENT_TYPES tipi diversi nel programma.
+// ---------------------------------------------------------------
+constexpr int MAX_COMPONENT_TYPES = 32;
+using ComponentMask = uint32_t;
+
+// Righe per batch nelle query: abbastanza per ammortizzare un job,
+// abbastanza poche da dividere anche qualche migliaio di entità
+constexpr int ENTITY_BATCH = 1024;
+
+// Un numero per tipo, assegnato al primo uso
+int registerComponentType(size_t size);
+
+// (T e const T sono lo stesso tipo di componente: un numero solo)
+template <typename T>
+int componentType() {
+    if constexpr (std::is_const_v<T>) {
+        return componentType<std::remove_const_t<T>>();
+    } else {
+        static_assert(std::is_trivially_copyable_v<T>, "i componenti si spostano con memcpy");
+        static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "colonne allineate come operator new");
+        static const int type = registerComponentType(sizeof(T));
+        return type;
+    }
+}
+
+template <typename... Ts>
+ComponentMask componentMask() {
+    return ((ComponentMask(1) << componentType<Ts>()) | ... | ComponentMask(0));
+}
+
+struct Entity {
+    uint32_t index      = UINT32_MAX;
+    uint32_t generation = 0; // cambia quando l'indice viene riusato
+
+    bool operator==(const Entity&) const = default;
+};
+
+// Un pezzo di archetipo passato a un sistema: count righe contigue
+struct EntityBatch {
+    const Entity* entities = nullptr;
+    int    count = 0;
+    size_t first = 0; // posizione della prima riga tra tutte quelle della query
+};
+
+// ---------------------------------------------------------------
+// EntityRegistry
+// Un thread alla volta per le modifiche; le query in parallelo
+// (parallelForEachBatch) dividono le righe tra i worker, e ogni
+// entità la tocca un job solo.
+// ---------------------------------------------------------------
+class EntityRegistry {
+public:
+    template <typename... Ts>
+    Entity create(const Ts&... components) {
+        Entity entity = allocateEntity();
+        uint32_t archetype = archetypeIndex(componentMask<Ts...>());
+        uint32_t row = appendRow(archetype, entity);
+        Archetype& a = *archetypes[archetype];
+        (std::memcpy(a.columns[componentType<Ts>()].at(row), &components, sizeof(Ts)), ...);
+        return entity;
+    }
+
+    void destroy(Entity entity);
+    bool alive(Entity entity) const;
+
+    // nullptr se l'entità non c'è più o non ha il componente
+    template <typename T>
+    T* get(Entity entity) {
+        if (!alive(entity)) return nullptr;
+        const Record& record = records[entity.index];
+        Archetype& a = *archetypes[record.archetype];
+        if (!(a.mask & componentMask<T>())) return nullptr;
+        return reinterpret_cast<T*>(a.columns[componentType<T>()].at(record.row));
+    }
+
+    template <typename T>
+    void add(Entity entity, const T& component) {
+        if (!alive(entity)) return;
+        if (T* existing = get<T>(entity)) {
+            *existing = component;
+            return;
+        }
+        move(entity, archetypes[records[entity.index].archetype]->mask | componentMask<T>());
+        *get<T>(entity) = component;
+    }
+
+    template <typename T>
+    void remove(Entity entity) {
+        if (!get<T>(entity)) return;
+        move(entity, archetypes[records[entity.index].archetype]->mask & ~componentMask<T>());
+    }
+
+    int count() const { return living; }
+    int archetypeCount() const { return (int)archetypes.size(); }
+
+    // Entità con tutti i componenti Ts
+    template <typename... Ts>
+    size_t countWith() const {
+        ComponentMask query = componentMask<Ts...>();
+        size_t total = 0;
+        for (const auto& a : archetypes)
+            if ((a->mask & query) == query) total += a->entities.size();
+        return total;
+    }
+
+    // fn(const EntityBatch&, Ts*...) per ogni batch di righe con tutti
+    // i componenti Ts, gli array già spostati alla prima riga del batch.
+    // Con Ts const la query è in sola lettura e va anche su un registry const.
+    template <typename... Ts, typename Fn>
+    void forEachBatch(Fn&& fn) {
+        visitBatches<Ts...>(fn);
+    }
+
+    template <typename... Ts, typename Fn>
+    void forEachBatch(Fn&& fn) const {
+        static_assert((std::is_const_v<Ts> && ...), "su un registry const solo componenti const");
+        visitBatches<Ts...>(fn);
+    }
+
+    // Come forEachBatch, con i batch divisi tra i worker (e il thread
+    // chiamante). jobs == nullptr: tutto sul thread chiamante, nello
+    // stesso ordine. Il risultato non dipende dalla divisione se fn
+    // scrive solo le righe del suo batch.
+    template <typename... Ts, typename Fn>
+    void parallelForEachBatch(JobSystem* jobs, Fn&& fn) {
+        parallelVisit<Ts...>(jobs, fn);
+    }
+
+    template <typename... Ts, typename Fn>
+    void parallelForEachBatch(JobSystem* jobs, Fn&& fn) const {
+        static_assert((std::is_const_v<Ts> && ...), "su un registry const solo componenti const");
+        parallelVisit<Ts...>(jobs, fn);
+    }
+
+    // fn(Entity, Ts&...) per ogni entità, per il codice che non ha
+    // bisogno degli array interi
+    template <typename... Ts, typename Fn>
+    void forEach(Fn&& fn) {
+        forEachBatch<Ts...>([&fn](const EntityBatch& batch, Ts*... columns) {
+            for (int i = 0; i < batch.count; i++) fn(batch.entities[i], columns[i]...);
+        });
+    }
+
+private:
+    // Un array di componenti dello stesso tipo, una riga per entità
+    struct Column {
+        std::vector<std::byte> bytes;
+        size_t size = 0; // byte per riga; 0 = tipo assente nell'archetipo
+
+        std::byte* at(uint32_t row) { return bytes.data() + row * size; }
+    };
+
+    struct Archetype {
+        ComponentMask       mask = 0;
+        std::vector<Entity> entities;
+        Column              columns[MAX_COMPONENT_TYPES];
+
+        template <typename T>
+        T* column() { return reinterpret_cast<T*>(columns[componentType<T>()].bytes.data()); }
+    };
+
+    struct Record {
+        uint32_t archetype  = UINT32_MAX; // UINT32_MAX: indice libero
+        uint32_t row        = 0;
+        uint32_t generation = 0;
+    };
+
+    struct Batch {
+        Archetype* archetype;
+        uint32_t   begin;
+        int        count;
+        size_t     first;
+    };
+
+    Entity   allocateEntity();
+    uint32_t archetypeIndex(ComponentMask mask);
+    uint32_t appendRow(uint32_t archetype, Entity entity);
+    void     removeRow(uint32_t archetype, uint32_t row);
+    void     move(Entity entity, ComponentMask mask);
+
+    template <typename... Ts, typename Visit>
+    void forEachMatchingBatch(Visit&& visit) const {
+        ComponentMask query = componentMask<Ts...>();
+        size_t first = 0;
+        for (const auto& a : archetypes) {
+            if ((a->mask & query) != query) continue;
+            uint32_t rows = (uint32_t)a->entities.size();
+            for (uint32_t begin = 0; begin < rows; begin += ENTITY_BATCH) {
+                int count = (int)std::min<uint32_t>(ENTITY_BATCH, rows - begin);
+                visit(Batch{ a.get(), begin, count, first });
+                first += count;
+            }
+        }
+    }
+
+    template <typename... Ts, typename Fn>
+    static void runBatch(const Batch& batch, Fn& fn) {
+        Archetype& a = *batch.archetype;
+        EntityBatch view{ a.entities.data() + batch.begin, batch.count, batch.first };
+        fn(view, (a.template column<Ts>() + batch.begin)...);
+    }
+
+    template <typename... Ts, typename Fn>
+    void visitBatches(Fn& fn) const {
+        forEachMatchingBatch<Ts...>([&fn](const Batch& batch) { runBatch<Ts...>(batch, fn); });
+    }
+
+    template <typename... Ts, typename Fn>
+    void parallelVisit(JobSystem* jobs, Fn& fn) const {
+        if (!jobs) {
+            visitBatches<Ts...>(fn);
+            return;
+        }
+        // L'elenco dei batch vive solo durante la chiamata: nell'arena
+        // del thread, letto dai worker finché parallelFor non ritorna
+        ArenaScope scope(scratchArena());
+        ArenaVector<Batch> batches(scratchArena());
+        batches.reserve(countWith<Ts...>() / ENTITY_BATCH + archetypes.size());
+        forEachMatchingBatch<Ts...>([&batches](const Batch& batch) { batches.push_back(batch); });
+        jobs->parallelFor((int)batches.size(), [&](int i) { runBatch<Ts...>(batches[i], fn); });
+    }
+
+    std::vector<std::unique_ptr<Archetype>>     archetypes;
+    std::unordered_map<ComponentMask, uint32_t> archetypeByMask;
+    std::vector<Record>   records;     // per indice di entità
+    std::vector<uint32_t> freeIndices; // indici da riusare
+    int living = 0;
+};
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "chunk_streamer.h"
+#include "lod.h"
+
+// ---------------------------------------------------------------
+// Impostazioni del gioco
+// Le usano la finestra (main.cpp) e voxel_replay, che rifà gli stessi
+// frame senza GPU: con numeri diversi le due misure non si potrebbero
+// confrontare.
+// ---------------------------------------------------------------
+
+const int SCREEN_WIDTH  = 800;
+const int SCREEN_HEIGHT = 600;
+
+// Raggio in chunk attorno alla camera entro cui generare il mondo
+// e disegnarlo a piena risoluzione (pari: vedi lod.h)
+const int RENDER_DISTANCE = 8;
+
+// Livelli LOD oltre i chunk: ognuno raddoppia la distanza visiva.
+// Con 4 livelli (fino a 16x) si vede a ~1800 blocchi.
+const int LOD_LEVELS = 4;
+
+// Quante mesh caricare sulla GPU al massimo per frame: evita picchi
+// quando arrivano tanti chunk insieme. Per i chunk il limite vero è il
+// tempo (StreamingSettings::frameBudget), questo è solo un tetto.
+const int MAX_UPLOADS_PER_FRAME     = 64;
+const int MAX_LOD_UPLOADS_PER_FRAME = 8;
+
+// Memoria per i chunk attorno al giocatore: oltre si scaricano
+// (o si tolgono dalla GPU) quelli usati meno di recente
+const StreamingSettings STREAMING = {
+    .lookAhead   = 1.0f,
+    .cpuBudget   = 256u << 20,
+    .gpuBudget   = 128u << 20,
+    .frameBudget = 0.004f,
+};
+
+// Tick al secondo della simulazione (giocatore, frammenti), sul suo
+// thread e indipendenti dal frame rate
+const int SIMULATION_TICK_RATE = 60;
+
+// Si gioca quando le colonne entro questo raggio (in chunk) dallo
+// spawn hanno la mesh: prima c'è la schermata di caricamento e la
+// simulazione non parte, così il giocatore non cade nel vuoto
+const int SPAWN_READY_RADIUS = 2;
+
+// Le colonne del livello 0 della selezione LOD, più un bordo di un
+// chunk che serve al meshing di quelle sul confine
+inline ColumnRegion detailColumns(const LodSelection& selection) {
+    return { selection.regionMin(0) - 1, selection.regionMax(0) };
+}
@@ -0,0 +1,54 @@
+#include "gpu_profiler.h"
+
+GpuProfiler::GpuProfiler() {
+    for (FrameQueries& frame : frames)
+        glGenQueries(MAX_ZONES_PER_FRAME, frame.queries);
+}
+
+GpuProfiler::~GpuProfiler() {
+    for (FrameQueries& frame : frames)
+        glDeleteQueries(MAX_ZONES_PER_FRAME, frame.queries);
+}
+
+void GpuProfiler::beginFrame() {
+    if (active) end();
+
+    current = (current + 1) % FRAME_LATENCY;
+    FrameQueries& frame = frames[current];
+
+    // I risultati di FRAME_LATENCY frame fa: se l'ultima query è pronta
+    // lo sono anche le precedenti (la GPU le esegue in ordine)
+    if (frame.count > 0) {
+        GLint available = 0;
+        glGetQueryObjectiv(frame.queries[frame.count - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available) {
+            for (int i = 0; i < frame.count; i++) {
+                GLuint64 nanoseconds = 0;
+                glGetQueryObjectui64v(frame.queries[i], GL_QUERY_RESULT, &nanoseconds);
+                Profiler::addGpuZone(frame.frame, frame.names[i], (int64_t)nanoseconds);
+            }
+        } else {
+            dropped++;
+        }
+    }
+
+    frame.count = 0;
+    frame.frame = Profiler::frameNumber();
+}
+
+bool GpuProfiler::begin(const char* name) {
+    FrameQueries& frame = frames[current];
+    if (active || frame.count == MAX_ZONES_PER_FRAME) return false;
+
+    frame.names[frame.count] = name;
+    glBeginQuery(GL_TIME_ELAPSED, frame.queries[frame.count]);
+    active = true;
+    return true;
+}
+
+void GpuProfiler::end() {
+    if (!active) return;
+    glEndQuery(GL_TIME_ELAPSED);
+    frames[current].count++;
+    active = false;
+}
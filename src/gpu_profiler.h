@@ -0,0 +1,79 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <cstdint>
+
+#include "profiler.h"
+
+// ---------------------------------------------------------------
+// GpuProfiler
+// Tempo GPU delle zone di rendering con le query GL_TIME_ELAPSED.
+// Il risultato di una query arriva solo quando la GPU ha finito quel
+// lavoro, di solito un paio di frame dopo: chiederlo subito
+// bloccherebbe la CPU. Per questo le query sono doppie (un set per il
+// frame corrente, uno per quello precedente). Quando un set torna in
+// uso si leggono i suoi risultati, ma solo se sono già pronti; se non
+// lo sono, quel frame resta senza tempi GPU.
+//
+// Le query GL_TIME_ELAPSED non si possono annidare: le zone GPU sono
+// una dopo l'altra, non una dentro l'altra.
+// I risultati finiscono nello storico del Profiler, nel frame in cui
+// le zone erano state registrate.
+// ---------------------------------------------------------------
+class GpuProfiler {
+public:
+    static constexpr int FRAME_LATENCY       = 2;
+    static constexpr int MAX_ZONES_PER_FRAME = 32;
+
+    GpuProfiler();
+    ~GpuProfiler();
+
+    GpuProfiler(const GpuProfiler&) = delete;
+    GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+    // Dopo PROFILE_FRAME(): raccoglie i tempi pronti e ricicla le query
+    void beginFrame();
+
+    // begin() restituisce false (e la zona non conta) se un'altra zona
+    // è già aperta o se il frame ha già MAX_ZONES_PER_FRAME zone
+    bool begin(const char* name);
+    void end();
+
+    // Frame i cui tempi non erano ancora pronti quando servivano le query
+    int droppedFrames() const { return dropped; }
+
+private:
+    struct FrameQueries {
+        GLuint      queries[MAX_ZONES_PER_FRAME] = {};
+        const char* names[MAX_ZONES_PER_FRAME]   = {};
+        int         count = 0;
+        uint64_t    frame = 0;
+    };
+
+    FrameQueries frames[FRAME_LATENCY];
+    int  current = 0;
+    bool active  = false; // una query è aperta
+    int  dropped = 0;
+};
+
+// Zona GPU RAII
+class GpuProfileScope {
+public:
+    GpuProfileScope(GpuProfiler& profiler, const char* name) : profiler(profiler), started(profiler.begin(name)) {}
+    ~GpuProfileScope() { if (started) profiler.end(); }
+
+    GpuProfileScope(const GpuProfileScope&) = delete;
+    GpuProfileScope& operator=(const GpuProfileScope&) = delete;
+
+private:
+    GpuProfiler& profiler;
+    bool         started;
+};
+
+#if VOXEL_PROFILING
+#define PROFILE_GPU_SCOPE(profiler, name) GpuProfileScope VOXEL_PROFILE_CONCAT(gpuProfileScope, __LINE__)(profiler, name)
+#define PROFILE_GPU_FRAME(profiler)       (profiler).beginFrame()
+#else
+#define PROFILE_GPU_SCOPE(profiler, name) ((void)0)
+#define PROFILE_GPU_FRAME(profiler)       ((void)0)
+#endif
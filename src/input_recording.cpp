@@ -0,0 +1,216 @@
+#include "input_recording.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "block_registry.h"
+#include "camera.h"
+#include "net_protocol.h"
+
+uint32_t InputFrame::toMicros(float seconds) {
+    return (uint32_t)std::lround(std::clamp(seconds, 0.0f, 3600.0f) * 1e6f);
+}
+
+BlockID blockForKey(int number) {
+    BlockID id = number <= BLOCK_LAVA ? (BlockID)number : (BlockID)(BLOCK_COUNT + number - BLOCK_LAVA - 1);
+    return number >= 1 && isRegisteredBlock(id) ? id : (BlockID)BLOCK_AIR;
+}
+
+// ---------------------------------------------------------------
+// InputMapper
+// ---------------------------------------------------------------
+
+PlayerInput InputMapper::apply(const InputFrame& frame, Camera& camera) {
+    previousKeys = keys;
+    keys         = frame.keys;
+
+    if (frame.mouseX != 0.0f || frame.mouseY != 0.0f) camera.processMouseMovement(frame.mouseX, frame.mouseY);
+    if (frame.scroll != 0.0f) camera.processMouseScroll(frame.scroll);
+
+    PlayerInput input;
+    input.yaw   = camera.yaw;
+    input.pitch = camera.pitch;
+
+    for (int direction = FORWARD; direction <= RIGHT; direction++)
+        if (held((InputKey)(KEY_FORWARD + direction))) input.moves |= 1 << direction;
+
+    // Il blocco scelto resta finché non se ne sceglie un altro
+    for (int number = 1; number <= 9; number++)
+        if (held((InputKey)(KEY_BLOCK_1 + number - 1)))
+            if (BlockID id = blockForKey(number); id != BLOCK_AIR) block = id;
+    input.block = block;
+
+    input.breakBlock   = pressed(KEY_BREAK);
+    input.placeBlock   = pressed(KEY_PLACE);
+    input.toggleNoclip = pressed(KEY_NOCLIP);
+    input.spawnMobs    = pressed(KEY_SPAWN_MOBS);
+    return input;
+}
+
+// ---------------------------------------------------------------
+// File delle registrazioni
+// ---------------------------------------------------------------
+
+struct InputFileHeader {
+    char     magic[4];  // "VXIN"
+    uint32_t version;
+    uint32_t seed;
+    uint32_t tickRate;
+    float    spawn[3];
+    float    yaw, pitch, fov;
+    uint32_t frames;
+    uint32_t size;      // byte dei frame dopo l'intestazione
+    uint64_t blockRegistry;
+    uint64_t finalState;
+    uint64_t checksum;  // FNV-1a dei frame
+};
+
+static const char     INPUT_MAGIC[4] = { 'V', 'X', 'I', 'N' };
+static const uint32_t INPUT_FILE_VERSION = 2;
+
+// Cosa segue il byte di flag di un frame
+enum : uint8_t {
+    FRAME_KEYS   = 1 << 0, // varint: i tasti, cambiati dal frame prima
+    FRAME_TIME   = 1 << 1, // svarint: durata meno quella del frame prima
+    FRAME_MOUSE  = 1 << 2, // f32 x, f32 y
+    FRAME_SCROLL = 1 << 3, // f32
+};
+
+static uint64_t fnv1a(const uint8_t* data, size_t size) {
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < size; i++) hash = (hash ^ data[i]) * 1099511628211ull;
+    return hash;
+}
+
+static void encodeFrames(const std::vector<InputFrame>& frames, std::vector<uint8_t>& out) {
+    ByteWriter writer(out);
+    InputFrame previous;
+    for (const InputFrame& frame : frames) {
+        uint8_t flags = 0;
+        if (frame.keys != previous.keys) flags |= FRAME_KEYS;
+        if (frame.frameMicros != previous.frameMicros) flags |= FRAME_TIME;
+        if (frame.mouseX != 0.0f || frame.mouseY != 0.0f) flags |= FRAME_MOUSE;
+        if (frame.scroll != 0.0f) flags |= FRAME_SCROLL;
+
+        writer.u8(flags);
+        if (flags & FRAME_KEYS) writer.varint(frame.keys);
+        if (flags & FRAME_TIME) writer.svarint((int64_t)frame.frameMicros - (int64_t)previous.frameMicros);
+        if (flags & FRAME_MOUSE) {
+            writer.f32(frame.mouseX);
+            writer.f32(frame.mouseY);
+        }
+        if (flags & FRAME_SCROLL) writer.f32(frame.scroll);
+        previous = frame;
+    }
+}
+
+static bool decodeFrames(const std::vector<uint8_t>& data, uint32_t count, std::vector<InputFrame>& frames) {
+    ByteReader reader(data.data(), data.size());
+    frames.clear();
+    frames.reserve(count);
+    InputFrame previous;
+    for (uint32_t i = 0; i < count && reader.ok(); i++) {
+        uint8_t flags = reader.u8();
+        InputFrame frame;
+        frame.keys        = flags & FRAME_KEYS ? (uint32_t)reader.varint() : previous.keys;
+        frame.frameMicros = flags & FRAME_TIME ? (uint32_t)((int64_t)previous.frameMicros + reader.svarint())
+                                               : previous.frameMicros;
+        if (flags & FRAME_MOUSE) {
+            frame.mouseX = reader.f32();
+            frame.mouseY = reader.f32();
+        }
+        if (flags & FRAME_SCROLL) frame.scroll = reader.f32();
+        frames.push_back(frame);
+        previous = frame;
+    }
+    return reader.ok() && reader.remaining() == 0 && frames.size() == count;
+}
+
+double InputRecording::seconds() const {
+    uint64_t micros = 0;
+    for (const InputFrame& frame : frames) micros += frame.frameMicros;
+    return (double)micros * 1e-6;
+}
+
+bool saveInputRecording(const std::string& path, const InputRecording& recording) {
+    std::vector<uint8_t> data;
+    encodeFrames(recording.frames, data);
+
+    InputFileHeader header{};
+    std::memcpy(header.magic, INPUT_MAGIC, sizeof(INPUT_MAGIC));
+    header.version       = INPUT_FILE_VERSION;
+    header.seed          = recording.seed;
+    header.tickRate      = (uint32_t)recording.tickRate;
+    header.spawn[0]      = recording.spawn.x;
+    header.spawn[1]      = recording.spawn.y;
+    header.spawn[2]      = recording.spawn.z;
+    header.yaw           = recording.yaw;
+    header.pitch         = recording.pitch;
+    header.fov           = recording.fov;
+    header.frames        = (uint32_t)recording.frames.size();
+    header.size          = (uint32_t)data.size();
+    header.blockRegistry = recording.blockRegistry;
+    header.finalState    = recording.finalState;
+    header.checksum      = fnv1a(data.data(), data.size());
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.write(reinterpret_cast<const char*>(&header), sizeof(header))
+        || !file.write(reinterpret_cast<const char*>(data.data()), (std::streamsize)data.size())) {
+        std::cerr << "Impossibile scrivere " << path << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool loadInputRecording(const std::string& path, InputRecording& recording) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Impossibile leggere " << path << "\n";
+        return false;
+    }
+
+    file.seekg(0, std::ios::end);
+    uint64_t fileSize = (uint64_t)file.tellg();
+    file.seekg(0, std::ios::beg);
+
+    // Le misure dell'header si controllano prima di allocare qualcosa:
+    // i dati devono arrivare esattamente alla fine del file, e ogni
+    // frame occupa almeno il suo byte di flag
+    InputFileHeader header{};
+    std::vector<uint8_t> data;
+    bool valid = file.read(reinterpret_cast<char*>(&header), sizeof(header))
+              && std::memcmp(header.magic, INPUT_MAGIC, sizeof(INPUT_MAGIC)) == 0
+              && header.version == INPUT_FILE_VERSION && header.tickRate > 0
+              && sizeof(header) + (uint64_t)header.size == fileSize && header.frames <= header.size;
+    if (valid) {
+        data.resize(header.size);
+        valid = file.read(reinterpret_cast<char*>(data.data()), header.size)
+             && fnv1a(data.data(), data.size()) == header.checksum
+             && decodeFrames(data, header.frames, recording.frames);
+    }
+    if (!valid) {
+        std::cerr << path << ": registrazione non valida o rovinata\n";
+        recording = {};
+        return false;
+    }
+
+    recording.seed          = header.seed;
+    recording.tickRate      = (int)header.tickRate;
+    recording.spawn         = glm::vec3(header.spawn[0], header.spawn[1], header.spawn[2]);
+    recording.yaw           = header.yaw;
+    recording.pitch         = header.pitch;
+    recording.fov           = header.fov;
+    recording.blockRegistry = header.blockRegistry;
+    recording.finalState    = header.finalState;
+    return true;
+}
+
+bool checkBlockTypes(const InputRecording& recording) {
+    if (recording.blockRegistry == blockRegistryHash()) return true;
+    std::cerr << "La registrazione è stata fatta con altri tipi di blocco (" << registeredBlockCount()
+              << " registrati qui): usa lo stesso file di definizione\n";
+    return false;
+}
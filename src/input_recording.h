@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "block.h"
+#include "block_registry.h"
+#include "simulation.h"
+
+class Camera;
+
+// ---------------------------------------------------------------
+// Input di un frame, senza GLFW
+// Il game loop legge tastiera e mouse e ne fa un InputFrame: i tasti
+// del gioco come bit, quanto si è mosso il mouse, lo scroll e quanto
+// è durato il frame. Da lì in poi tutto passa da InputMapper, che il
+// frame arrivi dalla finestra o da una registrazione: la stessa
+// sequenza di frame gira la camera e comanda la simulazione sempre
+// allo stesso modo.
+// ---------------------------------------------------------------
+enum InputKey : uint8_t {
+    KEY_FORWARD = 0,  // W (nell'ordine di CameraDirection)
+    KEY_BACKWARD,     // S
+    KEY_LEFT,         // A
+    KEY_RIGHT,        // D
+    KEY_BREAK,        // tasto sinistro del mouse
+    KEY_PLACE,        // tasto destro
+    KEY_NOCLIP,       // N
+    KEY_SPAWN_MOBS,   // M
+    KEY_DEBUG_UI,     // F3
+    KEY_SAVE_PROFILE, // F4
+    KEY_QUIT,         // Esc
+    KEY_BLOCK_1,      // 1..9: il blocco da piazzare
+    KEY_BLOCK_9 = KEY_BLOCK_1 + 8,
+
+    INPUT_KEY_COUNT
+};
+
+static_assert(INPUT_KEY_COUNT <= 32, "i tasti stanno in un uint32_t");
+
+struct InputFrame {
+    uint32_t keys        = 0; // un bit per InputKey tenuto giù
+    uint32_t frameMicros = 0; // durata del frame, in microsecondi
+    float    mouseX      = 0.0f; // spostamento del mouse, come lo vuole Camera::processMouseMovement
+    float    mouseY      = 0.0f;
+    float    scroll      = 0.0f;
+
+    bool  held(InputKey key) const { return (keys >> key) & 1u; }
+    void  press(InputKey key) { keys |= 1u << key; }
+    float deltaTime() const { return (float)frameMicros * 1e-6f; }
+
+    // Il tempo del frame si tiene in microsecondi interi: anche dal
+    // vivo si usa quello arrotondato, così la partita registrata è
+    // proprio quella giocata
+    static uint32_t toMicros(float seconds);
+};
+
+// ---------------------------------------------------------------
+// InputMapper
+// Trasforma i frame in quello che fanno: mouse e scroll girano e
+// zoomano la camera (processMouseMovement, processMouseScroll), i
+// tasti diventano il PlayerInput del prossimo tick.
+//
+// Ricorda i tasti del frame prima per la "edge detection": una
+// pressione (rompere, noclip, F3...) scatta solo nel frame in cui il
+// tasto va giù, non in tutti quelli in cui resta tenuto.
+// ---------------------------------------------------------------
+class InputMapper {
+public:
+    PlayerInput apply(const InputFrame& frame, Camera& camera);
+
+    // Dopo apply: tasto tenuto giù, o appena premuto in questo frame
+    bool held(InputKey key) const { return (keys >> key) & 1u; }
+    bool pressed(InputKey key) const { return ((keys & ~previousKeys) >> key) & 1u; }
+
+    BlockID placeBlock() const { return block; }
+
+private:
+    uint32_t keys         = 0;
+    uint32_t previousKeys = 0;
+    BlockID  block        = BLOCK_STONE;
+};
+
+// Il blocco del tasto 1..9: i tipi di BlockType fino alla lava, poi
+// i primi due registrati a runtime (BLOCK_AIR se non ci sono)
+BlockID blockForKey(int number);
+
+// ---------------------------------------------------------------
+// Una partita registrata: come ripartire (seed, spawn, camera) e un
+// InputFrame per frame, dal primo frame giocabile all'ultimo.
+//
+// Su disco un'intestazione fissa e poi i frame compatti: un byte di
+// flag dice cosa è cambiato dal frame prima, e solo quello segue.
+// I tasti cambiano di rado, il tempo del frame va come differenza in
+// varint (uno o due byte), mouse e scroll come float esatti e solo se
+// si sono mossi. Un frame senza mouse costa da uno a tre byte, uno
+// col mouse una decina.
+// ---------------------------------------------------------------
+struct InputRecording {
+    uint32_t  seed     = 0;
+    int       tickRate = 60;
+    glm::vec3 spawn{ 0.0f }; // occhi del giocatore al primo frame
+    float     yaw   = -90.0f;
+    float     pitch = 0.0f;
+    float     fov   = 45.0f;
+    uint64_t  blockRegistry = blockRegistryHash(); // tipi di blocco di chi ha registrato
+    uint64_t  finalState = 0;           // Simulation::stateHash() alla fine, 0 se non si sa
+    std::vector<InputFrame> frames;
+
+    double seconds() const;
+};
+
+bool saveInputRecording(const std::string& path, const InputRecording& recording);
+
+// false (con un messaggio) se il file manca, è di un'altra versione o è rovinato
+bool loadInputRecording(const std::string& path, InputRecording& recording);
+
+// false (con un messaggio) se i tipi di blocco registrati adesso non
+// sono quelli di chi ha registrato: gli stessi tasti 8 e 9 piazzerebbero
+// altri blocchi e la partita andrebbe diversamente
+bool checkBlockTypes(const InputRecording& recording);
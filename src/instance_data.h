@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+// ---------------------------------------------------------------
+// Dati per istanza degli oggetti che non sono terreno (frammenti,
+// oggetti a terra, entità): tutti cubi scalati e ruotati. Invece di
+// una draw call e di un setMat4 per oggetto, le istanze del frame
+// vanno in un solo buffer con una scrittura, e una sola
+// glDrawElementsInstanced le disegna tutte (vedi instance_renderer.h).
+// 40 byte invece dei 64 di una mat4: la matrice la ricostruisce il
+// vertex shader da posizione, scala e quaternione.
+//
+//   layers (32 bit)
+//     bit  0-9   layer della faccia sopra (+Y)
+//     bit 10-19  layer della faccia sotto (-Y)
+//     bit 20-29  layer dei lati
+//
+//   light: luce del voxel in cui sta l'oggetto, come Chunk::getLight
+//   (cielo nei 4 bit alti, blocchi nei 4 bassi)
+// ---------------------------------------------------------------
+struct InstanceData {
+    glm::vec3 position; // centro del cubo
+    float     scale;    // lato del cubo in blocchi
+    glm::vec4 rotation; // quaternione (x, y, z, w)
+    uint32_t  layers;
+    uint32_t  light;
+};
+
+static_assert(sizeof(InstanceData) == 40, "InstanceData deve occupare 40 byte");
+
+inline uint32_t packInstanceLayers(int top, int bottom, int side) {
+    return (uint32_t)(top & 1023) | (uint32_t)(bottom & 1023) << 10 | (uint32_t)(side & 1023) << 20;
+}
+
+// Quaternione di una rotazione di angle radianti attorno all'asse (normalizzato)
+inline glm::vec4 axisAngle(const glm::vec3& axis, float angle) {
+    float s = std::sin(angle * 0.5f);
+    return glm::vec4(axis.x * s, axis.y * s, axis.z * s, std::cos(angle * 0.5f));
+}
+
+// L'istanza a t tra a (0) e b (1), stesso oggetto in due tick di fila:
+// posizione e scala lineari, rotazione con il quaternione più corto
+// rinormalizzato (nlerp: tra due tick l'angolo è piccolo)
+inline InstanceData interpolateInstance(const InstanceData& a, const InstanceData& b, float t) {
+    glm::vec4 to = glm::dot(a.rotation, b.rotation) < 0.0f ? b.rotation * -1.0f : b.rotation;
+    InstanceData out = b;
+    out.position = glm::mix(a.position, b.position, t);
+    out.scale    = glm::mix(a.scale, b.scale, t);
+    out.rotation = glm::normalize(glm::mix(a.rotation, to, t));
+    return out;
+}
@@ -0,0 +1,95 @@
+#include "instance_renderer.h"
+
+#include <cstddef>
+#include <cstdint>
+
+#include <glad/glad.h>
+
+namespace {
+
+struct CubeVertex {
+    float    x, y, z;
+    uint32_t face;
+};
+
+// Cubo di lato 1 centrato nell'origine: 4 vertici per faccia, così
+// ogni faccia ha la sua (serve allo shader per normale e UV).
+// Facce nell'ordine di BlockFace, vertici antiorari visti da fuori.
+const CubeVertex CUBE_VERTICES[24] = {
+    {  0.5f, -0.5f, -0.5f, 0 }, {  0.5f,  0.5f, -0.5f, 0 }, {  0.5f,  0.5f,  0.5f, 0 }, {  0.5f, -0.5f,  0.5f, 0 }, // +X
+    { -0.5f, -0.5f, -0.5f, 1 }, { -0.5f, -0.5f,  0.5f, 1 }, { -0.5f,  0.5f,  0.5f, 1 }, { -0.5f,  0.5f, -0.5f, 1 }, // -X
+    { -0.5f,  0.5f, -0.5f, 2 }, { -0.5f,  0.5f,  0.5f, 2 }, {  0.5f,  0.5f,  0.5f, 2 }, {  0.5f,  0.5f, -0.5f, 2 }, // +Y
+    { -0.5f, -0.5f, -0.5f, 3 }, {  0.5f, -0.5f, -0.5f, 3 }, {  0.5f, -0.5f,  0.5f, 3 }, { -0.5f, -0.5f,  0.5f, 3 }, // -Y
+    { -0.5f, -0.5f,  0.5f, 4 }, {  0.5f, -0.5f,  0.5f, 4 }, {  0.5f,  0.5f,  0.5f, 4 }, { -0.5f,  0.5f,  0.5f, 4 }, // +Z
+    { -0.5f, -0.5f, -0.5f, 5 }, { -0.5f,  0.5f, -0.5f, 5 }, {  0.5f,  0.5f, -0.5f, 5 }, {  0.5f, -0.5f, -0.5f, 5 }, // -Z
+};
+
+const int CUBE_INDEX_COUNT = 36;
+
+} // namespace
+
+InstanceRenderer::InstanceRenderer() {
+    uint16_t indices[CUBE_INDEX_COUNT];
+    for (int face = 0; face < 6; face++) {
+        const uint16_t quad[6] = { 0, 1, 2, 2, 3, 0 };
+        for (int k = 0; k < 6; k++) indices[face * 6 + k] = (uint16_t)(face * 4 + quad[k]);
+    }
+
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &cubeVertices);
+    glGenBuffers(1, &cubeIndices);
+    glGenBuffers(1, &instanceBuffer);
+
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, cubeVertices);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(CUBE_VERTICES), CUBE_VERTICES, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(CubeVertex), (void*)offsetof(CubeVertex, x));
+    glEnableVertexAttribArray(1);
+    glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(CubeVertex), (void*)offsetof(CubeVertex, face));
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cubeIndices);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+
+    // Attributi per istanza: avanzano di un InstanceData per cubo, non per vertice
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)offsetof(InstanceData, position));
+    glVertexAttribDivisor(2, 1);
+    glEnableVertexAttribArray(3);
+    glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)offsetof(InstanceData, rotation));
+    glVertexAttribDivisor(3, 1);
+    glEnableVertexAttribArray(4);
+    glVertexAttribIPointer(4, 2, GL_UNSIGNED_INT, sizeof(InstanceData), (void*)offsetof(InstanceData, layers));
+    glVertexAttribDivisor(4, 1);
+
+    glBindVertexArray(0);
+}
+
+InstanceRenderer::~InstanceRenderer() {
+    glDeleteBuffers(1, &instanceBuffer);
+    glDeleteBuffers(1, &cubeIndices);
+    glDeleteBuffers(1, &cubeVertices);
+    glDeleteVertexArrays(1, &vao);
+}
+
+void InstanceRenderer::upload(const std::vector<InstanceData>& instances) {
+    count = (int)instances.size();
+    if (instances.empty()) return;
+
+    // Il buffer raddoppia quando non basta, così le riallocazioni sono
+    // rare anche se il numero di oggetti cresce a poco a poco
+    while (capacity < instances.size()) capacity = capacity ? capacity * 2 : 1024;
+
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(capacity * sizeof(InstanceData)), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)(instances.size() * sizeof(InstanceData)), instances.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void InstanceRenderer::draw() const {
+    if (count == 0) return;
+    glBindVertexArray(vao);
+    glDrawElementsInstanced(GL_TRIANGLES, CUBE_INDEX_COUNT, GL_UNSIGNED_SHORT, nullptr, count);
+    glBindVertexArray(0);
+}
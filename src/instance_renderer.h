@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "instance_data.h"
+
+// ---------------------------------------------------------------
+// InstanceRenderer
+// Disegna gli oggetti che non sono terreno (frammenti, oggetti,
+// entità) come istanze di un unico cubo. Le istanze del frame si
+// caricano in un solo buffer con una scrittura (upload) e si
+// disegnano con una sola glDrawElementsInstanced: il costo sulla CPU
+// non cresce con una draw call e un uniform per oggetto.
+//
+// Il buffer viene "orfanato" a ogni upload (glBufferData con nullptr
+// prima di scriverci): il driver dà memoria nuova invece di aspettare
+// che la GPU finisca di leggere le istanze del frame prima.
+//
+// Lo shader deve avere: location 0 = vec3 vertice del cubo unitario,
+// location 1 = uint faccia (BlockFace), location 2 = vec4 posizione e
+// scala, location 3 = vec4 quaternione, location 4 = uvec2 layer e luce.
+// ---------------------------------------------------------------
+class InstanceRenderer {
+public:
+    // Serve un contesto OpenGL attivo
+    InstanceRenderer();
+    ~InstanceRenderer();
+
+    InstanceRenderer(const InstanceRenderer&) = delete;
+    InstanceRenderer& operator=(const InstanceRenderer&) = delete;
+
+    // Sostituisce le istanze da disegnare: una scrittura nel buffer per frame
+    void upload(const std::vector<InstanceData>& instances);
+
+    // Disegna tutte le istanze caricate. Lo shader deve essere già attivo.
+    void draw() const;
+
+    int    instanceCount() const { return count; }
+    size_t gpuBytesCapacity() const { return capacity * sizeof(InstanceData); }
+
+private:
+    unsigned int vao            = 0;
+    unsigned int cubeVertices   = 0;
+    unsigned int cubeIndices    = 0;
+    unsigned int instanceBuffer = 0;
+    size_t       capacity       = 0; // istanze che stanno nel buffer
+    int          count          = 0;
+};
@@ -0,0 +1,221 @@
+#include "job_system.h"
+
+#include <algorithm>
+#include <string>
+
+#include "profiler.h"
+
+// ---------------------------------------------------------------
+// Ogni worker sa chi è: spawn() deve sapere in quale deque locale
+// mettere il job. thread_local = una copia della variabile per thread.
+// ---------------------------------------------------------------
+static thread_local JobSystem* currentSystem = nullptr;
+static thread_local int        currentWorker = -1;
+
+WorkStealingDeque::WorkStealingDeque(int capacity)
+    : buffer(new std::atomic<Job*>[capacity])
+    , mask(capacity - 1)
+{
+    // capacity deve essere una potenza di 2: l'indice si calcola con & mask
+}
+
+bool WorkStealingDeque::push(Job* job) {
+    int64_t b = bottom.load(std::memory_order_relaxed);
+    int64_t t = top.load(std::memory_order_acquire);
+    if (b - t > mask) return false; // piena
+
+    buffer[b & mask].store(job, std::memory_order_relaxed);
+    // "release": il job è visibile a chi legge il nuovo bottom con acquire
+    bottom.store(b + 1, std::memory_order_release);
+    return true;
+}
+
+Job* WorkStealingDeque::pop() {
+    int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+    bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top.load(std::memory_order_relaxed);
+
+    if (t > b) {
+        // Deque vuota: rimettiamo bottom a posto
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    Job* job = buffer[b & mask].load(std::memory_order_relaxed);
+    if (t == b) {
+        // Ultimo elemento: possiamo essere in gara con un ladro,
+        // vince chi riesce a spostare top per primo
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            job = nullptr;
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    return job;
+}
+
+Job* WorkStealingDeque::steal() {
+    int64_t t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = bottom.load(std::memory_order_acquire);
+    if (t >= b) return nullptr;
+
+    Job* job = buffer[t & mask].load(std::memory_order_relaxed);
+    if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        return nullptr; // un altro thread l'ha preso prima di noi
+    return job;
+}
+
+JobSystem::JobSystem(int workerCount) {
+    if (workerCount <= 0)
+        workerCount = std::max(1, (int)std::thread::hardware_concurrency() - 1);
+
+    // Le deque vanno create tutte prima di avviare i thread:
+    // un worker può provare a rubare da qualsiasi altra deque
+    for (int i = 0; i < workerCount; i++)
+        deques.push_back(std::make_unique<WorkStealingDeque>());
+    for (int i = 0; i < workerCount; i++)
+        workers.emplace_back(&JobSystem::workerLoop, this, i);
+}
+
+JobSystem::~JobSystem() {
+    waitIdle();
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    sleepCv.notify_all();
+    for (auto& worker : workers) worker.join();
+}
+
+void JobSystem::submit(Job job, float priority) {
+    pending.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(globalMutex);
+        globalQueue.push({ priority, nextSequence++, new Job(std::move(job)) });
+    }
+    queued.fetch_add(1, std::memory_order_release);
+    wakeOne();
+}
+
+void JobSystem::spawn(Job job) {
+    // Fuori da un worker di questo pool non c'è una deque locale
+    if (currentSystem != this) {
+        submit(std::move(job));
+        return;
+    }
+
+    pending.fetch_add(1, std::memory_order_relaxed);
+    Job* heapJob = new Job(std::move(job));
+    if (!deques[currentWorker]->push(heapJob)) {
+        std::lock_guard<std::mutex> lock(globalMutex);
+        globalQueue.push({ 0.0f, nextSequence++, heapJob });
+    }
+    queued.fetch_add(1, std::memory_order_release);
+    wakeOne();
+}
+
+// Stato condiviso di un parallelFor. Sta nell'heap perché un job di
+// aiuto può partire dopo che il chiamante è già tornato: in quel caso
+// trova il contatore esaurito ed esce senza toccare la funzione.
+namespace {
+
+struct ParallelRange {
+    std::atomic<int> next{ 0 };
+    std::atomic<int> done{ 0 };
+    int   count = 0;
+    void (*call)(void*, int) = nullptr;
+    void* function = nullptr;
+
+    void work() {
+        for (int i; (i = next.fetch_add(1, std::memory_order_relaxed)) < count;) {
+            call(function, i);
+            done.fetch_add(1, std::memory_order_release);
+        }
+    }
+};
+
+} // namespace
+
+void JobSystem::parallelFor(int count, void (*call)(void*, int), void* function) {
+    if (count <= 0) return;
+    if (count == 1) {
+        call(function, 0);
+        return;
+    }
+
+    auto range = std::make_shared<ParallelRange>();
+    range->count    = count;
+    range->call     = call;
+    range->function = function;
+
+    int helpers = std::min(workerCount(), count - 1);
+    for (int i = 0; i < helpers; i++) submit([range] { range->work(); }, -1.0f);
+
+    range->work();
+    // Qualcuno può avere ancora in mano l'ultimo indice
+    while (range->done.load(std::memory_order_acquire) < count) std::this_thread::yield();
+}
+
+void JobSystem::waitIdle() {
+    std::unique_lock<std::mutex> lock(idleMutex);
+    idleCv.wait(lock, [this] { return pending.load(std::memory_order_acquire) == 0; });
+}
+
+void JobSystem::wakeOne() {
+    // Prendere il lock prima di notificare evita la "sveglia persa":
+    // un worker che ha appena visto queued == 0 ma non dorme ancora
+    { std::lock_guard<std::mutex> lock(sleepMutex); }
+    sleepCv.notify_one();
+}
+
+void JobSystem::workerLoop(int index) {
+    currentSystem = this;
+    currentWorker = index;
+    PROFILE_THREAD("Worker " + std::to_string(index));
+
+    while (true) {
+        if (Job* job = findJob(index)) {
+            run(job);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleepCv.wait(lock, [this] {
+            return stopping.load() || queued.load(std::memory_order_acquire) > 0;
+        });
+        if (stopping.load() && queued.load() == 0) return;
+    }
+}
+
+Job* JobSystem::findJob(int index) {
+    // 1) Il proprio lavoro locale, il più recente (ancora in cache)
+    if (Job* job = deques[index]->pop()) return job;
+
+    // 2) La coda globale, il job più urgente
+    {
+        std::lock_guard<std::mutex> lock(globalMutex);
+        if (!globalQueue.empty()) {
+            Job* job = globalQueue.top().job;
+            globalQueue.pop();
+            return job;
+        }
+    }
+
+    // 3) Rubare dagli altri worker, partendo dal vicino
+    int count = (int)deques.size();
+    for (int i = 1; i < count; i++) {
+        if (Job* job = deques[(index + i) % count]->steal()) return job;
+    }
+    return nullptr;
+}
+
+void JobSystem::run(Job* job) {
+    queued.fetch_sub(1, std::memory_order_relaxed);
+    (*job)();
+    delete job;
+
+    if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        std::lock_guard<std::mutex> lock(idleMutex);
+        idleCv.notify_all();
+    }
+}
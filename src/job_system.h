@@ -0,0 +1,119 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Un "job" è una qualsiasi funzione senza argomenti da eseguire su un worker.
+// move_only_function (C++23) accetta anche lambda che catturano unique_ptr,
+// cosa che std::function non permette.
+using Job = std::move_only_function<void()>;
+
+// ---------------------------------------------------------------
+// WorkStealingDeque
+// Deque di Chase-Lev senza lock: il thread proprietario inserisce
+// e preleva dal fondo (LIFO, dati ancora "caldi" in cache), gli
+// altri worker rubano dalla cima (FIFO) quando restano senza lavoro.
+// Capacità fissa: se è piena push() fallisce e il chiamante ripiega
+// sulla coda globale.
+// ---------------------------------------------------------------
+class WorkStealingDeque {
+public:
+    explicit WorkStealingDeque(int capacity = 4096);
+
+    bool push(Job* job);   // solo il proprietario
+    Job* pop();            // solo il proprietario, nullptr se vuota
+    Job* steal();          // qualsiasi thread, nullptr se vuota o se perde la gara
+
+private:
+    std::atomic<int64_t> top{ 0 };
+    std::atomic<int64_t> bottom{ 0 };
+    std::unique_ptr<std::atomic<Job*>[]> buffer;
+    int64_t mask;
+};
+
+// ---------------------------------------------------------------
+// JobSystem
+// Pool di thread worker. I job arrivano in due modi:
+//  - submit(): coda globale ordinata per priorità (valori più bassi
+//    prima, es. la distanza del chunk dalla camera)
+//  - spawn(): dall'interno di un job, finisce nella deque locale del
+//    worker corrente; gli altri worker possono rubarlo
+// ---------------------------------------------------------------
+class JobSystem {
+public:
+    // workerCount = 0 → un worker per core, lasciando un core al render thread
+    explicit JobSystem(int workerCount = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    void submit(Job job, float priority = 0.0f);
+    void spawn(Job job);
+
+    // Chiama fn(i) per ogni i in [0, count) e ritorna quando hanno
+    // finito tutti. Il chiamante lavora anche lui invece di aspettare:
+    // se i worker sono occupati (meshing) fa da solo, senza restare
+    // fermo dietro ai loro job. Gli indici si prendono uno alla volta
+    // da un contatore condiviso, quindi conviene che ognuno valga un
+    // blocco di lavoro (centinaia di elementi), non un elemento solo.
+    // I job di aiuto passano davanti agli altri (priorità negativa).
+    template <typename Fn>
+    void parallelFor(int count, Fn&& fn) {
+        using Function = std::remove_reference_t<Fn>;
+        parallelFor(count, [](void* function, int index) { (*static_cast<Function*>(function))(index); }, &fn);
+    }
+
+    // Blocca finché tutti i job (anche quelli generati da altri job) sono finiti
+    void waitIdle();
+
+    int workerCount() const { return (int)workers.size(); }
+    int pendingJobs() const { return pending.load(std::memory_order_relaxed); }
+
+private:
+    void parallelFor(int count, void (*call)(void*, int), void* function);
+
+    struct QueuedJob {
+        float    priority;
+        uint64_t sequence; // a parità di priorità vince chi è arrivato prima
+        Job*     job;
+
+        // std::priority_queue estrae il "massimo": invertiamo il confronto
+        bool operator<(const QueuedJob& other) const {
+            if (priority != other.priority) return priority > other.priority;
+            return sequence > other.sequence;
+        }
+    };
+
+    void workerLoop(int index);
+    Job* findJob(int index);
+    void run(Job* job);
+    void wakeOne();
+
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<WorkStealingDeque>> deques;
+
+    std::mutex                     globalMutex;
+    std::priority_queue<QueuedJob> globalQueue;
+    uint64_t                       nextSequence = 0;
+
+    // Sveglia i worker addormentati quando arriva lavoro
+    std::mutex              sleepMutex;
+    std::condition_variable sleepCv;
+    std::atomic<int>        queued{ 0 };  // job in coda, non ancora iniziati
+
+    // Job non ancora finiti: per waitIdle()
+    std::atomic<int>        pending{ 0 };
+    std::mutex              idleMutex;
+    std::condition_variable idleCv;
+
+    std::atomic<bool> stopping{ false };
+};
@@ -0,0 +1,347 @@
+#include "light.h"
+
+#include <algorithm>
+
+#include "profiler.h"
+
+namespace {
+
+// Le 6 direzioni nell'ordine di BlockFace; la 3 è verso il basso
+const int DIRECTIONS[6][3] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+// Passo dell'indice in Chunk per ogni asse (x, y, z)
+const int STRIDES[3] = { 1, CHUNK_AREA, CHUNK_SIZE };
+constexpr int UP = 2;
+constexpr int DOWN = 3;
+
+constexpr int WORLD_TOP_Y = (WORLD_MAX_CHUNK_Y + 1) * CHUNK_SIZE - 1;
+
+const uint8_t FULL_SKY = Chunk::packLight(MAX_LIGHT, 0);
+
+} // namespace
+
+LightEngine::LightEngine(World& world)
+    : world(world)
+{
+}
+
+Chunk* LightEngine::locate(int x, int y, int z, int& index) {
+    if (y < WORLD_MIN_CHUNK_Y * CHUNK_SIZE || y > WORLD_TOP_Y) return nullptr;
+    index = Chunk::index(x & CHUNK_MASK, y & CHUNK_MASK, z & CHUNK_MASK);
+    return litChunk(World::toChunkPos(x, y, z));
+}
+
+int LightEngine::getLight(Chunk* chunk, int i, int channel) const {
+    uint8_t packed = chunk->getLightAt(i);
+    return channel == SKY ? packed >> 4 : packed & 15;
+}
+
+void LightEngine::setLight(Chunk* chunk, int i, int channel, int value) {
+    uint8_t packed = chunk->getLightAt(i);
+    packed = channel == SKY ? (uint8_t)(value << 4 | (packed & 15)) : (uint8_t)((packed & 0xF0) | value);
+    chunk->setLightAt(i, packed);
+}
+
+void LightEngine::markChanged(int x, int y, int z) {
+    // Come World::forEachChunkTouching, ma ricordando quali dei 27 chunk
+    // attorno a quello del voxel sono già segnati: la propagazione resta
+    // a lungo nello stesso chunk e così la hash map del World si tocca
+    // poche volte. Il ricordo vale per un aggiornamento (resetMarks).
+    ChunkPos pos = World::toChunkPos(x, y, z);
+    if (!(pos == lastChanged)) {
+        lastChanged = pos;
+        lastMarked = 0;
+    }
+    int local[3] = { x & CHUNK_MASK, y & CHUNK_MASK, z & CHUNK_MASK };
+    int range[3][2];
+    for (int a = 0; a < 3; a++) {
+        range[a][0] = local[a] == 0 ? -1 : 0;
+        range[a][1] = local[a] == CHUNK_MASK ? 1 : 0;
+    }
+    for (int dy = range[1][0]; dy <= range[1][1]; dy++)
+        for (int dz = range[2][0]; dz <= range[2][1]; dz++)
+            for (int dx = range[0][0]; dx <= range[0][1]; dx++) {
+                uint32_t bit = 1u << ((dy + 1) * 9 + (dz + 1) * 3 + (dx + 1));
+                if (lastMarked & bit) continue;
+                lastMarked |= bit;
+                int cy = pos.y + dy;
+                if (cy >= WORLD_MIN_CHUNK_Y && cy <= WORLD_MAX_CHUNK_Y) world.markMeshDirty({ pos.x + dx, cy, pos.z + dz });
+            }
+}
+
+Chunk* LightEngine::litChunk(const ChunkPos& pos) {
+    Chunk* chunk = world.getChunk(pos);
+    return chunk && chunk->isLit() ? chunk : nullptr;
+}
+
+void LightEngine::onChunkLoaded(const ChunkPos& pos) {
+    PROFILE_SCOPE("Light chunk");
+    visited = 0;
+    resetMarks();
+
+    // La luce del cielo arriva solo dall'alto: un chunk si illumina dopo
+    // quello sopra, così l'aria sotto il cielo prende sempre la via
+    // veloce e il terreno si riempie una volta sola. Quelli arrivati
+    // prima aspettano e si illuminano qui, a cascata verso il basso.
+    if (pos.y < WORLD_MAX_CHUNK_Y && !litChunk({ pos.x, pos.y + 1, pos.z })) return;
+
+    for (ChunkPos p = pos; p.y >= WORLD_MIN_CHUNK_Y; p.y--) {
+        Chunk* chunk = world.getChunk(p);
+        if (!chunk || chunk->isLit()) break;
+        lightChunk(p, *chunk);
+    }
+}
+
+void LightEngine::lightChunk(const ChunkPos& pos, Chunk& chunk) {
+    chunk.setLit(true);
+    int baseX = pos.x * CHUNK_SIZE, baseY = pos.y * CHUNK_SIZE, baseZ = pos.z * CHUNK_SIZE;
+
+    if (chunk.isEmpty() && (pos.y == WORLD_MAX_CHUNK_Y || bottomFullSky({ pos.x, pos.y + 1, pos.z }))) {
+        // Aria sotto il cielo: la luce scende dritta in ogni colonna, quindi
+        // vale 15 ovunque senza visita. Cambia tutto il chunk, anche il
+        // bordo che i vicini già meshati vedono; restano da propagare i bordi.
+        chunk.fillLight(FULL_SKY);
+        for (int dy = -1; dy <= 1; dy++)
+            for (int dz = -1; dz <= 1; dz++)
+                for (int dx = -1; dx <= 1; dx++) world.markMeshDirty({ pos.x + dx, pos.y + dy, pos.z + dz });
+        pushBorders(chunk, pos);
+    } else {
+        chunk.fillLight(0);
+
+        if (pos.y == WORLD_MAX_CHUNK_Y)
+            for (int z = 0; z < CHUNK_SIZE; z++)
+                for (int x = 0; x < CHUNK_SIZE; x++) {
+                    int i = Chunk::index(x, CHUNK_MASK, z);
+                    if (isOpaque(chunk.getBlockAt(i))) continue;
+                    setLight(&chunk, i, SKY, MAX_LIGHT);
+                    markChanged(baseX + x, baseY + CHUNK_MASK, baseZ + z);
+                    addQueue[SKY].push_back({ baseX + x, baseY + CHUNK_MASK, baseZ + z });
+                }
+
+        if (!chunk.isEmpty())
+            for (int i = 0; i < CHUNK_VOLUME; i++) {
+                int emission = blockEmission(chunk.getBlockAt(i));
+                if (emission == 0) continue;
+                setLight(&chunk, i, BLOCK, emission);
+                Voxel v = { baseX + (i & CHUNK_MASK), baseY + (i >> (2 * CHUNK_SHIFT)), baseZ + ((i >> CHUNK_SHIFT) & CHUNK_MASK) };
+                markChanged(v.x, v.y, v.z);
+                addQueue[BLOCK].push_back(v);
+            }
+    }
+
+    // Lo strato dei vicini che tocca questo chunk: la loro luce entra
+    // (il cielo no se qui è già tutto a 15)
+    bool fullSky = chunk.isLightUniform(FULL_SKY);
+    for (int d = 0; d < 6; d++) {
+        ChunkPos n = { pos.x + DIRECTIONS[d][0], pos.y + DIRECTIONS[d][1], pos.z + DIRECTIONS[d][2] };
+        if (const Chunk* neighbour = litChunk(n)) pushLayer(*neighbour, n, d ^ 1, !fullSky, true);
+    }
+
+    propagateAdd(SKY);
+    propagateAdd(BLOCK);
+}
+
+bool LightEngine::bottomFullSky(const ChunkPos& pos) {
+    const Chunk* chunk = litChunk(pos);
+    if (!chunk) return false;
+    if (chunk->isLightUniform(FULL_SKY)) return true;
+    // Lo strato y = 0 sono i primi CHUNK_AREA voxel
+    for (int i = 0; i < CHUNK_AREA; i++)
+        if (chunk->getLightAt(i) >> 4 != MAX_LIGHT) return false;
+    return true;
+}
+
+void LightEngine::pushLayer(const Chunk& chunk, const ChunkPos& pos, int d, bool sky, bool block) {
+    if (chunk.isLightUniform(0)) return;
+
+    int a = d >> 1;
+    int layer = (d & 1) ? 0 : CHUNK_MASK; // verso +: l'ultimo strato
+    for (int j = 0; j < CHUNK_SIZE; j++)
+        for (int k = 0; k < CHUNK_SIZE; k++) {
+            int p[3];
+            p[a] = layer;
+            p[(a + 1) % 3] = j;
+            p[(a + 2) % 3] = k;
+            uint8_t packed = chunk.getLight(p[0], p[1], p[2]);
+            Voxel v = { pos.x * CHUNK_SIZE + p[0], pos.y * CHUNK_SIZE + p[1], pos.z * CHUNK_SIZE + p[2] };
+            if (sky && (packed >> 4)) addQueue[SKY].push_back(v);
+            if (block && (packed & 15)) addQueue[BLOCK].push_back(v);
+        }
+}
+
+void LightEngine::pushBorders(const Chunk& chunk, const ChunkPos& pos) {
+    // Un chunk tutto a 15 di cielo: verso l'alto darebbe 14, e verso i
+    // vicini anche loro a 15 niente, quindi lì non c'è da propagare
+    for (int d = 0; d < 6; d++) {
+        if (d == UP) continue;
+        const Chunk* neighbour = litChunk({ pos.x + DIRECTIONS[d][0], pos.y + DIRECTIONS[d][1], pos.z + DIRECTIONS[d][2] });
+        if (!neighbour || neighbour->isLightUniform(FULL_SKY)) continue;
+        pushLayer(chunk, pos, d, true, false);
+    }
+}
+
+void LightEngine::setBlock(int x, int y, int z, BlockID id) {
+    BlockEdit edit = { x, y, z, id };
+    setBlocks(&edit, 1);
+}
+
+void LightEngine::setBlocks(const BlockEdit* edits, size_t count) {
+    PROFILE_SCOPE("Light update");
+    visited = 0;
+    resetMarks();
+
+    // Prima tutte le modifiche, ognuna mette in coda le sue sorgenti;
+    // poi un solo giro di remove e add per canale: la luce di una zona
+    // con molte modifiche si ricalcola una volta, non una per blocco
+    for (size_t e = 0; e < count; e++) {
+        auto [x, y, z, id] = edits[e];
+        BlockID old = world.getBlock(x, y, z);
+        if (old == id) continue;
+        world.setBlock(x, y, z, id);
+        queueChange(x, y, z, old, id);
+    }
+    propagate();
+}
+
+void LightEngine::blocksChanged(const BlockChange* changes, size_t count) {
+    PROFILE_SCOPE("Light update");
+    visited = 0;
+    resetMarks();
+
+    for (size_t c = 0; c < count; c++) {
+        auto [x, y, z, old, id] = changes[c];
+        if (old == id) continue;
+        world.markBlockChanged(x, y, z);
+        queueChange(x, y, z, old, id);
+    }
+    propagate();
+}
+
+void LightEngine::queueChange(int x, int y, int z, BlockID old, BlockID id) {
+    int i;
+    Chunk* chunk = locate(x, y, z, i);
+    if (!chunk) return;
+
+    // 1) La luce che passava di qui (ora è pieno) o che nasceva qui
+    //    (non emette più) si spegne, e con lei quella che ne dipendeva
+    for (int channel : { SKY, BLOCK }) {
+        int value = getLight(chunk, i, channel);
+        bool lost = isOpaque(id) || (channel == BLOCK && blockEmission(old) > 0);
+        if (value == 0 || !lost) continue;
+        setLight(chunk, i, channel, 0);
+        removeQueue[channel].push_back({ x, y, z, (uint8_t)value });
+    }
+
+    // 2) Ora è vuoto: la luce dei vicini (e del cielo, in cima) può entrare
+    if (!isOpaque(id)) {
+        for (const auto& d : DIRECTIONS) {
+            Voxel n = { x + d[0], y + d[1], z + d[2] };
+            addQueue[SKY].push_back(n);
+            addQueue[BLOCK].push_back(n);
+        }
+        if (y == WORLD_TOP_Y) {
+            setLight(chunk, i, SKY, MAX_LIGHT);
+            addQueue[SKY].push_back({ x, y, z });
+        }
+    }
+
+    // 3) Il nuovo blocco emette
+    int emission = blockEmission(id);
+    if (emission > getLight(chunk, i, BLOCK)) {
+        setLight(chunk, i, BLOCK, emission);
+        addQueue[BLOCK].push_back({ x, y, z });
+    }
+}
+
+void LightEngine::propagate() {
+    for (int channel : { SKY, BLOCK }) {
+        propagateRemove(channel);
+        propagateAdd(channel);
+    }
+}
+
+Chunk* LightEngine::neighbourOf(Chunk* chunk, int i, int x, int y, int z, int d, int& index) {
+    // Dentro lo stesso chunk basta spostare l'indice: il World (e la
+    // sua hash map) serve solo per passare il bordo
+    int a = d >> 1, step = DIRECTIONS[d][a];
+    int local = ((a == 0 ? x : a == 1 ? y : z) & CHUNK_MASK) + step;
+    if (local >= 0 && local < CHUNK_SIZE) {
+        index = i + step * STRIDES[a];
+        return chunk;
+    }
+    return locate(x + DIRECTIONS[d][0], y + DIRECTIONS[d][1], z + DIRECTIONS[d][2], index);
+}
+
+void LightEngine::propagateRemove(int channel) {
+    std::vector<Removal>& queue = removeQueue[channel];
+    for (size_t head = 0; head < queue.size(); head++) {
+        Removal r = queue[head];
+        int ri;
+        Chunk* current = locate(r.x, r.y, r.z, ri);
+        if (!current) continue;
+
+        for (int d = 0; d < 6; d++) {
+            int i;
+            Chunk* chunk = neighbourOf(current, ri, r.x, r.y, r.z, d, i);
+            if (!chunk) continue;
+            int value = getLight(chunk, i, channel);
+            if (value == 0) continue;
+
+            int nx = r.x + DIRECTIONS[d][0], ny = r.y + DIRECTIONS[d][1], nz = r.z + DIRECTIONS[d][2];
+            // Più scuro (o la colonna di cielo sotto): veniva da qui e si spegne.
+            // Un blocco che emette resta acceso e riparte.
+            bool dependent = value < r.value || (channel == SKY && d == DOWN && r.value == MAX_LIGHT);
+            int  emission  = channel == BLOCK ? blockEmission(chunk->getBlockAt(i)) : 0;
+            if (dependent && emission != value) {
+                // Un blocco non opaco che emette meno della luce che
+                // riceveva torna alla sua e la ripropaga
+                setLight(chunk, i, channel, emission);
+                markChanged(nx, ny, nz);
+                queue.push_back({ nx, ny, nz, (uint8_t)value });
+                if (emission > 0) addQueue[channel].push_back({ nx, ny, nz });
+            } else {
+                // Un'altra sorgente: ripropaga da qui per riempire il buco
+                addQueue[channel].push_back({ nx, ny, nz });
+            }
+        }
+    }
+    visited += (int)queue.size();
+    queue.clear();
+}
+
+void LightEngine::propagateAdd(int channel) {
+    std::vector<Voxel>& queue = addQueue[channel];
+    for (size_t head = 0; head < queue.size(); head++) {
+        Voxel v = queue[head];
+        int i;
+        Chunk* chunk = locate(v.x, v.y, v.z, i);
+        if (!chunk) continue;
+
+        // Si propaga la luce che il voxel ha adesso: una rimozione
+        // successiva all'inserimento in coda può averla cambiata
+        int value = getLight(chunk, i, channel);
+        if (value <= 1) continue;
+
+        for (int d = 0; d < 6; d++) {
+            int ni;
+            Chunk* neighbour = neighbourOf(chunk, i, v.x, v.y, v.z, d, ni);
+            if (!neighbour || (!neighbour->isEmpty() && isOpaque(neighbour->getBlockAt(ni)))) continue;
+
+            // La luce del cielo piena scende senza perdere niente
+            int next = (channel == SKY && d == DOWN && value == MAX_LIGHT) ? MAX_LIGHT : value - 1;
+            if (getLight(neighbour, ni, channel) >= next) continue;
+            setLight(neighbour, ni, channel, next);
+            int nx = v.x + DIRECTIONS[d][0], ny = v.y + DIRECTIONS[d][1], nz = v.z + DIRECTIONS[d][2];
+            markChanged(nx, ny, nz);
+            queue.push_back({ nx, ny, nz });
+        }
+    }
+    visited += (int)queue.size();
+    queue.clear();
+}
+
+void LightEngine::resetMarks() {
+    // Tra un aggiornamento e l'altro chi rimesha può aver preso (e
+    // spento) i chunk segnati: il ricordo di markChanged non vale più
+    lastChanged = { INT32_MIN, INT32_MIN, INT32_MIN };
+    lastMarked  = 0;
+}
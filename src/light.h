@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "world.h"
+
+// ---------------------------------------------------------------
+// LightEngine
+// Luce per voxel su due canali, 0..15, salvati nei chunk:
+//  - cielo: entra dall'alto del mondo a 15 e scende dritta senza
+//    perdere niente finché trova aria; di lato (e verso l'alto) cala
+//    di 1 per blocco
+//  - blocchi: parte dai blocchi che emettono (blockEmission) e cala
+//    di 1 per blocco in tutte le direzioni
+// La luce passa dai blocchi non opachi (isOpaque la ferma) e non entra nei
+// chunk non caricati. Un chunk si illumina quando c'è già quello sopra
+// (il cielo arriva dall'alto): fino ad allora conta come non caricato.
+//
+// Tutto è un flood fill in ampiezza con due code per canale:
+//  - "add": voxel da cui propagare la luce che hanno adesso
+//  - "remove": voxel che hanno perso la luce, con il valore di prima;
+//    i vicini più scuri dipendevano da loro e si spengono a catena,
+//    quelli più chiari hanno un'altra sorgente e tornano in "add"
+// Una modifica tocca solo la zona in cui la luce cambia davvero, mai
+// il mondo intero. I chunk in cui la luce cambia (e i vicini che la
+// vedono nel bordo) si segnano con World::markMeshDirty.
+//
+// Solo per il render thread, come il World.
+// ---------------------------------------------------------------
+class LightEngine {
+public:
+    explicit LightEngine(World& world);
+
+    // Un chunk appena inserito nel mondo: la luce entra dai vicini già
+    // illuminati (e dal cielo se è in cima) ed esce verso di loro. Se
+    // sopra non c'è ancora niente aspetta; se sotto c'erano chunk in
+    // attesa si illuminano adesso.
+    void onChunkLoaded(const ChunkPos& pos);
+
+    // Come World::setBlock, aggiornando la luce attorno al blocco
+    void setBlock(int x, int y, int z, BlockID id);
+
+    // Molte modifiche insieme (esplosioni, riempimenti): si cambiano
+    // tutti i blocchi e poi la luce si propaga una volta sola
+    void setBlocks(const BlockEdit* edits, size_t count);
+
+    // Blocchi già cambiati nei chunk (BlockUpdateSystem): come setBlocks
+    // ma senza scriverli, e segna il World come farebbe setBlock
+    void blocksChanged(const BlockChange* changes, size_t count);
+
+    // Voxel visitati dall'ultimo aggiornamento, per debug e benchmark
+    int lastVisited() const { return visited; }
+
+private:
+    enum Channel { SKY = 0, BLOCK = 1 };
+
+    struct Voxel {
+        int x, y, z;
+    };
+    struct Removal {
+        int     x, y, z;
+        uint8_t value; // luce che aveva prima di spegnersi
+    };
+
+    int  getLight(Chunk* chunk, int i, int channel) const;
+    void setLight(Chunk* chunk, int i, int channel, int value);
+    void markChanged(int x, int y, int z);
+
+    // Mette in coda la luce da spegnere e da propagare per il blocco
+    // (x, y, z) passato da old a id; propagate() fa il giro delle code
+    void queueChange(int x, int y, int z, BlockID old, BlockID id);
+    void propagate();
+    void resetMarks();
+
+    // Il chunk se è caricato e già illuminato, se no nullptr
+    Chunk* litChunk(const ChunkPos& pos);
+    // Chunk del blocco e indice locale; nullptr se non è caricato o illuminato
+    Chunk* locate(int x, int y, int z, int& index);
+    // Il vicino in direzione d del voxel (x, y, z), che sta in chunk a indice i
+    Chunk* neighbourOf(Chunk* chunk, int i, int x, int y, int z, int d, int& index);
+
+    // Mette in coda "add" lo strato di chunk (in pos) che guarda verso
+    // la direzione d, solo i voxel con luce e solo i canali richiesti
+    void pushLayer(const Chunk& chunk, const ChunkPos& pos, int d, bool sky, bool block);
+
+    // Lo stesso per le 5 facce (non quella in alto) di un chunk tutto
+    // a cielo pieno, verso i vicini caricati che possono ancora riceverlo
+    void pushBorders(const Chunk& chunk, const ChunkPos& pos);
+
+    // true se lo strato più basso del chunk (illuminato) è tutto cielo a 15
+    bool bottomFullSky(const ChunkPos& pos);
+
+    // Calcola la luce di un chunk appena caricato, con quello sopra già
+    // illuminato (o in cima al mondo)
+    void lightChunk(const ChunkPos& pos, Chunk& chunk);
+
+    void propagateRemove(int channel);
+    void propagateAdd(int channel);
+
+    World& world;
+
+    std::vector<Voxel>   addQueue[2];
+    std::vector<Removal> removeQueue[2];
+
+    ChunkPos lastChanged = { INT32_MIN, INT32_MIN, INT32_MIN };
+    uint32_t lastMarked = 0; // bit dei 27 chunk attorno a lastChanged già segnati
+
+    int visited = 0;
+};
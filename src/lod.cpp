@@ -0,0 +1,386 @@
+#include "lod.h"
+
+#include <cmath>
+#include <cstring>
+
+#include "profiler.h"
+
+// Altezza del mondo in blocchi
+constexpr int WORLD_BOTTOM = WORLD_MIN_CHUNK_Y * CHUNK_SIZE;
+constexpr int WORLD_TOP    = (WORLD_MAX_CHUNK_Y + 1) * CHUNK_SIZE;
+
+// ---------------------------------------------------------------
+// LodSelection
+// ---------------------------------------------------------------
+
+LodSelection::LodSelection(const LodSettings& settings, const glm::vec3& cameraPosition) {
+    levelCount = std::clamp(settings.levels, 0, MAX_LEVELS);
+    // Pari e almeno 2: è quello che fa combaciare gli anelli
+    nodeRadius = std::max(2, settings.radius + (settings.radius & 1));
+
+    int blockX = (int)std::floor(cameraPosition.x);
+    int blockZ = (int)std::floor(cameraPosition.z);
+
+    for (int level = 0; level <= levelCount; level++) {
+        // Nodo della camera, arrotondato per difetto a un numero pari:
+        // così la regione del livello sotto cade su nodi interi di questo
+        int shift = CHUNK_SHIFT + level;
+        int x = (blockX >> shift) & ~1;
+        int z = (blockZ >> shift) & ~1;
+        regions[level].min = glm::ivec2(x - nodeRadius, z - nodeRadius);
+        regions[level].max = glm::ivec2(x + nodeRadius, z + nodeRadius);
+    }
+
+    int size = lodNodeSize(levelCount);
+    const Region& outer = regions[levelCount];
+    distance = (float)std::min({ blockX - outer.min.x * size, outer.max.x * size - blockX,
+                                 blockZ - outer.min.y * size, outer.max.y * size - blockZ });
+}
+
+bool LodSelection::inRegion(int level, int x, int z) const {
+    const Region& r = regions[level];
+    return x >= r.min.x && x < r.max.x && z >= r.min.y && z < r.max.y;
+}
+
+bool LodSelection::isSelected(int level, int x, int z) const {
+    if (level < 1 || level > levelCount) return false;
+    // Il nodo (x, z) contiene i nodi (2x, 2z)..(2x+1, 2z+1) del livello
+    // sotto: la regione di sotto è allineata, basta controllare il primo
+    return inRegion(level, x, z) && !inRegion(level - 1, x * 2, z * 2);
+}
+
+uint8_t LodSelection::seams(const LodNode& node) const {
+    int level = node.level, x = node.pos.x, z = node.pos.z;
+    uint8_t result = 0;
+    if (!isSelected(level, x + 1, z)) result |= LOD_SEAM_POS_X;
+    if (!isSelected(level, x - 1, z)) result |= LOD_SEAM_NEG_X;
+    if (!isSelected(level, x, z + 1)) result |= LOD_SEAM_POS_Z;
+    if (!isSelected(level, x, z - 1)) result |= LOD_SEAM_NEG_Z;
+    return result;
+}
+
+void LodSelection::nodes(std::vector<LodNode>& out) const {
+    out.clear();
+    for (int level = 1; level <= levelCount; level++) {
+        const Region& r = regions[level];
+        for (int z = r.min.y; z < r.max.y; z++)
+            for (int x = r.min.x; x < r.max.x; x++) {
+                if (!isSelected(level, x, z)) continue;
+                for (int y = 0; y < lodColumnNodes(level); y++) out.push_back({ { x, y, z }, level });
+            }
+    }
+}
+
+bool LodSelection::operator==(const LodSelection& other) const {
+    if (levelCount != other.levelCount || nodeRadius != other.nodeRadius) return false;
+    for (int level = 0; level <= levelCount; level++)
+        if (regions[level].min != other.regions[level].min) return false;
+    return true;
+}
+
+// ---------------------------------------------------------------
+// Dati dei nodi
+// ---------------------------------------------------------------
+
+void generateLodInput(const TerrainGenerator& terrain, const LodNode& node, uint8_t seams, MeshInput& out) {
+    int step = 1 << node.level;
+    int size = lodNodeSize(node.level);
+    int baseX = node.pos.x * size, baseY = node.pos.y * size, baseZ = node.pos.z * size;
+
+    // Il bordo è un campione più in là, alla stessa distanza degli altri
+    terrain.sample(baseX - step, baseY - step, baseZ - step, step, MESH_PADDED_SIZE, out.blocks);
+
+    // Niente LightEngine per i nodi: da lontano il terreno è al sole,
+    // l'ombra la dà l'AO calcolata sui blocchi del nodo
+    std::memset(out.light, Chunk::packLight(MAX_LIGHT, 0), sizeof(out.light));
+
+    auto clearX = [&](int x) {
+        for (int y = -1; y <= CHUNK_SIZE; y++)
+            for (int z = -1; z <= CHUNK_SIZE; z++) out.blocks[MeshInput::index(x, y, z)] = BLOCK_AIR;
+    };
+    auto clearZ = [&](int z) {
+        for (int y = -1; y <= CHUNK_SIZE; y++)
+            for (int x = -1; x <= CHUNK_SIZE; x++) out.blocks[MeshInput::index(x, y, z)] = BLOCK_AIR;
+    };
+
+    for (int y = -1; y <= CHUNK_SIZE; y++) {
+        int wy = baseY + y * step;
+        if (wy >= WORLD_BOTTOM && wy < WORLD_TOP) continue;
+        for (int z = -1; z <= CHUNK_SIZE; z++)
+            for (int x = -1; x <= CHUNK_SIZE; x++) out.blocks[MeshInput::index(x, y, z)] = BLOCK_AIR;
+    }
+
+    if (seams & LOD_SEAM_POS_X) clearX(CHUNK_SIZE);
+    if (seams & LOD_SEAM_NEG_X) clearX(-1);
+    if (seams & LOD_SEAM_POS_Z) clearZ(CHUNK_SIZE);
+    if (seams & LOD_SEAM_NEG_Z) clearZ(-1);
+}
+
+// ---------------------------------------------------------------
+// LodManager
+// ---------------------------------------------------------------
+
+LodManager::LodManager(JobSystem& jobs, const TerrainGenerator& terrain, LodSettings settings)
+    : jobs(jobs)
+    , terrain(terrain)
+    , settings(settings)
+{
+}
+
+LodManager::~LodManager() {
+    // I job in volo usano la nostra coda: aspettiamo che finiscano
+    jobs.waitIdle();
+}
+
+float LodManager::priorityOf(const LodNode& node) const {
+    float size = (float)lodNodeSize(node.level);
+    glm::vec3 center(
+        (node.pos.x + 0.5f) * size,
+        (node.pos.y + 0.5f) * size,
+        (node.pos.z + 0.5f) * size
+    );
+    return glm::length(center - cameraPosition);
+}
+
+void LodManager::update(const glm::vec3& position, const ChunkMeshedFn& chunkMeshed) {
+    PROFILE_SCOPE("LOD update");
+    cameraPosition = position;
+
+    // La selezione cambia solo quando la camera passa un bordo di chunk
+    LodSelection selection(settings, position);
+    if (!hasSelection || !(selection == current)) select(selection);
+
+    // Finché ci sono nodi stale va ricontrollato ogni frame: i chunk
+    // meshati arrivano dalla ChunkPipeline senza avvisarci
+    if (!dirty && staleCount == 0) return;
+    resolveStale(chunkMeshed);
+    rebuildDrawable();
+    dirty = false;
+}
+
+void LodManager::select(const LodSelection& selection) {
+    current      = selection;
+    hasSelection = true;
+    dirty        = true;
+
+    for (auto& [node, entry] : entries) entry.desired = false;
+
+    static thread_local std::vector<LodNode> nodes;
+    selection.nodes(nodes);
+    for (const LodNode& node : nodes) {
+        Entry& entry  = entries[node];
+        entry.desired = true;
+
+        // Un nodo che resta selezionato ma cambia vicini va rifatto con
+        // le nuove pareti; quello vecchio resta disegnato nel frattempo
+        uint8_t seams = selection.seams(node);
+        if (!entry.requested || entry.seams != seams) submit(node, entry, seams);
+    }
+
+    for (auto it = entries.begin(); it != entries.end();) {
+        Entry& entry = it->second;
+        if (entry.desired) { ++it; continue; }
+
+        // Il job, se non è ancora partito, può saltare il lavoro
+        if (entry.wanted) entry.wanted->store(false, std::memory_order_relaxed);
+        entry.requested = false;
+
+        // Un nodo disegnato resta (stale) finché qualcosa non lo sostituisce
+        if (entry.shown) ++it;
+        else it = erase(it);
+    }
+}
+
+void LodManager::submit(const LodNode& node, Entry& entry, uint8_t seams) {
+    if (entry.wanted) entry.wanted->store(false, std::memory_order_relaxed);
+    entry.wanted    = std::make_shared<std::atomic<bool>>(true);
+    entry.version   = nextVersion++;
+    entry.seams     = seams;
+    entry.requested = true;
+
+    inFlight.fetch_add(1, std::memory_order_relaxed);
+    jobs.submit([this, node, seams, version = entry.version, wanted = entry.wanted] {
+        MeshedNode result;
+        result.node    = node;
+        result.version = version;
+        if (wanted->load(std::memory_order_relaxed)) {
+            PROFILE_SCOPE("LOD node");
+            PooledMeshInput input = acquireMeshInput();
+            generateLodInput(terrain, node, seams, *input);
+            result.mesh = acquireChunkMesh();
+            result.mesh->visibility = {}; // riciclata: quella di prima non vale
+            buildChunkMesh(*input, *result.mesh);
+        }
+        meshedQueue.push(std::move(result));
+    }, priorityOf(node));
+}
+
+LodManager::Entry* LodManager::acceptMesh(MeshedNode& result) {
+    // Job annullato o superato da uno più recente
+    auto it = entries.find(result.node);
+    if (it == entries.end() || !result.mesh || it->second.version != result.version) return nullptr;
+
+    Entry& entry = it->second;
+    if (!entry.desired) return nullptr;
+
+    entry.ready     = true;
+    entry.hasMesh   = !result.mesh->empty();
+    entry.triangles = result.mesh->triangleCount();
+    dirty = true;
+    return &entry;
+}
+
+LodManager::EntryMap::iterator LodManager::erase(EntryMap::iterator it) {
+    Entry& entry = it->second;
+    if (entry.wanted) entry.wanted->store(false, std::memory_order_relaxed);
+    if (entry.hasMesh) removed.push_back(it->first);
+    return entries.erase(it);
+}
+
+// ---------------------------------------------------------------
+// Nodi stale
+// Un nodo stale se ne va quando tutto quello che lo sostituisce è
+// pronto: i nodi selezionati che lo toccano e i chunk del livello 0.
+// I nodi selezionati che toccano uno stale non ancora sostituibile
+// restano nascosti. Siccome un nodo nuovo può toccare più nodi stale,
+// il blocco si propaga: uno stale pronto non se ne va se uno dei suoi
+// sostituti deve ancora restare nascosto per colpa di un altro.
+// ---------------------------------------------------------------
+
+bool LodManager::collectOverlaps(const LodNode& node, const ChunkMeshedFn& chunkMeshed) {
+    int size = lodNodeSize(node.level);
+    int x0 = node.pos.x * size, x1 = x0 + size - 1;
+    int z0 = node.pos.z * size, z1 = z0 + size - 1;
+    int y0 = node.pos.y * size, y1 = std::min(y0 + size, WORLD_TOP) - 1;
+    bool covered = true;
+
+    for (int level = 1; level <= current.levels(); level++) {
+        int shift = CHUNK_SHIFT + level;
+        int topNode = lodColumnNodes(level) - 1;
+        for (int z = z0 >> shift; z <= z1 >> shift; z++)
+            for (int x = x0 >> shift; x <= x1 >> shift; x++) {
+                if (!current.isSelected(level, x, z)) continue;
+                for (int y = y0 >> shift; y <= std::min(y1 >> shift, topNode); y++) {
+                    LodNode other = { { x, y, z }, level };
+                    auto it = entries.find(other);
+                    if (it == entries.end() || !it->second.ready) covered = false;
+                    overlaps.push_back(other);
+                }
+            }
+    }
+
+    for (int z = z0 >> CHUNK_SHIFT; z <= z1 >> CHUNK_SHIFT; z++)
+        for (int x = x0 >> CHUNK_SHIFT; x <= x1 >> CHUNK_SHIFT; x++) {
+            if (!current.isDetail(x, z)) continue;
+            for (int y = y0 >> CHUNK_SHIFT; y <= y1 >> CHUNK_SHIFT && covered; y++)
+                if (!chunkMeshed({ x, y, z })) covered = false;
+        }
+    return covered;
+}
+
+void LodManager::resolveStale(const ChunkMeshedFn& chunkMeshed) {
+    for (const LodNode& node : blockedNodes) {
+        auto it = entries.find(node);
+        if (it != entries.end()) it->second.blocked = false;
+    }
+    blockedNodes.clear();
+    staleNodes.clear();
+    overlaps.clear();
+
+    for (const auto& [node, entry] : entries) {
+        if (entry.desired) continue;
+        size_t first = overlaps.size();
+        bool covered = collectOverlaps(node, chunkMeshed);
+        staleNodes.push_back({ node, covered, first, overlaps.size() - first });
+    }
+
+    auto block = [&](const StaleNode& stale) {
+        for (size_t i = stale.first; i < stale.first + stale.count; i++) {
+            Entry& entry = entries[overlaps[i]];
+            if (entry.blocked) continue;
+            entry.blocked = true;
+            blockedNodes.push_back(overlaps[i]);
+        }
+    };
+    for (const StaleNode& stale : staleNodes)
+        if (!stale.covered) block(stale);
+
+    // Propagazione: ripete finché qualche stale cambia idea
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (StaleNode& stale : staleNodes) {
+            if (!stale.covered) continue;
+            for (size_t i = stale.first; i < stale.first + stale.count; i++) {
+                if (!entries[overlaps[i]].blocked) continue;
+                stale.covered = false;
+                block(stale);
+                changed = true;
+                break;
+            }
+        }
+    }
+
+    staleCount = 0;
+    for (const StaleNode& stale : staleNodes) {
+        if (stale.covered) erase(entries.find(stale.node));
+        else staleCount++;
+    }
+
+    for (auto& [node, entry] : entries)
+        if (entry.desired) entry.shown = entry.ready && !entry.blocked;
+}
+
+void LodManager::rebuildDrawable() {
+    boxes = BoxBatch();
+    drawable.clear();
+    for (const auto& [node, entry] : entries) {
+        if (!entry.shown || !entry.hasMesh) continue;
+        float size = (float)lodNodeSize(node.level);
+        glm::vec3 min = glm::vec3(node.pos.x, node.pos.y, node.pos.z) * size;
+        boxes.push(min, min + glm::vec3(size));
+        drawable.push_back(node);
+    }
+}
+
+// ---------------------------------------------------------------
+// Rendering
+// ---------------------------------------------------------------
+
+void LodManager::takeRemoved(std::vector<LodNode>& out) {
+    out.clear();
+    out.swap(removed);
+}
+
+void LodManager::cull(const Frustum& frustum, std::vector<LodNode>& visible) {
+    PROFILE_SCOPE("LOD cull");
+    visible.clear();
+    inFrustum.resize(drawable.size());
+    cullBoxes(frustum, boxes, inFrustum.data());
+    for (size_t i = 0; i < drawable.size(); i++)
+        if (inFrustum[i]) visible.push_back(drawable[i]);
+}
+
+bool LodManager::covers(const ChunkPos& chunk) const {
+    for (int level = 1; level <= current.levels(); level++) {
+        auto it = entries.find({ { chunk.x >> level, chunk.y >> level, chunk.z >> level }, level });
+        if (it != entries.end() && it->second.shown) return true;
+    }
+    return false;
+}
+
+LodStats LodManager::stats() const {
+    LodStats s;
+    s.levels       = current.levels();
+    s.staleNodes   = staleCount;
+    s.jobsInFlight = jobsInFlight();
+    s.viewDistance = current.viewDistance();
+    for (const auto& [node, entry] : entries) {
+        if (entry.desired) s.desiredNodes++;
+        if (!entry.shown) continue;
+        s.shownNodes++;
+        if (!entry.hasMesh) continue;
+        s.drawable++;
+        s.triangles += entry.triangles;
+    }
+    return s;
+}
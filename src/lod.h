@@ -0,0 +1,288 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "culling.h"
+#include "job_system.h"
+#include "mesher.h"
+#include "mpsc_queue.h"
+#include "terrain.h"
+#include "world.h"
+
+// ---------------------------------------------------------------
+// Livelli di dettaglio (LOD) per il terreno lontano.
+//
+// Un nodo di livello L è un cubo di 16 << L blocchi campionato
+// ogni 2^L blocchi: ha sempre 16³ campioni, quindi si mesha con lo
+// stesso mesher dei chunk e ha lo stesso costo, ma copre 8^L volte
+// il volume. Lo shader moltiplica la posizione dei vertici per 2^L.
+//
+// Attorno alla camera i livelli formano una clipmap di anelli
+// concentrici (vista dall'alto, R = raggio in nodi):
+//
+//   +---------------------------+
+//   |         livello 2         |
+//   |    +-----------------+    |
+//   |    |    livello 1    |    |
+//   |    |    +-------+    |    |
+//   |    |    |  0 =  |    |    |
+//   |    |    | chunk |    |    |
+//   |    |    +-------+    |    |
+//   |    +-----------------+    |
+//   +---------------------------+
+//
+// Ogni livello copre 2R × 2R nodi centrati sulla camera; la parte
+// centrale, già coperta dal livello più fine, viene saltata. Il
+// livello 0 sono i chunk veri, disegnati a piena risoluzione. Con
+// R pari e l'origine arrotondata a un numero pari di nodi, il buco
+// di ogni anello cade esattamente sui bordi dei nodi: ogni colonna
+// è coperta da un solo livello. Il numero di nodi non dipende dalla
+// distanza visiva: ogni livello in più la raddoppia a costo fisso.
+// ---------------------------------------------------------------
+
+// Un nodo: pos in unità del suo livello (il nodo (1, 0, 0) di
+// livello 2 copre i blocchi con x da 64 a 127)
+struct LodNode {
+    ChunkPos pos;
+    int      level;
+
+    bool operator==(const LodNode& other) const {
+        return pos == other.pos && level == other.level;
+    }
+};
+
+struct LodNodeHash {
+    size_t operator()(const LodNode& node) const noexcept {
+        return ChunkPosHash()(node.pos) ^ ((size_t)node.level * 0x9E3779B97F4A7C15ull);
+    }
+};
+
+// Lato di un nodo in blocchi
+inline int lodNodeSize(int level) { return CHUNK_SIZE << level; }
+
+// Nodi per colonna: il mondo è alto 8 chunk, dal livello 3 basta un nodo
+inline int lodColumnNodes(int level) {
+    return std::max(1, (WORLD_MAX_CHUNK_Y + 1) >> level);
+}
+
+// Lati orizzontali di un nodo senza vicino dello stesso livello:
+// lì il mesher chiude il nodo con una parete ("skirt") che copre le
+// fessure verso il livello accanto, più fine o più grossolano
+enum LodSeam : uint8_t {
+    LOD_SEAM_POS_X = 1,
+    LOD_SEAM_NEG_X = 2,
+    LOD_SEAM_POS_Z = 4,
+    LOD_SEAM_NEG_Z = 8
+};
+
+struct LodSettings {
+    int levels = 4; // livelli oltre ai chunk: 2x, 4x, 8x, 16x
+    int radius = 8; // in nodi, pari (come RENDER_DISTANCE per i chunk)
+};
+
+// ---------------------------------------------------------------
+// LodSelection
+// Quali nodi servono per una posizione della camera. Solo calcoli,
+// niente stato: la usa LodManager e si prova senza finestra.
+// ---------------------------------------------------------------
+class LodSelection {
+public:
+    LodSelection() = default;
+    LodSelection(const LodSettings& settings, const glm::vec3& cameraPosition);
+
+    int levels() const { return levelCount; }
+    int radius() const { return nodeRadius; }
+
+    // Nodi del livello (0 = chunk) coperti dal suo anello più il buco:
+    // x in [min.x, max.x), z in [min.y, max.y)
+    glm::ivec2 regionMin(int level) const { return regions[level].min; }
+    glm::ivec2 regionMax(int level) const { return regions[level].max; }
+
+    bool inRegion(int level, int x, int z) const;
+
+    // Colonna di chunk disegnata a piena risoluzione
+    bool isDetail(int chunkX, int chunkZ) const { return inRegion(0, chunkX, chunkZ); }
+
+    // Colonna di nodi che appartiene al livello (level >= 1)
+    bool isSelected(int level, int x, int z) const;
+
+    // Bit LodSeam del nodo
+    uint8_t seams(const LodNode& node) const;
+
+    // Tutti i nodi selezionati, dal livello 1 in su
+    void nodes(std::vector<LodNode>& out) const;
+
+    // Distanza orizzontale dalla camera al bordo dell'ultimo livello
+    float viewDistance() const { return distance; }
+
+    bool operator==(const LodSelection& other) const;
+
+private:
+    struct Region {
+        glm::ivec2 min{ 0 };
+        glm::ivec2 max{ 0 };
+    };
+
+    static constexpr int MAX_LEVELS = 8;
+
+    Region regions[MAX_LEVELS + 1];
+    int    levelCount = 0;
+    int    nodeRadius = 0;
+    float  distance   = 0.0f;
+};
+
+// Riempie l'input del mesher per un nodo: i 16³ campioni del nodo più
+// il bordo, tutti campionati ogni 2^level blocchi. I lati in seams
+// hanno il bordo d'aria. Sopra e sotto il mondo è aria, come in gather().
+// Le caverne non ci sono: campionate così rade sarebbero solo buchi.
+void generateLodInput(const TerrainGenerator& terrain, const LodNode& node, uint8_t seams, MeshInput& out);
+
+// Numeri per il pannello di debug
+struct LodStats {
+    int   levels       = 0;
+    int   desiredNodes = 0; // nodi della selezione attuale
+    int   shownNodes   = 0; // nodi che coprono il loro volume (anche vuoti)
+    int   staleNodes   = 0; // vecchi nodi ancora disegnati in attesa dei nuovi
+    int   drawable     = 0; // nodi con una mesh
+    int   triangles    = 0; // triangoli dei nodi disegnabili
+    int   jobsInFlight = 0;
+    float viewDistance = 0.0f;
+};
+
+// ---------------------------------------------------------------
+// LodManager
+// Tiene aggiornati i nodi LOD attorno alla camera, come ChunkPipeline
+// fa con i chunk: i worker generano e meshano, il render thread
+// raccoglie le mesh con consumeMeshes() e le carica sulla GPU.
+//
+// Quando la camera si sposta, i nodi che non servono più restano
+// disegnati ("stale") finché il loro volume non è coperto per intero
+// da nodi nuovi pronti e, dove torna il livello 0, da chunk meshati:
+// niente buchi durante le transizioni. Intanto i nodi nuovi che si
+// sovrappongono a un nodo stale aspettano nascosti, così nessuna
+// zona è disegnata due volte.
+//
+// I nodi campionano il generatore, non il World: le modifiche dei
+// giocatori si vedono solo entro la distanza dei chunk.
+// ---------------------------------------------------------------
+class LodManager {
+public:
+    // Dice se la mesh di un chunk è già sulla GPU (ChunkPipeline::isMeshed)
+    using ChunkMeshedFn = std::function<bool(const ChunkPos& pos)>;
+
+    LodManager(JobSystem& jobs, const TerrainGenerator& terrain, LodSettings settings = {});
+    ~LodManager();
+
+    LodManager(const LodManager&) = delete;
+    LodManager& operator=(const LodManager&) = delete;
+
+    // Render thread, una volta per frame: aggiorna la selezione, lancia
+    // i job dei nodi nuovi e decide quali nodi disegnare
+    void update(const glm::vec3& cameraPosition, const ChunkMeshedFn& chunkMeshed);
+
+    // Render thread: passa a fn(const LodNode&, const ChunkMesh&) al massimo
+    // maxCount mesh finite. Una mesh vuota sostituisce quella vecchia.
+    template <typename Fn>
+    int consumeMeshes(Fn&& fn, int maxCount) {
+        int count = 0;
+        MeshedNode result;
+        while (count < maxCount && meshedQueue.pop(result)) {
+            inFlight.fetch_sub(1, std::memory_order_relaxed);
+            Entry* entry = acceptMesh(result);
+            if (!entry) continue;
+            fn(result.node, *result.mesh);
+            count++;
+        }
+        return count;
+    }
+
+    // Nodi la cui mesh va tolta dalla GPU (svuota l'elenco interno)
+    void takeRemoved(std::vector<LodNode>& out);
+
+    // Nodi da disegnare in questo frame dentro il frustum
+    void cull(const Frustum& frustum, std::vector<LodNode>& visible);
+
+    // true se la colonna del chunk è già disegnata da un nodo LOD:
+    // in quel caso il chunk a piena risoluzione non va disegnato
+    bool covers(const ChunkPos& chunk) const;
+
+    const LodSelection& selection() const { return current; }
+    LodStats stats() const;
+
+    int  jobsInFlight() const { return inFlight.load(std::memory_order_relaxed); }
+    bool isIdle() const { return jobsInFlight() == 0 && staleCount == 0 && !dirty; }
+
+private:
+    struct Entry {
+        uint32_t version   = 0;     // dell'ultimo job lanciato
+        uint8_t  seams     = 0;     // con cui è stato lanciato
+        bool     requested = false; // un job valido è in volo o già consegnato
+        bool     desired   = false; // nella selezione attuale
+        bool     ready     = false; // una mesh (anche di una richiesta vecchia) è arrivata
+        bool     shown     = false; // copre il suo volume in questo frame
+        bool     blocked   = false; // pronto ma nascosto da un nodo stale
+        bool     hasMesh   = false; // mesh non vuota sulla GPU
+        int      triangles = 0;
+        std::shared_ptr<std::atomic<bool>> wanted; // false = il job può saltare il lavoro
+    };
+
+    struct MeshedNode {
+        LodNode  node{};
+        uint32_t version = 0;
+        PooledChunkMesh mesh; // nullptr se il job è stato annullato
+    };
+
+    void   select(const LodSelection& selection);
+    void   submit(const LodNode& node, Entry& entry, uint8_t seams);
+    Entry* acceptMesh(MeshedNode& result);
+    using EntryMap = std::unordered_map<LodNode, Entry, LodNodeHash>;
+
+    EntryMap::iterator erase(EntryMap::iterator it);
+    void   resolveStale(const ChunkMeshedFn& chunkMeshed);
+    bool   collectOverlaps(const LodNode& node, const ChunkMeshedFn& chunkMeshed);
+    void   rebuildDrawable();
+    float  priorityOf(const LodNode& node) const;
+
+    JobSystem&              jobs;
+    const TerrainGenerator& terrain;
+    LodSettings             settings;
+
+    LodSelection current;
+    bool         hasSelection = false;
+    glm::vec3    cameraPosition{ 0.0f };
+
+    // Un nodo stale e i nodi nuovi che si sovrappongono a lui
+    // (un intervallo di overlaps)
+    struct StaleNode {
+        LodNode node;
+        bool    covered;
+        size_t  first, count;
+    };
+
+    EntryMap entries;
+    std::vector<LodNode> removed;
+
+    // Buffer riusati tra un frame e l'altro
+    std::vector<StaleNode> staleNodes;
+    std::vector<LodNode>   overlaps;
+    std::vector<LodNode>   blockedNodes;
+    int  staleCount = 0;
+    bool dirty      = true; // i nodi disegnati vanno ricalcolati
+
+    // Nodi da disegnare: box e nodo nello stesso ordine
+    BoxBatch             boxes;
+    std::vector<LodNode> drawable;
+    std::vector<uint8_t> inFrustum;
+
+    MpscQueue<MeshedNode> meshedQueue;
+    std::atomic<int>      inFlight{ 0 };
+    uint32_t              nextVersion = 1;
+};
@@ -3,38 +3,78 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
 #include <iostream>
-#include <vector>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
 
 #include "shader.h"
 #include "camera.h"
 #include "debug_ui.h"
+#include "world.h"
+#include "mesher.h"
+#include "chunk_renderer.h"
+#include "instance_renderer.h"
+#include "material.h"
+#include "texture_array.h"
+#include "job_system.h"
+#include "chunk_pipeline.h"
+#include "chunk_streamer.h"
+#include "terrain.h"
+#include "culling.h"
+#include "light.h"
+#include "lod.h"
+#include "raycast.h"
+#include "simulation.h"
+#include "memory.h"
+#include "world_storage.h"
+#include "uniform_buffer.h"
+#include "profiler.h"
+#include "gpu_profiler.h"
+#include "asset_loader.h"
+#include "program_cache.h"
+#include "block_registry.h"
+#include "game_settings.h"
+#include "input_recording.h"
+#include "replay.h"
 #include <imgui.h>
 
-const char* vertexShaderSource = R"(
-    #version 330 core
-    layout (location = 0) in vec3 aPos;
+// Cartella degli shader: CMake passa quella dei sorgenti, così
+// modificare un file in shaders/ aggiorna il gioco mentre gira
+#ifndef VOXEL_SHADER_DIR
+#define VOXEL_SHADER_DIR "shaders"
+#endif
 
-    uniform mat4 model;
-    uniform mat4 view;
-    uniform mat4 projection;
+// Seed del mondo: lo stesso seed genera sempre lo stesso terreno
+const uint32_t WORLD_SEED = 1337;
 
-    void main() {
-        gl_Position = projection * view * model * vec4(aPos, 1.0);
-    }
-)";
+// Cartella dei region file: una per seed, così cambiare seed non
+// mescola chunk di mondi diversi
+const std::string WORLD_DIRECTORY = "saves/world_" + std::to_string(WORLD_SEED);
 
-const char* fragmentShaderSource = R"(
-    #version 330 core
-    out vec4 FragColor;
+// Binari degli shader già linkati (vedi ProgramCache): si possono
+// cancellare in qualsiasi momento, al prossimo avvio si ricompila
+const std::string SHADER_CACHE_DIRECTORY = "cache/shaders";
 
-    void main() {
-        FragColor = vec4(0.4, 0.7, 0.3, 1.0);
-    }
-)";
+// Tipi di blocco in più, se il file c'è (formato in block_registry.h).
+// Server e client devono leggere lo stesso file: il server rifiuta i
+// BlockID che non conosce.
+const std::string BLOCK_DEFINITIONS_FILE = "blocks.txt";
 
-const int SCREEN_WIDTH  = 800;
-const int SCREEN_HEIGHT = 600;
+// Inizio del programma (inizializzazione statica, prima di main):
+// da qui si misurano il primo frame e il momento in cui si gioca
+const auto PROGRAM_START = std::chrono::steady_clock::now();
+
+double secondsSinceStart() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - PROGRAM_START).count();
+}
 
 Camera  camera(glm::vec3(0.0f, 1.0f, 5.0f));
 DebugUI debugUI;
@@ -45,12 +85,9 @@ bool  firstMouse = true;
 float lastX = SCREEN_WIDTH  / 2.0f;
 float lastY = SCREEN_HEIGHT / 2.0f;
 
-// ---------------------------------------------------------------
-// Teniamo traccia se F3 era premuto al frame precedente per evitare
-// che il toggle si attivi più volte tenendo premuto il tasto.
-// Questo pattern si chiama "edge detection" dell'input.
-// ---------------------------------------------------------------
-bool f3WasPressed = false;
+// Mouse e scroll arrivano dai callback di GLFW, anche più volte per
+// frame: si sommano qui e processInput li mette nel frame
+InputFrame liveInput;
 
 void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
     // Se ImGui vuole catturare il mouse (es. ci stiamo sopra con il cursore)
@@ -62,45 +99,112 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
         lastY = (float)ypos;
         firstMouse = false;
     }
-    float xoffset = (float)xpos - lastX;
-    float yoffset = lastY - (float)ypos;
+    liveInput.mouseX += (float)xpos - lastX;
+    liveInput.mouseY += lastY - (float)ypos;
     lastX = (float)xpos;
     lastY = (float)ypos;
-    camera.processMouseMovement(xoffset, yoffset);
 }
 
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
-    camera.processMouseScroll((float)yoffset);
+    liveInput.scroll += (float)yoffset;
+}
+
+// Legge tastiera e mouse e ne fa l'InputFrame del frame: cosa fanno
+// i tasti lo decide InputMapper, uguale dal vivo e in una registrazione
+InputFrame processInput(GLFWwindow* window, float deltaTime) {
+    InputFrame frame = liveInput;
+    liveInput = {};
+    frame.frameMicros = InputFrame::toMicros(deltaTime);
+
+    const int keys[][2] = {
+        { KEY_FORWARD, GLFW_KEY_W }, { KEY_BACKWARD, GLFW_KEY_S }, { KEY_LEFT, GLFW_KEY_A }, { KEY_RIGHT, GLFW_KEY_D },
+        { KEY_NOCLIP, GLFW_KEY_N }, { KEY_SPAWN_MOBS, GLFW_KEY_M },
+        { KEY_DEBUG_UI, GLFW_KEY_F3 }, { KEY_SAVE_PROFILE, GLFW_KEY_F4 }, { KEY_QUIT, GLFW_KEY_ESCAPE },
+    };
+    for (const auto& [key, glfwKey] : keys)
+        if (glfwGetKey(window, glfwKey) == GLFW_PRESS) frame.press((InputKey)key);
+    for (int number = 1; number <= 9; number++)
+        if (glfwGetKey(window, GLFW_KEY_0 + number) == GLFW_PRESS) frame.press((InputKey)(KEY_BLOCK_1 + number - 1));
+
+    // I clic sopra l'interfaccia di ImGui non arrivano al gioco
+    if (!ImGui::GetIO().WantCaptureMouse) {
+        if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS)  frame.press(KEY_BREAK);
+        if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_RIGHT) == GLFW_PRESS) frame.press(KEY_PLACE);
+    }
+    return frame;
 }
 
-void processInput(GLFWwindow* window) {
-    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
-        glfwSetWindowShouldClose(window, true);
-
-    // Edge detection per F3: toglia solo quando il tasto viene premuto,
-    // non continuamente mentre è tenuto giù
-    bool f3IsPressed = glfwGetKey(window, GLFW_KEY_F3) == GLFW_PRESS;
-    if (f3IsPressed && !f3WasPressed)
-        debugUI.toggleVisible();
-    f3WasPressed = f3IsPressed;
-
-    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
-        camera.processKeyboard(FORWARD,  deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
-        camera.processKeyboard(BACKWARD, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
-        camera.processKeyboard(LEFT,     deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
-        camera.processKeyboard(RIGHT,    deltaTime);
+// Passa i chunk modificati dall'ultimo salvataggio ai worker, che li comprimono e scrivono
+void saveDirtyChunks(World& world, WorldStorage& storage) {
+    static std::vector<ChunkPos> dirtyChunks;
+    world.takeDirtyChunks(dirtyChunks);
+    for (const ChunkPos& pos : dirtyChunks)
+        if (const Chunk* chunk = world.getChunk(pos)) storage.saveChunkAsync(pos, *chunk);
 }
 
-int main() {
+// ---------------------------------------------------------------
+// Crea la finestra con il contesto OpenGL più recente disponibile:
+// dalla 4.3 il ChunkRenderer disegna tutto con una draw call
+// (multi-draw indirect), altrimenti si accontenta della 3.3.
+// VOXEL_FORCE_GL33=1 forza la 3.3, per provare la strada di riserva.
+// ---------------------------------------------------------------
+GLFWwindow* createWindow() {
+    const int versions[][2] = { { 4, 6 }, { 4, 5 }, { 4, 4 }, { 4, 3 }, { 3, 3 } };
+    bool forceFallback = std::getenv("VOXEL_FORCE_GL33") != nullptr;
+
+    for (const auto& version : versions) {
+        if (forceFallback && version[0] > 3) continue;
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, version[0]);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, version[1]);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+        GLFWwindow* window = glfwCreateWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Voxel Engine", nullptr, nullptr);
+        if (window) {
+            std::cout << "OpenGL " << version[0] << "." << version[1] << " core\n";
+            return window;
+        }
+    }
+    return nullptr;
+}
+
+// ---------------------------------------------------------------
+// Registrare e rigiocare una partita
+// --record FILE salva l'input di ogni frame giocato (vedi
+// input_recording.h), --replay FILE lo rigioca al posto di tastiera e
+// mouse e chiude la finestra all'ultimo frame; --csv FILE salva tempi
+// e contatori di ogni frame. In entrambi i casi il mondo viene solo
+// dal seed (niente salvataggi, né letti né scritti) e la simulazione
+// gira sul render thread con il tempo dei frame registrati: la stessa
+// registrazione dà la stessa partita, e la stessa partita si può
+// rigiocare anche senza finestra con voxel_replay.
+// ---------------------------------------------------------------
+struct SessionOptions {
+    std::string record, replay, csv;
+
+    bool active() const { return !record.empty() || !replay.empty(); }
+};
+
+bool parseSessionOptions(int argc, char** argv, SessionOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--record") == 0 && hasValue)      options.record = argv[++i];
+        else if (std::strcmp(argv[i], "--replay") == 0 && hasValue) options.replay = argv[++i];
+        else if (std::strcmp(argv[i], "--csv") == 0 && hasValue)    options.csv = argv[++i];
+        else return false;
+    }
+    return options.record.empty() || options.replay.empty();
+}
+
+int main(int argc, char** argv) {
+    SessionOptions session;
+    if (!parseSessionOptions(argc, argv, session)) {
+        std::cerr << "usage: " << argv[0] << " [--record FILE | --replay FILE] [--csv FILE]\n";
+        return 2;
+    }
+
     if (!glfwInit()) return -1;
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
-    GLFWwindow* window = glfwCreateWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Voxel Engine", nullptr, nullptr);
+    GLFWwindow* window = createWindow();
     if (!window) { glfwTerminate(); return -1; }
     glfwMakeContextCurrent(window);
 
@@ -111,100 +215,517 @@ int main() {
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) return -1;
     glEnable(GL_DEPTH_TEST);
 
+    // Le facce delle mesh sono in senso antiorario viste da fuori:
+    // quelle girate dall'altra parte non si vedono mai, la GPU le scarta
+    glEnable(GL_CULL_FACE);
+
     // Inizializza il debug UI dopo aver creato il contesto OpenGL
     debugUI.init(window);
 
-    Shader shader(vertexShaderSource, fragmentShaderSource);
-
-    float vertices[] = {
-        -0.5f, -0.5f,  0.5f,
-         0.5f, -0.5f,  0.5f,
-         0.5f,  0.5f,  0.5f,
-        -0.5f,  0.5f,  0.5f,
-        -0.5f, -0.5f, -0.5f,
-         0.5f, -0.5f, -0.5f,
-         0.5f,  0.5f, -0.5f,
-        -0.5f,  0.5f, -0.5f
-    };
-    unsigned int indices[] = {
-        0, 1, 2,  2, 3, 0,
-        5, 4, 7,  7, 6, 5,
-        4, 0, 3,  3, 7, 4,
-        1, 5, 6,  6, 2, 1,
-        3, 2, 6,  6, 7, 3,
-        4, 5, 1,  1, 0, 4
+    // Subito un frame con la schermata di caricamento: la finestra non
+    // resta nera mentre si prepara il resto
+    StartupStats      startup;
+    LoadingScreenInfo loading;
+    auto showLoadingScreen = [&] {
+        loading.seconds = (float)secondsSinceStart();
+        glClearColor(0.1f, 0.1f, 0.12f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        debugUI.drawLoadingScreen(loading);
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+        if (startup.firstFrame == 0.0) startup.firstFrame = secondsSinceStart();
     };
+    showLoadingScreen();
+
+    // Da qui in poi nascono gli oggetti OpenGL (shader, texture, buffer,
+    // renderer): vivono in questo blocco, così i distruttori girano
+    // mentre il contesto esiste ancora, prima di glfwTerminate()
+    {
+        // Sorgenti degli shader, immagini dei blocchi con le mipmap e tabella
+        // dei materiali si preparano sui worker, in parallelo tra loro e con
+        // il terreno che intanto si genera. Sulla GPU vanno appena sono
+        // pronti tutti (nel game loop): fino ad allora shader e texture non
+        // esistono e si disegna solo la schermata di caricamento.
+        //
+        // I tipi di blocco si registrano prima: worker e simulazione leggono
+        // le tabelle delle proprietà senza lock.
+        if (std::filesystem::exists(BLOCK_DEFINITIONS_FILE)) {
+            int registered = loadBlockDefinitions(BLOCK_DEFINITIONS_FILE);
+            std::cout << registered << " block types from " << BLOCK_DEFINITIONS_FILE << "\n";
+        }
 
-    unsigned int VAO, VBO, EBO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glBindVertexArray(0);
-
-    std::vector<glm::vec3> cubePositions;
-    for (int x = -2; x <= 2; x++)
-        for (int z = -2; z <= 2; z++)
-            cubePositions.push_back(glm::vec3((float)x, 0.0f, (float)z));
-
-    // --- Game loop ---
-    while (!glfwWindowShouldClose(window)) {
-        float currentFrame = (float)glfwGetTime();
-        deltaTime = currentFrame - lastFrame;
-        lastFrame = currentFrame;
-
-        processInput(window);
-
-        glClearColor(0.53f, 0.81f, 0.98f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        // Un mondo salvato con altri tipi di blocco non si apre: i suoi
+        // BlockID vorrebbero dire altri blocchi (vedi WorldStorage)
+        if (!session.active() && !syncBlockTable(WORLD_DIRECTORY + "/" + WorldStorage::BLOCK_TABLE_FILE)) {
+            std::cerr << "Rimetti " << BLOCK_DEFINITIONS_FILE << " com'era quando il mondo è stato salvato\n";
+            glfwTerminate();
+            return 1;
+        }
 
-        // ImGui: inizia il frame PRIMA di disegnare qualsiasi cosa
-        debugUI.beginFrame();
-
-        shader.use();
-
-        glm::mat4 view = camera.getViewMatrix();
-        glm::mat4 projection = glm::perspective(
-            glm::radians(camera.fov),
-            (float)SCREEN_WIDTH / (float)SCREEN_HEIGHT,
-            0.1f, 100.0f
-        );
-        shader.setMat4("view",       glm::value_ptr(view));
-        shader.setMat4("projection", glm::value_ptr(projection));
-
-        glBindVertexArray(VAO);
-        for (const auto& pos : cubePositions) {
-            glm::mat4 model = glm::mat4(1.0f);
-            model = glm::translate(model, pos);
-            shader.setMat4("model", glm::value_ptr(model));
-            glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
+        // La partita da rigiocare dice seed, spawn e camera di partenza
+        InputRecording recording;
+        size_t replayFrame = 0;
+        if (!session.replay.empty()) {
+            if (!loadInputRecording(session.replay, recording) || recording.frames.empty()) {
+                std::cerr << "Nessun frame da rigiocare in " << session.replay << "\n";
+                glfwTerminate();
+                return 2;
+            }
+            if (!checkBlockTypes(recording)) {
+                glfwTerminate();
+                return 2;
+            }
+            std::cout << "Rigioco " << recording.frames.size() << " frame (" << recording.seconds() << " s)\n";
+        }
+        JobSystem         jobs;
+        std::string       chunkVertexSource, chunkFragmentSource, instanceVertexSource;
+        TextureArrayImage blockImages;
+        MaterialUniforms  materials;
+        AssetLoader       assets(jobs);
+        assets.add("chunk.vert", [&chunkVertexSource] {
+            return readTextFile(VOXEL_SHADER_DIR "/chunk.vert", chunkVertexSource);
+        });
+        assets.add("chunk.frag", [&chunkFragmentSource] {
+            return readTextFile(VOXEL_SHADER_DIR "/chunk.frag", chunkFragmentSource);
+        });
+        assets.add("instance.vert", [&instanceVertexSource] {
+            return readTextFile(VOXEL_SHADER_DIR "/instance.vert", instanceVertexSource);
+        });
+        assets.add("block textures", [&blockImages] { blockImages = generateBlockTextures(); return true; });
+        assets.add("materials", [&materials] { materials = buildMaterialUniforms(); return true; });
+
+        // I binari degli shader valgono solo per questo driver
+        std::string driver = std::string((const char*)glGetString(GL_VENDOR)) + " | "
+                           + (const char*)glGetString(GL_RENDERER) + " | " + (const char*)glGetString(GL_VERSION);
+        ProgramCache programCache(SHADER_CACHE_DIRECTORY, driver);
+
+        std::optional<Shader> shader, instanceShader;
+        UniformHandle<float>  fogDistance, instanceFogDistance;
+        UniformHandle<int>    blockTextures, instanceBlockTextures;
+
+        // View e projection vanno in un uniform buffer condiviso: un solo
+        // aggiornamento per frame vale per tutti gli shader
+        UniformBuffer cameraUniforms(sizeof(CameraUniforms), CAMERA_UNIFORM_BINDING);
+        float lastShaderCheck = 0.0f;
+
+        // Immagini dei blocchi e tabella dei materiali: non cambiano più,
+        // restano legate alla texture unit e al binding point per tutta la partita
+        std::optional<TextureArray> blockTextureArray;
+        UniformBuffer materialUniforms(sizeof(MaterialUniforms), MATERIAL_UNIFORM_BINDING);
+        const int BLOCK_TEXTURE_UNIT = 0;
+
+        // Render thread, appena i worker hanno finito: la parte che vuole
+        // il contesto OpenGL. Gli shader già visti arrivano dalla cache.
+        auto uploadAssets = [&] {
+            shader.emplace(Shader::fromSources(VOXEL_SHADER_DIR "/chunk.vert", VOXEL_SHADER_DIR "/chunk.frag",
+                                               chunkVertexSource, chunkFragmentSource, &programCache));
+            shader->bindUniformBlock("Camera", CAMERA_UNIFORM_BINDING);
+            shader->bindUniformBlock("Materials", MATERIAL_UNIFORM_BINDING);
+            fogDistance   = shader->uniform<float>("fogDistance");
+            blockTextures = shader->uniform<int>("blockTextures");
+
+            // Gli oggetti istanziati usano lo stesso fragment shader dei chunk
+            instanceShader.emplace(Shader::fromSources(VOXEL_SHADER_DIR "/instance.vert", VOXEL_SHADER_DIR "/chunk.frag",
+                                                       instanceVertexSource, chunkFragmentSource, &programCache));
+            instanceShader->bindUniformBlock("Camera", CAMERA_UNIFORM_BINDING);
+            instanceShader->bindUniformBlock("Materials", MATERIAL_UNIFORM_BINDING);
+            instanceFogDistance   = instanceShader->uniform<float>("fogDistance");
+            instanceBlockTextures = instanceShader->uniform<int>("blockTextures");
+
+            blockTextureArray.emplace(blockImages);
+            blockTextureArray->bind(BLOCK_TEXTURE_UNIT);
+            materialUniforms.update(materials);
+            blockImages = {}; // la copia sulla CPU non serve più
+        };
+
+        // Il mondo viene generato e meshato in background dai worker, già
+        // durante il caricamento: i chunk compaiono man mano.
+        // I chunk già salvati si caricano dal disco invece di rigenerarli;
+        // quelli nuovi vengono salvati subito dal worker che li ha generati.
+        // Registrando o rigiocando il disco non si usa: niente storage,
+        // e la cartella dei salvataggi non viene nemmeno creata.
+        World            world;
+        std::optional<WorldStorage> storage;
+        if (!session.active()) storage.emplace(jobs, WORLD_DIRECTORY);
+        TerrainGenerator terrain(session.replay.empty() ? WORLD_SEED : recording.seed);
+        ChunkPipeline    pipeline(jobs, world, [&terrain, &storage](const ChunkPos& pos, Chunk& chunk) {
+            if (storage && storage->loadChunk(pos, chunk)) return;
+            terrain.generate(pos, chunk);
+            if (storage) storage->saveChunk(pos, chunk);
+        });
+        ChunkRenderer    chunkRenderer;
+        ChunkCuller      culler;
+        std::vector<ChunkPos> visibleChunks;
+
+        // Luce del cielo e dei blocchi: si calcola quando un chunk entra nel
+        // mondo e si aggiorna ad ogni modifica, prima del meshing
+        LightEngine light(world);
+        pipeline.setInsertedCallback([&light](const ChunkPos& pos) { light.onChunkLoaded(pos); });
+        std::vector<ChunkPos> staleMeshes;
+
+        // Oltre i chunk il terreno si disegna con i nodi LOD, campionati
+        // dal generatore sempre più radi allontanandosi dalla camera
+        LodManager lod(jobs, terrain, { LOD_LEVELS, RENDER_DISTANCE });
+        LodManager::ChunkMeshedFn chunkMeshed = [&pipeline](const ChunkPos& pos) { return pipeline.isMeshed(pos); };
+        std::vector<LodNode> visibleLodNodes;
+        std::vector<LodNode> removedLodNodes;
+
+        // Lo streamer chiede i chunk attorno alla camera (e dove sta andando)
+        // e scarica quelli lontani quando si supera il budget di memoria;
+        // i chunk modificati si salvano prima di toglierli dal mondo
+        ChunkStreamer streamer(world, pipeline, STREAMING);
+        streamer.setUnloadCallback([&world, &storage](const ChunkPos& pos, const Chunk& chunk) {
+            if (storage && world.isDirty(pos)) storage->saveChunkAsync(pos, chunk);
+        });
+        std::vector<ChunkPos> evictedMeshes;
+
+        // Frammenti dei blocchi rotti, disegnati come istanze di un cubo
+        InstanceRenderer instanceRenderer;
+        std::vector<InstanceData> instances;
+
+        // Partiamo poco sopra il terreno (o sopra il mare)
+        int spawnHeight = std::max(terrain.surfaceHeight(0, 0), TerrainGenerator::SEA_LEVEL);
+        camera.position = glm::vec3(0.5f, (float)spawnHeight + 3.0f, 0.5f);
+        if (!session.replay.empty()) {
+            camera = Camera(recording.spawn, recording.yaw, recording.pitch);
+            camera.fov = recording.fov;
+        }
+        std::cout << "Noise backend: " << noiseBackendName(terrain.backend()) << "\n";
+
+        // Giocatore e frammenti avanzano a passi fissi sul thread della
+        // simulazione; qui si disegna l'ultimo snapshot, interpolato tra
+        // gli ultimi due tick. Il mondo lo toccano entrambi i thread:
+        // il tick lo tiene bloccato con worldMutex, il render thread lo
+        // prova soltanto (un tick pesante non deve fermare il frame).
+        // Il thread parte solo a caricamento finito (vedi il game loop).
+        //
+        // Registrando o rigiocando invece la simulazione la fa avanzare il
+        // render thread (stepper), con il tempo dei frame registrati.
+        std::mutex       worldMutex;
+        Simulation       simulation(world, light, camera.position,
+                                    session.replay.empty() ? SIMULATION_TICK_RATE : recording.tickRate, &jobs);
+        std::optional<SimulationThread>  simulationThread;
+        std::optional<SimulationStepper> stepper;
+        InputMapper      mapper;
+        FrameLog         frameLog;
+        ReplayFrame      frameStats;
+        float streamingDelta = 0.0f; // tempo dall'ultimo streamer.update
+        WorldDebugInfo worldInfo;
+
+        // Le colonne attorno allo spawn che devono avere la mesh prima di giocare
+        const int spawnColumnX = (int)std::floor(camera.position.x / CHUNK_SIZE);
+        const int spawnColumnZ = (int)std::floor(camera.position.z / CHUNK_SIZE);
+        loading.columnsTotal = (2 * SPAWN_READY_RADIUS + 1) * (2 * SPAWN_READY_RADIUS + 1);
+
+#if VOXEL_PROFILING
+        // Tempi GPU delle zone di rendering, per il pannello F3
+        GpuProfiler gpuProfiler;
+#endif
+        PROFILE_THREAD("Main");
+
+        // Prima di un tick dello stepper il mondo attorno al giocatore deve
+        // esserci tutto: intanto si raccoglie solo il lavoro dei worker
+        auto waitForArea = [&](const glm::vec3& eye) {
+            if (isSimulationAreaLoaded(world, eye)) return;
+            PROFILE_SCOPE("Wait for chunks");
+            auto start = std::chrono::steady_clock::now();
+            while (!isSimulationAreaLoaded(world, eye)) {
+                streamer.update(camera.position, 0.0f, detailColumns(lod.selection()));
+                std::this_thread::yield();
+            }
+            frameStats.waitMs += std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        };
+
+        // --- Game loop ---
+        while (!glfwWindowShouldClose(window)) {
+            PROFILE_FRAME();
+            PROFILE_GPU_FRAME(gpuProfiler);
+            PROFILE_SCOPE("Frame");
+            // I temporanei del frame prima sono tutti morti: l'arena riparte da zero
+            frameArena().reset();
+
+            auto  frameStart   = std::chrono::steady_clock::now();
+            float currentFrame = (float)glfwGetTime();
+            deltaTime = currentFrame - lastFrame;
+            lastFrame = currentFrame;
+            frameStats = {};
+
+            // I comandi vanno al prossimo tick; la camera si mette dove la
+            // simulazione sarà tra i due ultimi tick, in proporzione al tempo
+            // trascorso (la posizione segue i tick, l'orientamento il mouse)
+            const SimSnapshot* snapshot = nullptr;
+            float alpha = 1.0f;
+            if (simulationThread || stepper) {
+                PROFILE_SCOPE("Input");
+                InputFrame input = processInput(window, deltaTime);
+                if (!session.replay.empty()) {
+                    // Esc dal vivo interrompe comunque; il resto viene dal file
+                    if (input.held(KEY_QUIT)) glfwSetWindowShouldClose(window, true);
+                    input = recording.frames[replayFrame++];
+                    if (replayFrame == recording.frames.size()) glfwSetWindowShouldClose(window, true);
+                } else if (!session.record.empty()) {
+                    recording.frames.push_back(input);
+                }
+                if (stepper) deltaTime = input.deltaTime();
+
+                PlayerInput commands = mapper.apply(input, camera);
+                if (mapper.held(KEY_QUIT)) glfwSetWindowShouldClose(window, true);
+                if (mapper.pressed(KEY_DEBUG_UI)) debugUI.toggleVisible();
+
+                // F4 salva gli ultimi secondi di profilazione come trace di Chrome
+                if (mapper.pressed(KEY_SAVE_PROFILE) && VOXEL_PROFILING) {
+                    if (Profiler::writeChromeTrace("profile_trace.json"))
+                        std::cout << "Profile saved to profile_trace.json\n";
+                }
+
+                if (stepper) {
+                    frameStats.ticks = stepper->advance(commands, input.deltaTime(), waitForArea);
+                    snapshot = &stepper->snapshot();
+                    alpha    = stepper->alpha();
+                } else {
+                    simulationThread->submit(commands);
+                    snapshot = simulationThread->latest();
+                    if (snapshot) alpha = simulationThread->alpha(*snapshot, std::chrono::steady_clock::now());
+                }
+                if (snapshot) camera.position = snapshot->eyeAt(alpha);
+            }
+
+            // Due volte al secondo controlliamo se i file degli shader sono cambiati
+            if (shader && currentFrame - lastShaderCheck > 0.5f) {
+                shader->reloadIfChanged();
+                instanceShader->reloadIfChanged();
+                lastShaderCheck = currentFrame;
+            }
+
+            // Prima i LOD: la loro selezione dice anche quali chunk servono
+            lod.update(camera.position, chunkMeshed);
+
+            // Chiede i chunk che servono, scarica quelli di troppo e
+            // raccoglie il lavoro finito dai worker, entro il budget del frame.
+            // I chunk con blocchi o luce cambiati in questo frame (modifiche,
+            // chunk nuovi accanto) si rimeshano una volta sola, in background:
+            // finché la mesh nuova non arriva resta disegnata quella vecchia.
+            // I chunk modificati si salvano in background. Tutto questo tocca
+            // il mondo: se un tick lo sta usando si rimanda al frame dopo.
+            streamingDelta += deltaTime;
+            if (std::unique_lock worldLock{ worldMutex, std::try_to_lock }) {
+                streamer.update(camera.position, streamingDelta, detailColumns(lod.selection()));
+                streamingDelta = 0.0f;
+                world.takeMeshDirtyChunks(staleMeshes);
+                for (const ChunkPos& pos : staleMeshes) pipeline.requestMesh(pos);
+                if (storage) {
+                    PROFILE_SCOPE("Save dirty chunks");
+                    saveDirtyChunks(world, *storage);
+                }
+                worldInfo.loadedChunks = world.chunkCount();
+                worldInfo.totalBlocks  = world.blockCount();
+            }
+            {
+                PROFILE_SCOPE("Mesh upload");
+                PROFILE_GPU_SCOPE(gpuProfiler, "Mesh upload");
+                frameStats.meshUploads = streamer.uploadMeshes([&](const ChunkPos& pos, const ChunkMesh& mesh) {
+                    chunkRenderer.upload(pos, mesh);
+                    culler.setChunk(pos, mesh.visibility, !mesh.empty());
+                }, MAX_UPLOADS_PER_FRAME);
+
+                streamer.takeEvictedMeshes(evictedMeshes);
+                for (const ChunkPos& pos : evictedMeshes) {
+                    chunkRenderer.remove(pos);
+                    culler.removeChunk(pos);
+                }
+
+                lod.consumeMeshes([&](const LodNode& node, const ChunkMesh& mesh) {
+                    chunkRenderer.upload(node, mesh);
+                }, MAX_LOD_UPLOADS_PER_FRAME);
+                lod.takeRemoved(removedLodNodes);
+                for (const LodNode& node : removedLodNodes) chunkRenderer.remove(node);
+            }
+
+            // --- Caricamento ---
+            // Finché shader, texture e terreno attorno allo spawn non sono
+            // pronti si disegna solo la schermata di caricamento. Poi parte
+            // la simulazione e da qui in giù è il frame normale.
+            if (!simulationThread && !stepper) {
+                if (!loading.gpuReady && assets.done()) {
+                    uploadAssets();
+                    loading.gpuReady    = true;
+                    startup.assetsReady = secondsSinceStart();
+                    std::cout << "Assets: " << assets.total() << " tasks in " << assets.seconds() * 1000.0
+                              << " ms on " << jobs.workerCount() << " workers\n";
+                }
+                loading.assetsDone  = assets.finished();
+                loading.assetsTotal = assets.total();
+                loading.columnsDone = 0;
+                for (int dz = -SPAWN_READY_RADIUS; dz <= SPAWN_READY_RADIUS; dz++)
+                    for (int dx = -SPAWN_READY_RADIUS; dx <= SPAWN_READY_RADIUS; dx++)
+                        loading.columnsDone += pipeline.isColumnMeshed(spawnColumnX + dx, spawnColumnZ + dz);
+
+                if (loading.gpuReady && loading.columnsDone == loading.columnsTotal) {
+                    startup.playable         = secondsSinceStart();
+                    startup.shadersFromCache = programCache.hits();
+                    startup.shadersCompiled  = programCache.misses();
+                    worldInfo.startup        = startup;
+                    std::cout << "Startup: first frame " << startup.firstFrame * 1000.0 << " ms, assets "
+                              << startup.assetsReady << " s, playable " << startup.playable << " s (shaders: "
+                              << startup.shadersFromCache << " from cache, " << startup.shadersCompiled << " compiled)\n";
+                    // Il mouse mosso durante il caricamento non conta
+                    liveInput = {};
+                    if (session.active()) {
+                        stepper.emplace(simulation);
+                        if (!session.record.empty()) {
+                            recording.seed       = WORLD_SEED;
+                            recording.tickRate   = SIMULATION_TICK_RATE;
+                            recording.spawn      = camera.position;
+                            recording.yaw        = camera.yaw;
+                            recording.pitch      = camera.pitch;
+                            recording.fov        = camera.fov;
+                            recording.blockRegistry = blockRegistryHash();
+                        }
+                    } else {
+                        simulationThread.emplace(simulation, worldMutex);
+                    }
+                }
+
+                if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+                    glfwSetWindowShouldClose(window, true);
+                showLoadingScreen();
+                continue;
+            }
+
+            glClearColor(0.53f, 0.81f, 0.98f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            // ImGui: inizia il frame PRIMA di disegnare qualsiasi cosa
+            debugUI.beginFrame();
+
+            shader->use();
+
+            // Il piano lontano arriva agli angoli dell'ultimo livello LOD;
+            // la nebbia sfuma il terreno prima del bordo
+            float viewDistance = lod.selection().viewDistance();
+            shader->set(fogDistance, viewDistance);
+            shader->set(blockTextures, BLOCK_TEXTURE_UNIT);
+
+            glm::mat4 view = camera.getViewMatrix();
+            glm::mat4 projection = glm::perspective(
+                glm::radians(camera.fov),
+                (float)SCREEN_WIDTH / (float)SCREEN_HEIGHT,
+                0.1f, viewDistance * 1.5f
+            );
+            CameraUniforms cameraData;
+            cameraData.view           = view;
+            cameraData.projection     = projection;
+            cameraData.cameraPosition = glm::vec4(camera.position, 1.0f);
+            cameraUniforms.update(cameraData);
+
+            // Solo i chunk nel frustum e non nascosti dal terreno,
+            // con una sola draw call dove c'è OpenGL 4.3. I chunk rimasti
+            // fuori dal livello 0 si disegnano finché un nodo LOD non li copre.
+            {
+                PROFILE_SCOPE("Cull");
+                Frustum frustum = Frustum::fromMatrix(projection * view);
+                culler.cull(frustum, camera.position, RENDER_DISTANCE + 2, visibleChunks);
+                std::erase_if(visibleChunks, [&lod](const ChunkPos& pos) { return lod.covers(pos); });
+                streamer.touch(visibleChunks);
+                lod.cull(frustum, visibleLodNodes);
+            }
+            {
+                PROFILE_SCOPE("Draw chunks");
+                PROFILE_GPU_SCOPE(gpuProfiler, "Chunks");
+                chunkRenderer.draw(visibleChunks, visibleLodNodes);
+            }
+
+            // Tutti gli oggetti in un colpo: una scrittura del buffer delle
+            // istanze e una draw call, qualunque sia il loro numero
+            {
+                PROFILE_SCOPE("Draw instances");
+                PROFILE_GPU_SCOPE(gpuProfiler, "Instances");
+                instances.clear();
+                if (snapshot) snapshot->interpolateInstances(alpha, instances);
+                instanceRenderer.upload(instances);
+
+                instanceShader->use();
+                instanceShader->set(instanceFogDistance, viewDistance);
+                instanceShader->set(instanceBlockTextures, BLOCK_TEXTURE_UNIT);
+                instanceRenderer.draw();
+            }
+
+            // ImGui: chiudi il frame DOPO aver disegnato tutto il resto
+            // passiamo i dati da mostrare nel pannello
+            worldInfo.meshedChunks  = chunkRenderer.chunkCount();
+            worldInfo.triangles     = chunkRenderer.triangleCount();
+            worldInfo.jobsInFlight  = pipeline.jobsInFlight();
+            worldInfo.workerThreads = jobs.workerCount();
+            worldInfo.culling       = culler.stats();
+            worldInfo.drawCalls     = chunkRenderer.drawCallCount();
+            worldInfo.gpuMeshBytes  = chunkRenderer.gpuBytesUsed();
+            worldInfo.gpuMeshCapacity = chunkRenderer.gpuBytesCapacity();
+            worldInfo.lod             = lod.stats();
+            worldInfo.lodVisible      = (int)visibleLodNodes.size();
+            worldInfo.instances       = instanceRenderer.instanceCount();
+            worldInfo.streaming       = streamer.stats();
+            worldInfo.simulation      = stepper ? stepper->stats() : simulationThread->stats();
+            worldInfo.memory          = memoryStats();
+            worldInfo.target          = snapshot ? snapshot->target : RayHit{};
+            worldInfo.placeBlock      = mapper.placeBlock();
+            worldInfo.noclip          = snapshot && snapshot->noclip;
+
+            {
+                PROFILE_SCOPE("Debug UI");
+                PROFILE_GPU_SCOPE(gpuProfiler, "Debug UI");
+                debugUI.endFrame(
+                    deltaTime,
+                    camera.position.x,
+                    camera.position.y,
+                    camera.position.z,
+                    worldInfo
+                );
+            }
+
+            {
+                // Con il vsync qui si aspetta lo schermo: è tempo "libero"
+                PROFILE_SCOPE("Swap buffers");
+                glfwSwapBuffers(window);
+                glfwPollEvents();
+            }
+
+            if (stepper) {
+                frameStats.frameMs       = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+                frameStats.loadedChunks  = worldInfo.loadedChunks;
+                frameStats.visibleChunks = (int)visibleChunks.size();
+                frameStats.lodNodes      = (int)visibleLodNodes.size();
+                frameStats.jobsInFlight  = worldInfo.jobsInFlight;
+                frameLog.add(frameStats);
+            }
         }
 
-        // ImGui: chiudi il frame DOPO aver disegnato tutto il resto
-        // passiamo i dati da mostrare nel pannello
-        debugUI.endFrame(
-            deltaTime,
-            camera.position.x,
-            camera.position.y,
-            camera.position.z,
-            (int)cubePositions.size()
-        );
+        // Le ultime modifiche vanno su disco prima di chiudere (dopo
+        // l'ultimo tick: la simulazione non deve più toccare il mondo)
+        if (simulationThread) simulationThread->stop();
+        if (storage) {
+            saveDirtyChunks(world, *storage);
+            storage->flush();
+        }
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        // La partita registrata finisce con il suo stato, per chi la rigioca
+        if (stepper) {
+            std::cout << frameLog.summary() << "\n";
+            if (!session.csv.empty() && frameLog.writeCsv(session.csv))
+                std::cout << "Tempi dei frame in " << session.csv << "\n";
+
+            if (!session.record.empty()) {
+                recording.finalState = simulation.stateHash();
+                if (saveInputRecording(session.record, recording))
+                    std::cout << "Registrati " << recording.frames.size() << " frame in " << session.record << "\n";
+            } else if (replayFrame == recording.frames.size() && recording.finalState != 0) {
+                bool same = recording.finalState == simulation.stateHash();
+                std::cout << "Stato finale " << (same ? "uguale a quello registrato" : "DIVERSO da quello registrato") << "\n";
+            }
+        }
     }
 
     // Cleanup nell'ordine inverso rispetto all'inizializzazione
     debugUI.shutdown();
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
-    glDeleteBuffers(1, &EBO);
     glfwTerminate();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,150 @@
+#include "mapped_file.h"
+
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Quanto spazio riservare oltre la fine del file: la memoria virtuale
+// è gratuita finché non la si tocca, e così rimappare è raro
+constexpr size_t MAP_RESERVE = 64u << 20; // 64 MB
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& path) {
+    close();
+    HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                                OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        std::cerr << "Impossibile aprire " << path << "\n";
+        return false;
+    }
+    file = handle;
+
+    LARGE_INTEGER size;
+    GetFileSizeEx(handle, &size);
+    fileSize = (size_t)size.QuadPart;
+    return fileSize == 0 || remap(fileSize);
+}
+
+void MappedFile::close() {
+    unmap();
+    if (file) CloseHandle((HANDLE)file);
+    file = nullptr;
+    fileSize = 0;
+}
+
+bool MappedFile::isOpen() const {
+    return file != nullptr;
+}
+
+bool MappedFile::write(size_t offset, const void* bytes, size_t count) {
+    OVERLAPPED overlapped = {};
+    overlapped.Offset     = (DWORD)(offset & 0xFFFFFFFFu);
+    overlapped.OffsetHigh = (DWORD)((uint64_t)offset >> 32);
+    DWORD written = 0;
+    if (!WriteFile((HANDLE)file, bytes, (DWORD)count, &written, &overlapped) || written != count) return false;
+
+    if (offset + count > fileSize) {
+        fileSize = offset + count;
+        // Su Windows la vista non può superare il file: rimappiamo tutto
+        if (fileSize > mappedSize) return remap(fileSize);
+    }
+    return true;
+}
+
+bool MappedFile::remap(size_t minimumSize) {
+    unmap();
+    mapping = CreateFileMappingA((HANDLE)file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) return false;
+    mapped = (uint8_t*)MapViewOfFile((HANDLE)mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!mapped) return false;
+    mappedSize = minimumSize;
+    return true;
+}
+
+void MappedFile::unmap() {
+    if (mapped) UnmapViewOfFile(mapped);
+    if (mapping) CloseHandle((HANDLE)mapping);
+    mapped     = nullptr;
+    mapping    = nullptr;
+    mappedSize = 0;
+}
+
+#else
+
+bool MappedFile::open(const std::string& path) {
+    close();
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        std::cerr << "Impossibile aprire " << path << "\n";
+        return false;
+    }
+
+    struct stat info;
+    fstat(fd, &info);
+    fileSize = (size_t)info.st_size;
+    return remap(fileSize);
+}
+
+void MappedFile::close() {
+    unmap();
+    if (fd >= 0) ::close(fd);
+    fd = -1;
+    fileSize = 0;
+}
+
+bool MappedFile::isOpen() const {
+    return fd >= 0;
+}
+
+bool MappedFile::write(size_t offset, const void* bytes, size_t count) {
+    const uint8_t* p = (const uint8_t*)bytes;
+    size_t done = 0;
+    while (done < count) {
+        ssize_t n = pwrite(fd, p + done, count - done, (off_t)(offset + done));
+        if (n <= 0) return false;
+        done += (size_t)n;
+    }
+
+    if (offset + count > fileSize) {
+        fileSize = offset + count;
+        if (fileSize > mappedSize) return remap(fileSize);
+    }
+    return true;
+}
+
+bool MappedFile::remap(size_t minimumSize) {
+    unmap();
+    // Le pagine oltre la fine del file non vanno lette (SIGBUS), ma
+    // diventano valide da sole quando il file cresce
+    size_t size = minimumSize + MAP_RESERVE;
+    void* address = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (address == MAP_FAILED) {
+        std::cerr << "mmap fallita\n";
+        return false;
+    }
+    mapped     = (uint8_t*)address;
+    mappedSize = size;
+    return true;
+}
+
+void MappedFile::unmap() {
+    if (mapped) munmap(mapped, mappedSize);
+    mapped     = nullptr;
+    mappedSize = 0;
+}
+
+#endif
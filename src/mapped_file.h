@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// ---------------------------------------------------------------
+// MappedFile
+// Un file mappato in memoria in sola lettura: data() punta
+// direttamente alle pagine del file nella page cache del sistema,
+// quindi leggere un pezzo del file non richiede read() né copie.
+// Le scritture passano invece da pwrite/WriteFile: la page cache è
+// la stessa, quindi la mappatura vede subito i dati nuovi.
+//
+// Su Linux/macOS la mappatura riserva più spazio del file, così il
+// file può crescere senza rimappare; su Windows si rimappa quando
+// il file supera la vista corrente.
+// ---------------------------------------------------------------
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Apre il file in lettura/scrittura, creandolo se non esiste
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const;
+
+    // Byte validi del file; data() può essere nullptr se il file è vuoto
+    const uint8_t* data() const { return mapped; }
+    size_t         size() const { return fileSize; }
+
+    // Scrive count byte a partire da offset, allungando il file se serve.
+    // Non è thread-safe: chi scrive deve escludere i lettori (la
+    // mappatura può cambiare indirizzo).
+    bool write(size_t offset, const void* bytes, size_t count);
+
+private:
+    bool remap(size_t minimumSize);
+    void unmap();
+
+#ifdef _WIN32
+    void* file    = nullptr; // HANDLE
+    void* mapping = nullptr; // HANDLE
+#else
+    int fd = -1;
+#endif
+    uint8_t* mapped     = nullptr;
+    size_t   mappedSize = 0; // byte riservati dalla mappatura (>= fileSize)
+    size_t   fileSize   = 0;
+};
@@ -0,0 +1,122 @@
+#include "material.h"
+
+#include <algorithm>
+
+// Tinta e luce propria di ogni layer. Le immagini hanno già i colori
+// giusti, quindi la tinta è bianca: serve per variarli senza rifare
+// la texture (per esempio l'erba di biomi diversi).
+MaterialUniforms buildMaterialUniforms() {
+    MaterialUniforms uniforms;
+    for (glm::vec4& material : uniforms.materials) material = glm::vec4(1.0f, 1.0f, 1.0f, 0.0f);
+    uniforms.materials[LAYER_LAMP].w = 1.0f;
+    uniforms.materials[LAYER_LAVA].w = 1.0f;
+    return uniforms;
+}
+
+// ---------------------------------------------------------------
+// Immagini procedurali: un colore base per layer, variato texel per
+// texel da un hash delle coordinate (sempre uguale tra un avvio e
+// l'altro) e con qualche dettaglio disegnato sopra.
+// ---------------------------------------------------------------
+namespace {
+
+uint32_t texelHash(int layer, int x, int y) {
+    uint32_t h = (uint32_t)layer * 374761393u + (uint32_t)x * 668265263u + (uint32_t)y * 2246822519u;
+    h = (h ^ (h >> 13)) * 1274126177u;
+    return h ^ (h >> 16);
+}
+
+// Rumore in -1..1
+float texelNoise(int layer, int x, int y) {
+    return (float)(texelHash(layer, x, y) & 0xFFFF) / 32767.5f - 1.0f;
+}
+
+glm::vec3 texelColor(int layer, int x, int y) {
+    float n = texelNoise(layer, x, y);
+    switch (layer) {
+    case LAYER_STONE: {
+        glm::vec3 c = glm::vec3(0.5f) * (1.0f + 0.12f * n);
+        // Qualche macchia più scura
+        return (texelHash(layer + 100, x / 2, y / 2) & 7) == 0 ? c * 0.75f : c;
+    }
+    case LAYER_DIRT:
+        return glm::vec3(0.45f, 0.3f, 0.2f) * (1.0f + 0.15f * n);
+    case LAYER_GRASS_TOP:
+        return glm::vec3(0.4f, 0.7f, 0.3f) * (1.0f + 0.15f * n);
+    case LAYER_GRASS_SIDE: {
+        // Terra con una frangia d'erba in alto, di altezza irregolare
+        int fringe = 3 + (int)(texelHash(layer, x, 0) % 3);
+        if (y < fringe) return glm::vec3(0.4f, 0.7f, 0.3f) * (1.0f + 0.15f * n);
+        return glm::vec3(0.45f, 0.3f, 0.2f) * (1.0f + 0.15f * n);
+    }
+    case LAYER_SAND:
+        return glm::vec3(0.85f, 0.8f, 0.55f) * (1.0f + 0.06f * n);
+    case LAYER_WATER: {
+        // Onde orizzontali
+        float wave = (y + (x / 4) % 2) % 4 == 0 ? 1.15f : 1.0f;
+        return glm::vec3(0.2f, 0.4f, 0.8f) * wave * (1.0f + 0.05f * n);
+    }
+    case LAYER_LAMP: {
+        // Vetro luminoso dentro una cornice scura
+        bool frame = x == 0 || y == 0 || x == TEXTURE_SIZE - 1 || y == TEXTURE_SIZE - 1;
+        return frame ? glm::vec3(0.35f, 0.3f, 0.25f) : glm::vec3(1.0f, 0.85f, 0.5f) * (1.0f + 0.08f * n);
+    }
+    case LAYER_LAVA: {
+        // Croste scure su un fondo arancio acceso
+        bool crust = (texelHash(layer + 100, x / 3, y / 3) & 3) == 0;
+        return crust ? glm::vec3(0.45f, 0.12f, 0.05f) : glm::vec3(1.0f, 0.45f, 0.1f) * (1.0f + 0.1f * n);
+    }
+    default:
+        return glm::vec3(1.0f, 0.0f, 1.0f); // layer sconosciuto: magenta, si nota subito
+    }
+}
+
+uint8_t toByte(float v) {
+    return (uint8_t)(std::clamp(v, 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+} // namespace
+
+TextureArrayImage generateBlockTextures() {
+    TextureArrayImage image;
+    image.size   = TEXTURE_SIZE;
+    image.layers = LAYER_COUNT;
+    image.levels.resize(TEXTURE_LEVELS);
+
+    std::vector<uint8_t>& base = image.levels[0];
+    base.resize((size_t)LAYER_COUNT * TEXTURE_SIZE * TEXTURE_SIZE * 4);
+    for (int layer = 0; layer < LAYER_COUNT; layer++)
+        for (int y = 0; y < TEXTURE_SIZE; y++)
+            for (int x = 0; x < TEXTURE_SIZE; x++) {
+                glm::vec3 c = texelColor(layer, x, y);
+                uint8_t* texel = &base[(((size_t)layer * TEXTURE_SIZE + y) * TEXTURE_SIZE + x) * 4];
+                texel[0] = toByte(c.x);
+                texel[1] = toByte(c.y);
+                texel[2] = toByte(c.z);
+                texel[3] = 255;
+            }
+
+    buildMipChain(image);
+    return image;
+}
+
+void buildMipChain(TextureArrayImage& image) {
+    for (size_t level = 1; level < image.levels.size(); level++) {
+        int source = image.levelSize((int)level - 1);
+        int size   = image.levelSize((int)level);
+        const std::vector<uint8_t>& above = image.levels[level - 1];
+        std::vector<uint8_t>& out = image.levels[level];
+        out.resize((size_t)image.layers * size * size * 4);
+
+        for (int layer = 0; layer < image.layers; layer++)
+            for (int y = 0; y < size; y++)
+                for (int x = 0; x < size; x++)
+                    for (int c = 0; c < 4; c++) {
+                        auto at = [&](int sx, int sy) {
+                            return (int)above[(((size_t)layer * source + sy) * source + sx) * 4 + c];
+                        };
+                        int sum = at(2 * x, 2 * y) + at(2 * x + 1, 2 * y) + at(2 * x, 2 * y + 1) + at(2 * x + 1, 2 * y + 1);
+                        out[(((size_t)layer * size + y) * size + x) * 4 + c] = (uint8_t)((sum + 2) / 4);
+                    }
+    }
+}
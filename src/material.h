@@ -0,0 +1,136 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "block.h"
+
+// ---------------------------------------------------------------
+// Materiali dei blocchi
+// Le immagini dei blocchi stanno tutte in una sola texture array
+// (GL_TEXTURE_2D_ARRAY): un layer per immagine, tutte 16x16. Ogni
+// vertice delle mesh porta già il layer della sua faccia (vedi
+// packed_vertex.h), quindi l'erba ha il prato sopra, la terra sotto
+// e il bordo verde sui lati senza cambiare texture tra una draw e
+// l'altra. Le immagini sono generate qui (rumore deterministico sui
+// colori base): il motore non ha file di asset da caricare.
+// ---------------------------------------------------------------
+enum TextureLayer : uint16_t {
+    LAYER_STONE = 0,
+    LAYER_DIRT,
+    LAYER_GRASS_TOP,
+    LAYER_GRASS_SIDE,
+    LAYER_SAND,
+    LAYER_WATER,
+    LAYER_LAMP,
+    LAYER_LAVA,
+
+    LAYER_COUNT // non è un layer: serve solo a contare quante immagini esistono
+};
+
+constexpr int TEXTURE_SIZE   = 16; // lato di ogni layer in texel
+constexpr int TEXTURE_LEVELS = 5;  // 16, 8, 4, 2, 1
+
+// Layer delle facce di un blocco: sopra (+Y), sotto (-Y) e i quattro lati
+struct BlockTextures {
+    uint16_t top;
+    uint16_t bottom;
+    uint16_t side;
+};
+
+inline constexpr BlockTextures BLOCK_TEXTURES[BLOCK_COUNT] = {
+    { LAYER_STONE,      LAYER_STONE, LAYER_STONE      }, // aria (mai disegnata)
+    { LAYER_STONE,      LAYER_STONE, LAYER_STONE      },
+    { LAYER_DIRT,       LAYER_DIRT,  LAYER_DIRT       },
+    { LAYER_GRASS_TOP,  LAYER_DIRT,  LAYER_GRASS_SIDE },
+    { LAYER_SAND,       LAYER_SAND,  LAYER_SAND       },
+    { LAYER_WATER,      LAYER_WATER, LAYER_WATER      },
+    { LAYER_LAMP,       LAYER_LAMP,  LAYER_LAMP       },
+    { LAYER_LAVA,       LAYER_LAVA,  LAYER_LAVA       },
+    // acqua che scorre, livelli 1..7
+    { LAYER_WATER,      LAYER_WATER, LAYER_WATER      },
+    { LAYER_WATER,      LAYER_WATER, LAYER_WATER      },
+    { LAYER_WATER,      LAYER_WATER, LAYER_WATER      },
+    { LAYER_WATER,      LAYER_WATER, LAYER_WATER      },
+    { LAYER_WATER,      LAYER_WATER, LAYER_WATER      },
+    { LAYER_WATER,      LAYER_WATER, LAYER_WATER      },
+    { LAYER_WATER,      LAYER_WATER, LAYER_WATER      },
+    // lava che scorre, livelli 1..7
+    { LAYER_LAVA,       LAYER_LAVA,  LAYER_LAVA       },
+    { LAYER_LAVA,       LAYER_LAVA,  LAYER_LAVA       },
+    { LAYER_LAVA,       LAYER_LAVA,  LAYER_LAVA       },
+    { LAYER_LAVA,       LAYER_LAVA,  LAYER_LAVA       },
+    { LAYER_LAVA,       LAYER_LAVA,  LAYER_LAVA       },
+    { LAYER_LAVA,       LAYER_LAVA,  LAYER_LAVA       },
+    { LAYER_LAVA,       LAYER_LAVA,  LAYER_LAVA       },
+};
+
+// Le facce di ogni BlockID, come le tabelle di block.h: quelli di
+// BlockType da BLOCK_TEXTURES, gli altri pietra finché registerBlock
+// non dice altro
+using BlockTextureTable = std::array<BlockTextures, MAX_BLOCK_TYPES>;
+
+constexpr BlockTextureTable makeBlockTextureTable() {
+    BlockTextureTable table{};
+    for (int id = 0; id < MAX_BLOCK_TYPES; id++) table[id] = BLOCK_TEXTURES[id < BLOCK_COUNT ? id : BLOCK_STONE];
+    return table;
+}
+
+inline constinit BlockTextureTable blockTextureTable = makeBlockTextureTable();
+
+inline const BlockTextures& blockTextures(BlockID id) {
+    return blockTextureTable[id & (MAX_BLOCK_TYPES - 1)];
+}
+
+// Layer da disegnare sulla faccia del blocco (face come BlockFace:
+// 2 = +Y, 3 = -Y, gli altri sono lati)
+inline uint16_t blockTextureLayer(BlockID id, int face) {
+    const BlockTextures& t = blockTextures(id);
+    return face == 2 ? t.top : face == 3 ? t.bottom : t.side;
+}
+
+static_assert(FLUID_LEVELS == 7, "BLOCK_TEXTURES ha una riga per ogni livello dei fluidi");
+
+// ---------------------------------------------------------------
+// Tabella dei materiali nell'uniform buffer, indicizzata dal layer:
+// rgb = tinta che moltiplica i texel, a = luce propria del materiale
+// (le lampade restano accese anche dove la luce calcolata è bassa).
+// Layout std140: un array di vec4 ha passo 16 byte, come in C++:
+//
+//   layout (std140) uniform Materials {
+//       vec4 materials[MAX_MATERIALS];
+//   };
+// ---------------------------------------------------------------
+constexpr int MAX_MATERIALS = 64;
+
+struct MaterialUniforms {
+    glm::vec4 materials[MAX_MATERIALS];
+};
+
+static_assert(sizeof(MaterialUniforms) == MAX_MATERIALS * 16, "MaterialUniforms deve seguire il layout std140");
+static_assert(LAYER_COUNT <= MAX_MATERIALS, "troppi layer per la tabella dei materiali");
+
+MaterialUniforms buildMaterialUniforms();
+
+// ---------------------------------------------------------------
+// Immagini della texture array, con tutta la catena di mipmap già
+// calcolata: levels[l] contiene tutti i layer del livello l uno dopo
+// l'altro, RGBA8, nell'ordine che vuole glTexImage3D.
+// ---------------------------------------------------------------
+struct TextureArrayImage {
+    int size   = 0; // lato del livello 0
+    int layers = 0;
+    std::vector<std::vector<uint8_t>> levels;
+
+    int levelSize(int level) const { return size >> level; }
+};
+
+// Genera i layer di LAYER_COUNT e la loro catena di mipmap
+TextureArrayImage generateBlockTextures();
+
+// Riempie i livelli dal secondo in poi: ogni texel è la media dei
+// 2x2 del livello sopra. Il livello 0 deve essere già presente.
+void buildMipChain(TextureArrayImage& image);
@@ -0,0 +1,266 @@
+#include "memory.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <mutex>
+
+// Dimensioni iniziali delle arene: bastano per un frame tipico, e
+// crescono da sole al reset() se un frame chiede di più
+static const size_t FRAME_ARENA_SIZE   = 1u << 20;
+static const size_t SCRATCH_ARENA_SIZE = 256u << 10;
+
+static const size_t SLAB_SIZE       = 64u << 10;
+static const size_t BLOCK_ALIGNMENT = 16;
+
+// ---------------------------------------------------------------
+// Contatori
+// ---------------------------------------------------------------
+namespace {
+
+struct TagCounters {
+    std::atomic<long long> allocations{ 0 };
+    std::atomic<long long> heapAllocations{ 0 };
+    std::atomic<long long> bytesInUse{ 0 };
+    std::atomic<long long> bytesReserved{ 0 };
+};
+
+TagCounters counters[(int)MemoryTag::Count];
+
+// I FixedPool vivi. Mai distrutto: i pool delle classi di dimensione
+// restano fino all'uscita, e qualcuno può chiedere le statistiche
+struct PoolRegistry {
+    std::mutex              mutex;
+    std::vector<FixedPool*> pools;
+};
+
+PoolRegistry& poolRegistry() {
+    static PoolRegistry* registry = new PoolRegistry();
+    return *registry;
+}
+
+} // namespace
+
+const char* memoryTagName(MemoryTag tag) {
+    switch (tag) {
+        case MemoryTag::Frame:    return "Frame arena";
+        case MemoryTag::Scratch:  return "Scratch arenas";
+        case MemoryTag::Chunks:   return "Chunks";
+        case MemoryTag::Palettes: return "Palettes";
+        case MemoryTag::Meshes:   return "Mesh buffers";
+        default:                  return "?";
+    }
+}
+
+void trackAllocations(MemoryTag tag, long long count, long long heapCount, long long bytes) {
+    TagCounters& c = counters[(int)tag];
+    if (count) c.allocations.fetch_add(count, std::memory_order_relaxed);
+    if (heapCount) c.heapAllocations.fetch_add(heapCount, std::memory_order_relaxed);
+    if (bytes) c.bytesInUse.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void trackFree(MemoryTag tag, long long bytes) {
+    counters[(int)tag].bytesInUse.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+void trackReserved(MemoryTag tag, long long bytes) {
+    counters[(int)tag].bytesReserved.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+MemoryStats memoryStats() {
+    MemoryStats stats;
+    for (int i = 0; i < (int)MemoryTag::Count; i++) {
+        stats.tags[i].allocations     = counters[i].allocations.load(std::memory_order_relaxed);
+        stats.tags[i].heapAllocations = counters[i].heapAllocations.load(std::memory_order_relaxed);
+        stats.tags[i].bytesInUse      = counters[i].bytesInUse.load(std::memory_order_relaxed);
+        stats.tags[i].bytesReserved   = counters[i].bytesReserved.load(std::memory_order_relaxed);
+    }
+
+    PoolRegistry& registry = poolRegistry();
+    std::lock_guard lock(registry.mutex);
+    for (FixedPool* pool : registry.pools) {
+        MemoryTagStats pooled = pool->stats();
+        MemoryTagStats& total = stats.tags[(int)pool->memoryTag()];
+        total.allocations     += pooled.allocations;
+        total.heapAllocations += pooled.heapAllocations;
+        total.bytesInUse      += pooled.bytesInUse;
+        total.bytesReserved   += pooled.bytesReserved;
+    }
+    return stats;
+}
+
+// ---------------------------------------------------------------
+// LinearArena
+// ---------------------------------------------------------------
+
+LinearArena::LinearArena(size_t capacity, MemoryTag tag)
+    : tag(tag)
+    , base(static_cast<std::byte*>(::operator new(capacity)))
+    , size(capacity)
+{
+    trackReserved(tag, (long long)capacity);
+    overflowBlocks.reserve(16);
+}
+
+LinearArena::~LinearArena() {
+    reset();
+    ::operator delete(base);
+    trackReserved(tag, -(long long)size);
+    trackAllocations(tag, 0, 0, -publishedBytes);
+}
+
+void* LinearArena::allocateOverflow(size_t bytes, size_t alignment) {
+    // Blocco pieno: all'heap fino a quando l'arena torna vuota
+    alignment = std::max(alignment, alignof(std::max_align_t));
+    void* p = ::operator new(bytes, std::align_val_t(alignment));
+    overflowBlocks.push_back({ p, bytes, alignment });
+    overflowBytes += bytes;
+    peak = std::max(peak, used + overflowBytes);
+    pendingAllocations++;
+    pendingHeap++;
+    return p;
+}
+
+void LinearArena::rewind(const Mark& to) {
+    while (overflowBlocks.size() > to.overflow) {
+        Overflow block = overflowBlocks.back();
+        overflowBlocks.pop_back();
+        ::operator delete(block.pointer, std::align_val_t(block.alignment));
+        overflowBytes -= block.size;
+    }
+    used = std::min(used, to.used);
+
+    // Vuota: se il picco non ci stava il blocco cresce (con margine),
+    // così le prossime volte si resta dentro
+    if (to.used == 0 && to.overflow == 0) {
+        if (peak > size) {
+            size_t newSize = std::bit_ceil(peak + peak / 2);
+            ::operator delete(base);
+            base = static_cast<std::byte*>(::operator new(newSize));
+            trackReserved(tag, (long long)newSize - (long long)size);
+            size = newSize;
+        }
+        peak = 0;
+    }
+
+    // I contatori globali si aggiornano qui e non ad ogni allocate()
+    long long inUse = (long long)(used + overflowBytes);
+    trackAllocations(tag, pendingAllocations, pendingHeap, inUse - publishedBytes);
+    publishedBytes     = inUse;
+    pendingAllocations = 0;
+    pendingHeap        = 0;
+}
+
+LinearArena& frameArena() {
+    static LinearArena arena(FRAME_ARENA_SIZE, MemoryTag::Frame);
+    return arena;
+}
+
+LinearArena& scratchArena() {
+    thread_local LinearArena arena(SCRATCH_ARENA_SIZE, MemoryTag::Scratch);
+    return arena;
+}
+
+// ---------------------------------------------------------------
+// FixedPool
+// ---------------------------------------------------------------
+
+FixedPool::FixedPool(size_t blockSize, MemoryTag tag)
+    : tag(tag)
+    , block(std::max((blockSize + BLOCK_ALIGNMENT - 1) & ~(BLOCK_ALIGNMENT - 1), sizeof(FreeBlock)))
+    , blocksPerSlab(std::max<size_t>(SLAB_SIZE / block, 4))
+{
+    PoolRegistry& registry = poolRegistry();
+    std::lock_guard lock(registry.mutex);
+    registry.pools.push_back(this);
+}
+
+FixedPool::~FixedPool() {
+    {
+        PoolRegistry& registry = poolRegistry();
+        std::lock_guard lock(registry.mutex);
+        std::erase(registry.pools, this);
+    }
+    for (void* slab : slabs) ::operator delete(slab, std::align_val_t(BLOCK_ALIGNMENT));
+}
+
+void* FixedPool::allocate() {
+    std::lock_guard lock(spin);
+    if (!freeList) {
+        // Uno slab nuovo, infilato tutto nella free list
+        std::byte* slab = static_cast<std::byte*>(::operator new(blocksPerSlab * block, std::align_val_t(BLOCK_ALIGNMENT)));
+        slabs.push_back(slab);
+        for (size_t i = blocksPerSlab; i-- > 0;) {
+            FreeBlock* free = reinterpret_cast<FreeBlock*>(slab + i * block);
+            free->next = freeList;
+            freeList = free;
+        }
+        heapAllocations++;
+    }
+    FreeBlock* result = freeList;
+    freeList = result->next;
+    allocations++;
+    blocksInUse++;
+    return result;
+}
+
+void FixedPool::deallocate(void* p) {
+    if (!p) return;
+    std::lock_guard lock(spin);
+    FreeBlock* free = static_cast<FreeBlock*>(p);
+    free->next = freeList;
+    freeList = free;
+    blocksInUse--;
+}
+
+MemoryTagStats FixedPool::stats() {
+    std::lock_guard lock(spin);
+    MemoryTagStats s;
+    s.allocations     = allocations;
+    s.heapAllocations = heapAllocations;
+    s.bytesInUse      = blocksInUse * (long long)block;
+    s.bytesReserved   = (long long)(slabs.size() * blocksPerSlab * block);
+    return s;
+}
+
+// ---------------------------------------------------------------
+// Pool a classi di dimensione
+// ---------------------------------------------------------------
+
+static const int POOL_CLASSES = 11; // 16 .. 16384 byte
+
+static int sizeClass(size_t bytes) {
+    // 16 → 0, 17..32 → 1, ... 16384 → 10
+    return (int)std::bit_width(std::max<size_t>(bytes, 16) - 1) - 4;
+}
+
+static FixedPool& classPool(MemoryTag tag, int sizeClassIndex) {
+    // Mai distrutti: un chunk può morire dopo i distruttori statici
+    // (es. in un thread che esce per ultimo), e il pool deve esserci
+    struct Pools {
+        FixedPool* pools[(int)MemoryTag::Count][POOL_CLASSES];
+        Pools() {
+            for (int t = 0; t < (int)MemoryTag::Count; t++)
+                for (int c = 0; c < POOL_CLASSES; c++) pools[t][c] = new FixedPool((size_t)16 << c, (MemoryTag)t);
+        }
+    };
+    static Pools* instance = new Pools();
+    return *instance->pools[(int)tag][sizeClassIndex];
+}
+
+void* poolAllocate(size_t bytes, MemoryTag tag) {
+    if (bytes > POOL_MAX_BLOCK) {
+        trackAllocation(tag, (long long)bytes, true);
+        return ::operator new(bytes);
+    }
+    return classPool(tag, sizeClass(bytes)).allocate();
+}
+
+void poolDeallocate(void* p, size_t bytes, MemoryTag tag) {
+    if (bytes > POOL_MAX_BLOCK) {
+        trackFree(tag, (long long)bytes);
+        ::operator delete(p);
+        return;
+    }
+    classPool(tag, sizeClass(bytes)).deallocate(p);
+}
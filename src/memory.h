@@ -0,0 +1,324 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+// ---------------------------------------------------------------
+// Memoria per i dati di breve durata o di dimensione fissa.
+// Tre strumenti, tutti con contatori per sottosistema (MemoryTag):
+//
+//  - LinearArena: un blocco da cui si alloca spostando un puntatore
+//    ("bump"), e che si libera tutto insieme. frameArena() la usa il
+//    render thread e il game loop la azzera ad ogni frame;
+//    scratchArena() ne dà una per thread (i worker ci mettono i
+//    temporanei di generazione e meshing).
+//  - FixedPool: blocchi tutti della stessa dimensione presi da "slab"
+//    grandi, con una free list. Niente heap dopo che gli slab sono
+//    bastati: li usano Chunk (operator new) e PoolAllocator, che dà
+//    a palette e dati dei chunk blocchi di 16, 32, ... 16384 byte.
+//  - ObjectPool: oggetti già costruiti da riusare (MeshInput,
+//    ChunkMesh): tornano nel pool con la capacità dei loro vector,
+//    così la mesh successiva non rialloca.
+//
+// Gli slab dei pool non tornano mai all'heap: la memoria riservata
+// resta al picco. memoryStats() dice quanta ne è in uso e quanta
+// riservata, e quante richieste sono dovute arrivare all'heap.
+// ---------------------------------------------------------------
+enum class MemoryTag : uint8_t {
+    Frame,    // frameArena del render thread
+    Scratch,  // scratchArena dei worker e degli altri thread
+    Chunks,   // oggetti Chunk e luce per voxel
+    Palettes, // palette, conteggi e indici impacchettati dei chunk
+    Meshes,   // MeshInput e ChunkMesh riciclati
+    Count
+};
+
+const char* memoryTagName(MemoryTag tag);
+
+struct MemoryTagStats {
+    long long allocations     = 0; // richieste servite dall'avvio
+    long long heapAllocations = 0; // di cui arrivate all'heap (slab, blocchi nuovi, oggetti nuovi)
+    long long bytesInUse      = 0;
+    long long bytesReserved   = 0; // presi dall'heap e tenuti (slab, blocchi delle arene)
+};
+
+struct MemoryStats {
+    MemoryTagStats tags[(int)MemoryTag::Count];
+
+    const MemoryTagStats& operator[](MemoryTag tag) const { return tags[(int)tag]; }
+};
+
+MemoryStats memoryStats();
+
+// Contatori globali (relaxed: sono statistiche, non sincronizzano
+// niente). Le arene li aggiornano a blocchi, quando tornano indietro;
+// i FixedPool tengono i loro sotto il proprio mutex e memoryStats() li somma.
+void trackAllocations(MemoryTag tag, long long count, long long heapCount, long long bytes);
+void trackFree(MemoryTag tag, long long bytes);
+void trackReserved(MemoryTag tag, long long bytes);
+
+inline void trackAllocation(MemoryTag tag, long long bytes, bool fromHeap) {
+    trackAllocations(tag, 1, fromHeap ? 1 : 0, bytes);
+}
+
+// ---------------------------------------------------------------
+// LinearArena
+// Un thread solo. allocate() sposta "used" in avanti; mark() e
+// rewind() tornano a un punto precedente (vedi ArenaScope), reset()
+// libera tutto. Se il blocco finisce le richieste vanno all'heap una
+// per una finché l'arena non torna vuota: allora il blocco si allarga
+// al picco visto, e dopo qualche frame non se ne esce più.
+// La memoria non si inizializza e i distruttori non si chiamano:
+// solo tipi banali, o vector con ArenaAllocator.
+// ---------------------------------------------------------------
+class LinearArena {
+public:
+    struct Mark {
+        size_t used     = 0;
+        size_t overflow = 0; // elementi di overflowBlocks
+    };
+
+    LinearArena(size_t capacity, MemoryTag tag);
+    ~LinearArena();
+
+    LinearArena(const LinearArena&) = delete;
+    LinearArena& operator=(const LinearArena&) = delete;
+
+    // Nell'header: la strada normale è un'addizione e un confronto
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t)) {
+        size_t start = (used + alignment - 1) & ~(alignment - 1);
+        if (start + bytes > size) return allocateOverflow(bytes, alignment);
+        used = start + bytes;
+        if (used + overflowBytes > peak) peak = used + overflowBytes;
+        pendingAllocations++;
+        return base + start;
+    }
+
+    // Se p è l'ultima allocazione la restituisce (un vector che cresce
+    // in cima all'arena riusa il suo spazio); altrimenti non fa niente
+    void deallocate(void* p, size_t bytes) {
+        if (static_cast<std::byte*>(p) + bytes == base + used) used = static_cast<size_t>(static_cast<std::byte*>(p) - base);
+    }
+
+    template <typename T>
+    T* allocateArray(size_t count) { return static_cast<T*>(allocate(count * sizeof(T), alignof(T))); }
+
+    Mark mark() const { return { used, overflowBlocks.size() }; }
+    void rewind(const Mark& to);
+    void reset() { rewind({}); }
+
+    size_t capacity() const { return size; }
+    size_t bytesUsed() const { return used + overflowBytes; }
+    size_t peakBytes() const { return peak; } // da quando l'arena era vuota
+
+private:
+    struct Overflow {
+        void*  pointer;
+        size_t size;
+        size_t alignment;
+    };
+
+    void* allocateOverflow(size_t bytes, size_t alignment);
+
+    MemoryTag tag;
+    std::byte* base = nullptr;
+    size_t size = 0;
+    size_t used = 0;
+    size_t peak = 0;
+    size_t overflowBytes = 0;
+    std::vector<Overflow> overflowBlocks;
+
+    // Non ancora passati ai contatori globali
+    long long pendingAllocations = 0;
+    long long pendingHeap        = 0;
+    long long publishedBytes     = 0;
+};
+
+// Render thread: azzerata dal game loop all'inizio di ogni frame
+LinearArena& frameArena();
+
+// Una per thread, per i temporanei di un job o di una chiamata
+LinearArena& scratchArena();
+
+// Torna al punto di partenza uscendo dallo scope: i temporanei di una
+// funzione si liberano anche se nessuno chiama reset()
+class ArenaScope {
+public:
+    explicit ArenaScope(LinearArena& arena) : arena(arena), start(arena.mark()) {}
+    ~ArenaScope() { arena.rewind(start); }
+
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+
+private:
+    LinearArena&      arena;
+    LinearArena::Mark start;
+};
+
+// Allocatore per std::vector dentro un'arena: deallocate restituisce
+// solo l'ultima allocazione, il resto torna con rewind o reset
+template <typename T>
+struct ArenaAllocator {
+    using value_type = T;
+
+    LinearArena* arena;
+
+    ArenaAllocator(LinearArena& arena) : arena(&arena) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+    T*   allocate(size_t n) { return arena->allocateArray<T>(n); }
+    void deallocate(T* p, size_t n) { arena->deallocate(p, n * sizeof(T)); }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+};
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+// ---------------------------------------------------------------
+// Lock per sezioni di poche istruzioni (una free list): uno scambio
+// atomico invece delle due operazioni di un std::mutex, e nessuna
+// chiamata al kernel. Si usa con std::lock_guard.
+// ---------------------------------------------------------------
+class SpinLock {
+public:
+    void lock() {
+        while (locked.exchange(true, std::memory_order_acquire))
+            while (locked.load(std::memory_order_relaxed)) std::this_thread::yield();
+    }
+    void unlock() { locked.store(false, std::memory_order_release); }
+
+private:
+    std::atomic<bool> locked{ false };
+};
+
+// ---------------------------------------------------------------
+// FixedPool
+// Blocchi di blockSize byte (allineati a 16) da slab di circa 64 KB.
+// Thread-safe: un chunk nasce su un worker e muore sul render thread.
+// ---------------------------------------------------------------
+class FixedPool {
+public:
+    FixedPool(size_t blockSize, MemoryTag tag);
+    ~FixedPool();
+
+    FixedPool(const FixedPool&) = delete;
+    FixedPool& operator=(const FixedPool&) = delete;
+
+    void* allocate();
+    void  deallocate(void* p);
+
+    size_t blockSize() const { return block; }
+
+    // Per memoryStats(): tutti i pool vivi sono in un registro
+    MemoryTag      memoryTag() const { return tag; }
+    MemoryTagStats stats();
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    MemoryTag  tag;
+    size_t     block;
+    size_t     blocksPerSlab;
+    SpinLock   spin;
+    FreeBlock* freeList = nullptr;
+    std::vector<void*> slabs;
+    long long  allocations     = 0;
+    long long  heapAllocations = 0;
+    long long  blocksInUse     = 0;
+};
+
+// Blocchi di 16, 32, ... POOL_MAX_BLOCK byte da FixedPool per tag;
+// le richieste più grandi vanno all'heap (e si contano come tali)
+constexpr size_t POOL_MAX_BLOCK = 16384;
+
+void* poolAllocate(size_t bytes, MemoryTag tag);
+void  poolDeallocate(void* p, size_t bytes, MemoryTag tag);
+
+template <typename T, MemoryTag Tag>
+struct PoolAllocator {
+    using value_type = T;
+
+    template <typename U>
+    struct rebind { using other = PoolAllocator<U, Tag>; };
+
+    PoolAllocator() = default;
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U, Tag>&) {}
+
+    T*   allocate(size_t n) { return static_cast<T*>(poolAllocate(n * sizeof(T), Tag)); }
+    void deallocate(T* p, size_t n) { poolDeallocate(p, n * sizeof(T), Tag); }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U, Tag>&) const { return true; }
+};
+
+template <typename T, MemoryTag Tag>
+using PoolVector = std::vector<T, PoolAllocator<T, Tag>>;
+
+// ---------------------------------------------------------------
+// ObjectPool
+// acquire() dà un oggetto già usato (svuotato da chi lo riprende) o
+// uno nuovo; il Ptr lo restituisce al pool quando muore, da qualsiasi
+// thread. Oltre maxFree oggetti liberi i restituiti si distruggono.
+// ---------------------------------------------------------------
+template <typename T>
+class ObjectPool {
+public:
+    struct Release {
+        ObjectPool* pool = nullptr;
+        void operator()(T* object) const { pool->release(object); }
+    };
+    using Ptr = std::unique_ptr<T, Release>;
+
+    ObjectPool(MemoryTag tag, size_t maxFree) : tag(tag), maxFree(maxFree) { free.reserve(maxFree); }
+
+    ~ObjectPool() {
+        for (T* object : free) delete object;
+    }
+
+    ObjectPool(const ObjectPool&) = delete;
+    ObjectPool& operator=(const ObjectPool&) = delete;
+
+    Ptr acquire() {
+        T* object = nullptr;
+        {
+            std::lock_guard lock(mutex);
+            if (!free.empty()) {
+                object = free.back();
+                free.pop_back();
+            }
+        }
+        trackAllocation(tag, sizeof(T), object == nullptr);
+        if (!object) object = new T();
+        return Ptr(object, Release{ this });
+    }
+
+private:
+    void release(T* object) {
+        trackFree(tag, sizeof(T));
+        {
+            std::lock_guard lock(mutex);
+            if (free.size() < maxFree) {
+                free.push_back(object);
+                return;
+            }
+        }
+        delete object;
+    }
+
+    MemoryTag       tag;
+    size_t          maxFree;
+    std::mutex      mutex;
+    std::vector<T*> free;
+};
@@ -0,0 +1,355 @@
+#include "mesher.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#include "material.h"
+
+// Quanti oggetti liberi tenere: più dei worker, e abbastanza per le
+// mesh che aspettano l'upload nella coda della pipeline
+static const size_t FREE_MESH_INPUTS = 32;
+static const size_t FREE_CHUNK_MESHES = 128;
+
+PooledMeshInput acquireMeshInput() {
+    // Mai distrutti: un job può restituire l'oggetto all'uscita
+    static ObjectPool<MeshInput>* pool = new ObjectPool<MeshInput>(MemoryTag::Meshes, FREE_MESH_INPUTS);
+    return pool->acquire();
+}
+
+PooledChunkMesh acquireChunkMesh() {
+    static ObjectPool<ChunkMesh>* pool = new ObjectPool<ChunkMesh>(MemoryTag::Meshes, FREE_CHUNK_MESHES);
+    return pool->acquire();
+}
+
+void MeshInput::gather(const World& world, const ChunkPos& pos) {
+    // Per ognuno dei 27 chunk (il centrale + 26 vicini) copiamo solo
+    // la parte che cade nel volume 18³: tutto il centrale, una faccia,
+    // uno spigolo o un singolo angolo dei vicini.
+    for (int dy = -1; dy <= 1; dy++)
+    for (int dz = -1; dz <= 1; dz++)
+    for (int dx = -1; dx <= 1; dx++) {
+        const Chunk* chunk = world.getChunk({ pos.x + dx, pos.y + dy, pos.z + dz });
+
+        // Intervallo di coordinate locali del vicino che ci interessa:
+        // -1 → solo l'ultimo strato (15), 0 → tutto, +1 → solo il primo (0)
+        auto rangeMin = [](int d) { return d < 0 ? CHUNK_MASK : 0; };
+        auto rangeMax = [](int d) { return d > 0 ? 0 : CHUNK_MASK; };
+
+        bool    aboveWorld   = pos.y + dy > WORLD_MAX_CHUNK_Y;
+        uint8_t missingLight = aboveWorld ? Chunk::packLight(MAX_LIGHT, 0) : 0;
+
+        for (int y = rangeMin(dy); y <= rangeMax(dy); y++)
+        for (int z = rangeMin(dz); z <= rangeMax(dz); z++)
+        for (int x = rangeMin(dx); x <= rangeMax(dx); x++) {
+            int i = index(x + dx * CHUNK_SIZE, y + dy * CHUNK_SIZE, z + dz * CHUNK_SIZE);
+            blocks[i] = chunk ? chunk->getBlock(x, y, z) : (BlockID)BLOCK_AIR;
+            light[i]  = chunk ? chunk->getLight(x, y, z) : missingLight;
+        }
+    }
+}
+
+void MeshOpacity::build(const MeshInput& input) {
+    const int ROW   = MESH_PADDED_SIZE;            // da una riga (y, z) alla successiva in z
+    const int LAYER = ROW * MESH_PADDED_SIZE;      // da uno strato y al successivo
+
+    // Per ogni riga dell'input (bordo compreso), bit x + 1 = voxel x
+    uint32_t opaqueRows[MESH_PADDED_SIZE * MESH_PADDED_SIZE];
+    uint32_t filledRows[MESH_PADDED_SIZE * MESH_PADDED_SIZE];
+    for (int r = 0; r < MESH_PADDED_SIZE * MESH_PADDED_SIZE; r++) {
+        const BlockID* row = &input.blocks[r * ROW];
+        uint32_t o = 0, f = 0;
+        for (int x = 0; x < MESH_PADDED_SIZE; x++) {
+            bool isOpaqueVoxel = isOpaque(row[x]);
+            opaque[r * ROW + x] = isOpaqueVoxel;
+            o |= (uint32_t)isOpaqueVoxel << x;
+            f |= (uint32_t)(row[x] != BLOCK_AIR) << x;
+        }
+        opaqueRows[r] = o;
+        filledRows[r] = f;
+    }
+
+    // Distanza nell'input del vicino di ogni faccia, nell'ordine di BlockFace
+    const int neighbourOffset[6] = { 1, -1, LAYER, -LAYER, ROW, -ROW };
+
+    std::memset(slices, 0, sizeof(slices));
+    for (int y = 0; y < CHUNK_SIZE; y++)
+        for (int z = 0; z < CHUNK_SIZE; z++) {
+            int r = (y + 1) * MESH_PADDED_SIZE + (z + 1);
+            uint32_t filled      = (filledRows[r] >> 1) & 0xFFFF;
+            uint32_t transparent = filled & ~(opaqueRows[r] >> 1);
+
+            // Il vicino di ogni voxel della riga, allineato al bit x
+            const uint32_t neighbours[6] = {
+                opaqueRows[r] >> 2,                    // +X
+                opaqueRows[r],                         // -X
+                opaqueRows[r + MESH_PADDED_SIZE] >> 1, // +Y
+                opaqueRows[r - MESH_PADDED_SIZE] >> 1, // -Y
+                opaqueRows[r + 1] >> 1,                // +Z
+                opaqueRows[r - 1] >> 1,                // -Z
+            };
+            for (int face = 0; face < 6; face++) {
+                uint32_t mask = filled & ~neighbours[face] & 0xFFFF;
+
+                // Blocchi non opachi: niente faccia verso un vicino dello stesso tipo
+                for (uint32_t check = mask & transparent; check; check &= check - 1) {
+                    int x   = std::countr_zero(check);
+                    int idx = r * ROW + x + 1;
+                    if (input.blocks[idx] == input.blocks[idx + neighbourOffset[face]]) mask &= ~(1u << x);
+                }
+
+                faces[face][y * CHUNK_SIZE + z] = (uint16_t)mask;
+                if (!mask) continue;
+                int axis = face >> 1;
+                slices[face] |= axis == 0 ? mask : 1u << (axis == 1 ? y : z);
+            }
+        }
+}
+
+uint16_t MeshOpacity::sliceRow(int face, int slice, int j) const {
+    const uint16_t* rows = faces[face];
+    uint32_t bits = 0;
+    switch (face >> 1) {
+    case 0: // facce ±X: u = y, v = z, un bit (x = slice) per riga
+        for (int i = 0; i < CHUNK_SIZE; i++) bits |= ((rows[i * CHUNK_SIZE + j] >> slice) & 1u) << i;
+        return (uint16_t)bits;
+    case 1: // facce ±Y: u = z, v = x, il bit x = j delle righe dello strato
+        for (int i = 0; i < CHUNK_SIZE; i++) bits |= ((rows[slice * CHUNK_SIZE + i] >> j) & 1u) << i;
+        return (uint16_t)bits;
+    default: // facce ±Z: u = x, v = y, la riga è già quella
+        return rows[j * CHUNK_SIZE + slice];
+    }
+}
+
+int MeshOpacity::faceCount() const {
+    int count = 0;
+    for (int face = 0; face < 6; face++)
+        for (uint16_t row : faces[face]) count += std::popcount(row);
+    return count;
+}
+
+// ---------------------------------------------------------------
+// Una faccia visibile nella maschera del greedy è una chiave a 64 bit:
+//   bit  0-15      tipo di blocco
+//   bit 16 + 10k   angolo k (0..3): AO (2 bit), cielo (4), blocchi (4)
+// Due facce si fondono solo se la chiave è identica, così il quad
+// grande ha agli angoli gli stessi valori di ogni faccia che contiene.
+// 0 = nessuna faccia (l'aria non ne ha).
+// ---------------------------------------------------------------
+using FaceKey = uint64_t;
+
+// Angoli della faccia nell'ordine dei vertici di emitQuad: (-u, -v),
+// (+u, -v), (+u, +v), (-u, +v)
+static const int CORNER_SIGNS[4][2] = { { -1, -1 }, { 1, -1 }, { 1, 1 }, { -1, 1 } };
+
+// AO e luce ai 4 angoli di una faccia. front è il voxel d'aria davanti
+// alla faccia; per ogni angolo si guardano i due voxel di lato e quello
+// in diagonale sullo stesso strato. AO classico: due lati pieni chiudono
+// l'angolo del tutto. La luce è la media dei voxel vuoti tra i quattro
+// (la diagonale conta solo se si vede). L'opacità dei voxel viene da
+// MeshOpacity, già calcolata per tutto l'input.
+static FaceKey faceCorners(const MeshInput& input, const MeshOpacity& opacity, int front, int strideU, int strideV) {
+    FaceKey key = 0;
+    for (int k = 0; k < 4; k++) {
+        int side1  = front + CORNER_SIGNS[k][0] * strideU;
+        int side2  = front + CORNER_SIGNS[k][1] * strideV;
+        int corner = side1 + CORNER_SIGNS[k][1] * strideV;
+        bool solid1 = opacity.opaque[side1];
+        bool solid2 = opacity.opaque[side2];
+        bool solidC = (solid1 && solid2) || opacity.opaque[corner];
+        int  ao = (solid1 && solid2) ? 0 : 3 - (int)solid1 - (int)solid2 - (int)solidC;
+
+        int sky = input.light[front] >> 4, block = input.light[front] & 15, count = 1;
+        for (int n : { side1, side2, corner }) {
+            bool solid = n == side1 ? solid1 : n == side2 ? solid2 : solidC;
+            if (solid) continue;
+            sky   += input.light[n] >> 4;
+            block += input.light[n] & 15;
+            count++;
+        }
+        sky   = (sky + count / 2) / count;
+        block = (block + count / 2) / count;
+        key |= (FaceKey)(ao | sky << 2 | block << 6) << (16 + 10 * k);
+    }
+    return key;
+}
+
+// ---------------------------------------------------------------
+// Emette un quad sul piano "plane" lungo l'asse "axis".
+// u e v sono gli altri due assi in ordine ciclico (x→y→z→x), così
+// u × v punta verso +axis e l'ordine 0,1,2,3 dei vertici è antiorario
+// visto dal lato positivo. Per le facce negative invertiamo gli indici.
+// ---------------------------------------------------------------
+static void emitQuad(ChunkMesh& out, int face, int axis, int u, int v,
+                     int plane, int i, int j, int w, int h, FaceKey key) {
+    // Il quad non entra più negli indici della prima parte: comincia la seconda
+    if (out.splitVertex == 0 && out.vertices.size() + 4 > MESH_PART_VERTICES) {
+        out.splitVertex = (uint32_t)out.vertices.size();
+        out.splitIndex  = (uint32_t)out.indices.size();
+    }
+    uint16_t base = (uint16_t)(out.vertices.size() - out.splitVertex);
+
+    const int corners[4][2] = { { i, j }, { i + w, j }, { i + w, j + h }, { i, j + h } };
+    int brightness[4];
+    for (int k = 0; k < 4; k++) {
+        int p[3];
+        p[axis] = plane;
+        p[u]    = corners[k][0];
+        p[v]    = corners[k][1];
+
+        int light = (int)(key >> (16 + 10 * k)) & 1023;
+        VertexData vertex;
+        vertex.x = p[0];
+        vertex.y = p[1];
+        vertex.z = p[2];
+        vertex.face         = face;
+        vertex.ao           = light & 3;
+        vertex.textureLayer = blockTextureLayer((BlockID)(key & 0xFFFF), face);
+        vertex.skyLight     = (light >> 2) & 15;
+        vertex.blockLight   = (light >> 6) & 15;
+        out.vertices.push_back(packVertex(vertex));
+
+        // Come la calcola lo shader: (0.55 + 0.15 AO) * luce
+        brightness[k] = (11 + 3 * vertex.ao) * std::max(vertex.skyLight, vertex.blockLight);
+    }
+
+    // Il quad si divide in due triangoli lungo la diagonale 0-2; se gli
+    // angoli 0 e 2 sono i più scuri si usa l'altra, altrimenti l'ombra
+    // dell'AO si allunga in modo diverso a seconda dell'orientamento
+    bool flip = brightness[0] + brightness[2] < brightness[1] + brightness[3];
+    bool positive = (face & 1) == 0;
+    static const uint16_t QUADS[4][6] = {
+        { 0, 1, 2, 2, 3, 0 }, { 1, 2, 3, 3, 0, 1 }, // positive
+        { 2, 1, 0, 0, 3, 2 }, { 3, 2, 1, 1, 0, 3 }, // negative
+    };
+    for (uint16_t k : QUADS[(positive ? 0 : 2) + (flip ? 1 : 0)]) out.indices.push_back(base + k);
+}
+
+void buildChunkMesh(const MeshInput& input, ChunkMesh& out, bool greedy) {
+    out.clear();
+
+    // Distanza nell'array 18³ tra due voxel vicini lungo x, y, z
+    const int stride[3] = { 1, MESH_PADDED_SIZE * MESH_PADDED_SIZE, MESH_PADDED_SIZE };
+
+    // Maschera 16x16 delle facce visibili in una fetta: la chiave della
+    // faccia (tipo, AO e luce), 0 dove non c'è niente da disegnare
+    FaceKey mask[CHUNK_AREA];
+
+    // Opacità e facce visibili di tutto il chunk, a righe di bit
+    MeshOpacity opacity;
+    opacity.build(input);
+
+    for (int face = 0; face < 6; face++) {
+        int axis = face >> 1;
+        int u    = (axis + 1) % 3;
+        int v    = (axis + 2) % 3;
+        int dir  = (face & 1) ? -1 : 1;
+        int neighbourOffset = dir * stride[axis];
+
+        for (int slice = 0; slice < CHUNK_SIZE; slice++) {
+            if (!((opacity.slices[face] >> slice) & 1)) continue; // fetta senza facce
+
+            // 1) Costruisce la maschera: la chiave di ogni faccia visibile
+            //    (c'è un blocco e il vicino in quella direzione non è opaco)
+            //    Si visitano solo i bit accesi della riga.
+            for (int j = 0; j < CHUNK_SIZE; j++) {
+                FaceKey* row = &mask[j * CHUNK_SIZE];
+                std::memset(row, 0, CHUNK_SIZE * sizeof(FaceKey));
+                int rowIndex = MeshInput::index(0, 0, 0) + slice * stride[axis] + j * stride[v];
+                for (uint32_t bits = opacity.sliceRow(face, slice, j); bits; bits &= bits - 1) {
+                    int i   = std::countr_zero(bits);
+                    int idx = rowIndex + i * stride[u];
+                    row[i] = input.blocks[idx] | faceCorners(input, opacity, idx + neighbourOffset, stride[u], stride[v]);
+                }
+            }
+
+            // 2) Greedy: partendo da ogni faccia ancora libera allarga il
+            //    rettangolo prima lungo u poi lungo v finché il tipo è lo stesso
+            int plane = slice + (dir > 0 ? 1 : 0);
+            for (int j = 0; j < CHUNK_SIZE; j++) {
+                for (int i = 0; i < CHUNK_SIZE; ) {
+                    FaceKey key = mask[j * CHUNK_SIZE + i];
+                    if (key == 0) { i++; continue; }
+
+                    int w = 1;
+                    int h = 1;
+                    if (greedy) {
+                        while (i + w < CHUNK_SIZE && mask[j * CHUNK_SIZE + i + w] == key) w++;
+
+                        for (; j + h < CHUNK_SIZE; h++) {
+                            const FaceKey* row = &mask[(j + h) * CHUNK_SIZE + i];
+                            bool sameRow = true;
+                            for (int k = 0; k < w; k++)
+                                if (row[k] != key) { sameRow = false; break; }
+                            if (!sameRow) break;
+                        }
+                    }
+
+                    // Le facce usate dal rettangolo non vanno riprese
+                    for (int y = 0; y < h; y++)
+                        std::memset(&mask[(j + y) * CHUNK_SIZE + i], 0, w * sizeof(FaceKey));
+
+                    emitQuad(out, face, axis, u, v, plane, i, j, w, h, key);
+                    i += w;
+                }
+            }
+        }
+    }
+}
+
+ChunkVisibility computeChunkVisibility(const MeshInput& input) {
+    // Visitati: un bit per voxel del chunk (senza bordo)
+    uint64_t visited[CHUNK_VOLUME / 64] = {};
+    int      stack[CHUNK_VOLUME];
+    int      emptyVoxels = 0;
+
+    for (int i = 0; i < CHUNK_VOLUME; i++) {
+        int x = i & CHUNK_MASK, z = (i >> CHUNK_SHIFT) & CHUNK_MASK, y = i >> (2 * CHUNK_SHIFT);
+        if (!isOpaque(input.get(x, y, z))) emptyVoxels++;
+    }
+
+    ChunkVisibility result;
+    if (emptyVoxels == CHUNK_VOLUME) return result; // tutto aria: tutto collegato
+    result.connections = 0;
+    if (emptyVoxels == 0) return result;            // tutto pieno: niente passa
+
+    // Ogni regione d'aria che tocca il bordo collega tutte le facce che tocca.
+    // Basta partire dai voxel di bordo: le regioni interne non toccano facce.
+    for (int start = 0; start < CHUNK_VOLUME; start++) {
+        int sx = start & CHUNK_MASK, sz = (start >> CHUNK_SHIFT) & CHUNK_MASK, sy = start >> (2 * CHUNK_SHIFT);
+        bool onBorder = sx == 0 || sx == CHUNK_MASK || sy == 0 || sy == CHUNK_MASK || sz == 0 || sz == CHUNK_MASK;
+        if (!onBorder || (visited[start >> 6] >> (start & 63)) & 1 || isOpaque(input.get(sx, sy, sz))) continue;
+
+        int faces = 0; // bit per ogni BlockFace toccata
+        int top = 0;
+        stack[top++] = start;
+        visited[start >> 6] |= uint64_t(1) << (start & 63);
+
+        while (top > 0) {
+            int i = stack[--top];
+            int x = i & CHUNK_MASK, z = (i >> CHUNK_SHIFT) & CHUNK_MASK, y = i >> (2 * CHUNK_SHIFT);
+            if (x == CHUNK_MASK) faces |= 1 << FACE_POS_X;
+            if (x == 0)          faces |= 1 << FACE_NEG_X;
+            if (y == CHUNK_MASK) faces |= 1 << FACE_POS_Y;
+            if (y == 0)          faces |= 1 << FACE_NEG_Y;
+            if (z == CHUNK_MASK) faces |= 1 << FACE_POS_Z;
+            if (z == 0)          faces |= 1 << FACE_NEG_Z;
+
+            const int offsets[6][3] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+            for (const auto& o : offsets) {
+                int nx = x + o[0], ny = y + o[1], nz = z + o[2];
+                if ((unsigned)nx > CHUNK_MASK || (unsigned)ny > CHUNK_MASK || (unsigned)nz > CHUNK_MASK) continue;
+                int n = Chunk::index(nx, ny, nz);
+                if ((visited[n >> 6] >> (n & 63)) & 1 || isOpaque(input.get(nx, ny, nz))) continue;
+                visited[n >> 6] |= uint64_t(1) << (n & 63);
+                stack[top++] = n;
+            }
+        }
+
+        for (int a = 0; a < 6; a++)
+            for (int b = 0; b < 6; b++)
+                if ((faces >> a & 1) && (faces >> b & 1))
+                    result.connections |= uint64_t(1) << (a * 6 + b);
+    }
+    return result;
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "memory.h"
+#include "packed_vertex.h"
+#include "world.h"
+
+// ---------------------------------------------------------------
+// Le 6 facce di un cubo, nell'ordine: asse X, Y, Z, prima il verso
+// positivo poi il negativo. face / 2 dà l'asse, face % 2 il verso.
+// ---------------------------------------------------------------
+enum BlockFace : uint8_t {
+    FACE_POS_X = 0,
+    FACE_NEG_X,
+    FACE_POS_Y,
+    FACE_NEG_Y,
+    FACE_POS_Z,
+    FACE_NEG_Z
+};
+
+// ---------------------------------------------------------------
+// Connettività tra le facce di un chunk attraverso l'aria: il bit
+// (a * 6 + b) dice se da una faccia a si può arrivare alla faccia b
+// passando solo per voxel vuoti. Serve all'occlusion culling: se un
+// chunk non collega la faccia da cui lo guardiamo con quella opposta,
+// quello che c'è dietro è nascosto.
+// ---------------------------------------------------------------
+struct ChunkVisibility {
+    uint64_t connections = ~uint64_t(0); // di default: tutto collegato
+
+    bool connects(int faceA, int faceB) const {
+        return (connections >> (faceA * 6 + faceB)) & 1;
+    }
+};
+
+// I vertici sono nel formato compatto di packed_vertex.h, con la
+// posizione locale al chunk: quella nel mondo la aggiunge lo shader.
+//
+// Gli indici sono a 16 bit, ma un chunk può avere fino a 98304 vertici:
+// tutti i 4096 blocchi con 6 facce, per esempio una scacchiera di due
+// tipi non opachi diversi (le facce tra loro restano e non si uniscono).
+// Oltre MESH_PART_VERTICES la mesh continua in una seconda parte: gli
+// indici da splitIndex in poi contano da splitVertex. Il renderer la
+// disegna come due mesh con lo stesso chunk.
+constexpr uint32_t MESH_PART_VERTICES = 65536;
+static_assert(CHUNK_VOLUME * 6 * 4 <= 2 * MESH_PART_VERTICES, "un chunk sta in due parti");
+
+struct ChunkMesh {
+    std::vector<PackedVertex> vertices;
+    std::vector<uint16_t>     indices;
+    ChunkVisibility           visibility;
+    uint32_t splitVertex = 0; // inizio della seconda parte, 0 se ce n'è una sola
+    uint32_t splitIndex  = 0;
+
+    void clear() { vertices.clear(); indices.clear(); splitVertex = splitIndex = 0; }
+    bool empty() const { return indices.empty(); }
+    int  triangleCount() const { return (int)indices.size() / 3; }
+    size_t byteSize() const {
+        return vertices.size() * sizeof(PackedVertex) + indices.size() * sizeof(uint16_t);
+    }
+};
+
+// ---------------------------------------------------------------
+// Input del mesher: i blocchi del chunk più un bordo di 1 voxel
+// preso dai chunk vicini (18³), e la luce degli stessi voxel (come
+// in Chunk: cielo nei 4 bit alti, blocchi nei bassi). Con il bordo il
+// mesher sa se una faccia sul confine del chunk è coperta e come è
+// illuminata, senza accedere al World.
+// Copiare i dati prima di meshare significa anche che il mesher
+// può girare su un altro thread mentre il mondo cambia.
+// ---------------------------------------------------------------
+constexpr int MESH_PADDED_SIZE   = CHUNK_SIZE + 2;
+constexpr int MESH_PADDED_VOLUME = MESH_PADDED_SIZE * MESH_PADDED_SIZE * MESH_PADDED_SIZE;
+
+struct MeshInput {
+    BlockID blocks[MESH_PADDED_VOLUME];
+    uint8_t light[MESH_PADDED_VOLUME];
+
+    // Coordinate locali da -1 a 16 (il bordo è a -1 e a 16)
+    static int index(int x, int y, int z) {
+        return ((y + 1) * MESH_PADDED_SIZE + (z + 1)) * MESH_PADDED_SIZE + (x + 1);
+    }
+    BlockID get(int x, int y, int z) const { return blocks[index(x, y, z)]; }
+
+    // Copia dal mondo il chunk in pos e il bordo dei 26 vicini.
+    // Sopra il mondo c'è il cielo pieno, nei chunk mancanti il buio.
+    void gather(const World& world, const ChunkPos& pos);
+};
+
+// ---------------------------------------------------------------
+// Facce visibili di un chunk, come maschere di bit
+// Prima di meshare si legge l'opacità di ogni voxel dell'input una
+// volta sola (un load nelle tabelle di block.h ciascuno) e se ne fanno
+// righe di 18 bit lungo x. Una faccia è visibile dove c'è un blocco e
+// il vicino nella sua direzione non è opaco: per una riga intera sono
+// un AND e un NOT tra due parole (spostate di un bit per ±X), 16 voxel
+// alla volta. Le fette senza nessuna faccia il mesher le salta.
+// Tra due blocchi uguali non opachi (due vetri) la faccia non c'è.
+// ---------------------------------------------------------------
+struct MeshOpacity {
+    uint8_t  opaque[MESH_PADDED_VOLUME]; // 1 se il voxel è opaco (per AO e luce agli angoli)
+    uint16_t faces[6][CHUNK_AREA];       // per BlockFace e riga (y, z) del chunk: bit x = faccia visibile
+    uint16_t slices[6];                  // per BlockFace: bit s = la fetta s lungo l'asse ha facce
+
+    void build(const MeshInput& input);
+
+    bool visible(int face, int x, int y, int z) const {
+        return (faces[face][y * CHUNK_SIZE + z] >> x) & 1;
+    }
+
+    // La riga j della fetta slice come la scorre buildChunkMesh: bit i =
+    // faccia visibile nel punto (i, j) degli assi u, v di quella faccia
+    uint16_t sliceRow(int face, int slice, int j) const;
+
+    // Facce visibili in tutto il chunk (= quad della mesh senza greedy)
+    int faceCount() const;
+};
+
+// ---------------------------------------------------------------
+// Input e mesh riciclati tra un job e l'altro (pipeline e LOD): un
+// MeshInput sono quasi 18 KB, e una ChunkMesh tornata nel pool tiene
+// la capacità dei suoi vector, così buildChunkMesh (che la svuota)
+// di solito non rialloca. Si restituiscono da qualsiasi thread.
+// ---------------------------------------------------------------
+using PooledMeshInput = ObjectPool<MeshInput>::Ptr;
+using PooledChunkMesh = ObjectPool<ChunkMesh>::Ptr;
+
+PooledMeshInput acquireMeshInput();
+PooledChunkMesh acquireChunkMesh();
+
+// Costruisce la mesh del chunk emettendo solo le facce visibili.
+// Ogni vertice ha AO e luce "smooth": la media dei 4 voxel d'aria che
+// toccano il suo angolo davanti alla faccia.
+// Con greedy = true le facce complanari dello stesso tipo, con la
+// stessa luce e AO ai quattro angoli, vengono fuse in rettangoli più
+// grandi (greedy meshing); con false ogni faccia visibile resta un
+// quad a sé (utile per confronti).
+void buildChunkMesh(const MeshInput& input, ChunkMesh& out, bool greedy = true);
+
+// Calcola quali facce del chunk sono collegate dall'aria (flood fill
+// che parte dai voxel vuoti sul bordo del chunk)
+ChunkVisibility computeChunkVisibility(const MeshInput& input);
@@ -0,0 +1,154 @@
+#include "mobs.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "job_system.h"
+#include "material.h"
+#include "raycast.h"
+#include "world.h"
+
+static const float GRAVITY     = 20.0f; // blocchi/s², come i frammenti
+static const float JUMP_SPEED  = 7.5f;  // abbastanza per salire un blocco
+static const float WALK_SPEED  = 2.5f;
+static const float TURN_SPEED  = 6.0f;  // radianti al secondo
+static const float MOB_SIZE    = 0.8f;
+static const float TWO_PI      = 6.2831853f;
+
+// Sotto il mondo non c'è niente su cui cadere
+static const float WORLD_FLOOR = (float)(WORLD_MIN_CHUNK_Y * CHUNK_SIZE) - 16.0f;
+
+static float nextRandom(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return (float)(state & 0xFFFFFF) / (float)0x1000000;
+}
+
+// Da a verso b per la via più corta, al massimo di step radianti
+static float turnTowards(float a, float b, float step) {
+    float diff = std::remainder(b - a, TWO_PI);
+    return std::remainder(a + std::clamp(diff, -step, step), TWO_PI);
+}
+
+float MobSystem::random() {
+    return nextRandom(rng);
+}
+
+int MobSystem::spawn(const World& world, const glm::vec3& center, int count, float radius) {
+    static const BlockID SKINS[] = { BLOCK_DIRT, BLOCK_GRASS, BLOCK_SAND, BLOCK_STONE };
+    glm::vec3 half(MOB_SIZE * 0.5f);
+    int spawned = 0;
+
+    count = std::min(count, MAX_MOBS - entities.count());
+    for (int i = 0; i < count; i++) {
+        int x = (int)std::floor(center.x + (random() * 2.0f - 1.0f) * radius);
+        int z = (int)std::floor(center.z + (random() * 2.0f - 1.0f) * radius);
+        BlockID skin = SKINS[(int)(random() * 4.0f) & 3];
+        float yaw = random() * TWO_PI;
+
+        // Il primo blocco pieno con aria sopra, scendendo da poco sopra il centro
+        int top = (int)std::floor(center.y) + 24;
+        int ground = top;
+        while (ground > (int)center.y - 48 && !(isSolid(world.getBlock(x, ground, z)) && !isSolid(world.getBlock(x, ground + 1, z))))
+            ground--;
+        if (ground <= (int)center.y - 48 || !world.findChunk(World::toChunkPos(x, ground, z))) continue;
+
+        glm::vec3 position((float)x + 0.5f, (float)ground + 1.0f + half.y + 1e-3f, (float)z + 0.5f);
+        const BlockTextures& textures = BLOCK_TEXTURES[skin];
+        entities.create(
+            Transform{ position, yaw },
+            PreviousTransform{ position, yaw },
+            Velocity{ glm::vec3(0.0f), false, false },
+            BoundingBox{ half },
+            Renderable{ packInstanceLayers(textures.top, textures.bottom, textures.side), MOB_SIZE },
+            Wander{ rng | 1u, random() * 2.0f, yaw, 0.0f });
+        spawned++;
+    }
+    return spawned;
+}
+
+void MobSystem::update(const World& world, float deltaTime) {
+    if (entities.count() == 0) return;
+
+    // 1) Dove andare: nuova direzione allo scadere del timer, salto
+    //    se l'ultimo passo è stato fermato da un blocco
+    entities.parallelForEachBatch<Wander, Velocity, Transform>(jobs,
+        [deltaTime](const EntityBatch& batch, Wander* wander, Velocity* velocity, Transform* transform) {
+            for (int i = 0; i < batch.count; i++) {
+                Wander& w = wander[i];
+                w.timer -= deltaTime;
+                if (w.timer <= 0.0f) {
+                    w.heading = nextRandom(w.rng) * TWO_PI;
+                    w.speed   = nextRandom(w.rng) < 0.3f ? 0.0f : WALK_SPEED * (0.5f + 0.5f * nextRandom(w.rng));
+                    w.timer   = 1.0f + 3.0f * nextRandom(w.rng);
+                }
+                Velocity& v = velocity[i];
+                v.linear.x = std::cos(w.heading) * w.speed;
+                v.linear.z = std::sin(w.heading) * w.speed;
+                if (v.onGround && v.blocked) v.linear.y = JUMP_SPEED;
+                transform[i].yaw = turnTowards(transform[i].yaw, w.heading, TURN_SPEED * deltaTime);
+            }
+        });
+
+    // 2) Movimento: gravità e collisioni con i blocchi, un asse alla
+    //    volta come il giocatore (sweepAabb)
+    entities.parallelForEachBatch<Transform, PreviousTransform, Velocity, const BoundingBox>(jobs,
+        [&world, deltaTime](const EntityBatch& batch, Transform* transform, PreviousTransform* previous,
+                            Velocity* velocity, const BoundingBox* bounds) {
+            for (int i = 0; i < batch.count; i++) {
+                Transform& t = transform[i];
+                Velocity&  v = velocity[i];
+                previous[i] = { t.position, t.yaw };
+
+                glm::ivec3 block((int)std::floor(t.position.x), (int)std::floor(t.position.y), (int)std::floor(t.position.z));
+                if (block.y >= WORLD_MIN_CHUNK_Y * CHUNK_SIZE && !world.findChunk(World::toChunkPos(block.x, block.y, block.z))) {
+                    v.linear = glm::vec3(0.0f); // chunk non caricato: ferma
+                    continue;
+                }
+
+                v.linear.y -= GRAVITY * deltaTime;
+                Aabb box = { t.position - bounds[i].halfExtents, t.position + bounds[i].halfExtents };
+                SweepResult result = sweepAabb(world, box, v.linear * deltaTime);
+                t.position = (box.min + box.max) * 0.5f;
+
+                v.onGround = result.blocked[1] && v.linear.y < 0.0f;
+                if (result.blocked[1]) v.linear.y = 0.0f;
+                v.blocked = result.blocked[0] || result.blocked[2];
+            }
+        });
+
+    // 3) Quelle cadute fuori dal mondo si tolgono (fuori dai sistemi:
+    //    la struttura del registry non cambia mentre li si scorre)
+    fallen.clear();
+    entities.forEach<const Transform, const Velocity>([this](Entity entity, const Transform& t, const Velocity&) {
+        if (t.position.y < WORLD_FLOOR) fallen.push_back(entity);
+    });
+    for (Entity entity : fallen) entities.destroy(entity);
+}
+
+void MobSystem::appendInstances(const World& world, std::vector<InstanceData>& out, float t) const {
+    // Ogni batch scrive la sua parte di out: batch.first è la posizione
+    // della creatura tra tutte quelle della query
+    size_t base = out.size();
+    out.resize(base + entities.countWith<const Transform, const PreviousTransform, const Renderable>());
+    InstanceData* instances = out.data() + base;
+
+    entities.parallelForEachBatch<const Transform, const PreviousTransform, const Renderable>(jobs,
+        [&world, t, instances](const EntityBatch& batch, const Transform* transform, const PreviousTransform* previous,
+                               const Renderable* renderable) {
+            for (int i = 0; i < batch.count; i++) {
+                glm::vec3 position = glm::mix(previous[i].position, transform[i].position, t);
+                float yaw = previous[i].yaw + std::remainder(transform[i].yaw - previous[i].yaw, TWO_PI) * t;
+                int x = (int)std::floor(position.x), y = (int)std::floor(position.y), z = (int)std::floor(position.z);
+                const Chunk* chunk = world.findChunk(World::toChunkPos(x, y, z));
+
+                InstanceData& instance = instances[batch.first + i];
+                instance.position = position;
+                instance.scale    = renderable[i].scale;
+                instance.rotation = axisAngle(glm::vec3(0.0f, 1.0f, 0.0f), yaw);
+                instance.layers   = renderable[i].layers;
+                instance.light    = chunk ? chunk->getLight(x & CHUNK_MASK, y & CHUNK_MASK, z & CHUNK_MASK) : MAX_LIGHT << 4;
+            }
+        });
+}
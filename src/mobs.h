@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "ecs.h"
+#include "instance_data.h"
+
+class JobSystem;
+class World;
+
+// ---------------------------------------------------------------
+// Componenti delle creature. Il centro del box è la posizione; yaw
+// gira attorno all'asse y.
+// ---------------------------------------------------------------
+struct Transform {
+    glm::vec3 position;
+    float     yaw;
+};
+
+// Transform prima dell'ultimo update, per interpolare tra due tick
+struct PreviousTransform {
+    glm::vec3 position;
+    float     yaw;
+};
+
+struct Velocity {
+    glm::vec3 linear;
+    bool      onGround; // appoggiata sul terreno dopo l'ultimo update
+    bool      blocked;  // fermata da un blocco in orizzontale
+};
+
+struct BoundingBox {
+    glm::vec3 halfExtents;
+};
+
+// Come disegnarla: un cubo di lato scale con le immagini layers
+struct Renderable {
+    uint32_t layers;
+    float    scale;
+};
+
+// Gira a caso: ogni tanto sceglie una direzione e una velocità
+// (anche zero), e salta se un blocco la ferma
+struct Wander {
+    uint32_t rng;     // generatore della singola creatura
+    float    timer;   // secondi alla prossima scelta
+    float    heading; // radianti, verso cui cammina
+    float    speed;   // blocchi/s
+};
+
+// ---------------------------------------------------------------
+// MobSystem
+// Le creature del mondo in un EntityRegistry. Come ParticleSystem:
+// update le muove ad ogni tick, appendInstances le aggiunge alle
+// istanze dell'InstanceRenderer. I sistemi (scelta della direzione,
+// movimento con le collisioni, istanze) girano in parallelo a batch
+// se c'è un JobSystem; ogni creatura dipende solo da sé e dal mondo,
+// quindi il risultato è lo stesso con qualsiasi numero di thread.
+//
+// Il mondo si legge soltanto (findChunk, niente cache condivise):
+// chi chiama update lo tiene fermo. Le creature sopra chunk non
+// caricati restano ferme finché il chunk non torna.
+// ---------------------------------------------------------------
+class MobSystem {
+public:
+    static constexpr int MAX_MOBS = 1 << 16;
+
+    explicit MobSystem(JobSystem* jobs = nullptr) : jobs(jobs) {}
+
+    // Fino a count creature a terra entro radius blocchi (in x e z) da
+    // center, nelle colonne caricate. Restituisce quante ne ha create.
+    int spawn(const World& world, const glm::vec3& center, int count, float radius = 16.0f);
+
+    void update(const World& world, float deltaTime);
+
+    // Un'istanza per creatura; t come in ParticleSystem::appendInstances
+    void appendInstances(const World& world, std::vector<InstanceData>& out, float t = 1.0f) const;
+
+    int count() const { return entities.count(); }
+    void clear() { entities = EntityRegistry(); }
+
+    EntityRegistry&       registry() { return entities; }
+    const EntityRegistry& registry() const { return entities; }
+
+private:
+    float random(); // 0..1
+
+    JobSystem*          jobs;
+    EntityRegistry      entities;
+    std::vector<Entity> fallen; // uscite dal fondo del mondo nell'ultimo update
+    uint32_t rng = 0x2545F491u;
+};
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+// ---------------------------------------------------------------
+// MpscQueue
+// Coda senza lock "Multi Producer, Single Consumer" (algoritmo di
+// Vyukov): tanti worker possono fare push() in contemporanea, un
+// solo thread (il render thread) fa pop(). Una push costa un
+// exchange atomico: i worker non si bloccano mai a vicenda.
+//
+// È una lista concatenata in cui "tail" punta sempre a un nodo
+// fittizio già consumato; il primo elemento vero è tail->next.
+// ---------------------------------------------------------------
+template <typename T>
+class MpscQueue {
+public:
+    MpscQueue() {
+        Node* stub = new Node();
+        head.store(stub, std::memory_order_relaxed);
+        tail = stub;
+    }
+
+    ~MpscQueue() {
+        T discard;
+        while (pop(discard)) {}
+        delete tail;
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    // Qualsiasi thread
+    void push(T value) {
+        Node* node = new Node();
+        node->value = std::move(value);
+        // Ci prendiamo il posto di ultimo nodo, poi agganciamo il precedente a noi.
+        // Tra le due istruzioni il consumatore vede la lista "interrotta" e
+        // semplicemente si ferma: l'elemento arriverà alla pop() successiva.
+        Node* prev = head.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    // Solo il thread consumatore. false se la coda è vuota.
+    bool pop(T& out) {
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if (!next) return false;
+
+        out = std::move(next->value);
+        delete tail;
+        tail = next; // next diventa il nuovo nodo fittizio
+        return true;
+    }
+
+private:
+    struct Node {
+        std::atomic<Node*> next{ nullptr };
+        T value{};
+    };
+
+    std::atomic<Node*> head; // lato produttori
+    Node*              tail; // lato consumatore
+};
@@ -0,0 +1,346 @@
+#include "net_protocol.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <lz4.h>
+
+#include "block_registry.h"
+
+void ByteWriter::u16(uint16_t v) {
+    out.push_back((uint8_t)v);
+    out.push_back((uint8_t)(v >> 8));
+}
+
+void ByteWriter::f32(float v) {
+    uint32_t bits;
+    std::memcpy(&bits, &v, 4);
+    for (int i = 0; i < 4; i++) out.push_back((uint8_t)(bits >> (8 * i)));
+}
+
+void ByteWriter::varint(uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back((uint8_t)(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back((uint8_t)v);
+}
+
+void ByteWriter::bytes(const void* data, size_t size) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    out.insert(out.end(), p, p + size);
+}
+
+void ByteWriter::chunkPos(const ChunkPos& pos) {
+    svarint(pos.x);
+    svarint(pos.y);
+    svarint(pos.z);
+}
+
+uint8_t ByteReader::u8() {
+    if (cursor >= end) {
+        failed = true;
+        return 0;
+    }
+    return *cursor++;
+}
+
+uint16_t ByteReader::u16() {
+    uint16_t lo = u8();
+    return (uint16_t)(lo | (uint16_t)u8() << 8);
+}
+
+float ByteReader::f32() {
+    uint32_t bits = 0;
+    for (int i = 0; i < 4; i++) bits |= (uint32_t)u8() << (8 * i);
+    float v;
+    std::memcpy(&v, &bits, 4);
+    return v;
+}
+
+uint64_t ByteReader::varint() {
+    uint64_t v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        uint8_t byte = u8();
+        v |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return v;
+    }
+    failed = true; // più di 10 byte: non è un varint
+    return 0;
+}
+
+const uint8_t* ByteReader::bytes(size_t size) {
+    if (remaining() < size) {
+        failed = true;
+        return nullptr;
+    }
+    const uint8_t* p = cursor;
+    cursor += size;
+    return p;
+}
+
+ChunkPos ByteReader::chunkPos() {
+    ChunkPos pos;
+    pos.x = (int)svarint();
+    pos.y = (int)svarint();
+    pos.z = (int)svarint();
+    return pos;
+}
+
+// ---------------------------------------------------------------
+// Messaggi piccoli
+// ---------------------------------------------------------------
+
+enum InputFlags : uint8_t {
+    INPUT_BREAK  = 1,
+    INPUT_PLACE  = 2,
+    INPUT_NOCLIP = 4,
+    INPUT_SPAWN  = 8,
+};
+
+void writeHello(std::vector<uint8_t>& out) {
+    ByteWriter writer(out);
+    writer.u8((uint8_t)MessageType::Hello);
+    writer.u16(PROTOCOL_VERSION);
+}
+
+bool readHello(ByteReader& in) {
+    return in.u16() == PROTOCOL_VERSION && in.ok();
+}
+
+void writeWelcome(std::vector<uint8_t>& out, const WelcomeMessage& message) {
+    ByteWriter writer(out);
+    writer.u8((uint8_t)MessageType::Welcome);
+    writer.varint(message.playerId);
+    writer.varint((uint64_t)message.tickRate);
+    writer.varint((uint64_t)message.viewDistance);
+    writer.f32(message.eye.x);
+    writer.f32(message.eye.y);
+    writer.f32(message.eye.z);
+}
+
+bool readWelcome(ByteReader& in, WelcomeMessage& message) {
+    message.playerId     = (uint32_t)in.varint();
+    message.tickRate     = (int)in.varint();
+    message.viewDistance = (int)in.varint();
+    message.eye.x = in.f32();
+    message.eye.y = in.f32();
+    message.eye.z = in.f32();
+    return in.ok() && message.tickRate > 0;
+}
+
+void writeInput(std::vector<uint8_t>& out, const InputMessage& message) {
+    const PlayerInput& input = message.input;
+    ByteWriter writer(out);
+    writer.u8((uint8_t)MessageType::Input);
+    writer.varint(message.sequence);
+    writer.u8(input.moves);
+    writer.f32(input.yaw);
+    writer.f32(input.pitch);
+    writer.u8((input.breakBlock ? INPUT_BREAK : 0) | (input.placeBlock ? INPUT_PLACE : 0)
+            | (input.toggleNoclip ? INPUT_NOCLIP : 0) | (input.spawnMobs ? INPUT_SPAWN : 0));
+    writer.varint(input.block); // i tipi registrati a runtime vanno oltre 255
+    writer.varint(message.entityAck);
+
+    size_t acks = std::min<size_t>(message.chunkAcks.size(), MAX_CHUNK_ACKS);
+    writer.u8((uint8_t)acks);
+    for (size_t i = 0; i < acks; i++) {
+        writer.chunkPos(message.chunkAcks[i].pos);
+        writer.varint(message.chunkAcks[i].version);
+    }
+}
+
+bool readInput(ByteReader& in, InputMessage& message) {
+    PlayerInput& input = message.input;
+    message.sequence = (uint32_t)in.varint();
+    input.moves = in.u8();
+    input.yaw   = in.f32();
+    input.pitch = in.f32();
+    uint8_t flags = in.u8();
+    input.breakBlock   = flags & INPUT_BREAK;
+    input.placeBlock   = flags & INPUT_PLACE;
+    input.toggleNoclip = flags & INPUT_NOCLIP;
+    input.spawnMobs    = flags & INPUT_SPAWN;
+    uint64_t block = in.varint();
+    input.block = block < MAX_BLOCK_TYPES ? (BlockID)block : (BlockID)BLOCK_AIR;
+    message.entityAck = in.varint();
+
+    int acks = in.u8();
+    message.chunkAcks.clear();
+    for (int i = 0; i < acks; i++) {
+        ChunkAck ack;
+        ack.pos     = in.chunkPos();
+        ack.version = (uint32_t)in.varint();
+        message.chunkAcks.push_back(ack);
+    }
+    // Niente NaN dal client: la camera non ne uscirebbe più
+    return in.ok() && std::isfinite(input.yaw) && std::isfinite(input.pitch) && block < MAX_BLOCK_TYPES
+        && isRegisteredBlock(input.block);
+}
+
+// ---------------------------------------------------------------
+// Chunk
+// ---------------------------------------------------------------
+
+void writeChunkMessage(std::vector<uint8_t>& out, const ChunkPos& pos, uint32_t version, const Chunk& chunk) {
+    thread_local std::vector<uint8_t> raw;
+    thread_local char compressed[LZ4_COMPRESSBOUND(Chunk::MAX_SERIALIZED_SIZE)];
+    raw.clear();
+    chunk.serialize(raw);
+    int size = LZ4_compress_default((const char*)raw.data(), compressed, (int)raw.size(), (int)sizeof(compressed));
+
+    ByteWriter writer(out);
+    writer.u8((uint8_t)MessageType::Chunk);
+    writer.chunkPos(pos);
+    writer.varint(version);
+    writer.varint(raw.size());
+    writer.varint((uint64_t)size);
+    writer.bytes(compressed, (size_t)size);
+}
+
+bool readChunkMessage(ByteReader& in, ChunkPos& pos, uint32_t& version, Chunk& chunk) {
+    thread_local char raw[Chunk::MAX_SERIALIZED_SIZE];
+    pos     = in.chunkPos();
+    version = (uint32_t)in.varint();
+    uint64_t rawSize        = in.varint();
+    uint64_t compressedSize = in.varint();
+    if (!in.ok() || rawSize > sizeof(raw) || compressedSize > in.remaining()) return false;
+
+    const uint8_t* compressed = in.bytes((size_t)compressedSize);
+    int size = LZ4_decompress_safe((const char*)compressed, raw, (int)compressedSize, (int)sizeof(raw));
+    return size == (int)rawSize && chunk.deserialize((const uint8_t*)raw, (size_t)size);
+}
+
+// ---------------------------------------------------------------
+// Entità
+//
+//   varint n, n id tolti (differenze dall'id precedente)
+//   varint m, m voci:  varint differenza dall'id precedente
+//                      u8 flag: NEW | MOVED | TURNED | LOOK
+//                      NEW:    posizione assoluta (3 svarint), yaw, layers
+//                      MOVED:  differenza di posizione (3 svarint)
+//                      TURNED: yaw
+//                      LOOK:   layers
+// ---------------------------------------------------------------
+enum EntityFlags : uint8_t {
+    ENTITY_NEW    = 1,
+    ENTITY_MOVED  = 2,
+    ENTITY_TURNED = 4,
+    ENTITY_LOOK   = 8,
+};
+
+static uint8_t entityChanges(const NetEntity& from, const NetEntity& to) {
+    uint8_t flags = 0;
+    if (from.position != to.position) flags |= ENTITY_MOVED;
+    if (from.yaw != to.yaw) flags |= ENTITY_TURNED;
+    if (from.layers != to.layers) flags |= ENTITY_LOOK;
+    return flags;
+}
+
+void writeEntityDelta(ByteWriter& out, const std::vector<NetEntity>& baseline, const std::vector<NetEntity>& current) {
+    // Tolti: in baseline e non in current (entrambi ordinati per id)
+    thread_local std::vector<uint32_t> removed;
+    removed.clear();
+    size_t j = 0;
+    for (const NetEntity& old : baseline) {
+        while (j < current.size() && current[j].id < old.id) j++;
+        if (j == current.size() || current[j].id != old.id) removed.push_back(old.id);
+    }
+    out.varint(removed.size());
+    uint32_t previous = 0;
+    for (uint32_t id : removed) {
+        out.varint(id - previous);
+        previous = id;
+    }
+
+    // Nuovi o cambiati. Il numero di voci va prima delle voci: si
+    // contano in un primo giro e si scrivono nel secondo.
+    auto forEachChange = [&](auto&& fn) {
+        size_t i = 0;
+        for (const NetEntity& entity : current) {
+            while (i < baseline.size() && baseline[i].id < entity.id) i++;
+            bool known = i < baseline.size() && baseline[i].id == entity.id;
+            uint8_t flags = known ? entityChanges(baseline[i], entity) : (uint8_t)ENTITY_NEW;
+            if (flags) fn(entity, known ? &baseline[i] : nullptr, flags);
+        }
+    };
+    size_t changes = 0;
+    forEachChange([&changes](const NetEntity&, const NetEntity*, uint8_t) { changes++; });
+    out.varint(changes);
+
+    previous = 0;
+    forEachChange([&](const NetEntity& entity, const NetEntity* old, uint8_t flags) {
+        out.varint(entity.id - previous);
+        previous = entity.id;
+        out.u8(flags);
+        glm::ivec3 p = old ? entity.position - old->position : entity.position;
+        if (flags & (ENTITY_NEW | ENTITY_MOVED)) {
+            out.svarint(p.x);
+            out.svarint(p.y);
+            out.svarint(p.z);
+        }
+        if (flags & (ENTITY_NEW | ENTITY_TURNED)) out.u8(entity.yaw);
+        if (flags & (ENTITY_NEW | ENTITY_LOOK)) out.varint(entity.layers);
+    });
+}
+
+bool readEntityDelta(ByteReader& in, const std::vector<NetEntity>& baseline, std::vector<NetEntity>& current) {
+    thread_local std::vector<uint32_t> removed;
+    removed.clear();
+    uint64_t removedCount = in.varint();
+    if (removedCount > baseline.size()) return false;
+    uint32_t id = 0;
+    for (uint64_t i = 0; i < removedCount; i++) {
+        id += (uint32_t)in.varint();
+        removed.push_back(id);
+    }
+
+    current.clear();
+    uint64_t changes = in.varint();
+    if (!in.ok() || changes > in.remaining()) return false;
+
+    // Unione ordinata: baseline senza i tolti, con le voci al loro posto
+    size_t b = 0, r = 0;
+    auto copyBaselineBelow = [&](uint64_t limit) {
+        for (; b < baseline.size() && baseline[b].id < limit; b++) {
+            while (r < removed.size() && removed[r] < baseline[b].id) r++;
+            if (r < removed.size() && removed[r] == baseline[b].id) continue;
+            current.push_back(baseline[b]);
+        }
+    };
+
+    id = 0;
+    for (uint64_t i = 0; i < changes; i++) {
+        uint32_t delta = (uint32_t)in.varint();
+        if (i > 0 && delta == 0) return false; // id ripetuto
+        id += delta;
+        uint8_t flags = in.u8();
+        copyBaselineBelow(id);
+
+        NetEntity entity;
+        if (flags & ENTITY_NEW) {
+            entity.id = id;
+            entity.position = glm::ivec3(0);
+            entity.yaw = 0;
+            entity.layers = 0;
+        } else {
+            // Una modifica di un'entità che il client deve già avere
+            if (b == baseline.size() || baseline[b].id != id) return false;
+            entity = baseline[b];
+        }
+        if (b < baseline.size() && baseline[b].id == id) b++;
+
+        if (flags & (ENTITY_NEW | ENTITY_MOVED)) {
+            glm::ivec3 p;
+            p.x = (int)in.svarint();
+            p.y = (int)in.svarint();
+            p.z = (int)in.svarint();
+            entity.position = (flags & ENTITY_NEW) ? p : entity.position + p;
+        }
+        if (flags & (ENTITY_NEW | ENTITY_TURNED)) entity.yaw = in.u8();
+        if (flags & (ENTITY_NEW | ENTITY_LOOK)) entity.layers = (uint32_t)in.varint();
+        current.push_back(entity);
+    }
+    copyBaselineBelow(UINT64_MAX);
+    return in.ok();
+}
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "simulation.h"
+#include "world.h"
+
+// ---------------------------------------------------------------
+// Protocollo tra server e client. Ogni pacchetto è un messaggio: un
+// byte di tipo e i campi in fila, senza allineamenti. Gli interi
+// vanno in varint (7 bit per byte, il bit alto dice "continua"): un
+// numero piccolo costa un byte solo, e quasi tutto quello che si
+// manda è piccolo (differenze, contatori, coordinate di chunk).
+//
+//   Hello    client → server   versione del protocollo
+//   Welcome  server → client   id del giocatore, tick rate, raggio di vista
+//   Input    client → server   PlayerInput del tick e le conferme
+//                              (ultimo stato delle entità, chunk ricevuti)
+//   Chunk    server → client   un chunk intero: serialize() compresso LZ4
+//   Entities server → client   le entità vicine, come differenza da uno
+//                              stato che il client ha già confermato
+//
+// I pacchetti possono perdersi: nessuno aspetta una risposta. Le
+// entità si mandano sempre rispetto all'ultimo stato confermato (o da
+// zero), i chunk non confermati si rimandano dopo un po'.
+// ---------------------------------------------------------------
+constexpr uint16_t PROTOCOL_VERSION = 2;
+
+enum class MessageType : uint8_t {
+    Hello = 1,
+    Welcome,
+    Input,
+    Chunk,
+    Entities,
+};
+
+// Stati delle entità che server e client tengono per fare e leggere
+// le differenze: una conferma più vecchia di così si ignora
+constexpr int ENTITY_HISTORY = 32;
+
+// Posizioni in 1/64 di blocco: abbastanza per non vedere scatti, e
+// le differenze tra due tick stanno in uno o due byte
+constexpr float POSITION_SCALE = 64.0f;
+
+inline glm::ivec3 quantizePosition(const glm::vec3& p) {
+    return glm::ivec3((int)std::lround(p.x * POSITION_SCALE), (int)std::lround(p.y * POSITION_SCALE),
+                      (int)std::lround(p.z * POSITION_SCALE));
+}
+
+inline glm::vec3 dequantizePosition(const glm::ivec3& q) {
+    return glm::vec3((float)q.x, (float)q.y, (float)q.z) * (1.0f / POSITION_SCALE);
+}
+
+// Un giro in 256 passi
+inline uint8_t quantizeAngle(float radians) {
+    return (uint8_t)(int)std::lround(radians * (256.0f / 6.2831853f));
+}
+
+inline float dequantizeAngle(uint8_t q) {
+    return (float)q * (6.2831853f / 256.0f);
+}
+
+// ---------------------------------------------------------------
+// Scrittura e lettura dei campi
+// ---------------------------------------------------------------
+class ByteWriter {
+public:
+    explicit ByteWriter(std::vector<uint8_t>& out) : out(out) {}
+
+    void u8(uint8_t v) { out.push_back(v); }
+    void u16(uint16_t v);
+    void f32(float v);
+    void varint(uint64_t v);
+    void svarint(int64_t v) { varint(((uint64_t)v << 1) ^ (uint64_t)(v >> 63)); } // zigzag: -1 → 1, 1 → 2
+    void bytes(const void* data, size_t size);
+    void chunkPos(const ChunkPos& pos);
+
+    size_t size() const { return out.size(); }
+
+private:
+    std::vector<uint8_t>& out;
+};
+
+// Un campo oltre la fine non è un errore subito: restituisce 0 e
+// ok() diventa false, da controllare alla fine del messaggio
+class ByteReader {
+public:
+    ByteReader(const uint8_t* data, size_t size) : cursor(data), end(data + size) {}
+
+    uint8_t  u8();
+    uint16_t u16();
+    float    f32();
+    uint64_t varint();
+    int64_t  svarint() { uint64_t v = varint(); return (int64_t)(v >> 1) ^ -(int64_t)(v & 1); }
+    const uint8_t* bytes(size_t size); // nullptr se non ci sono
+    ChunkPos chunkPos();
+
+    bool   ok() const { return !failed; }
+    size_t remaining() const { return (size_t)(end - cursor); }
+
+private:
+    const uint8_t* cursor;
+    const uint8_t* end;
+    bool failed = false;
+};
+
+// ---------------------------------------------------------------
+// Messaggi piccoli: il tipo seguito dai campi
+// ---------------------------------------------------------------
+struct WelcomeMessage {
+    uint32_t  playerId     = 0; // l'entità del giocatore, da non disegnare
+    int       tickRate     = 0;
+    int       viewDistance = 0;
+    glm::vec3 eye{ 0.0f };
+};
+
+struct ChunkAck {
+    ChunkPos pos;
+    uint32_t version;
+};
+
+// Il client ne manda uno per tick. Le conferme dei chunk sono quelle
+// arrivate dall'ultimo Input; se l'Input si perde il server rimanda.
+struct InputMessage {
+    uint32_t    sequence  = 0;
+    PlayerInput input;
+    uint64_t    entityAck = 0; // tick dell'ultimo stato delle entità ricevuto
+    std::vector<ChunkAck> chunkAcks;
+};
+
+constexpr int MAX_CHUNK_ACKS = 255; // per Input, le altre al prossimo
+
+void writeHello(std::vector<uint8_t>& out);
+void writeWelcome(std::vector<uint8_t>& out, const WelcomeMessage& message);
+void writeInput(std::vector<uint8_t>& out, const InputMessage& message);
+
+// Il resto del messaggio dopo il tipo; false se non è valido
+bool readHello(ByteReader& in);
+bool readWelcome(ByteReader& in, WelcomeMessage& message);
+bool readInput(ByteReader& in, InputMessage& message);
+
+// ---------------------------------------------------------------
+// Chunk: serialize() (già compresso con la palette) più LZ4
+// ---------------------------------------------------------------
+void writeChunkMessage(std::vector<uint8_t>& out, const ChunkPos& pos, uint32_t version, const Chunk& chunk);
+
+// Il resto di un messaggio Chunk dopo il tipo; false se non è valido
+bool readChunkMessage(ByteReader& in, ChunkPos& pos, uint32_t& version, Chunk& chunk);
+
+// ---------------------------------------------------------------
+// Entità come le vede un client: id stabile, posizione e yaw
+// quantizzati, l'aspetto (layers di InstanceData). Gli elenchi sono
+// ordinati per id.
+// ---------------------------------------------------------------
+struct NetEntity {
+    uint32_t   id;
+    glm::ivec3 position;
+    uint8_t    yaw;
+    uint32_t   layers;
+};
+
+// Un messaggio Entities: tick dello stato, tick della base usata (0:
+// nessuna), occhi del giocatore e poi la differenza
+//
+// current come differenza da baseline (vuoto: tutto da zero). Le
+// entità uguali nei due non costano niente, quelle sparite solo l'id,
+// quelle mosse le differenze di posizione.
+void writeEntityDelta(ByteWriter& out, const std::vector<NetEntity>& baseline, const std::vector<NetEntity>& current);
+
+// current = baseline più le differenze; false se i dati non sono validi
+bool readEntityDelta(ByteReader& in, const std::vector<NetEntity>& baseline, std::vector<NetEntity>& current);
@@ -0,0 +1,137 @@
+#include "noise.h"
+#include "noise_common.h"
+
+#include <cmath>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <immintrin.h>
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#endif
+
+// ---------------------------------------------------------------
+// Versione scalare: è il riferimento. I kernel SIMD devono dare
+// esattamente questi risultati, quindi ogni operazione è scritta
+// nello stesso ordine usato nei kernel vettoriali.
+// ---------------------------------------------------------------
+static inline float hashToFloat(uint32_t h) {
+    h ^= h >> 15;
+    h *= NOISE_MIX;
+    h ^= h >> 13;
+    return (float)(h >> 8) * NOISE_SCALE - 1.0f;
+}
+
+static inline float smooth(float t) {
+    return t * t * (3.0f - 2.0f * t);
+}
+
+static float valueNoise3D(float x, float y, float z, uint32_t seed) {
+    float x0 = std::floor(x);
+    float y0 = std::floor(y);
+    float z0 = std::floor(z);
+    float ux = smooth(x - x0);
+    float uy = smooth(y - y0);
+    float uz = smooth(z - z0);
+
+    // Il contributo di ogni asse all'hash si calcola una volta sola:
+    // per l'angolo successivo basta aggiungere il primo
+    uint32_t hx0 = (uint32_t)(int)x0 * NOISE_PRIME_X, hx1 = hx0 + NOISE_PRIME_X;
+    uint32_t hy0 = (uint32_t)(int)y0 * NOISE_PRIME_Y, hy1 = hy0 + NOISE_PRIME_Y;
+    uint32_t hz0 = (uint32_t)(int)z0 * NOISE_PRIME_Z + seed, hz1 = hz0 + NOISE_PRIME_Z;
+
+    float c000 = hashToFloat(hx0 + hy0 + hz0), c100 = hashToFloat(hx1 + hy0 + hz0);
+    float c010 = hashToFloat(hx0 + hy1 + hz0), c110 = hashToFloat(hx1 + hy1 + hz0);
+    float c001 = hashToFloat(hx0 + hy0 + hz1), c101 = hashToFloat(hx1 + hy0 + hz1);
+    float c011 = hashToFloat(hx0 + hy1 + hz1), c111 = hashToFloat(hx1 + hy1 + hz1);
+
+    // Interpolazione trilineare: prima lungo x, poi y, poi z
+    float a00 = c000 + (c100 - c000) * ux;
+    float a10 = c010 + (c110 - c010) * ux;
+    float a01 = c001 + (c101 - c001) * ux;
+    float a11 = c011 + (c111 - c011) * ux;
+    float b0  = a00 + (a10 - a00) * uy;
+    float b1  = a01 + (a11 - a01) * uy;
+    return b0 + (b1 - b0) * uz;
+}
+
+void fractalNoise3DScalar(const FractalParams& params, const float* x, const float* y, const float* z, float* out, int count) {
+    for (int i = 0; i < count; i++) {
+        float sum       = 0.0f;
+        float amplitude = 1.0f;
+        float frequency = params.frequency;
+        for (int octave = 0; octave < params.octaves; octave++) {
+            uint32_t seed = noiseOctaveSeed(params.seed, octave);
+            sum = sum + amplitude * valueNoise3D(x[i] * frequency, y[i] * frequency, z[i] * frequency, seed);
+            frequency *= params.lacunarity;
+            amplitude *= params.gain;
+        }
+        out[i] = sum;
+    }
+}
+
+// ---------------------------------------------------------------
+// Scelta del backend a runtime: lo stesso eseguibile gira su CPU
+// vecchie (scalare) e usa AVX2 dove c'è.
+// ---------------------------------------------------------------
+bool isNoiseBackendSupported(NoiseBackend backend) {
+    if (backend == NoiseBackend::Scalar) return true;
+
+#if defined(VOXEL_NOISE_SIMD)
+  #if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    bool sse41 = (info[2] & (1 << 19)) != 0;
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx2 = false;
+    if (osxsave && (_xgetbv(0) & 6) == 6) { // il sistema operativo salva i registri YMM
+        __cpuidex(info, 7, 0);
+        avx2 = (info[1] & (1 << 5)) != 0;
+    }
+    if (backend == NoiseBackend::SSE41) return sse41;
+    if (backend == NoiseBackend::AVX2)  return avx2;
+  #else
+    __builtin_cpu_init();
+    if (backend == NoiseBackend::SSE41) return __builtin_cpu_supports("sse4.1");
+    if (backend == NoiseBackend::AVX2) {
+        // Come sopra: la CPU può avere AVX2 con i registri YMM spenti dal
+        // sistema operativo. xgetbv in assembly, _xgetbv vorrebbe -mxsave.
+        unsigned int eax, ebx, ecx, edx;
+        if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & bit_OSXSAVE)) return false;
+        unsigned int xcr0Low, xcr0High;
+        __asm__ volatile("xgetbv" : "=a"(xcr0Low), "=d"(xcr0High) : "c"(0));
+        return (xcr0Low & 6) == 6 && __builtin_cpu_supports("avx2");
+    }
+  #endif
+#endif
+    return false;
+}
+
+NoiseBackend detectBestNoiseBackend() {
+    if (isNoiseBackendSupported(NoiseBackend::AVX2))  return NoiseBackend::AVX2;
+    if (isNoiseBackendSupported(NoiseBackend::SSE41)) return NoiseBackend::SSE41;
+    return NoiseBackend::Scalar;
+}
+
+const char* noiseBackendName(NoiseBackend backend) {
+    switch (backend) {
+        case NoiseBackend::Scalar: return "scalar";
+        case NoiseBackend::SSE41:  return "SSE4.1";
+        case NoiseBackend::AVX2:   return "AVX2";
+    }
+    return "?";
+}
+
+void fractalNoise3D(NoiseBackend backend, const FractalParams& params,
+                    const float* x, const float* y, const float* z,
+                    float* out, int count) {
+    int done = 0;
+#if defined(VOXEL_NOISE_SIMD)
+    if (backend == NoiseBackend::AVX2)  done = fractalNoise3DAVX2(params, x, y, z, out, count);
+    if (backend == NoiseBackend::SSE41) done = fractalNoise3DSSE41(params, x, y, z, out, count);
+#else
+    (void)backend;
+#endif
+    // Gli ultimi punti che non riempiono un registro SIMD
+    fractalNoise3DScalar(params, x + done, y + done, z + done, out + done, count - done);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+
+// ---------------------------------------------------------------
+// Rumore frattale ("value noise" a più ottave) calcolato a lotti.
+//
+// Il rumore è deterministico: stesso seed e stesse coordinate danno
+// sempre lo stesso valore, su qualsiasi macchina. Le versioni SIMD
+// (4 punti alla volta con SSE4.1, 8 con AVX2) eseguono esattamente le
+// stesse operazioni float nello stesso ordine della versione scalare,
+// quindi producono risultati identici bit per bit.
+// ---------------------------------------------------------------
+enum class NoiseBackend {
+    Scalar,
+    SSE41,
+    AVX2
+};
+
+// Il backend più veloce supportato dalla CPU su cui stiamo girando
+NoiseBackend detectBestNoiseBackend();
+bool         isNoiseBackendSupported(NoiseBackend backend);
+const char*  noiseBackendName(NoiseBackend backend);
+
+struct FractalParams {
+    uint32_t seed       = 0;
+    int      octaves    = 4;
+    float    frequency  = 0.01f; // scala della prima ottava
+    float    lacunarity = 2.0f;  // ogni ottava ha frequenza × lacunarity...
+    float    gain       = 0.5f;  // ...e ampiezza × gain
+};
+
+// out[i] = rumore frattale nel punto (x[i], y[i], z[i]).
+// Il risultato è circa in [-1, 1] per ottava, pesato dalle ampiezze.
+void fractalNoise3D(NoiseBackend backend, const FractalParams& params,
+                    const float* x, const float* y, const float* z,
+                    float* out, int count);
+
+// ---------------------------------------------------------------
+// Kernel per backend (noise.cpp, noise_sse41.cpp, noise_avx2.cpp).
+// Ogni file SIMD è compilato con le istruzioni del suo backend:
+// vanno chiamati solo se isNoiseBackendSupported() lo conferma.
+// Elaborano solo un multiplo della loro larghezza e restituiscono
+// quanti punti hanno fatto; il resto lo finisce la versione scalare.
+// ---------------------------------------------------------------
+void fractalNoise3DScalar(const FractalParams& params, const float* x, const float* y, const float* z, float* out, int count);
+int  fractalNoise3DSSE41 (const FractalParams& params, const float* x, const float* y, const float* z, float* out, int count);
+int  fractalNoise3DAVX2  (const FractalParams& params, const float* x, const float* y, const float* z, float* out, int count);
@@ -0,0 +1,87 @@
+// ---------------------------------------------------------------
+// Kernel AVX2: 8 punti per istruzione.
+// Questo file è compilato con -mavx2 (vedi CMakeLists.txt) e va
+// chiamato solo se la CPU supporta AVX2. Ogni operazione ricalca
+// quella della versione scalare in noise.cpp, nello stesso ordine.
+// ---------------------------------------------------------------
+#include "noise.h"
+#include "noise_common.h"
+
+#if defined(VOXEL_NOISE_SIMD)
+#include <immintrin.h>
+
+static inline __m256 hashToFloat(__m256i h) {
+    h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 15));
+    h = _mm256_mullo_epi32(h, _mm256_set1_epi32((int)NOISE_MIX));
+    h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 13));
+    __m256 f = _mm256_cvtepi32_ps(_mm256_srli_epi32(h, 8));
+    return _mm256_sub_ps(_mm256_mul_ps(f, _mm256_set1_ps(NOISE_SCALE)), _mm256_set1_ps(1.0f));
+}
+
+static inline __m256 smooth(__m256 t) {
+    return _mm256_mul_ps(_mm256_mul_ps(t, t), _mm256_sub_ps(_mm256_set1_ps(3.0f), _mm256_mul_ps(_mm256_set1_ps(2.0f), t)));
+}
+
+static inline __m256 lerp(__m256 a, __m256 b, __m256 t) {
+    return _mm256_add_ps(a, _mm256_mul_ps(_mm256_sub_ps(b, a), t));
+}
+
+static inline __m256 valueNoise3D(__m256 x, __m256 y, __m256 z, uint32_t seed) {
+    __m256 x0 = _mm256_floor_ps(x);
+    __m256 y0 = _mm256_floor_ps(y);
+    __m256 z0 = _mm256_floor_ps(z);
+    __m256 ux = smooth(_mm256_sub_ps(x, x0));
+    __m256 uy = smooth(_mm256_sub_ps(y, y0));
+    __m256 uz = smooth(_mm256_sub_ps(z, z0));
+
+    __m256i primeX = _mm256_set1_epi32((int)NOISE_PRIME_X);
+    __m256i primeY = _mm256_set1_epi32((int)NOISE_PRIME_Y);
+    __m256i primeZ = _mm256_set1_epi32((int)NOISE_PRIME_Z);
+
+    __m256i hx0 = _mm256_mullo_epi32(_mm256_cvttps_epi32(x0), primeX), hx1 = _mm256_add_epi32(hx0, primeX);
+    __m256i hy0 = _mm256_mullo_epi32(_mm256_cvttps_epi32(y0), primeY), hy1 = _mm256_add_epi32(hy0, primeY);
+    __m256i hz0 = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_cvttps_epi32(z0), primeZ), _mm256_set1_epi32((int)seed));
+    __m256i hz1 = _mm256_add_epi32(hz0, primeZ);
+
+    __m256i h00 = _mm256_add_epi32(hy0, hz0), h10 = _mm256_add_epi32(hy1, hz0);
+    __m256i h01 = _mm256_add_epi32(hy0, hz1), h11 = _mm256_add_epi32(hy1, hz1);
+
+    __m256 a00 = lerp(hashToFloat(_mm256_add_epi32(hx0, h00)), hashToFloat(_mm256_add_epi32(hx1, h00)), ux);
+    __m256 a10 = lerp(hashToFloat(_mm256_add_epi32(hx0, h10)), hashToFloat(_mm256_add_epi32(hx1, h10)), ux);
+    __m256 a01 = lerp(hashToFloat(_mm256_add_epi32(hx0, h01)), hashToFloat(_mm256_add_epi32(hx1, h01)), ux);
+    __m256 a11 = lerp(hashToFloat(_mm256_add_epi32(hx0, h11)), hashToFloat(_mm256_add_epi32(hx1, h11)), ux);
+    __m256 b0  = lerp(a00, a10, uy);
+    __m256 b1  = lerp(a01, a11, uy);
+    return lerp(b0, b1, uz);
+}
+
+int fractalNoise3DAVX2(const FractalParams& params, const float* x, const float* y, const float* z, float* out, int count) {
+    int done = count & ~7;
+    for (int i = 0; i < done; i += 8) {
+        __m256 px = _mm256_loadu_ps(x + i);
+        __m256 py = _mm256_loadu_ps(y + i);
+        __m256 pz = _mm256_loadu_ps(z + i);
+
+        __m256 sum      = _mm256_setzero_ps();
+        float amplitude = 1.0f;
+        float frequency = params.frequency;
+        for (int octave = 0; octave < params.octaves; octave++) {
+            __m256 f = _mm256_set1_ps(frequency);
+            __m256 n = valueNoise3D(_mm256_mul_ps(px, f), _mm256_mul_ps(py, f), _mm256_mul_ps(pz, f),
+                                    noiseOctaveSeed(params.seed, octave));
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(amplitude), n));
+            frequency *= params.lacunarity;
+            amplitude *= params.gain;
+        }
+        _mm256_storeu_ps(out + i, sum);
+    }
+    return done;
+}
+
+#else
+
+int fractalNoise3DAVX2(const FractalParams&, const float*, const float*, const float*, float*, int) {
+    return 0; // CPU non x86: ci pensa la versione scalare
+}
+
+#endif
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+
+// ---------------------------------------------------------------
+// Parti del rumore condivise dai kernel scalare e SIMD.
+// Header interno: lo includono solo i file noise*.cpp.
+// ---------------------------------------------------------------
+
+// Costanti dell'hash: tre primi grandi per mescolare le coordinate
+// del reticolo e una costante per la moltiplicazione finale
+constexpr uint32_t NOISE_PRIME_X = 0x27D4EB2Du;
+constexpr uint32_t NOISE_PRIME_Y = 0x165667B1u;
+constexpr uint32_t NOISE_PRIME_Z = 0x9E3779B1u;
+constexpr uint32_t NOISE_MIX     = 0x2C1B3C6Du;
+constexpr float    NOISE_SCALE   = 2.0f / 16777215.0f; // 24 bit di hash → [0, 2]
+
+// Ogni ottava usa un seed diverso, altrimenti le ottave sarebbero
+// copie ingrandite l'una dell'altra e si vedrebbero motivi ripetuti.
+// "static": ogni file ha la sua copia, così la versione compilata con
+// AVX2 non può finire per sbaglio nel codice scalare al momento del link.
+static inline uint32_t noiseOctaveSeed(uint32_t seed, int octave) {
+    return seed + (uint32_t)octave * 0x632BE5ABu;
+}
@@ -0,0 +1,87 @@
+// ---------------------------------------------------------------
+// Kernel SSE4.1: 4 punti per istruzione.
+// Questo file è compilato con -msse4.1 (vedi CMakeLists.txt) e va
+// chiamato solo se la CPU supporta SSE4.1. Ogni operazione ricalca
+// quella della versione scalare in noise.cpp, nello stesso ordine.
+// ---------------------------------------------------------------
+#include "noise.h"
+#include "noise_common.h"
+
+#if defined(VOXEL_NOISE_SIMD)
+#include <smmintrin.h>
+
+static inline __m128 hashToFloat(__m128i h) {
+    h = _mm_xor_si128(h, _mm_srli_epi32(h, 15));
+    h = _mm_mullo_epi32(h, _mm_set1_epi32((int)NOISE_MIX));
+    h = _mm_xor_si128(h, _mm_srli_epi32(h, 13));
+    __m128 f = _mm_cvtepi32_ps(_mm_srli_epi32(h, 8));
+    return _mm_sub_ps(_mm_mul_ps(f, _mm_set1_ps(NOISE_SCALE)), _mm_set1_ps(1.0f));
+}
+
+static inline __m128 smooth(__m128 t) {
+    return _mm_mul_ps(_mm_mul_ps(t, t), _mm_sub_ps(_mm_set1_ps(3.0f), _mm_mul_ps(_mm_set1_ps(2.0f), t)));
+}
+
+static inline __m128 lerp(__m128 a, __m128 b, __m128 t) {
+    return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t));
+}
+
+static inline __m128 valueNoise3D(__m128 x, __m128 y, __m128 z, uint32_t seed) {
+    __m128 x0 = _mm_floor_ps(x);
+    __m128 y0 = _mm_floor_ps(y);
+    __m128 z0 = _mm_floor_ps(z);
+    __m128 ux = smooth(_mm_sub_ps(x, x0));
+    __m128 uy = smooth(_mm_sub_ps(y, y0));
+    __m128 uz = smooth(_mm_sub_ps(z, z0));
+
+    __m128i primeX = _mm_set1_epi32((int)NOISE_PRIME_X);
+    __m128i primeY = _mm_set1_epi32((int)NOISE_PRIME_Y);
+    __m128i primeZ = _mm_set1_epi32((int)NOISE_PRIME_Z);
+
+    __m128i hx0 = _mm_mullo_epi32(_mm_cvttps_epi32(x0), primeX), hx1 = _mm_add_epi32(hx0, primeX);
+    __m128i hy0 = _mm_mullo_epi32(_mm_cvttps_epi32(y0), primeY), hy1 = _mm_add_epi32(hy0, primeY);
+    __m128i hz0 = _mm_add_epi32(_mm_mullo_epi32(_mm_cvttps_epi32(z0), primeZ), _mm_set1_epi32((int)seed));
+    __m128i hz1 = _mm_add_epi32(hz0, primeZ);
+
+    __m128i h00 = _mm_add_epi32(hy0, hz0), h10 = _mm_add_epi32(hy1, hz0);
+    __m128i h01 = _mm_add_epi32(hy0, hz1), h11 = _mm_add_epi32(hy1, hz1);
+
+    __m128 a00 = lerp(hashToFloat(_mm_add_epi32(hx0, h00)), hashToFloat(_mm_add_epi32(hx1, h00)), ux);
+    __m128 a10 = lerp(hashToFloat(_mm_add_epi32(hx0, h10)), hashToFloat(_mm_add_epi32(hx1, h10)), ux);
+    __m128 a01 = lerp(hashToFloat(_mm_add_epi32(hx0, h01)), hashToFloat(_mm_add_epi32(hx1, h01)), ux);
+    __m128 a11 = lerp(hashToFloat(_mm_add_epi32(hx0, h11)), hashToFloat(_mm_add_epi32(hx1, h11)), ux);
+    __m128 b0  = lerp(a00, a10, uy);
+    __m128 b1  = lerp(a01, a11, uy);
+    return lerp(b0, b1, uz);
+}
+
+int fractalNoise3DSSE41(const FractalParams& params, const float* x, const float* y, const float* z, float* out, int count) {
+    int done = count & ~3;
+    for (int i = 0; i < done; i += 4) {
+        __m128 px = _mm_loadu_ps(x + i);
+        __m128 py = _mm_loadu_ps(y + i);
+        __m128 pz = _mm_loadu_ps(z + i);
+
+        __m128 sum      = _mm_setzero_ps();
+        float amplitude = 1.0f;
+        float frequency = params.frequency;
+        for (int octave = 0; octave < params.octaves; octave++) {
+            __m128 f = _mm_set1_ps(frequency);
+            __m128 n = valueNoise3D(_mm_mul_ps(px, f), _mm_mul_ps(py, f), _mm_mul_ps(pz, f),
+                                    noiseOctaveSeed(params.seed, octave));
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(amplitude), n));
+            frequency *= params.lacunarity;
+            amplitude *= params.gain;
+        }
+        _mm_storeu_ps(out + i, sum);
+    }
+    return done;
+}
+
+#else
+
+int fractalNoise3DSSE41(const FractalParams&, const float*, const float*, const float*, float*, int) {
+    return 0; // CPU non x86: ci pensa la versione scalare
+}
+
+#endif
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+
+// ---------------------------------------------------------------
+// Formato compatto dei vertici delle mesh dei chunk: 8 byte.
+// Con tre float per la sola posizione servirebbero 12 byte, e con
+// normale, UV e luce si arriva a ~36. Ma in un chunk ogni valore
+// ha pochissimi stati possibili, quindi bastano pochi bit:
+//
+//   position (32 bit)
+//     bit  0-4   x locale   0..16 (16 = bordo del chunk)
+//     bit  5-9   y locale   0..16
+//     bit 10-14  z locale   0..16
+//     bit 15-17  faccia     0..5 (BlockFace: dà anche la normale)
+//     bit 18-19  AO         0..3 (3 = nessuna occlusione)
+//     bit 20-31  liberi
+//
+//   attributes (32 bit)
+//     bit  0-15  layer della texture array (vedi material.h)
+//     bit 16-19  luce del cielo  0..15
+//     bit 20-23  luce dei blocchi 0..15
+//     bit 24-31  liberi
+//
+// Le UV non servono: lo shader le ricava dalla posizione e dalla
+// faccia, così funzionano anche sui quad grandi del greedy meshing.
+// Il vertex shader in shaders/chunk.vert decodifica esattamente questi campi.
+// ---------------------------------------------------------------
+struct PackedVertex {
+    uint32_t position;
+    uint32_t attributes;
+};
+
+static_assert(sizeof(PackedVertex) == 8, "PackedVertex deve occupare 8 byte");
+
+// Versione "aperta" degli stessi dati, comoda per il codice CPU
+struct VertexData {
+    int x, y, z;
+    int face;
+    int ao;
+    int textureLayer;
+    int skyLight;
+    int blockLight;
+};
+
+inline PackedVertex packVertex(const VertexData& v) {
+    PackedVertex packed;
+    packed.position = (uint32_t)(v.x & 31)
+                    | (uint32_t)(v.y & 31) << 5
+                    | (uint32_t)(v.z & 31) << 10
+                    | (uint32_t)(v.face & 7) << 15
+                    | (uint32_t)(v.ao & 3) << 18;
+    packed.attributes = (uint32_t)(v.textureLayer & 0xFFFF)
+                      | (uint32_t)(v.skyLight & 15) << 16
+                      | (uint32_t)(v.blockLight & 15) << 20;
+    return packed;
+}
+
+inline VertexData unpackVertex(const PackedVertex& p) {
+    VertexData v;
+    v.x            = (int)(p.position & 31);
+    v.y            = (int)(p.position >> 5) & 31;
+    v.z            = (int)(p.position >> 10) & 31;
+    v.face         = (int)(p.position >> 15) & 7;
+    v.ao           = (int)(p.position >> 18) & 3;
+    v.textureLayer = (int)(p.attributes & 0xFFFF);
+    v.skyLight     = (int)(p.attributes >> 16) & 15;
+    v.blockLight   = (int)(p.attributes >> 20) & 15;
+    return v;
+}
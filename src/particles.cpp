@@ -0,0 +1,104 @@
+#include "particles.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "material.h"
+#include "world.h"
+
+static const float GRAVITY       = 20.0f; // blocchi/s²
+static const float BOUNCE        = 0.3f;  // velocità che resta dopo un urto
+static const float GROUND_FRICTION = 0.8f;
+static const float MIN_LIFE      = 1.0f;
+static const float MAX_LIFE      = 2.5f;
+
+float ParticleSystem::random() {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return (float)(rng & 0xFFFFFF) / (float)0x1000000;
+}
+
+void ParticleSystem::spawnDebris(const glm::ivec3& block, BlockID id, int count) {
+    const BlockTextures& textures = blockTextures(id);
+    uint32_t layers = packInstanceLayers(textures.top, textures.bottom, textures.side);
+
+    count = std::min(count, MAX_PARTICLES - (int)particles.size());
+    for (int i = 0; i < count; i++) {
+        Particle p;
+        glm::vec3 offset(random(), random(), random());
+        p.position = glm::vec3(block) + offset * 0.8f + 0.1f;
+        // Verso l'esterno dal centro del blocco, con una spinta in alto
+        glm::vec3 outward = offset - 0.5f;
+        p.velocity = outward * 6.0f + glm::vec3(0.0f, 2.0f + 3.0f * random(), 0.0f);
+        p.axis  = glm::normalize(glm::vec3(random() - 0.5f, random() - 0.5f, random() - 0.5f) + glm::vec3(0.0f, 0.01f, 0.0f));
+        p.angle = random() * 6.2831853f;
+        p.previousPosition = p.position;
+        p.previousAngle    = p.angle;
+        p.spin  = (random() - 0.5f) * 12.0f;
+        p.scale = 0.1f + 0.1f * random();
+        p.life  = MIN_LIFE + (MAX_LIFE - MIN_LIFE) * random();
+        p.layers = layers;
+        particles.push_back(p);
+    }
+}
+
+void ParticleSystem::update(const World& world, float deltaTime) {
+    auto solidAt = [&world](const glm::vec3& p) {
+        return isSolid(world.getBlock((int)std::floor(p.x), (int)std::floor(p.y), (int)std::floor(p.z)));
+    };
+
+    for (size_t i = 0; i < particles.size(); ) {
+        Particle& p = particles[i];
+        p.life -= deltaTime;
+        if (p.life <= 0.0f) {
+            // Togliere scambiando con l'ultimo: l'ordine non conta
+            p = particles.back();
+            particles.pop_back();
+            continue;
+        }
+
+        p.previousPosition = p.position;
+        p.previousAngle    = p.angle;
+        p.velocity.y -= GRAVITY * deltaTime;
+        p.angle += p.spin * deltaTime;
+
+        // Un asse alla volta: contro un blocco pieno la velocità su
+        // quell'asse si inverte e cala, le altre continuano. Un frammento
+        // non sta mai dentro un blocco pieno, quindi il mondo si legge
+        // solo quando passa nel voxel accanto.
+        for (int axis = 0; axis < 3; axis++) {
+            glm::vec3 next = p.position;
+            next[axis] += p.velocity[axis] * deltaTime;
+            if (std::floor(next[axis]) == std::floor(p.position[axis]) || !solidAt(next)) {
+                p.position = next;
+                continue;
+            }
+            if (axis == 1 && p.velocity.y < 0.0f) {
+                // A terra: l'attrito frena anche lo scivolamento e la rotazione
+                p.velocity.x *= GROUND_FRICTION;
+                p.velocity.z *= GROUND_FRICTION;
+                p.spin *= GROUND_FRICTION;
+            }
+            p.velocity[axis] *= -BOUNCE;
+        }
+        i++;
+    }
+}
+
+void ParticleSystem::appendInstances(const World& world, std::vector<InstanceData>& out, float t) const {
+    for (const Particle& p : particles) {
+        glm::vec3 position = glm::mix(p.previousPosition, p.position, t);
+        int x = (int)std::floor(position.x), y = (int)std::floor(position.y), z = (int)std::floor(position.z);
+        const Chunk* chunk = world.getChunk(World::toChunkPos(x, y, z));
+
+        InstanceData instance;
+        instance.position = position;
+        // Negli ultimi istanti il frammento si rimpicciolisce invece di sparire di colpo
+        instance.scale    = p.scale * std::min(p.life * 4.0f, 1.0f);
+        instance.rotation = axisAngle(p.axis, glm::mix(p.previousAngle, p.angle, t));
+        instance.layers   = p.layers;
+        instance.light    = chunk ? chunk->getLight(x & CHUNK_MASK, y & CHUNK_MASK, z & CHUNK_MASK) : MAX_LIGHT << 4;
+        out.push_back(instance);
+    }
+}
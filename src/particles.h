@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "block.h"
+#include "instance_data.h"
+
+class World;
+
+// ---------------------------------------------------------------
+// ParticleSystem
+// Frammenti di un blocco rotto: piccoli cubi con le immagini del
+// blocco che schizzano fuori, cadono, rimbalzano sul terreno e dopo
+// un po' spariscono. Tutto sulla CPU e senza OpenGL: ogni frame
+// update li muove e appendInstances li aggiunge alle istanze che
+// l'InstanceRenderer disegna con una draw call sola.
+// ---------------------------------------------------------------
+class ParticleSystem {
+public:
+    // Oltre questo numero i frammenti nuovi non si creano
+    static constexpr int MAX_PARTICLES = 1 << 16;
+
+    // count frammenti del blocco id, sparsi nel blocco intero in (x, y, z)
+    void spawnDebris(const glm::ivec3& block, BlockID id, int count = 24);
+
+    // Gravità, collisioni con i blocchi pieni e durata
+    void update(const World& world, float deltaTime);
+
+    // Aggiunge un'istanza per frammento, con la luce del voxel in cui si
+    // trova. t sceglie il momento: 1 dopo l'ultimo update, 0 prima
+    // (per interpolare tra due tick; gli elementi sono gli stessi)
+    void appendInstances(const World& world, std::vector<InstanceData>& out, float t = 1.0f) const;
+
+    int  count() const { return (int)particles.size(); }
+    void clear() { particles.clear(); }
+
+private:
+    struct Particle {
+        glm::vec3 position;
+        glm::vec3 previousPosition; // prima dell'ultimo update
+        glm::vec3 velocity;
+        glm::vec3 axis;  // asse di rotazione
+        float     angle;
+        float     previousAngle;
+        float     spin;  // radianti al secondo
+        float     scale;
+        float     life;  // secondi rimasti
+        uint32_t  layers;
+    };
+
+    float random(); // 0..1
+
+    std::vector<Particle> particles;
+    uint32_t rng = 0x9E3779B9u;
+};
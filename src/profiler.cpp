@@ -0,0 +1,301 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+
+// ---------------------------------------------------------------
+// Ring buffer di un thread. Solo il proprietario scrive; il thread
+// principale legge le zone tra "read" e "written". I campi degli slot
+// sono atomici (relaxed, su x86 sono normali mov) perché il lettore
+// può leggere uno slot mentre il proprietario lo sta riscrivendo:
+// dopo la copia ricontrolla "written" e scarta gli slot sovrascritti.
+// ---------------------------------------------------------------
+namespace {
+
+struct ZoneSlot {
+    std::atomic<const char*> name{ nullptr };
+    std::atomic<int64_t>     start{ 0 };
+    std::atomic<int64_t>     end{ 0 };
+    std::atomic<uint16_t>    depth{ 0 };
+};
+
+struct ThreadBuffer {
+    std::unique_ptr<ZoneSlot[]> slots{ new ZoneSlot[Profiler::THREAD_BUFFER_SIZE] };
+    std::atomic<uint64_t> written{ 0 };
+    uint64_t read  = 0; // solo il thread principale
+    uint16_t depth = 0; // solo il proprietario
+    uint16_t index = 0;
+    std::string name;   // protetto da State::mutex
+};
+
+struct State {
+    std::mutex mutex;
+    // Il buffer sopravvive al thread: le sue ultime zone si possono
+    // ancora raccogliere
+    std::vector<std::shared_ptr<ThreadBuffer>> threads;
+    std::vector<ThreadBuffer*> reading; // copia di threads per beginFrame (i buffer non muoiono)
+
+    std::deque<ProfileFrame> history;
+    size_t   peakZones   = 0;
+    uint64_t frameNumber = 0;
+    int64_t  frameStart  = 0;
+    bool     started     = false;
+};
+
+State& state() {
+    static State instance;
+    return instance;
+}
+
+// Un puntatore semplice (niente costruttore thread_local da controllare
+// ad ogni accesso): il buffer è tenuto vivo da State::threads
+thread_local ThreadBuffer* currentThread = nullptr;
+
+ThreadBuffer* registerThread() {
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    auto buffer = std::make_shared<ThreadBuffer>();
+    buffer->index = (uint16_t)s.threads.size();
+    buffer->name  = "Thread " + std::to_string(s.threads.size());
+    s.threads.push_back(buffer);
+    return buffer.get();
+}
+
+inline ThreadBuffer& threadBuffer() {
+    if (!currentThread) currentThread = registerThread();
+    return *currentThread;
+}
+
+} // namespace
+
+int64_t Profiler::now() {
+    // Un'origine comune per tutti i thread: i tempi restano piccoli
+    static const auto origin = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count();
+}
+
+void Profiler::enterZone() {
+    threadBuffer().depth++;
+}
+
+void Profiler::leaveZone(const char* name, int64_t start) {
+    ThreadBuffer& buffer = threadBuffer();
+    buffer.depth--;
+
+    uint64_t index = buffer.written.load(std::memory_order_relaxed);
+    ZoneSlot& slot = buffer.slots[index & (THREAD_BUFFER_SIZE - 1)];
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.start.store(start, std::memory_order_relaxed);
+    slot.end.store(now(), std::memory_order_relaxed);
+    slot.depth.store(buffer.depth, std::memory_order_relaxed);
+    buffer.written.store(index + 1, std::memory_order_release);
+}
+
+void Profiler::beginFrame() {
+    State& s = state();
+    int64_t frameEnd = now();
+
+    if (s.started) {
+        // A storico pieno il frame più vecchio diventa il nuovo: i suoi
+        // vector tengono la capacità, e a regime non si alloca niente
+        if ((int)s.history.size() < HISTORY_FRAMES) s.history.emplace_back();
+        else std::rotate(s.history.begin(), s.history.begin() + 1, s.history.end());
+        ProfileFrame& frame = s.history.back();
+        frame.number = s.frameNumber;
+        frame.start  = s.frameStart;
+        frame.end    = frameEnd;
+        frame.zones.clear();
+        frame.gpu.clear();
+        frame.zones.reserve(s.peakZones); // il frame più pieno visto finora
+
+        {
+            std::lock_guard<std::mutex> lock(s.mutex);
+            s.reading.clear();
+            for (const auto& buffer : s.threads) s.reading.push_back(buffer.get());
+        }
+        for (ThreadBuffer* buffer : s.reading) {
+            uint64_t written = buffer->written.load(std::memory_order_acquire);
+            uint64_t first   = std::max(buffer->read, written > THREAD_BUFFER_SIZE ? written - THREAD_BUFFER_SIZE : 0);
+            size_t   copied  = frame.zones.size();
+
+            for (uint64_t i = first; i < written; i++) {
+                const ZoneSlot& slot = buffer->slots[i & (THREAD_BUFFER_SIZE - 1)];
+                frame.zones.push_back({
+                    slot.name.load(std::memory_order_relaxed),
+                    slot.start.load(std::memory_order_relaxed),
+                    slot.end.load(std::memory_order_relaxed),
+                    slot.depth.load(std::memory_order_relaxed),
+                    buffer->index });
+            }
+
+            // Gli slot che il proprietario ha nel frattempo riscritto (o sta
+            // riscrivendo: l'indice "after" è in scrittura) non sono affidabili
+            uint64_t after = buffer->written.load(std::memory_order_acquire);
+            if (after >= first + THREAD_BUFFER_SIZE && written > first) {
+                size_t torn = (size_t)std::min(after - THREAD_BUFFER_SIZE - first + 1, written - first);
+                frame.zones.erase(frame.zones.begin() + copied, frame.zones.begin() + copied + torn);
+            }
+            buffer->read = written;
+        }
+
+        s.peakZones = std::max(s.peakZones, frame.zones.size());
+        s.frameNumber++;
+    }
+
+    s.started    = true;
+    s.frameStart = frameEnd;
+}
+
+uint64_t Profiler::frameNumber() {
+    return state().frameNumber;
+}
+
+const std::deque<ProfileFrame>& Profiler::frames() {
+    return state().history;
+}
+
+void Profiler::addGpuZone(uint64_t frame, const char* name, int64_t duration) {
+    State& s = state();
+    if (s.history.empty() || frame < s.history.front().number || frame > s.history.back().number) return;
+    s.history[(size_t)(frame - s.history.front().number)].gpu.push_back({ name, duration });
+}
+
+void Profiler::setThreadName(const std::string& name) {
+    ThreadBuffer& buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(state().mutex);
+    buffer.name = name;
+}
+
+std::vector<std::string> Profiler::threadNames() {
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    std::vector<std::string> names;
+    for (const auto& buffer : s.threads) names.push_back(buffer->name);
+    return names;
+}
+
+std::vector<ProfileZoneStats> Profiler::zoneStats(int frameCount) {
+    const std::deque<ProfileFrame>& history = state().history;
+    int count = std::min(frameCount, (int)history.size());
+    if (count == 0) return {};
+
+    // Il thread principale è quello che chiama beginFrame: lo riconosciamo
+    // dal suo buffer (lo crea la prima zona del game loop)
+    uint16_t mainThread = currentThread ? currentThread->index : UINT16_MAX;
+
+    // Chiave: nome + dove gira. Lo stesso letterale può avere indirizzi
+    // diversi in file diversi, quindi si confronta il testo.
+    struct Totals { double sum = 0.0, max = 0.0, calls = 0.0; bool gpu = false, main = false; };
+    std::map<std::string, Totals> totals;
+    std::map<std::string, double> frameSums;
+
+    for (int f = (int)history.size() - count; f < (int)history.size(); f++) {
+        const ProfileFrame& frame = history[f];
+        frameSums.clear();
+        for (const ProfileZone& zone : frame.zones) {
+            bool main = zone.thread == mainThread;
+            std::string key = std::string(main ? "M" : "W") + zone.name;
+            Totals& t = totals[key];
+            t.main = main;
+            t.calls++;
+            frameSums[key] += (zone.end - zone.start) * 1e-6;
+        }
+        for (const GpuProfileZone& zone : frame.gpu) {
+            std::string key = std::string("G") + zone.name;
+            Totals& t = totals[key];
+            t.gpu = true;
+            t.calls++;
+            frameSums[key] += zone.duration * 1e-6;
+        }
+        for (const auto& [key, ms] : frameSums) {
+            Totals& t = totals[key];
+            t.sum += ms;
+            t.max = std::max(t.max, ms);
+        }
+    }
+
+    std::vector<ProfileZoneStats> result;
+    for (const auto& [key, t] : totals) {
+        ProfileZoneStats stats;
+        stats.name       = key.substr(1);
+        stats.gpu        = t.gpu;
+        stats.mainThread = t.main;
+        stats.averageMs  = t.sum / count;
+        stats.maxMs      = t.max;
+        stats.calls      = t.calls / count;
+        result.push_back(stats);
+    }
+    std::sort(result.begin(), result.end(), [](const ProfileZoneStats& a, const ProfileZoneStats& b) {
+        return a.averageMs > b.averageMs;
+    });
+    return result;
+}
+
+// ---------------------------------------------------------------
+// Formato "Trace Event" di Chrome: eventi completi ("ph": "X") con
+// inizio e durata in microsecondi, più i nomi dei thread come metadati.
+// Le zone GPU non hanno un inizio: le mettiamo una dopo l'altra dall'inizio
+// del loro frame, su una riga a parte.
+// ---------------------------------------------------------------
+static void writeJsonString(std::ofstream& file, const char* text) {
+    file << '"';
+    for (const char* c = text; *c; c++) {
+        if (*c == '"' || *c == '\\') file << '\\';
+        file << *c;
+    }
+    file << '"';
+}
+
+bool Profiler::writeChromeTrace(const std::string& path) {
+    std::ofstream file(path);
+    if (!file) {
+        std::cerr << "Impossibile scrivere " << path << "\n";
+        return false;
+    }
+
+    std::vector<std::string> names = threadNames();
+    const int GPU_THREAD = (int)names.size();
+
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    auto separator = [&] { file << (first ? "" : ",\n"); first = false; };
+
+    for (size_t i = 0; i < names.size(); i++) {
+        separator();
+        file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << i << ",\"args\":{\"name\":";
+        writeJsonString(file, names[i].c_str());
+        file << "}}";
+    }
+    separator();
+    file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << GPU_THREAD << ",\"args\":{\"name\":\"GPU\"}}";
+
+    file.precision(3);
+    file << std::fixed;
+    for (const ProfileFrame& frame : state().history) {
+        for (const ProfileZone& zone : frame.zones) {
+            separator();
+            file << "{\"name\":";
+            writeJsonString(file, zone.name);
+            file << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << zone.thread
+                 << ",\"ts\":" << zone.start * 1e-3 << ",\"dur\":" << (zone.end - zone.start) * 1e-3 << "}";
+        }
+        int64_t gpuTime = frame.start;
+        for (const GpuProfileZone& zone : frame.gpu) {
+            separator();
+            file << "{\"name\":";
+            writeJsonString(file, zone.name);
+            file << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << GPU_THREAD
+                 << ",\"ts\":" << gpuTime * 1e-3 << ",\"dur\":" << zone.duration * 1e-3 << "}";
+            gpuTime += zone.duration;
+        }
+    }
+    file << "\n]}\n";
+    return (bool)file;
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+// ---------------------------------------------------------------
+// Profiler
+// Misura quanto durano le parti del frame ("zone") su tutti i thread.
+//
+//   void ChunkPipeline::update(...) {
+//       PROFILE_SCOPE("Pipeline update");
+//       ...
+//   }
+//
+// Ogni thread scrive le sue zone in un ring buffer tutto suo, senza
+// lock: il costo di una zona sono due letture dell'orologio e qualche
+// store. Una volta per frame il thread principale (PROFILE_FRAME)
+// raccoglie le zone finite da tutti i thread e le mette nello storico
+// degli ultimi frame, che il pannello F3 mostra e che si può salvare
+// come trace di Chrome (chrome://tracing o ui.perfetto.dev).
+//
+// Con VOXEL_PROFILING=0 (opzione CMake) le macro non generano codice.
+// I nomi delle zone devono essere stringhe letterali: si salva solo
+// il puntatore.
+// ---------------------------------------------------------------
+#ifndef VOXEL_PROFILING
+#define VOXEL_PROFILING 0
+#endif
+
+// Una zona finita. I tempi sono in nanosecondi da Profiler::now()
+struct ProfileZone {
+    const char* name;
+    int64_t     start;
+    int64_t     end;
+    uint16_t    depth;  // 0 = zona più esterna del thread
+    uint16_t    thread; // indice in Profiler::threadNames()
+};
+
+// Tempo GPU di una zona: le query danno solo la durata, non l'inizio
+struct GpuProfileZone {
+    const char* name;
+    int64_t     duration;
+};
+
+struct ProfileFrame {
+    uint64_t number = 0;
+    int64_t  start  = 0;
+    int64_t  end    = 0;
+    std::vector<ProfileZone>    zones; // di tutti i thread, in ordine di fine
+    std::vector<GpuProfileZone> gpu;   // arrivano qualche frame dopo
+};
+
+// Statistiche di una zona sugli ultimi frame, per la tabella del pannello
+struct ProfileZoneStats {
+    std::string name;
+    bool        gpu        = false;
+    bool        mainThread = false; // false = worker (o GPU)
+    double      averageMs  = 0.0;   // tempo totale per frame, in media
+    double      maxMs      = 0.0;   // il frame peggiore
+    double      calls      = 0.0;   // chiamate per frame, in media
+};
+
+class Profiler {
+public:
+    static constexpr int THREAD_BUFFER_SIZE = 1 << 14; // zone per thread tra due raccolte
+    static constexpr int HISTORY_FRAMES     = 240;
+
+    // Orologio monotono in nanosecondi
+    static int64_t now();
+
+    // Solo dal thread principale, una volta per frame: chiude il frame
+    // precedente raccogliendo le zone di tutti i thread
+    static void beginFrame();
+    static uint64_t frameNumber();
+
+    // Frame chiusi, dal più vecchio al più recente
+    static const std::deque<ProfileFrame>& frames();
+
+    // Il tempo GPU di una zona del frame "frame" (se è ancora nello storico)
+    static void addGpuZone(uint64_t frame, const char* name, int64_t duration);
+
+    // Il nome con cui il thread chiamante compare nel pannello e nel trace
+    static void setThreadName(const std::string& name);
+    static std::vector<std::string> threadNames();
+
+    // Somme per zona degli ultimi frameCount frame, le più costose prima
+    static std::vector<ProfileZoneStats> zoneStats(int frameCount);
+
+    // Salva lo storico in formato Chrome trace (JSON)
+    static bool writeChromeTrace(const std::string& path);
+
+    // Usate da ProfileScope
+    static void enterZone();
+    static void leaveZone(const char* name, int64_t start);
+};
+
+// Zona RAII: misura dal costruttore al distruttore
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* name) : name(name), start(Profiler::now()) { Profiler::enterZone(); }
+    ~ProfileScope() { Profiler::leaveZone(name, start); }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    const char* name;
+    int64_t     start;
+};
+
+#define VOXEL_PROFILE_CONCAT_INNER(a, b) a##b
+#define VOXEL_PROFILE_CONCAT(a, b)       VOXEL_PROFILE_CONCAT_INNER(a, b)
+
+#if VOXEL_PROFILING
+#define PROFILE_SCOPE(name)  ProfileScope VOXEL_PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_FRAME()      Profiler::beginFrame()
+#define PROFILE_THREAD(name) Profiler::setThreadName(name)
+#else
+#define PROFILE_SCOPE(name)  ((void)0)
+#define PROFILE_FRAME()      ((void)0)
+#define PROFILE_THREAD(name) ((void)0)
+#endif
@@ -0,0 +1,115 @@
+#include "program_cache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <utility>
+
+// Intestazione di ogni file: la chiave ripetuta dentro protegge da un
+// file rinominato a mano, il checksum da uno scritto a metà
+struct ProgramFileHeader {
+    char     magic[4];  // "VXPB"
+    uint32_t version;
+    uint64_t key;
+    uint32_t format;
+    uint32_t size;      // byte del binario dopo l'intestazione
+    uint64_t checksum;  // FNV-1a del binario
+};
+
+static const char     PROGRAM_MAGIC[4] = { 'V', 'X', 'P', 'B' };
+static const uint32_t PROGRAM_FILE_VERSION = 1;
+
+static const uint64_t FNV_OFFSET = 14695981039346656037ull;
+static const uint64_t FNV_PRIME  = 1099511628211ull;
+
+static uint64_t fnv1a(uint64_t hash, const void* data, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++) hash = (hash ^ bytes[i]) * FNV_PRIME;
+    return hash;
+}
+
+ProgramCache::ProgramCache(std::string directory, std::string driver)
+    : dir(std::move(directory)), driver(std::move(driver)) {
+    std::error_code error;
+    std::filesystem::create_directories(dir, error);
+    if (error) std::cerr << "Impossibile creare " << dir << ": " << error.message() << "\n";
+}
+
+uint64_t ProgramCache::keyOf(const std::string& vertexSource, const std::string& fragmentSource) const {
+    // Uno zero tra i pezzi: "ab" + "c" e "a" + "bc" danno chiavi diverse
+    const uint8_t separator = 0;
+    uint64_t hash = fnv1a(FNV_OFFSET, &PROGRAM_FILE_VERSION, sizeof(PROGRAM_FILE_VERSION));
+    hash = fnv1a(hash, driver.data(), driver.size());
+    hash = fnv1a(hash, &separator, 1);
+    hash = fnv1a(hash, vertexSource.data(), vertexSource.size());
+    hash = fnv1a(hash, &separator, 1);
+    return fnv1a(hash, fragmentSource.data(), fragmentSource.size());
+}
+
+std::string ProgramCache::pathOf(uint64_t key) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+    return (std::filesystem::path(dir) / name).string();
+}
+
+bool ProgramCache::load(uint64_t key, ProgramBinary& binary) {
+    std::ifstream file(pathOf(key), std::ios::binary);
+    ProgramFileHeader header{};
+    bool valid = file && file.read(reinterpret_cast<char*>(&header), sizeof(header))
+              && std::memcmp(header.magic, PROGRAM_MAGIC, sizeof(PROGRAM_MAGIC)) == 0
+              && header.version == PROGRAM_FILE_VERSION && header.key == key && header.size > 0;
+    if (valid) {
+        binary.format = header.format;
+        binary.data.resize(header.size);
+        valid = file.read(reinterpret_cast<char*>(binary.data.data()), header.size)
+             && fnv1a(FNV_OFFSET, binary.data.data(), binary.data.size()) == header.checksum;
+    }
+    if (!valid) {
+        binary = {};
+        missCount++;
+        return false;
+    }
+    hitCount++;
+    return true;
+}
+
+bool ProgramCache::store(uint64_t key, const ProgramBinary& binary) {
+    if (binary.data.empty()) return false;
+
+    ProgramFileHeader header{};
+    std::memcpy(header.magic, PROGRAM_MAGIC, sizeof(PROGRAM_MAGIC));
+    header.version  = PROGRAM_FILE_VERSION;
+    header.key      = key;
+    header.format   = binary.format;
+    header.size     = (uint32_t)binary.data.size();
+    header.checksum = fnv1a(FNV_OFFSET, binary.data.data(), binary.data.size());
+
+    std::string path = pathOf(key);
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file.write(reinterpret_cast<const char*>(&header), sizeof(header))
+            || !file.write(reinterpret_cast<const char*>(binary.data.data()), (std::streamsize)binary.data.size())) {
+            std::cerr << "Impossibile scrivere " << temporary << "\n";
+            return false;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+    if (error) {
+        std::cerr << "Impossibile scrivere " << path << ": " << error.message() << "\n";
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+    return true;
+}
+
+void ProgramCache::reject(uint64_t key) {
+    std::error_code error;
+    std::filesystem::remove(pathOf(key), error);
+    hitCount--;
+    missCount++;
+    rejectCount++;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Un program OpenGL già linkato, come lo restituisce glGetProgramBinary:
+// il formato è un valore del driver, da ripassare a glProgramBinary
+struct ProgramBinary {
+    uint32_t             format = 0;
+    std::vector<uint8_t> data;
+};
+
+// ---------------------------------------------------------------
+// ProgramCache
+// Compilare e linkare gli shader costa decine di millisecondi per
+// program, a volte molto di più: all'avvio è tempo in cui non si
+// vede niente. Il driver però può restituire il program già linkato
+// (glGetProgramBinary) e riprenderlo così com'è (glProgramBinary).
+// Qui quei binari si tengono su disco, un file per program.
+//
+// Il binario vale solo per gli stessi sorgenti e lo stesso driver:
+// la chiave è un hash (FNV-1a a 64 bit) dei due sorgenti e della
+// stringa del driver (vendor, renderer, versione), quindi cambiare
+// uno shader o aggiornare i driver porta semplicemente a un'altra
+// chiave. Un file rovinato (troncato, checksum sbagliato) è una miss;
+// uno che il driver rifiuta si butta con reject(). In tutti i casi si
+// ricompila dai sorgenti e si riscrive.
+//
+// Solo la parte su disco: le chiamate OpenGL le fa Shader. Si usa
+// dal render thread.
+// ---------------------------------------------------------------
+class ProgramCache {
+public:
+    ProgramCache(std::string directory, std::string driver);
+
+    uint64_t keyOf(const std::string& vertexSource, const std::string& fragmentSource) const;
+
+    // false (una miss) se il file non c'è o non è valido
+    bool load(uint64_t key, ProgramBinary& binary);
+
+    // Scrive prima un file temporaneo e poi lo rinomina: un avvio
+    // interrotto a metà non lascia binari troncati
+    bool store(uint64_t key, const ProgramBinary& binary);
+
+    // Il driver non ha accettato il binario caricato: il file si
+    // cancella e il caricamento conta come una miss
+    void reject(uint64_t key);
+
+    int hits() const { return hitCount; }
+    int misses() const { return missCount; }
+    int rejected() const { return rejectCount; }
+
+    const std::string& directory() const { return dir; }
+
+private:
+    std::string pathOf(uint64_t key) const;
+
+    std::string dir;
+    std::string driver;
+    int hitCount = 0, missCount = 0, rejectCount = 0;
+};
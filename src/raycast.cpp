@@ -0,0 +1,279 @@
+#include "raycast.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <thread>
+
+#include "job_system.h"
+#include "profiler.h"
+
+namespace {
+
+constexpr float INF = std::numeric_limits<float>::infinity();
+
+constexpr int WORLD_MIN_Y = WORLD_MIN_CHUNK_Y * CHUNK_SIZE;
+constexpr int WORLD_END_Y = (WORLD_MAX_CHUNK_Y + 1) * CHUNK_SIZE;
+
+// Blocchi letti dai chunk con una cache locale dell'ultimo chunk:
+// a differenza di World::getBlock non scrive niente nel World, quindi
+// più thread possono fare query insieme
+struct VoxelQuery {
+    const World& world;
+    ChunkPos     lastPos   = { INT32_MIN, INT32_MIN, INT32_MIN };
+    const Chunk* lastChunk = nullptr;
+
+    explicit VoxelQuery(const World& world) : world(world) {}
+
+    const Chunk* chunk(const ChunkPos& pos) {
+        if (!(pos == lastPos)) {
+            lastPos   = pos;
+            lastChunk = world.findChunk(pos);
+        }
+        return lastChunk;
+    }
+
+    bool solid(int x, int y, int z) {
+        const Chunk* c = chunk(World::toChunkPos(x, y, z));
+        return c && isSolid(c->getBlock(x & CHUNK_MASK, y & CHUNK_MASK, z & CHUNK_MASK));
+    }
+};
+
+// Quello che serve al DDA, calcolato una volta per raggio
+struct RaySetup {
+    float      origin[3];
+    float      invDir[3];
+    int        step[3];
+    glm::ivec3 voxel;
+    float      maxDistance;
+
+    explicit RaySetup(const Ray& ray) : maxDistance(ray.maxDistance) {
+        float length = glm::length(ray.direction);
+        glm::vec3 dir = length > 0.0f ? ray.direction / length : glm::vec3(0.0f);
+        glm::vec3 start = glm::floor(ray.origin);
+        voxel = glm::ivec3((int)start.x, (int)start.y, (int)start.z);
+        for (int a = 0; a < 3; a++) {
+            origin[a] = ray.origin[a];
+            step[a]   = dir[a] > 0.0f ? 1 : (dir[a] < 0.0f ? -1 : 0);
+            invDir[a] = step[a] != 0 ? 1.0f / dir[a] : INF;
+        }
+    }
+
+    // Distanza a cui il raggio esce dal blocco "cell" lungo l'asse a.
+    // Sempre calcolata da capo, mai accumulata: il salto dei brick e il
+    // passo singolo ottengono gli stessi identici valori.
+    float exitDistance(int a, int cell) const {
+        if (step[a] == 0) return INF;
+        float face = (float)(cell + (step[a] > 0 ? 1 : 0));
+        return (face - origin[a]) * invDir[a];
+    }
+
+    // Sopra o sotto il mondo e in allontanamento: non colpirà più niente
+    bool leftWorld() const {
+        return (voxel.y < WORLD_MIN_Y && step[1] <= 0) || (voxel.y >= WORLD_END_Y && step[1] >= 0);
+    }
+};
+
+RayHit makeHit(const glm::ivec3& block, int axis, int step, float distance, BlockID id) {
+    RayHit hit;
+    hit.hit      = true;
+    hit.block    = block;
+    hit.distance = distance;
+    hit.id       = id;
+    if (axis >= 0) hit.normal[axis] = -step;
+    return hit;
+}
+
+} // namespace
+
+// ---------------------------------------------------------------
+// Versione di riferimento: un blocco alla volta. Si attraversa la
+// faccia più vicina; a parità di distanza vince l'asse più basso (x).
+// ---------------------------------------------------------------
+RayHit raycastNaive(const World& world, const Ray& ray) {
+    RaySetup r(ray);
+    int   axis = -1;
+    float t    = 0.0f;
+
+    while (!r.leftWorld()) {
+        BlockID id = world.getBlock(r.voxel.x, r.voxel.y, r.voxel.z);
+        if (isSolid(id)) return makeHit(r.voxel, axis, axis >= 0 ? r.step[axis] : 0, t, id);
+
+        axis = 0;
+        t    = r.exitDistance(0, r.voxel.x);
+        for (int a = 1; a < 3; a++) {
+            float ta = r.exitDistance(a, r.voxel[a]);
+            if (ta < t) { t = ta; axis = a; }
+        }
+        if (t > r.maxDistance) break; // anche direzione nulla: t = INF
+        r.voxel[axis] += r.step[axis];
+    }
+    return {};
+}
+
+// ---------------------------------------------------------------
+// Versione con salto dello spazio vuoto. Ad ogni passo il blocco
+// corrente sta in una "cella" allineata:
+//   - chunk non caricato o vuoto → cella di 16³
+//   - brick vuoto nella maschera del chunk → cella di 4³
+//   - altrimenti il blocco stesso (1³), che si legge
+// Una cella vuota si attraversa in un colpo solo: l'asse di uscita è
+// quello con la faccia della cella più vicina (t = tExit), e sugli altri
+// assi si fanno tutti i passi che il DDA singolo farebbe prima di uscire,
+// cioè quelli con t < tExit o t == tExit su un asse più basso.
+// ---------------------------------------------------------------
+RayHit raycast(const World& world, const Ray& ray) {
+    RaySetup   r(ray);
+    VoxelQuery query(world);
+    int   axis = -1;
+    float t    = 0.0f;
+
+    while (!r.leftWorld()) {
+        const Chunk* chunk = query.chunk(World::toChunkPos(r.voxel.x, r.voxel.y, r.voxel.z));
+        int size = CHUNK_SIZE;
+        if (chunk && !chunk->isEmpty()) {
+            int x = r.voxel.x & CHUNK_MASK, y = r.voxel.y & CHUNK_MASK, z = r.voxel.z & CHUNK_MASK;
+            size = BRICK_SIZE;
+            if (chunk->brickOccupied(x, y, z)) {
+                BlockID id = chunk->getBlock(x, y, z);
+                if (isSolid(id)) return makeHit(r.voxel, axis, axis >= 0 ? r.step[axis] : 0, t, id);
+                size = 1;
+            }
+        }
+
+        // Ultimo blocco della cella lungo il raggio e distanza di uscita
+        int last[3];
+        axis = -1;
+        t    = INF;
+        for (int a = 0; a < 3; a++) {
+            int base = r.voxel[a] & ~(size - 1);
+            last[a]  = r.step[a] > 0 ? base + size - 1 : base;
+            float ta = r.exitDistance(a, last[a]);
+            if (axis < 0 || ta < t) { t = ta; axis = a; }
+        }
+        if (t > r.maxDistance) break;
+
+        for (int a = 0; a < 3; a++) {
+            if (a == axis) continue;
+            while (r.voxel[a] != last[a]) {
+                float ta = r.exitDistance(a, r.voxel[a]);
+                if (ta < t || (ta == t && a < axis)) r.voxel[a] += r.step[a];
+                else break;
+            }
+        }
+        r.voxel[axis] = last[axis] + r.step[axis];
+    }
+    return {};
+}
+
+void raycastBatch(const World& world, const Ray* rays, RayHit* hits, int count, JobSystem* jobs) {
+    PROFILE_SCOPE("Raycast batch");
+
+    // Abbastanza raggi per job da ripagare la coda, pochi abbastanza
+    // da dividere bene anche qualche migliaio di raggi
+    constexpr int BATCH = 256;
+    int batches = (count + BATCH - 1) / BATCH;
+
+    if (!jobs || jobs->workerCount() == 0 || batches <= 1) {
+        for (int i = 0; i < count; i++) hits[i] = raycast(world, rays[i]);
+        return;
+    }
+
+    // I blocchi si prendono da un contatore: chi arriva prima lavora.
+    // Lo stato è condiviso perché un job può partire dopo che la
+    // chiamata è già finita (trova il contatore esaurito ed esce).
+    struct BatchState {
+        std::atomic<int> next{ 0 };
+        std::atomic<int> done{ 0 };
+    };
+    auto state = std::make_shared<BatchState>();
+    const World* w = &world;
+
+    auto work = [state, w, rays, hits, count, batches]() {
+        for (;;) {
+            int batch = state->next.fetch_add(1, std::memory_order_relaxed);
+            if (batch >= batches) return;
+            int end = std::min(count, (batch + 1) * BATCH);
+            for (int i = batch * BATCH; i < end; i++) hits[i] = raycast(*w, rays[i]);
+            state->done.fetch_add(1, std::memory_order_release);
+        }
+    };
+
+    // Priorità negativa: davanti alla generazione dei chunk
+    int helpers = std::min(jobs->workerCount(), batches - 1);
+    for (int i = 0; i < helpers; i++) jobs->submit(work, -1.0f);
+
+    work();
+    while (state->done.load(std::memory_order_acquire) < batches) std::this_thread::yield();
+}
+
+// ---------------------------------------------------------------
+// Sweep del box: per ogni asse si guardano gli strati di blocchi che
+// la faccia davanti attraverserebbe, dal più vicino. Ogni strato è la
+// sezione del box sugli altri due assi; il primo con un blocco pieno
+// ferma il box a EPS dalla sua faccia.
+// ---------------------------------------------------------------
+SweepResult sweepAabb(const World& world, Aabb& box, const glm::vec3& motion) {
+    // Distanza lasciata dalle pareti: il box non le tocca mai, quindi
+    // scorrendoci accanto non le conta nella sua sezione
+    constexpr float EPS = 1e-3f;
+    constexpr int   ORDER[3] = { 1, 0, 2 }; // prima y: appoggiarsi al suolo, poi muoversi
+
+    VoxelQuery  query(world);
+    SweepResult result;
+
+    for (int a : ORDER) {
+        float d = motion[a];
+        if (d == 0.0f) continue;
+
+        int b = (a + 1) % 3, c = (a + 2) % 3;
+        int b0 = (int)std::floor(box.min[b]), b1 = (int)std::ceil(box.max[b]) - 1;
+        int c0 = (int)std::floor(box.min[c]), c1 = (int)std::ceil(box.max[c]) - 1;
+
+        auto layerSolid = [&](int k) {
+            glm::ivec3 p;
+            p[a] = k;
+            for (p[b] = b0; p[b] <= b1; p[b]++)
+                for (p[c] = c0; p[c] <= c1; p[c]++)
+                    if (query.solid(p.x, p.y, p.z)) return true;
+            return false;
+        };
+
+        if (d > 0.0f) {
+            int first = (int)std::ceil(box.max[a]);
+            int end   = (int)std::ceil(box.max[a] + d);
+            for (int k = first; k < end; k++)
+                if (layerSolid(k)) {
+                    d = std::max((float)k - EPS - box.max[a], 0.0f);
+                    result.blocked[a] = true;
+                    break;
+                }
+        } else {
+            int first = (int)std::floor(box.min[a]) - 1;
+            int end   = (int)std::floor(box.min[a] + d);
+            for (int k = first; k >= end; k--)
+                if (layerSolid(k)) {
+                    d = std::min((float)(k + 1) + EPS - box.min[a], 0.0f);
+                    result.blocked[a] = true;
+                    break;
+                }
+        }
+
+        box.min[a] += d;
+        box.max[a] += d;
+        result.moved[a] = d;
+    }
+    return result;
+}
+
+bool overlapsSolid(const World& world, const Aabb& box) {
+    VoxelQuery query(world);
+    glm::vec3 min = glm::floor(box.min);
+    for (int y = (int)min.y; y < (int)std::ceil(box.max.y); y++)
+        for (int z = (int)min.z; z < (int)std::ceil(box.max.z); z++)
+            for (int x = (int)min.x; x < (int)std::ceil(box.max.x); x++)
+                if (query.solid(x, y, z)) return true;
+    return false;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "block.h"
+#include "world.h"
+
+class JobSystem;
+
+// ---------------------------------------------------------------
+// Raggio nel mondo: parte da origin e va lungo direction (non serve
+// che sia normalizzata) per al più maxDistance blocchi.
+// ---------------------------------------------------------------
+struct Ray {
+    glm::vec3 origin{ 0.0f };
+    glm::vec3 direction{ 0.0f, 0.0f, -1.0f };
+    float     maxDistance = 8.0f;
+
+    // Il segmento da from a to: utile per la linea di vista, c'è se
+    // il raggio non colpisce niente
+    static Ray between(const glm::vec3& from, const glm::vec3& to) {
+        return { from, to - from, glm::length(to - from) };
+    }
+};
+
+struct RayHit {
+    bool       hit = false;
+    glm::ivec3 block{ 0 };  // blocco colpito
+    glm::ivec3 normal{ 0 }; // faccia da cui è entrato il raggio (0 se partiva già dentro)
+    float      distance = 0.0f;
+    BlockID    id = BLOCK_AIR;
+};
+
+// ---------------------------------------------------------------
+// Raycast DDA (Amanatides e Woo)
+// Il raggio passa da un blocco al vicino attraversando ogni volta la
+// faccia più vicina: per ogni asse basta sapere a che distanza si
+// trova il prossimo piano intero. raycastNaive legge ogni blocco con
+// World::getBlock; raycast salta lo spazio vuoto a due livelli, un
+// chunk (16³) non caricato o vuoto e un brick (4³) vuoto, guardando
+// la maschera dei brick del chunk. I due danno esattamente lo stesso
+// risultato: il salto ripete gli stessi confronti del passo singolo.
+//
+// Colpisce i blocchi solidi (isSolid). Il mondo fuori dai chunk
+// caricati è aria; il raggio si ferma quando esce dall'altezza del mondo.
+// ---------------------------------------------------------------
+RayHit raycastNaive(const World& world, const Ray& ray);
+RayHit raycast(const World& world, const Ray& ray);
+
+// Molti raggi insieme (picking, linea di vista, sonde per la luce).
+// Con un JobSystem i raggi si dividono a blocchi tra i worker e il
+// thread chiamante, che ritorna quando hits[0..count) sono pronti.
+// Il mondo non deve cambiare finché la chiamata non è finita.
+void raycastBatch(const World& world, const Ray* rays, RayHit* hits, int count, JobSystem* jobs = nullptr);
+
+// ---------------------------------------------------------------
+// Collisione con box allineato agli assi (il giocatore)
+// sweepAabb sposta box di motion un asse alla volta (y, poi x, poi z)
+// e si ferma poco prima del primo strato di blocchi pieni sul
+// percorso, così il box scivola lungo le pareti. I blocchi che il box
+// tocca già non lo fermano: se ci finisce dentro può uscirne.
+// ---------------------------------------------------------------
+struct Aabb {
+    glm::vec3 min{ 0.0f };
+    glm::vec3 max{ 0.0f };
+
+    // Due box che si toccano solo su una faccia non si intersecano
+    bool intersects(const Aabb& other) const {
+        return min.x < other.max.x && other.min.x < max.x
+            && min.y < other.max.y && other.min.y < max.y
+            && min.z < other.max.z && other.min.z < max.z;
+    }
+};
+
+struct SweepResult {
+    glm::vec3 moved{ 0.0f };                      // spostamento applicato
+    bool      blocked[3] = { false, false, false }; // assi fermati da un blocco
+};
+
+SweepResult sweepAabb(const World& world, Aabb& box, const glm::vec3& motion);
+
+// true se il box tocca almeno un blocco pieno
+bool overlapsSolid(const World& world, const Aabb& box);
@@ -0,0 +1,111 @@
+#include "region_file.h"
+
+#include <cstring>
+#include <iostream>
+#include <mutex>
+
+#include <lz4.h>
+
+bool RegionFile::open(const std::string& path) {
+    if (!file.open(path)) return false;
+
+    if (file.size() == 0) {
+        // File nuovo: header vuoto
+        std::vector<uint8_t> header(HEADER_SECTORS * SECTOR_SIZE, 0);
+        std::memcpy(header.data(), &MAGIC, 4);
+        std::memcpy(header.data() + 4, &VERSION, 4);
+        if (!file.write(0, header.data(), header.size())) return false;
+    }
+
+    uint32_t magic, version;
+    std::memcpy(&magic, file.data(), 4);
+    std::memcpy(&version, file.data() + 4, 4);
+    if (file.size() < HEADER_BYTES || magic != MAGIC || version != VERSION) {
+        std::cerr << "Region file non valido: " << path << "\n";
+        return false;
+    }
+    std::memcpy(entries, file.data() + 8, sizeof(entries));
+
+    // Quali settori sono occupati: l'header più quelli dei chunk salvati
+    usedSectors.assign((file.size() + SECTOR_SIZE - 1) / SECTOR_SIZE, false);
+    markSectors(0, (uint32_t)HEADER_SECTORS, true);
+    for (Entry& entry : entries) {
+        if (entry.sector == 0) continue;
+        if ((size_t)entry.sector + sectorsFor(entry.bytes) > usedSectors.size()) {
+            entry = Entry(); // punta oltre la fine del file: lo scartiamo
+            continue;
+        }
+        markSectors(entry.sector, sectorsFor(entry.bytes), true);
+    }
+    return true;
+}
+
+bool RegionFile::loadChunk(int index, Chunk& chunk) const {
+    std::shared_lock lock(mutex);
+    const Entry& entry = entries[index];
+    if (entry.sector == 0 || entry.bytes < 4) return false;
+
+    const uint8_t* stored = file.data() + (size_t)entry.sector * SECTOR_SIZE;
+    uint32_t rawSize;
+    std::memcpy(&rawSize, stored, 4);
+    if (rawSize > Chunk::MAX_SERIALIZED_SIZE) return false;
+
+    // Un buffer per thread: i worker caricano chunk in parallelo
+    thread_local uint8_t raw[Chunk::MAX_SERIALIZED_SIZE];
+    int size = LZ4_decompress_safe((const char*)stored + 4, (char*)raw, (int)entry.bytes - 4, (int)rawSize);
+    if (size != (int)rawSize) return false;
+    return chunk.deserialize(raw, rawSize);
+}
+
+bool RegionFile::writeChunk(int index, const uint8_t* compressed, uint32_t compressedSize, uint32_t rawSize) {
+    std::unique_lock lock(mutex);
+    Entry& entry = entries[index];
+    uint32_t bytes   = 4 + compressedSize;
+    uint32_t sectors = sectorsFor(bytes);
+
+    // Sempre settori nuovi: quelli vecchi restano occupati finché la
+    // tabella punta a loro, così allocate() non può restituirli
+    uint32_t first = allocate(sectors);
+    markSectors(first, sectors, true);
+
+    // Prima i dati, poi la tabella, e solo alla fine si liberano i
+    // settori vecchi: se il gioco si chiude a metà, l'header punta
+    // ancora a dati completi (i vecchi o i nuovi)
+    size_t offset = (size_t)first * SECTOR_SIZE;
+    Entry  updated = { first, bytes };
+    if (!file.write(offset, &rawSize, 4) || !file.write(offset + 4, compressed, compressedSize)
+        || !file.write(8 + index * sizeof(Entry), &updated, sizeof(Entry))) {
+        std::cerr << "Errore di scrittura nel region file\n";
+        markSectors(first, sectors, false);
+        return false;
+    }
+
+    if (entry.sector) markSectors(entry.sector, sectorsFor(entry.bytes), false);
+    entry = updated;
+    return true;
+}
+
+bool RegionFile::hasChunk(int index) const {
+    std::shared_lock lock(mutex);
+    return entries[index].sector != 0;
+}
+
+size_t RegionFile::fileSize() const {
+    std::shared_lock lock(mutex);
+    return file.size();
+}
+
+uint32_t RegionFile::allocate(uint32_t sectors) {
+    // First fit: il primo buco abbastanza grande, se no in fondo al file
+    uint32_t run = 0;
+    for (uint32_t i = (uint32_t)HEADER_SECTORS; i < (uint32_t)usedSectors.size(); i++) {
+        run = usedSectors[i] ? 0 : run + 1;
+        if (run == sectors) return i + 1 - sectors;
+    }
+    return (uint32_t)usedSectors.size() - run;
+}
+
+void RegionFile::markSectors(uint32_t first, uint32_t count, bool used) {
+    if (first + count > usedSectors.size()) usedSectors.resize(first + count, false);
+    for (uint32_t i = 0; i < count; i++) usedSectors[first + i] = used;
+}
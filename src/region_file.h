@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+#include "mapped_file.h"
+#include "world.h"
+
+// ---------------------------------------------------------------
+// Una regione è un cubo di 8x8x8 chunk salvato in un solo file:
+// con l'altezza del mondo attuale (8 chunk) una regione copre tutta
+// la colonna, e 512 chunk per file evitano di avere migliaia di file
+// piccoli (lenti da aprire e sprecati sul disco).
+// ---------------------------------------------------------------
+constexpr int REGION_SHIFT  = 3;
+constexpr int REGION_SIZE   = 1 << REGION_SHIFT; // 8 chunk per lato
+constexpr int REGION_MASK   = REGION_SIZE - 1;
+constexpr int REGION_CHUNKS = REGION_SIZE * REGION_SIZE * REGION_SIZE;
+
+// ---------------------------------------------------------------
+// RegionFile
+// Formato del file:
+//
+//   header  "CVXR", versione, poi per ogni chunk della regione
+//           { primo settore, byte occupati } (0 = chunk non salvato)
+//   dati    chunk compressi con LZ4, ognuno in settori consecutivi
+//           da 256 byte: { uint32 byte non compressi, dati LZ4 }
+//
+// I settori piccoli tengono basso lo spazio sprecato (un chunk di
+// terreno compresso occupa poche centinaia di byte). Un chunk
+// risalvato va sempre in settori liberi, cercati come un piccolo
+// allocatore; i suoi settori vecchi si liberano dopo aver aggiornato
+// la tabella, così non si scrive mai sopra l'unica copia buona.
+//
+// La lettura passa dalla mappatura del file: trovare un chunk è un
+// accesso alla tabella, e LZ4 decomprime direttamente dalle pagine
+// del file. Letture in parallelo sì, scritture una alla volta.
+// ---------------------------------------------------------------
+class RegionFile {
+public:
+    static constexpr uint32_t MAGIC       = 0x52585643; // "CVXR"
+    static constexpr uint32_t VERSION     = 1;
+    static constexpr size_t   SECTOR_SIZE = 256;
+
+    bool open(const std::string& path);
+
+    // Indice del chunk nella tabella, da coordinate locali alla regione (0..7)
+    static int localIndex(int x, int y, int z) {
+        return (y * REGION_SIZE + z) * REGION_SIZE + x;
+    }
+
+    // Carica il chunk; false se non è mai stato salvato o se i dati sono rovinati
+    bool loadChunk(int index, Chunk& chunk) const;
+
+    // Salva un chunk già compresso: compressed sono i dati LZ4 di un
+    // chunk serializzato di rawSize byte
+    bool writeChunk(int index, const uint8_t* compressed, uint32_t compressedSize, uint32_t rawSize);
+
+    bool   hasChunk(int index) const;
+    size_t fileSize() const;
+
+private:
+    struct Entry {
+        uint32_t sector = 0; // 0 = nessun chunk (il settore 0 è dell'header)
+        uint32_t bytes  = 0;
+    };
+
+    static constexpr size_t HEADER_BYTES   = 8 + REGION_CHUNKS * sizeof(Entry);
+    static constexpr size_t HEADER_SECTORS = (HEADER_BYTES + SECTOR_SIZE - 1) / SECTOR_SIZE;
+
+    static uint32_t sectorsFor(uint32_t bytes) { return (uint32_t)((bytes + SECTOR_SIZE - 1) / SECTOR_SIZE); }
+    uint32_t allocate(uint32_t sectors);
+    void     markSectors(uint32_t first, uint32_t count, bool used);
+
+    MappedFile        file;
+    Entry             entries[REGION_CHUNKS];
+    std::vector<bool> usedSectors; // un bit per settore del file
+    mutable std::shared_mutex mutex;
+};
@@ -0,0 +1,207 @@
+#include "replay.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "block_registry.h"
+#include "camera.h"
+#include "chunk_pipeline.h"
+#include "chunk_streamer.h"
+#include "culling.h"
+#include "game_settings.h"
+#include "job_system.h"
+#include "light.h"
+#include "lod.h"
+#include "profiler.h"
+#include "terrain.h"
+#include "world.h"
+
+// ---------------------------------------------------------------
+// FrameLog
+// ---------------------------------------------------------------
+
+bool FrameLog::writeCsv(const std::string& path) const {
+    std::ofstream file(path, std::ios::trunc);
+    if (!file) {
+        std::cerr << "Impossibile scrivere " << path << "\n";
+        return false;
+    }
+    file << "frame,frame_ms,wait_ms,ticks,loaded_chunks,mesh_uploads,visible_chunks,lod_nodes,jobs_in_flight\n";
+    for (size_t i = 0; i < log.size(); i++) {
+        const ReplayFrame& f = log[i];
+        file << i << ',' << f.frameMs << ',' << f.waitMs << ',' << f.ticks << ',' << f.loadedChunks << ','
+             << f.meshUploads << ',' << f.visibleChunks << ',' << f.lodNodes << ',' << f.jobsInFlight << '\n';
+    }
+    return (bool)file;
+}
+
+std::string FrameLog::summary() const {
+    if (log.empty()) return "0 frames";
+
+    std::vector<float> times;
+    double total = 0.0, waited = 0.0;
+    long long ticks = 0;
+    for (const ReplayFrame& f : log) {
+        times.push_back(f.frameMs);
+        total  += f.frameMs;
+        waited += f.waitMs;
+        ticks  += f.ticks;
+    }
+    std::sort(times.begin(), times.end());
+    auto percentile = [&times](double p) { return times[std::min(times.size() - 1, (size_t)(p * times.size()))]; };
+
+    char line[256];
+    std::snprintf(line, sizeof(line),
+                  "%zu frames in %.2f s (%.1f FPS), frame p50 %.2f ms p99 %.2f ms max %.2f ms, %lld ticks, %.1f ms waiting for chunks",
+                  log.size(), total / 1000.0, log.size() * 1000.0 / std::max(total, 1e-9), percentile(0.5),
+                  percentile(0.99), times.back(), ticks, waited);
+    return line;
+}
+
+// ---------------------------------------------------------------
+// Rigiocare senza finestra
+// ---------------------------------------------------------------
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+float millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+}
+
+// Quello che il game loop ha sulla CPU, con le stesse impostazioni
+struct HeadlessGame {
+    World            world;
+    TerrainGenerator terrain;
+    ChunkPipeline    pipeline;
+    LightEngine      light{ world };
+    LodManager       lod;
+    ChunkStreamer    streamer;
+    ChunkCuller      culler;
+
+    std::vector<ChunkPos> staleMeshes, evictedMeshes, visibleChunks;
+    std::vector<LodNode>  removedLodNodes, visibleLodNodes;
+    LodManager::ChunkMeshedFn chunkMeshed;
+
+    HeadlessGame(JobSystem& jobs, uint32_t seed)
+        : terrain(seed)
+        , pipeline(jobs, world, [this](const ChunkPos& pos, Chunk& chunk) { terrain.generate(pos, chunk); })
+        , lod(jobs, terrain, { LOD_LEVELS, RENDER_DISTANCE })
+        , streamer(world, pipeline, STREAMING)
+        , chunkMeshed([this](const ChunkPos& pos) { return pipeline.isMeshed(pos); })
+    {
+        pipeline.setInsertedCallback([this](const ChunkPos& pos) { light.onChunkLoaded(pos); });
+    }
+
+    // LOD, streaming, chunk da rimeshare e mesh finite, come in main.
+    // Restituisce le mesh di chunk consegnate.
+    int updateWorld(const glm::vec3& cameraPosition, float deltaTime) {
+        lod.update(cameraPosition, chunkMeshed);
+        streamer.update(cameraPosition, deltaTime, detailColumns(lod.selection()));
+        world.takeMeshDirtyChunks(staleMeshes);
+        for (const ChunkPos& pos : staleMeshes) pipeline.requestMesh(pos);
+
+        int uploads = streamer.uploadMeshes([this](const ChunkPos& pos, const ChunkMesh& mesh) {
+            culler.setChunk(pos, mesh.visibility, !mesh.empty());
+        }, MAX_UPLOADS_PER_FRAME);
+        streamer.takeEvictedMeshes(evictedMeshes);
+        for (const ChunkPos& pos : evictedMeshes) culler.removeChunk(pos);
+        lod.consumeMeshes([](const LodNode&, const ChunkMesh&) {}, MAX_LOD_UPLOADS_PER_FRAME);
+        lod.takeRemoved(removedLodNodes);
+        return uploads;
+    }
+
+    void cull(const Camera& camera) {
+        float viewDistance = lod.selection().viewDistance();
+        glm::mat4 projection = glm::perspective(glm::radians(camera.fov), (float)SCREEN_WIDTH / (float)SCREEN_HEIGHT,
+                                                0.1f, viewDistance * 1.5f);
+        Frustum frustum = Frustum::fromMatrix(projection * camera.getViewMatrix());
+        culler.cull(frustum, camera.position, RENDER_DISTANCE + 2, visibleChunks);
+        std::erase_if(visibleChunks, [this](const ChunkPos& pos) { return lod.covers(pos); });
+        streamer.touch(visibleChunks);
+        lod.cull(frustum, visibleLodNodes);
+    }
+};
+
+} // namespace
+
+ReplayResult replayHeadless(const InputRecording& recording, JobSystem& jobs, FrameLog* log) {
+    PROFILE_SCOPE("Replay");
+    ReplayResult result;
+    if (!checkBlockTypes(recording)) return result;
+
+    auto game = std::make_unique<HeadlessGame>(jobs, recording.seed);
+    Camera camera(recording.spawn, recording.yaw, recording.pitch);
+    camera.fov = recording.fov;
+
+    // Schermata di caricamento: il terreno attorno allo spawn
+    auto loadingStart = Clock::now();
+    const int spawnX = (int)std::floor(recording.spawn.x / CHUNK_SIZE);
+    const int spawnZ = (int)std::floor(recording.spawn.z / CHUNK_SIZE);
+    auto spawnReady = [&] {
+        for (int dz = -SPAWN_READY_RADIUS; dz <= SPAWN_READY_RADIUS; dz++)
+            for (int dx = -SPAWN_READY_RADIUS; dx <= SPAWN_READY_RADIUS; dx++)
+                if (!game->pipeline.isColumnMeshed(spawnX + dx, spawnZ + dz)) return false;
+        return true;
+    };
+    while (!spawnReady()) {
+        game->updateWorld(camera.position, 0.0f);
+        std::this_thread::yield();
+    }
+    result.loadingSeconds = std::chrono::duration<double>(Clock::now() - loadingStart).count();
+
+    Simulation        simulation(game->world, game->light, recording.spawn, recording.tickRate, &jobs);
+    SimulationStepper stepper(simulation);
+    InputMapper       mapper;
+
+    // Prima di un tick il mondo attorno al giocatore deve esserci tutto
+    float waitMs = 0.0f;
+    auto waitForArea = [&](const glm::vec3& eye) {
+        if (isSimulationAreaLoaded(game->world, eye)) return;
+        PROFILE_SCOPE("Wait for chunks");
+        auto start = Clock::now();
+        while (!isSimulationAreaLoaded(game->world, eye)) {
+            game->streamer.update(camera.position, 0.0f, detailColumns(game->lod.selection()));
+            std::this_thread::yield();
+        }
+        waitMs += millisecondsSince(start);
+    };
+
+    auto start = Clock::now();
+    for (const InputFrame& input : recording.frames) {
+        auto frameStart = Clock::now();
+        waitMs = 0.0f;
+
+        ReplayFrame frame;
+        frame.ticks = stepper.advance(mapper.apply(input, camera), input.deltaTime(), waitForArea);
+        camera.position = stepper.snapshot().eyeAt(stepper.alpha());
+
+        frame.meshUploads = game->updateWorld(camera.position, input.deltaTime());
+        game->cull(camera);
+
+        frame.frameMs       = millisecondsSince(frameStart);
+        frame.waitMs        = waitMs;
+        frame.loadedChunks  = game->world.chunkCount();
+        frame.visibleChunks = (int)game->visibleChunks.size();
+        frame.lodNodes      = (int)game->visibleLodNodes.size();
+        frame.jobsInFlight  = game->pipeline.jobsInFlight();
+        if (log) log->add(frame);
+        result.ticks += frame.ticks;
+        result.frames++;
+    }
+    result.seconds    = std::chrono::duration<double>(Clock::now() - start).count();
+    result.finalState = simulation.stateHash();
+    result.finalPosition = simulation.player().position;
+
+    // I worker finiscono quello che resta prima che il mondo sparisca
+    jobs.waitIdle();
+    return result;
+}
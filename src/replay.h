@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "input_recording.h"
+
+class JobSystem;
+
+// ---------------------------------------------------------------
+// Tempi e contatori di un frame di una partita registrata o rigiocata,
+// per confrontare le prestazioni tra due build sullo stesso percorso
+// ---------------------------------------------------------------
+struct ReplayFrame {
+    float frameMs       = 0.0f; // tutto il frame
+    float waitMs        = 0.0f; // di cui ad aspettare i chunk attorno al giocatore
+    int   ticks         = 0;    // tick della simulazione fatti nel frame
+    int   loadedChunks  = 0;
+    int   meshUploads   = 0;    // mesh di chunk consegnate (caricate sulla GPU, con la finestra)
+    int   visibleChunks = 0;    // dopo frustum e occlusion culling
+    int   lodNodes      = 0;    // nodi LOD nel frustum
+    int   jobsInFlight  = 0;
+};
+
+class FrameLog {
+public:
+    void add(const ReplayFrame& frame) { log.push_back(frame); }
+    const std::vector<ReplayFrame>& frames() const { return log; }
+
+    // Un frame per riga, con l'intestazione delle colonne
+    bool writeCsv(const std::string& path) const;
+
+    // Frame, FPS, tempi del frame (p50/p99/max), tick e attese, su una riga
+    std::string summary() const;
+
+private:
+    std::vector<ReplayFrame> log;
+};
+
+// ---------------------------------------------------------------
+// Rigioca una partita senza finestra né GPU, più veloce che si può:
+// lo stesso mondo (dal seed, mai dai salvataggi), la stessa camera
+// mossa dagli stessi InputFrame, la simulazione a tick fissi
+// (SimulationStepper) e quello che il game loop fa sulla CPU ogni
+// frame: LOD, streaming, luce, meshing sui worker e culling, con le
+// impostazioni di game_settings.h. Solo le mesh non vanno da nessuna
+// parte.
+//
+// Prima del primo frame aspetta il terreno attorno allo spawn, come
+// la schermata di caricamento del gioco. Con tipi di blocco diversi da
+// quelli della registrazione non rigioca niente (frames == 0).
+// ---------------------------------------------------------------
+struct ReplayResult {
+    int       frames         = 0;
+    long long ticks          = 0;
+    double    seconds        = 0.0; // tempo vero, senza il caricamento
+    double    loadingSeconds = 0.0;
+    uint64_t  finalState     = 0;   // Simulation::stateHash() dopo l'ultimo frame
+    glm::vec3 finalPosition{ 0.0f }; // del giocatore dopo l'ultimo frame
+
+    // Lo stato finale è quello della partita registrata (se lo conosce)
+    bool matches(const InputRecording& recording) const {
+        return recording.finalState == 0 || recording.finalState == finalState;
+    }
+};
+
+ReplayResult replayHeadless(const InputRecording& recording, JobSystem& jobs, FrameLog* log = nullptr);
@@ -0,0 +1,69 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "block_registry.h"
+#include "job_system.h"
+#include "replay.h"
+
+// ---------------------------------------------------------------
+// voxel_replay
+// Rigioca una partita registrata con "voxel_game --record FILE" senza
+// finestra, più veloce che si può: la stessa camera, gli stessi tick e
+// lo stesso lavoro di streaming, LOD, meshing e culling del gioco.
+// Stampa un riassunto dei tempi, salva quelli di ogni frame (--csv) e
+// controlla che la partita sia finita come quella registrata: esce
+// con 1 se no.
+// ---------------------------------------------------------------
+
+static void usage(const char* program) {
+    std::fprintf(stderr, "usage: %s SESSION [--csv FILE] [--workers N] [--blocks FILE]\n", program);
+}
+
+int main(int argc, char** argv) {
+    const char* session = nullptr;
+    const char* csv     = nullptr;
+    const char* blocks  = nullptr; // gli stessi tipi di blocco di chi ha registrato
+    int workers = 0;               // 0: quanti ne sceglie il JobSystem
+
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--csv") == 0 && hasValue)          csv = argv[++i];
+        else if (std::strcmp(argv[i], "--workers") == 0 && hasValue) workers = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--blocks") == 0 && hasValue)  blocks = argv[++i];
+        else if (argv[i][0] != '-' && !session)                      session = argv[i];
+        else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (!session) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    if (blocks) std::printf("%d block types from %s\n", loadBlockDefinitions(blocks), blocks);
+
+    InputRecording recording;
+    if (!loadInputRecording(session, recording) || !checkBlockTypes(recording)) return 2;
+    std::printf("voxel_replay: %zu frames, %.1f s recorded, seed %u, %d Hz\n",
+                recording.frames.size(), recording.seconds(), recording.seed, recording.tickRate);
+
+    JobSystem    jobs(workers);
+    FrameLog     log;
+    ReplayResult result = replayHeadless(recording, jobs, &log);
+
+    std::printf("loading %.2f s, replay %.2f s on %d workers\n", result.loadingSeconds, result.seconds,
+                jobs.workerCount());
+    std::printf("%s\n", log.summary().c_str());
+    if (csv && log.writeCsv(csv)) std::printf("per-frame timings in %s\n", csv);
+
+    if (recording.finalState == 0) {
+        std::printf("final state %016llx (the recording has none to compare)\n", (unsigned long long)result.finalState);
+        return 0;
+    }
+    bool same = result.matches(recording);
+    std::printf("final state %016llx, recorded %016llx: %s\n", (unsigned long long)result.finalState,
+                (unsigned long long)recording.finalState, same ? "match" : "MISMATCH");
+    return same ? 0 : 1;
+}
@@ -0,0 +1,420 @@
+#include "server.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "job_system.h"
+#include "material.h"
+#include "profiler.h"
+#include "raycast.h"
+
+// Entità di un giocatore: dove sta il corpo rispetto agli occhi e con
+// che aspetto lo vedono gli altri
+static const glm::vec3 PLAYER_BODY_OFFSET = glm::vec3(0.0f, -0.72f, 0.0f);
+static const float     PLAYER_SCALE = 0.9f;
+
+// Con un tick di arretrato il budget può accumulare al massimo
+// questi tick di banda: un client fermo non si ritrova con un secondo
+// di pacchetti da mandare tutti insieme
+static const float BUDGET_BURST_TICKS = 4.0f;
+
+// Dentro questo angolo dalla direzione della camera (coseno di ~55°)
+// un chunk o un'entità si considerano visibili
+static const float VISIBLE_COS = 0.57f;
+
+static uint64_t columnKey(int cx, int cz) {
+    return (uint64_t)(uint32_t)cx << 32 | (uint32_t)cz;
+}
+
+// Un id di rete che non si ripete finché l'entità vive e cambia quando
+// l'indice viene riusato (come Entity, in 32 bit)
+static uint32_t networkId(Entity entity) {
+    return (entity.generation & 0xFFFF) << 16 | (entity.index & 0xFFFF);
+}
+
+GameServer::GameServer(const ServerConfig& config, JobSystem* jobs)
+    : settings(config)
+    , terrain(config.seed)
+    , creatures(jobs)
+    , movingBlocks(jobs)
+    , jobs(jobs)
+{
+}
+
+glm::vec3 GameServer::spawnEye() const {
+    return glm::vec3(0.5f, (float)std::max(terrain.surfaceHeight(0, 0), TerrainGenerator::SEA_LEVEL) + 3.0f, 0.5f);
+}
+
+int GameServer::connect(LoopbackEndpoint endpoint) {
+    auto client = std::make_unique<Client>();
+    client->id       = nextClientId++;
+    client->endpoint = std::move(endpoint);
+    client->body     = Camera(spawnEye());
+    client->input.yaw   = client->body.yaw;
+    client->input.pitch = client->body.pitch;
+
+    const BlockTextures& look = BLOCK_TEXTURES[BLOCK_LAMP];
+    glm::vec3 body = client->body.position + PLAYER_BODY_OFFSET;
+    client->player = creatures.registry().create(
+        Transform{ body, 0.0f },
+        PreviousTransform{ body, 0.0f },
+        Renderable{ packInstanceLayers(look.top, look.bottom, look.side), PLAYER_SCALE });
+
+    int id = client->id;
+    clients.push_back(std::move(client));
+    return id;
+}
+
+void GameServer::disconnect(int id) {
+    for (size_t i = 0; i < clients.size(); i++) {
+        if (clients[i]->id != id) continue;
+        creatures.registry().destroy(clients[i]->player);
+        clients.erase(clients.begin() + (long)i);
+        return;
+    }
+}
+
+GameServer::Client* GameServer::findClient(int id) {
+    for (auto& client : clients)
+        if (client->id == id) return client.get();
+    return nullptr;
+}
+
+const GameServer::Client* GameServer::findClient(int id) const {
+    for (const auto& client : clients)
+        if (client->id == id) return client.get();
+    return nullptr;
+}
+
+uint32_t GameServer::chunkVersion(const ChunkPos& pos) const {
+    auto it = versions.find(pos);
+    return it == versions.end() ? 1 : it->second;
+}
+
+int GameServer::spawnMobs(const glm::vec3& center, int count, float radius) {
+    return creatures.spawn(worldState, center, count, radius);
+}
+
+// ---------------------------------------------------------------
+// Tick
+// ---------------------------------------------------------------
+
+void GameServer::tick() {
+    PROFILE_SCOPE("Server tick");
+    auto start = std::chrono::steady_clock::now();
+    float step = 1.0f / (float)settings.tickRate;
+    tickCount++;
+
+    // 1) Comandi dei client e movimento dei giocatori
+    for (auto& client : clients) {
+        receive(*client);
+        if (!client->welcomed) continue;
+
+        if (client->input.toggleNoclip) client->noclip = !client->noclip;
+        movePlayer(worldState, client->body, client->input, client->noclip, step);
+        editBlocks(*client, client->input);
+        if (client->input.spawnMobs) creatures.spawn(worldState, client->body.position, Simulation::MOBS_PER_SPAWN);
+        // I colpi singoli valgono per un tick, i tasti tenuti restano
+        client->input.breakBlock   = false;
+        client->input.placeBlock   = false;
+        client->input.toggleNoclip = false;
+        client->input.spawnMobs    = false;
+
+        if (Transform* t = creatures.registry().get<Transform>(client->player)) {
+            PreviousTransform* previous = creatures.registry().get<PreviousTransform>(client->player);
+            *previous = { t->position, t->yaw };
+            t->position = client->body.position + PLAYER_BODY_OFFSET;
+            t->yaw      = glm::radians(client->body.yaw);
+        }
+    }
+
+    // 2) Il mondo: terreno attorno ai giocatori, creature, fluidi e sabbia
+    generateAroundPlayers();
+    creatures.update(worldState, step);
+    if (tickCount % (uint64_t)std::max(1, settings.tickRate / BlockUpdateSystem::TICK_RATE) == 0) {
+        movingBlocks.update(worldState);
+        for (const BlockChange& change : movingBlocks.changes()) worldState.markBlockChanged(change.x, change.y, change.z);
+    }
+
+    // Chunk modificati in questo tick: nuova versione, da rimandare
+    worldState.takeDirtyChunks(changed);
+    for (const ChunkPos& pos : changed) versions[pos] = chunkVersion(pos) + 1;
+
+    // 3) A ogni client la sua parte, dentro la sua banda
+    float perTick = (float)settings.bytesPerSecond / (float)settings.tickRate;
+    for (auto& client : clients) {
+        if (!client->welcomed) continue;
+        client->budget = std::min(client->budget + perTick, perTick * BUDGET_BURST_TICKS);
+        sendEntities(*client);
+        sendChunks(*client);
+    }
+
+    float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    counters.ticks++;
+    counters.tickMs      = ms;
+    counters.worstTickMs = std::max(counters.worstTickMs, ms);
+}
+
+void GameServer::receive(Client& client) {
+    while (client.endpoint.receive(packet)) {
+        ByteReader in(packet.data(), packet.size());
+        MessageType type = (MessageType)in.u8();
+        if (type == MessageType::Hello) {
+            // Anche ripetuto: il Welcome di prima può essersi perso
+            if (!readHello(in)) continue;
+            client.welcomed = true;
+            WelcomeMessage welcome;
+            welcome.playerId     = networkId(client.player);
+            welcome.tickRate     = settings.tickRate;
+            welcome.viewDistance = settings.viewDistance;
+            welcome.eye          = client.body.position;
+            packet.clear();
+            writeWelcome(packet, welcome);
+            sendPacket(client);
+        } else if (type == MessageType::Input && client.welcomed) {
+            handleInput(client, in);
+        }
+        // Il resto (messaggi sconosciuti o fuori posto) si ignora
+    }
+}
+
+void GameServer::handleInput(Client& client, ByteReader& in) {
+    thread_local InputMessage message;
+    if (!readInput(in, message)) return;
+    // Arrivano in ordine, ma uno vecchio ripetuto non deve rifare i colpi
+    if (message.sequence <= client.lastSequence) return;
+    client.lastSequence = message.sequence;
+
+    client.input.merge(message.input);
+    if (message.entityAck > client.ackedEntityTick && message.entityAck <= tickCount)
+        client.ackedEntityTick = message.entityAck;
+    for (const ChunkAck& ack : message.chunkAcks) {
+        auto it = client.chunks.find(ack.pos);
+        if (it != client.chunks.end() && ack.version > it->second.acked) it->second.acked = ack.version;
+    }
+}
+
+// Come Simulation::editBlocks, senza luce: il server non disegna
+void GameServer::editBlocks(Client& client, const PlayerInput& input) {
+    if (!input.breakBlock && !input.placeBlock) return;
+    const Camera& body = client.body;
+    RayHit target = raycast(worldState, { body.position, body.front, PICK_DISTANCE });
+    if (!target.hit) return;
+
+    if (input.breakBlock) {
+        worldState.setBlock(target.block.x, target.block.y, target.block.z, BLOCK_AIR);
+        movingBlocks.blockChanged(worldState, target.block.x, target.block.y, target.block.z);
+    } else if (target.normal != glm::ivec3(0)) {
+        glm::ivec3 p = target.block + target.normal;
+        Aabb block = { glm::vec3(p), glm::vec3(p) + 1.0f };
+        if ((block.intersects(playerBox(body.position)) && !client.noclip) || !worldState.getChunk(World::toChunkPos(p.x, p.y, p.z))) return;
+        worldState.setBlock(p.x, p.y, p.z, input.block);
+        movingBlocks.blockChanged(worldState, p.x, p.y, p.z);
+    }
+}
+
+// Le colonne mancanti entro la vista di qualche giocatore, le più
+// vicine prima, al massimo columnsPerTick per tick. Generate in
+// parallelo (ognuna nei suoi chunk), inserite poi qui.
+void GameServer::generateAroundPlayers() {
+    struct Column {
+        int   x, z;
+        float distance;
+    };
+    // Locale e non thread_local: la leggono anche i worker
+    std::vector<Column> missing;
+
+    int r = settings.viewDistance + 1;
+    for (const auto& client : clients) {
+        ChunkPos center = World::toChunkPos((int)std::floor(client->body.position.x), 0, (int)std::floor(client->body.position.z));
+        for (int dz = -r; dz <= r; dz++)
+            for (int dx = -r; dx <= r; dx++) {
+                if (dx * dx + dz * dz > r * r || generatedColumns.count(columnKey(center.x + dx, center.z + dz))) continue;
+                missing.push_back({ center.x + dx, center.z + dz, (float)(dx * dx + dz * dz) });
+            }
+    }
+    if (missing.empty()) return;
+
+    std::sort(missing.begin(), missing.end(), [](const Column& a, const Column& b) {
+        if (a.distance != b.distance) return a.distance < b.distance;
+        return a.x != b.x ? a.x < b.x : a.z < b.z;
+    });
+    // Due giocatori vicini vogliono le stesse colonne
+    missing.erase(std::unique(missing.begin(), missing.end(), [](const Column& a, const Column& b) {
+        return a.x == b.x && a.z == b.z;
+    }), missing.end());
+    if ((int)missing.size() > settings.columnsPerTick) missing.resize(settings.columnsPerTick);
+
+    constexpr int HEIGHT = WORLD_MAX_CHUNK_Y - WORLD_MIN_CHUNK_Y + 1;
+    std::vector<std::unique_ptr<Chunk>> generated(missing.size() * HEIGHT);
+    auto generate = [&](int i) {
+        const Column& column = missing[i / HEIGHT];
+        ChunkPos pos = { column.x, WORLD_MIN_CHUNK_Y + i % HEIGHT, column.z };
+        generated[i] = std::make_unique<Chunk>();
+        terrain.generate(pos, *generated[i]);
+    };
+    if (jobs) jobs->parallelFor((int)generated.size(), generate);
+    else for (int i = 0; i < (int)generated.size(); i++) generate(i);
+
+    for (size_t i = 0; i < generated.size(); i++) {
+        const Column& column = missing[i / HEIGHT];
+        worldState.insertChunk({ column.x, WORLD_MIN_CHUNK_Y + (int)(i % HEIGHT), column.z }, std::move(generated[i]));
+    }
+    for (const Column& column : missing) generatedColumns.insert(columnKey(column.x, column.z));
+}
+
+float GameServer::interestScore(const Client& client, const glm::vec3& p) {
+    glm::vec3 d = p - client.body.position;
+    float distance = glm::length(d);
+    bool visible = distance < 2.0f * CHUNK_SIZE || glm::dot(d, client.body.front) > distance * VISIBLE_COS;
+    return visible ? distance : distance * 3.0f;
+}
+
+bool GameServer::sendPacket(Client& client) {
+    client.budget -= (float)packet.size();
+    counters.bytesSent += (long long)packet.size();
+    return client.endpoint.send(packet);
+}
+
+// ---------------------------------------------------------------
+// Entità: le più interessanti entro entityRadius, come differenza
+// dall'ultimo stato confermato dal client
+// ---------------------------------------------------------------
+void GameServer::sendEntities(Client& client) {
+    if (client.budget <= 0.0f) {
+        counters.skippedUpdates++;
+        return;
+    }
+
+    nearby.clear();
+    float radius2 = settings.entityRadius * settings.entityRadius;
+    uint32_t self = networkId(client.player);
+    creatures.registry().forEachBatch<const Transform, const Renderable>(
+        [&](const EntityBatch& batch, const Transform* transform, const Renderable* renderable) {
+            for (int i = 0; i < batch.count; i++) {
+                glm::vec3 d = transform[i].position - client.body.position;
+                if (glm::dot(d, d) > radius2) continue;
+                uint32_t id = networkId(batch.entities[i]);
+                if (id == self) continue;
+                NetEntity entity{ id, quantizePosition(transform[i].position), quantizeAngle(transform[i].yaw), renderable[i].layers };
+                nearby.push_back({ interestScore(client, transform[i].position), entity });
+            }
+        });
+    if ((int)nearby.size() > settings.maxEntities) {
+        std::nth_element(nearby.begin(), nearby.begin() + settings.maxEntities, nearby.end(),
+                         [](const auto& a, const auto& b) { return a.first < b.first; });
+        nearby.resize(settings.maxEntities);
+    }
+
+    EntitySnapshot& snapshot = client.history[tickCount % ENTITY_HISTORY];
+    snapshot.tick = tickCount;
+    snapshot.entities.clear();
+    for (const auto& [score, entity] : nearby) snapshot.entities.push_back(entity);
+    std::sort(snapshot.entities.begin(), snapshot.entities.end(),
+              [](const NetEntity& a, const NetEntity& b) { return a.id < b.id; });
+
+    // La base è l'ultimo stato confermato, se lo teniamo ancora
+    static const std::vector<NetEntity> NONE;
+    const EntitySnapshot& acked = client.history[client.ackedEntityTick % ENTITY_HISTORY];
+    bool hasBaseline = client.ackedEntityTick > 0 && acked.tick == client.ackedEntityTick;
+
+    packet.clear();
+    ByteWriter writer(packet);
+    writer.u8((uint8_t)MessageType::Entities);
+    writer.varint(tickCount);
+    writer.varint(hasBaseline ? client.ackedEntityTick : 0);
+    glm::ivec3 eye = quantizePosition(client.body.position);
+    writer.svarint(eye.x);
+    writer.svarint(eye.y);
+    writer.svarint(eye.z);
+    writeEntityDelta(writer, hasBaseline ? acked.entities : NONE, snapshot.entities);
+
+    counters.entityUpdates++;
+    counters.entityBytes += (long long)packet.size();
+    sendPacket(client);
+}
+
+// ---------------------------------------------------------------
+// Chunk: quelli in vista con una versione che il client non ha
+// confermato, i più interessanti prima, finché c'è banda
+// ---------------------------------------------------------------
+void GameServer::sendChunks(Client& client) {
+    int r = settings.viewDistance;
+    ChunkPos center = World::toChunkPos((int)std::floor(client.body.position.x), 0, (int)std::floor(client.body.position.z));
+    uint64_t resendAfter = (uint64_t)(settings.tickRate * RESEND_SECONDS);
+
+    // Il client dimentica da solo i chunk oltre la vista (più uno):
+    // anche il server smette di ricordarseli
+    for (auto it = client.chunks.begin(); it != client.chunks.end();) {
+        int dx = it->first.x - center.x, dz = it->first.z - center.z;
+        if (dx * dx + dz * dz > (r + 1) * (r + 1)) it = client.chunks.erase(it);
+        else ++it;
+    }
+
+    if (client.budget <= 0.0f) return;
+
+    candidates.clear();
+    for (int dz = -r; dz <= r; dz++)
+        for (int dx = -r; dx <= r; dx++) {
+            if (dx * dx + dz * dz > r * r || !generatedColumns.count(columnKey(center.x + dx, center.z + dz))) continue;
+            for (int cy = WORLD_MIN_CHUNK_Y; cy <= WORLD_MAX_CHUNK_Y; cy++) {
+                ChunkPos pos = { center.x + dx, cy, center.z + dz };
+                uint32_t version = chunkVersion(pos);
+                auto it = client.chunks.find(pos);
+                if (it != client.chunks.end()) {
+                    const SentChunk& sent = it->second;
+                    if (sent.acked >= version) continue;
+                    if (sent.version == version && tickCount - sent.sentTick < resendAfter) continue;
+                }
+                glm::vec3 middle = (glm::vec3((float)pos.x, (float)pos.y, (float)pos.z) + 0.5f) * (float)CHUNK_SIZE;
+                candidates.push_back({ pos, interestScore(client, middle) });
+            }
+        }
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) { return a.score < b.score; });
+
+    for (const Candidate& candidate : candidates) {
+        if (client.budget <= 0.0f) break;
+        const Chunk* chunk = worldState.findChunk(candidate.pos);
+        if (!chunk) continue;
+
+        uint32_t version = chunkVersion(candidate.pos);
+        SentChunk& sent = client.chunks[candidate.pos];
+        if (sent.version == version) counters.chunksResent++;
+        sent.version  = version;
+        sent.sentTick = tickCount;
+
+        packet.clear();
+        writeChunkMessage(packet, candidate.pos, version, *chunk);
+        counters.chunksSent++;
+        counters.chunkBytes += (long long)packet.size();
+        sendPacket(client);
+    }
+}
+
+// ---------------------------------------------------------------
+// Statistiche
+// ---------------------------------------------------------------
+
+ServerStats GameServer::stats() const {
+    ServerStats s = counters;
+    s.clients = (int)clients.size();
+    return s;
+}
+
+long long GameServer::bytesSentTo(int id) const {
+    const Client* client = findClient(id);
+    return client ? client->endpoint.bytesSent() : 0;
+}
+
+glm::vec3 GameServer::playerEye(int id) const {
+    const Client* client = findClient(id);
+    return client ? client->body.position : glm::vec3(0.0f);
+}
+
+const std::vector<NetEntity>* GameServer::lastEntities(int id) const {
+    const Client* client = findClient(id);
+    if (!client) return nullptr;
+    const EntitySnapshot& snapshot = client->history[tickCount % ENTITY_HISTORY];
+    return snapshot.tick == tickCount ? &snapshot.entities : nullptr;
+}
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "block_updates.h"
+#include "camera.h"
+#include "ecs.h"
+#include "mobs.h"
+#include "net_protocol.h"
+#include "simulation.h"
+#include "terrain.h"
+#include "transport.h"
+#include "world.h"
+
+class JobSystem;
+
+struct ServerConfig {
+    uint32_t seed           = 1337;
+    int      tickRate       = 20;
+    int      viewDistance   = 4;          // colonne di chunk attorno a ogni giocatore
+    int      bytesPerSecond = 128 * 1024; // banda massima verso ogni client
+    float    entityRadius   = 48.0f;      // blocchi: oltre, le entità non si mandano
+    int      maxEntities    = 256;        // per aggiornamento, le più interessanti
+    int      columnsPerTick = 16;         // colonne di chunk generate al massimo per tick
+};
+
+struct ServerStats {
+    int       clients       = 0;
+    long long ticks         = 0;
+    float     tickMs        = 0.0f;
+    float     worstTickMs   = 0.0f;
+    long long bytesSent     = 0; // verso tutti i client, pacchetti persi compresi
+    long long chunkBytes    = 0;
+    long long entityBytes   = 0;
+    long long chunksSent    = 0;
+    long long chunksResent  = 0; // rimandati perché non confermati in tempo
+    long long entityUpdates = 0;
+    long long skippedUpdates = 0; // aggiornamenti delle entità saltati per la banda
+};
+
+// ---------------------------------------------------------------
+// GameServer
+// Il mondo autoritativo per più giocatori, senza finestra né OpenGL:
+// genera i chunk attorno ai giocatori, li muove con i loro comandi
+// (movePlayer, come la Simulation), applica le modifiche ai blocchi
+// e fa vivere le creature, l'acqua e la lava. Ogni client riceve:
+//
+//  - i chunk che gli servono, interi e compressi, i più interessanti
+//    prima: vicini e davanti alla camera prima di quelli alle spalle.
+//    Un chunk modificato cambia versione e si rimanda; uno non
+//    confermato dopo un secondo anche.
+//  - ad ogni tick le entità vicine (creature e altri giocatori) come
+//    differenza dall'ultimo stato che il client ha confermato.
+//
+// Tutto dentro la banda del client: ogni tick aggiunge
+// bytesPerSecond / tickRate byte al suo budget, e si manda finché ce
+// n'è. Le entità passano prima dei chunk.
+//
+// Un thread solo chiama connect, disconnect e tick; creature e
+// blocchi che si muovono usano jobs se c'è.
+// ---------------------------------------------------------------
+class GameServer {
+public:
+    explicit GameServer(const ServerConfig& config = {}, JobSystem* jobs = nullptr);
+
+    // Un client collegato all'altro capo di endpoint; restituisce il
+    // suo numero (per disconnect e le statistiche)
+    int  connect(LoopbackEndpoint endpoint);
+    void disconnect(int client);
+
+    void tick();
+
+    // Creature attorno a center, nelle colonne già generate
+    int spawnMobs(const glm::vec3& center, int count, float radius);
+
+    // Dove compare un giocatore nuovo
+    glm::vec3 spawnEye() const;
+
+    const ServerConfig& config() const { return settings; }
+    ServerStats stats() const;
+    uint64_t    ticks() const { return tickCount; }
+
+    const World&     world() const { return worldState; }
+    const MobSystem& mobs() const { return creatures; }
+
+    // Versione attuale di un chunk (parte da 1, cresce a ogni modifica)
+    uint32_t chunkVersion(const ChunkPos& pos) const;
+
+    // Per un client: byte mandati, posizione degli occhi, entità
+    // dell'ultimo aggiornamento
+    long long bytesSentTo(int client) const;
+    glm::vec3 playerEye(int client) const;
+    const std::vector<NetEntity>* lastEntities(int client) const;
+
+private:
+    static constexpr int RESEND_SECONDS = 1;
+
+    struct SentChunk {
+        uint32_t version  = 0; // ultima mandata
+        uint32_t acked    = 0; // ultima confermata
+        uint64_t sentTick = 0;
+    };
+
+    struct EntitySnapshot {
+        uint64_t tick = 0;
+        std::vector<NetEntity> entities;
+    };
+
+    struct Client {
+        int              id = 0;
+        LoopbackEndpoint endpoint;
+        bool             welcomed = false;
+        Entity           player;
+        Camera           body;
+        bool             noclip = false;
+        PlayerInput      input;            // i tasti tenuti valgono fino al prossimo Input
+        uint32_t         lastSequence = 0;
+        float            budget = 0.0f;    // byte che si possono ancora mandare
+        uint64_t         ackedEntityTick = 0;
+        EntitySnapshot   history[ENTITY_HISTORY];
+        std::unordered_map<ChunkPos, SentChunk, ChunkPosHash> chunks;
+    };
+
+    // Un candidato da mandare: più basso è score, prima si manda
+    struct Candidate {
+        ChunkPos pos;
+        float    score;
+    };
+
+    Client* findClient(int id);
+    const Client* findClient(int id) const;
+
+    void receive(Client& client);
+    void handleInput(Client& client, ByteReader& in);
+    void editBlocks(Client& client, const PlayerInput& input);
+    void generateAroundPlayers();
+    void sendEntities(Client& client);
+    void sendChunks(Client& client);
+    bool sendPacket(Client& client);
+
+    // Quanto interessa al client qualcosa in p: la distanza, tripla
+    // per quello che sta alle spalle della camera
+    static float interestScore(const Client& client, const glm::vec3& p);
+
+    ServerConfig      settings;
+    TerrainGenerator  terrain;
+    World             worldState;
+    MobSystem         creatures;
+    BlockUpdateSystem movingBlocks;
+    JobSystem*        jobs;
+
+    std::vector<std::unique_ptr<Client>> clients;
+    int      nextClientId = 1;
+    uint64_t tickCount = 0;
+
+    std::unordered_map<ChunkPos, uint32_t, ChunkPosHash> versions; // solo i chunk modificati
+    std::unordered_set<uint64_t> generatedColumns;
+
+    // Riusati ad ogni tick
+    std::vector<uint8_t>   packet;
+    std::vector<ChunkPos>  changed;
+    std::vector<Candidate> candidates;
+    std::vector<std::pair<float, NetEntity>> nearby;
+
+    ServerStats counters;
+};
@@ -0,0 +1,99 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "block_registry.h"
+#include "client.h"
+#include "job_system.h"
+#include "server.h"
+
+// ---------------------------------------------------------------
+// voxel_server
+// Il server dedicato: lo stesso motore senza finestra, camera né
+// interfaccia, a tick fisso. Per ora i client sono giocatori finti
+// nello stesso processo, collegati in loopback (--bots): servono a
+// vedere quanta banda e quanto tempo di tick costa ogni giocatore.
+// Ogni secondo stampa una riga di statistiche.
+// ---------------------------------------------------------------
+
+static void usage(const char* program) {
+    std::fprintf(stderr,
+        "usage: %s [--bots N] [--seconds S] [--tick-rate HZ] [--view CHUNKS]\n"
+        "          [--kbps KB_PER_CLIENT] [--mobs N] [--loss FRACTION] [--blocks FILE]\n", program);
+}
+
+int main(int argc, char** argv) {
+    ServerConfig config;
+    int   bots    = 4;
+    int   seconds = 30; // 0: finché non lo si ferma
+    int   mobs    = 1000;
+    float loss    = 0.0f;
+    const char* blocks = nullptr; // tipi di blocco in più, lo stesso file dei client
+
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--bots") == 0 && hasValue)           bots = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--seconds") == 0 && hasValue)   seconds = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--tick-rate") == 0 && hasValue) config.tickRate = std::max(1, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--view") == 0 && hasValue)      config.viewDistance = std::max(1, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--kbps") == 0 && hasValue)      config.bytesPerSecond = std::max(1, std::atoi(argv[++i])) * 1024;
+        else if (std::strcmp(argv[i], "--mobs") == 0 && hasValue)      mobs = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--loss") == 0 && hasValue)      loss = (float)std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--blocks") == 0 && hasValue)    blocks = argv[++i];
+        else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (blocks) std::printf("%d block types from %s\n", loadBlockDefinitions(blocks), blocks);
+
+    JobSystem  jobs;
+    GameServer server(config, &jobs);
+    std::vector<std::unique_ptr<GameClient>> clients;
+    for (int i = 0; i < bots; i++) {
+        auto [serverSide, clientSide] = makeLoopbackPair(loss, (uint32_t)i + 1);
+        server.connect(std::move(serverSide));
+        clients.push_back(std::make_unique<GameClient>(std::move(clientSide)));
+    }
+    std::printf("voxel_server: %d bots, %d Hz, view %d chunks, %d KB/s per client\n",
+                bots, config.tickRate, config.viewDistance, config.bytesPerSecond / 1024);
+
+    using Clock = std::chrono::steady_clock;
+    auto step = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / config.tickRate));
+    Clock::time_point next = Clock::now();
+    ServerStats last;
+    bool mobsSpawned = mobs <= 0;
+
+    for (uint64_t tick = 1; seconds == 0 || tick <= (uint64_t)seconds * config.tickRate; tick++) {
+        for (size_t i = 0; i < clients.size(); i++) {
+            clients[i]->update();
+            if (clients[i]->welcomed()) clients[i]->sendInput(botInput((int)i, clients[i]->inputsSent() + 1));
+        }
+        server.tick();
+
+        // Le creature quando attorno allo spawn c'è il terreno
+        if (!mobsSpawned && tick >= 5) mobsSpawned = server.spawnMobs(server.spawnEye(), mobs, 48.0f) > 0;
+
+        if (tick % config.tickRate == 0) {
+            ServerStats stats = server.stats();
+            double perClient = bots > 0 ? (double)(stats.bytesSent - last.bytesSent) / bots / 1024.0 : 0.0;
+            std::printf("t=%3llus  tick %.2f ms (worst %.2f)  %.1f KB/s per client  chunks %lld  entities %d\n",
+                        (unsigned long long)(tick / config.tickRate), stats.tickMs, stats.worstTickMs, perClient,
+                        stats.chunksSent - last.chunksSent, server.mobs().count());
+            std::fflush(stdout);
+            last = stats;
+        }
+
+        // Passo fisso come SimulationThread: in ritardo si recupera
+        next += step;
+        if (Clock::now() - next > step * 5) next = Clock::now();
+        std::this_thread::sleep_until(next);
+    }
+    return 0;
+}
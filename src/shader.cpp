@@ -1,6 +1,10 @@
 #include "shader.h"
+#include <glm/gtc/type_ptr.hpp>
 #include <iostream>
 
+#include "asset_loader.h"
+#include "program_cache.h"
+
 // ---------------------------------------------------------------
 // In C++ il :: è l'operatore di "scope resolution".
 // Shader::Shader significa "il costruttore della classe Shader".
@@ -8,53 +12,279 @@
 // ---------------------------------------------------------------
 
 Shader::Shader(const char* vertexSource, const char* fragmentSource) {
+    ID = buildProgram(vertexSource, fragmentSource);
+    reflect();
+}
+
+static std::filesystem::file_time_type modificationTime(const std::string& path) {
+    std::error_code error; // un file che sparisce a metà salvataggio non è un errore grave
+    return std::filesystem::last_write_time(path, error);
+}
+
+Shader Shader::fromFiles(const std::string& vertexPath, const std::string& fragmentPath, ProgramCache* cache) {
+    std::string vertexSource, fragmentSource;
+    if (!readTextFile(vertexPath, vertexSource) || !readTextFile(fragmentPath, fragmentSource))
+        vertexSource.clear(); // niente program, ma i percorsi restano per la ricarica
+    return fromSources(vertexPath, fragmentPath, vertexSource, fragmentSource, cache);
+}
+
+Shader Shader::fromSources(const std::string& vertexPath, const std::string& fragmentPath,
+                           const std::string& vertexSource, const std::string& fragmentSource,
+                           ProgramCache* cache) {
+    Shader shader;
+    shader.vertexPath   = vertexPath;
+    shader.fragmentPath = fragmentPath;
+    shader.vertexTime   = modificationTime(vertexPath);
+    shader.fragmentTime = modificationTime(fragmentPath);
+    shader.cache        = cache;
+
+    if (!vertexSource.empty() && !fragmentSource.empty())
+        shader.ID = shader.buildProgram(vertexSource, fragmentSource);
+    shader.reflect();
+    return shader;
+}
+
+Shader::Shader(Shader&& other) noexcept
+    : ID(other.ID)
+    , uniforms(std::move(other.uniforms))
+    , slotNames(std::move(other.slotNames))
+    , slotTypes(std::move(other.slotTypes))
+    , slotLocations(std::move(other.slotLocations))
+    , blockBindings(std::move(other.blockBindings))
+    , vertexPath(std::move(other.vertexPath))
+    , fragmentPath(std::move(other.fragmentPath))
+    , vertexTime(other.vertexTime)
+    , fragmentTime(other.fragmentTime)
+    , cache(other.cache)
+{
+    other.ID = 0; // il program ora è nostro: l'altro non deve cancellarlo
+}
+
+Shader::~Shader() {
+    // RAII: quando l'oggetto Shader viene distrutto, libera la risorsa GPU
+    if (ID) glDeleteProgram(ID);
+}
+
+void Shader::use() const {
+    glUseProgram(ID);
+}
+
+// I binari dei program ci sono dalla 4.1 o con ARB_get_program_binary,
+// ma un driver può comunque non offrire nessun formato
+static bool programBinarySupported() {
+    if (!GLAD_GL_VERSION_4_1 && !GLAD_GL_ARB_get_program_binary) return false;
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return formats > 0;
+}
+
+unsigned int Shader::buildProgram(const std::string& vertexSource, const std::string& fragmentSource) {
+    if (!cache || !programBinarySupported())
+        return compileProgram(vertexSource.c_str(), fragmentSource.c_str(), false);
+
+    // Stessi sorgenti e stesso driver di un avvio precedente: il program
+    // arriva già linkato. Se il driver lo rifiuta (aggiornato con la
+    // stessa stringa di versione, binario rovinato) si ricompila.
+    uint64_t key = cache->keyOf(vertexSource, fragmentSource);
+    ProgramBinary binary;
+    if (cache->load(key, binary)) {
+        unsigned int program = glCreateProgram();
+        glProgramBinary(program, binary.format, binary.data.data(), (GLsizei)binary.data.size());
+        int success = 0;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (success) return program;
+        glDeleteProgram(program);
+        cache->reject(key);
+    }
+
+    unsigned int program = compileProgram(vertexSource.c_str(), fragmentSource.c_str(), true);
+    if (!program) return 0;
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length > 0) {
+        GLenum format = 0;
+        binary.data.resize((size_t)length);
+        glGetProgramBinary(program, length, &length, &format, binary.data.data());
+        binary.data.resize((size_t)length);
+        binary.format = format;
+        cache->store(key, binary);
+    }
+    return program;
+}
+
+unsigned int Shader::compileProgram(const char* vertexSource, const char* fragmentSource, bool retrievable) {
     // Compila i due shader separatamente
-    unsigned int vertex   = compileShader(GL_VERTEX_SHADER,   vertexSource);
-    unsigned int fragment = compileShader(GL_FRAGMENT_SHADER, fragmentSource);
+    bool vertexOk, fragmentOk;
+    unsigned int vertex   = compileShader(GL_VERTEX_SHADER,   vertexSource,   vertexOk);
+    unsigned int fragment = compileShader(GL_FRAGMENT_SHADER, fragmentSource, fragmentOk);
 
     // Crea il program e collega i due shader
-    ID = glCreateProgram();
-    glAttachShader(ID, vertex);
-    glAttachShader(ID, fragment);
-    glLinkProgram(ID);
+    unsigned int program = glCreateProgram();
+    glAttachShader(program, vertex);
+    glAttachShader(program, fragment);
+    // Va detto prima del linking, se poi si vuole leggere il binario
+    if (retrievable) glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glLinkProgram(program);
 
     // Controlla errori di linking
     int success;
     char infoLog[512];
-    glGetProgramiv(ID, GL_LINK_STATUS, &success);
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
     if (!success) {
-        glGetProgramInfoLog(ID, 512, nullptr, infoLog);
+        glGetProgramInfoLog(program, 512, nullptr, infoLog);
         std::cerr << "Errore linking shader program: " << infoLog << "\n";
     }
 
     // Gli shader singoli non servono più dopo il linking — li eliminiamo
     glDeleteShader(vertex);
     glDeleteShader(fragment);
+
+    if (!success || !vertexOk || !fragmentOk) {
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
 }
 
-Shader::~Shader() {
-    // RAII: quando l'oggetto Shader viene distrutto, libera la risorsa GPU
-    glDeleteProgram(ID);
+void Shader::reflect() {
+    uniforms.clear();
+
+    int count = 0;
+    if (ID) glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+    for (int i = 0; i < count; i++) {
+        char    name[256];
+        GLsizei length = 0;
+        GLint   size   = 0;
+        GLenum  type   = 0;
+        glGetActiveUniform(ID, (GLuint)i, sizeof(name), &length, &size, &type, name);
+
+        // Gli uniform dentro un blocco non hanno location: li gestisce il blocco
+        int location = glGetUniformLocation(ID, name);
+        if (location < 0) continue;
+
+        // Gli array si chiamano "nome[0]": li registriamo anche come "nome"
+        std::string uniformName(name, (size_t)length);
+        if (uniformName.size() > 3 && uniformName.compare(uniformName.size() - 3, 3, "[0]") == 0)
+            uniformName.resize(uniformName.size() - 3);
+        uniforms[uniformName] = { location, (unsigned)type };
+    }
+
+    for (size_t slot = 0; slot < slotNames.size(); slot++)
+        slotLocations[slot] = locationOf(slotNames[slot]);
+
+    for (const auto& [blockName, binding] : blockBindings) {
+        unsigned int index = ID ? glGetUniformBlockIndex(ID, blockName.c_str()) : GL_INVALID_INDEX;
+        if (index != GL_INVALID_INDEX) glUniformBlockBinding(ID, index, binding);
+    }
 }
 
-void Shader::use() const {
-    glUseProgram(ID);
+int Shader::locationOf(const std::string& name) const {
+    auto it = uniforms.find(name);
+    return it == uniforms.end() ? -1 : it->second.location;
+}
+
+static bool isSampler(unsigned int type) {
+    switch (type) {
+    case GL_SAMPLER_1D: case GL_SAMPLER_2D: case GL_SAMPLER_3D: case GL_SAMPLER_CUBE:
+    case GL_SAMPLER_2D_SHADOW: case GL_SAMPLER_2D_ARRAY: case GL_SAMPLER_2D_ARRAY_SHADOW:
+    case GL_INT_SAMPLER_2D: case GL_UNSIGNED_INT_SAMPLER_2D: case GL_SAMPLER_BUFFER:
+        return true;
+    default:
+        return false;
+    }
+}
+
+int Shader::addSlot(const std::string& name, unsigned int expectedType) {
+    // Lo stesso uniform chiesto due volte riusa lo slot
+    for (size_t slot = 0; slot < slotNames.size(); slot++)
+        if (slotNames[slot] == name && slotTypes[slot] == expectedType) return (int)slot;
+
+    auto it = uniforms.find(name);
+    if (it != uniforms.end()) {
+        // I sampler si impostano con un int (l'unità di texture)
+        bool sampler = expectedType == GL_INT && isSampler(it->second.type);
+        if (it->second.type != expectedType && !sampler)
+            std::cerr << "Uniform " << name << ": il tipo nello shader non corrisponde all'handle\n";
+    }
+
+    slotNames.push_back(name);
+    slotTypes.push_back(expectedType);
+    slotLocations.push_back(locationOf(name));
+    return (int)slotNames.size() - 1;
+}
+
+void Shader::set(UniformHandle<int> handle, int value) const {
+    glUniform1i(slotLocations[handle.slot], value);
+}
+
+void Shader::set(UniformHandle<float> handle, float value) const {
+    glUniform1f(slotLocations[handle.slot], value);
+}
+
+void Shader::set(UniformHandle<glm::vec3> handle, const glm::vec3& value) const {
+    glUniform3fv(slotLocations[handle.slot], 1, glm::value_ptr(value));
+}
+
+void Shader::set(UniformHandle<glm::vec4> handle, const glm::vec4& value) const {
+    glUniform4fv(slotLocations[handle.slot], 1, glm::value_ptr(value));
+}
+
+void Shader::set(UniformHandle<glm::mat4> handle, const glm::mat4& value) const {
+    glUniformMatrix4fv(slotLocations[handle.slot], 1, GL_FALSE, glm::value_ptr(value));
 }
 
 void Shader::setMat4(const std::string& name, const float* value) const {
-    // glGetUniformLocation trova la "posizione" della variabile uniform nello shader
-    glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, value);
+    // La location viene dalla tabella costruita al linking, non da glGetUniformLocation
+    glUniformMatrix4fv(locationOf(name), 1, GL_FALSE, value);
 }
 
 void Shader::setInt(const std::string& name, int value) const {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+    glUniform1i(locationOf(name), value);
 }
 
 void Shader::setFloat(const std::string& name, float value) const {
-    glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+    glUniform1f(locationOf(name), value);
+}
+
+void Shader::bindUniformBlock(const std::string& blockName, unsigned int binding) {
+    blockBindings.emplace_back(blockName, binding);
+    reflect();
 }
 
-unsigned int Shader::compileShader(unsigned int type, const char* source) {
+bool Shader::reloadIfChanged() {
+    if (vertexPath.empty()) return false; // shader compilato da stringhe
+
+    auto newVertexTime   = modificationTime(vertexPath);
+    auto newFragmentTime = modificationTime(fragmentPath);
+    if (newVertexTime == vertexTime && newFragmentTime == fragmentTime) return false;
+    vertexTime   = newVertexTime;
+    fragmentTime = newFragmentTime;
+
+    std::string vertexSource, fragmentSource;
+    if (!readTextFile(vertexPath, vertexSource) || !readTextFile(fragmentPath, fragmentSource)) return false;
+
+    unsigned int program = buildProgram(vertexSource, fragmentSource);
+    if (!program) {
+        std::cerr << "Ricarica fallita, resta lo shader precedente\n";
+        return false;
+    }
+
+    // Il program nuovo prende il posto del vecchio: gli uniform hanno
+    // nuove location, che reflect() copia negli slot degli handle
+    GLint current = 0;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &current);
+    bool wasActive = ID != 0 && (unsigned)current == ID;
+    if (ID) glDeleteProgram(ID);
+    ID = program;
+    reflect();
+    if (wasActive) glUseProgram(ID);
+
+    std::cout << "Shader ricaricato: " << vertexPath << ", " << fragmentPath << "\n";
+    return true;
+}
+
+unsigned int Shader::compileShader(unsigned int type, const char* source, bool& ok) {
     unsigned int shader = glCreateShader(type);
     glShaderSource(shader, 1, &source, nullptr);
     glCompileShader(shader);
@@ -66,5 +296,6 @@ unsigned int Shader::compileShader(unsigned int type, const char* source) {
         glGetShaderInfoLog(shader, 512, nullptr, infoLog);
         std::cerr << "Errore compilazione shader: " << infoLog << "\n";
     }
+    ok = success != 0;
     return shader;
-}
\ No newline at end of file
+}
@@ -1,24 +1,68 @@
 #pragma once // evita che questo header venga incluso più volte nello stesso file
 
 #include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <filesystem>
 #include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class ProgramCache;
+
+// ---------------------------------------------------------------
+// Handle tipizzato di un uniform: si ottiene una volta con
+// Shader::uniform<T>("nome") e poi si passa a Shader::set().
+// Dentro c'è solo un indice nella tabella dello shader, quindi
+// impostare il valore non costa né stringhe né chiamate al driver.
+// Il tipo T impedisce di passare un float a una mat4 per sbaglio.
+// ---------------------------------------------------------------
+template <typename T>
+class UniformHandle {
+public:
+    UniformHandle() = default;
+    bool isValid() const { return slot >= 0; }
+
+private:
+    friend class Shader;
+    explicit UniformHandle(int slot) : slot(slot) {}
+    int slot = -1;
+};
 
 // ---------------------------------------------------------------
 // Classe Shader
 // Incapsula la compilazione e l'uso di un shader program OpenGL.
 // In C++ una "classe" raggruppa dati e funzioni correlate insieme —
 // è il concetto base della programmazione orientata agli oggetti.
+//
+// Dopo il linking legge dal driver tutti gli uniform attivi (nome,
+// tipo, location) e li tiene in una tabella. Se lo shader viene da
+// file si può ricaricare a caldo: gli handle restano validi perché
+// puntano a uno slot della tabella, non alla location del driver.
+//
+// Con una ProgramCache il program linkato si salva su disco e agli
+// avvii successivi si ricarica senza compilare (vedi program_cache.h).
 // ---------------------------------------------------------------
 class Shader {
 public:
     // L'ID del shader program sulla GPU
     // "unsigned int" perché OpenGL usa ID numerici positivi per le sue risorse
-    unsigned int ID;
+    unsigned int ID = 0;
 
     // Costruttore: prende il codice sorgente di vertex e fragment shader
     // e li compila. In C++ il costruttore ha lo stesso nome della classe.
     Shader(const char* vertexSource, const char* fragmentSource);
 
+    // Carica vertex e fragment shader da due file (ricaricabili con reloadIfChanged)
+    static Shader fromFiles(const std::string& vertexPath, const std::string& fragmentPath,
+                            ProgramCache* cache = nullptr);
+
+    // Come fromFiles, ma con i sorgenti già letti (es. dai worker durante
+    // il caricamento): i percorsi servono per le ricariche a caldo
+    static Shader fromSources(const std::string& vertexPath, const std::string& fragmentPath,
+                              const std::string& vertexSource, const std::string& fragmentSource,
+                              ProgramCache* cache = nullptr);
+
     // Distruttore: chiamato automaticamente quando l'oggetto viene distrutto.
     // Il ~ davanti al nome indica che è un distruttore.
     // Qui liberiamo le risorse GPU — questo è il concetto RAII di C++:
@@ -26,18 +70,95 @@ public:
     // automaticamente quando l'oggetto esce dallo scope.
     ~Shader();
 
+    // Un program OpenGL ha un solo proprietario: si può spostare ma non copiare
+    Shader(Shader&& other) noexcept;
+    Shader(const Shader&) = delete;
+    Shader& operator=(const Shader&) = delete;
+
     // Attiva questo shader program per il rendering
     void use() const;
 
-    // Metodi helper per passare valori agli uniform degli shader.
+    // Handle di un uniform. Se lo shader non ha (ancora) quell'uniform
+    // l'handle è valido lo stesso e set() non fa niente: può comparire
+    // con una ricarica successiva.
+    template <typename T>
+    UniformHandle<T> uniform(const std::string& name);
+
+    // Setter veloci, da usare nei loop di disegno.
     // "const" alla fine significa che il metodo non modifica lo stato dell'oggetto.
+    void set(UniformHandle<int> handle, int value) const;
+    void set(UniformHandle<float> handle, float value) const;
+    void set(UniformHandle<glm::vec3> handle, const glm::vec3& value) const;
+    void set(UniformHandle<glm::vec4> handle, const glm::vec4& value) const;
+    void set(UniformHandle<glm::mat4> handle, const glm::mat4& value) const;
+
+    // Metodi helper per passare valori agli uniform degli shader per nome.
+    // Cercano nella tabella riflessa (niente chiamate al driver) ma costano
+    // comunque un hash della stringa: fuori dai loop caldi vanno bene.
     void setMat4(const std::string& name, const float* value) const;
     void setInt(const std::string& name, int value) const;
     void setFloat(const std::string& name, float value) const;
 
+    // Collega un blocco "uniform Nome { ... }" dello shader al binding point
+    // di un UniformBuffer. Il collegamento sopravvive alle ricariche.
+    void bindUniformBlock(const std::string& blockName, unsigned int binding);
+
+    // Se lo shader viene da file e i file sono cambiati li ricompila.
+    // Se la compilazione fallisce resta in uso il program precedente.
+    // Restituisce true se il program è stato sostituito.
+    bool reloadIfChanged();
+
 private:
+    Shader() = default;
+
+    struct UniformInfo {
+        int      location;
+        unsigned type; // GL_FLOAT, GL_FLOAT_MAT4, GL_SAMPLER_2D...
+    };
+
     // Funzione interna per compilare un singolo shader.
     // "private" significa che è usabile solo dentro questa classe,
     // non dall'esterno — nasconde i dettagli implementativi.
-    unsigned int compileShader(unsigned int type, const char* source);
-};
\ No newline at end of file
+    unsigned int compileShader(unsigned int type, const char* source, bool& ok);
+
+    // Compila e linka un program nuovo; 0 se qualcosa fallisce.
+    // Con la cache prima prova il binario salvato, poi salva quello nuovo.
+    unsigned int buildProgram(const std::string& vertexSource, const std::string& fragmentSource);
+
+    // Solo la compilazione dai sorgenti, senza cache
+    unsigned int compileProgram(const char* vertexSource, const char* fragmentSource, bool retrievable);
+
+    // Dopo ogni linking: rilegge gli uniform, aggiorna gli slot e i blocchi
+    void reflect();
+
+    int  addSlot(const std::string& name, unsigned int expectedType);
+    int  locationOf(const std::string& name) const;
+
+    std::unordered_map<std::string, UniformInfo> uniforms;
+
+    // Slot degli handle: il nome resta, la location si aggiorna ad ogni ricarica
+    std::vector<std::string>  slotNames;
+    std::vector<unsigned int> slotTypes;
+    std::vector<int>          slotLocations;
+
+    std::vector<std::pair<std::string, unsigned int>> blockBindings;
+
+    // Solo per gli shader caricati da file
+    std::string vertexPath, fragmentPath;
+    std::filesystem::file_time_type vertexTime, fragmentTime;
+
+    ProgramCache* cache = nullptr;
+};
+
+// Tipo GLSL che corrisponde a ogni tipo C++ degli handle
+template <typename T> constexpr unsigned int uniformTypeOf();
+template <> constexpr unsigned int uniformTypeOf<int>()       { return GL_INT; }
+template <> constexpr unsigned int uniformTypeOf<float>()     { return GL_FLOAT; }
+template <> constexpr unsigned int uniformTypeOf<glm::vec3>() { return GL_FLOAT_VEC3; }
+template <> constexpr unsigned int uniformTypeOf<glm::vec4>() { return GL_FLOAT_VEC4; }
+template <> constexpr unsigned int uniformTypeOf<glm::mat4>() { return GL_FLOAT_MAT4; }
+
+template <typename T>
+UniformHandle<T> Shader::uniform(const std::string& name) {
+    return UniformHandle<T>(addSlot(name, uniformTypeOf<T>()));
+}
@@ -0,0 +1,289 @@
+#include "simulation.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "light.h"
+#include "profiler.h"
+#include "world.h"
+
+// FNV-1a sui byte: due float uguali al bit danno lo stesso hash
+static void hashBytes(uint64_t& hash, const void* data, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++) hash = (hash ^ bytes[i]) * 1099511628211ull;
+}
+
+void SimSnapshot::interpolateInstances(float alpha, std::vector<InstanceData>& out) const {
+    out.clear();
+    out.reserve(instances.size());
+    for (size_t i = 0; i < instances.size(); i++)
+        out.push_back(interpolateInstance(previousInstances[i], instances[i], alpha));
+}
+
+// ---------------------------------------------------------------
+// Simulation
+// ---------------------------------------------------------------
+
+void movePlayer(const World& world, Camera& body, const PlayerInput& input, bool noclip, float step) {
+    glm::vec3 start = body.position;
+    body.setOrientation(input.yaw, input.pitch);
+    for (int direction = FORWARD; direction <= RIGHT; direction++)
+        if (input.moves & (1 << direction)) body.processKeyboard(direction, step);
+    if (!noclip) {
+        Aabb box = playerBox(start);
+        sweepAabb(world, box, body.position - start);
+        body.position = box.min + PLAYER_BOX_BELOW_EYE;
+    }
+}
+
+Simulation::Simulation(World& world, LightEngine& light, const glm::vec3& spawnEye, int tickRate, JobSystem* jobs)
+    : world(world)
+    , light(light)
+    , rate(tickRate)
+    , body(spawnEye)
+    , previousEye(spawnEye)
+    , creatures(jobs)
+    , movingBlocks(jobs)
+{
+}
+
+void Simulation::tick(const PlayerInput& input) {
+    PROFILE_SCOPE("Tick");
+    float step = tickSeconds();
+    tickCount++;
+
+    // Il giocatore, con l'orientamento scelto dal render thread
+    previousEye = body.position;
+    if (input.toggleNoclip) noclipOn = !noclipOn;
+    movePlayer(world, body, input, noclipOn, step);
+
+    target = raycast(world, { body.position, body.front, PICK_DISTANCE });
+    editBlocks(input);
+    debris.update(world, step);
+
+    if (input.spawnMobs) creatures.spawn(world, body.position, MOBS_PER_SPAWN);
+    creatures.update(world, step);
+
+    // Acqua, lava e sabbia a un ritmo loro; la luce segue i blocchi cambiati
+    if (tickCount % std::max(1, rate / BlockUpdateSystem::TICK_RATE) == 0) {
+        movingBlocks.update(world);
+        const std::vector<BlockChange>& changes = movingBlocks.changes();
+        if (!changes.empty()) light.blocksChanged(changes.data(), changes.size());
+    }
+}
+
+// Rompere il blocco puntato lascia dei frammenti; se ne piazza uno
+// sulla faccia colpita solo se non finisce addosso al giocatore. La
+// luce si aggiorna subito; i chunk da rimeshare li raccoglie il LightEngine.
+void Simulation::editBlocks(const PlayerInput& input) {
+    if (!target.hit) return;
+
+    if (input.breakBlock) {
+        light.setBlock(target.block.x, target.block.y, target.block.z, BLOCK_AIR);
+        movingBlocks.blockChanged(world, target.block.x, target.block.y, target.block.z);
+        debris.spawnDebris(target.block, target.id);
+        target = raycast(world, { body.position, body.front, PICK_DISTANCE });
+    } else if (input.placeBlock && target.normal != glm::ivec3(0)) {
+        glm::ivec3 p = target.block + target.normal;
+        Aabb block = { glm::vec3(p), glm::vec3(p) + 1.0f };
+        // Solo dentro chunk già generati: gli altri verrebbero sovrascritti
+        if ((block.intersects(playerBox(body.position)) && !noclipOn) || !world.getChunk(World::toChunkPos(p.x, p.y, p.z))) return;
+        light.setBlock(p.x, p.y, p.z, input.block);
+        movingBlocks.blockChanged(world, p.x, p.y, p.z);
+        target = raycast(world, { body.position, body.front, PICK_DISTANCE });
+    }
+}
+
+void Simulation::fillSnapshot(SimSnapshot& out) const {
+    out.tick        = tickCount;
+    out.previousEye = previousEye;
+    out.eye         = body.position;
+    out.target      = target;
+    out.noclip      = noclipOn;
+    // clear() e non un vector nuovo: il buffer del TripleBuffer si riusa
+    out.previousInstances.clear();
+    out.instances.clear();
+    debris.appendInstances(world, out.previousInstances, 0.0f);
+    debris.appendInstances(world, out.instances, 1.0f);
+    creatures.appendInstances(world, out.previousInstances, 0.0f);
+    creatures.appendInstances(world, out.instances, 1.0f);
+}
+
+uint64_t Simulation::stateHash() const {
+    SimSnapshot snapshot;
+    fillSnapshot(snapshot);
+
+    uint64_t hash = 14695981039346656037ull;
+    hashBytes(hash, &tickCount, sizeof(tickCount));
+    hashBytes(hash, &body.position, sizeof(body.position));
+    hashBytes(hash, &body.yaw, sizeof(body.yaw));
+    hashBytes(hash, &body.pitch, sizeof(body.pitch));
+    hashBytes(hash, &noclipOn, sizeof(noclipOn));
+    hashBytes(hash, &target.hit, sizeof(target.hit));
+    hashBytes(hash, &target.block, sizeof(target.block));
+    hashBytes(hash, &target.id, sizeof(target.id));
+    for (const InstanceData& instance : snapshot.instances) {
+        hashBytes(hash, &instance.position, sizeof(instance.position));
+        hashBytes(hash, &instance.scale, sizeof(instance.scale));
+        hashBytes(hash, &instance.rotation, sizeof(instance.rotation));
+        hashBytes(hash, &instance.layers, sizeof(instance.layers));
+    }
+    return hash;
+}
+
+bool isSimulationAreaLoaded(const World& world, const glm::vec3& eye) {
+    ChunkPos center = World::toChunkPos((int)std::floor(eye.x), 0, (int)std::floor(eye.z));
+    for (int cz = center.z - SIMULATION_AREA_RADIUS; cz <= center.z + SIMULATION_AREA_RADIUS; cz++)
+        for (int cx = center.x - SIMULATION_AREA_RADIUS; cx <= center.x + SIMULATION_AREA_RADIUS; cx++)
+            for (int cy = WORLD_MIN_CHUNK_Y; cy <= WORLD_MAX_CHUNK_Y; cy++)
+                if (!world.findChunk({ cx, cy, cz })) return false;
+    return true;
+}
+
+// ---------------------------------------------------------------
+// SimulationThread
+// ---------------------------------------------------------------
+
+SimulationThread::SimulationThread(Simulation& simulation, std::mutex& worldMutex)
+    : simulation(simulation)
+    , worldMutex(worldMutex)
+    , step(std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(simulation.tickSeconds())))
+{
+    pending.yaw   = simulation.player().yaw;
+    pending.pitch = simulation.player().pitch;
+    thread = std::thread([this] { run(); });
+}
+
+SimulationThread::~SimulationThread() {
+    stop();
+}
+
+void SimulationThread::stop() {
+    running.store(false, std::memory_order_relaxed);
+    if (thread.joinable()) thread.join();
+}
+
+void SimulationThread::submit(const PlayerInput& input) {
+    std::lock_guard lock(inputMutex);
+    pending.merge(input);
+}
+
+const SimSnapshot* SimulationThread::latest() {
+    if (snapshots.acquire()) hasSnapshot = true;
+    return hasSnapshot ? &snapshots.readBuffer() : nullptr;
+}
+
+float SimulationThread::alpha(const SimSnapshot& snapshot, std::chrono::steady_clock::time_point now) const {
+    float elapsed = std::chrono::duration<float>(now - snapshot.time).count();
+    return std::clamp(elapsed / simulation.tickSeconds(), 0.0f, 1.0f);
+}
+
+SimulationStats SimulationThread::stats() const {
+    SimulationStats s;
+    s.tickRate     = simulation.tickRate();
+    s.ticks        = tickCount.load(std::memory_order_relaxed);
+    s.tickMs       = lastTickMs.load(std::memory_order_relaxed);
+    s.worstTickMs  = worstTickMs.load(std::memory_order_relaxed);
+    s.skippedTicks = skipped.load(std::memory_order_relaxed);
+    s.entities     = entityCount.load(std::memory_order_relaxed);
+    return s;
+}
+
+void SimulationThread::run() {
+    PROFILE_THREAD("Simulation");
+    using Clock = std::chrono::steady_clock;
+
+    // next è l'istante a cui vale il prossimo tick: si avanza sempre di
+    // un passo esatto, così il ritmo non deriva con i ritardi dello sleep
+    Clock::time_point next = Clock::now();
+    while (running.load(std::memory_order_relaxed)) {
+        PlayerInput input;
+        {
+            std::lock_guard lock(inputMutex);
+            input = pending;
+            pending.breakBlock   = false;
+            pending.placeBlock   = false;
+            pending.toggleNoclip = false;
+            pending.spawnMobs    = false;
+        }
+
+        auto start = Clock::now();
+        SimSnapshot& snapshot = snapshots.writeBuffer();
+        {
+            std::lock_guard lock(worldMutex);
+            simulation.tick(input);
+            simulation.fillSnapshot(snapshot);
+            entityCount.store(simulation.mobs().count(), std::memory_order_relaxed);
+        }
+        snapshot.time = next;
+        snapshots.publish();
+
+        float ms = std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+        lastTickMs.store(ms, std::memory_order_relaxed);
+        if (ms > worstTickMs.load(std::memory_order_relaxed)) worstTickMs.store(ms, std::memory_order_relaxed);
+        tickCount.fetch_add(1, std::memory_order_relaxed);
+
+        // In ritardo di qualche tick si recupera senza dormire; di più si
+        // riparte da adesso (la simulazione rallenta invece di inseguire)
+        next += step;
+        auto now = Clock::now();
+        if (now - next > step * MAX_CATCH_UP) {
+            skipped.fetch_add((now - next) / step, std::memory_order_relaxed);
+            next = now;
+        }
+        std::this_thread::sleep_until(next);
+    }
+}
+
+// ---------------------------------------------------------------
+// SimulationStepper
+// ---------------------------------------------------------------
+
+SimulationStepper::SimulationStepper(Simulation& simulation)
+    : simulation(simulation)
+    , step(1.0 / simulation.tickRate())
+{
+    pending.yaw   = simulation.player().yaw;
+    pending.pitch = simulation.player().pitch;
+    simulation.fillSnapshot(current);
+    counters.tickRate = simulation.tickRate();
+}
+
+int SimulationStepper::advance(const PlayerInput& input, float deltaTime, const WaitForAreaFn& waitForArea) {
+    using Clock = std::chrono::steady_clock;
+    pending.merge(input);
+
+    // Come SimulationThread: qualche tick di ritardo si recupera, di più
+    // si salta. Qui il ritardo è nel tempo registrato, quindi anche i
+    // tick saltati sono sempre gli stessi.
+    accumulator += deltaTime;
+    int ticks = 0;
+    while (accumulator >= step) {
+        if (ticks == SimulationThread::MAX_CATCH_UP) {
+            long long late = (long long)(accumulator / step);
+            counters.skippedTicks += late;
+            accumulator -= (double)late * step;
+            break;
+        }
+        waitForArea(simulation.player().position);
+
+        auto start = Clock::now();
+        simulation.tick(pending);
+        pending.breakBlock   = false;
+        pending.placeBlock   = false;
+        pending.toggleNoclip = false;
+        pending.spawnMobs    = false;
+        accumulator -= step;
+        ticks++;
+
+        float ms = std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+        counters.tickMs      = ms;
+        counters.worstTickMs = std::max(counters.worstTickMs, ms);
+        counters.ticks++;
+    }
+    if (ticks > 0) {
+        simulation.fillSnapshot(current);
+        counters.entities = simulation.mobs().count();
+    }
+    return ticks;
+}
@@ -0,0 +1,265 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "block.h"
+#include "block_updates.h"
+#include "camera.h"
+#include "instance_data.h"
+#include "mobs.h"
+#include "particles.h"
+#include "raycast.h"
+#include "triple_buffer.h"
+
+class LightEngine;
+class World;
+
+// Fin dove arriva il mirino per rompere e piazzare blocchi
+constexpr float PICK_DISTANCE = 6.0f;
+
+// Box del giocatore attorno agli occhi: largo 0.6, alto 1.8, con gli
+// occhi a 1.62 dai piedi
+const glm::vec3 PLAYER_BOX_BELOW_EYE = glm::vec3(0.3f, 1.62f, 0.3f);
+const glm::vec3 PLAYER_BOX_ABOVE_EYE = glm::vec3(0.3f, 0.18f, 0.3f);
+
+inline Aabb playerBox(const glm::vec3& eye) {
+    return { eye - PLAYER_BOX_BELOW_EYE, eye + PLAYER_BOX_ABOVE_EYE };
+}
+
+// ---------------------------------------------------------------
+// Comandi del giocatore per un tick. L'orientamento lo decide il
+// render thread (il mouse deve rispondere a ogni frame), i tasti
+// tenuti valgono per tutti i tick finché restano giù, le pressioni
+// singole (rompere, piazzare, noclip) valgono per un tick solo.
+// ---------------------------------------------------------------
+struct PlayerInput {
+    uint8_t moves        = 0; // un bit per CameraDirection: 1 << FORWARD, ...
+    float   yaw          = -90.0f;
+    float   pitch        = 0.0f;
+    bool    breakBlock   = false;
+    bool    placeBlock   = false;
+    bool    toggleNoclip = false;
+    bool    spawnMobs    = false; // un gruppo di creature attorno al giocatore
+    BlockID block        = BLOCK_STONE; // quello da piazzare
+
+    // Pressioni arrivate dopo l'ultimo tick: i tasti tenuti e
+    // l'orientamento vincono quelli nuovi, i colpi singoli si sommano
+    void merge(const PlayerInput& newer) {
+        bool breakOnce = breakBlock || newer.breakBlock;
+        bool placeOnce = placeBlock || newer.placeBlock;
+        bool toggle    = toggleNoclip != newer.toggleNoclip;
+        bool spawnOnce = spawnMobs || newer.spawnMobs;
+        *this = newer;
+        breakBlock   = breakOnce;
+        placeBlock   = placeOnce;
+        toggleNoclip = toggle;
+        spawnMobs    = spawnOnce;
+    }
+};
+
+// Un tick di movimento del giocatore: prima l'orientamento, poi i
+// tasti tenuti; senza noclip il box scivola lungo le pareti invece di
+// attraversarle. La stessa per la Simulation e per il server.
+void movePlayer(const World& world, Camera& body, const PlayerInput& input, bool noclip, float step);
+
+// ---------------------------------------------------------------
+// Quello che il render thread sa della simulazione: lo stato dopo
+// l'ultimo tick e quello prima, per interpolare tra i due. Il tick
+// vale per l'istante time; a metà tra time e time + tick il render
+// thread disegna lo stato a metà tra previous e current.
+// ---------------------------------------------------------------
+struct SimSnapshot {
+    uint64_t  tick = 0;
+    std::chrono::steady_clock::time_point time;
+    glm::vec3 previousEye{ 0.0f };
+    glm::vec3 eye{ 0.0f };
+    RayHit    target;
+    bool      noclip = false;
+    std::vector<InstanceData> previousInstances; // stessi elementi, un tick prima
+    std::vector<InstanceData> instances;
+
+    glm::vec3 eyeAt(float alpha) const { return glm::mix(previousEye, eye, alpha); }
+
+    // Le istanze a metà strada tra i due tick, in out (svuotato prima)
+    void interpolateInstances(float alpha, std::vector<InstanceData>& out) const;
+};
+
+// ---------------------------------------------------------------
+// Simulation
+// Lo stato del gioco che avanza a passi fissi: giocatore (movimento,
+// collisioni, mira e modifiche ai blocchi), frammenti, creature e
+// blocchi che si muovono da soli (BlockUpdateSystem, a TICK_RATE passi
+// al secondo). Creature e blocchi usano jobs se c'è, con lo stesso
+// risultato di un thread solo. Nessun thread
+// e nessun OpenGL: dati lo stesso mondo e gli stessi PlayerInput,
+// tick dopo tick fa sempre le stesse cose, così si può far girare
+// senza finestra e ripetere una partita registrata.
+// ---------------------------------------------------------------
+class Simulation {
+public:
+    // Creature per ogni PlayerInput::spawnMobs
+    static constexpr int MOBS_PER_SPAWN = 256;
+
+    Simulation(World& world, LightEngine& light, const glm::vec3& spawnEye, int tickRate = 60, JobSystem* jobs = nullptr);
+
+    void tick(const PlayerInput& input);
+
+    // Lo stato prima e dopo l'ultimo tick (time resta a chi chiama)
+    void fillSnapshot(SimSnapshot& out) const;
+
+    // Hash dello stato dopo l'ultimo tick: giocatore, mira, frammenti e
+    // creature, senza la luce (dipende da quando arrivano i chunk
+    // lontani). Due partite rigiocate uguali danno lo stesso hash.
+    uint64_t stateHash() const;
+
+    int      tickRate() const { return rate; }
+    float    tickSeconds() const { return 1.0f / (float)rate; }
+    uint64_t ticks() const { return tickCount; }
+
+    const Camera&   player() const { return body; }
+    const ParticleSystem& particles() const { return debris; }
+    const MobSystem&      mobs() const { return creatures; }
+    const BlockUpdateSystem& blockUpdates() const { return movingBlocks; }
+    bool noclip() const { return noclipOn; }
+
+private:
+    void editBlocks(const PlayerInput& input);
+
+    World&       world;
+    LightEngine& light;
+    int          rate;
+    uint64_t     tickCount = 0;
+
+    Camera         body;          // solo posizione e orientamento
+    glm::vec3      previousEye{ 0.0f };
+    RayHit         target;
+    bool           noclipOn = false;
+    ParticleSystem debris;
+    MobSystem      creatures;
+    BlockUpdateSystem movingBlocks;
+};
+
+struct SimulationStats {
+    int       tickRate     = 0;
+    long long ticks        = 0;
+    float     tickMs       = 0.0f; // ultimo tick, compresa l'attesa del lock del mondo
+    float     worstTickMs  = 0.0f; // dall'avvio
+    long long skippedTicks = 0;    // tick saltati perché la simulazione era troppo indietro
+    int       entities     = 0;    // creature dopo l'ultimo tick
+};
+
+// Raggio in chunk (colonne intere) attorno al giocatore che un tick
+// può toccare: movimento, mira, frammenti e creature appena nate
+constexpr int SIMULATION_AREA_RADIUS = 2;
+
+// true se tutti i chunk entro SIMULATION_AREA_RADIUS colonne da eye
+// sono nel mondo. Si può chiamare da qualsiasi thread (findChunk).
+bool isSimulationAreaLoaded(const World& world, const glm::vec3& eye);
+
+// ---------------------------------------------------------------
+// SimulationThread
+// Fa girare una Simulation su un thread suo, a tickRate tick al
+// secondo qualunque sia il frame rate: un frame lento della GPU non
+// rallenta la simulazione e un tick pesante non ferma il render
+// thread, che disegna sempre l'ultimo SimSnapshot pubblicato
+// (TripleBuffer: nessuno dei due aspetta l'altro).
+//
+// Il mondo è condiviso: il tick lo tocca tenendo worldMutex, il
+// render thread (streaming, chunk modificati) lo prova con try_lock
+// e se è occupato rimanda al frame dopo.
+//
+// Se un tick dura più del passo la simulazione recupera i tick
+// persi; oltre MAX_CATCH_UP tick di ritardo li salta (e li conta)
+// invece di inseguire il tempo per sempre.
+// ---------------------------------------------------------------
+class SimulationThread {
+public:
+    static constexpr int MAX_CATCH_UP = 5;
+
+    SimulationThread(Simulation& simulation, std::mutex& worldMutex);
+    ~SimulationThread();
+
+    SimulationThread(const SimulationThread&) = delete;
+    SimulationThread& operator=(const SimulationThread&) = delete;
+
+    // Render thread: i comandi dell'ultimo frame, per il prossimo tick
+    void submit(const PlayerInput& input);
+
+    // Render thread: l'ultimo snapshot (nullptr prima del primo tick).
+    // Resta valido fino alla chiamata successiva.
+    const SimSnapshot* latest();
+
+    // Quanto del passo è trascorso dal tick di snapshot, tra 0 e 1
+    float alpha(const SimSnapshot& snapshot, std::chrono::steady_clock::time_point now) const;
+
+    SimulationStats stats() const;
+
+    // Ferma il thread dopo il tick in corso (lo fa anche il distruttore)
+    void stop();
+
+private:
+    void run();
+
+    Simulation& simulation;
+    std::mutex& worldMutex;
+    std::chrono::steady_clock::duration step;
+
+    std::mutex  inputMutex;
+    PlayerInput pending;
+
+    TripleBuffer<SimSnapshot> snapshots;
+    bool hasSnapshot = false; // lato render thread
+
+    std::atomic<bool>      running{ true };
+    std::atomic<long long> tickCount{ 0 };
+    std::atomic<long long> skipped{ 0 };
+    std::atomic<float>     lastTickMs{ 0.0f };
+    std::atomic<float>     worstTickMs{ 0.0f };
+    std::atomic<int>       entityCount{ 0 };
+    std::thread thread;
+};
+
+// ---------------------------------------------------------------
+// SimulationStepper
+// La strada deterministica, per registrare e rigiocare una partita:
+// la Simulation gira sul thread che chiama e i tick li decide il
+// tempo dei frame (quello registrato, non l'orologio). Gli stessi
+// frame danno sempre gli stessi tick con gli stessi comandi.
+//
+// Prima di ogni tick si aspetta che attorno al giocatore il mondo sia
+// caricato (waitForArea): con i worker i chunk arrivano quando capita,
+// e un tick che trova un chunk mancante farebbe un'altra partita.
+// ---------------------------------------------------------------
+class SimulationStepper {
+public:
+    // Torna quando isSimulationAreaLoaded è vero attorno a eye
+    using WaitForAreaFn = std::function<void(const glm::vec3& eye)>;
+
+    explicit SimulationStepper(Simulation& simulation);
+
+    // Un frame: i suoi comandi e quanto è durato. Restituisce i tick
+    // fatti (al più SimulationThread::MAX_CATCH_UP, gli altri si saltano)
+    int advance(const PlayerInput& input, float deltaTime, const WaitForAreaFn& waitForArea);
+
+    // L'ultimo snapshot (time non usato) e quanto del passo è avanzato
+    const SimSnapshot& snapshot() const { return current; }
+    float alpha() const { return (float)(accumulator / step); }
+
+    SimulationStats stats() const { return counters; }
+
+private:
+    Simulation& simulation;
+    double      step;
+    double      accumulator = 0.0;
+    PlayerInput pending;
+    SimSnapshot current;
+    SimulationStats counters;
+};
@@ -0,0 +1,147 @@
+#include "terrain.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Quanto in alto/in basso rispetto alla heightmap può arrivare il campo
+// di densità: fuori da questa fascia il risultato è già noto senza rumore
+constexpr int OVERHANG_RANGE = 16;
+
+// Buffer di lavoro per una griglia (fino a 18³ campioni, quella delle
+// mesh dei LOD). Sono grandi (~120 KB) quindi non li mettiamo sullo
+// stack; thread_local = uno per worker, riusato.
+constexpr int MAX_GRID_SIZE   = CHUNK_SIZE + 2;
+constexpr int MAX_GRID_VOLUME = MAX_GRID_SIZE * MAX_GRID_SIZE * MAX_GRID_SIZE;
+
+struct TerrainScratch {
+    float x[MAX_GRID_VOLUME];
+    float y[MAX_GRID_VOLUME];
+    float z[MAX_GRID_VOLUME];
+    float density[MAX_GRID_VOLUME];
+    float cave[MAX_GRID_VOLUME];
+    int   height[MAX_GRID_SIZE * MAX_GRID_SIZE];
+};
+
+TerrainGenerator::TerrainGenerator(uint32_t seed, NoiseBackend backend)
+    : noiseBackend(isNoiseBackendSupported(backend) ? backend : NoiseBackend::Scalar)
+{
+    // Colline ampie: 5 ottave partendo da lunghezze d'onda di ~200 blocchi
+    heightParams.seed       = seed;
+    heightParams.octaves    = 5;
+    heightParams.frequency  = 0.005f;
+
+    // Sporgenze: rumore più fitto e con meno dettaglio
+    densityParams.seed      = seed ^ 0xA511E9B3u;
+    densityParams.octaves   = 3;
+    densityParams.frequency = 0.03f;
+
+    // Caverne: dove questo rumore passa vicino a zero si scava un tunnel
+    caveParams.seed         = seed ^ 0x63D83595u;
+    caveParams.octaves      = 2;
+    caveParams.frequency    = 0.035f;
+}
+
+float TerrainGenerator::heightFromNoise(float noise) const {
+    // Il rumore (5 ottave) sta circa in [-1.9, 1.9]: lo portiamo a ~[10, 100]
+    return 56.0f + noise * 24.0f;
+}
+
+int TerrainGenerator::surfaceHeight(int x, int z) const {
+    float px = (float)x, py = 0.0f, pz = (float)z, noise;
+    fractalNoise3D(noiseBackend, heightParams, &px, &py, &pz, &noise, 1);
+    return (int)std::floor(heightFromNoise(noise));
+}
+
+void TerrainGenerator::generate(const ChunkPos& pos, Chunk& chunk) const {
+    if (pos.y < WORLD_MIN_CHUNK_Y || pos.y > WORLD_MAX_CHUNK_Y) return;
+
+    BlockID blocks[CHUNK_VOLUME];
+    if (sample(pos.x * CHUNK_SIZE, pos.y * CHUNK_SIZE, pos.z * CHUNK_SIZE, 1, CHUNK_SIZE, blocks))
+        chunk.assign(blocks);
+}
+
+bool TerrainGenerator::sample(int baseX, int baseY, int baseZ, int step, int size, BlockID* out) const {
+    static thread_local TerrainScratch scratch;
+    TerrainScratch& s = scratch;
+
+    const int area   = size * size;
+    const int volume = area * size;
+    auto index = [size](int x, int y, int z) { return (y * size + z) * size + x; };
+
+    // 1) Heightmap: una valutazione per colonna, sul piano y = 0
+    for (int z = 0; z < size; z++)
+        for (int x = 0; x < size; x++) {
+            int i = z * size + x;
+            s.x[i] = (float)(baseX + x * step);
+            s.y[i] = 0.0f;
+            s.z[i] = (float)(baseZ + z * step);
+        }
+    fractalNoise3D(noiseBackend, heightParams, s.x, s.y, s.z, s.density, area);
+
+    int minHeight = INT32_MAX, maxHeight = INT32_MIN;
+    for (int i = 0; i < area; i++) {
+        s.height[i] = (int)std::floor(heightFromNoise(s.density[i]));
+        minHeight = std::min(minHeight, s.height[i]);
+        maxHeight = std::max(maxHeight, s.height[i]);
+    }
+
+    // Griglia tutta sopra le colline e sopra il mare: resta aria
+    if (baseY > maxHeight + OVERHANG_RANGE && baseY >= SEA_LEVEL) {
+        std::fill(out, out + volume, (BlockID)BLOCK_AIR);
+        return false;
+    }
+
+    // 2) Campi 3D, valutati a lotti su tutti i campioni
+    for (int y = 0; y < size; y++)
+        for (int z = 0; z < size; z++)
+            for (int x = 0; x < size; x++) {
+                int i = index(x, y, z);
+                s.x[i] = (float)(baseX + x * step);
+                s.y[i] = (float)(baseY + y * step);
+                s.z[i] = (float)(baseZ + z * step);
+            }
+
+    // Sotto la fascia delle sporgenze è tutto pieno: il rumore di densità non serve.
+    // Le caverne solo a piena risoluzione: campionate ogni 2+ blocchi
+    // i tunnel (larghi pochi blocchi) diventerebbero buchi sparsi
+    bool needsDensity = baseY + size * step > minHeight - OVERHANG_RANGE;
+    bool caves        = step == 1;
+    if (needsDensity)
+        fractalNoise3D(noiseBackend, densityParams, s.x, s.y, s.z, s.density, volume);
+    if (caves)
+        fractalNoise3D(noiseBackend, caveParams, s.x, s.y, s.z, s.cave, volume);
+
+    // 3) Da densità e profondità ai tipi di blocco
+    for (int y = 0; y < size; y++) {
+        int wy = baseY + y * step;
+        for (int z = 0; z < size; z++)
+            for (int x = 0; x < size; x++) {
+                int i      = index(x, y, z);
+                int height = s.height[z * size + x];
+                int depth  = height - wy; // > 0 sotto la superficie
+
+                // Densità: positiva = pieno. Il termine in depth la fa
+                // crescere scendendo, il rumore crea sporgenze e rientranze.
+                bool solid = needsDensity
+                    ? (float)depth * 0.1f + s.density[i] * 1.5f > 0.0f
+                    : true;
+
+                // Tunnel: dove il rumore delle caverne è vicino a zero.
+                // Il fondo del mondo (y = 0) non si scava mai.
+                if (caves && solid && wy > 0 && depth > 3 && std::fabs(s.cave[i]) < 0.06f)
+                    solid = false;
+
+                BlockID block = BLOCK_AIR;
+                if (solid) {
+                    if (depth <= 1)      block = (wy >= SEA_LEVEL) ? BLOCK_GRASS : BLOCK_SAND;
+                    else if (depth <= 4) block = (wy >= SEA_LEVEL - 2) ? BLOCK_DIRT : BLOCK_SAND;
+                    else                 block = BLOCK_STONE;
+                } else if (wy < SEA_LEVEL && depth <= 0) {
+                    // Aria sotto il livello del mare e sopra il terreno: è mare
+                    block = BLOCK_WATER;
+                }
+                out[i] = block;
+            }
+    }
+    return true;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+
+#include "noise.h"
+#include "world.h"
+
+// ---------------------------------------------------------------
+// TerrainGenerator
+// Genera il terreno di un chunk a partire da un seed:
+//  - una heightmap 2D (rumore frattale) dà l'altezza delle colline
+//  - un campo di densità 3D aggiunge sporgenze e strapiombi vicino
+//    alla superficie
+//  - un secondo rumore 3D scava le caverne
+// Lo stesso seed produce sempre lo stesso mondo, qualunque sia
+// l'ordine in cui i chunk vengono generati o il backend del rumore.
+//
+// generate() non modifica il generatore, quindi più worker possono
+// usarlo insieme.
+// ---------------------------------------------------------------
+class TerrainGenerator {
+public:
+    static constexpr int SEA_LEVEL = 48;
+
+    explicit TerrainGenerator(uint32_t seed, NoiseBackend backend = detectBestNoiseBackend());
+
+    void generate(const ChunkPos& pos, Chunk& chunk) const;
+
+    // Campiona il terreno su una griglia size³ che parte dal blocco
+    // (baseX, baseY, baseZ), un campione ogni step blocchi, nell'ordine
+    // y, z, x di Chunk::index. Con step = 1 e size = 16 è generate();
+    // con step > 1 dà i dati ridotti dei LOD (senza caverne).
+    // Restituisce false se la griglia è tutta aria.
+    bool sample(int baseX, int baseY, int baseZ, int step, int size, BlockID* out) const;
+
+    // Altezza del terreno (senza sporgenze né caverne) nella colonna x, z:
+    // utile per far partire la camera sopra il suolo
+    int surfaceHeight(int x, int z) const;
+
+    NoiseBackend backend() const { return noiseBackend; }
+
+private:
+    float heightFromNoise(float noise) const;
+
+    NoiseBackend  noiseBackend;
+    FractalParams heightParams;
+    FractalParams densityParams;
+    FractalParams caveParams;
+};
@@ -0,0 +1,33 @@
+#include "texture_array.h"
+
+#include <glad/glad.h>
+
+TextureArray::TextureArray(const TextureArrayImage& image) : layers(image.layers) {
+    glGenTextures(1, &id);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, id);
+
+    // Tutti i livelli già pronti: niente glGenerateMipmap a ogni avvio
+    // del driver, e i texel di ogni livello sono quelli di buildMipChain
+    int levels = (int)image.levels.size();
+    for (int level = 0; level < levels; level++) {
+        int size = image.levelSize(level);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8, size, size, image.layers, 0,
+                     GL_RGBA, GL_UNSIGNED_BYTE, image.levels[level].data());
+    }
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levels - 1);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+TextureArray::~TextureArray() {
+    glDeleteTextures(1, &id);
+}
+
+void TextureArray::bind(int unit) const {
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, id);
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "material.h"
+
+// ---------------------------------------------------------------
+// TextureArray
+// Una GL_TEXTURE_2D_ARRAY con tutti i livelli di mipmap presi da un
+// TextureArrayImage (calcolati sulla CPU al caricamento, vedi
+// material.h). Filtro NEAREST da vicino, così i texel restano netti,
+// e mipmap da lontano, così il terreno distante non sfarfalla.
+// ---------------------------------------------------------------
+class TextureArray {
+public:
+    explicit TextureArray(const TextureArrayImage& image);
+    ~TextureArray();
+
+    TextureArray(const TextureArray&) = delete;
+    TextureArray& operator=(const TextureArray&) = delete;
+
+    // Lega la texture alla texture unit indicata (0, 1, ...)
+    void bind(int unit) const;
+
+    int layerCount() const { return layers; }
+
+private:
+    unsigned int id = 0;
+    int layers = 0;
+};
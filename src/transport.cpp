@@ -0,0 +1,47 @@
+#include "transport.h"
+
+bool LoopbackEndpoint::send(const uint8_t* data, size_t size) {
+    if (!outgoing) return false;
+    // Contato anche se si perde: la banda l'ha usata comunque
+    sentBytes += (long long)size;
+    sentPackets++;
+
+    if (lossRate > 0.0f) {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        if ((float)(rng & 0xFFFFFF) / (float)0x1000000 < lossRate) {
+            lostPackets++;
+            return true;
+        }
+    }
+
+    std::vector<uint8_t> packet(data, data + size);
+    std::lock_guard lock(outgoing->mutex);
+    outgoing->packets.push_back(std::move(packet));
+    return true;
+}
+
+bool LoopbackEndpoint::receive(std::vector<uint8_t>& out) {
+    if (!incoming) return false;
+    std::lock_guard lock(incoming->mutex);
+    if (incoming->packets.empty()) return false;
+    out = std::move(incoming->packets.front());
+    incoming->packets.pop_front();
+    return true;
+}
+
+std::pair<LoopbackEndpoint, LoopbackEndpoint> makeLoopbackPair(float lossRate, uint32_t seed) {
+    auto toB = std::make_shared<LoopbackEndpoint::Channel>();
+    auto toA = std::make_shared<LoopbackEndpoint::Channel>();
+
+    LoopbackEndpoint a, b;
+    a.outgoing = toB;
+    a.incoming = toA;
+    b.outgoing = toA;
+    b.incoming = toB;
+    a.lossRate = b.lossRate = lossRate;
+    a.rng = seed | 1u;
+    b.rng = (seed * 2654435761u) | 1u;
+    return { std::move(a), std::move(b) };
+}
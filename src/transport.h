@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// ---------------------------------------------------------------
+// LoopbackEndpoint
+// Un capo di un collegamento tra server e client nello stesso
+// processo. Si comporta come un socket a datagrammi: send() consegna
+// un pacchetto intero o niente, receive() li dà nell'ordine di
+// arrivo. Per provare il protocollo su una rete vera si può far
+// perdere una parte dei pacchetti (lossRate, sempre gli stessi dato
+// il seed). Un trasporto con socket avrebbe la stessa interfaccia.
+//
+// send() e receive() si possono chiamare da thread diversi; ogni capo
+// però lo usa un thread alla volta.
+// ---------------------------------------------------------------
+class LoopbackEndpoint {
+public:
+    LoopbackEndpoint() = default;
+
+    // false se il collegamento non c'è (capo vuoto)
+    bool send(const uint8_t* data, size_t size);
+    bool send(const std::vector<uint8_t>& packet) { return send(packet.data(), packet.size()); }
+
+    // Il prossimo pacchetto arrivato in out; false se non ce ne sono
+    bool receive(std::vector<uint8_t>& out);
+
+    bool connected() const { return outgoing != nullptr; }
+
+    long long bytesSent() const { return sentBytes; }
+    long long packetsSent() const { return sentPackets; }
+    long long packetsLost() const { return lostPackets; }
+
+private:
+    struct Channel {
+        std::mutex mutex;
+        std::deque<std::vector<uint8_t>> packets;
+    };
+
+    friend std::pair<LoopbackEndpoint, LoopbackEndpoint> makeLoopbackPair(float lossRate, uint32_t seed);
+
+    std::shared_ptr<Channel> outgoing;
+    std::shared_ptr<Channel> incoming;
+    float     lossRate = 0.0f;
+    uint32_t  rng = 1;
+    long long sentBytes = 0;
+    long long sentPackets = 0;
+    long long lostPackets = 0;
+};
+
+// I due capi di un collegamento: quello che manda uno lo riceve l'altro
+std::pair<LoopbackEndpoint, LoopbackEndpoint> makeLoopbackPair(float lossRate = 0.0f, uint32_t seed = 1);
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// ---------------------------------------------------------------
+// TripleBuffer
+// Passa l'ultimo valore da un thread che scrive (la simulazione) a
+// uno che legge (il render thread) senza lock e senza che nessuno
+// dei due aspetti l'altro. Le copie sono tre:
+//  - "back": quella che lo scrittore sta riempiendo;
+//  - "middle": l'ultima pubblicata, non ancora presa dal lettore;
+//  - "front": quella che il lettore sta usando.
+// publish() scambia back con middle, acquire() scambia middle con
+// front se nel frattempo è arrivato qualcosa di nuovo. Gli scambi
+// sono un exchange atomico sull'indice di middle, che porta con sé
+// un bit "nuovo". Se lo scrittore pubblica più volte prima che il
+// lettore guardi, i valori intermedi si perdono: conta solo l'ultimo.
+//
+// I buffer si riusano: chi scrive riempie writeBuffer() riciclando
+// la memoria che ci trova (es. vector.clear() invece di riallocare).
+// ---------------------------------------------------------------
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() = default;
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    // Solo lo scrittore: la copia da riempire
+    T& writeBuffer() { return buffers[back]; }
+
+    // Solo lo scrittore: rende visibile writeBuffer() al lettore
+    void publish() {
+        uint8_t previous = middle.exchange((uint8_t)(back | FRESH), std::memory_order_acq_rel);
+        back = previous & INDEX_MASK;
+    }
+
+    // Solo il lettore: prende l'ultima copia pubblicata, se ce n'è
+    // una nuova. true se readBuffer() è cambiata.
+    bool acquire() {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH)) return false;
+        uint8_t previous = middle.exchange(front, std::memory_order_acq_rel);
+        front = previous & INDEX_MASK;
+        return true;
+    }
+
+    // Solo il lettore: resta valida fino al prossimo acquire()
+    const T& readBuffer() const { return buffers[front]; }
+
+private:
+    static constexpr uint8_t INDEX_MASK = 0x3;
+    static constexpr uint8_t FRESH      = 0x4;
+
+    T buffers[3];
+    uint8_t back  = 0;
+    uint8_t front = 1;
+    std::atomic<uint8_t> middle{ 2 };
+};
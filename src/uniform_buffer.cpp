@@ -0,0 +1,21 @@
+#include "uniform_buffer.h"
+
+#include <glad/glad.h>
+
+UniformBuffer::UniformBuffer(size_t size, unsigned int binding) {
+    glGenBuffers(1, &id);
+    glBindBuffer(GL_UNIFORM_BUFFER, id);
+    glBufferData(GL_UNIFORM_BUFFER, (GLsizeiptr)size, nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, binding, id);
+}
+
+UniformBuffer::~UniformBuffer() {
+    glDeleteBuffers(1, &id);
+}
+
+void UniformBuffer::update(const void* data, size_t size, size_t offset) {
+    glBindBuffer(GL_UNIFORM_BUFFER, id);
+    glBufferSubData(GL_UNIFORM_BUFFER, (GLintptr)offset, (GLsizeiptr)size, data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
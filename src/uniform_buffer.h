@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+
+#include <glm/glm.hpp>
+
+// ---------------------------------------------------------------
+// Binding point dei blocchi uniform condivisi tra tutti gli shader:
+// ogni program collega il suo blocco allo stesso numero con
+// Shader::bindUniformBlock, e il buffer si aggiorna una volta sola.
+// ---------------------------------------------------------------
+constexpr unsigned int CAMERA_UNIFORM_BINDING   = 0;
+constexpr unsigned int MATERIAL_UNIFORM_BINDING = 1; // MaterialUniforms, vedi material.h
+
+// Dati della camera, uguali per tutti gli shader del frame.
+// Layout std140: mat4 e vec4 sono già allineati a 16 byte, quindi la
+// struct C++ coincide con il blocco GLSL:
+//
+//   layout (std140) uniform Camera {
+//       mat4 view;
+//       mat4 projection;
+//       vec4 cameraPosition;
+//   };
+struct CameraUniforms {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::vec4 cameraPosition;
+};
+
+// ---------------------------------------------------------------
+// UniformBuffer
+// Un uniform buffer object legato in modo fisso a un binding point.
+// ---------------------------------------------------------------
+class UniformBuffer {
+public:
+    UniformBuffer(size_t size, unsigned int binding);
+    ~UniformBuffer();
+
+    UniformBuffer(const UniformBuffer&) = delete;
+    UniformBuffer& operator=(const UniformBuffer&) = delete;
+
+    void update(const void* data, size_t size, size_t offset = 0);
+
+    template <typename T>
+    void update(const T& value) { update(&value, sizeof(T)); }
+
+private:
+    unsigned int id = 0;
+};
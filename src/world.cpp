@@ -0,0 +1,116 @@
+#include "world.h"
+
+BlockID World::getBlock(int x, int y, int z) const {
+    const Chunk* chunk = getChunk(toChunkPos(x, y, z));
+    if (!chunk) return BLOCK_AIR;
+    return chunk->getBlock(x & CHUNK_MASK, y & CHUNK_MASK, z & CHUNK_MASK);
+}
+
+void World::setBlock(int x, int y, int z, BlockID id) {
+    ChunkPos pos = toChunkPos(x, y, z);
+    Chunk* chunk = getChunk(pos);
+    if (!chunk) {
+        if (id == BLOCK_AIR) return; // è già aria, non serve creare niente
+        chunk = &getOrCreateChunk(pos);
+    }
+    chunk->setBlock(x & CHUNK_MASK, y & CHUNK_MASK, z & CHUNK_MASK, id);
+    markBlockChanged(x, y, z);
+}
+
+void World::markBlockChanged(int x, int y, int z) {
+    ChunkPos pos = toChunkPos(x, y, z);
+    Chunk* chunk = getChunk(pos);
+    if (!chunk) return;
+    int lx = x & CHUNK_MASK, ly = y & CHUNK_MASK, lz = z & CHUNK_MASK;
+
+    if (!(pos == lastDirty)) {
+        dirtyChunks.insert(pos);
+        lastDirty = pos;
+    }
+
+    // Dentro il chunk la mesh da rifare è solo la sua: niente hash map
+    auto inside = [](int v) { return v > 0 && v < CHUNK_MASK; };
+    if (inside(lx) && inside(ly) && inside(lz)) {
+        if (!chunk->isMeshDirty()) {
+            chunk->setMeshDirty(true);
+            meshDirtyChunks.push_back(pos);
+        }
+        return;
+    }
+    forEachChunkTouching(x, y, z, [this](const ChunkPos& p) { markMeshDirty(p); });
+}
+
+void World::markMeshDirty(const ChunkPos& pos) {
+    Chunk* chunk = getChunk(pos);
+    if (!chunk || chunk->isMeshDirty()) return;
+    chunk->setMeshDirty(true);
+    meshDirtyChunks.push_back(pos);
+}
+
+void World::takeMeshDirtyChunks(std::vector<ChunkPos>& out) {
+    out.clear();
+    for (const ChunkPos& pos : meshDirtyChunks) {
+        // Rimosso (o sostituito da uno nuovo) dopo essere stato segnato
+        Chunk* chunk = getChunk(pos);
+        if (!chunk || !chunk->isMeshDirty()) continue;
+        chunk->setMeshDirty(false);
+        out.push_back(pos);
+    }
+    meshDirtyChunks.clear();
+}
+
+Chunk* World::getChunk(const ChunkPos& pos) {
+    if (lastChunk && pos == lastPos) return lastChunk;
+
+    auto it = chunks.find(pos);
+    if (it == chunks.end()) return nullptr;
+
+    lastPos   = pos;
+    lastChunk = it->second.get();
+    return lastChunk;
+}
+
+const Chunk* World::getChunk(const ChunkPos& pos) const {
+    // Riusa la versione non-const: la cache è mutable, il mondo non cambia
+    return const_cast<World*>(this)->getChunk(pos);
+}
+
+Chunk& World::getOrCreateChunk(const ChunkPos& pos) {
+    auto& slot = chunks[pos];
+    if (!slot) slot = std::make_unique<Chunk>();
+
+    lastPos   = pos;
+    lastChunk = slot.get();
+    return *slot;
+}
+
+void World::insertChunk(const ChunkPos& pos, std::unique_ptr<Chunk> chunk) {
+    if (lastChunk && pos == lastPos) lastChunk = nullptr;
+    chunks[pos] = std::move(chunk);
+}
+
+void World::removeChunk(const ChunkPos& pos) {
+    // Invalida la cache prima di distruggere il chunk a cui punta
+    if (lastChunk && pos == lastPos) lastChunk = nullptr;
+    chunks.erase(pos);
+    dirtyChunks.erase(pos);
+    if (pos == lastDirty) lastDirty = { INT32_MIN, INT32_MIN, INT32_MIN };
+}
+
+void World::takeDirtyChunks(std::vector<ChunkPos>& out) {
+    out.assign(dirtyChunks.begin(), dirtyChunks.end());
+    dirtyChunks.clear();
+    lastDirty = { INT32_MIN, INT32_MIN, INT32_MIN };
+}
+
+long long World::blockCount() const {
+    long long total = 0;
+    for (const auto& [pos, chunk] : chunks) total += chunk->solidCount();
+    return total;
+}
+
+size_t World::memoryUsage() const {
+    size_t total = 0;
+    for (const auto& [pos, chunk] : chunks) total += chunk->memoryUsage();
+    return total;
+}
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "chunk.h"
+
+// ---------------------------------------------------------------
+// Altezza del mondo in chunk: orizzontalmente il mondo è infinito,
+// verticalmente va da WORLD_MIN_CHUNK_Y a WORLD_MAX_CHUNK_Y inclusi
+// (blocchi da y = 0 a y = 127).
+// ---------------------------------------------------------------
+constexpr int WORLD_MIN_CHUNK_Y = 0;
+constexpr int WORLD_MAX_CHUNK_Y = 7;
+
+// ---------------------------------------------------------------
+// Coordinate di un chunk nella griglia dei chunk (non in blocchi):
+// il chunk (1, 0, 0) contiene i blocchi con x da 16 a 31.
+// ---------------------------------------------------------------
+struct ChunkPos {
+    int x, y, z;
+
+    bool operator==(const ChunkPos& other) const {
+        return x == other.x && y == other.y && z == other.z;
+    }
+};
+
+// Funzione di hash per usare ChunkPos come chiave di unordered_map.
+// Moltiplichiamo ogni coordinata per un primo grande diverso così
+// chunk vicini finiscono in bucket lontani tra loro.
+struct ChunkPosHash {
+    size_t operator()(const ChunkPos& p) const noexcept {
+        uint64_t h = (uint64_t)(uint32_t)p.x * 73856093u
+                   ^ (uint64_t)(uint32_t)p.y * 19349663u
+                   ^ (uint64_t)(uint32_t)p.z * 83492791u;
+        return (size_t)(h ^ (h >> 29));
+    }
+};
+
+// Una modifica di un blocco, per applicarne molte insieme
+struct BlockEdit {
+    int     x, y, z;
+    BlockID id;
+};
+
+// Un blocco già cambiato da chi scrive direttamente nei chunk (come
+// BlockUpdateSystem), con il tipo di prima
+struct BlockChange {
+    int     x, y, z;
+    BlockID old;
+    BlockID id;
+};
+
+// ---------------------------------------------------------------
+// Classe World
+// Il mondo è una hash map da ChunkPos a Chunk: crea i chunk solo
+// dove servono, quindi può essere grande quanto vogliamo.
+// getBlock/setBlock sono O(1): uno shift per trovare il chunk,
+// una ricerca nella hash map e un accesso all'array del chunk.
+// ---------------------------------------------------------------
+class World {
+public:
+    // Da coordinate blocco a coordinate chunk / locali.
+    // Lo shift aritmetico arrotonda verso -infinito, quindi
+    // funziona anche per coordinate negative (-1 → chunk -1, locale 15).
+    static ChunkPos toChunkPos(int x, int y, int z) {
+        return { x >> CHUNK_SHIFT, y >> CHUNK_SHIFT, z >> CHUNK_SHIFT };
+    }
+
+    // Blocchi fuori dai chunk caricati sono aria
+    BlockID getBlock(int x, int y, int z) const;
+
+    // Crea il chunk se non esiste (ma non per piazzare aria nel vuoto).
+    // Segna da rimeshare il chunk e i vicini che vedono il blocco nel bordo.
+    void setBlock(int x, int y, int z, BlockID id);
+
+    // Quello che setBlock fa dopo aver scritto: chunk da salvare e mesh
+    // da rifare, per un blocco già cambiato direttamente nel chunk
+    void markBlockChanged(int x, int y, int z);
+
+    // nullptr se il chunk non è caricato
+    Chunk*       getChunk(const ChunkPos& pos);
+    const Chunk* getChunk(const ChunkPos& pos) const;
+
+    // Come getChunk ma senza la cache dell'ultimo chunk: più thread
+    // possono chiamarla insieme, purché nessuno modifichi il mondo
+    const Chunk* findChunk(const ChunkPos& pos) const {
+        auto it = chunks.find(pos);
+        return it == chunks.end() ? nullptr : it->second.get();
+    }
+
+    Chunk& getOrCreateChunk(const ChunkPos& pos);
+
+    // Chiama fn(const ChunkPos&) per i chunk la cui mesh legge il blocco
+    // (x, y, z): il suo e, se è sul bordo, i vicini che lo vedono nel
+    // loro bordo di 1 voxel (fino a 8 chunk in un angolo)
+    template <typename Fn>
+    static void forEachChunkTouching(int x, int y, int z, Fn&& fn) {
+        ChunkPos center = toChunkPos(x, y, z);
+        int local[3] = { x & CHUNK_MASK, y & CHUNK_MASK, z & CHUNK_MASK };
+        int range[3][2];
+        for (int a = 0; a < 3; a++) {
+            range[a][0] = local[a] == 0 ? -1 : 0;
+            range[a][1] = local[a] == CHUNK_MASK ? 1 : 0;
+        }
+        for (int dy = range[1][0]; dy <= range[1][1]; dy++) {
+            int cy = center.y + dy;
+            if (cy < WORLD_MIN_CHUNK_Y || cy > WORLD_MAX_CHUNK_Y) continue;
+            for (int dz = range[2][0]; dz <= range[2][1]; dz++)
+                for (int dx = range[0][0]; dx <= range[0][1]; dx++)
+                    fn(ChunkPos{ center.x + dx, cy, center.z + dz });
+        }
+    }
+
+    // Inserisce un chunk già pronto (es. generato da un worker),
+    // sostituendo quello che c'era
+    void   insertChunk(const ChunkPos& pos, std::unique_ptr<Chunk> chunk);
+    // Le modifiche non salvate del chunk rimosso vanno perse: salvarlo prima
+    void   removeChunk(const ChunkPos& pos);
+
+    int       chunkCount() const { return (int)chunks.size(); }
+    long long blockCount() const;  // blocchi non-aria in tutto il mondo
+    size_t    memoryUsage() const;
+
+    // Chunk modificati con setBlock e non ancora salvati: chi salva il
+    // mondo li prende e li scrive su disco.
+    // Copia in out quelli da salvare e svuota la lista
+    void takeDirtyChunks(std::vector<ChunkPos>& out);
+    bool hasDirtyChunks() const { return !dirtyChunks.empty(); }
+    bool isDirty(const ChunkPos& pos) const { return dirtyChunks.count(pos) != 0; }
+
+    // Chunk caricati la cui mesh è da rifare (blocchi o luce cambiati).
+    // Il bit sta nel chunk: mille modifiche allo stesso chunk in un
+    // frame lo mettono in lista una volta sola, e chi rimesha li prende
+    // tutti insieme una volta per frame (svuotando la lista).
+    void markMeshDirty(const ChunkPos& pos);
+    void takeMeshDirtyChunks(std::vector<ChunkPos>& out);
+
+    // Scorre tutti i chunk caricati: fn(const ChunkPos&, Chunk&)
+    template <typename Fn>
+    void forEachChunk(Fn&& fn) {
+        for (auto& [pos, chunk] : chunks) fn(pos, *chunk);
+    }
+    template <typename Fn>
+    void forEachChunk(Fn&& fn) const {
+        for (const auto& [pos, chunk] : chunks) fn(pos, (const Chunk&)*chunk);
+    }
+
+private:
+    std::unordered_map<ChunkPos, std::unique_ptr<Chunk>, ChunkPosHash> chunks;
+
+    // Cache dell'ultimo chunk usato: accessi consecutivi allo stesso
+    // chunk (il caso più comune) saltano la hash map.
+    // "mutable" permette di aggiornarla anche nei metodi const.
+    mutable ChunkPos lastPos   = { INT32_MIN, INT32_MIN, INT32_MIN };
+    mutable Chunk*   lastChunk = nullptr;
+
+    // L'ultimo chunk segnato come modificato: modifiche consecutive
+    // nello stesso chunk non ripetono l'inserimento nel set
+    std::unordered_set<ChunkPos, ChunkPosHash> dirtyChunks;
+    ChunkPos lastDirty = { INT32_MIN, INT32_MIN, INT32_MIN };
+
+    // Chunk con il bit meshDirty acceso (o rimossi dopo: si saltano)
+    std::vector<ChunkPos> meshDirtyChunks;
+};
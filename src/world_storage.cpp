@@ -0,0 +1,133 @@
+#include "world_storage.h"
+
+#include <filesystem>
+#include <iostream>
+
+#include <lz4.h>
+
+#include "block_registry.h"
+#include "profiler.h"
+
+WorldStorage::WorldStorage(JobSystem& jobs, const std::string& directory)
+    : jobs(jobs)
+    , directory(directory)
+{
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error) std::cerr << "Impossibile creare la cartella " << directory << ": " << error.message() << "\n";
+    blocksMatch = syncBlockTable(directory + "/" + BLOCK_TABLE_FILE);
+}
+
+WorldStorage::~WorldStorage() {
+    flush();
+}
+
+RegionFile* WorldStorage::region(const ChunkPos& regionPos) {
+    std::lock_guard lock(regionsMutex);
+    auto& slot = regions[regionPos];
+    if (!slot) {
+        std::string path = directory + "/r." + std::to_string(regionPos.x) + "." + std::to_string(regionPos.y)
+                         + "." + std::to_string(regionPos.z) + ".cvr";
+        auto file = std::make_unique<RegionFile>();
+        if (!file->open(path)) {
+            regions.erase(regionPos);
+            return nullptr;
+        }
+        slot = std::move(file);
+    }
+    return slot.get();
+}
+
+static int localIndexOf(const ChunkPos& pos) {
+    return RegionFile::localIndex(pos.x & REGION_MASK, pos.y & REGION_MASK, pos.z & REGION_MASK);
+}
+
+bool WorldStorage::loadChunk(const ChunkPos& pos, Chunk& chunk) {
+    PROFILE_SCOPE("Load chunk");
+    if (!blocksMatch) return false;
+    {
+        // Una versione più nuova non ancora scritta?
+        std::unique_lock lock(pendingMutex);
+        auto it = pending.find(pos);
+        if (it != pending.end()) {
+            Bytes bytes = it->second;
+            lock.unlock();
+            return chunk.deserialize(bytes->data(), bytes->size());
+        }
+    }
+
+    RegionFile* file = region(regionOf(pos));
+    return file && file->loadChunk(localIndexOf(pos), chunk);
+}
+
+bool WorldStorage::writeSerialized(const ChunkPos& pos, const uint8_t* raw, size_t rawSize) {
+    PROFILE_SCOPE("Write chunk");
+    if (!blocksMatch) return false;
+    RegionFile* file = region(regionOf(pos));
+    if (!file) return false;
+
+    thread_local char compressed[LZ4_COMPRESSBOUND(Chunk::MAX_SERIALIZED_SIZE)];
+    int size = LZ4_compress_default((const char*)raw, compressed, (int)rawSize, (int)sizeof(compressed));
+    if (size <= 0) return false;
+    return file->writeChunk(localIndexOf(pos), (const uint8_t*)compressed, (uint32_t)size, (uint32_t)rawSize);
+}
+
+bool WorldStorage::saveChunk(const ChunkPos& pos, const Chunk& chunk) {
+    thread_local std::vector<uint8_t> raw;
+    raw.clear();
+    chunk.serialize(raw);
+    return writeSerialized(pos, raw.data(), raw.size());
+}
+
+void WorldStorage::saveChunkAsync(const ChunkPos& pos, const Chunk& chunk) {
+    if (!blocksMatch) return;
+    auto raw = std::make_shared<std::vector<uint8_t>>();
+    raw->reserve(Chunk::MAX_SERIALIZED_SIZE);
+    chunk.serialize(*raw);
+    Bytes bytes = std::move(raw);
+
+    {
+        std::lock_guard lock(pendingMutex);
+        pending[pos] = bytes;
+        writesInFlight++;
+    }
+
+    // Priorità bassa: generazione e meshing dei chunk vicini vengono prima
+    jobs.submit([this, pos, bytes] {
+        // Scriviamo solo se nessuno ha risalvato il chunk nel frattempo.
+        // Controllo e scrittura stanno sotto lo stesso lock, così una
+        // copia vecchia non può finire sul disco dopo una più nuova.
+        {
+            std::lock_guard writeLock(asyncWriteMutex);
+            bool latest;
+            {
+                std::lock_guard lock(pendingMutex);
+                auto it = pending.find(pos);
+                latest = it != pending.end() && it->second == bytes;
+            }
+            if (latest) writeSerialized(pos, bytes->data(), bytes->size());
+        }
+
+        std::lock_guard lock(pendingMutex);
+        auto it = pending.find(pos);
+        if (it != pending.end() && it->second == bytes) pending.erase(it);
+        if (--writesInFlight == 0) pendingDone.notify_all();
+    }, 1e9f);
+}
+
+void WorldStorage::flush() {
+    std::unique_lock lock(pendingMutex);
+    pendingDone.wait(lock, [this] { return writesInFlight == 0; });
+}
+
+int WorldStorage::pendingWrites() const {
+    std::lock_guard lock(pendingMutex);
+    return writesInFlight;
+}
+
+size_t WorldStorage::diskUsage() {
+    std::lock_guard lock(regionsMutex);
+    size_t total = 0;
+    for (const auto& [pos, file] : regions) total += file->fileSize();
+    return total;
+}
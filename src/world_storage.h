@@ -0,0 +1,84 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "job_system.h"
+#include "region_file.h"
+#include "world.h"
+
+// ---------------------------------------------------------------
+// WorldStorage
+// Salva e carica i chunk di un mondo in una cartella di region file
+// (vedi region_file.h), aprendo le regioni solo quando servono.
+//
+//  - loadChunk() e saveChunk() si possono chiamare da qualsiasi
+//    thread: il generatore li usa direttamente dai worker.
+//  - saveChunkAsync() è per il render thread: copia i dati del chunk
+//    (veloce, è già compresso con la palette) e lascia compressione
+//    e scrittura a un job.
+//
+// Accanto ai region file c'è la tabella dei tipi di blocco registrati
+// a runtime (BLOCK_TABLE_FILE, vedi syncBlockTable). Se non torna con
+// quelli di adesso la cartella non si tocca: niente si carica e niente
+// si scrive, così i blocchi salvati non cambiano tipo.
+// ---------------------------------------------------------------
+class WorldStorage {
+public:
+    static constexpr const char* BLOCK_TABLE_FILE = "blocks.ids";
+
+    WorldStorage(JobSystem& jobs, const std::string& directory);
+    ~WorldStorage(); // aspetta le scritture in corso
+
+    WorldStorage(const WorldStorage&) = delete;
+    WorldStorage& operator=(const WorldStorage&) = delete;
+
+    // false se il chunk non è mai stato salvato (va generato)
+    bool loadChunk(const ChunkPos& pos, Chunk& chunk);
+
+    // Comprime e scrive subito, sul thread chiamante
+    bool saveChunk(const ChunkPos& pos, const Chunk& chunk);
+
+    // Come saveChunk ma la scrittura avviene su un worker
+    void saveChunkAsync(const ChunkPos& pos, const Chunk& chunk);
+
+    // Blocca finché tutte le saveChunkAsync sono su disco
+    void flush();
+
+    // false se i BlockID salvati vogliono dire altri tipi di blocco
+    bool   blockTypesMatch() const { return blocksMatch; }
+
+    int    pendingWrites() const;
+    size_t diskUsage();  // byte occupati dai region file aperti
+
+    static ChunkPos regionOf(const ChunkPos& pos) {
+        return { pos.x >> REGION_SHIFT, pos.y >> REGION_SHIFT, pos.z >> REGION_SHIFT };
+    }
+
+private:
+    using Bytes = std::shared_ptr<const std::vector<uint8_t>>;
+
+    RegionFile* region(const ChunkPos& regionPos);
+    bool        writeSerialized(const ChunkPos& pos, const uint8_t* raw, size_t rawSize);
+
+    JobSystem&  jobs;
+    std::string directory;
+    bool        blocksMatch = true;
+
+    std::mutex regionsMutex;
+    std::unordered_map<ChunkPos, std::unique_ptr<RegionFile>, ChunkPosHash> regions;
+
+    // Chunk in attesa di scrittura, serializzati: se lo stesso chunk viene
+    // risalvato prima che il job parta vince la copia più recente, e chi
+    // lo carica nel frattempo legge da qui invece che dal file vecchio
+    mutable std::mutex      pendingMutex;
+    std::condition_variable pendingDone;
+    std::unordered_map<ChunkPos, Bytes, ChunkPosHash> pending;
+    int writesInFlight = 0;
+    std::mutex asyncWriteMutex;
+};